@@ -18,6 +18,7 @@ find_package( Qt5
         Concurrent
         Core
         Gui
+        Network
         OpenGL
         OpenGLExtensions
         PrintSupport
@@ -18,6 +18,9 @@
 
 #include "CCAppCommon.h"
 
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QVector>
 
@@ -27,6 +30,13 @@ class ccPluginInterface;
 using ccPluginInterfaceList = QVector<ccPluginInterface *>;
 
 
+//! Plugins manager
+/** To speed up the application startup, the plugins that only provide I/O filters
+	(and, in command line mode, the plugins that only provide commands) are not loaded
+	if their description is found in the metadata cache. Their library is only loaded
+	the first time one of their filters or commands is actually used ('deferred' plugins).
+	The cache is (re)generated each time a plugin library is actually loaded.
+**/
 class CCAPPCOMMON_LIB_API ccPluginManager : public QObject
 {
 	Q_OBJECT
@@ -46,6 +56,26 @@ public:
 	void setPluginEnabled( const ccPluginInterface* plugin, bool enabled );
 	bool isEnabled( const ccPluginInterface* plugin ) const;
 	
+	//! Returns whether a plugin is deferred (i.e. its library has not been loaded yet)
+	bool isDeferred( const ccPluginInterface* plugin ) const;
+	
+	//! Loads the library of a deferred plugin
+	/** Does nothing if the plugin is already loaded.
+		\return whether the plugin is loaded
+	**/
+	bool load( ccPluginInterface* plugin );
+	
+	//! Returns the command line keywords of a deferred plugin (from the metadata cache)
+	QStringList commandKeywords( const ccPluginInterface* plugin ) const;
+	
+	//! Records the command line keywords registered by a (loaded) plugin in the metadata cache
+	/** The cache file is only updated by flushMetaDataCache.
+	**/
+	void setCommandKeywords( const ccPluginInterface* plugin, const QStringList& keywords );
+	
+	//! Writes the metadata cache file if it has been modified (see setCommandKeywords)
+	void flushMetaDataCache();
+	
 protected:
 	explicit ccPluginManager( QObject* parent = nullptr );
 
@@ -54,6 +84,21 @@ private:
 	
 	QStringList disabledPluginIIDs() const;
 	
+	//! Returns whether a plugin can be deferred, given its metadata cache entry
+	bool canBeDeferred( const QJsonObject& cacheEntry ) const;
+	
+	void loadMetaDataCache();
+	void saveMetaDataCache();
+	
 	QStringList m_pluginPaths;
 	ccPluginInterfaceList m_pluginList;
+	
+	//! Metadata cache (one entry per plugin file)
+	QJsonObject m_metaDataCache;
+	//! Plugin files (dynamic plugins only)
+	QMap<const ccPluginInterface*, QString> m_pluginFiles;
+	//! Whether the metadata cache has been modified since it was last written
+	bool m_metaDataCacheModified = false;
+	//! Protects the metadata cache (deferred plugins may be loaded by several threads)
+	mutable QMutex m_cacheMutex;
 };
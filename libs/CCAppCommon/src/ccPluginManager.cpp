@@ -29,18 +29,355 @@
 
 //Qt
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QPluginLoader>
+#include <QSaveFile>
 #include <QSet>
 #include <QSettings>
 #include <QStandardPaths>
+#include <QThread>
+
+//system
+#include <atomic>
 
 
 namespace
 {
 	// This is used to avoid having to make the ccPluginManager constructor public
 	class PrivatePluginManager : public ccPluginManager {};	
+	
+	// Version of the metadata cache format (increase it each time the format changes)
+	constexpr int c_MetaDataCacheVersion = 1;
+	
+	// Entity types for which the 'canSave' results of the I/O filters are stored in the metadata cache
+	const CC_CLASS_ENUM c_CanSaveTypes[]{	CC_TYPES::POINT_CLOUD,
+											CC_TYPES::MESH,
+											CC_TYPES::POLY_LINE,
+											CC_TYPES::IMAGE,
+											CC_TYPES::HIERARCHY_OBJECT };
+	
+	QString sMetaDataCacheFile()
+	{
+		const QString cachePath = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+		
+		if ( cachePath.isEmpty() )
+		{
+			return {};
+		}
+		
+		return QDir( cachePath ).absoluteFilePath( QStringLiteral( "PluginMetaData.json" ) );
+	}
+	
+	CC_PLUGIN_TYPE sPluginType( const QString& type )
+	{
+		if ( type == QLatin1String( "GL" ) )
+		{
+			return CC_GL_FILTER_PLUGIN;
+		}
+		else if ( type == QLatin1String( "I/O" ) )
+		{
+			return CC_IO_FILTER_PLUGIN;
+		}
+		
+		return CC_STD_PLUGIN;
+	}
+	
+	// Describes an I/O filter in the metadata cache
+	QJsonObject sFilterMetaData( const FileIOFilter& filter )
+	{
+		const FileIOFilter::FilterInfo& info = filter.getFilterInfo();
+		
+		QJsonObject canSave;
+		
+		for ( CC_CLASS_ENUM type : c_CanSaveTypes )
+		{
+			bool multiple = false;
+			bool exclusive = false;
+			
+			if ( filter.canSave( type, multiple, exclusive ) )
+			{
+				canSave[QString::number( type )] = QJsonObject{ { "multiple", multiple }, { "exclusive", exclusive } };
+			}
+			else
+			{
+				canSave[QString::number( type )] = false;
+			}
+		}
+		
+		return QJsonObject{
+			{ "id", info.id },
+			{ "priority", info.priority },
+			{ "importExtensions", QJsonArray::fromStringList( info.importExtensions ) },
+			{ "defaultExtension", info.defaultExtension },
+			{ "importFileFilters", QJsonArray::fromStringList( info.importFileFilterStrings ) },
+			{ "exportFileFilters", QJsonArray::fromStringList( info.exportFileFilterStrings ) },
+			{ "features", static_cast<int>( info.features ) },
+			{ "canSave", canSave }
+		};
+	}
+	
+	// Stands for a plugin whose library has not been loaded yet
+	/** Its description comes from the plugin JSON metadata (read without loading
+		the library) and from the metadata cache. All the other calls are forwarded
+		to the actual plugin, which is then loaded on first use.
+	**/
+	class DeferredPlugin : public ccPluginInterface
+	{
+	public:
+		DeferredPlugin( const QString& fileName, const QString& iid, const QJsonObject& metaData, const QJsonObject& cacheEntry )
+			: m_fileName( fileName )
+			, m_iid( iid )
+			, m_metaData( metaData )
+			, m_cacheEntry( cacheEntry )
+			, m_plugin( nullptr )
+			, m_loadingFailed( false )
+		{
+		}
+		
+		CC_PLUGIN_TYPE getType() const override { return sPluginType( m_metaData["type"].toString() ); }
+		
+		bool isCore() const override { return m_metaData["core"].toBool(); }
+		
+		QString getName() const override { return m_metaData["name"].toString(); }
+		
+		QString getDescription() const override { return m_metaData["description"].toString(); }
+		
+		QIcon getIcon() const override
+		{
+			// the icon is a resource of the plugin library
+			ccPluginInterface* plugin = m_plugin;
+			return plugin ? plugin->getIcon() : QIcon();
+		}
+		
+		ReferenceList getReferences() const override
+		{
+			ReferenceList list;
+			
+			const QJsonArray array = m_metaData["references"].toArray();
+			
+			for ( const QJsonValue &value : array )
+			{
+				const QJsonObject object = value.toObject();
+				
+				list += Reference{ object["text"].toString(), object["url"].toString() };
+			}
+			
+			return list;
+		}
+		
+		ContactList getAuthors() const override { return contacts( "authors" ); }
+		
+		ContactList getMaintainers() const override { return contacts( "maintainers" ); }
+		
+		bool start() override
+		{
+			return ccPluginManager::get().load( this ) && m_plugin.load()->start();
+		}
+		
+		void stop() override
+		{
+			ccPluginInterface* plugin = m_plugin;
+			
+			if ( plugin != nullptr )
+			{
+				plugin->stop();
+			}
+		}
+		
+		// Deferred plugins have no custom object factory (see ccPluginManager::canBeDeferred)
+		ccExternalFactory* getCustomObjectsFactory() const override { return nullptr; }
+		
+		void registerCommands( ccCommandLineInterface* cmd ) override
+		{
+			if ( ccPluginManager::get().load( this ) )
+			{
+				m_plugin.load()->registerCommands( cmd );
+			}
+		}
+		
+		void setIID( const QString& iid ) override { m_iid = iid; }
+		
+		const QString& IID() const override { return m_iid; }
+		
+		const QString& fileName() const { return m_fileName; }
+		
+		const QJsonObject& cacheEntry() const { return m_cacheEntry; }
+		
+		//! Returns the actual plugin (or nullptr if it has not been loaded yet)
+		ccPluginInterface* actualPlugin() const { return m_plugin; }
+		
+		//! Sets the actual plugin, once loaded
+		void setActualPlugin( ccPluginInterface* plugin, const ccIOPluginInterface::FilterList& filters )
+		{
+			m_filters = filters;
+			m_plugin = plugin;
+		}
+		
+		//! Returns an I/O filter of the actual plugin
+		FileIOFilter::Shared filter( const QString& id )
+		{
+			if ( !ccPluginManager::get().load( this ) )
+			{
+				return {};
+			}
+			
+			for ( const FileIOFilter::Shared& ioFilter : m_filters )
+			{
+				if ( ioFilter && ioFilter->getFilterInfo().id == id )
+				{
+					return ioFilter;
+				}
+			}
+			
+			ccLog::Warning( QStringLiteral( "[Plugin][%1] I/O filter '%2' not found (the metadata cache is probably outdated)" ).arg( getName(), id ) );
+			
+			return {};
+		}
+		
+		bool loadingFailed() const { return m_loadingFailed; }
+		void setLoadingFailed() { m_loadingFailed = true; }
+		
+		QMutex& mutex() { return m_mutex; }
+		
+	private:
+		ContactList contacts( const QString& fieldName ) const
+		{
+			ContactList list;
+			
+			const QJsonArray array = m_metaData[fieldName].toArray();
+			
+			for ( const QJsonValue &value : array )
+			{
+				const QJsonObject object = value.toObject();
+				
+				list += Contact{ object["name"].toString(), object["email"].toString() };
+			}
+			
+			return list;
+		}
+		
+		QString m_fileName;
+		QString m_iid;
+		QJsonObject m_metaData;
+		QJsonObject m_cacheEntry;
+		
+		std::atomic<ccPluginInterface*> m_plugin;
+		ccIOPluginInterface::FilterList m_filters;
+		bool m_loadingFailed;
+		
+		QMutex m_mutex;
+	};
+	
+	// Stands for an I/O filter of a deferred plugin
+	/** The plugin is loaded the first time the filter is actually used.
+	**/
+	class DeferredIOFilter : public FileIOFilter
+	{
+	public:
+		DeferredIOFilter( const QJsonObject& metaData, DeferredPlugin* plugin )
+			: FileIOFilter( {
+				metaData["id"].toString(),
+				static_cast<float>( metaData["priority"].toDouble( DEFAULT_PRIORITY ) ),
+				metaData["importExtensions"].toVariant().toStringList(),
+				metaData["defaultExtension"].toString(),
+				metaData["importFileFilters"].toVariant().toStringList(),
+				metaData["exportFileFilters"].toVariant().toStringList(),
+				FilterFeatures( QFlag( metaData["features"].toInt() ) )
+			} )
+			, m_plugin( plugin )
+			, m_canSave( metaData["canSave"].toObject() )
+		{
+		}
+		
+		CC_FILE_ERROR loadFile( const QString& filename, ccHObject& container, LoadParameters& parameters ) override
+		{
+			Shared filter = actualFilter();
+			
+			return filter ? filter->loadFile( filename, container, parameters ) : CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+		
+		CC_FILE_ERROR saveToFile( ccHObject* entity, const QString& filename, const SaveParameters& parameters ) override
+		{
+			Shared filter = actualFilter();
+			
+			return filter ? filter->saveToFile( entity, filename, parameters ) : CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+		
+		ChunkReader::Shared openChunkReader( const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error ) override
+		{
+			Shared filter = actualFilter();
+			
+			if ( !filter )
+			{
+				error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
+				return {};
+			}
+			
+			return filter->openChunkReader( filename, parameters, error );
+		}
+		
+		ChunkWriter::Shared openChunkWriter( const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error ) override
+		{
+			Shared filter = actualFilter();
+			
+			if ( !filter )
+			{
+				error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
+				return {};
+			}
+			
+			return filter->openChunkWriter( filename, parameters, error );
+		}
+		
+		bool canSave( CC_CLASS_ENUM type, bool& multiple, bool& exclusive ) const override
+		{
+			// the most common types are answered without loading the plugin
+			const QJsonValue cached = m_canSave[QString::number( type )];
+			
+			if ( cached.isObject() )
+			{
+				multiple = cached.toObject()["multiple"].toBool();
+				exclusive = cached.toObject()["exclusive"].toBool();
+				return true;
+			}
+			else if ( cached.isBool() )
+			{
+				return false;
+			}
+			
+			Shared filter = actualFilter();
+			
+			return filter && filter->canSave( type, multiple, exclusive );
+		}
+		
+		void unregister() override
+		{
+			if ( m_plugin->actualPlugin() != nullptr )
+			{
+				Shared filter = actualFilter();
+				
+				if ( filter )
+				{
+					filter->unregister();
+				}
+			}
+		}
+		
+	private:
+		Shared actualFilter() const
+		{
+			return m_plugin->filter( getFilterInfo().id );
+		}
+		
+		DeferredPlugin* m_plugin;
+		QJsonObject m_canSave;
+	};
 }
 
 Q_GLOBAL_STATIC( PrivatePluginManager, sPluginManager );
@@ -121,7 +458,15 @@ QStringList ccPluginManager::pluginPaths()
 
 void ccPluginManager::loadPlugins()
 {
+	QElapsedTimer timer;
+	timer.start();
+	
 	m_pluginList.clear();
+	m_pluginFiles.clear();
+	
+	loadMetaDataCache();
+	
+	const QJsonObject previousMetaDataCache = m_metaDataCache;
 	
 	if ( m_pluginPaths.empty() )
 	{
@@ -153,6 +498,8 @@ void ccPluginManager::loadPlugins()
 	
 	const QStringList disabledList = disabledPluginIIDs();
 	
+	int deferredCount = 0;
+	
 	for ( ccPluginInterface* plugin : pluginList )
 	{
 		if ( plugin == nullptr )
@@ -169,10 +516,28 @@ void ccPluginManager::loadPlugins()
 			continue;
 		}
 		
+		// static plugins have no entry in the metadata cache
+		const QString pluginFile = m_pluginFiles.value( plugin );
+		
+		QJsonObject cacheEntry = m_metaDataCache.value( pluginFile ).toObject();
+		
+		DeferredPlugin* deferredPlugin = dynamic_cast<DeferredPlugin*>( plugin );
+		
+		if ( deferredPlugin != nullptr )
+		{
+			++deferredCount;
+		}
+		
 		switch ( plugin->getType() )
 		{
 			case CC_STD_PLUGIN:
 			{
+				if ( deferredPlugin != nullptr )
+				{
+					// deferred plugins have no factory (see canBeDeferred)
+					break;
+				}
+				
 				ccStdPluginInterface* stdPlugin = static_cast<ccStdPluginInterface*>(plugin);
 				
 				//see if this plugin provides an additional factory for objects
@@ -185,31 +550,55 @@ void ccPluginManager::loadPlugins()
 					ccExternalFactory::Container::GetUniqueInstance()->addFactory(factory);
 				}
 				
+				cacheEntry["factory"] = (factory != nullptr);
+				
 				break;
 			}
 				
 			case CC_IO_FILTER_PLUGIN: //I/O filter
 			{
-				ccIOPluginInterface* ioPlugin = static_cast<ccIOPluginInterface*>(plugin);
-				
 				QStringList	ioExtensions;
 				
-				for ( auto &filter : ioPlugin->getFilters() )
+				if ( deferredPlugin != nullptr )
 				{
-					if (filter)
+					const QJsonArray filtersMetaData = cacheEntry["filters"].toArray();
+					
+					for ( const QJsonValue& filterMetaData : filtersMetaData )
 					{
-						FileIOFilter::Register(filter);
+						FileIOFilter::Shared filter( new DeferredIOFilter( filterMetaData.toObject(), deferredPlugin ) );
+						
+						FileIOFilter::Register( filter );
 						
 						ioExtensions += filter->getDefaultExtension().toUpper();
 					}
 				}
+				else
+				{
+					ccIOPluginInterface* ioPlugin = static_cast<ccIOPluginInterface*>(plugin);
+					
+					QJsonArray filtersMetaData;
+					
+					for ( auto &filter : ioPlugin->getFilters() )
+					{
+						if (filter)
+						{
+							FileIOFilter::Register(filter);
+							
+							ioExtensions += filter->getDefaultExtension().toUpper();
+							
+							filtersMetaData.append( sFilterMetaData( *filter ) );
+						}
+					}
+					
+					cacheEntry["filters"] = filtersMetaData;
+				}
 				
 				if ( !ioExtensions.empty() )
 				{
 					ioExtensions.sort();
 					
 					ccLog::Print( tr( "[Plugin][%1] New file extensions registered: %2" )
-								  .arg( ioPlugin->getName(), ioExtensions.join( ' ' ) ) );
+								  .arg( plugin->getName(), ioExtensions.join( ' ' ) ) );
 				}
 				
 				break;
@@ -219,7 +608,22 @@ void ccPluginManager::loadPlugins()
 				//nothing to do at this point
 				break;
 		}
+		
+		if ( !pluginFile.isEmpty() )
+		{
+			m_metaDataCache.insert( pluginFile, cacheEntry );
+		}
 	}
+	
+	if ( m_metaDataCache != previousMetaDataCache )
+	{
+		saveMetaDataCache();
+	}
+	
+	ccLog::Print( tr( "[Plugin] %1 plugin(s) found in %2 ms (%3 deferred until first use)" )
+				  .arg( m_pluginList.size() )
+				  .arg( timer.elapsed() )
+				  .arg( deferredCount ) );
 }
 
 ccPluginInterfaceList &ccPluginManager::pluginList()
@@ -266,6 +670,203 @@ bool ccPluginManager::isEnabled( const ccPluginInterface *plugin ) const
 	return !disabledPluginIIDs().contains( iid );
 }
 
+bool ccPluginManager::isDeferred( const ccPluginInterface* plugin ) const
+{
+	const DeferredPlugin* deferredPlugin = dynamic_cast<const DeferredPlugin*>( plugin );
+	
+	return (deferredPlugin != nullptr) && (deferredPlugin->actualPlugin() == nullptr);
+}
+
+bool ccPluginManager::load( ccPluginInterface* plugin )
+{
+	DeferredPlugin* deferredPlugin = dynamic_cast<DeferredPlugin*>( plugin );
+	
+	if ( deferredPlugin == nullptr )
+	{
+		// regular plugins are loaded at startup
+		return plugin != nullptr;
+	}
+	
+	// several threads may try to load the same plugin at the same time
+	QMutexLocker locker( &deferredPlugin->mutex() );
+	
+	if ( deferredPlugin->actualPlugin() != nullptr )
+	{
+		return true;
+	}
+	
+	if ( deferredPlugin->loadingFailed() )
+	{
+		return false;
+	}
+	
+	QElapsedTimer timer;
+	timer.start();
+	
+	QPluginLoader loader( deferredPlugin->fileName() );
+	
+	QObject* instance = loader.instance();
+	ccPluginInterface* ccPlugin = qobject_cast<ccPluginInterface*>( instance );
+	
+	if ( ccPlugin == nullptr )
+	{
+		ccLog::Warning( tr( "[Plugin][%1] Failed to load %2 (%3)" ).arg( deferredPlugin->getName(), deferredPlugin->fileName(), loader.errorString() ) );
+		
+		deferredPlugin->setLoadingFailed();
+		
+		return false;
+	}
+	
+	ccPlugin->setIID( deferredPlugin->IID() );
+	
+	// the plugin may be loaded by a worker thread
+	if ( instance->thread() != QCoreApplication::instance()->thread() )
+	{
+		instance->moveToThread( QCoreApplication::instance()->thread() );
+	}
+	
+	ccIOPluginInterface::FilterList filters;
+	
+	if ( ccPlugin->getType() == CC_IO_FILTER_PLUGIN )
+	{
+		filters = static_cast<ccIOPluginInterface*>( ccPlugin )->getFilters();
+	}
+	
+	deferredPlugin->setActualPlugin( ccPlugin, filters );
+	
+	ccLog::Print( tr( "[Plugin][%1] Loaded on first use in %2 ms" ).arg( ccPlugin->getName() ).arg( timer.elapsed() ) );
+	
+	return true;
+}
+
+QStringList ccPluginManager::commandKeywords( const ccPluginInterface* plugin ) const
+{
+	QMutexLocker locker( &m_cacheMutex );
+	
+	const QJsonObject cacheEntry = m_metaDataCache.value( m_pluginFiles.value( plugin ) ).toObject();
+	
+	return cacheEntry["commands"].toVariant().toStringList();
+}
+
+void ccPluginManager::setCommandKeywords( const ccPluginInterface* plugin, const QStringList& keywords )
+{
+	QMutexLocker locker( &m_cacheMutex );
+	
+	const QString pluginFile = m_pluginFiles.value( plugin );
+	
+	QJsonObject cacheEntry = m_metaDataCache.value( pluginFile ).toObject();
+	
+	if ( cacheEntry.isEmpty() )
+	{
+		// static plugin
+		return;
+	}
+	
+	QStringList sortedKeywords = keywords;
+	sortedKeywords.sort();
+	
+	const QJsonArray commands = QJsonArray::fromStringList( sortedKeywords );
+	
+	if ( cacheEntry.contains( "commands" ) && cacheEntry["commands"].toArray() == commands )
+	{
+		return;
+	}
+	
+	cacheEntry["commands"] = commands;
+	
+	m_metaDataCache.insert( pluginFile, cacheEntry );
+	
+	m_metaDataCacheModified = true;
+}
+
+void ccPluginManager::flushMetaDataCache()
+{
+	QMutexLocker locker( &m_cacheMutex );
+	
+	if ( m_metaDataCacheModified )
+	{
+		saveMetaDataCache();
+	}
+}
+
+bool ccPluginManager::canBeDeferred( const QJsonObject& cacheEntry ) const
+{
+	// the factories must be registered before any BIN file is loaded
+	if ( cacheEntry["factory"].toBool() )
+	{
+		return false;
+	}
+	
+	// the commands of the plugin must be known in command line mode
+	const bool commandsKnown = cacheEntry.contains( "commands" );
+	
+	switch ( sPluginType( cacheEntry["type"].toString() ) )
+	{
+		case CC_IO_FILTER_PLUGIN:
+			return cacheEntry.contains( "filters" ) && (commandsKnown || !ccApp->isCommandLine());
+			
+		case CC_STD_PLUGIN:
+			// in GUI mode, the actions of standard plugins are created (and updated) by the plugins themselves
+			return commandsKnown && ccApp->isCommandLine();
+			
+		default:
+			return false;
+	}
+}
+
+void ccPluginManager::loadMetaDataCache()
+{
+	QMutexLocker locker( &m_cacheMutex );
+	
+	m_metaDataCache = QJsonObject();
+	
+	QFile file( sMetaDataCacheFile() );
+	
+	if ( !file.exists() || !file.open( QIODevice::ReadOnly ) )
+	{
+		return;
+	}
+	
+	const QJsonObject root = QJsonDocument::fromJson( file.readAll() ).object();
+	
+	if ( root["version"].toInt() != c_MetaDataCacheVersion )
+	{
+		return;
+	}
+	
+	m_metaDataCache = root["plugins"].toObject();
+}
+
+void ccPluginManager::saveMetaDataCache()
+{
+	const QString fileName = sMetaDataCacheFile();
+	
+	if ( fileName.isEmpty() || !QDir().mkpath( QFileInfo( fileName ).absolutePath() ) )
+	{
+		return;
+	}
+	
+	// the file is written in a temporary file first and then renamed, so that
+	// concurrent instances never read (or write) a partial file
+	QSaveFile file( fileName );
+	
+	const QJsonObject root{
+		{ "version", c_MetaDataCacheVersion },
+		{ "plugins", m_metaDataCache }
+	};
+	
+	if (	!file.open( QIODevice::WriteOnly )
+		||	file.write( QJsonDocument( root ).toJson() ) < 0
+		||	!file.commit() )
+	{
+		ccLog::Warning( tr( "[Plugin] Failed to write the metadata cache (%1)" ).arg( fileName ) );
+		
+		return;
+	}
+	
+	m_metaDataCacheModified = false;
+}
+
 void ccPluginManager::loadFromPathsAndAddToList()
 {
 	const QStringList nameFilters{
@@ -283,6 +884,12 @@ void ccPluginManager::loadFromPathsAndAddToList()
 	// Map the plugin's IID to its loader so we can unload it if necessary.
 	//	This lets us override plugins by path.
 	QMap<QString, QPluginLoader *> pluginIIDToLoaderMap;
+	QMap<QString, ccPluginInterface *> pluginIIDToPluginMap;
+	
+	// only the entries of the plugins found this time are kept
+	const QJsonObject previousMetaDataCache = m_metaDataCache;
+	
+	m_metaDataCache = QJsonObject();
 	
 	const auto paths = pluginPaths();
 	
@@ -315,54 +922,109 @@ void ccPluginManager::loadFromPathsAndAddToList()
 				continue;
 			}
 			
-			QObject* plugin = loader->instance();
-			ccPluginInterface* ccPlugin = qobject_cast<ccPluginInterface*>(plugin);
+			const QJsonObject metaData = loader->metaData()["MetaData"].toObject();
 			
-			if ( (plugin == nullptr) || (ccPlugin == nullptr) )
-			{				
-				if ( plugin == nullptr )
-				{
-					ccLog::Warning( tr( "\t%1 does not seem to be a valid plugin\t(%2)" ).arg( fileName, loader->errorString() ) );
-				}
-				else
-				{
-					ccLog::Warning( tr( "\t%1 does not seem to be a valid plugin or it is not supported by this version" ).arg( fileName ) );
-				}
-				
-				loader->unload();
+			// the cache entry is only valid if the plugin file hasn't changed since it was generated
+			const QFileInfo fileInfo( pluginPath );
+			
+			QJsonObject cacheEntry = previousMetaDataCache.value( pluginPath ).toObject();
+			
+			const bool cacheEntryValid = !cacheEntry.isEmpty()
+										 && cacheEntry["size"].toDouble() == static_cast<double>( fileInfo.size() )
+										 && cacheEntry["lastModified"].toDouble() == static_cast<double>( fileInfo.lastModified().toMSecsSinceEpoch() )
+										 && cacheEntry["iid"].toString() == pluginIID;
+			
+			if ( !cacheEntryValid )
+			{
+				cacheEntry = QJsonObject{
+					{ "size", static_cast<double>( fileInfo.size() ) },
+					{ "lastModified", static_cast<double>( fileInfo.lastModified().toMSecsSinceEpoch() ) },
+					{ "iid", pluginIID },
+					{ "type", metaData["type"].toString() }
+				};
+			}
+			
+			ccPluginInterface* ccPlugin = nullptr;
+			
+			const bool deferred = cacheEntryValid && canBeDeferred( cacheEntry );
+			
+			if ( deferred )
+			{
+				// the library will only be loaded on first use
+				ccPlugin = new DeferredPlugin( pluginPath, pluginIID, metaData, cacheEntry );
 				
 				delete loader;
 				
-				continue;
+				loader = nullptr;
+			}
+			else
+			{
+				QObject* plugin = loader->instance();
+				ccPlugin = qobject_cast<ccPluginInterface*>(plugin);
+				
+				if ( (plugin == nullptr) || (ccPlugin == nullptr) )
+				{				
+					if ( plugin == nullptr )
+					{
+						ccLog::Warning( tr( "\t%1 does not seem to be a valid plugin\t(%2)" ).arg( fileName, loader->errorString() ) );
+					}
+					else
+					{
+						ccLog::Warning( tr( "\t%1 does not seem to be a valid plugin or it is not supported by this version" ).arg( fileName ) );
+					}
+					
+					loader->unload();
+					
+					delete loader;
+					
+					continue;
+				}
+				
+				ccPlugin->setIID( pluginIID );
 			}
 			
 			if ( ccPlugin->getName().isEmpty() )
 			{
 				ccLog::Error( tr( "Plugin %1 has a blank name" ).arg( fileName ) );
 				
-				loader->unload();
-				
-				delete loader;
+				if ( loader != nullptr )
+				{
+					loader->unload();
+					
+					delete loader;
+				}
+				else
+				{
+					delete ccPlugin;
+				}
 				
 				continue;
 			}
 			
-			ccPlugin->setIID( pluginIID );
-			
-			QPluginLoader* previousLoader = pluginIIDToLoaderMap.value( pluginIID );
+			ccPluginInterface* previousPlugin = pluginIIDToPluginMap.value( pluginIID );
 			
 			// If we have already loaded a plugin with this IID, unload it and replace the interface in the plugin list
-			if ( previousLoader != nullptr )
+			if ( previousPlugin != nullptr )
 			{
-				ccPluginInterface* pluginInterface = qobject_cast<ccPluginInterface *>( previousLoader->instance() );
-				
 				// maintain the order of the plugin list
-				const int index = m_pluginList.indexOf( pluginInterface );
+				const int index = m_pluginList.indexOf( previousPlugin );
 				m_pluginList.replace( index, ccPlugin );
 				
-				previousLoader->unload();
+				m_metaDataCache.remove( m_pluginFiles.take( previousPlugin ) );
+				
+				QPluginLoader* previousLoader = pluginIIDToLoaderMap.take( pluginIID );
 				
-				delete previousLoader;
+				if ( previousLoader != nullptr )
+				{
+					previousLoader->unload();
+					
+					delete previousLoader;
+				}
+				else
+				{
+					// deferred plugin
+					delete previousPlugin;
+				}
 				
 				ccLog::Warning( tr( "\t%1 overridden" ).arg( fileName ) );
 			}
@@ -371,9 +1033,25 @@ void ccPluginManager::loadFromPathsAndAddToList()
 				m_pluginList.push_back( ccPlugin );
 			}
 			
-			pluginIIDToLoaderMap[pluginIID] = loader;
+			pluginIIDToPluginMap[pluginIID] = ccPlugin;
 			
-			ccLog::Print( tr( "\tPlugin found: %1 (%2)" ).arg( ccPlugin->getName(), fileName ) );
+			if ( loader != nullptr )
+			{
+				pluginIIDToLoaderMap[pluginIID] = loader;
+			}
+			
+			m_pluginFiles[ccPlugin] = pluginPath;
+			
+			m_metaDataCache.insert( pluginPath, cacheEntry );
+			
+			if ( deferred )
+			{
+				ccLog::Print( tr( "\tPlugin found: %1 (%2, deferred)" ).arg( ccPlugin->getName(), fileName ) );
+			}
+			else
+			{
+				ccLog::Print( tr( "\tPlugin found: %1 (%2)" ).arg( ccPlugin->getName(), fileName ) );
+			}
 		}
 	}
 	
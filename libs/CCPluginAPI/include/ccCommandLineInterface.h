@@ -160,6 +160,12 @@ public: //commands
 		//! Main process
 		virtual bool process(ccCommandLineInterface& cmd) = 0;
 
+		//! Returns whether the command can be applied to the point clouds chunk by chunk (streaming mode)
+		/** I.e. the result for each point only depends on the point itself and on the command parameters.
+			\param arguments the arguments following the command keyword
+		**/
+		virtual bool isPointLocal(const QStringList& arguments) const { Q_UNUSED(arguments); return false; }
+
 		//! Command name
 		QString m_name;
 		//! Command keyword
@@ -269,6 +275,62 @@ public: //logging
 	virtual void warning(const QString& message) const = 0;
 	virtual bool error(const QString& message) const = 0; //must always return false!
 
+public: //profiling
+
+	//! Starts a profiling section (only if profiling is enabled, see the '-PROFILE' option)
+	/** The commands, file imports and file exports are automatically profiled.
+		Commands (e.g. from plugins) can profile their own steps as well (sections
+		can be nested). See ProfilingScope.
+		\param category section category (e.g. the plugin name)
+		\param name section name
+		\return section handle (see endProfilingSection) or -1 if profiling is disabled
+	**/
+	virtual int beginProfilingSection(const QString& category, const QString& name) { Q_UNUSED(category); Q_UNUSED(name); return -1; }
+
+	//! Ends a profiling section
+	/** \param section section handle (as returned by beginProfilingSection)
+		\param pointCount number of processed points (to compute the throughput)
+		\param triangleCount number of processed triangles (to compute the throughput)
+	**/
+	virtual void endProfilingSection(int section, size_t pointCount = 0, size_t triangleCount = 0) { Q_UNUSED(section); Q_UNUSED(pointCount); Q_UNUSED(triangleCount); }
+
+	//! Profiling section that ends automatically when going out of scope
+	class ProfilingScope
+	{
+	public:
+
+		//! Default constructor (starts the section)
+		ProfilingScope(ccCommandLineInterface& cmd, const QString& category, const QString& name)
+			: m_cmd(cmd)
+			, m_section(cmd.beginProfilingSection(category, name))
+			, m_pointCount(0)
+			, m_triangleCount(0)
+		{}
+
+		//! Destructor (ends the section)
+		~ProfilingScope()
+		{
+			if (m_section >= 0)
+			{
+				m_cmd.endProfilingSection(m_section, m_pointCount, m_triangleCount);
+			}
+		}
+
+		//! Sets the number of processed points
+		void setPointCount(size_t count) { m_pointCount = count; }
+		//! Sets the number of processed triangles
+		void setTriangleCount(size_t count) { m_triangleCount = count; }
+
+	private:
+
+		Q_DISABLE_COPY(ProfilingScope)
+
+		ccCommandLineInterface& m_cmd;
+		int m_section;
+		size_t m_pointCount;
+		size_t m_triangleCount;
+	};
+
 public: //access to data
 
 	//! Currently opened point clouds and their filename
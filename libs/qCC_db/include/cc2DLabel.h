@@ -185,6 +185,13 @@ public:
 	//! Returns a given point
 	inline const PickedPoint& getPickedPoint(unsigned index) const { return m_pickedPoints[index]; }
 
+	//! Updates the indexes of the points picked on a given cloud
+	/** To be called when the points of the cloud are reordered (see ccPointCloud::reorderPoints).
+		\param cloud cloud
+		\param newIndexMap new index of each (old) point of the cloud
+	**/
+	void updatePointIndexes(const ccGenericPointCloud* cloud, const std::vector<int>& newIndexMap);
+
 	//! Sets marker (relative) scale
 	/** Default value: 1.0
 	**/
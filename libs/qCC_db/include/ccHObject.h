@@ -142,11 +142,24 @@ public: //children management
 	inline ccHObject* getChild(unsigned childPos) const { return (childPos < getChildrenNumber() ? m_children[childPos] : nullptr); }
 
 	//! Finds an entity in this object hierarchy
-	/** \param uniqueID child unique ID
+	/** The entity is first looked up in the registry of all the existing
+		objects (see GetObjectByUniqueID) so that the whole hierarchy doesn't
+		need to be traversed.
+		\param uniqueID child unique ID
 		\return child (or nullptr if not found)
 	**/
 	ccHObject* find(unsigned uniqueID) const;
 
+	//! Returns an existing object by its unique ID (or nullptr if there's none)
+	/** All the hierarchical objects are registered at construction time and
+		unregistered at deletion time (whatever their parent).
+		\warning if several objects share the same ID, the first one is returned
+	**/
+	static ccHObject* GetObjectByUniqueID(unsigned uniqueID);
+
+	//inherited from ccObject
+	void setUniqueID(unsigned ID) override;
+
 	//! Standard instances container (for children, etc.)
 	using Container = std::vector<ccHObject *>;
 
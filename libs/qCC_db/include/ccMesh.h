@@ -25,6 +25,12 @@
 //Local
 #include "ccGenericMesh.h"
 
+//Qt
+#include <QSharedPointer>
+
+//system
+#include <vector>
+
 class ccProgressDialog;
 class ccPolyline;
 
@@ -347,8 +353,45 @@ public:
 	//! Computes per-triangle normals
 	bool computePerTriangleNormals();
 
+	//! Vertex adjacency (Compressed Sparse Row format)
+	/** The neighbors of vertex i are stored in 'neighbors', between
+		indexes offsets[i] (included) and offsets[i+1] (excluded).
+		They are sorted by increasing index, without duplicates.
+	**/
+	struct VertexAdjacency
+	{
+		using Shared = QSharedPointer<const VertexAdjacency>;
+
+		//! Start of the neighbors of each vertex (+ the total number of neighbors at the end)
+		std::vector<unsigned> offsets;
+		//! Neighbors of all the vertices
+		std::vector<unsigned> neighbors;
+		//! Number of triangles when the structure was built
+		unsigned triangleCount = 0;
+
+		//! Returns the number of vertices
+		inline unsigned vertexCount() const { return offsets.empty() ? 0 : static_cast<unsigned>(offsets.size() - 1); }
+		//! Returns the number of neighbors of a given vertex
+		inline unsigned neighborCount(unsigned vertexIndex) const { return offsets[vertexIndex + 1] - offsets[vertexIndex]; }
+		//! Returns the neighbors of a given vertex
+		inline const unsigned* neighborsOf(unsigned vertexIndex) const { return neighbors.data() + offsets[vertexIndex]; }
+	};
+
+	//! Returns the vertex adjacency
+	/** The structure is computed on the first call, then cached until the triangles change.
+		\return the vertex adjacency (or a null pointer if the mesh is invalid or not enough memory)
+	**/
+	VertexAdjacency::Shared getVertexAdjacency() const;
+
+	//! Releases the cached vertex adjacency
+	/** Must be called if the triangles vertex indexes are modified directly (see getTriangleVertIndexes).
+	**/
+	void invalidateVertexAdjacency();
+
 	//! Laplacian smoothing
-	/** \param nbIteration smoothing iterations
+	/** Each iteration moves all the vertices simultaneously (Jacobi scheme) towards
+		the barycenter of their neighbors (see getVertexAdjacency).
+		\param nbIteration smoothing iterations
 		\param factor smoothing 'force'
 		\param progressCb progress dialog callback
 	**/
@@ -356,6 +399,19 @@ public:
 							PointCoordinateType factor = static_cast<PointCoordinateType>(0.01),
 							ccProgressDialog* progressCb = nullptr);
 
+	//! Taubin smoothing (smoothing without shrinkage)
+	/** Each iteration is made of a Laplacian step with a positive factor (lambda)
+		followed by a Laplacian step with a negative factor (mu), with |mu| > lambda.
+		\param nbIteration smoothing iterations
+		\param lambda positive smoothing factor
+		\param mu negative 'inflating' factor
+		\param progressCb progress dialog callback
+	**/
+	bool taubinSmooth(	unsigned nbIteration = 100,
+						PointCoordinateType lambda = static_cast<PointCoordinateType>(0.5),
+						PointCoordinateType mu = static_cast<PointCoordinateType>(-0.53),
+						ccProgressDialog* progressCb = nullptr);
+
 	//! Mesh scalar field processes
 	enum MESH_SCALAR_FIELD_PROCESS {	SMOOTH_MESH_SF,		/**< Smooth **/
 										ENHANCE_MESH_SF,	/**< Enhance **/
@@ -373,7 +429,10 @@ public:
 	bool processScalarField(MESH_SCALAR_FIELD_PROCESS process);
 
 	//! Subdivides mesh (so as to ensure that all triangles are falls below 'maxArea')
-	/** \return subdivided mesh (if successful)
+	/** The triangles are subdivided by successive passes: at each pass, the edges of all
+		the triangles that are too large are split in their middle, and all the triangles
+		having at least one split edge are replaced (so that the mesh remains conforming).
+		\return subdivided mesh (if successful)
 	**/
 	ccMesh* subdivide(PointCoordinateType maxArea) const;
 
@@ -397,10 +456,51 @@ public:
 	//! Transforms the mesh per-triangle normals
 	void transformTriNormals(const ccGLMatrix& trans);
 
-	//! Default octree level for the 'mergeDuplicatedVertices' algorithm
+	//! Vertex welding parameters (see weldVertices)
+	struct WeldingParameters
+	{
+		//! Max distance between two vertices to be merged (0 = exact duplicates only)
+		double epsilon = 0.0;
+		//! Whether to remove the degenerate triangles (i.e. with at least two identical vertices after welding)
+		bool removeDegenerateTriangles = true;
+		//! Whether to remove the duplicate triangles (i.e. with the same vertices, whatever their order)
+		bool removeDuplicateTriangles = true;
+	};
+
+	//! Vertex welding statistics (see weldVertices)
+	struct WeldingStats
+	{
+		unsigned mergedVertexCount = 0;
+		unsigned degenerateTriangleCount = 0;
+		unsigned duplicateTriangleCount = 0;
+	};
+
+	//! Welds the duplicated (or very close) vertices and cleans the triangles
+	/** The vertices are hashed in a regular grid (in parallel), and each vertex is merged with
+		the vertex with the smallest index that is closer than the tolerance (if any).
+		The triangles indexes are updated in place, and the degenerate and/or duplicate triangles
+		are removed. The per-triangle normals, texture coordinates and material indexes are
+		compacted along with the triangles (in a single pass). Sub-meshes are updated as well.
+		Warning: the associated cloud is replaced if some vertices are merged.
+		\param params welding parameters
+		\param stats output statistics (optional)
+		\param progressCb progress callback (optional)
+		\return success
+	**/
+	bool weldVertices(	const WeldingParameters& params,
+						WeldingStats* stats = nullptr,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Default tolerance for merging duplicated vertices
+	static double DefaultWeldingTolerance();
+
+	//! Default octree level for the 'mergeDuplicatedVertices' algorithm (not used anymore)
 	static const unsigned char DefaultMergeDulicateVerticesLevel = 10;
 
 	//! Merges duplicated vertices
+	/** Same as weldVertices with the default tolerance (the duplicate triangles are not removed).
+		The octree level is not used anymore (kept for compatibility).
+	**/
 	bool mergeDuplicatedVertices(unsigned char octreeLevel = DefaultMergeDulicateVerticesLevel, QWidget* parentWidget = nullptr);
 
 protected: //methods
@@ -422,8 +522,16 @@ protected: //methods
 	//! Same as other 'interpolateColors' method with a set of 3 vertices indexes
 	bool interpolateColors(const CCCoreLib::VerticesIndexes& vertIndexes, const CCVector3d& w, ccColor::Rgba& C);
 
-	//! Used internally by 'subdivide'
-	bool pushSubdivide(/*PointCoordinateType maxArea, */unsigned indexA, unsigned indexB, unsigned indexC);
+	//! Runs Laplacian smoothing iterations (see laplacianSmooth and taubinSmooth)
+	/** \param nbIteration number of iterations
+		\param factors factor of each step of an iteration (one step per factor)
+		\param title progress dialog title
+		\param progressCb progress dialog callback
+	**/
+	bool smoothVertices(unsigned nbIteration,
+						const std::vector<PointCoordinateType>& factors,
+						const QString& title,
+						ccProgressDialog* progressCb);
 
 	/*** EXTENDED CALL SCRIPTS (FOR CC_SUB_MESHES) ***/
 	
@@ -489,6 +597,9 @@ protected: //members
 	using triangleNormalsIndexesSet = ccArray<Tuple3i, 3, int>;
 	//! Mesh normals indexes (per-triangle)
 	triangleNormalsIndexesSet* m_triNormalIndexes;
+
+	//! Vertex adjacency (cache)
+	mutable VertexAdjacency::Shared m_vertexAdjacency;
 };
 
 #endif //CC_MESH_HEADER
@@ -77,6 +77,7 @@ public:
 		\param preferredOrientation specifies a preferred orientation for normals (optional)
 		\param progressCb progress notification (optional)
 		\param inputOctree inputOctree input cloud octree (optional).
+		\param kNN if not 0, the local model is fitted on the kNN nearest neighbours of each point instead of a spherical neighbourhood (LS and QUADRIC only)
 		\return success
 	**/
 	static bool ComputeCloudNormals(ccGenericPointCloud* cloud,
@@ -85,7 +86,8 @@ public:
 									PointCoordinateType localRadius,
 									Orientation preferredOrientation = UNDEFINED,
 									CCCoreLib::GenericProgressCallback* progressCb = 0,
-									CCCoreLib::DgmOctree* inputOctree = 0);
+									CCCoreLib::DgmOctree* inputOctree = 0,
+									unsigned kNN = 0);
 
 	//! Tries to guess a very naive 'local radius' for normals computation (see ComputeCloudNormals)
 	/** \param cloud point cloud on which to process the normals.
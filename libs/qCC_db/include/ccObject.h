@@ -25,6 +25,9 @@
 #include <QSharedPointer>
 #include <QVariant>
 
+//system
+#include <atomic>
+
 
 //! Object state flag
 enum CC_OBJECT_FLAG {	//CC_UNUSED			= 1, //DGM: not used anymore (former CC_FATHER_DEPENDENT)
@@ -160,15 +163,23 @@ public:
 
 	//! Resets the unique ID
 	void reset() { m_lastUniqueID = MinUniqueID; }
-	//! Returns a (new) unique ID
+	//! Returns a (new) unique ID (thread-safe)
 	unsigned fetchOne() { return ++m_lastUniqueID; }
 	//! Returns the value of the last generated unique ID
 	unsigned getLast() const { return m_lastUniqueID; }
-	//! Updates the value of the last generated unique ID with the current one
-	void update(unsigned ID) { if (ID > m_lastUniqueID) m_lastUniqueID = ID; }
+	//! Updates the value of the last generated unique ID with the current one (thread-safe)
+	void update(unsigned ID)
+	{
+		unsigned last = m_lastUniqueID.load();
+		while (ID > last && !m_lastUniqueID.compare_exchange_weak(last, ID))
+		{
+			//'last' has been updated, we try again
+		}
+	}
 
 protected:
-	unsigned m_lastUniqueID;
+	//entities may be created concurrently (e.g. by the command line parallel mode)
+	std::atomic<unsigned> m_lastUniqueID;
 };
 
 //! Generic "CloudCompare Object" template
@@ -0,0 +1,48 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#                  COPYRIGHT: Daniel Girardeau-Montaut                   #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_PARALLEL_FOR_HEADER
+#define CC_PARALLEL_FOR_HEADER
+
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_for.h>
+#endif
+
+//! Parallel loops helpers
+namespace ccParallel
+{
+	//! Runs a function for all indexes in [0, count[ (in parallel if possible)
+	/** Relies on TBB if CCCoreLib uses it, or on OpenMP otherwise (if enabled).
+		\warning The function should not throw (catch the exceptions inside the loop body)
+	**/
+	template <class Func> void For(int count, const Func& func)
+	{
+#ifdef CC_CORE_LIB_USES_TBB
+		tbb::parallel_for(0, count, func);
+#else
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+		for (int i = 0; i < count; ++i)
+		{
+			func(i);
+		}
+#endif
+	}
+}
+
+#endif //CC_PARALLEL_FOR_HEADER
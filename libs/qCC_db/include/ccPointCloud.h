@@ -367,10 +367,15 @@ public: //normals computation/orientation
 	bool orientNormalsTowardViewPoint( CCVector3 & VP, ccProgressDialog* pDlg = nullptr);
 
 	//! Compute the normals by approximating the local surface around each point
+	/** If kNN is not 0, the local surface is fitted on the kNN nearest neighbours
+		of each point instead of the points inside a sphere of radius 'defaultRadius'
+		(LS and QUADRIC models only).
+	**/
 	bool computeNormalsWithOctree(	CCCoreLib::LOCAL_MODEL_TYPES model,
 									ccNormalVectors::Orientation preferredOrientation,
 									PointCoordinateType defaultRadius,
-									ccProgressDialog* pDlg = nullptr );
+									ccProgressDialog* pDlg = nullptr,
+									unsigned kNN = 0 );
 
 	//! Orient the normals with a Minimum Spanning Tree
 	bool orientNormalsWithMST(		unsigned kNN = 6,
@@ -727,6 +732,62 @@ public: //other methods
 	**/
 	const ccPointCloud& append(ccPointCloud* cloud, unsigned pointCountBefore, bool ignoreChildren = false);
 
+	//! Appends several clouds to this one at once
+	/** Much faster than successive calls to append when merging many clouds: the final
+		layout (scalar fields, colors, normals, waveforms) is computed once, each table
+		is allocated a single time and the attributes are copied in parallel.
+		\param clouds clouds to be added
+		\param ignoreChildren whether to copy input clouds' children or not
+		\return success
+	**/
+	bool append(const std::vector<ccPointCloud*>& clouds, bool ignoreChildren = false);
+
+	//! Space filling curves (see reorderPoints)
+	enum class SpatialOrder
+	{
+		MORTON = 0,		/**< Morton (Z-order) curve, i.e. the octree cell codes order **/
+		HILBERT = 1,	/**< Hilbert curve (better locality than the Morton curve) **/
+	};
+
+	//! Returns the name of the scalar field storing the original point indexes (see reorderPoints)
+	static inline const char* OriginalIndexesSFName() { return "Original index"; }
+	//! Returns the name of the scalar field storing the higher bits of the original point indexes
+	/** Only used when there are too many points to store the indexes exactly in a single
+		scalar field. In this case, the 'Original index' scalar field stores the 16 lower bits.
+	**/
+	static inline const char* OriginalIndexesHighSFName() { return "Original index (high bits)"; }
+
+	//! Returns whether the cloud is the vertices of at least one mesh
+	/** The meshes (and sub-meshes) register themselves as dependents of their associated
+		cloud, whether they are its parent, its children or anywhere else in the DB tree.
+	**/
+	bool isMeshVertices() const;
+
+	//! Returns whether other entities refer to the points by index (and can't be updated if the points are reordered)
+	/** I.e. the meshes (see isMeshVertices), the polylines and the kd-trees based on this cloud.
+		The labels are not concerned (their picked points are updated by reorderPoints).
+	**/
+	bool hasIndexedDependents() const;
+
+	//! Reorders the points along a space filling curve
+	/** All the point attributes (colors, normals, scalar fields, waveforms, scan grids and
+		visibility) are reordered in place, so that spatially close points are also close in
+		memory. This makes the octree traversals, neighborhood searches, LOD, etc. more cache
+		friendly. The octree and the LOD structure are dropped.
+		The points picked by the labels are updated.
+		\warning Fails if other entities refer to the points by index (see hasIndexedDependents).
+		\param order space filling curve
+		\param storeOriginalIndexes whether to store the original point indexes in a scalar field (see OriginalIndexesSFName and restoreOriginalPointOrder)
+		\return success
+	**/
+	bool reorderPoints(SpatialOrder order, bool storeOriginalIndexes = false);
+
+	//! Restores the original order of the points (see reorderPoints)
+	/** Requires the scalar field storing the original point indexes (which is then removed).
+		\return success
+	**/
+	bool restoreOriginalPointOrder();
+
 	//! Enhances the RGB colors with the current scalar field (assuming it's intensities)
 	bool enhanceRGBWithIntensitySF(int sfIdx, bool useCustomIntensityRange = false, double minI = 0.0, double maxI = 1.0);
 
@@ -744,6 +805,14 @@ public: //other methods
 
 protected:
 
+	//! Permutes the points (and all their attributes) in place
+	/** The points picked by the labels are updated. Fails if other entities refer to the points
+		by index (see hasIndexedDependents).
+		\param order source index of each point (i.e. new point #i = old point #order[i])
+		\return success
+	**/
+	bool permutePoints(const std::vector<unsigned>& order);
+
 	//inherited from ccHObject
 	void drawMeOnly(CC_DRAW_CONTEXT& context) override;
 	void applyGLTransformation(const ccGLMatrix& trans) override;
@@ -756,6 +825,14 @@ protected:
 	**/
 	void swapPoints(unsigned firstIndex, unsigned secondIndex) override;
 
+	//! Imports the grid structures, the global shift and the children of an appended cloud
+	/** See ccPointCloud::append.
+		\param addedCloud appended cloud
+		\param pointCountBefore index of the first point of the appended cloud
+		\param ignoreChildren whether to copy the appended cloud's children or not
+	**/
+	void appendStructures(ccPointCloud* addedCloud, unsigned pointCountBefore, bool ignoreChildren);
+
 	//! Colors
 	RGBAColorsTableType* m_rgbaColors;
 
@@ -19,16 +19,22 @@
 #define CC_POINT_CLOUD_INTERPOLATOR
 
 class ccPointCloud;
+class ccOctree;
 
 //Local
 #include "qCC_db.h"
 
+//Qt
+#include <QByteArray>
+#include <QSharedPointer>
+
 //System
 #include <vector>
 
 namespace CCCoreLib
 {
 	class GenericProgressCallback;
+	class ScalarField;
 }
 
 class QCC_DB_LIB_API ccPointCloudInterpolator
@@ -39,13 +45,16 @@ public:
 	struct Parameters
 	{
 		enum Method { NEAREST_NEIGHBOR, K_NEAREST_NEIGHBORS, RADIUS };
-		enum Algo { AVERAGE, MEDIAN, NORMAL_DIST };
+		enum Algo { AVERAGE, MEDIAN, NORMAL_DIST, INVERSE_DIST };
 
 		Method method = NEAREST_NEIGHBOR;
 		Algo algo = AVERAGE;
 		unsigned knn = 0;
 		float radius = 0;
+		//! Normal distribution (Gaussian kernel) sigma
 		double sigma = 0;
+		//! Inverse distance weighting power
+		double power = 2.0;
 	};
 
 	//! Interpolate scalar fields from another cloud
@@ -56,7 +65,57 @@ public:
 											CCCoreLib::GenericProgressCallback* progressCb = 0,
 											unsigned char octreeLevel = 0);
 
+	//! Interpolation engine
+	/** The source cloud octree is retrieved (or computed and attached to the cloud)
+		once, and is then reused for all the destination clouds. All the scalar fields
+		are interpolated in a single (parallel) neighborhood pass, during which their
+		min and max values are also computed.
+	**/
+	class QCC_DB_LIB_API Engine
+	{
+	public:
+
+		//! Default constructor
+		Engine();
+
+		//! Sets the source cloud, the scalar fields to interpolate and the interpolation parameters
+		/** \param srcCloud source cloud
+			\param sfIndexes indexes of the source scalar fields
+			\param params interpolation parameters
+			\param progressCb progress callback (optional, for the octree computation)
+			\param octreeLevel octree level (optional, automatically determined if 0)
+			\return success
+		**/
+		bool setSource(	ccPointCloud* srcCloud,
+						const std::vector<int>& sfIndexes,
+						const Parameters& params,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+						unsigned char octreeLevel = 0);
 
+		//! Interpolates the scalar fields on a destination cloud
+		/** Scalar fields with the same name are overwritten.
+			\param destCloud destination cloud
+			\param progressCb progress callback (optional)
+			\return success
+		**/
+		bool interpolateTo(	ccPointCloud* destCloud,
+							CCCoreLib::GenericProgressCallback* progressCb = nullptr) const;
+
+	protected:
+
+		//! Source cloud
+		ccPointCloud* m_srcCloud;
+		//! Source scalar fields
+		std::vector<const CCCoreLib::ScalarField*> m_srcSFs;
+		//! Source scalar fields names
+		std::vector<QByteArray> m_sfNames;
+		//! Interpolation parameters
+		Parameters m_params;
+		//! Source octree
+		QSharedPointer<ccOctree> m_octree;
+		//! Octree level used for the neighborhood extraction
+		unsigned char m_octreeLevel;
+	};
 };
 
 #endif //CC_POINT_CLOUD_INTERPOLATOR
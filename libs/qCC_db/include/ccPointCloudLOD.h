@@ -50,7 +50,7 @@ struct LODLevelDesc
 typedef std::vector<unsigned> LODIndexSet;
 
 //! L.O.D. (Level of Detail) structure
-class ccPointCloudLOD
+class QCC_DB_LIB_API ccPointCloudLOD
 {
 public:
 	//! Structure initialization state
@@ -170,6 +170,12 @@ public:
 	//inherited
 	void computeMinAndMax() override;
 
+	//! Sets the min and max values (if they have already been computed elsewhere)
+	/** The display range, the histogram and the saturation bounds are updated accordingly.
+		\warning No check is done on the actual values of the field!
+	**/
+	void setMinAndMax(ScalarType minVal, ScalarType maxVal);
+
 	//! Returns associated color scale
 	inline const ccColorScale::Shared& getColorScale() const { return m_colorScale; }
 
@@ -216,6 +222,85 @@ public:
 	//! Sets the global shift
 	inline void setGlobalShift(double shift) { m_globalShift = shift; }
 
+	/*** Compact storage ***/
+
+	//! Compact storage types
+	/** \warning The values are always stored as ScalarType values in memory (see
+		CCCoreLib::ScalarField). The compact storage is a serialization option: the
+		preferred storage is used to save them in BIN files (version 5.3, if it is
+		lossless, see BinFilter::SetCompactScalarFields) and by the I/O filters that
+		handle typed fields (LAS, E57).
+	**/
+	enum class StorageType : uint8_t
+	{
+		NATIVE = 0,		/**< Native ScalarType values (32 bits floating point values by default) **/
+		UINT8 = 1,		/**< Quantized values on 8 bits (value = offset + scale * code) **/
+		UINT16 = 2,		/**< Quantized values on 16 bits (value = offset + scale * code) **/
+		FLOAT16 = 3,	/**< Half precision floating point values **/
+	};
+
+	//! Compact storage descriptor
+	struct QCC_DB_LIB_API Storage
+	{
+		//! Storage type
+		StorageType type = StorageType::NATIVE;
+		//! Quantization scale (for UINT8 and UINT16 storage types only)
+		double scale = 1.0;
+		//! Quantization offset (for UINT8 and UINT16 storage types only)
+		double offset = 0.0;
+
+		//! Returns the number of bytes per value
+		size_t bytesPerValue() const;
+		//! Returns a short description of the storage (e.g. 'uint8')
+		QString description() const;
+
+		//! Returns the most compact storage for the quantized values of a given range
+		/** \param minValue minimum value
+			\param maxValue maximum value
+			\param scale quantization step
+			\return a quantized storage or the native storage if the range is too large
+		**/
+		static Storage ForRange(double minValue, double maxValue, double scale = 1.0);
+	};
+
+	//! Returns the preferred compact storage of the values
+	inline const Storage& getStorage() const { return m_storage; }
+	//! Sets the preferred compact storage of the values (typically the type of the field in the source file)
+	inline void setStorage(const Storage& storage) { m_storage = storage; }
+
+	//! Returns whether all the values can be stored with a given storage without any loss
+	/** NaN values can only be stored with the native and FLOAT16 storage types.
+	**/
+	bool isLosslessWith(const Storage& storage) const;
+
+	//! Returns the most compact lossless storage for the current values
+	/** The preferred storage is returned if it is lossless. Otherwise the values are analyzed.
+	**/
+	Storage getCompactStorage() const;
+
+	//! Returns the memory currently used by the values (in bytes)
+	inline size_t memoryUsage() const { return capacity() * sizeof(ScalarType); }
+	//! Returns the size of the values once saved with the preferred storage (in bytes)
+	/** The values still use memoryUsage() bytes in memory.
+	**/
+	inline size_t compactMemoryUsage() const { return currentSize() * m_storage.bytesPerValue(); }
+
+	//! Encodes values with a compact storage
+	/** \param storage compact storage (should be lossless for these values, see isLosslessWith)
+		\param values values to encode
+		\param count number of values
+		\param codes output buffer (count * storage.bytesPerValue() bytes)
+	**/
+	static void Encode(const Storage& storage, const ScalarType* values, size_t count, void* codes);
+
+	//! Decodes values stored with a compact storage
+	/** \param storage compact storage
+		\param codes encoded values (count * storage.bytesPerValue() bytes)
+		\param count number of values
+		\param values output values
+	**/
+	static void Decode(const Storage& storage, const void* codes, size_t count, ScalarType* values);
+
 protected: //methods
 
 	//! Default destructor
@@ -223,6 +308,9 @@ protected: //methods
 	**/
 	~ccScalarField() override = default;
 
+	//! Updates the display range, the histogram and the saturation bounds after the min and max values have changed
+	void minAndMaxHaveChanged();
+
 	//! Updates saturation values
 	void updateSaturationBounds();
 
@@ -278,6 +366,9 @@ protected: //members
 
 	//! Global shift
 	double m_globalShift;
+
+	//! Preferred compact storage of the values
+	Storage m_storage;
 };
 
 #endif //CC_DB_SCALAR_FIELD_HEADER
@@ -95,6 +95,33 @@ public:
 	static bool CorruptError() { ccLog::Error("File seems to be corrupted"); return false; }
 };
 
+//! Serialization context
+/** Sets the version of the file written by the current thread, as long as this
+	object lives. The toFile methods can check it (see DataVersion) to remain
+	readable by the previous versions. The current version is used by default.
+**/
+class QCC_DB_LIB_API ccSerializationContext
+{
+public:
+
+	//! Sets the version of the file being written
+	explicit ccSerializationContext(short dataVersion);
+
+	//! Restores the previous version
+	~ccSerializationContext();
+
+	//! Returns the version of the file being written by the current thread
+	static short DataVersion();
+
+private:
+
+	ccSerializationContext(const ccSerializationContext&) = delete;
+	ccSerializationContext& operator=(const ccSerializationContext&) = delete;
+
+	//! Previous version (nested contexts)
+	short m_previousVersion;
+};
+
 //! Serialization helpers
 class ccSerializationHelper
 {
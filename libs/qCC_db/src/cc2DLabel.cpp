@@ -408,6 +408,24 @@ bool cc2DLabel::addPickedPoint(ccGenericMesh* mesh, unsigned triangleIndex, cons
 	return addPickedPoint(pp);
 }
 
+void cc2DLabel::updatePointIndexes(const ccGenericPointCloud* cloud, const std::vector<int>& newIndexMap)
+{
+	bool updated = false;
+	for (PickedPoint& pp : m_pickedPoints)
+	{
+		if (pp._cloud == cloud && !pp.entityCenterPoint && pp.index < newIndexMap.size())
+		{
+			pp.index = static_cast<unsigned>(newIndexMap[pp.index]);
+			updated = true;
+		}
+	}
+
+	if (updated)
+	{
+		updateName();
+	}
+}
+
 bool cc2DLabel::addPickedPoint(const PickedPoint& pp)
 {
 	if (m_pickedPoints.size() == 3)
@@ -46,6 +46,47 @@
 
 //Qt
 #include <QIcon>
+#include <QMutex>
+
+//system
+#include <unordered_map>
+
+//! Registry of all the existing hierarchical objects (indexed by unique ID)
+struct UniqueIDRegistry
+{
+	QMutex mutex;
+	std::unordered_multimap<unsigned, ccHObject*> objects;
+};
+
+static UniqueIDRegistry& GetUniqueIDRegistry()
+{
+	//never released on purpose (some static objects may be destroyed after it)
+	static UniqueIDRegistry* s_registry = new UniqueIDRegistry;
+	return *s_registry;
+}
+
+static void RegisterUniqueID(ccHObject* object, unsigned uniqueID)
+{
+	UniqueIDRegistry& registry = GetUniqueIDRegistry();
+	QMutexLocker locker(&registry.mutex);
+	registry.objects.emplace(uniqueID, object);
+}
+
+static void UnregisterUniqueID(ccHObject* object, unsigned uniqueID)
+{
+	UniqueIDRegistry& registry = GetUniqueIDRegistry();
+	QMutexLocker locker(&registry.mutex);
+	auto range = registry.objects.equal_range(uniqueID);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == object)
+		{
+			registry.objects.erase(it);
+			return;
+		}
+	}
+	assert(false);
+}
 
 ccHObject::ccHObject(const QString& name, unsigned uniqueID/*=ccUniqueIDGenerator::InvalidUniqueID*/)
 	: ccObject(name, uniqueID)
@@ -58,6 +99,8 @@ ccHObject::ccHObject(const QString& name, unsigned uniqueID/*=ccUniqueIDGenerato
 	lockVisibility(true);
 	
 	m_glTransHistory.toIdentity();
+
+	RegisterUniqueID(this, getUniqueID());
 }
 
 ccHObject::ccHObject(const ccHObject& object)
@@ -68,12 +111,16 @@ ccHObject::ccHObject(const ccHObject& object)
 	, m_isDeleting(false)
 {
 	m_glTransHistory.toIdentity();
+
+	RegisterUniqueID(this, getUniqueID());
 }
 
 ccHObject::~ccHObject()
 {
 	m_isDeleting = true;
 
+	UnregisterUniqueID(this, getUniqueID());
+
 	//process dependencies
 	for (std::map<ccHObject*, int>::const_iterator it = m_dependencies.begin(); it != m_dependencies.end(); ++it)
 	{
@@ -388,18 +435,18 @@ unsigned int ccHObject::getChildCountRecursive() const
 	return count;
 }
 
-ccHObject* ccHObject::find(unsigned uniqueID) const
+static ccHObject* FindRecursive(const ccHObject* object, unsigned uniqueID)
 {
 	//found the right item?
-	if (getUniqueID() == uniqueID)
+	if (object->getUniqueID() == uniqueID)
 	{
-		return const_cast<ccHObject *>(this);
+		return const_cast<ccHObject *>(object);
 	}
 	
 	//otherwise we are going to test all children recursively
-	for (unsigned i = 0; i < getChildrenNumber(); ++i)
+	for (unsigned i = 0; i < object->getChildrenNumber(); ++i)
 	{
-		ccHObject* match = getChild(i)->find(uniqueID);
+		ccHObject* match = FindRecursive(object->getChild(i), uniqueID);
 		if (match)
 		{
 			return match;
@@ -409,6 +456,66 @@ ccHObject* ccHObject::find(unsigned uniqueID) const
 	return nullptr;
 }
 
+ccHObject* ccHObject::find(unsigned uniqueID) const
+{
+	//found the right item?
+	if (getUniqueID() == uniqueID)
+	{
+		return const_cast<ccHObject *>(this);
+	}
+
+	//look for the existing objects with this ID
+	ccHObject::Container candidates;
+	{
+		UniqueIDRegistry& registry = GetUniqueIDRegistry();
+		QMutexLocker locker(&registry.mutex);
+		auto range = registry.objects.equal_range(uniqueID);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			candidates.push_back(it->second);
+		}
+	}
+
+	if (candidates.empty())
+	{
+		//no such object
+		return nullptr;
+	}
+
+	//is one of them below this object? (we only need to climb up the hierarchy)
+	for (ccHObject* candidate : candidates)
+	{
+		if (isAncestorOf(candidate))
+		{
+			return candidate;
+		}
+	}
+
+	//the object may still be a child of this object without having it as parent
+	//(i.e. if it was added without the DP_PARENT_OF_OTHER flag)
+	return FindRecursive(this, uniqueID);
+}
+
+ccHObject* ccHObject::GetObjectByUniqueID(unsigned uniqueID)
+{
+	UniqueIDRegistry& registry = GetUniqueIDRegistry();
+	QMutexLocker locker(&registry.mutex);
+	auto it = registry.objects.find(uniqueID);
+	return (it != registry.objects.end() ? it->second : nullptr);
+}
+
+void ccHObject::setUniqueID(unsigned ID)
+{
+	if (ID == getUniqueID())
+	{
+		return;
+	}
+
+	UnregisterUniqueID(this, getUniqueID());
+	ccObject::setUniqueID(ID);
+	RegisterUniqueID(this, getUniqueID());
+}
+
 unsigned ccHObject::filterChildren(	Container& filteredChildren,
 									bool recursive/*=false*/,
 									CC_CLASS_ENUM filter/*=CC_TYPES::OBJECT*/,
@@ -33,6 +33,7 @@
 #include "ccGenericGLDisplay.h"
 #include "ccProgressDialog.h"
 #include "ccChunk.h"
+#include "ccParallelFor.h"
 
 //CCCoreLib
 #include <ManualSegmentationTools.h>
@@ -42,12 +43,172 @@
 #include <Delaunay2dMesh.h>
 
 //System
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <string.h>
 #include <assert.h>
 #include <cmath> //for std::modf
 
 static CCVector3 s_blankNorm(0, 0, 0);
 
+namespace
+{
+	//! Number of elements processed by each parallel job
+	static const unsigned s_parallelChunkSize = 65536;
+	//! Number of bits used to dispatch the (hashed) keys in buckets
+	static const unsigned s_keyBucketBits = 10;
+
+	//! 64 bits hash mixing function (splitmix64 finalizer)
+	inline uint64_t Mix(uint64_t h)
+	{
+		h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+		return h ^ (h >> 31);
+	}
+
+	//! Hashes 3 integer values
+	inline uint64_t Hash3(uint64_t a, uint64_t b, uint64_t c)
+	{
+		return Mix(Mix(Mix(a) ^ b) ^ c);
+	}
+
+	//! Hashes the exact coordinates of a point
+	inline uint64_t HashCoordinates(const CCVector3& P)
+	{
+		uint64_t bits[3] = { 0, 0, 0 };
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			PointCoordinateType c = P.u[d] + static_cast<PointCoordinateType>(0); //to get rid of -0
+			memcpy(bits + d, &c, sizeof(PointCoordinateType));
+		}
+		return Hash3(bits[0], bits[1], bits[2]);
+	}
+
+	//! (Hashed) key and element index
+	struct KeyAndIndex
+	{
+		uint64_t key;
+		unsigned index;
+
+		inline bool operator < (const KeyAndIndex& other) const
+		{
+			return key < other.key || (key == other.key && index < other.index);
+		}
+	};
+
+	//! Returns the bucket of a given key
+	inline unsigned KeyBucket(uint64_t key)
+	{
+		return static_cast<unsigned>(key >> (64 - s_keyBucketBits));
+	}
+
+	//! Sorts (in parallel) a set of keys
+	/** The keys are first dispatched in buckets (depending on their most significant bits),
+		then each bucket is sorted independently (by key, then by index).
+		\param entries keys to sort
+		\param bucketOffsets output: the start of each bucket (+ the total count at the end)
+	**/
+	bool SortKeys(std::vector<KeyAndIndex>& entries, std::vector<size_t>& bucketOffsets)
+	{
+		const size_t count = entries.size();
+		const size_t bucketCount = (static_cast<size_t>(1) << s_keyBucketBits);
+		const int chunkCount = static_cast<int>((count + s_parallelChunkSize - 1) / s_parallelChunkSize);
+
+		std::vector<KeyAndIndex> sorted;
+		std::vector<size_t> positions;
+		try
+		{
+			positions.resize(chunkCount * bucketCount, 0);
+			bucketOffsets.resize(bucketCount + 1, 0);
+			sorted.resize(count);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+
+		//count the keys of each bucket (per chunk)
+		ccParallel::For(chunkCount, [&](int c)
+		{
+			size_t* chunkCounts = positions.data() + c * bucketCount;
+			size_t end = std::min(count, (c + 1) * static_cast<size_t>(s_parallelChunkSize));
+			for (size_t i = c * static_cast<size_t>(s_parallelChunkSize); i < end; ++i)
+			{
+				++chunkCounts[KeyBucket(entries[i].key)];
+			}
+		});
+
+		//where each chunk should write its keys in each bucket
+		size_t offset = 0;
+		for (size_t b = 0; b < bucketCount; ++b)
+		{
+			bucketOffsets[b] = offset;
+			for (int c = 0; c < chunkCount; ++c)
+			{
+				size_t chunkCount_b = positions[c * bucketCount + b];
+				positions[c * bucketCount + b] = offset;
+				offset += chunkCount_b;
+			}
+		}
+		bucketOffsets[bucketCount] = offset;
+		assert(offset == count);
+
+		//dispatch the keys
+		ccParallel::For(chunkCount, [&](int c)
+		{
+			size_t* chunkPositions = positions.data() + c * bucketCount;
+			size_t end = std::min(count, (c + 1) * static_cast<size_t>(s_parallelChunkSize));
+			for (size_t i = c * static_cast<size_t>(s_parallelChunkSize); i < end; ++i)
+			{
+				sorted[chunkPositions[KeyBucket(entries[i].key)]++] = entries[i];
+			}
+		});
+
+		entries.swap(sorted);
+
+		//sort each bucket
+		ccParallel::For(static_cast<int>(bucketCount), [&](int b)
+		{
+			std::sort(entries.begin() + bucketOffsets[b], entries.begin() + bucketOffsets[b + 1]);
+		});
+
+		return true;
+	}
+
+	//! Returns the position of the first entry with a given key (or the end of the bucket)
+	inline size_t FindKey(const std::vector<KeyAndIndex>& entries, const std::vector<size_t>& bucketOffsets, uint64_t key)
+	{
+		unsigned b = KeyBucket(key);
+		KeyAndIndex value{ key, 0 };
+		return std::lower_bound(entries.begin() + bucketOffsets[b], entries.begin() + bucketOffsets[b + 1], value) - entries.begin();
+	}
+
+	//! Returns the vertices of a triangle sorted by increasing index
+	inline void SortedTriangle(const CCCoreLib::VerticesIndexes& tri, const std::vector<unsigned>& vertexMap, unsigned sortedIndexes[3])
+	{
+		unsigned a = vertexMap[tri.i1];
+		unsigned b = vertexMap[tri.i2];
+		unsigned c = vertexMap[tri.i3];
+		if (a > b) std::swap(a, b);
+		if (b > c) std::swap(b, c);
+		if (a > b) std::swap(a, b);
+		sortedIndexes[0] = a;
+		sortedIndexes[1] = b;
+		sortedIndexes[2] = c;
+	}
+
+	//! Returns the key of an edge
+	/** The mixing function is a bijection: two different edges can't have the same key.
+	**/
+	inline uint64_t EdgeKey(unsigned i1, unsigned i2)
+	{
+		if (i1 > i2)
+			std::swap(i1, i2);
+		return Mix((static_cast<uint64_t>(i1) << 32) | static_cast<uint64_t>(i2));
+	}
+}
+
 ccMesh::ccMesh(ccGenericPointCloud* vertices, unsigned uniqueID/*=ccUniqueIDGenerator::InvalidUniqueID*/)
 	: ccGenericMesh("Mesh", uniqueID)
 	, m_associatedCloud(nullptr)
@@ -129,6 +290,7 @@ void ccMesh::setAssociatedCloud(ccGenericPointCloud* cloud)
 		m_associatedCloud->addDependency(this,DP_NOTIFY_OTHER_ON_DELETE | DP_NOTIFY_OTHER_ON_UPDATE);
 
 	m_bBox.setValidity(false);
+	invalidateVertexAdjacency();
 }
 
 void ccMesh::onUpdateOf(ccHObject* obj)
@@ -540,9 +702,195 @@ void ccMesh::transformTriNormals(const ccGLMatrix& trans)
 	}
 }
 
+ccMesh::VertexAdjacency::Shared ccMesh::getVertexAdjacency() const
+{
+	if (!m_associatedCloud)
+	{
+		return VertexAdjacency::Shared();
+	}
+
+	const unsigned vertCount = m_associatedCloud->size();
+	const unsigned faceCount = size();
+
+	//is the cached structure still valid?
+	if (m_vertexAdjacency && m_vertexAdjacency->vertexCount() == vertCount && m_vertexAdjacency->triangleCount == faceCount)
+	{
+		return m_vertexAdjacency;
+	}
+	m_vertexAdjacency.clear();
+
+	if (vertCount == 0 || faceCount == 0)
+	{
+		return VertexAdjacency::Shared();
+	}
+
+	QSharedPointer<VertexAdjacency> adjacency(new VertexAdjacency);
+	adjacency->triangleCount = faceCount;
+
+	//triangles of each vertex (counting sort)
+	std::vector<unsigned> triOffsets;
+	std::vector<unsigned> vertTriangles;
+	try
+	{
+		triOffsets.resize(static_cast<size_t>(vertCount) + 1, 0);
+		vertTriangles.resize(static_cast<size_t>(faceCount) * 3);
+		adjacency->offsets.resize(static_cast<size_t>(vertCount) + 1, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccMesh::getVertexAdjacency] Not enough memory");
+		return VertexAdjacency::Shared();
+	}
+
+	for (const CCCoreLib::VerticesIndexes& tri : *m_triVertIndexes)
+	{
+		if (tri.i1 >= vertCount || tri.i2 >= vertCount || tri.i3 >= vertCount)
+		{
+			ccLog::Warning("[ccMesh::getVertexAdjacency] Invalid vertex index");
+			return VertexAdjacency::Shared();
+		}
+		++triOffsets[tri.i1 + 1];
+		++triOffsets[tri.i2 + 1];
+		++triOffsets[tri.i3 + 1];
+	}
+	for (unsigned i = 0; i < vertCount; ++i)
+	{
+		triOffsets[i + 1] += triOffsets[i];
+	}
+	{
+		std::vector<unsigned> positions(triOffsets.begin(), triOffsets.end() - 1);
+		for (unsigned i = 0; i < faceCount; ++i)
+		{
+			const CCCoreLib::VerticesIndexes& tri = m_triVertIndexes->at(i);
+			vertTriangles[positions[tri.i1]++] = i;
+			vertTriangles[positions[tri.i2]++] = i;
+			vertTriangles[positions[tri.i3]++] = i;
+		}
+	}
+
+	//gathers the (sorted and unique) neighbors of a vertex
+	auto gatherNeighbors = [&](unsigned vertexIndex, std::vector<unsigned>& buffer)
+	{
+		buffer.clear();
+		for (unsigned t = triOffsets[vertexIndex]; t < triOffsets[vertexIndex + 1]; ++t)
+		{
+			const CCCoreLib::VerticesIndexes& tri = m_triVertIndexes->at(vertTriangles[t]);
+			for (unsigned j = 0; j < 3; ++j)
+			{
+				if (tri.i[j] != vertexIndex)
+				{
+					buffer.push_back(tri.i[j]);
+				}
+			}
+		}
+		std::sort(buffer.begin(), buffer.end());
+		buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+	};
+
+	const int vertChunkCount = static_cast<int>((vertCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
+
+	//the exceptions can't be propagated outside of the parallel loops
+	std::atomic<bool> notEnoughMemory(false);
+
+	//1st pass: number of neighbors of each vertex
+	ccParallel::For(vertChunkCount, [&](int c)
+	{
+		try
+		{
+			std::vector<unsigned> buffer;
+			unsigned end = std::min(vertCount, (c + 1) * s_parallelChunkSize);
+			for (unsigned i = c * s_parallelChunkSize; i < end && !notEnoughMemory; ++i)
+			{
+				gatherNeighbors(i, buffer);
+				adjacency->offsets[i + 1] = static_cast<unsigned>(buffer.size());
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+		}
+	});
+
+	if (notEnoughMemory)
+	{
+		ccLog::Warning("[ccMesh::getVertexAdjacency] Not enough memory");
+		return VertexAdjacency::Shared();
+	}
+
+	for (unsigned i = 0; i < vertCount; ++i)
+	{
+		adjacency->offsets[i + 1] += adjacency->offsets[i];
+	}
+
+	try
+	{
+		adjacency->neighbors.resize(adjacency->offsets.back());
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccMesh::getVertexAdjacency] Not enough memory");
+		return VertexAdjacency::Shared();
+	}
+
+	//2nd pass: neighbors of each vertex
+	ccParallel::For(vertChunkCount, [&](int c)
+	{
+		try
+		{
+			std::vector<unsigned> buffer;
+			unsigned end = std::min(vertCount, (c + 1) * s_parallelChunkSize);
+			for (unsigned i = c * s_parallelChunkSize; i < end && !notEnoughMemory; ++i)
+			{
+				gatherNeighbors(i, buffer);
+				std::copy(buffer.begin(), buffer.end(), adjacency->neighbors.begin() + adjacency->offsets[i]);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			notEnoughMemory = true;
+		}
+	});
+
+	if (notEnoughMemory)
+	{
+		ccLog::Warning("[ccMesh::getVertexAdjacency] Not enough memory");
+		return VertexAdjacency::Shared();
+	}
+
+	m_vertexAdjacency = adjacency;
+	return m_vertexAdjacency;
+}
+
+void ccMesh::invalidateVertexAdjacency()
+{
+	m_vertexAdjacency.clear();
+}
+
 bool ccMesh::laplacianSmooth(	unsigned nbIteration,
 								PointCoordinateType factor,
 								ccProgressDialog* progressCb/*=0*/)
+{
+	return smoothVertices(nbIteration, { factor }, QObject::tr("Laplacian smooth"), progressCb);
+}
+
+bool ccMesh::taubinSmooth(	unsigned nbIteration,
+							PointCoordinateType lambda,
+							PointCoordinateType mu,
+							ccProgressDialog* progressCb/*=0*/)
+{
+	if (lambda <= 0 || mu >= 0 || -mu < lambda)
+	{
+		ccLog::Warning("[ccMesh::taubinSmooth] Invalid parameters (we must have 0 < lambda < -mu)");
+		return false;
+	}
+
+	return smoothVertices(nbIteration, { lambda, mu }, QObject::tr("Taubin smooth"), progressCb);
+}
+
+bool ccMesh::smoothVertices(unsigned nbIteration,
+							const std::vector<PointCoordinateType>& factors,
+							const QString& title,
+							ccProgressDialog* progressCb)
 {
 	if (!m_associatedCloud)
 		return false;
@@ -554,22 +902,18 @@ bool ccMesh::laplacianSmooth(	unsigned nbIteration,
 	if (!vertCount || !faceCount)
 		return false;
 
-	std::vector<CCVector3> verticesDisplacement;
-	try
-	{
-		verticesDisplacement.resize(vertCount);
-	}
-	catch (const std::bad_alloc&)
+	VertexAdjacency::Shared adjacency = getVertexAdjacency();
+	if (!adjacency)
 	{
 		//not enough memory
 		return false;
 	}
 
-	//compute the number of edges to which belong each vertex
-	std::vector<unsigned> edgesCount;
+	//new positions (Jacobi iterations: all the vertices are moved at once)
+	std::vector<CCVector3> newPositions;
 	try
 	{
-		edgesCount.resize(vertCount, 0);
+		newPositions.resize(vertCount);
 	}
 	catch (const std::bad_alloc&)
 	{
@@ -577,46 +921,57 @@ bool ccMesh::laplacianSmooth(	unsigned nbIteration,
 		return false;
 	}
 
-	placeIteratorAtBeginning();
-	for(unsigned j=0; j<faceCount; j++)
-	{
-		const CCCoreLib::VerticesIndexes* tri = getNextTriangleVertIndexes();
-		edgesCount[tri->i1] += 2;
-		edgesCount[tri->i2] += 2;
-		edgesCount[tri->i3] += 2;
-	}
-
 	//progress dialog
 	CCCoreLib::NormalizedProgress nProgress(progressCb, nbIteration);
 	if (progressCb)
 	{
-		progressCb->setMethodTitle(QObject::tr("Laplacian smooth"));
+		progressCb->setMethodTitle(title);
 		progressCb->setInfo(QObject::tr("Iterations: %1\nVertices: %2\nFaces: %3").arg(nbIteration).arg(vertCount).arg(faceCount));
 		progressCb->start();
 	}
 
-	//repeat Laplacian smoothing iterations
+	const int vertChunkCount = static_cast<int>((vertCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
+
+	//repeat the smoothing iterations
 	for (unsigned iter = 0; iter < nbIteration; iter++)
 	{
-		std::fill(verticesDisplacement.begin(), verticesDisplacement.end(), CCVector3(0, 0, 0));
-
-		//for each triangle
-		placeIteratorAtBeginning();
-		for (unsigned j = 0; j < faceCount; j++)
+		for (PointCoordinateType factor : factors)
 		{
-			const CCCoreLib::VerticesIndexes* tri = getNextTriangleVertIndexes();
-
-			const CCVector3* A = m_associatedCloud->getPoint(tri->i1);
-			const CCVector3* B = m_associatedCloud->getPoint(tri->i2);
-			const CCVector3* C = m_associatedCloud->getPoint(tri->i3);
+			//compute the new positions
+			ccParallel::For(vertChunkCount, [&](int c)
+			{
+				unsigned end = std::min(vertCount, (c + 1) * s_parallelChunkSize);
+				for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
+				{
+					const CCVector3* P = m_associatedCloud->getPoint(i);
+					unsigned neighborCount = adjacency->neighborCount(i);
+					if (neighborCount == 0)
+					{
+						newPositions[i] = *P;
+						continue;
+					}
 
-			CCVector3 dAB = (*B-*A);
-			CCVector3 dAC = (*C-*A);
-			CCVector3 dBC = (*C-*B);
+					CCVector3d sum(0, 0, 0);
+					const unsigned* neighbors = adjacency->neighborsOf(i);
+					for (unsigned j = 0; j < neighborCount; ++j)
+					{
+						sum += CCVector3d::fromArray((*m_associatedCloud->getPoint(neighbors[j]) - *P).u);
+					}
+					newPositions[i] = *P + (sum * (static_cast<double>(factor) / neighborCount)).toPC();
+				}
+			});
 
-			verticesDisplacement[tri->i1] += dAB + dAC;
-			verticesDisplacement[tri->i2] += dBC - dAB;
-			verticesDisplacement[tri->i3] -= dAC + dBC;
+			//apply them
+			ccParallel::For(vertChunkCount, [&](int c)
+			{
+				unsigned end = std::min(vertCount, (c + 1) * s_parallelChunkSize);
+				for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
+				{
+					//this is a "persistent" pointer and we know what type of cloud is behind ;)
+					CCVector3* P = const_cast<CCVector3*>(m_associatedCloud->getPointPersistentPtr(i));
+					*P = newPositions[i];
+				}
+			});
 		}
 
 		if (!nProgress.oneStep())
@@ -624,17 +979,6 @@ bool ccMesh::laplacianSmooth(	unsigned nbIteration,
 			//cancelled by user
 			break;
 		}
-
-		//apply displacement
-		for (unsigned i = 0; i < vertCount; i++)
-		{
-			if (edgesCount[i])
-			{
-				//this is a "persistent" pointer and we know what type of cloud is behind ;)
-				CCVector3* P = const_cast<CCVector3*>(m_associatedCloud->getPointPersistentPtr(i));
-				(*P) += verticesDisplacement[i] * (factor / edgesCount[i]);
-			}
-		}
 	}
 
 	m_associatedCloud->notifyGeometryUpdate();
@@ -1566,6 +1910,7 @@ const ccGLMatrix& ccMesh::getGLTransformationHistory() const
 void ccMesh::addTriangle(unsigned i1, unsigned i2, unsigned i3)
 {
 	m_triVertIndexes->emplace_back(CCCoreLib::VerticesIndexes(i1, i2, i3));
+	invalidateVertexAdjacency();
 }
 
 bool ccMesh::reserve(size_t n)
@@ -1589,6 +1934,7 @@ bool ccMesh::resize(size_t n)
 {
 	m_bBox.setValidity(false);
 	notifyGeometryUpdate();
+	invalidateVertexAdjacency();
 
 	if (m_triMtlIndexes)
 	{
@@ -2580,6 +2926,8 @@ ccMesh* ccMesh::createNewMeshFromSelection(bool removeSelectedFaces)
 
 void ccMesh::shiftTriangleIndexes(unsigned shift)
 {
+	invalidateVertexAdjacency();
+
 	for (CCCoreLib::VerticesIndexes& ti : *m_triVertIndexes)
 	{
 		ti.i1 += shift;
@@ -3438,391 +3786,334 @@ bool ccMesh::getColorFromMaterial(unsigned triIndex, const CCVector3& P, ccColor
 	return true;
 }
 
-//we use as many static variables as we can to limit the size of the heap used by each recursion...
-static const unsigned s_defaultSubdivideGrowRate = 50;
-static PointCoordinateType s_maxSubdivideArea = 1;
-static QMap<qint64,unsigned> s_alreadyCreatedVertices; //map to store already created edges middle points
+//! Max number of subdivision passes (each pass divides the area of the largest triangles by 4)
+static const unsigned s_maxSubdivisionPasses = 32;
 
-static qint64 GenerateKey(unsigned edgeIndex1, unsigned edgeIndex2)
+ccMesh* ccMesh::subdivide(PointCoordinateType maxArea) const
 {
-	if (edgeIndex1 > edgeIndex2)
-		std::swap(edgeIndex1, edgeIndex2);
-
-	return (static_cast<qint64>(edgeIndex1) << 32) | static_cast<qint64>(edgeIndex2);
-}
+	if ( maxArea <= CCCoreLib::ZERO_TOLERANCE_POINT_COORDINATE )
+	{
+		ccLog::Error("[ccMesh::subdivide] Invalid input argument!");
+		return nullptr;
+	}
 
-bool ccMesh::pushSubdivide(/*PointCoordinateType maxArea, */unsigned indexA, unsigned indexB, unsigned indexC)
-{
-	if ( s_maxSubdivideArea <= CCCoreLib::ZERO_TOLERANCE_POINT_COORDINATE )
+	unsigned triCount = size();
+	ccGenericPointCloud* vertices = getAssociatedCloud();
+	unsigned vertCount = (vertices ? vertices->size() : 0);
+	if (!vertices || vertCount*triCount == 0)
 	{
-		ccLog::Error("[ccMesh::pushSubdivide] Invalid input argument!");
-		return false;
+		ccLog::Error("[ccMesh::subdivide] Invalid mesh: no face or no vertex!");
+		return nullptr;
 	}
 
-	if (!getAssociatedCloud() || !getAssociatedCloud()->isA(CC_TYPES::POINT_CLOUD))
+	ccPointCloud* resultVertices = vertices->isA(CC_TYPES::POINT_CLOUD) ? static_cast<ccPointCloud*>(vertices)->cloneThis() : ccPointCloud::From(vertices,vertices);
+	if (!resultVertices)
 	{
-		ccLog::Error("[ccMesh::pushSubdivide] Vertices set must be a true point cloud!");
-		return false;
+		ccLog::Error("[ccMesh::subdivide] Not enough memory!");
+		return nullptr;
 	}
-	ccPointCloud* vertices = static_cast<ccPointCloud*>(getAssociatedCloud());
-	assert(vertices);
-	const CCVector3* A = vertices->getPoint(indexA);
-	const CCVector3* B = vertices->getPoint(indexB);
-	const CCVector3* C = vertices->getPoint(indexC);
 
-	//do we need to sudivide this triangle?
-	PointCoordinateType area = ((*B - *A)*(*C - *A)).norm() / 2;
-	if (area > s_maxSubdivideArea/*maxArea*/)
+	ccMesh* resultMesh = new ccMesh(resultVertices);
+	resultMesh->addChild(resultVertices);
+
+	RGBAColorsTableType* colors = resultVertices->hasColors() ? resultVertices->rgbaColors() : nullptr;
+	NormsIndexesTableType* normals = resultVertices->hasNormals() ? resultVertices->normals() : nullptr;
+	const unsigned sfCount = resultVertices->getNumberOfScalarFields();
+
+	std::vector<CCCoreLib::VerticesIndexes> triangles;
+	std::vector<CCCoreLib::VerticesIndexes> newTriangles;
+	std::vector<unsigned> splitTriangles;
+	std::vector<unsigned char> tooLarge;
+	std::vector<KeyAndIndex> edges;
+	std::vector<size_t> bucketOffsets;
+	std::vector<unsigned> midIndexes;
+	std::vector<unsigned> outOffsets;
+
+	unsigned pass = 0;
+	try
 	{
-		//we will add 3 new vertices, so we must be sure to have enough memory
-		if (vertices->size() + 2 >= vertices->capacity())
+		triangles.assign(m_triVertIndexes->begin(), m_triVertIndexes->end());
+
+		for (; pass < s_maxSubdivisionPasses; ++pass)
 		{
-			assert(s_defaultSubdivideGrowRate > 2);
-			if (!vertices->reserve(vertices->size() + s_defaultSubdivideGrowRate))
+			const unsigned currentTriCount = static_cast<unsigned>(triangles.size());
+			const int triChunkCount = static_cast<int>((currentTriCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
+
+			//1) flag the triangles that are too large
+			tooLarge.resize(currentTriCount);
+			ccParallel::For(triChunkCount, [&](int c)
 			{
-				ccLog::Error("[ccMesh::pushSubdivide] Not enough memory!");
-				return false;
-			}
-			//We have to update pointers as they may have been wrangled by the 'reserve' call
-			A = vertices->getPoint(indexA);
-			B = vertices->getPoint(indexB);
-			C = vertices->getPoint(indexC);
-		}
+				unsigned end = std::min(currentTriCount, (c + 1) * s_parallelChunkSize);
+				for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
+				{
+					const CCCoreLib::VerticesIndexes& tri = triangles[i];
+					const CCVector3* A = resultVertices->getPoint(tri.i1);
+					const CCVector3* B = resultVertices->getPoint(tri.i2);
+					const CCVector3* C = resultVertices->getPoint(tri.i3);
+					PointCoordinateType area = (*B - *A).cross(*C - *A).norm() / 2;
+					tooLarge[i] = (area > maxArea ? 1 : 0);
+				}
+			});
 
-		//add new vertices
-		unsigned indexG1 = 0;
-		{
-			qint64 key = GenerateKey(indexA, indexB);
-			QMap<qint64, unsigned>::const_iterator it = s_alreadyCreatedVertices.constFind(key);
-			if (it == s_alreadyCreatedVertices.constEnd())
+			splitTriangles.clear();
+			for (unsigned i = 0; i < currentTriCount; ++i)
 			{
-				//generate new vertex
-				indexG1 = vertices->size();
-				CCVector3 G1 = (*A + *B) / 2;
-				vertices->addPoint(G1);
-				//interpolate other features?
-				//if (vertices->hasNormals())
-				//{
-				//	//vertices->reserveTheNormsTable();
-				//	CCVector3 N(0.0, 0.0, 1.0);
-				//	interpolateNormals(indexA, indexB, indexC, G1, N);
-				//	vertices->addNorm(N);
-				//}
-				if (vertices->hasColors())
+				if (tooLarge[i])
 				{
-					CCCoreLib::VerticesIndexes tri(indexA, indexB, indexC);
-					CCVector3d w1;
-					computeInterpolationWeights(tri, G1, w1);
-					ccColor::Rgba color;
-					interpolateColors(CCCoreLib::VerticesIndexes(indexA, indexB, indexC), w1, color);
-					vertices->addColor(color);
+					splitTriangles.push_back(i);
 				}
-				//and add it to the map
-				s_alreadyCreatedVertices.insert(key, indexG1);
 			}
-			else
+			if (splitTriangles.empty())
 			{
-				indexG1 = it.value();
+				//nothing left to subdivide
+				break;
 			}
-		}
-		unsigned indexG2 = 0;
-		{
-			qint64 key = GenerateKey(indexB, indexC);
-			QMap<qint64, unsigned>::const_iterator it = s_alreadyCreatedVertices.constFind(key);
-			if (it == s_alreadyCreatedVertices.constEnd())
+
+			//2) collect and sort the edges of these triangles (the same edge may appear twice)
+			const unsigned splitCount = static_cast<unsigned>(splitTriangles.size());
+			const int splitChunkCount = static_cast<int>((splitCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
+			edges.resize(static_cast<size_t>(splitCount) * 3);
+			ccParallel::For(splitChunkCount, [&](int c)
 			{
-				//generate new vertex
-				indexG2 = vertices->size();
-				CCVector3 G2 = (*B + *C) / 2;
-				vertices->addPoint(G2);
-				//interpolate other features?
-				//if (vertices->hasNormals())
-				//{
-				//	//vertices->reserveTheNormsTable();
-				//	CCVector3 N(0.0, 0.0, 1.0);
-				//	interpolateNormals(indexA, indexB, indexC, G2, N);
-				//	vertices->addNorm(N);
-				//}
-				if (vertices->hasColors())
+				unsigned end = std::min(splitCount, (c + 1) * s_parallelChunkSize);
+				for (unsigned k = c * s_parallelChunkSize; k < end; ++k)
 				{
-					CCCoreLib::VerticesIndexes tri(indexA, indexB, indexC);
-					CCVector3d w2;
-					computeInterpolationWeights(tri, G2, w2);
-					ccColor::Rgba colors;
-					interpolateColors(CCCoreLib::VerticesIndexes(indexA, indexB, indexC), w2, colors);
-					vertices->addColor(colors);
+					const CCCoreLib::VerticesIndexes& tri = triangles[splitTriangles[k]];
+					for (unsigned e = 0; e < 3; ++e)
+					{
+						KeyAndIndex& edge = edges[3 * static_cast<size_t>(k) + e];
+						edge.key = EdgeKey(tri.i[e], tri.i[(e + 1) % 3]);
+						edge.index = 3 * k + e;
+					}
 				}
-				//and add it to the map
-				s_alreadyCreatedVertices.insert(key, indexG2);
-			}
-			else
+			});
+
+			if (!SortKeys(edges, bucketOffsets))
 			{
-				indexG2 = it.value();
+				throw std::bad_alloc();
 			}
-		}
-		unsigned indexG3 = vertices->size();
-		{
-			qint64 key = GenerateKey(indexC, indexA);
-			QMap<qint64, unsigned>::const_iterator it = s_alreadyCreatedVertices.constFind(key);
-			if (it == s_alreadyCreatedVertices.constEnd())
+
+			//3) create one vertex in the middle of each edge
+			const int bucketCount = static_cast<int>(bucketOffsets.size() - 1);
+			std::vector<unsigned> bucketFirstVertex(bucketCount + 1, 0);
+			ccParallel::For(bucketCount, [&](int b)
 			{
-				//generate new vertex
-				indexG3 = vertices->size();
-				CCVector3 G3 = (*C + *A) / 2.0;
-				vertices->addPoint(G3);
-				//interpolate other features?
-				//if (vertices->hasNormals())
-				//{
-				//	//vertices->reserveTheNormsTable();
-				//	CCVector3 N(0.0, 0.0, 1.0);
-				//	interpolateNormals(indexA, indexB, indexC, G3, N);
-				//	vertices->addNorm(N);
-				//}
-				if (vertices->hasColors())
+				for (size_t pos = bucketOffsets[b]; pos < bucketOffsets[b + 1]; ++pos)
 				{
-					CCCoreLib::VerticesIndexes tri(indexA, indexB, indexC);
-					CCVector3d w3;
-					computeInterpolationWeights(tri, G3, w3);
-					ccColor::Rgba colors;
-					interpolateColors(CCCoreLib::VerticesIndexes(indexA, indexB, indexC), w3, colors);
-					vertices->addColor(colors);
+					//keys can't be shared by two buckets
+					if (pos == bucketOffsets[b] || edges[pos - 1].key != edges[pos].key)
+					{
+						++bucketFirstVertex[b + 1];
+					}
 				}
-				//and add it to the map
-				s_alreadyCreatedVertices.insert(key, indexG3);
-			}
-			else
+			});
+			bucketFirstVertex[0] = resultVertices->size();
+			for (int b = 0; b < bucketCount; ++b)
 			{
-				indexG3 = it.value();
+				bucketFirstVertex[b + 1] += bucketFirstVertex[b];
 			}
-		}
 
-		//add new triangles
-		if (!pushSubdivide(/*maxArea, */indexA, indexG1, indexG3))
-			return false;
-		if (!pushSubdivide(/*maxArea, */indexB, indexG2, indexG1))
-			return false;
-		if (!pushSubdivide(/*maxArea, */indexC, indexG3, indexG2))
-			return false;
-		if (!pushSubdivide(/*maxArea, */indexG1, indexG2, indexG3))
-			return false;
-	}
-	else
-	{
-		//we will add one triangle, so we must be sure to have enough memory
-		if (size() == capacity())
-		{
-			if (!reserve(size() + 3 * s_defaultSubdivideGrowRate))
+			if (!resultVertices->resize(bucketFirstVertex.back()))
 			{
-				ccLog::Error("[ccMesh::pushSubdivide] Not enough memory!");
-				return false;
+				throw std::bad_alloc();
 			}
-		}
+			midIndexes.resize(edges.size());
 
-		//we keep this triangle as is
-		addTriangle(indexA, indexB, indexC);
-	}
+			ccParallel::For(bucketCount, [&](int b)
+			{
+				unsigned nextIndex = bucketFirstVertex[b];
+				for (size_t pos = bucketOffsets[b]; pos < bucketOffsets[b + 1]; ++pos)
+				{
+					if (pos != bucketOffsets[b] && edges[pos - 1].key == edges[pos].key)
+					{
+						midIndexes[pos] = midIndexes[pos - 1];
+						continue;
+					}
 
-	return true;
-}
+					unsigned mid = nextIndex++;
+					midIndexes[pos] = mid;
 
-ccMesh* ccMesh::subdivide(PointCoordinateType maxArea) const
-{
-	if ( maxArea <= CCCoreLib::ZERO_TOLERANCE_POINT_COORDINATE )
-	{
-		ccLog::Error("[ccMesh::subdivide] Invalid input argument!");
-		return nullptr;
-	}
-	s_maxSubdivideArea = maxArea;
-
-	unsigned triCount = size();
-	ccGenericPointCloud* vertices = getAssociatedCloud();
-	unsigned vertCount = (vertices ? vertices->size() : 0);
-	if (!vertices || vertCount*triCount == 0)
-	{
-		ccLog::Error("[ccMesh::subdivide] Invalid mesh: no face or no vertex!");
-		return nullptr;
-	}
-
-	ccPointCloud* resultVertices = vertices->isA(CC_TYPES::POINT_CLOUD) ? static_cast<ccPointCloud*>(vertices)->cloneThis() : ccPointCloud::From(vertices,vertices);
-	if (!resultVertices)
-	{
-		ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-		return nullptr;
-	}
+					unsigned k = edges[pos].index / 3;
+					unsigned e = edges[pos].index % 3;
+					const CCCoreLib::VerticesIndexes& tri = triangles[splitTriangles[k]];
+					unsigned indexA = tri.i[e];
+					unsigned indexB = tri.i[(e + 1) % 3];
 
-	ccMesh* resultMesh = new ccMesh(resultVertices);
-	resultMesh->addChild(resultVertices);
-
-	if (!resultMesh->reserve(triCount))
-	{
-		ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-		delete resultMesh;
-		return nullptr;
-	}
-
-	s_alreadyCreatedVertices.clear();
-
-	try
-	{
-		for (unsigned i = 0; i < triCount; ++i)
-		{
-			const CCCoreLib::VerticesIndexes& tri = m_triVertIndexes->getValue(i);
-			if (!resultMesh->pushSubdivide(/*maxArea,*/tri.i1, tri.i2, tri.i3))
-			{
-				ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-				delete resultMesh;
-				return nullptr;
-			}
-		}
-	}
-	catch(...)
-	{
-		ccLog::Error("[ccMesh::subdivide] An error occurred!");
-		delete resultMesh;
-		return nullptr;
-	}
+					//this is a "persistent" pointer and we know what type of cloud is behind ;)
+					CCVector3* G = const_cast<CCVector3*>(resultVertices->getPointPersistentPtr(mid));
+					*G = (*resultVertices->getPoint(indexA) + *resultVertices->getPoint(indexB)) / 2;
 
-	//we must also 'fix' the triangles that share (at least) an edge with a subdivided triangle!
-	try
-	{
-		unsigned newTriCount = resultMesh->size();
-		for (unsigned i = 0; i < newTriCount; ++i)
-		{
-			CCCoreLib::VerticesIndexes& tri = resultMesh->m_triVertIndexes->getValue(i); //warning: array might change at each call to reallocate!
-			unsigned indexA = tri.i1;
-			unsigned indexB = tri.i2;
-			unsigned indexC = tri.i3;
+					if (colors)
+					{
+						const ccColor::Rgba& colA = colors->getValue(indexA);
+						const ccColor::Rgba& colB = colors->getValue(indexB);
+						colors->setValue(mid, ccColor::Rgba(static_cast<ColorCompType>((static_cast<int>(colA.r) + colB.r) / 2),
+															static_cast<ColorCompType>((static_cast<int>(colA.g) + colB.g) / 2),
+															static_cast<ColorCompType>((static_cast<int>(colA.b) + colB.b) / 2),
+															static_cast<ColorCompType>((static_cast<int>(colA.a) + colB.a) / 2)));
+					}
+					if (normals)
+					{
+						CCVector3 N = ccNormalVectors::GetNormal(normals->getValue(indexA)) + ccNormalVectors::GetNormal(normals->getValue(indexB));
+						N.normalize();
+						normals->setValue(mid, ccNormalVectors::GetNormIndex(N));
+					}
+					for (unsigned s = 0; s < sfCount; ++s)
+					{
+						CCCoreLib::ScalarField* sf = resultVertices->getScalarField(static_cast<int>(s));
+						sf->setValue(mid, (sf->getValue(indexA) + sf->getValue(indexB)) / 2);
+					}
+				}
+			});
 
-			//test all edges
-			int indexG1 = -1;
+			//4) replace all the triangles with (at least) one split edge
+			auto midIndex = [&](unsigned indexA, unsigned indexB) -> int
 			{
-				QMap<qint64, unsigned>::const_iterator it = s_alreadyCreatedVertices.constFind(GenerateKey(indexA, indexB));
-				if (it != s_alreadyCreatedVertices.constEnd())
-					indexG1 = (int)it.value();
-			}
-			int indexG2 = -1;
+				uint64_t key = EdgeKey(indexA, indexB);
+				size_t pos = FindKey(edges, bucketOffsets, key);
+				return (pos < edges.size() && edges[pos].key == key ? static_cast<int>(midIndexes[pos]) : -1);
+			};
+
+			outOffsets.resize(static_cast<size_t>(currentTriCount) + 1);
+			outOffsets[0] = 0;
+			ccParallel::For(triChunkCount, [&](int c)
 			{
-				QMap<qint64, unsigned>::const_iterator it = s_alreadyCreatedVertices.constFind(GenerateKey(indexB, indexC));
-				if (it != s_alreadyCreatedVertices.constEnd())
-					indexG2 = (int)it.value();
-			}
-			int indexG3 = -1;
+				unsigned end = std::min(currentTriCount, (c + 1) * s_parallelChunkSize);
+				for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
+				{
+					const CCCoreLib::VerticesIndexes& tri = triangles[i];
+					unsigned brokenEdges =	(midIndex(tri.i1, tri.i2) < 0 ? 0 : 1)
+										+	(midIndex(tri.i2, tri.i3) < 0 ? 0 : 1)
+										+	(midIndex(tri.i3, tri.i1) < 0 ? 0 : 1);
+					outOffsets[i + 1] = 1 + brokenEdges;
+				}
+			});
+			for (unsigned i = 0; i < currentTriCount; ++i)
 			{
-				QMap<qint64, unsigned>::const_iterator it = s_alreadyCreatedVertices.constFind(GenerateKey(indexC, indexA));
-				if (it != s_alreadyCreatedVertices.constEnd())
-					indexG3 = (int)it.value();
+				outOffsets[i + 1] += outOffsets[i];
 			}
 
-			//at least one edge is 'wrong'
-			unsigned brokenEdges =	(indexG1 < 0 ? 0:1)
-								+	(indexG2 < 0 ? 0:1)
-								+	(indexG3 < 0 ? 0:1);
-
-			if (brokenEdges == 1)
+			newTriangles.resize(outOffsets.back());
+			ccParallel::For(triChunkCount, [&](int c)
 			{
-				int indexG = indexG1;
-				unsigned char i1 = 2; //relative index facing the broken edge
-				if (indexG2 >= 0)
-				{
-					indexG = indexG2;
-					i1 = 0;
-				}
-				else if (indexG3 >= 0)
+				unsigned end = std::min(currentTriCount, (c + 1) * s_parallelChunkSize);
+				for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
 				{
-					indexG = indexG3;
-					i1 = 1;
-				}
-				assert(indexG >= 0);
-				assert(i1<3);
-
-				unsigned indexes[3] = { indexA, indexB, indexC };
+					const CCCoreLib::VerticesIndexes& tri = triangles[i];
+					const unsigned indexA = tri.i1;
+					const unsigned indexB = tri.i2;
+					const unsigned indexC = tri.i3;
+					const int indexG1 = midIndex(indexA, indexB);
+					const int indexG2 = midIndex(indexB, indexC);
+					const int indexG3 = midIndex(indexC, indexA);
+
+					CCCoreLib::VerticesIndexes* out = newTriangles.data() + outOffsets[i];
+					switch (outOffsets[i + 1] - outOffsets[i] - 1) //number of broken edges
+					{
+					case 0:
+					{
+						//we keep this triangle as is
+						out[0] = tri;
+					}
+					break;
 
-				//replace current triangle by one half
-				tri.i1 = indexes[i1];
-				tri.i2 = indexG;
-				tri.i3 = indexes[(i1 + 2) % 3];
-				//and add the other half (we can use pushSubdivide as the area should alredy be ok!)
-				if (!resultMesh->pushSubdivide(/*maxArea,*/indexes[i1], indexes[(i1 + 1) % 3], indexG))
-				{
-					ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-					delete resultMesh;
-					return nullptr;
-				}
-			}
-			else if (brokenEdges == 2)
-			{
-				if (indexG1 < 0) //broken edges: BC and CA
-				{
-					//replace current triangle by the 'pointy' part
-					tri.i1 = indexC;
-					tri.i2 = indexG3;
-					tri.i3 = indexG2;
-					//split the remaining 'trapezoid' in 2
-					if (!resultMesh->pushSubdivide(/*maxArea, */indexA, indexG2, indexG3) ||
-						!resultMesh->pushSubdivide(/*maxArea, */indexA, indexB, indexG2))
+					case 1:
 					{
-						ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-						delete resultMesh;
-						return nullptr;
+						int indexG = indexG1;
+						unsigned char i1 = 2; //relative index facing the broken edge
+						if (indexG2 >= 0)
+						{
+							indexG = indexG2;
+							i1 = 0;
+						}
+						else if (indexG3 >= 0)
+						{
+							indexG = indexG3;
+							i1 = 1;
+						}
+						assert(indexG >= 0);
+
+						unsigned indexes[3] = { indexA, indexB, indexC };
+						out[0] = CCCoreLib::VerticesIndexes(indexes[i1], indexG, indexes[(i1 + 2) % 3]);
+						out[1] = CCCoreLib::VerticesIndexes(indexes[i1], indexes[(i1 + 1) % 3], indexG);
 					}
-				}
-				else if (indexG2 < 0) //broken edges: AB and CA
-				{
-					//replace current triangle by the 'pointy' part
-					tri.i1 = indexA;
-					tri.i2 = indexG1;
-					tri.i3 = indexG3;
-					//split the remaining 'trapezoid' in 2
-					if (!resultMesh->pushSubdivide(/*maxArea, */indexB, indexG3, indexG1) ||
-						!resultMesh->pushSubdivide(/*maxArea, */indexB, indexC, indexG3))
+					break;
+
+					case 2:
 					{
-						ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-						delete resultMesh;
-						return nullptr;
+						if (indexG1 < 0) //broken edges: BC and CA
+						{
+							//the 'pointy' part
+							out[0] = CCCoreLib::VerticesIndexes(indexC, indexG3, indexG2);
+							//the remaining 'trapezoid' split in 2
+							out[1] = CCCoreLib::VerticesIndexes(indexA, indexG2, indexG3);
+							out[2] = CCCoreLib::VerticesIndexes(indexA, indexB, indexG2);
+						}
+						else if (indexG2 < 0) //broken edges: AB and CA
+						{
+							out[0] = CCCoreLib::VerticesIndexes(indexA, indexG1, indexG3);
+							out[1] = CCCoreLib::VerticesIndexes(indexB, indexG3, indexG1);
+							out[2] = CCCoreLib::VerticesIndexes(indexB, indexC, indexG3);
+						}
+						else /*if (indexG3 < 0)*/ //broken edges: AB and BC
+						{
+							out[0] = CCCoreLib::VerticesIndexes(indexB, indexG2, indexG1);
+							out[1] = CCCoreLib::VerticesIndexes(indexC, indexG1, indexG2);
+							out[2] = CCCoreLib::VerticesIndexes(indexC, indexA, indexG1);
+						}
 					}
-				}
-				else /*if (indexG3 < 0)*/ //broken edges: AB and BC
-				{
-					//replace current triangle by the 'pointy' part
-					tri.i1 = indexB;
-					tri.i2 = indexG2;
-					tri.i3 = indexG1;
-					//split the remaining 'trapezoid' in 2
-					if (!resultMesh->pushSubdivide(/*maxArea, */indexC, indexG1, indexG2) ||
-						!resultMesh->pushSubdivide(/*maxArea, */indexC, indexA, indexG1))
+					break;
+
+					case 3:
 					{
-						ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-						delete resultMesh;
-						return nullptr;
+						//standard subdivision (4 quarters)
+						out[0] = CCCoreLib::VerticesIndexes(indexA, indexG1, indexG3);
+						out[1] = CCCoreLib::VerticesIndexes(indexB, indexG2, indexG1);
+						out[2] = CCCoreLib::VerticesIndexes(indexC, indexG3, indexG2);
+						out[3] = CCCoreLib::VerticesIndexes(indexG1, indexG2, indexG3);
+					}
+					break;
+
+					default:
+						assert(false);
+						break;
 					}
 				}
-			}
-			else if (brokenEdges == 3) //works just as a standard subdivision in fact!
-			{
-				//replace current triangle by one quarter
-				tri.i1 = indexA;
-				tri.i2 = indexG1;
-				tri.i3 = indexG3;
-				//and add the other 3 quarters (we can use pushSubdivide as the area should alredy be ok!)
-				if (!resultMesh->pushSubdivide(/*maxArea, */indexB, indexG2, indexG1) ||
-					!resultMesh->pushSubdivide(/*maxArea, */indexC, indexG3, indexG2) ||
-					!resultMesh->pushSubdivide(/*maxArea, */indexG1, indexG2, indexG3))
-				{
-					ccLog::Error("[ccMesh::subdivide] Not enough memory!");
-					delete resultMesh;
-					return nullptr;
-				}
-			}
+			});
+
+			triangles.swap(newTriangles);
 		}
+
+		if (!resultMesh->resize(triangles.size()))
+		{
+			throw std::bad_alloc();
+		}
+		std::copy(triangles.begin(), triangles.end(), resultMesh->m_triVertIndexes->begin());
 	}
-	catch (...)
+	catch (const std::bad_alloc&)
 	{
-		ccLog::Error("[ccMesh::subdivide] An error occurred!");
+		ccLog::Error("[ccMesh::subdivide] Not enough memory!");
 		delete resultMesh;
 		return nullptr;
 	}
 
-	s_alreadyCreatedVertices.clear();
+	if (pass == s_maxSubdivisionPasses)
+	{
+		ccLog::Warning("[ccMesh::subdivide] Max number of passes reached: some triangles may still be too large");
+	}
+
+	if (colors)
+	{
+		resultVertices->colorsHaveChanged();
+	}
+	if (normals)
+	{
+		resultVertices->normalsHaveChanged();
+	}
+	for (unsigned s = 0; s < sfCount; ++s)
+	{
+		resultVertices->getScalarField(static_cast<int>(s))->computeMinAndMax();
+	}
 
 	resultMesh->shrinkToFit();
 	resultVertices->shrinkToFit();
@@ -3885,237 +4176,492 @@ bool ccMesh::convertMaterialsToVertexColors()
 	return true;
 }
 
-static bool TagDuplicatedVertices(	const CCCoreLib::DgmOctree::octreeCell& cell,
-									void** additionalParameters,
-									CCCoreLib::NormalizedProgress* nProgress/*=0*/)
+bool ccMesh::weldVertices(	const WeldingParameters& params,
+							WeldingStats* stats/*=nullptr*/,
+							CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
 {
-	std::vector<int>* equivalentIndexes = static_cast<std::vector<int>*>(additionalParameters[0]);
+	if (stats)
+	{
+		*stats = WeldingStats();
+	}
 
-	//we look for points very close to the others (only if not yet tagged!)
+	if (!m_associatedCloud)
+	{
+		assert(false);
+		return false;
+	}
 
-	//structure for nearest neighbors search
-	CCCoreLib::DgmOctree::NearestNeighboursSphericalSearchStruct nNSS;
-	nNSS.level = cell.level;
-	static const PointCoordinateType c_defaultSearchRadius = static_cast<PointCoordinateType>(sqrt(CCCoreLib::ZERO_TOLERANCE_F));
-	cell.parentOctree->getCellPos(cell.truncatedCode, cell.level, nNSS.cellPos, true);
-	cell.parentOctree->computeCellCenter(nNSS.cellPos, cell.level, nNSS.cellCenter);
+	const unsigned vertCount = m_associatedCloud->size();
+	const unsigned faceCount = size();
+	if (vertCount == 0 || faceCount == 0)
+	{
+		ccLog::Warning("[ccMesh::weldVertices] No triangle or no vertex");
+		return false;
+	}
+	if (params.epsilon < 0)
+	{
+		ccLog::Warning("[ccMesh::weldVertices] Invalid tolerance");
+		return false;
+	}
 
-	unsigned n = cell.points->size(); //number of points in the current cell
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Weld vertices");
+			progressCb->setInfo(qPrintable(QString("Vertices: %1\nTriangles: %2").arg(vertCount).arg(faceCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+	//stops the progress callback whatever the outcome
+	struct ProgressStopper
+	{
+		CCCoreLib::GenericProgressCallback* cb;
+		~ProgressStopper() { if (cb) cb->stop(); }
+	} progressStopper{ progressCb };
+
+	auto progressStep = [progressCb](float percent) -> bool
+	{
+		if (!progressCb)
+			return true;
+		progressCb->update(percent);
+		return !progressCb->isCancelRequested();
+	};
+
+	ccGenericPointCloud* vertices = m_associatedCloud;
+	const bool exactDuplicates = (params.epsilon == 0);
+	//with cells 4 times larger than the tolerance, only a few vertices need to look at the neighbor cells
+	const double cellSize = 4.0 * params.epsilon;
+	const double squareEpsilon = params.epsilon * params.epsilon;
+	const int vertChunkCount = static_cast<int>((vertCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
 
-	//we already know some of the neighbours: the points in the current cell!
+	std::vector<unsigned> vertexMap;
+	std::vector<KeyAndIndex> entries;
+	std::vector<size_t> bucketOffsets;
 	try
 	{
-		nNSS.pointsInNeighbourhood.resize(n);
+		vertexMap.resize(vertCount);
+		entries.resize(vertCount);
 	}
-	catch (.../*const std::bad_alloc&*/) //out of memory
+	catch (const std::bad_alloc&)
 	{
+		ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
 		return false;
 	}
 
-	//init structure with cell points
+	//1) spatial hashing of the vertices
+	auto cellOf = [cellSize](const CCVector3& P, int64_t cell[3], double frac[3])
+	{
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			double f = P.u[d] / cellSize;
+			double fl = std::floor(f);
+			cell[d] = static_cast<int64_t>(fl);
+			frac[d] = f - fl;
+		}
+	};
+
+	ccParallel::For(vertChunkCount, [&](int c)
 	{
-		CCCoreLib::DgmOctree::NeighboursSet::iterator it = nNSS.pointsInNeighbourhood.begin();
-		for (unsigned i = 0; i < n; ++i, ++it)
+		unsigned end = std::min(vertCount, (c + 1) * s_parallelChunkSize);
+		for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
 		{
-			it->point = cell.points->getPointPersistentPtr(i);
-			it->pointIndex = cell.points->getPointGlobalIndex(i);
+			const CCVector3* P = vertices->getPoint(i);
+			if (exactDuplicates)
+			{
+				entries[i].key = HashCoordinates(*P);
+			}
+			else
+			{
+				int64_t cell[3];
+				double frac[3];
+				cellOf(*P, cell, frac);
+				entries[i].key = Hash3(cell[0], cell[1], cell[2]);
+			}
+			entries[i].index = i;
 		}
-		nNSS.alreadyVisitedNeighbourhoodSize = 1;
+	});
+
+	if (!SortKeys(entries, bucketOffsets))
+	{
+		ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
+		return false;
+	}
+	if (!progressStep(25.0f))
+	{
+		return false;
 	}
 
-	//for each point in the cell
-	for (unsigned i = 0; i < n; ++i)
+	//2) each vertex is attached to the vertex with the smallest index closer than the tolerance
+	ccParallel::For(vertChunkCount, [&](int c)
 	{
-		int thisIndex = static_cast<int>(cell.points->getPointGlobalIndex(i));
-		if (equivalentIndexes->at(thisIndex) < 0) //has no equivalent yet 
+		unsigned end = std::min(vertCount, (c + 1) * s_parallelChunkSize);
+		for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
 		{
-			cell.points->getPoint(i, nNSS.queryPoint);
+			const CCVector3* P = vertices->getPoint(i);
+			unsigned best = i;
 
-			//look for neighbors in a (very small) sphere
-			//warning: there may be more points at the end of nNSS.pointsInNeighbourhood than the actual nearest neighbors (k)!
-			unsigned k = cell.parentOctree->findNeighborsInASphereStartingFromCell(nNSS, c_defaultSearchRadius, false);
+			//the entries are sorted by index for a given key, so we can stop as soon as we reach 'best'
+			auto lookInCell = [&](uint64_t key)
+			{
+				for (size_t pos = FindKey(entries, bucketOffsets, key); pos < entries.size() && entries[pos].key == key; ++pos)
+				{
+					unsigned j = entries[pos].index;
+					if (j >= best)
+					{
+						break;
+					}
+					const CCVector3* Q = vertices->getPoint(j);
+					if (exactDuplicates ? (*P == *Q) : ((*P - *Q).norm2d() <= squareEpsilon))
+					{
+						best = j;
+						break;
+					}
+				}
+			};
 
-			//if there are some very close points
-			if (k > 1)
+			if (exactDuplicates)
+			{
+				lookInCell(HashCoordinates(*P));
+			}
+			else
 			{
-				for (unsigned j = 0; j < k; ++j)
+				int64_t cell[3];
+				double frac[3];
+				cellOf(*P, cell, frac);
+
+				//neighbor cells (only if the vertex is close enough to the border)
+				int minOffset[3];
+				int maxOffset[3];
+				for (unsigned d = 0; d < 3; ++d)
 				{
-					//all the other points are equivalent to the query point
-					const unsigned& otherIndex = nNSS.pointsInNeighbourhood[j].pointIndex;
-					if (static_cast<int>(otherIndex) != thisIndex)
-						equivalentIndexes->at(otherIndex) = thisIndex;
+					minOffset[d] = (frac[d] <= 0.25 ? -1 : 0);
+					maxOffset[d] = (frac[d] >= 0.75 ? 1 : 0);
 				}
+				for (int dx = minOffset[0]; dx <= maxOffset[0]; ++dx)
+					for (int dy = minOffset[1]; dy <= maxOffset[1]; ++dy)
+						for (int dz = minOffset[2]; dz <= maxOffset[2]; ++dz)
+							lookInCell(Hash3(cell[0] + dx, cell[1] + dy, cell[2] + dz));
 			}
 
-			//and the query point is always root
-			equivalentIndexes->at(thisIndex) = thisIndex;
+			vertexMap[i] = best;
 		}
+	});
 
-		if (nProgress && !nProgress->oneStep())
-		{
-			return false;
-		}
-	}
+	//no need to keep the vertices keys anymore
+	entries.clear();
+	entries.shrink_to_fit();
 
-	return true;
-}
-
-bool ccMesh::mergeDuplicatedVertices(unsigned char octreeLevel/*=10*/, QWidget* parentWidget/*=nullptr*/)
-{
-	if (!m_associatedCloud)
+	if (!progressStep(50.0f))
 	{
-		assert(false);
 		return false;
 	}
 
-	unsigned vertCount = m_associatedCloud->size();
-	unsigned faceCount = size();
-	if (vertCount == 0 || faceCount == 0)
+	//3) new vertex indexes (the 'best' vertex always has a smaller index than the current one)
+	unsigned remainingVertCount = 0;
+	for (unsigned i = 0; i < vertCount; ++i)
 	{
-		ccLog::Warning("[ccMesh::mergeDuplicatedVertices] No triangle or no vertex");
-		return false;
+		unsigned rootIndex = vertexMap[i];
+		vertexMap[i] = (rootIndex == i ? remainingVertCount++ : vertexMap[rootIndex]);
 	}
 
+	//4) flag the triangles to be removed (degenerate or duplicate)
+	std::vector<bool> removed;
 	try
 	{
-		std::vector<int> equivalentIndexes;
-		const int razValue = -1;
-		equivalentIndexes.resize(vertCount, razValue);
+		removed.resize(faceCount, false);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
+		return false;
+	}
 
-		// tag the duplicated vertices
+	unsigned degenerateCount = 0;
+	if (params.removeDegenerateTriangles)
+	{
+		//std::vector<bool> can't be written concurrently
+		for (unsigned i = 0; i < faceCount; ++i)
 		{
-			QScopedPointer<ccProgressDialog> pDlg(nullptr);
-			if (parentWidget)
+			const CCCoreLib::VerticesIndexes& tri = m_triVertIndexes->at(i);
+			unsigned a = vertexMap[tri.i1];
+			unsigned b = vertexMap[tri.i2];
+			unsigned c = vertexMap[tri.i3];
+			if (a == b || b == c || a == c)
 			{
-				pDlg.reset(new ccProgressDialog(true, parentWidget));
+				removed[i] = true;
+				++degenerateCount;
 			}
+		}
+	}
+
+	unsigned duplicateCount = 0;
+	if (params.removeDuplicateTriangles)
+	{
+		const int faceChunkCount = static_cast<int>((faceCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
+		std::vector<unsigned char> duplicate;
+		try
+		{
+			entries.resize(faceCount);
+			duplicate.resize(faceCount, 0);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
+			return false;
+		}
 
-			// try to build the octree
-			ccOctree::Shared octree = ccOctree::Shared(new ccOctree(m_associatedCloud));
-			if (!octree->build(pDlg.data()))
+		ccParallel::For(faceChunkCount, [&](int c)
+		{
+			unsigned end = std::min(faceCount, (c + 1) * s_parallelChunkSize);
+			for (unsigned i = c * s_parallelChunkSize; i < end; ++i)
 			{
-				ccLog::Warning("[MergeDuplicatedVertices] Not enough memory");
-				return false;
+				unsigned s[3];
+				SortedTriangle(m_triVertIndexes->at(i), vertexMap, s);
+				entries[i].key = Hash3(s[0], s[1], s[2]);
+				entries[i].index = i;
 			}
+		});
 
-			void* additionalParameters[] = { static_cast<void*>(&equivalentIndexes) };
-			unsigned result = octree->executeFunctionForAllCellsAtLevel(10,
-				TagDuplicatedVertices,
-				additionalParameters,
-				false,
-				pDlg.data(),
-				"Tag duplicated vertices");
+		if (!SortKeys(entries, bucketOffsets))
+		{
+			ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
+			return false;
+		}
 
-			if (result == 0)
+		//the duplicate triangles are now contiguous (the first one is kept)
+		ccParallel::For(static_cast<int>(bucketOffsets.size() - 1), [&](int b)
+		{
+			for (size_t pos = bucketOffsets[b]; pos < bucketOffsets[b + 1]; ++pos)
 			{
-				ccLog::Warning("[MergeDuplicatedVertices] Duplicated vertices removal algorithm failed?!");
-				return false;
+				unsigned i = entries[pos].index;
+				unsigned si[3];
+				SortedTriangle(m_triVertIndexes->at(i), vertexMap, si);
+
+				//compare with the previous triangles with the same key (hash collisions are very unlikely)
+				for (size_t prev = pos; prev > bucketOffsets[b] && entries[prev - 1].key == entries[pos].key; --prev)
+				{
+					unsigned j = entries[prev - 1].index;
+					unsigned sj[3];
+					SortedTriangle(m_triVertIndexes->at(j), vertexMap, sj);
+					if (si[0] == sj[0] && si[1] == sj[1] && si[2] == sj[2])
+					{
+						duplicate[i] = 1;
+						break;
+					}
+				}
 			}
-		}
+		});
 
-		unsigned remainingCount = 0;
-		for (unsigned i = 0; i < vertCount; ++i)
+		entries.clear();
+		entries.shrink_to_fit();
+
+		for (unsigned i = 0; i < faceCount; ++i)
 		{
-			int eqIndex = equivalentIndexes[i];
-			assert(eqIndex >= 0);
-			if (eqIndex == static_cast<int>(i)) //root point
+			if (duplicate[i] && !removed[i])
 			{
-				// we replace the root index by its 'new' index (+ vertCount, to differentiate it later)
-				int newIndex = static_cast<int>(vertCount + remainingCount);
-				equivalentIndexes[i] = newIndex;
-				++remainingCount;
+				removed[i] = true;
+				++duplicateCount;
 			}
 		}
+	}
+
+	if (!progressStep(75.0f))
+	{
+		return false;
+	}
 
-		CCCoreLib::ReferenceCloud newVerticesRef(m_associatedCloud);
-		if (!newVerticesRef.reserve(remainingCount))
+	const unsigned remainingFaceCount = faceCount - degenerateCount - duplicateCount;
+	if (remainingFaceCount == 0)
+	{
+		ccLog::Warning("[ccMesh::weldVertices] After vertex fusion, all triangles would collapse! We'll keep the non-fused version...");
+		return false;
+	}
+
+	//5) new vertices
+	if (remainingVertCount < vertCount)
+	{
+		CCCoreLib::ReferenceCloud newVerticesRef(vertices);
+		if (!newVerticesRef.reserve(remainingVertCount))
 		{
-			ccLog::Warning("[MergeDuplicatedVertices] Not enough memory");
+			ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
 			return false;
 		}
-
-		//copy root points in a new cloud
+		for (unsigned i = 0, next = 0; i < vertCount; ++i)
 		{
-			for (unsigned i = 0; i < vertCount; ++i)
+			if (vertexMap[i] == next) //first vertex of its group
 			{
-				int eqIndex = equivalentIndexes[i];
-				if (eqIndex >= static_cast<int>(vertCount)) //root point
-					newVerticesRef.addPointIndex(i);
-				else
-					equivalentIndexes[i] = equivalentIndexes[eqIndex]; //and update the other indexes
+				newVerticesRef.addPointIndex(i);
+				++next;
 			}
 		}
+		assert(newVerticesRef.size() == remainingVertCount);
 
 		ccPointCloud* newVertices = nullptr;
-		if (m_associatedCloud->isKindOf(CC_TYPES::POINT_CLOUD))
+		if (vertices->isKindOf(CC_TYPES::POINT_CLOUD))
 		{
-			newVertices = static_cast<ccPointCloud*>(m_associatedCloud)->partialClone(&newVerticesRef);
+			newVertices = static_cast<ccPointCloud*>(vertices)->partialClone(&newVerticesRef);
 		}
 		else
 		{
-			newVertices = ccPointCloud::From(&newVerticesRef, m_associatedCloud);
+			newVertices = ccPointCloud::From(&newVerticesRef, vertices);
 		}
 		if (!newVertices)
 		{
-			ccLog::Warning("[MergeDuplicatedVertices] Not enough memory");
+			ccLog::Warning("[ccMesh::weldVertices] Not enough memory");
 			return false;
 		}
 
-		//update face indexes
-		{
-			unsigned newFaceCount = 0;
-			for (unsigned i = 0; i < faceCount; ++i)
-			{
-				CCCoreLib::VerticesIndexes* tri = getTriangleVertIndexes(i);
-				tri->i1 = static_cast<unsigned>(equivalentIndexes[tri->i1]) - vertCount;
-				tri->i2 = static_cast<unsigned>(equivalentIndexes[tri->i2]) - vertCount;
-				tri->i3 = static_cast<unsigned>(equivalentIndexes[tri->i3]) - vertCount;
-
-				//very small triangles (or flat ones) may be implicitly removed by vertex fusion!
-				if (tri->i1 != tri->i2 && tri->i1 != tri->i3 && tri->i2 != tri->i3)
-				{
-					if (newFaceCount != i)
-						swapTriangles(i, newFaceCount);
-					++newFaceCount;
-				}
-			}
+		newVertices->setName(vertices->getName());
+		newVertices->setEnabled(vertices->isEnabled());
+		newVertices->setVisible(vertices->isVisible());
+		newVertices->setLocked(vertices->isLocked());
 
-			if (newFaceCount == 0)
-			{
-				ccLog::Warning("[MergeDuplicatedVertices] After vertex fusion, all triangles would collapse! We'll keep the non-fused version...");
-				delete newVertices;
-				newVertices = nullptr;
-			}
-			else
-			{
-				resize(newFaceCount);
-			}
-		}
-
-		// update the mesh vertices
-		int childPos = getChildIndex(m_associatedCloud);
+		//update the mesh vertices
+		int childPos = getChildIndex(vertices);
 		if (childPos >= 0)
 		{
 			removeChild(childPos);
 		}
 		else
 		{
-			delete m_associatedCloud;
-			m_associatedCloud = nullptr;
+			delete vertices;
 		}
+		m_associatedCloud = nullptr;
 		setAssociatedCloud(newVertices);
 		if (childPos >= 0)
 		{
 			addChild(m_associatedCloud);
 		}
-		vertCount = (m_associatedCloud ? m_associatedCloud->size() : 0);
-		ccLog::Print("[MergeDuplicatedVertices] Remaining vertices after auto-removal of duplicate ones: %i", vertCount);
-		ccLog::Print("[MergeDuplicatedVertices] Remaining faces after auto-removal of duplicate ones: %i", size());
 	}
-	catch (const std::bad_alloc&)
+
+	//6) remap and compact the triangles (and their per-triangle features) in a single pass
+	std::vector<unsigned> faceMap;
+	bool hasSubMeshes = false;
+	for (ccHObject* child : m_children)
+	{
+		if (child->isA(CC_TYPES::SUB_MESH))
+		{
+			hasSubMeshes = true;
+			break;
+		}
+	}
+	if (hasSubMeshes)
+	{
+		try
+		{
+			faceMap.resize(faceCount, static_cast<unsigned>(-1));
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccMesh::weldVertices] Not enough memory to update the sub-meshes");
+			hasSubMeshes = false;
+		}
+	}
+
+	unsigned newFaceCount = 0;
+	for (unsigned i = 0; i < faceCount; ++i)
+	{
+		if (removed[i])
+		{
+			continue;
+		}
+
+		CCCoreLib::VerticesIndexes tri = m_triVertIndexes->at(i);
+		CCCoreLib::VerticesIndexes& newTri = m_triVertIndexes->at(newFaceCount);
+		newTri.i1 = vertexMap[tri.i1];
+		newTri.i2 = vertexMap[tri.i2];
+		newTri.i3 = vertexMap[tri.i3];
+
+		if (newFaceCount != i)
+		{
+			if (m_triMtlIndexes)
+				m_triMtlIndexes->at(newFaceCount) = m_triMtlIndexes->at(i);
+			if (m_texCoordIndexes)
+				m_texCoordIndexes->at(newFaceCount) = m_texCoordIndexes->at(i);
+			if (m_triNormalIndexes)
+				m_triNormalIndexes->at(newFaceCount) = m_triNormalIndexes->at(i);
+		}
+
+		if (hasSubMeshes)
+		{
+			faceMap[i] = newFaceCount;
+		}
+		++newFaceCount;
+	}
+	assert(newFaceCount == remainingFaceCount);
+	resize(newFaceCount);
+
+	if (hasSubMeshes)
 	{
-		ccLog::Warning("[MergeDuplicatedVertices] Not enough memory: could not remove duplicated vertices!");
+		for (ccHObject* child : m_children)
+		{
+			if (!child->isA(CC_TYPES::SUB_MESH))
+				continue;
+
+			ccSubMesh* subMesh = static_cast<ccSubMesh*>(child);
+			std::vector<unsigned> subIndexes;
+			subIndexes.reserve(subMesh->size());
+			for (unsigned j = 0; j < subMesh->size(); ++j)
+			{
+				unsigned newIndex = faceMap[subMesh->getTriGlobalIndex(j)];
+				if (newIndex != static_cast<unsigned>(-1))
+					subIndexes.push_back(newIndex);
+			}
+			subMesh->clear(false);
+			for (unsigned index : subIndexes)
+			{
+				subMesh->addTriangleIndex(index);
+			}
+			subMesh->refreshBB();
+		}
+	}
+
+	notifyGeometryUpdate();
+
+	if (progressCb)
+	{
+		progressCb->update(100.0f);
+	}
+
+	if (stats)
+	{
+		stats->mergedVertexCount = vertCount - remainingVertCount;
+		stats->degenerateTriangleCount = degenerateCount;
+		stats->duplicateTriangleCount = duplicateCount;
+	}
+
+	ccLog::Print(QString("[ccMesh::weldVertices] %1 vertices merged (%2 remaining), %3 degenerate and %4 duplicate triangles removed (%5 remaining)")
+				 .arg(vertCount - remainingVertCount).arg(remainingVertCount).arg(degenerateCount).arg(duplicateCount).arg(newFaceCount));
+
+	return true;
+}
+
+bool ccMesh::mergeDuplicatedVertices(unsigned char octreeLevel/*=10*/, QWidget* parentWidget/*=nullptr*/)
+{
+	Q_UNUSED(octreeLevel);
+
+	QScopedPointer<ccProgressDialog> pDlg(nullptr);
+	if (parentWidget)
+	{
+		pDlg.reset(new ccProgressDialog(true, parentWidget));
+	}
+
+	WeldingParameters params;
+	params.epsilon = DefaultWeldingTolerance();
+	params.removeDuplicateTriangles = false;
+
+	if (!weldVertices(params, nullptr, pDlg.data()))
+	{
+		//we only fail if the mesh is invalid
+		return m_associatedCloud && size() != 0;
 	}
 
 	return true;
 }
+
+double ccMesh::DefaultWeldingTolerance()
+{
+	return sqrt(CCCoreLib::ZERO_TOLERANCE_F);
+}
@@ -23,401 +23,101 @@
 //local
 #include "ccLog.h"
 #include "ccOctree.h"
+#include "ccParallelFor.h"
 #include "ccPointCloud.h"
 #include "ccProgressDialog.h"
-#include "ccScalarField.h"
 
 //system
-#include <map>
-#include <queue>
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <vector>
 
 namespace 
 {
-	//! Weighted graph edge
-	class Edge
+	//! Invalid vertex index (empty neighbor slot)
+	static const uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+	//! kNN graph in compressed (CSR) form
+	/** All the vertices have the same number of neighbor slots (kNN) so that
+		the offset of vertex i is simply i * kNN. Empty slots are marked with
+		InvalidIndex. The graph is not symmetric (edge (i,j) may only appear
+		in the row of i) but this doesn't matter for the spanning forest.
+	**/
+	struct KNNGraph
 	{
-	public:
-		
-		//! Unique edge key type
-		using Key = std::pair<unsigned, unsigned>;
-		
-		//! Returns the unique key of an edge (no vertex order)
-		inline static Key ConstructKey(unsigned v1, unsigned v2)
-		{
-			return v1 > v2 ? std::make_pair(v2, v1) : std::make_pair(v1, v2);
-		}
-		
-		//! Default constructor
-		Edge(unsigned v1, unsigned v2, float weight)
-			: m_key(ConstructKey(v1, v2))
-			, m_weight(weight)
-		{
-			assert(m_weight >= 0);
-		}
-		
-		//! Strict weak ordering operator (required by std::priority_queue)
-		inline bool operator < (const Edge& other) const
-		{
-			return m_weight > other.m_weight;
-		}
-		
-		//! Returns first vertex (index)
-		const unsigned& v1() const { return m_key.first; }
-		//! Returns second vertex (index)
-		const unsigned& v2() const { return m_key.second; }
-		
-	protected:
-		
-		//! Unique key
-		Key m_key;
-		
-		//! Associated weight
-		float m_weight;
+		//! Number of neighbor slots per vertex
+		unsigned k = 0;
+		//! Neighbor indexes (vertexCount * k)
+		std::vector<uint32_t> neighbors;
+		//! Edge weights (vertexCount * k)
+		std::vector<float> weights;
 	};
-	
-	//! Generic graph structure
-	class Graph
+
+	//! Atomically replaces 'target' by 'value' if the latter is smaller
+	inline void AtomicMin(std::atomic<uint64_t>& target, uint64_t value)
 	{
-	public:
-		
-		//! Default constructor
-		Graph() = default;
-		
-		//! Set of indexes
-		using IndexSet = std::set<unsigned int>;
-		
-		//! Reserves memory for graph
-		/** Must be called before using the structure!
-		Clears the structure as well.
-	**/
-		bool reserve(unsigned vertexCount)
-		{
-			m_edges.clear();
-			
-			try
-			{
-				m_vertexNeighbors.resize(vertexCount, IndexSet());
-			}
-			catch (const std::bad_alloc&)
-			{
-				//not enough memory
-				return false;
-			}
-			
-			return true;
-		}
-		
-		//! Returns the number of vertices
-		unsigned vertexCount() const { return static_cast<unsigned>(m_vertexNeighbors.size()); } //the m_vertexNeighbors vector size shouldn't be bigger than a 32 bits integer (see 'reserve')
-		
-		//! Returns the number of edges
-		size_t edgeCount() const { return m_edges.size(); }
-		
-		//! Returns the weight associated to an edge (if it exists - returns -1 otherwise)
-		float weight(unsigned v1, unsigned v2) const
-		{
-			assert(v1 < m_vertexNeighbors.size() && v2 < m_vertexNeighbors.size());
-			
-			// try to find the corresponding edge (otherwise return -1)
-			std::map<Edge::Key, float>::const_iterator it = m_edges.find(Edge::ConstructKey(v1, v2));
-			
-			return (it == m_edges.end() ? -1 : it->second);
-		}
-		
-		//! Adds or updates the edge (v1,v2)
-		void addEdge(unsigned v1, unsigned v2, float weight = 0.0f)
-		{
-			assert(v1 < m_vertexNeighbors.size() && v2 < m_vertexNeighbors.size());
-			
-			m_edges.insert(std::make_pair(Edge::ConstructKey(v1, v2), weight));
-			m_vertexNeighbors[v1].insert(v2);
-			m_vertexNeighbors[v2].insert(v1);
-		}
-		
-		//! Returns the set of edges connected to a given vertex
-		inline const IndexSet& getVertexNeighbors(unsigned index) const
+		uint64_t current = target.load(std::memory_order_relaxed);
+		while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
 		{
-			return m_vertexNeighbors[index];
 		}
-		
-	protected:
-		
-		//! Graph edges
-		std::map<Edge::Key, float> m_edges;
-		
-		//! Set of neighbors for each vertex
-		std::vector<IndexSet> m_vertexNeighbors;
-	};
-}
-
-static bool ResolveNormalsWithMST(	ccPointCloud* cloud,
-#ifdef WITH_GRAPH
-									const Graph& graph,
-#else
-									ccOctree::Shared& octree,
-									unsigned char level,
-									unsigned kNN,
-#endif
-									ccProgressDialog* progressCb = nullptr)
-{
-	assert(cloud && cloud->hasNormals());
-
-//#define COLOR_PATCHES
-#ifdef COLOR_PATCHES
-	//Test: color patches
-	cloud->setColor(ccColor::white);
-	cloud->showColors(true);
-
-	//Test: arrival time
-	int sfIdx = cloud->getScalarFieldIndexByName("MST arrival time");
-	if (sfIdx < 0)
-		sfIdx = cloud->addScalarField("MST arrival time");
-	ccScalarField* sf = static_cast<ccScalarField*>(cloud->getScalarField(sfIdx));
-	sf->fill(NAN_VALUE);
-	cloud->setCurrentDisplayedScalarField(sfIdx);
-#endif
-
-	//reset
-	std::priority_queue<Edge> priorityQueue;
-	std::vector<bool> visited;
-	unsigned visitedCount = 0;
-#ifdef WITH_GRAPH
-	unsigned vertexCount = graph.vertexCount();
-#else
-	unsigned vertexCount = cloud->size();
-#endif
+	}
 
-	//instantiate the 'visited' table
-	try
+	//! Returns a (unique) sortable key for an edge
+	/** The weight is always positive, so its binary representation can be compared as an integer.
+		The edge index is used to break ties (required by Boruvka's algorithm to avoid cycles).
+	**/
+	inline uint64_t EdgeKey(float weight, uint32_t edgeIndex)
 	{
-		visited.resize(vertexCount, false);
-
-		//progress notification
-		CCCoreLib::NormalizedProgress nProgress(progressCb, vertexCount);
-		if (progressCb)
-		{
-			progressCb->update(0);
-			progressCb->setMethodTitle(QObject::tr("Orient normals (MST)"));
-#ifdef WITH_GRAPH
-			progressCb->setInfo(QObject::tr("Compute Minimum spanning tree\nPoints: %1\nEdges: %2").arg(vertexCount).arg(graph.edgeCount()));
-#else
-			progressCb->setInfo(QObject::tr("Compute Minimum spanning tree\nPoints: %1").arg(vertexCount));
-#endif
-			progressCb->start();
-		}
+		uint32_t weightBits = 0;
+		std::memcpy(&weightBits, &weight, sizeof(float));
+		return (static_cast<uint64_t>(weightBits) << 32) | edgeIndex;
+	}
 
-#ifndef WITH_GRAPH
-		CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
-		nNSS.level = level;
-		nNSS.minNumberOfNeighbors = kNN + 1; //+1 because we'll get the query point itself!
-#endif
+	//! Number of vertices processed by each parallel task
+	static const unsigned ParallelChunkSize = 4096;
 
-		//while unvisited vertices remain...
-		unsigned firstUnvisitedIndex = 0;
-		size_t patchCount = 0;
-		size_t inversionCount = 0;
-		while (visitedCount < vertexCount)
+	//! Runs a function for all indexes in [0, count[ (in parallel if possible)
+	/** ccParallel::For only handles 'int' counts: the indexes are processed by chunks
+		so that clouds with more than 2^31 points can be handled.
+	**/
+	template <class Func> void ParallelForIndexes(size_t count, const Func& func)
+	{
+		const int chunkCount = static_cast<int>((count + ParallelChunkSize - 1) / ParallelChunkSize);
+		ccParallel::For(chunkCount, [&](int c)
 		{
-			//find the first not-yet-visited vertex
-			while (visited[firstUnvisitedIndex])
+			size_t begin = static_cast<size_t>(c) * ParallelChunkSize;
+			size_t end = std::min(count, begin + ParallelChunkSize);
+			for (size_t i = begin; i < end; ++i)
 			{
-				++firstUnvisitedIndex;
+				func(i);
 			}
+		});
+	}
 
-			//set it as "visited"
-			{
-				visited[firstUnvisitedIndex] = true;
-				++visitedCount;
-				//add its neighbors to the priority queue
-#ifdef WITH_GRAPH
-				const Graph::IndexSet& neighbors = graph.getVertexNeighbors(firstUnvisitedIndex);
-				for (Graph::IndexSet::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
-				{
-					priorityQueue.push(Edge(firstUnvisitedIndex, *it, graph.weight(firstUnvisitedIndex, *it)));
-				}
-#else
-				const CCVector3* P = cloud->getPoint(firstUnvisitedIndex);
-				nNSS.queryPoint = *P;
-				octree->getTheCellPosWhichIncludesThePoint(P, nNSS.cellPos, level);
-				octree->computeCellCenter(nNSS.cellPos, level, nNSS.cellCenter);
-				nNSS.pointsInNeighbourhood.clear();
-				nNSS.alreadyVisitedNeighbourhoodSize = 0;
-
-				//look for neighbors in a sphere
-				unsigned neighborCount = octree->findNearestNeighborsStartingFromCell(nNSS, false);
-				neighborCount = std::min(neighborCount, kNN + 1);
-
-				//current point index
-				const CCVector3& N1 = cloud->getPointNormal(firstUnvisitedIndex);
-				for (unsigned j = 0; j < neighborCount; ++j)
-				{
-					//current neighbor index
-					unsigned neighborIndex = nNSS.pointsInNeighbourhood[j].pointIndex;
-					if (	firstUnvisitedIndex != neighborIndex
-						&&	!visited[neighborIndex])
-					{
-						const CCVector3& N2 = cloud->getPointNormal(neighborIndex);
-						//dot product
-						float weight = std::max(0.0f, 1.0f - static_cast<float>(std::abs(N1.dot(N2))));
-
-						//distance
-						//float weight = sqrt(nNSS.pointsInNeighbourhood[j].squareDistd);
-
-						//mutual dot product
-						//const CCVector3* P2 = cloud->getPoint(static_cast<unsigned>(neighborIndex));
-						//CCVector3 uAB = *P2 - *P1;
-						//uAB.normalize();
-						//float weight = (std::abs(CCVector3::vdot(uAB.u, N1) + std::abs(CCVector3::vdot(uAB.u, N2)))) / 2;
-
-						priorityQueue.emplace( firstUnvisitedIndex, neighborIndex, weight );
-					}
-				}
-#endif
-
-				if (progressCb && !nProgress.oneStep())
-				{
-					break;
-				}
-			}
-
-	#ifdef COLOR_PATCHES
-			ccColor::Rgb patchCol = ccColor::Generator::Random();
-			cloud->setPointColor(static_cast<unsigned>(firstUnvisitedIndex), patchCol.rgb);
-			sf->setValue(static_cast<unsigned>(firstUnvisitedIndex),static_cast<ScalarType>(visitedCount));
-	#endif
-
-			while (!priorityQueue.empty() && (visitedCount < vertexCount))
-			{
-				//process next edge (with the lowest 'weight')
-				Edge element = priorityQueue.top();
-				priorityQueue.pop();
-
-				//shall the normal be inverted?
-				const CCVector3& N1 = cloud->getPointNormal(static_cast<unsigned>(element.v1()));
-				const CCVector3& N2 = cloud->getPointNormal(static_cast<unsigned>(element.v2()));
-				bool inverNormal = (N1.dot(N2) < 0);
-				unsigned v = 0;
-				//we should change the vertex that has not been visited yet
-				if (!visited[element.v1()])
-				{
-					v = element.v1();
-					if (inverNormal)
-					{
-						cloud->setPointNormal(static_cast<unsigned>(v), -N1);
-						++inversionCount;
-					}
-				}
-				else if (!visited[element.v2()])
-				{
-					v = element.v2();
-					if (inverNormal)
-					{
-						cloud->setPointNormal(static_cast<unsigned>(v), -N2);
-						++inversionCount;
-					}
-				}
-				else
-				{
-					continue;
-				}
-
-				//set it as "visited"
-				{
-					visited[v] = true;
-					++visitedCount;
-					//add its neighbors to the priority queue
-#ifdef WITH_GRAPH
-					const Graph::IndexSet& neighbors = graph.getVertexNeighbors(v);
-					for (Graph::IndexSet::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
-						priorityQueue.push(Edge(v, *it, graph.weight(v,*it)));
-#else
-					const CCVector3* P = cloud->getPoint(v);
-					nNSS.queryPoint = *P;
-					octree->getTheCellPosWhichIncludesThePoint(P, nNSS.cellPos, level);
-					octree->computeCellCenter(nNSS.cellPos, level, nNSS.cellCenter);
-					nNSS.pointsInNeighbourhood.clear();
-					nNSS.alreadyVisitedNeighbourhoodSize = 0;
-
-					//look for neighbors in a sphere
-					unsigned neighborCount = octree->findNearestNeighborsStartingFromCell(nNSS, false);
-					neighborCount = std::min(neighborCount, kNN + 1);
-					//current point index
-					const CCVector3& N1 = cloud->getPointNormal(v);
-					for (unsigned j = 0; j < neighborCount; ++j)
-					{
-						//current neighbor index
-						unsigned neighborIndex = nNSS.pointsInNeighbourhood[j].pointIndex;
-						if (	v != neighborIndex
-							&&	!visited[neighborIndex])
-						{
-							const CCVector3& N2 = cloud->getPointNormal(neighborIndex);
-							//dot product
-							float weight = std::max(0.0f, 1.0f - static_cast<float>(std::abs(N1.dot(N2))));
-
-							//distance
-							//float weight = sqrt(nNSS.pointsInNeighbourhood[j].squareDistd);
-
-							//mutual dot product
-							//const CCVector3* P2 = cloud->getPoint(static_cast<unsigned>(neighborIndex));
-							//CCVector3 uAB = *P2 - *P1;
-							//uAB.normalize();
-							//float weight = (std::abs(CCVector3::vdot(uAB.u, N1) + std::abs(CCVector3::vdot(uAB.u, N2)))) / 2;
-
-							priorityQueue.emplace( v, neighborIndex, weight );
-						}
-					}
-#endif
-				}
-
-	#ifdef COLOR_PATCHES
-				cloud->setPointColor(static_cast<unsigned>(v), patchCol);
-				sf->setValue(static_cast<unsigned>(v),static_cast<ScalarType>(visitedCount));
-	#endif
-				if (progressCb && !nProgress.oneStep())
-				{
-					visitedCount = static_cast<unsigned>(vertexCount); //early stop
-					break;
-				}
-			}
-
-			//new patch
-			++patchCount;
-		}
-
-	#ifdef COLOR_PATCHES
-		sf->computeMinAndMax();
-		cloud->showSF(true);
-	#endif
-
-		if (progressCb)
+	//! Returns the root of a vertex in the union-find structure (with path halving)
+	inline uint32_t FindRoot(std::vector<uint32_t>& parents, uint32_t v)
+	{
+		while (parents[v] != v)
 		{
-			progressCb->stop();
+			parents[v] = parents[parents[v]];
+			v = parents[v];
 		}
-
-		ccLog::Print(QString("[ResolveNormalsWithMST] Patches = %1 / Inversions: %2").arg(patchCount).arg(inversionCount));
-	}
-	catch (const std::bad_alloc&)
-	{
-		//not enough memory
-		return false;
+		return v;
 	}
-
-	return true;
 }
 
-#ifdef WITH_GRAPH
-static bool ComputeMSTGraphAtLevel(	const CCCoreLib::DgmOctree::octreeCell& cell,
+static bool ComputeKNNGraphAtLevel(	const CCCoreLib::DgmOctree::octreeCell& cell,
 									void** additionalParameters,
 									CCCoreLib::NormalizedProgress* nProgress/*=0*/)
 {
 	//parameters
-	Graph* graph = static_cast<Graph*>(additionalParameters[0]);
+	KNNGraph* graph = static_cast<KNNGraph*>(additionalParameters[0]);
 	ccPointCloud* cloud = static_cast<ccPointCloud*>(additionalParameters[1]);
-
-	//structure for the nearest neighbor search
-	unsigned kNN = *static_cast<unsigned*>(additionalParameters[2]);
+	const unsigned kNN = graph->k;
 
 	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
 	nNSS.level				  = cell.level;
@@ -447,7 +147,8 @@ static bool ComputeMSTGraphAtLevel(	const CCCoreLib::DgmOctree::octreeCell& cell
 	}
 	nNSS.alreadyVisitedNeighbourhoodSize = 1;
 
-	//for each point in the cell
+	//for each point in the cell (each point only writes its own row, hence the
+	//process is compatible with parallel strategies)
 	for (unsigned i = 0; i < n; ++i)
 	{
 		cell.points->getPoint(i, nNSS.queryPoint);
@@ -459,8 +160,10 @@ static bool ComputeMSTGraphAtLevel(	const CCCoreLib::DgmOctree::octreeCell& cell
 		//current point index
 		unsigned index = cell.points->getPointGlobalIndex(i);
 		const CCVector3& N1 = cloud->getPointNormal(index);
-		//const CCVector3* P1 = cloud->getPoint(static_cast<unsigned>(index));
-		for (unsigned j = 0; j < neighborCount; ++j)
+
+		size_t rowStart = static_cast<size_t>(index) * kNN;
+		unsigned slot = 0;
+		for (unsigned j = 0; j < neighborCount && slot < kNN; ++j)
 		{
 			//current neighbor index
 			unsigned neighborIndex = nNSS.pointsInNeighbourhood[j].pointIndex;
@@ -470,16 +173,9 @@ static bool ComputeMSTGraphAtLevel(	const CCCoreLib::DgmOctree::octreeCell& cell
 				//dot product
 				float weight = std::max(0.0f, 1.0f - static_cast<float>(std::abs(N1.dot(N2))));
 
-				//distance
-				//float weight = sqrt(nNSS.pointsInNeighbourhood[j].squareDistd);
-
-				//mutual dot product
-				//const CCVector3* P2 = cloud->getPoint(static_cast<unsigned>(neighborIndex));
-				//CCVector3 uAB = *P2 - *P1;
-				//uAB.normalize();
-				//float weight = (std::abs(CCVector3::vdot(uAB.u, N1) + std::abs(CCVector3::vdot(uAB.u, N2)))) / 2;
-
-				graph->addEdge(index, neighborIndex, weight);
+				graph->neighbors[rowStart + slot] = neighborIndex;
+				graph->weights[rowStart + slot] = weight;
+				++slot;
 			}
 		}
 
@@ -489,7 +185,111 @@ static bool ComputeMSTGraphAtLevel(	const CCCoreLib::DgmOctree::octreeCell& cell
 
 	return true;
 }
-#endif
+
+//! Computes the minimum spanning forest of the graph with Boruvka's algorithm
+/** \param graph kNN graph
+	\param vertexCount number of vertices
+	\param treeEdges output spanning forest edges (pairs of vertices)
+	\param components output component (root) index of each vertex
+	\return the number of components (or -1 if the process was canceled)
+**/
+static int ComputeSpanningForest(	const KNNGraph& graph,
+									unsigned vertexCount,
+									std::vector<uint32_t>& treeEdges,
+									std::vector<uint32_t>& components,
+									ccProgressDialog* progressCb)
+{
+	const unsigned kNN = graph.k;
+	const uint64_t NoEdge = std::numeric_limits<uint64_t>::max();
+
+	components.resize(vertexCount);
+	for (unsigned i = 0; i < vertexCount; ++i)
+	{
+		components[i] = i;
+	}
+	treeEdges.clear();
+	treeEdges.reserve(2 * static_cast<size_t>(vertexCount));
+
+	std::vector< std::atomic<uint64_t> > bestEdges(vertexCount);
+
+	unsigned componentCount = vertexCount;
+	for (unsigned round = 0; ; ++round)
+	{
+		if (progressCb)
+		{
+			if (progressCb->textCanBeEdited())
+			{
+				progressCb->setInfo(QObject::tr("Compute minimum spanning forest\nPoints: %1\nComponents: %2").arg(vertexCount).arg(componentCount));
+			}
+			//the number of components is (at least) divided by 2 at each round
+			progressCb->update(std::min(100.0f, 100.0f * (round + 1) / std::max(1.0f, std::log2(static_cast<float>(vertexCount)))));
+			if (progressCb->isCancelRequested())
+			{
+				return -1;
+			}
+		}
+
+		ParallelForIndexes(vertexCount, [&](size_t i)
+		{
+			bestEdges[i].store(NoEdge, std::memory_order_relaxed);
+		});
+
+		//find the lightest edge leaving each component (in parallel)
+		ParallelForIndexes(vertexCount, [&](size_t i)
+		{
+			uint32_t ci = components[i];
+			size_t rowStart = i * kNN;
+			for (unsigned j = 0; j < kNN; ++j)
+			{
+				uint32_t v = graph.neighbors[rowStart + j];
+				if (v == InvalidIndex)
+					break;
+				uint32_t cv = components[v];
+				if (ci == cv)
+					continue;
+				uint64_t key = EdgeKey(graph.weights[rowStart + j], static_cast<uint32_t>(rowStart + j));
+				AtomicMin(bestEdges[ci], key);
+				AtomicMin(bestEdges[cv], key);
+			}
+		});
+
+		//merge the components
+		unsigned mergeCount = 0;
+		for (unsigned c = 0; c < vertexCount; ++c)
+		{
+			uint64_t key = bestEdges[c].load(std::memory_order_relaxed);
+			if (key == NoEdge)
+				continue;
+
+			uint32_t edgeIndex = static_cast<uint32_t>(key & 0xFFFFFFFF);
+			uint32_t u = edgeIndex / kNN;
+			uint32_t v = graph.neighbors[edgeIndex];
+			uint32_t ru = FindRoot(components, u);
+			uint32_t rv = FindRoot(components, v);
+			if (ru == rv)
+				continue; //already merged (the same edge may be selected by both components)
+
+			components[std::max(ru, rv)] = std::min(ru, rv);
+			treeEdges.push_back(u);
+			treeEdges.push_back(v);
+			++mergeCount;
+		}
+
+		if (mergeCount == 0)
+		{
+			break;
+		}
+		componentCount -= mergeCount;
+
+		//flatten the union-find structure (so that components[i] is the root of i)
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			components[i] = FindRoot(components, i);
+		}
+	}
+
+	return static_cast<int>(componentCount);
+}
 
 bool ccMinimumSpanningTreeForNormsDirection::OrientNormals(	ccPointCloud* cloud,
 															unsigned kNN/*=6*/,
@@ -501,6 +301,11 @@ bool ccMinimumSpanningTreeForNormsDirection::OrientNormals(	ccPointCloud* cloud,
 		ccLog::Warning(QString("Cloud '%1' has no normals!").arg(cloud->getName()));
 		return false;
 	}
+	if (kNN == 0)
+	{
+		assert(false);
+		return false;
+	}
 
 	//we need the octree
 	if (!cloud->getOctree())
@@ -515,58 +320,172 @@ bool ccMinimumSpanningTreeForNormsDirection::OrientNormals(	ccPointCloud* cloud,
 	assert(octree);
 
 	unsigned char level = octree->findBestLevelForAGivenPopulationPerCell(kNN);
+	unsigned vertexCount = cloud->size();
 
-	bool result = true;
 	try
 	{
-#ifdef WITH_GRAPH
-		Graph graph;
-		if (!graph.reserve(cloud->size()))
+		//build the kNN graph (in parallel)
+		KNNGraph graph;
+		graph.k = kNN;
+		graph.neighbors.resize(static_cast<size_t>(vertexCount) * kNN, InvalidIndex);
+		graph.weights.resize(static_cast<size_t>(vertexCount) * kNN, 0.0f);
+		if (graph.neighbors.size() >= InvalidIndex)
 		{
-			//not enough memory!
-			result = false;
+			ccLog::Warning(QString("[orientNormalsWithMST] Too many points or neighbors on cloud '%1'").arg(cloud->getName()));
+			return false;
 		}
 
-		//parameters
-		void* additionalParameters[3] = {	reinterpret_cast<void*>(&graph),
-											reinterpret_cast<void*>(cloud),
-											reinterpret_cast<void*>(&kNN)
+		void* additionalParameters[2] = {	reinterpret_cast<void*>(&graph),
+											reinterpret_cast<void*>(cloud)
 										};
 
 		if (octree->executeFunctionForAllCellsAtLevel(	level,
-														&ComputeMSTGraphAtLevel,
+														&ComputeKNNGraphAtLevel,
 														additionalParameters,
-														false, //not compatible with parallel strategies!
+														true,
 														progressDlg,
-														"Build Spanning Tree") == 0)
+														"Build kNN graph") == 0)
+		{
+			//something went wrong (or the process was canceled)
+			ccLog::Warning(QString("Failed to compute the kNN graph on cloud '%1'").arg(cloud->getName()));
+			return false;
+		}
+
+		//minimum spanning forest
+		if (progressDlg)
+		{
+			progressDlg->setMethodTitle(QObject::tr("Orient normals (MST)"));
+			progressDlg->update(0);
+			progressDlg->start();
+		}
+
+		std::vector<uint32_t> treeEdges;
+		std::vector<uint32_t> components;
+		int componentCount = ComputeSpanningForest(graph, vertexCount, treeEdges, components, progressDlg);
+
+		//release the graph memory as soon as possible
+		graph.neighbors.clear();
+		graph.neighbors.shrink_to_fit();
+		graph.weights.clear();
+		graph.weights.shrink_to_fit();
+
+		if (componentCount < 0)
+		{
+			//process canceled by the user
+			return false;
+		}
+
+		//forest adjacency (CSR)
+		std::vector<uint32_t> offsets(static_cast<size_t>(vertexCount) + 1, 0);
+		for (uint32_t v : treeEdges)
+		{
+			++offsets[v + 1];
+		}
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			offsets[i + 1] += offsets[i];
+		}
+		std::vector<uint32_t> adjacency(treeEdges.size());
+		{
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t e = 0; e < treeEdges.size(); e += 2)
+			{
+				uint32_t u = treeEdges[e];
+				uint32_t v = treeEdges[e + 1];
+				adjacency[fill[u]++] = v;
+				adjacency[fill[v]++] = u;
+			}
+		}
+		treeEdges.clear();
+		treeEdges.shrink_to_fit();
+
+		//component roots
+		std::vector<uint32_t> roots;
+		roots.reserve(componentCount);
+		for (unsigned i = 0; i < vertexCount; ++i)
+		{
+			if (components[i] == i)
+			{
+				roots.push_back(i);
+			}
+		}
+		components.clear();
+		components.shrink_to_fit();
+
+		//propagate the orientation along the trees (components are processed in parallel)
+		//we only flag the normals to invert at this stage (each vertex belongs to a single tree)
+		std::vector<uint8_t> inverted(vertexCount, 0);
+		//the exceptions can't be propagated outside of the parallel loop
+		std::atomic<bool> notEnoughMemory(false);
+		ParallelForIndexes(roots.size(), [&](size_t c)
+		{
+			if (notEnoughMemory)
+				return;
+
+			try
+			{
+				//stack of (vertex, parent) pairs
+				std::vector< std::pair<uint32_t, uint32_t> > stack;
+				stack.emplace_back(roots[c], InvalidIndex);
+				while (!stack.empty())
+				{
+					std::pair<uint32_t, uint32_t> current = stack.back();
+					stack.pop_back();
+
+					uint32_t v = current.first;
+					const CCVector3& N = cloud->getPointNormal(v);
+					for (uint32_t a = offsets[v]; a < offsets[v + 1]; ++a)
+					{
+						uint32_t w = adjacency[a];
+						if (w == current.second)
+							continue;
+
+						//shall the normal be inverted (relatively to its - potentially inverted - parent)?
+						bool oppositeNormals = (N.dot(cloud->getPointNormal(w)) < 0);
+						inverted[w] = (oppositeNormals != (inverted[v] != 0)) ? 1 : 0;
+						stack.emplace_back(w, v);
+					}
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				notEnoughMemory = true;
+			}
+		});
+
+		if (notEnoughMemory)
 		{
-			//something went wrong
-			ccLog::Warning(QString("Failed to compute Spanning Tree on cloud '%1'").arg(cloud->getName()));
-			result = false;
+			ccLog::Error(QString("Not enough memory to orient the normals of cloud '%1'").arg(cloud->getName()));
+			return false;
 		}
-		else
+
+		size_t inversionCount = 0;
+		for (unsigned i = 0; i < vertexCount; ++i)
 		{
-			if (!ResolveNormalsWithMST(cloud, graph, progressDlg))
+			if (inverted[i])
 			{
-				//something went wrong
-				ccLog::Warning(QString("Failed to compute Minimum Spanning Tree on cloud '%1'").arg(cloud->getName()));
-				result = false;
+				cloud->setPointNormal(i, -cloud->getPointNormal(i));
+				++inversionCount;
 			}
 		}
-#else
-		if (!ResolveNormalsWithMST(cloud, octree, level, kNN, progressDlg))
+
+		if (progressDlg)
 		{
-			//something went wrong
-			ccLog::Warning(QString("Failed to resolve normals orientation with Minimum Spanning Tree on cloud '%1'").arg(cloud->getName()));
-			result = false;
+			progressDlg->stop();
 		}
-#endif
+
+		ccLog::Print(QString("[ResolveNormalsWithMST] Patches = %1 / Inversions: %2").arg(componentCount).arg(inversionCount));
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error(QString("Not enough memory to orient the normals of cloud '%1'").arg(cloud->getName()));
+		return false;
 	}
 	catch (...)
 	{
 		ccLog::Error(QString("Process failed on cloud '%1'").arg(cloud->getName()));
-		result = false;
+		return false;
 	}
 
-	return result;
+	return true;
 }
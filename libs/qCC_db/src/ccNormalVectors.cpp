@@ -30,6 +30,7 @@
 #include <Neighbourhood.h>
 
 //System
+#include <algorithm>
 #include <cassert>
 #include <random>
 
@@ -43,6 +44,215 @@ static const unsigned NUMBER_OF_POINTS_FOR_NORM_WITH_LS = 3;
 //Number of points for local modeling to compute normals with quadratic 'height' function
 static const unsigned NUMBER_OF_POINTS_FOR_NORM_WITH_QUADRIC = 6;
 
+//! Orients normals towards a preferred direction
+/** Shared by UpdateNormalOrientations and the normal computation cellular methods.
+**/
+struct NormalOrientationHelper
+{
+	bool init(ccGenericPointCloud* theCloud, ccNormalVectors::Orientation preferredOrientation)
+	{
+		assert(theCloud);
+		cloud = theCloud;
+		orientation = CCVector3(0, 0, 0);
+		barycenter = CCVector3(0, 0, 0);
+		useBarycenter = false;
+		positiveSign = true;
+		usePrevious = false;
+		enabled = false;
+
+		switch (preferredOrientation)
+		{
+		case ccNormalVectors::PLUS_X:
+		case ccNormalVectors::MINUS_X:
+		case ccNormalVectors::PLUS_Y:
+		case ccNormalVectors::MINUS_Y:
+		case ccNormalVectors::PLUS_Z:
+		case ccNormalVectors::MINUS_Z:
+			{
+				//0-5 = +/-X,Y,Z
+				assert(preferredOrientation >= 0 && preferredOrientation <= 5);
+
+				orientation.u[preferredOrientation >> 1] = ((preferredOrientation & 1) == 0 ? CCCoreLib::PC_ONE : -CCCoreLib::PC_ONE); //odd number --> inverse direction
+			}
+			break;
+
+		case ccNormalVectors::PLUS_BARYCENTER:
+		case ccNormalVectors::MINUS_BARYCENTER:
+			{
+				barycenter = CCCoreLib::GeometricalAnalysisTools::ComputeGravityCenter(cloud);
+				ccLog::Print(QString("[UpdateNormalOrientations] Barycenter: (%1,%2,%3)").arg(barycenter.x).arg(barycenter.y).arg(barycenter.z));
+				useBarycenter = true;
+				positiveSign = (preferredOrientation == ccNormalVectors::PLUS_BARYCENTER);
+			}
+			break;
+
+		case ccNormalVectors::PLUS_ZERO:
+		case ccNormalVectors::MINUS_ZERO:
+			{
+				//barycenter = CCVector3(0,0,0);
+				useBarycenter = true;
+				positiveSign = (preferredOrientation == ccNormalVectors::PLUS_ZERO);
+			}
+			break;
+
+		case ccNormalVectors::PREVIOUS:
+			{
+				if (!cloud->hasNormals())
+				{
+					ccLog::Warning("[UpdateNormalOrientations] Can't orient the new normals with the previous ones... as the cloud has no normals!");
+					return false;
+				}
+				usePrevious = true;
+			}
+			break;
+
+		default:
+			assert(false);
+			return false;
+		}
+
+		enabled = true;
+		return true;
+	}
+
+	//! Orients a normal (returns true if the normal has been inverted)
+	inline bool orient(unsigned pointIndex, CCVector3& N) const
+	{
+		if (!enabled)
+		{
+			return false;
+		}
+
+		CCVector3 dir = orientation;
+		if (usePrevious)
+		{
+			dir = cloud->getPointNormal(pointIndex);
+		}
+		else if (useBarycenter)
+		{
+			if (positiveSign)
+			{
+				dir = *(cloud->getPoint(pointIndex)) - barycenter;
+			}
+			else
+			{
+				dir = barycenter - *(cloud->getPoint(pointIndex));
+			}
+		}
+
+		//we eventually check the sign
+		if (N.dot(dir) < 0)
+		{
+			N *= -1;
+			return true;
+		}
+		return false;
+	}
+
+	ccGenericPointCloud* cloud = nullptr;
+	CCVector3 orientation;
+	CCVector3 barycenter;
+	bool useBarycenter = false;
+	bool positiveSign = true;
+	bool usePrevious = false;
+	bool enabled = false;
+};
+
+//! Context shared by the normal computation cellular methods
+/** Each normal is estimated, oriented and compressed in the same pass, so that
+	no temporary (full precision) normal array is required.
+**/
+struct NormalsComputationContext
+{
+	//! Output (compressed) normals
+	NormsIndexesTableType* codes = nullptr;
+	//! Neighbourhood radius (radius mode)
+	PointCoordinateType radius = 0;
+	//! Number of neighbours (kNN mode, or 0 for the radius mode)
+	unsigned kNN = 0;
+	//! Orientation
+	NormalOrientationHelper orientation;
+
+	//! Orients, compresses and stores a normal
+	inline void store(unsigned pointIndex, CCVector3& N) const
+	{
+		orientation.orient(pointIndex, N);
+		codes->setValue(pointIndex, ccNormalVectors::GetNormIndex(N));
+	}
+};
+
+//! Per-thread neighbours buffer (for the kNN mode)
+/** Avoids a new allocation for each octree cell.
+**/
+static thread_local CCCoreLib::DgmOctree::NeighboursSet s_kNNBuffer;
+
+//! Computes the normals of the points of a given cell with their k nearest neighbours
+static bool ComputeNormsInKNNNeighbourhood(	const CCCoreLib::DgmOctree::octreeCell& cell,
+											const NormalsComputationContext& context,
+											CCCoreLib::LOCAL_MODEL_TYPES model,
+											CCCoreLib::NormalizedProgress* nProgress)
+{
+	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
+	nNSS.level = cell.level;
+	nNSS.minNumberOfNeighbors = context.kNN;
+	cell.parentOctree->getCellPos(cell.truncatedCode, cell.level, nNSS.cellPos, true);
+	cell.parentOctree->computeCellCenter(nNSS.cellPos, cell.level, nNSS.cellCenter);
+
+	//we re-use the buffer of the current thread
+	nNSS.pointsInNeighbourhood.swap(s_kNNBuffer);
+
+	//we already know which points are lying in the current cell
+	unsigned pointCount = cell.points->size();
+	nNSS.pointsInNeighbourhood.resize(pointCount);
+	{
+		CCCoreLib::DgmOctree::NeighboursSet::iterator it = nNSS.pointsInNeighbourhood.begin();
+		for (unsigned j = 0; j < pointCount; ++j, ++it)
+		{
+			it->point = cell.points->getPointPersistentPtr(j);
+			it->pointIndex = cell.points->getPointGlobalIndex(j);
+		}
+	}
+	nNSS.alreadyVisitedNeighbourhoodSize = 1;
+
+	unsigned minK = (model == CCCoreLib::QUADRIC ? NUMBER_OF_POINTS_FOR_NORM_WITH_QUADRIC : NUMBER_OF_POINTS_FOR_NORM_WITH_LS);
+
+	bool success = true;
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		cell.points->getPoint(i, nNSS.queryPoint);
+
+		//warning: there may be more points at the end of nNSS.pointsInNeighbourhood than the actual nearest neighbors (k)!
+		unsigned k = cell.parentOctree->findNearestNeighborsStartingFromCell(nNSS);
+		if (k > context.kNN)
+		{
+			k = context.kNN;
+		}
+		if (k >= minK)
+		{
+			CCCoreLib::DgmOctreeReferenceCloud neighbours(&nNSS.pointsInNeighbourhood, k);
+
+			CCVector3 N;
+			bool validNormal = (model == CCCoreLib::QUADRIC ? ccNormalVectors::ComputeNormalWithQuadric(&neighbours, nNSS.queryPoint, N)
+															: ccNormalVectors::ComputeNormalWithLS(&neighbours, N));
+			if (validNormal)
+			{
+				context.store(cell.points->getPointGlobalIndex(i), N);
+			}
+		}
+
+		if (nProgress && !nProgress->oneStep())
+		{
+			success = false;
+			break;
+		}
+	}
+
+	//give the buffer back to the thread
+	nNSS.pointsInNeighbourhood.swap(s_kNNBuffer);
+
+	return success;
+}
+
 ccNormalVectors* ccNormalVectors::GetUniqueInstance()
 {
 	if (!s_uniqueInstance.instance)
@@ -133,58 +343,9 @@ bool ccNormalVectors::UpdateNormalOrientations(	ccGenericPointCloud* theCloud,
 	assert(theCloud);
 
 	//preferred orientation
-	CCVector3 orientation(0,0,0);
-	CCVector3 barycenter(0,0,0);
-	bool useBarycenter = false;
-	bool positiveSign = true;
-
-	switch (preferredOrientation)
+	NormalOrientationHelper helper;
+	if (!helper.init(theCloud, preferredOrientation))
 	{
-	case PLUS_X:
-	case MINUS_X:
-	case PLUS_Y:
-	case MINUS_Y:
-	case PLUS_Z:
-	case MINUS_Z:
-		{
-			//0-5 = +/-X,Y,Z
-			assert(preferredOrientation >= 0 && preferredOrientation <= 5);
-
-			orientation.u[preferredOrientation >> 1] = ((preferredOrientation & 1) == 0 ? CCCoreLib::PC_ONE : -CCCoreLib::PC_ONE); //odd number --> inverse direction
-		}
-		break;
-
-	case PLUS_BARYCENTER:
-	case MINUS_BARYCENTER:
-		{
-			barycenter = CCCoreLib::GeometricalAnalysisTools::ComputeGravityCenter(theCloud);
-			ccLog::Print(QString("[UpdateNormalOrientations] Barycenter: (%1,%2,%3)").arg(barycenter.x).arg(barycenter.y).arg(barycenter.z));
-			useBarycenter = true;
-			positiveSign = (preferredOrientation == 6);
-		}
-		break;
-
-	case PLUS_ZERO:
-	case MINUS_ZERO:
-		{
-			//barycenter = CCVector3(0,0,0);
-			useBarycenter = true;
-			positiveSign = (preferredOrientation == 8);
-		}
-		break;
-
-	case PREVIOUS:
-		{
-			if (!theCloud->hasNormals())
-			{
-				ccLog::Warning("[UpdateNormalOrientations] Can't orient the new normals with the previous ones... as the cloud has no normals!");
-				return false;
-			}
-		}
-		break;
-
-	default:
-		assert(false);
 		return false;
 	}
 
@@ -194,27 +355,9 @@ bool ccNormalVectors::UpdateNormalOrientations(	ccGenericPointCloud* theCloud,
 		const CompressedNormType& code = theNormsCodes.getValue(i);
 		CCVector3 N = GetNormal(code);
 
-		if (preferredOrientation == PREVIOUS)
-		{
-			orientation = theCloud->getPointNormal(i);
-		}
-		else if (useBarycenter)
+		if (helper.orient(i, N))
 		{
-			if (positiveSign)
-			{
-				orientation = *(theCloud->getPoint(i)) - barycenter;
-			}
-			else
-			{
-				orientation = barycenter - *(theCloud->getPoint(i));
-			}
-		}
-
-		//we eventually check the sign
-		if (N.dot(orientation) < 0)
-		{
-			//inverse normal and re-compress it
-			N *= -1;
+			//re-compress the inverted normal
 			theNormsCodes.setValue(i, ccNormalVectors::GetNormIndex(N.u));
 		}
 	}
@@ -413,7 +556,8 @@ bool ccNormalVectors::ComputeCloudNormals(	ccGenericPointCloud* theCloud,
 											PointCoordinateType localRadius,
 											Orientation preferredOrientation/*=UNDEFINED*/,
 											CCCoreLib::GenericProgressCallback* progressCb/*=0*/,
-											CCCoreLib::DgmOctree* inputOctree/*=0*/)
+											CCCoreLib::DgmOctree* inputOctree/*=0*/,
+											unsigned kNN/*=0*/)
 {
 	assert(theCloud);
 
@@ -435,36 +579,45 @@ bool ccNormalVectors::ComputeCloudNormals(	ccGenericPointCloud* theCloud,
 	}
 
 	//reserve some memory to store the (compressed) normals
-	if (!theNormsCodes.isAllocated() || theNormsCodes.currentSize() < pointCount)
-	{
-		if (!theNormsCodes.resizeSafe(pointCount))
-		{
-			if (theOctree && !inputOctree)
-				delete theOctree;
-			return false;
-		}
-	}
-
-	//we instantiate 3D normal vectors
-	NormsTableType* theNorms = new NormsTableType;
+	//(the points for which no normal can be computed get a null normal)
 	static const CCVector3 blankN(0, 0, 0);
-	if (!theNorms->resizeSafe(pointCount, true, &blankN))
+	const CompressedNormType blankCode = GetNormIndex(blankN);
+	if (!theNormsCodes.resizeSafe(pointCount))
 	{
-		theNormsCodes.resize(0);
 		if (theOctree && !inputOctree)
 			delete theOctree;
 		return false;
 	}
-	//theNorms->fill(0);
+	std::fill(theNormsCodes.begin(), theNormsCodes.end(), blankCode);
+
+	//the normals are estimated, oriented and compressed in the same (parallel) pass
+	NormalsComputationContext context;
+	context.codes = &theNormsCodes;
+	context.radius = localRadius;
+	context.kNN = 0;
+	if (kNN != 0 && localModel == CCCoreLib::TRI)
+	{
+		ccLog::Warning("[ComputeCloudNormals] The kNN mode is ignored with the TRI model (it already works with a fixed number of neighbours)");
+	}
+	else if (kNN != 0)
+	{
+		context.kNN = std::max(kNN, localModel == CCCoreLib::QUADRIC ? NUMBER_OF_POINTS_FOR_NORM_WITH_QUADRIC : NUMBER_OF_POINTS_FOR_NORM_WITH_LS);
+	}
+	if (preferredOrientation != UNDEFINED)
+	{
+		//if the orientation can't be applied, the normals are simply not oriented
+		context.orientation.init(theCloud, preferredOrientation);
+	}
 
-	void* additionalParameters[2] = { reinterpret_cast<void*>(theNorms), reinterpret_cast<void*>(&localRadius) };
+	void* additionalParameters[1] = { reinterpret_cast<void*>(&context) };
 
 	unsigned processedCells = 0;
 	switch (localModel)
 	{
 	case CCCoreLib::LS:
 		{
-			unsigned char level = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(localRadius);
+			unsigned char level = (context.kNN != 0 ? theOctree->findBestLevelForAGivenPopulationPerCell(context.kNN)
+													: theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(localRadius));
 			processedCells = theOctree->executeFunctionForAllCellsAtLevel(	level,
 																			&(ComputeNormsAtLevelWithLS),
 																			additionalParameters,
@@ -488,7 +641,8 @@ bool ccNormalVectors::ComputeCloudNormals(	ccGenericPointCloud* theCloud,
 		break;
 	case CCCoreLib::QUADRIC:
 		{
-			unsigned char level = theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(localRadius);
+			unsigned char level = (context.kNN != 0 ? theOctree->findBestLevelForAGivenPopulationPerCell(context.kNN)
+													: theOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(localRadius));
 			processedCells = theOctree->executeFunctionForAllCellsAtLevel(	level,
 																			&(ComputeNormsAtLevelWithQuadric),
 																			additionalParameters,
@@ -502,6 +656,12 @@ bool ccNormalVectors::ComputeCloudNormals(	ccGenericPointCloud* theCloud,
 		break;
 	}
 
+	if (theOctree && !inputOctree)
+	{
+		delete theOctree;
+		theOctree = nullptr;
+	}
+
 	//error or canceled by user?
 	if (processedCells == 0 || (progressCb && progressCb->isCancelRequested()))
 	{
@@ -509,30 +669,6 @@ bool ccNormalVectors::ComputeCloudNormals(	ccGenericPointCloud* theCloud,
 		return false;
 	}
 
-	//we 'compress' each normal
-	std::fill(theNormsCodes.begin(), theNormsCodes.end(), 0);
-	for (unsigned i = 0; i < pointCount; i++)
-	{
-		const CCVector3& N = theNorms->at(i);
-		CompressedNormType nCode = GetNormIndex(N);
-		theNormsCodes.setValue(i, nCode);
-	}
-
-	theNorms->release();
-	theNorms = nullptr;
-
-	//preferred orientation
-	if (preferredOrientation != UNDEFINED)
-	{
-		UpdateNormalOrientations(theCloud, theNormsCodes, preferredOrientation);
-	}
-
-	if (theOctree && !inputOctree)
-	{
-		delete theOctree;
-		theOctree = nullptr;
-	}
-
 	return true;
 }
 
@@ -662,8 +798,12 @@ bool ccNormalVectors::ComputeNormsAtLevelWithQuadric(	const CCCoreLib::DgmOctree
 														CCCoreLib::NormalizedProgress* nProgress/*=0*/)
 {
 	//additional parameters
-	NormsTableType* theNorms = static_cast<NormsTableType*>(additionalParameters[0]);
-	PointCoordinateType radius = *static_cast<PointCoordinateType*>(additionalParameters[1]);
+	const NormalsComputationContext& context = *static_cast<NormalsComputationContext*>(additionalParameters[0]);
+	if (context.kNN != 0)
+	{
+		return ComputeNormsInKNNNeighbourhood(cell, context, CCCoreLib::QUADRIC, nProgress);
+	}
+	PointCoordinateType radius = context.radius;
 
 	CCCoreLib::DgmOctree::NearestNeighboursSphericalSearchStruct nNSS;
 	nNSS.level = cell.level;
@@ -700,7 +840,7 @@ bool ccNormalVectors::ComputeNormsAtLevelWithQuadric(	const CCCoreLib::DgmOctree
 			CCVector3 N;
 			if (ComputeNormalWithQuadric(&neighbours, nNSS.queryPoint, N))
 			{
-				theNorms->setValue(cell.points->getPointGlobalIndex(i), N);
+				context.store(cell.points->getPointGlobalIndex(i), N);
 			}
 		}
 
@@ -716,8 +856,12 @@ bool ccNormalVectors::ComputeNormsAtLevelWithLS(const CCCoreLib::DgmOctree::octr
 												CCCoreLib::NormalizedProgress* nProgress/*=0*/)
 {
 	//additional parameters
-	NormsTableType* theNorms = static_cast<NormsTableType*>(additionalParameters[0]);
-	PointCoordinateType radius = *static_cast<PointCoordinateType*>(additionalParameters[1]);
+	const NormalsComputationContext& context = *static_cast<NormalsComputationContext*>(additionalParameters[0]);
+	if (context.kNN != 0)
+	{
+		return ComputeNormsInKNNNeighbourhood(cell, context, CCCoreLib::LS, nProgress);
+	}
+	PointCoordinateType radius = context.radius;
 
 	CCCoreLib::DgmOctree::NearestNeighboursSphericalSearchStruct nNSS;
 	nNSS.level = cell.level;
@@ -756,7 +900,7 @@ bool ccNormalVectors::ComputeNormsAtLevelWithLS(const CCCoreLib::DgmOctree::octr
 			CCVector3 N;
 			if (ComputeNormalWithLS(&neighbours, N))
 			{
-				theNorms->setValue(cell.points->getPointGlobalIndex(i), N);
+				context.store(cell.points->getPointGlobalIndex(i), N);
 			}
 		}
 
@@ -774,7 +918,7 @@ bool ccNormalVectors::ComputeNormsAtLevelWithTri(	const CCCoreLib::DgmOctree::oc
 													CCCoreLib::NormalizedProgress* nProgress/*=0*/)
 {
 	//additional parameters
-	NormsTableType* theNorms = static_cast<NormsTableType*>(additionalParameters[0]);
+	const NormalsComputationContext& context = *static_cast<NormalsComputationContext*>(additionalParameters[0]);
 
 	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
 	nNSS.level = cell.level;
@@ -809,7 +953,7 @@ bool ccNormalVectors::ComputeNormsAtLevelWithTri(	const CCCoreLib::DgmOctree::oc
 			CCVector3 N;
 			if (ComputeNormalWithTri(&neighbours, N))
 			{
-				theNorms->setValue(cell.points->getPointGlobalIndex(i), N);
+				context.store(cell.points->getPointGlobalIndex(i), N);
 			}
 		}
 
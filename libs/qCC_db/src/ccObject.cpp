@@ -63,8 +63,9 @@
 	v5.0 - 10/06/2019 - Point labels can now target the entity center
 	v5.1 - 03/29/2019 - New camera management (viewports have changed)
 	v5.2 - 11/30/2020 - New ccCoordinateSystem added
+	v5.3 - 10/18/2026 - Compact storage of scalar fields (8/16 bits quantized or half precision values)
 **/
-const unsigned c_currentDBVersion = 52; //5.2
+const unsigned c_currentDBVersion = 53; //5.3
 
 //! Default unique ID generator (using the system persistent settings as we did previously proved to be not reliable)
 static ccUniqueIDGenerator::Shared s_uniqueIDGenerator(new ccUniqueIDGenerator);
@@ -89,6 +90,25 @@ unsigned ccObject::GetCurrentDBVersion()
 	return c_currentDBVersion;
 }
 
+//! Version of the file being written by the current thread (0 = current version)
+static thread_local short s_serializationVersion = 0;
+
+ccSerializationContext::ccSerializationContext(short dataVersion)
+	: m_previousVersion(s_serializationVersion)
+{
+	s_serializationVersion = dataVersion;
+}
+
+ccSerializationContext::~ccSerializationContext()
+{
+	s_serializationVersion = m_previousVersion;
+}
+
+short ccSerializationContext::DataVersion()
+{
+	return (s_serializationVersion > 0 ? s_serializationVersion : static_cast<short>(c_currentDBVersion));
+}
+
 unsigned ccObject::GetNextUniqueID()
 {
 	if (!s_uniqueIDGenerator)
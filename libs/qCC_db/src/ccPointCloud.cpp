@@ -18,6 +18,10 @@
 //Always first
 #include "ccIncludeGL.h"
 
+#ifdef CC_CORE_LIB_USES_TBB
+#include <tbb/parallel_sort.h>
+#endif
+
 #include "ccPointCloud.h"
 
 //CCCoreLib
@@ -42,6 +46,7 @@
 #include "ccMinimumSpanningTreeForNormsDirection.h"
 #include "ccNormalVectors.h"
 #include "ccOctree.h"
+#include "ccParallelFor.h"
 #include "ccPointCloudLOD.h"
 #include "ccPolyline.h"
 #include "ccProgressDialog.h"
@@ -52,11 +57,175 @@
 #include <QElapsedTimer>
 
 //system
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
 #include <queue>
 
 static const char s_deviationSFName[] = "Deviation";
 
+namespace
+{
+	//! Number of points copied by each parallel job (see ccPointCloud::append)
+	static const unsigned s_parallelChunkSize = 65536;
+
+	//! Copies attribute arrays in parallel (dest[i] = source[indexes[i]])
+	/** Each attribute array is a separate gather task. The tasks are split in chunks
+		of s_parallelChunkSize values, except in 'in place' mode (source == dest) where
+		each array is compacted sequentially (in this case the indexes must be increasing).
+	**/
+	class GatherEngine
+	{
+	public:
+
+		//! Default constructor
+		/** \param indexes source index of each destination value
+			\param inPlace whether the arrays are compacted in place or not
+		**/
+		GatherEngine(const std::vector<unsigned>& indexes, bool inPlace)
+			: m_indexes(indexes)
+			, m_inPlace(inPlace)
+		{}
+
+		//! Adds an attribute array to copy
+		/** \param source source array
+			\param dest destination array (at least indexes.size() values, can be equal to 'source' in 'in place' mode)
+		**/
+		template <class T> void add(const T* source, T* dest)
+		{
+			assert(m_inPlace || source != dest);
+			const unsigned* indexes = m_indexes.data();
+			m_tasks.emplace_back([source, dest, indexes](unsigned first, unsigned last)
+			{
+				for (unsigned i = first; i < last; ++i)
+				{
+					dest[i] = source[indexes[i]];
+				}
+			});
+		}
+
+		//! Runs all the tasks
+		void run() const
+		{
+			const unsigned count = static_cast<unsigned>(m_indexes.size());
+			if (m_tasks.empty() || count == 0)
+			{
+				return;
+			}
+
+			const unsigned chunkSize = (m_inPlace ? count : s_parallelChunkSize);
+			const unsigned chunkCount = (count + chunkSize - 1) / chunkSize;
+			ccParallel::For(static_cast<int>(m_tasks.size() * chunkCount), [&](int jobIndex)
+			{
+				unsigned first = (static_cast<unsigned>(jobIndex) % chunkCount) * chunkSize;
+				unsigned last = std::min(first + chunkSize, count);
+				m_tasks[static_cast<unsigned>(jobIndex) / chunkCount](first, last);
+			});
+		}
+
+	protected:
+
+		//! Source indexes
+		const std::vector<unsigned>& m_indexes;
+		//! Whether the arrays are compacted in place or not
+		bool m_inPlace;
+		//! Gather tasks (one per attribute array)
+		std::vector< std::function<void(unsigned, unsigned)> > m_tasks;
+	};
+
+	//! Permutes an array in place (values[i] = old values[order[i]])
+	/** The cycles of the permutation are followed (no additional memory is required).
+		\param values array to permute
+		\param order permutation
+		\param cycleStarts first index of each (non trivial) cycle of the permutation
+	**/
+	template <class T> void PermuteInPlace(T* values, const std::vector<unsigned>& order, const std::vector<unsigned>& cycleStarts)
+	{
+		for (unsigned start : cycleStarts)
+		{
+			T startValue = values[start];
+			unsigned j = start;
+			for (unsigned k = order[j]; k != start; k = order[k])
+			{
+				values[j] = values[k];
+				j = k;
+			}
+			values[j] = startValue;
+		}
+	}
+
+	//! Number of bits per dimension of the space filling curves keys (3 x 21 = 63 bits)
+	static const unsigned s_sfcBitsPerDim = 21;
+
+	//! Inserts two 0 bits between each of the 21 lowest bits of a value
+	inline uint64_t SpreadBits(uint64_t x)
+	{
+		x &= 0x1FFFFF;
+		x = (x | (x << 32)) & 0x1F00000000FFFFull;
+		x = (x | (x << 16)) & 0x1F0000FF0000FFull;
+		x = (x | (x << 8))  & 0x100F00F00F00F00Full;
+		x = (x | (x << 4))  & 0x10C30C30C30C30C3ull;
+		x = (x | (x << 2))  & 0x1249249249249249ull;
+		return x;
+	}
+
+	//! Returns the Morton key of a cell (same bit interleaving as the octree cell codes)
+	inline uint64_t MortonKey(uint32_t x, uint32_t y, uint32_t z)
+	{
+		return SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+	}
+
+	//! Returns the Hilbert key of a cell
+	/** See J. Skilling, "Programming the Hilbert curve", AIP Conference Proceedings 707, 2004.
+	**/
+	inline uint64_t HilbertKey(uint32_t x, uint32_t y, uint32_t z)
+	{
+		uint32_t X[3] = { x, y, z };
+		const uint32_t M = 1u << (s_sfcBitsPerDim - 1);
+
+		//inverse undo
+		for (uint32_t Q = M; Q > 1; Q >>= 1)
+		{
+			uint32_t P = Q - 1;
+			for (int i = 0; i < 3; ++i)
+			{
+				if (X[i] & Q)
+				{
+					X[0] ^= P; //invert
+				}
+				else
+				{
+					uint32_t t = (X[0] ^ X[i]) & P; //exchange
+					X[0] ^= t;
+					X[i] ^= t;
+				}
+			}
+		}
+
+		//Gray encode
+		X[1] ^= X[0];
+		X[2] ^= X[1];
+		uint32_t t = 0;
+		for (uint32_t Q = M; Q > 1; Q >>= 1)
+		{
+			if (X[2] & Q)
+			{
+				t ^= Q - 1;
+			}
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			X[i] ^= t;
+		}
+
+		//the key is the interleaving of the 'transposed' coordinates (X[0] holds the most significant bits)
+		return (SpreadBits(X[0]) << 2) | (SpreadBits(X[1]) << 1) | SpreadBits(X[2]);
+	}
+}
+
 ccPointCloud::ccPointCloud(QString name/*=QString()*/, unsigned uniqueID/*=ccUniqueIDGenerator::InvalidUniqueID*/) throw()
 	: BaseClass(name, uniqueID)
 	, m_rgbaColors(nullptr)
@@ -205,30 +374,43 @@ ccPointCloud* ccPointCloud::partialClone(const CCCoreLib::ReferenceCloud* select
 	unsigned n = selection->size();
 	if (n)
 	{
-		if (!result->reserveThePointsTable(n))
+		//list of the selected indexes (for the gather tasks)
+		std::vector<unsigned> indexes;
+		try
+		{
+			indexes.resize(n);
+		}
+		catch (const std::bad_alloc&)
 		{
 			ccLog::Error("[ccPointCloud::partialClone] Not enough memory to duplicate cloud!");
 			delete result;
 			return nullptr;
 		}
+		for (unsigned i = 0; i < n; i++)
+		{
+			indexes[i] = selection->getPointGlobalIndex(i);
+		}
 
-		//import points
+		if (!result->reserveThePointsTable(n))
 		{
-			for (unsigned i = 0; i < n; i++)
-			{
-				result->addPoint(*getPointPersistentPtr(selection->getPointGlobalIndex(i)));
-			}
+			ccLog::Error("[ccPointCloud::partialClone] Not enough memory to duplicate cloud!");
+			delete result;
+			return nullptr;
 		}
+		result->m_points.resize(n);
+
+		//all the attributes are allocated first, then copied in parallel
+		GatherEngine gather(indexes, false);
+
+		//import points
+		gather.add(m_points.data(), result->m_points.data());
 
 		//RGB colors
 		if (hasColors())
 		{
-			if (result->reserveTheRGBTable())
+			if (result->resizeTheRGBTable())
 			{
-				for (unsigned i = 0; i < n; i++)
-				{
-					result->addColor(getPointColor(selection->getPointGlobalIndex(i)));
-				}
+				gather.add(m_rgbaColors->data(), result->m_rgbaColors->data());
 				result->showColors(colorsShown());
 			}
 			else
@@ -242,12 +424,9 @@ ccPointCloud* ccPointCloud::partialClone(const CCCoreLib::ReferenceCloud* select
 		//normals
 		if (hasNormals())
 		{
-			if (result->reserveTheNormsTable())
+			if (result->resizeTheNormsTable())
 			{
-				for (unsigned i = 0; i < n; i++)
-				{
-					result->addNormIndex(getPointNormalIndex(selection->getPointGlobalIndex(i)));
-				}
+				gather.add(m_normals->data(), result->m_normals->data());
 				result->showNormals(normalsShown());
 			}
 			else
@@ -259,32 +438,15 @@ ccPointCloud* ccPointCloud::partialClone(const CCCoreLib::ReferenceCloud* select
 		}
 
 		//waveform
+		bool copyFWF = false;
 		if (hasFWF())
 		{
-			if (result->reserveTheFWFTable())
+			if (result->resizeTheFWFTable())
 			{
-				try
-				{
-					for (unsigned i = 0; i < n; i++)
-					{
-						const ccWaveform& w = m_fwfWaveforms[selection->getPointGlobalIndex(i)];
-						if (!result->fwfDescriptors().contains(w.descriptorID()))
-						{
-							//copy only the necessary descriptors
-							result->fwfDescriptors().insert(w.descriptorID(), m_fwfDescriptors[w.descriptorID()]);
-						}
-						result->waveforms().push_back(w);
-					}
-					//we will use the same FWF data container
-					result->fwfData() = fwfData();
-				}
-				catch (const std::bad_alloc&)
-				{
-					ccLog::Warning("[ccPointCloud::partialClone] Not enough memory to copy waveform signals!");
-					result->clearFWFData();
-					if (warnings)
-						*warnings |= WRN_OUT_OF_MEM_FOR_FWF;
-				}
+				gather.add(m_fwfWaveforms.data(), result->m_fwfWaveforms.data());
+				//we will use the same FWF data container
+				result->fwfData() = fwfData();
+				copyFWF = true;
 			}
 			else
 			{
@@ -295,62 +457,77 @@ ccPointCloud* ccPointCloud::partialClone(const CCCoreLib::ReferenceCloud* select
 		}
 
 		//scalar fields
+		std::vector< std::pair<const ccScalarField*, ccScalarField*> > copiedSFs;
 		unsigned sfCount = getNumberOfScalarFields();
-		if (sfCount != 0)
+		for (unsigned k = 0; k < sfCount; ++k)
 		{
-			for (unsigned k = 0; k < sfCount; ++k)
+			const ccScalarField* sf = static_cast<ccScalarField*>(getScalarField(k));
+			assert(sf);
+			if (sf)
 			{
-				const ccScalarField* sf = static_cast<ccScalarField*>(getScalarField(k));
-				assert(sf);
-				if (sf)
+				//we create a new scalar field with same name
+				int sfIdx = result->addScalarField(sf->getName());
+				if (sfIdx >= 0) //success
 				{
-					//we create a new scalar field with same name
-					int sfIdx = result->addScalarField(sf->getName());
-					if (sfIdx >= 0) //success
+					ccScalarField* currentScalarField = static_cast<ccScalarField*>(result->getScalarField(sfIdx));
+					assert(currentScalarField);
+					if (currentScalarField->resizeSafe(n))
 					{
-						ccScalarField* currentScalarField = static_cast<ccScalarField*>(result->getScalarField(sfIdx));
-						assert(currentScalarField);
-						if (currentScalarField->resizeSafe(n))
-						{
-							currentScalarField->setGlobalShift(sf->getGlobalShift());
-
-							//we copy data to new SF
-							for (unsigned i = 0; i < n; i++)
-								currentScalarField->setValue(i, sf->getValue(selection->getPointGlobalIndex(i)));
-
-							currentScalarField->computeMinAndMax();
-							//copy display parameters
-							currentScalarField->importParametersFrom(sf);
-						}
-						else
-						{
-							//if we don't have enough memory, we cancel SF creation
-							result->deleteScalarField(sfIdx);
-							ccLog::Warning(QString("[ccPointCloud::partialClone] Not enough memory to copy scalar field '%1'!").arg(sf->getName()));
-							if (warnings)
-								*warnings |= WRN_OUT_OF_MEM_FOR_SFS;
-						}
+						currentScalarField->setGlobalShift(sf->getGlobalShift());
+						gather.add(sf->data(), currentScalarField->data());
+						copiedSFs.emplace_back(sf, currentScalarField);
+					}
+					else
+					{
+						//if we don't have enough memory, we cancel SF creation
+						result->deleteScalarField(sfIdx);
+						ccLog::Warning(QString("[ccPointCloud::partialClone] Not enough memory to copy scalar field '%1'!").arg(sf->getName()));
+						if (warnings)
+							*warnings |= WRN_OUT_OF_MEM_FOR_SFS;
 					}
 				}
 			}
+		}
+
+		//now we can copy all the attributes at once
+		gather.run();
+		result->invalidateBoundingBox();
 
-			unsigned copiedSFCount = getNumberOfScalarFields();
-			if (copiedSFCount)
+		if (copyFWF)
+		{
+			//copy only the necessary descriptors
+			for (const ccWaveform& w : result->m_fwfWaveforms)
 			{
-				//we display the same scalar field as the source (if we managed to copy it!)
-				if (getCurrentDisplayedScalarField())
+				if (!result->fwfDescriptors().contains(w.descriptorID()))
 				{
-					int sfIdx = result->getScalarFieldIndexByName(getCurrentDisplayedScalarField()->getName());
-					if (sfIdx >= 0)
-						result->setCurrentDisplayedScalarField(sfIdx);
-					else
-						result->setCurrentDisplayedScalarField(static_cast<int>(copiedSFCount) - 1);
+					result->fwfDescriptors().insert(w.descriptorID(), m_fwfDescriptors[w.descriptorID()]);
 				}
-				//copy visibility
-				result->showSF(sfShown());
 			}
 		}
 
+		for (const auto& sfPair : copiedSFs)
+		{
+			sfPair.second->computeMinAndMax();
+			//copy display parameters
+			sfPair.second->importParametersFrom(sfPair.first);
+		}
+
+		unsigned copiedSFCount = result->getNumberOfScalarFields();
+		if (copiedSFCount)
+		{
+			//we display the same scalar field as the source (if we managed to copy it!)
+			if (getCurrentDisplayedScalarField())
+			{
+				int sfIdx = result->getScalarFieldIndexByName(getCurrentDisplayedScalarField()->getName());
+				if (sfIdx >= 0)
+					result->setCurrentDisplayedScalarField(sfIdx);
+				else
+					result->setCurrentDisplayedScalarField(static_cast<int>(copiedSFCount) - 1);
+			}
+			//copy visibility
+			result->showSF(sfShown());
+		}
+
 		//scan grids
 		if (gridCount() != 0)
 		{
@@ -862,206 +1039,1098 @@ const ccPointCloud& ccPointCloud::append(ccPointCloud* addedCloud, unsigned poin
 			}
 		}
 
-		//let's check if there are non-updated fields
-		for (unsigned j = 0; j < sfCount; ++j)
+		//let's check if there are non-updated fields
+		for (unsigned j = 0; j < sfCount; ++j)
+		{
+			if (!sfUpdated[j])
+			{
+				CCCoreLib::ScalarField* sf = getScalarField(j);
+				assert(sf);
+
+				if (sf->currentSize() == pointCountBefore)
+				{
+					//we fill the end with NaN (as there is no equivalent in the added cloud)
+					ScalarType NaN = sf->NaN();
+					for (unsigned i = 0; i < addedPoints; i++)
+					{
+						sf->addElement(NaN);
+					}
+				}
+			}
+		}
+
+		//in case something bad happened
+		if (getNumberOfScalarFields() == 0)
+		{
+			setCurrentDisplayedScalarField(-1);
+			showSF(false);
+		}
+		else
+		{
+			//if there was no scalar field before
+			if (sfCount == 0)
+			{
+				//and if the added cloud has one displayed
+				const ccScalarField* dispSF = addedCloud->getCurrentDisplayedScalarField();
+				if (dispSF)
+				{
+					//we set it as displayed on the current cloud also
+					int sfIdx = getScalarFieldIndexByName(dispSF->getName()); //same name!
+					setCurrentDisplayedScalarField(sfIdx);
+				}
+			}
+
+			//merge display parameters
+			showSF(sfShown() || addedCloud->sfShown());
+		}
+	}
+
+	//grid structures, global shift and children
+	appendStructures(addedCloud, pointCountBefore, ignoreChildren);
+
+	//We should update the VBOs (just in case)
+	releaseVBOs();
+	//As well as the LOD structure
+	clearLOD();
+
+	return *this;
+}
+
+void ccPointCloud::appendStructures(ccPointCloud* addedCloud, unsigned pointCountBefore, bool ignoreChildren)
+{
+	assert(addedCloud);
+
+	//if the merged cloud has grid structures AND this one is blank or also has grid structures
+	if (addedCloud->gridCount() != 0 && (gridCount() != 0 || pointCountBefore == 0))
+	{
+		//copy the grid structures
+		for (size_t i = 0; i < addedCloud->gridCount(); ++i)
+		{
+			const Grid::Shared& otherGrid = addedCloud->grid(i);
+			if (otherGrid && otherGrid->validCount != 0) //no need to copy empty grids!
+			{
+				try
+				{
+					//copy the grid data
+					Grid::Shared grid(new Grid(*otherGrid));
+					{
+						//then update the indexes
+						unsigned cellCount = grid->w*grid->h;
+						int* _gridIndex = grid->indexes.data();
+						for (size_t j = 0; j < cellCount; ++j, ++_gridIndex)
+						{
+							if (*_gridIndex >= 0)
+							{
+								//shift the index
+								*_gridIndex += static_cast<int>(pointCountBefore);
+							}
+						}
+
+						//don't forget to shift the boundaries as well
+						grid->minValidIndex += pointCountBefore;
+						grid->maxValidIndex += pointCountBefore;
+					}
+
+					addGrid(grid);
+				}
+				catch (const std::bad_alloc&)
+				{
+					//not enough memory
+					m_grids.resize(0);
+					ccLog::Warning(QString("[ccPointCloud::fusion] Not enough memory: failed to copy the grid structure(s) from '%1'").arg(addedCloud->getName()));
+					break;
+				}
+			}
+			else
+			{
+				assert(otherGrid);
+			}
+		}
+	}
+	else if (gridCount() != 0) //otherwise we'll have to drop the former grid structures!
+	{
+		ccLog::Warning(QString("[ccPointCloud::fusion] Grid structure(s) will be dropped as the merged cloud is unstructured"));
+		m_grids.resize(0);
+	}
+
+	//has the cloud been recentered/rescaled?
+	{
+		if (addedCloud->isShifted())
+		{
+			if (!isShifted())
+			{
+				//we can keep the global shift information of the merged cloud
+				copyGlobalShiftAndScale(*addedCloud);
+			}
+			else if (	getGlobalScale() != addedCloud->getGlobalScale()
+					||	(getGlobalShift() - addedCloud->getGlobalShift()).norm2d() > 1.0e-6)
+			{
+				//the clouds have different shift & scale information!
+				ccLog::Warning(QString("[ccPointCloud::fusion] Global shift/scale information conflict: shift/scale of cloud '%1' will be ignored!").arg(addedCloud->getName()));
+			}
+		}
+	}
+
+	//children (not yet reserved)
+	if (!ignoreChildren)
+	{
+		unsigned childrenCount = addedCloud->getChildrenNumber();
+		for (unsigned c = 0; c < childrenCount; ++c)
+		{
+			ccHObject* child = addedCloud->getChild(c);
+			if (!child)
+			{
+				assert(false);
+				continue;
+			}
+			if (child->isA(CC_TYPES::MESH)) //mesh --> FIXME: what for the other types of MESH?
+			{
+				ccMesh* mesh = static_cast<ccMesh*>(child);
+
+				//detach from father?
+				//addedCloud->detachChild(mesh);
+				//ccGenericMesh* addedTri = mesh;
+
+				//or clone?
+				ccMesh* cloneMesh = mesh->cloneMesh(mesh->getAssociatedCloud() == addedCloud ? this : nullptr);
+				if (cloneMesh)
+				{
+					//change mesh vertices
+					if (cloneMesh->getAssociatedCloud() == this)
+					{
+						cloneMesh->shiftTriangleIndexes(pointCountBefore);
+					}
+					addChild(cloneMesh);
+				}
+				else
+				{
+					ccLog::Warning(QString("[ccPointCloud::fusion] Not enough memory: failed to clone sub mesh %1!").arg(mesh->getName()));
+				}
+			}
+			else if (child->isKindOf(CC_TYPES::IMAGE))
+			{
+				//ccImage* image = static_cast<ccImage*>(child);
+
+				//DGM FIXME: take image ownership! (dirty)
+				addedCloud->transferChild(child, *this);
+			}
+			else if (child->isA(CC_TYPES::LABEL_2D))
+			{
+				//clone label and update points if necessary
+				cc2DLabel* label = static_cast<cc2DLabel*>(child);
+				cc2DLabel* newLabel = new cc2DLabel(label->getName());
+				for (unsigned j = 0; j < label->size(); ++j)
+				{
+					cc2DLabel::PickedPoint P = label->getPickedPoint(j);
+					if (P._cloud == addedCloud)
+					{
+						P._cloud = this;
+						P.index += pointCountBefore;
+					}
+					newLabel->addPickedPoint(P);
+				}
+				newLabel->displayPointLegend(label->isPointLegendDisplayed());
+				newLabel->setDisplayedIn2D(label->isDisplayedIn2D());
+				newLabel->setCollapsed(label->isCollapsed());
+				newLabel->setPosition(label->getPosition()[0], label->getPosition()[1]);
+				newLabel->setVisible(label->isVisible());
+				newLabel->setDisplay(getDisplay());
+				addChild(newLabel);
+			}
+			else if (child->isA(CC_TYPES::GBL_SENSOR))
+			{
+				//copy sensor object
+				ccGBLSensor* sensor = new ccGBLSensor(*static_cast<ccGBLSensor*>(child));
+				addChild(sensor);
+				sensor->setDisplay(getDisplay());
+				sensor->setVisible(child->isVisible());
+			}
+		}
+	}
+}
+
+bool ccPointCloud::append(const std::vector<ccPointCloud*>& addedClouds, bool ignoreChildren/*=false*/)
+{
+	if (isLocked())
+	{
+		ccLog::Error("[ccPointCloud::append] Cloud is locked");
+		return false;
+	}
+
+	//appended block (i.e. one per added cloud)
+	struct Block
+	{
+		ccPointCloud* cloud = nullptr;
+		//! Index of the first point of the block in the merged cloud
+		unsigned offset = 0;
+		//! Index of the source scalar field for each SF of the merged cloud (or -1)
+		std::vector<int> sfIndexes;
+		//! Shift to apply to the source SF values (for each SF of the merged cloud)
+		std::vector<double> sfShifts;
+		//! Whether the block waveforms are imported
+		bool importFWF = false;
+		//! FWF descriptor IDs conversion (or -1 if the descriptor couldn't be imported)
+		std::vector<int> descriptorIDMap;
+		//! Offset of the block waveform data in the merged FWF data container
+		uint64_t fwfDataOffset = 0;
+	};
+
+	const unsigned pointCountBefore = size();
+	const unsigned sfCountBefore = getNumberOfScalarFields();
+
+	//first we compute the final layout of the merged cloud (once)
+	std::vector<Block> blocks;
+	std::vector<const ccScalarField*> newSFSources; //first source of each new SF
+	bool withColors = hasColors();
+	bool withNormals = hasNormals();
+	bool withFWF = hasFWF();
+	uint64_t finalCount = pointCountBefore;
+	try
+	{
+		QMap<QString, int> sfIndexByName;
+		for (unsigned k = 0; k < sfCountBefore; ++k)
+		{
+			sfIndexByName.insert(getScalarFieldName(static_cast<int>(k)), static_cast<int>(k));
+		}
+
+		blocks.reserve(addedClouds.size());
+		for (ccPointCloud* cloud : addedClouds)
+		{
+			if (!cloud || cloud == this)
+			{
+				assert(false);
+				continue;
+			}
+
+			Block block;
+			block.cloud = cloud;
+			block.offset = static_cast<unsigned>(finalCount);
+			finalCount += cloud->size();
+
+			withColors |= cloud->hasColors();
+			withNormals |= cloud->hasNormals();
+			withFWF |= cloud->hasFWF();
+
+			for (unsigned k = 0; k < cloud->getNumberOfScalarFields(); ++k)
+			{
+				const ccScalarField* sf = static_cast<ccScalarField*>(cloud->getScalarField(static_cast<int>(k)));
+				assert(sf);
+				QString sfName(sf->getName());
+				if (!sfIndexByName.contains(sfName))
+				{
+					//new scalar field
+					sfIndexByName.insert(sfName, static_cast<int>(sfCountBefore + newSFSources.size()));
+					newSFSources.push_back(sf);
+				}
+			}
+
+			blocks.push_back(block);
+		}
+
+		//now that we know all the scalar fields, we can match them (by name)
+		size_t mergedSFCount = sfCountBefore + newSFSources.size();
+		for (Block& block : blocks)
+		{
+			block.sfIndexes.resize(mergedSFCount, -1);
+			block.sfShifts.resize(mergedSFCount, 0.0);
+			for (unsigned k = 0; k < block.cloud->getNumberOfScalarFields(); ++k)
+			{
+				const ccScalarField* sf = static_cast<ccScalarField*>(block.cloud->getScalarField(static_cast<int>(k)));
+				int sfIdx = sfIndexByName.value(QString(sf->getName()));
+				block.sfIndexes[sfIdx] = static_cast<int>(k);
+				//the destination SF has the global shift of its first source
+				double destShift = (sfIdx < static_cast<int>(sfCountBefore) ? static_cast<ccScalarField*>(getScalarField(sfIdx))->getGlobalShift() : newSFSources[sfIdx - sfCountBefore]->getGlobalShift());
+				block.sfShifts[sfIdx] = sf->getGlobalShift() - destShift;
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[ccPointCloud::append] Not enough memory!");
+		return false;
+	}
+
+	if (blocks.empty())
+	{
+		//nothing to do
+		return true;
+	}
+	if (finalCount > std::numeric_limits<unsigned>::max())
+	{
+		ccLog::Error("[ccPointCloud::append] The merged cloud would have too many points!");
+		return false;
+	}
+
+	//parallel copy jobs
+	struct CopyJob
+	{
+		size_t blockIndex;
+		unsigned firstIndex;
+		unsigned count;
+	};
+	std::vector<CopyJob> jobs;
+	try
+	{
+		for (size_t i = 0; i < blocks.size(); ++i)
+		{
+			unsigned cloudSize = blocks[i].cloud->size();
+			for (unsigned firstIndex = 0; firstIndex < cloudSize; firstIndex += s_parallelChunkSize)
+			{
+				jobs.push_back({ i, firstIndex, std::min(s_parallelChunkSize, cloudSize - firstIndex) });
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[ccPointCloud::append] Not enough memory!");
+		return false;
+	}
+
+	//merge display parameters
+	for (const Block& block : blocks)
+	{
+		setVisible(isVisible() || block.cloud->isVisible());
+	}
+
+	//we remove structures that are not compatible with the fusion process
+	deleteOctree();
+	unallocateVisibilityArray();
+
+	//then we allocate each table a single time
+	const bool hadColors = hasColors();
+	const bool hadNormals = hasNormals();
+	const bool hadFWF = hasFWF();
+	bool success = resize(static_cast<unsigned>(finalCount));
+	if (success && withColors && !hadColors)
+	{
+		success = resizeTheRGBTable(true);
+	}
+	if (success && withNormals && !hadNormals)
+	{
+		success = resizeTheNormsTable();
+	}
+	if (success && withFWF && m_fwfWaveforms.size() != finalCount)
+	{
+		success = resizeTheFWFTable();
+	}
+	for (size_t k = 0; success && k < newSFSources.size(); ++k)
+	{
+		const ccScalarField* sf = newSFSources[k];
+		ccScalarField* newSF = new ccScalarField(sf->getName());
+		newSF->setGlobalShift(sf->getGlobalShift());
+		//the SF is filled with NaN by default (for the clouds that don't have it)
+		if (newSF->resizeSafe(static_cast<unsigned>(finalCount), true, CCCoreLib::NAN_VALUE) && addScalarField(newSF) >= 0)
+		{
+			//copy display parameters
+			newSF->importParametersFrom(sf);
+		}
+		else
+		{
+			newSF->release();
+			newSF = nullptr;
+			success = false;
+		}
+	}
+
+	if (!success)
+	{
+		//restore the cloud in its previous state
+		while (getNumberOfScalarFields() > sfCountBefore)
+		{
+			deleteScalarField(static_cast<int>(getNumberOfScalarFields()) - 1);
+		}
+		if (!hadColors)
+			unallocateColors();
+		if (!hadNormals)
+			unallocateNorms();
+		if (!hadFWF)
+			clearFWFData();
+		resize(pointCountBefore);
+
+		ccLog::Error("[ccPointCloud::append] Not enough memory!");
+		return false;
+	}
+
+	//waveforms: merge the data containers and the descriptors
+	if (withFWF)
+	{
+		//distinct data containers
+		std::vector<SharedFWFDataContainer> containers;
+		std::vector<uint64_t> containerOffsets;
+		uint64_t totalDataSize = 0;
+		auto addContainer = [&](const SharedFWFDataContainer& container) -> uint64_t
+		{
+			for (size_t i = 0; i < containers.size(); ++i)
+			{
+				if (containers[i] == container)
+				{
+					return containerOffsets[i];
+				}
+			}
+			containers.push_back(container);
+			containerOffsets.push_back(totalDataSize);
+			totalDataSize += container->size();
+			return containerOffsets.back();
+		};
+
+		try
+		{
+			if (hadFWF)
+			{
+				addContainer(fwfData());
+			}
+			for (Block& block : blocks)
+			{
+				if (block.cloud->hasFWF())
+				{
+					block.fwfDataOffset = addContainer(block.cloud->fwfData());
+					block.importFWF = true;
+				}
+			}
+
+			if (containers.size() > 1)
+			{
+				//we need to merge the FWF data containers!
+				FWFDataContainer* mergedContainer = new FWFDataContainer;
+				try
+				{
+					mergedContainer->reserve(totalDataSize);
+					for (const SharedFWFDataContainer& container : containers)
+					{
+						mergedContainer->insert(mergedContainer->end(), container->begin(), container->end());
+					}
+					fwfData() = SharedFWFDataContainer(mergedContainer);
+				}
+				catch (const std::bad_alloc&)
+				{
+					delete mergedContainer;
+					mergedContainer = nullptr;
+					throw;
+				}
+			}
+			else if (!containers.empty())
+			{
+				//we will simply use the (unique) FWF data container
+				fwfData() = containers.front();
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ccPointCloud::append] Not enough memory: failed to merge waveform containers!");
+			for (Block& block : blocks)
+			{
+				block.importFWF = false;
+			}
+		}
+
+		//copy the wave descriptors
+		for (Block& block : blocks)
+		{
+			if (!block.importFWF)
+			{
+				continue;
+			}
+
+			block.descriptorIDMap.resize(256, -1);
+			for (auto it = block.cloud->m_fwfDescriptors.begin(); it != block.cloud->m_fwfDescriptors.end(); ++it)
+			{
+				uint8_t newKey = it.key();
+				if (m_fwfDescriptors.contains(newKey))
+				{
+					//we'll have to find a free descriptor ID (not used in the destination cloud)
+					newKey = 0;
+					for (unsigned k = 1; k < 256; ++k)
+					{
+						if (!m_fwfDescriptors.contains(static_cast<uint8_t>(k)))
+						{
+							newKey = static_cast<uint8_t>(k);
+							break;
+						}
+					}
+					if (newKey == 0)
+					{
+						ccLog::Warning("[ccPointCloud::append] Not enough free FWF descriptor IDs on destination cloud: some waveforms won't be imported!");
+						break;
+					}
+				}
+				block.descriptorIDMap[it.key()] = newKey; //remember the ID transposition
+				m_fwfDescriptors.insert(newKey, it.value()); //insert the descriptor at its new position (ID)
+			}
+		}
+	}
+
+	//now we can copy the attributes (in parallel)
+	std::vector<size_t> lostWaveformCounts(jobs.size(), 0);
+	const unsigned mergedSFCount = getNumberOfScalarFields();
+	ccParallel::For(static_cast<int>(jobs.size()), [&](int jobIndex)
+	{
+		const CopyJob& job = jobs[jobIndex];
+		const Block& block = blocks[job.blockIndex];
+		const ccPointCloud* cloud = block.cloud;
+		const unsigned destIndex = block.offset + job.firstIndex;
+
+		//points
+		std::copy(	cloud->m_points.begin() + job.firstIndex,
+					cloud->m_points.begin() + job.firstIndex + job.count,
+					m_points.begin() + destIndex );
+
+		//colors
+		if (withColors)
+		{
+			if (cloud->hasColors())
+			{
+				std::copy(	cloud->m_rgbaColors->begin() + job.firstIndex,
+							cloud->m_rgbaColors->begin() + job.firstIndex + job.count,
+							m_rgbaColors->begin() + destIndex );
+			}
+			else
+			{
+				//we set a white color to the points without color
+				std::fill_n(m_rgbaColors->begin() + destIndex, job.count, ccColor::white);
+			}
+		}
+
+		//normals (the points without normal are associated to '0' normals)
+		if (withNormals && cloud->hasNormals())
+		{
+			std::copy(	cloud->m_normals->begin() + job.firstIndex,
+						cloud->m_normals->begin() + job.firstIndex + job.count,
+						m_normals->begin() + destIndex );
+		}
+
+		//scalar fields
+		for (unsigned k = 0; k < mergedSFCount; ++k)
+		{
+			CCCoreLib::ScalarField* destSF = getScalarField(static_cast<int>(k));
+			int sfIdx = block.sfIndexes[k];
+			if (sfIdx >= 0)
+			{
+				const CCCoreLib::ScalarField* sf = cloud->getScalarField(sfIdx);
+				double shift = block.sfShifts[k];
+				if (shift == 0.0)
+				{
+					for (unsigned i = 0; i < job.count; ++i)
+					{
+						destSF->setValue(destIndex + i, sf->getValue(job.firstIndex + i));
+					}
+				}
+				else
+				{
+					for (unsigned i = 0; i < job.count; ++i)
+					{
+						destSF->setValue(destIndex + i, static_cast<ScalarType>(shift + sf->getValue(job.firstIndex + i))); //FIXME: we could have accuracy issues here
+					}
+				}
+			}
+			else
+			{
+				//we fill the block with NaN (as there is no equivalent in the added cloud)
+				for (unsigned i = 0; i < job.count; ++i)
+				{
+					destSF->setValue(destIndex + i, CCCoreLib::NAN_VALUE);
+				}
+			}
+		}
+
+		//waveforms (the points without waveform are associated to empty waveforms)
+		if (block.importFWF)
+		{
+			for (unsigned i = 0; i < job.count; ++i)
+			{
+				ccWaveform w = cloud->m_fwfWaveforms[job.firstIndex + i];
+				if (w.descriptorID() == 0)
+				{
+					//empty waveform
+					continue;
+				}
+
+				int newID = block.descriptorIDMap[w.descriptorID()];
+				if (newID > 0) //the waveform can be imported :)
+				{
+					//update the byte offset
+					w.setDataDescription(w.dataOffset() + block.fwfDataOffset, w.byteCount());
+					//and the (potentially new) descriptor ID
+					w.setDescriptorID(static_cast<uint8_t>(newID));
+
+					m_fwfWaveforms[destIndex + i] = w;
+				}
+				else //the waveform is associated to a descriptor that couldn't be imported :(
+				{
+					++lostWaveformCounts[jobIndex];
+				}
+			}
+		}
+	});
+
+	size_t lostWaveformCount = std::accumulate(lostWaveformCounts.begin(), lostWaveformCounts.end(), static_cast<size_t>(0));
+	if (lostWaveformCount)
+	{
+		ccLog::Warning(QString("[ccPointCloud::append] %1 waveform(s) were lost in the fusion process").arg(lostWaveformCount));
+	}
+
+	//update the scalar fields boundaries
+	ccParallel::For(static_cast<int>(mergedSFCount), [&](int k)
+	{
+		static_cast<ccScalarField*>(getScalarField(k))->computeMinAndMax();
+	});
+
+	//merge display parameters
+	for (const Block& block : blocks)
+	{
+		if (withColors)
+			showColors(colorsShown() || block.cloud->colorsShown());
+		if (withNormals)
+			showNormals(normalsShown() || block.cloud->normalsShown());
+		if (mergedSFCount != 0)
+			showSF(sfShown() || block.cloud->sfShown());
+	}
+	if (sfCountBefore == 0 && mergedSFCount != 0)
+	{
+		//if there was no scalar field before, we display the first one displayed on the added clouds
+		for (const Block& block : blocks)
+		{
+			const ccScalarField* dispSF = block.cloud->getCurrentDisplayedScalarField();
+			if (dispSF)
+			{
+				setCurrentDisplayedScalarField(getScalarFieldIndexByName(dispSF->getName())); //same name!
+				break;
+			}
+		}
+	}
+
+	//grid structures, global shift and children
+	for (const Block& block : blocks)
+	{
+		appendStructures(block.cloud, block.offset, ignoreChildren);
+	}
+
+	//deprecate internal structures
+	notifyGeometryUpdate(); //calls releaseVBOs()
+	//As well as the LOD structure
+	clearLOD();
+
+	return true;
+}
+
+bool ccPointCloud::isMeshVertices() const
+{
+	//the meshes register themselves as dependents of their vertices (see ccMesh::setAssociatedCloud)
+	for (const auto& dependency : m_dependencies)
+	{
+		const ccHObject* object = dependency.first;
+		if (object && object->isKindOf(CC_TYPES::MESH) && static_cast<const ccGenericMesh*>(object)->getAssociatedCloud() == this)
+		{
+			return true;
+		}
+	}
+
+	//just in case, we also check the parent and the children
+	const ccHObject* parent = getParent();
+	if (parent && parent->isKindOf(CC_TYPES::MESH) && static_cast<const ccGenericMesh*>(parent)->getAssociatedCloud() == this)
+	{
+		return true;
+	}
+	for (unsigned i = 0; i < getChildrenNumber(); ++i)
+	{
+		const ccHObject* child = getChild(i);
+		if (child && child->isKindOf(CC_TYPES::MESH) && static_cast<const ccGenericMesh*>(child)->getAssociatedCloud() == this)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ccPointCloud::hasIndexedDependents() const
+{
+	if (isMeshVertices())
+	{
+		return true;
+	}
+
+	//the polylines and the kd-trees can be dependents, children or parent of the cloud
+	std::vector<const ccHObject*> objects;
+	for (const auto& dependency : m_dependencies)
+	{
+		objects.push_back(dependency.first);
+	}
+	for (unsigned i = 0; i < getChildrenNumber(); ++i)
+	{
+		objects.push_back(getChild(i));
+	}
+	objects.push_back(getParent());
+
+	for (const ccHObject* object : objects)
+	{
+		if (!object)
+		{
+			continue;
+		}
+		if (object->isKindOf(CC_TYPES::POLY_LINE) && static_cast<const ccPolyline*>(object)->getAssociatedCloud() == this)
+		{
+			return true;
+		}
+		if (object->isA(CC_TYPES::POINT_KDTREE) && static_cast<const ccKdTree*>(object)->associatedGenericCloud() == this)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ccPointCloud::permutePoints(const std::vector<unsigned>& order)
+{
+	unsigned pointCount = size();
+	if (order.size() != pointCount)
+	{
+		assert(false);
+		return false;
+	}
+
+	if (isLocked())
+	{
+		ccLog::Warning(QString("[ccPointCloud] Cloud '%1' is locked: its points can't be reordered").arg(getName()));
+		return false;
+	}
+
+	//the triangles of a mesh refer to its vertices by index
+	if (isMeshVertices())
+	{
+		ccLog::Warning(QString("[ccPointCloud] Cloud '%1' is the vertices of a mesh: its points can't be reordered").arg(getName()));
+		return false;
+	}
+	//and so do the polylines and the kd-trees
+	if (hasIndexedDependents())
+	{
+		ccLog::Warning(QString("[ccPointCloud] Cloud '%1' is used by a polyline or a kd-tree: its points can't be reordered").arg(getName()));
+		return false;
+	}
+
+	//the labels are updated afterwards (they can be dependents or children of the cloud)
+	std::vector<cc2DLabel*> labels;
+	for (const auto& dependency : m_dependencies)
+	{
+		if (dependency.first && dependency.first->isA(CC_TYPES::LABEL_2D))
+		{
+			labels.push_back(static_cast<cc2DLabel*>(dependency.first));
+		}
+	}
+	for (unsigned i = 0; i < getChildrenNumber(); ++i)
+	{
+		ccHObject* child = getChild(i);
+		if (child->isA(CC_TYPES::LABEL_2D) && std::find(labels.begin(), labels.end(), child) == labels.end())
+		{
+			labels.push_back(static_cast<cc2DLabel*>(child));
+		}
+	}
+
+	//we decompose the permutation in cycles (once for all the attributes)
+	std::vector<unsigned> cycleStarts;
+	std::vector<int> newIndexMap;
+	try
+	{
+		std::vector<bool> visited(pointCount, false);
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			if (visited[i])
+			{
+				continue;
+			}
+			visited[i] = true;
+			if (order[i] == i)
+			{
+				//nothing to do
+				continue;
+			}
+
+			cycleStarts.push_back(i);
+			for (unsigned j = order[i]; j != i; j = order[j])
+			{
+				if (j >= pointCount || visited[j])
+				{
+					ccLog::Warning("[ccPointCloud::permutePoints] Invalid permutation");
+					assert(false);
+					return false;
+				}
+				visited[j] = true;
+			}
+		}
+
+		//we'll need a map between old and new indexes for the scan grids and the labels
+		if (!m_grids.empty() || !labels.empty())
+		{
+			newIndexMap.resize(pointCount);
+			for (unsigned i = 0; i < pointCount; ++i)
+			{
+				newIndexMap[order[i]] = static_cast<int>(i);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccPointCloud::permutePoints] Not enough memory");
+		return false;
+	}
+
+	if (cycleStarts.empty())
+	{
+		//identity
+		return true;
+	}
+
+	//the octree and the LOD structure are based on the points indexes
+	deleteOctree();
+	clearLOD();
+
+	//each attribute array is permuted by a separate (parallel) task
+	std::vector< std::function<void()> > tasks;
+	tasks.emplace_back([&]() { PermuteInPlace(m_points.data(), order, cycleStarts); });
+	if (hasColors())
+	{
+		tasks.emplace_back([&]() { PermuteInPlace(m_rgbaColors->data(), order, cycleStarts); });
+	}
+	if (hasNormals())
+	{
+		tasks.emplace_back([&]() { PermuteInPlace(m_normals->data(), order, cycleStarts); });
+	}
+	if (hasFWF())
+	{
+		tasks.emplace_back([&]() { PermuteInPlace(m_fwfWaveforms.data(), order, cycleStarts); });
+	}
+	if (m_pointsVisibility.size() == pointCount)
+	{
+		tasks.emplace_back([&]() { PermuteInPlace(m_pointsVisibility.data(), order, cycleStarts); });
+	}
+	for (unsigned k = 0; k < getNumberOfScalarFields(); ++k)
+	{
+		CCCoreLib::ScalarField* sf = getScalarField(static_cast<int>(k));
+		tasks.emplace_back([&, sf]() { PermuteInPlace(sf->data(), order, cycleStarts); });
+	}
+	ccParallel::For(static_cast<int>(tasks.size()), [&](int taskIndex) { tasks[taskIndex](); });
+
+	//scan grids
+	if (!m_grids.empty())
+	{
+		UpdateGridIndexes(newIndexMap, m_grids);
+	}
+
+	//labels
+	for (cc2DLabel* label : labels)
+	{
+		label->updatePointIndexes(this, newIndexMap);
+	}
+
+	notifyGeometryUpdate(); //calls releaseVBOs
+
+	return true;
+}
+
+bool ccPointCloud::reorderPoints(SpatialOrder order, bool storeOriginalIndexes/*=false*/)
+{
+	unsigned pointCount = size();
+	if (pointCount < 2)
+	{
+		//nothing to do
+		return true;
+	}
+
+	std::vector< std::pair<uint64_t, unsigned> > keys;
+	std::vector<unsigned> permutation;
+	try
+	{
+		keys.resize(pointCount);
+		permutation.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccPointCloud::reorderPoints] Not enough memory");
+		return false;
+	}
+
+	//the points are quantized in the cubical bounding box (as for the octree)
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	getBoundingBox(bbMin, bbMax);
+	CCVector3 diag = bbMax - bbMin;
+	PointCoordinateType maxDim = std::max(diag.x, std::max(diag.y, diag.z));
+	const double maxCell = static_cast<double>((1u << s_sfcBitsPerDim) - 1);
+	const double scale = (maxDim > 0 ? maxCell / maxDim : 0.0);
+
+	//key of each point on the space filling curve
+	const int chunkCount = static_cast<int>((pointCount + s_parallelChunkSize - 1) / s_parallelChunkSize);
+	ccParallel::For(chunkCount, [&](int chunkIndex)
+	{
+		unsigned first = static_cast<unsigned>(chunkIndex) * s_parallelChunkSize;
+		unsigned last = std::min(first + s_parallelChunkSize, pointCount);
+		for (unsigned i = first; i < last; ++i)
+		{
+			const CCVector3& P = m_points[i];
+			uint32_t x = static_cast<uint32_t>(std::min(maxCell, (P.x - bbMin.x) * scale));
+			uint32_t y = static_cast<uint32_t>(std::min(maxCell, (P.y - bbMin.y) * scale));
+			uint32_t z = static_cast<uint32_t>(std::min(maxCell, (P.z - bbMin.z) * scale));
+			keys[i].first = (order == SpatialOrder::HILBERT ? HilbertKey(x, y, z) : MortonKey(x, y, z));
+			keys[i].second = i;
+		}
+	});
+
+#ifdef CC_CORE_LIB_USES_TBB
+	tbb::parallel_sort(keys.begin(), keys.end());
+#else
+	std::sort(keys.begin(), keys.end());
+#endif
+
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		permutation[i] = keys[i].second;
+	}
+	keys.clear();
+	keys.shrink_to_fit();
+
+	//the original indexes are stored in a scalar field (reordered with the other attributes)
+	int originalIndexesSFIdx = -1;
+	int originalIndexesHighSFIdx = -1;
+	if (storeOriginalIndexes && getScalarFieldIndexByName(OriginalIndexesSFName()) < 0)
+	{
+		//too many points to store the indexes exactly in a single scalar field
+		//(--> we split them in two scalar fields: the 16 lower bits and the higher bits)
+		bool splitIndexes = (pointCount > std::ldexp(1.0, std::numeric_limits<ScalarType>::digits));
+
+		originalIndexesSFIdx = addScalarField(OriginalIndexesSFName());
+		if (originalIndexesSFIdx >= 0 && splitIndexes)
 		{
-			if (!sfUpdated[j])
+			originalIndexesHighSFIdx = addScalarField(OriginalIndexesHighSFName());
+			if (originalIndexesHighSFIdx < 0)
 			{
-				CCCoreLib::ScalarField* sf = getScalarField(j);
-				assert(sf);
-
-				if (sf->currentSize() == pointCountBefore)
-				{
-					//we fill the end with NaN (as there is no equivalent in the added cloud)
-					ScalarType NaN = sf->NaN();
-					for (unsigned i = 0; i < addedPoints; i++)
-					{
-						sf->addElement(NaN);
-					}
-				}
+				deleteScalarField(originalIndexesSFIdx);
+				originalIndexesSFIdx = -1;
 			}
 		}
+		if (originalIndexesSFIdx < 0)
+		{
+			ccLog::Warning("[ccPointCloud::reorderPoints] Not enough memory to store the original indexes");
+			return false;
+		}
 
-		//in case something bad happened
-		if (getNumberOfScalarFields() == 0)
+		ccScalarField* sf = static_cast<ccScalarField*>(getScalarField(originalIndexesSFIdx));
+		if (splitIndexes)
 		{
-			setCurrentDisplayedScalarField(-1);
-			showSF(false);
+			ccScalarField* highSF = static_cast<ccScalarField*>(getScalarField(originalIndexesHighSFIdx));
+			for (unsigned i = 0; i < pointCount; ++i)
+			{
+				sf->setValue(i, static_cast<ScalarType>(i & 0xFFFF));
+				highSF->setValue(i, static_cast<ScalarType>(i >> 16));
+			}
+			sf->computeMinAndMax();
+			sf->setStorage(ccScalarField::Storage::ForRange(0, 0xFFFF));
+			highSF->computeMinAndMax();
+			highSF->setStorage(ccScalarField::Storage::ForRange(0, (pointCount - 1) >> 16));
 		}
 		else
 		{
-			//if there was no scalar field before
-			if (sfCount == 0)
+			for (unsigned i = 0; i < pointCount; ++i)
 			{
-				//and if the added cloud has one displayed
-				const ccScalarField* dispSF = addedCloud->getCurrentDisplayedScalarField();
-				if (dispSF)
-				{
-					//we set it as displayed on the current cloud also
-					int sfIdx = getScalarFieldIndexByName(dispSF->getName()); //same name!
-					setCurrentDisplayedScalarField(sfIdx);
-				}
+				sf->setValue(i, static_cast<ScalarType>(i));
 			}
-
-			//merge display parameters
-			showSF(sfShown() || addedCloud->sfShown());
+			sf->computeMinAndMax();
+			sf->setStorage(ccScalarField::Storage::ForRange(0, pointCount - 1));
 		}
 	}
 
-	//if the merged cloud has grid structures AND this one is blank or also has grid structures
-	if (addedCloud->gridCount() != 0 && (gridCount() != 0 || pointCountBefore == 0))
+	if (!permutePoints(permutation))
 	{
-		//copy the grid structures
-		for (size_t i = 0; i < addedCloud->gridCount(); ++i)
+		//delete the last one first (so that the other index remains valid)
+		if (originalIndexesHighSFIdx >= 0)
 		{
-			const Grid::Shared& otherGrid = addedCloud->grid(i);
-			if (otherGrid && otherGrid->validCount != 0) //no need to copy empty grids!
-			{
-				try
-				{
-					//copy the grid data
-					Grid::Shared grid(new Grid(*otherGrid));
-					{
-						//then update the indexes
-						unsigned cellCount = grid->w*grid->h;
-						int* _gridIndex = grid->indexes.data();
-						for (size_t j = 0; j < cellCount; ++j, ++_gridIndex)
-						{
-							if (*_gridIndex >= 0)
-							{
-								//shift the index
-								*_gridIndex += static_cast<int>(pointCountBefore);
-							}
-						}
+			deleteScalarField(originalIndexesHighSFIdx);
+		}
+		if (originalIndexesSFIdx >= 0)
+		{
+			deleteScalarField(originalIndexesSFIdx);
+		}
+		return false;
+	}
 
-						//don't forget to shift the boundaries as well
-						grid->minValidIndex += pointCountBefore;
-						grid->maxValidIndex += pointCountBefore;
-					}
+	return true;
+}
 
-					addGrid(grid);
-				}
-				catch (const std::bad_alloc&)
-				{
-					//not enough memory
-					m_grids.resize(0);
-					ccLog::Warning(QString("[ccPointCloud::fusion] Not enough memory: failed to copy the grid structure(s) from '%1'").arg(addedCloud->getName()));
-					break;
-				}
-			}
-			else
-			{
-				assert(otherGrid);
-			}
-		}
+bool ccPointCloud::restoreOriginalPointOrder()
+{
+	int sfIdx = getScalarFieldIndexByName(OriginalIndexesSFName());
+	if (sfIdx < 0)
+	{
+		ccLog::Warning(QString("[ccPointCloud] Cloud '%1' has no '%2' scalar field: can't restore the original order of its points").arg(getName(), OriginalIndexesSFName()));
+		return false;
 	}
-	else if (gridCount() != 0) //otherwise we'll have to drop the former grid structures!
+	const CCCoreLib::ScalarField* sf = getScalarField(sfIdx);
+
+	//the higher bits of the indexes, if they were split (see reorderPoints)
+	int highSFIdx = getScalarFieldIndexByName(OriginalIndexesHighSFName());
+	const CCCoreLib::ScalarField* highSF = (highSFIdx >= 0 ? getScalarField(highSFIdx) : nullptr);
+
+	//we sort the points by original index (so that it also works with subsets or merged clouds)
+	unsigned pointCount = size();
+	std::vector< std::pair<uint64_t, unsigned> > keys;
+	std::vector<unsigned> permutation;
+	try
 	{
-		ccLog::Warning(QString("[ccPointCloud::fusion] Grid structure(s) will be dropped as the merged cloud is unstructured"));
-		m_grids.resize(0);
+		keys.resize(pointCount);
+		permutation.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[ccPointCloud::restoreOriginalPointOrder] Not enough memory");
+		return false;
 	}
 
-	//has the cloud been recentered/rescaled?
+	for (unsigned i = 0; i < pointCount; ++i)
 	{
-		if (addedCloud->isShifted())
+		ScalarType value = sf->getValue(i);
+		if (!ccScalarField::ValidValue(value))
 		{
-			if (!isShifted())
-			{
-				//we can keep the global shift information of the merged cloud
-				copyGlobalShiftAndScale(*addedCloud);
-			}
-			else if (	getGlobalScale() != addedCloud->getGlobalScale()
-					||	(getGlobalShift() - addedCloud->getGlobalShift()).norm2d() > 1.0e-6)
-			{
-				//the clouds have different shift & scale information!
-				ccLog::Warning(QString("[ccPointCloud::fusion] Global shift/scale information conflict: shift/scale of cloud '%1' will be ignored!").arg(addedCloud->getName()));
-			}
+			keys[i].first = std::numeric_limits<uint64_t>::max();
+		}
+		else if (highSF)
+		{
+			ScalarType highValue = highSF->getValue(i);
+			keys[i].first = (ccScalarField::ValidValue(highValue) ? (static_cast<uint64_t>(highValue) << 16) + static_cast<uint64_t>(value) : std::numeric_limits<uint64_t>::max());
+		}
+		else
+		{
+			keys[i].first = static_cast<uint64_t>(value);
 		}
+		keys[i].second = i;
 	}
-
-	//children (not yet reserved)
-	if (!ignoreChildren)
+	std::sort(keys.begin(), keys.end());
+	for (unsigned i = 0; i < pointCount; ++i)
 	{
-		unsigned childrenCount = addedCloud->getChildrenNumber();
-		for (unsigned c = 0; c < childrenCount; ++c)
-		{
-			ccHObject* child = addedCloud->getChild(c);
-			if (!child)
-			{
-				assert(false);
-				continue;
-			}
-			if (child->isA(CC_TYPES::MESH)) //mesh --> FIXME: what for the other types of MESH?
-			{
-				ccMesh* mesh = static_cast<ccMesh*>(child);
-
-				//detach from father?
-				//addedCloud->detachChild(mesh);
-				//ccGenericMesh* addedTri = mesh;
+		permutation[i] = keys[i].second;
+	}
+	keys.clear();
+	keys.shrink_to_fit();
 
-				//or clone?
-				ccMesh* cloneMesh = mesh->cloneMesh(mesh->getAssociatedCloud() == addedCloud ? this : nullptr);
-				if (cloneMesh)
-				{
-					//change mesh vertices
-					if (cloneMesh->getAssociatedCloud() == this)
-					{
-						cloneMesh->shiftTriangleIndexes(pointCountBefore);
-					}
-					addChild(cloneMesh);
-				}
-				else
-				{
-					ccLog::Warning(QString("[ccPointCloud::fusion] Not enough memory: failed to clone sub mesh %1!").arg(mesh->getName()));
-				}
-			}
-			else if (child->isKindOf(CC_TYPES::IMAGE))
-			{
-				//ccImage* image = static_cast<ccImage*>(child);
+	if (!permutePoints(permutation))
+	{
+		return false;
+	}
 
-				//DGM FIXME: take image ownership! (dirty)
-				addedCloud->transferChild(child, *this);
-			}
-			else if (child->isA(CC_TYPES::LABEL_2D))
-			{
-				//clone label and update points if necessary
-				cc2DLabel* label = static_cast<cc2DLabel*>(child);
-				cc2DLabel* newLabel = new cc2DLabel(label->getName());
-				for (unsigned j = 0; j < label->size(); ++j)
-				{
-					cc2DLabel::PickedPoint P = label->getPickedPoint(j);
-					if (P._cloud == addedCloud)
-					{
-						P._cloud = this;
-						P.index += pointCountBefore;
-					}
-					newLabel->addPickedPoint(P);
-				}
-				newLabel->displayPointLegend(label->isPointLegendDisplayed());
-				newLabel->setDisplayedIn2D(label->isDisplayedIn2D());
-				newLabel->setCollapsed(label->isCollapsed());
-				newLabel->setPosition(label->getPosition()[0], label->getPosition()[1]);
-				newLabel->setVisible(label->isVisible());
-				newLabel->setDisplay(getDisplay());
-				addChild(newLabel);
-			}
-			else if (child->isA(CC_TYPES::GBL_SENSOR))
-			{
-				//copy sensor object
-				ccGBLSensor* sensor = new ccGBLSensor(*static_cast<ccGBLSensor*>(child));
-				addChild(sensor);
-				sensor->setDisplay(getDisplay());
-				sensor->setVisible(child->isVisible());
-			}
+	//delete the last one first (so that the other index remains valid)
+	if (highSFIdx > sfIdx)
+	{
+		deleteScalarField(highSFIdx);
+		deleteScalarField(sfIdx);
+	}
+	else
+	{
+		deleteScalarField(sfIdx);
+		if (highSFIdx >= 0)
+		{
+			deleteScalarField(highSFIdx);
 		}
 	}
 
-	//We should update the VBOs (just in case)
-	releaseVBOs();
-	//As well as the LOD structure
-	clearLOD();
-
-	return *this;
+	return true;
 }
 
 void ccPointCloud::unallocateNorms()
@@ -3308,24 +4377,39 @@ ccGenericPointCloud* ccPointCloud::createNewCloudFromVisibilitySelection(bool re
 	//shall the visible points be erased from this cloud?
 	if (removeSelectedPoints && !isLocked())
 	{
+		unsigned count = size();
+
+		//list of the remaining (non visible) points
+		std::vector<unsigned> keptIndexes;
+		try
+		{
+			keptIndexes.reserve(count - result->size());
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning(QString("[Cloud %1] Not enough memory to remove the selected points").arg(getName()));
+			return result;
+		}
+		for (unsigned i = 0; i < count; ++i)
+		{
+			if ((*visTable)[i] != CCCoreLib::POINT_VISIBLE)
+			{
+				keptIndexes.push_back(i);
+			}
+		}
+
 		//we drop the octree before modifying this cloud's contents
 		deleteOctree();
 		clearLOD();
 
-		unsigned count = size();
-
 		//we have to take care of scan grids first
 		{
 			//we need a map between old and new indexes
 			std::vector<int> newIndexMap(size(), -1);
 			{
-				unsigned newIndex = 0;
-				for (unsigned i = 0; i < count; ++i)
+				for (size_t i = 0; i < keptIndexes.size(); ++i)
 				{
-					if (m_pointsVisibility[i] != CCCoreLib::POINT_VISIBLE)
-					{
-						newIndexMap[i] = newIndex++;
-					}
+					newIndexMap[keptIndexes[i]] = static_cast<int>(i);
 				}
 			}
 
@@ -3343,25 +4427,35 @@ ccGenericPointCloud* ccPointCloud::createNewCloudFromVisibilitySelection(bool re
 			}
 		}
 
-		//we remove all visible points
-		unsigned lastPoint = 0;
-		for (unsigned i = 0; i < count; ++i)
+		//we remove all visible points (the attributes are compacted in place, in parallel)
 		{
-			if (m_pointsVisibility[i] != CCCoreLib::POINT_VISIBLE)
+			GatherEngine gather(keptIndexes, true);
+			gather.add(m_points.data(), m_points.data());
+			if (hasColors())
 			{
-				if (i != lastPoint)
-				{
-					swapPoints(lastPoint, i);
-				}
-				++lastPoint;
+				gather.add(m_rgbaColors->data(), m_rgbaColors->data());
+			}
+			if (hasNormals())
+			{
+				gather.add(m_normals->data(), m_normals->data());
+			}
+			if (hasFWF())
+			{
+				gather.add(m_fwfWaveforms.data(), m_fwfWaveforms.data());
+			}
+			for (unsigned k = 0; k < getNumberOfScalarFields(); ++k)
+			{
+				CCCoreLib::ScalarField* sf = getScalarField(static_cast<int>(k));
+				gather.add(sf->data(), sf->data());
 			}
+			gather.run();
 		}
 
 		unallocateVisibilityArray();
 
 		//TODO: handle associated meshes
 
-		resize(lastPoint);
+		resize(static_cast<unsigned>(keptIndexes.size()));
 		
 		refreshBB(); //calls notifyGeometryUpdate + releaseVBOs
 	}
@@ -5521,7 +6615,8 @@ bool ccPointCloud::orientNormalsTowardViewPoint( CCVector3 & VP, ccProgressDialo
 bool ccPointCloud::computeNormalsWithOctree(CCCoreLib::LOCAL_MODEL_TYPES model,
 											ccNormalVectors::Orientation preferredOrientation,
 											PointCoordinateType defaultRadius,
-											ccProgressDialog* pDlg/*=0*/)
+											ccProgressDialog* pDlg/*=0*/,
+											unsigned kNN/*=0*/)
 {
 	//compute the normals the 'old' way ;)
 	if (!getOctree())
@@ -5534,6 +6629,7 @@ bool ccPointCloud::computeNormalsWithOctree(CCCoreLib::LOCAL_MODEL_TYPES model,
 	}
 
 	//computes cloud normals
+	//(they are directly oriented and compressed by ComputeCloudNormals)
 	QElapsedTimer eTimer;
 	eTimer.start();
 	NormsIndexesTableType* normsIndexes = new NormsIndexesTableType;
@@ -5543,40 +6639,25 @@ bool ccPointCloud::computeNormalsWithOctree(CCCoreLib::LOCAL_MODEL_TYPES model,
 												defaultRadius,
 												preferredOrientation,
 												static_cast<CCCoreLib::GenericProgressCallback*>(pDlg),
-												getOctree().data()))
+												getOctree().data(),
+												kNN))
 	{
 		ccLog::Warning(QString("[computeNormals] Failed to compute normals on cloud '%1'").arg(getName()));
+		normsIndexes->release();
 		return false;
 	}
 	
 	ccLog::Print("[ComputeCloudNormals] Timing: %3.2f s.", eTimer.elapsed() / 1000.0);
 
-	if (!hasNormals())
-	{
-		if (!resizeTheNormsTable())
-		{
-			ccLog::Error(QString("Not enough memory to compute normals on cloud '%1'").arg(getName()));
-			normsIndexes->release();
-			return false;
-		}
-	}
-
-	//we hide normals during process
-	showNormals(false);
-
-	//compress the normals
+	if (normsIndexes->size() != size())
 	{
-		for (unsigned j = 0; j < normsIndexes->currentSize(); j++)
-		{
-			setPointNormalIndex(j, normsIndexes->getValue(j));
-		}
+		ccLog::Warning(QString("[computeNormals] Inconsistent number of normals computed on cloud '%1'").arg(getName()));
+		normsIndexes->release();
+		return false;
 	}
 
-	//we don't need this anymore...
-	normsIndexes->release();
-	normsIndexes = nullptr;
-
-	//we restore the normals
+	//no need to copy the normals one by one, the computed table simply replaces the current one
+	setNormsTable(normsIndexes);
 	showNormals(true);
 
 	return true;
@@ -18,164 +18,166 @@
 #include "ccPointCloudInterpolator.h"
 
 //qCC_db
+#include "ccOctree.h"
+#include "ccParallelFor.h"
 #include "ccPointCloud.h"
+#include "ccScalarField.h"
 
 //CCCoreLib
 #include <DgmOctree.h>
-#include <DistanceComputationTools.h>
 #include <GenericProgressCallback.h>
-#include <ccScalarField.h>
 
-struct SFPair
+//system
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	//! Number of destination points processed by each parallel job
+	static const unsigned s_chunkSize = 4096;
+
+	//! Per-thread buffers (to avoid reallocating them for each job)
+	struct InterpolationBuffers
+	{
+		CCCoreLib::DgmOctree::NeighboursSet neighbours;
+		std::vector<double> sumValues;
+		std::vector<ScalarType> values;
+	};
+	static thread_local InterpolationBuffers s_buffers;
+
+	//! Interpolation job (range of destination points)
+	struct InterpolationChunk
+	{
+		unsigned begin = 0;
+		unsigned end = 0;
+		//! Min and max values of each output scalar field (for this range)
+		std::vector<ScalarType> minValues, maxValues;
+	};
+}
+
+ccPointCloudInterpolator::Engine::Engine()
+	: m_srcCloud(nullptr)
+	, m_octreeLevel(0)
 {
-	SFPair(const CCCoreLib::ScalarField* sfIn = nullptr, CCCoreLib::ScalarField* sfOut = nullptr) : in(sfIn), out(sfOut) {}
-	const CCCoreLib::ScalarField* in;
-	CCCoreLib::ScalarField* out;
-};
-
-bool cellSFInterpolator(const CCCoreLib::DgmOctree::octreeCell& cell,
-						void** additionalParameters,
-						CCCoreLib::NormalizedProgress* nProgress/*=0*/)
+}
+
+bool ccPointCloudInterpolator::Engine::setSource(	ccPointCloud* srcCloud,
+													const std::vector<int>& sfIndexes,
+													const Parameters& params,
+													CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
+													unsigned char octreeLevel/*=0*/)
 {
-	//additional parameters
-//	const ccPointCloud* srcCloud = reinterpret_cast<ccPointCloud*>(additionalParameters[0]);
-	const CCCoreLib::DgmOctree* srcOctree = reinterpret_cast<CCCoreLib::DgmOctree*>(additionalParameters[1]);
-	std::vector<SFPair>* scalarFields = reinterpret_cast<std::vector< SFPair >*>(additionalParameters[2]);
-	const ccPointCloudInterpolator::Parameters* params = reinterpret_cast<const ccPointCloudInterpolator::Parameters*>(additionalParameters[3]);
-	
-	bool normalDistWeighting = false;
-	double interpSigma2x2 = 0;
-	if (params->algo == ccPointCloudInterpolator::Parameters::NORMAL_DIST)
+	m_srcCloud = nullptr;
+	m_srcSFs.clear();
+	m_sfNames.clear();
+	m_octree.clear();
+
+	if (!srcCloud || srcCloud->size() == 0 || srcCloud->getNumberOfScalarFields() == 0 || sfIndexes.empty())
 	{
-		interpSigma2x2 = 2 * params->sigma * params->sigma;
-		normalDistWeighting = (interpSigma2x2 > 0);
+		ccLog::Warning("[Interpolation] Invalid/empty source cloud");
+		return false;
 	}
 
-	//structure for nearest neighbors search
-	bool useKNN = (params->method == ccPointCloudInterpolator::Parameters::K_NEAREST_NEIGHBORS);
-	CCCoreLib::DgmOctree::NearestNeighboursSphericalSearchStruct nNSS;
+	if ((params.method == Parameters::K_NEAREST_NEIGHBORS && params.knn == 0) ||
+		(params.method == Parameters::RADIUS && params.radius <= 0))
 	{
-		nNSS.level = cell.level;
-		if (useKNN)
-		{
-			nNSS.minNumberOfNeighbors = params->knn;
-		}
-		cell.parentOctree->getCellPos(cell.truncatedCode, cell.level, nNSS.cellPos, true);
-		cell.parentOctree->computeCellCenter(nNSS.cellPos, cell.level, nNSS.cellCenter);
+		//invalid input
+		ccLog::Warning("[Interpolation] Invalid input");
+		assert(false);
+		return false;
 	}
 
-	std::vector<double> sumValues;
-	size_t sfCount = scalarFields->size();
-	assert(sfCount != 0);
-	sumValues.resize(sfCount);
-
-	//for each point of the current cell (destination octree) we look for its nearest neighbours in the source cloud
-	unsigned pointCount = cell.points->size();
-	for (unsigned i = 0; i < pointCount; i++)
+	try
 	{
-		unsigned outPointIndex = cell.points->getPointGlobalIndex(i);
-		cell.points->getPoint(i, nNSS.queryPoint);
-
-		//look for neighbors (either inside a sphere or the k nearest ones)
-		//warning: there may be more points at the end of nNSS.pointsInNeighbourhood than the actual nearest neighbors (neighborCount)!
-		unsigned neighborCount = 0;
+		m_srcSFs.reserve(sfIndexes.size());
+		m_sfNames.reserve(sfIndexes.size());
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[Interpolation] Not enough memory");
+		return false;
+	}
 
-		if (useKNN)
-		{
-			neighborCount = srcOctree->findNearestNeighborsStartingFromCell(nNSS);
-			neighborCount = std::min(neighborCount, params->knn);
-		}
-		else
+	for (int sfIndex : sfIndexes)
+	{
+		if (sfIndex < 0 || sfIndex >= static_cast<int>(srcCloud->getNumberOfScalarFields()))
 		{
-			neighborCount = srcOctree->findNeighborsInASphereStartingFromCell(nNSS, params->radius, false);
+			//invalid index
+			ccLog::Warning(QString("[Interpolation] Source cloud has no scalar field with index #%1").arg(sfIndex));
+			assert(false);
+			m_srcSFs.clear();
+			m_sfNames.clear();
+			return false;
 		}
+		m_srcSFs.push_back(srcCloud->getScalarField(sfIndex));
+		m_sfNames.push_back(QByteArray(srcCloud->getScalarFieldName(sfIndex)));
+	}
 
-		if (neighborCount)
-		{
-			if (params->algo == ccPointCloudInterpolator::Parameters::MEDIAN)
-			{
-				//median
-				std::vector<ScalarType> values;
-				values.resize(neighborCount);
-				unsigned medianIndex = std::max(neighborCount / 2, 1u) - 1;
-
-				for (unsigned j = 0; j < sfCount; ++j)
-				{
-					const CCCoreLib::ScalarField* sf = scalarFields->at(j).in;
-					for (unsigned k = 0; k < neighborCount; ++k)
-					{
-						CCCoreLib::DgmOctree::PointDescriptor& P = nNSS.pointsInNeighbourhood[k];
-						values[k] = sf->getValue(P.pointIndex);
-					}
-					std::sort(values.begin(), values.end());
-					
-					ScalarType median = values[medianIndex];
-					scalarFields->at(j).out->setValue(outPointIndex, median);
-				}
-			}
-			else //average or weighted average
-			{
-				double sumW = 0;
-				std::fill(sumValues.begin(), sumValues.end(), 0);
-				for (unsigned k = 0; k < neighborCount; ++k)
-				{
-					CCCoreLib::DgmOctree::PointDescriptor& P = nNSS.pointsInNeighbourhood[k];
-					double w = 1.0;
-					if (normalDistWeighting)
-					{
-						w = exp(-P.squareDistd / interpSigma2x2);
-					}
-					sumW += w;
-					for (unsigned j = 0; j < sfCount; ++j)
-					{
-						sumValues[j] += w * scalarFields->at(j).in->getValue(P.pointIndex);
-					}
-				}
-
-				if (sumW > 0)
-				{
-					for (unsigned j = 0; j < sfCount; ++j)
-					{
-						ScalarType s = static_cast<ScalarType>(sumValues[j] / sumW);
-						scalarFields->at(j).out->setValue(outPointIndex, s);
-					}
-				}
-				else
-				{
-					//we assume the scalar fields have all been initialized to CCCoreLib::NAN_VALUE
-				}
-			}
-		}
-		else
+	//we reuse the source octree if it already exists (and we keep it for the next time otherwise)
+	ccOctree::Shared octree = srcCloud->getOctree();
+	if (!octree)
+	{
+		octree = srcCloud->computeOctree(progressCb);
+		if (!octree)
 		{
-			//we assume the scalar fields have all been initialized to CCCoreLib::NAN_VALUE
+			ccLog::Warning("[Interpolation] Failed to compute the source octree (not enough memory?)");
+			m_srcSFs.clear();
+			m_sfNames.clear();
+			return false;
 		}
+	}
 
-		if (nProgress && !nProgress->oneStep())
+	if (octreeLevel == 0)
+	{
+		switch (params.method)
 		{
-			return false;
+		case Parameters::NEAREST_NEIGHBOR:
+			octreeLevel = octree->findBestLevelForAGivenPopulationPerCell(3);
+			break;
+		case Parameters::K_NEAREST_NEIGHBORS:
+			octreeLevel = octree->findBestLevelForAGivenPopulationPerCell(params.knn);
+			break;
+		case Parameters::RADIUS:
+			octreeLevel = octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(params.radius);
+			break;
 		}
 	}
 
+	m_srcCloud = srcCloud;
+	m_params = params;
+	m_octree = octree;
+	m_octreeLevel = octreeLevel;
+
 	return true;
 }
 
-bool ccPointCloudInterpolator::InterpolateScalarFieldsFrom(	ccPointCloud* destCloud,
-															ccPointCloud* srcCloud,
-															const std::vector<int>& inSFIndexes,
-															const Parameters& params,
-															CCCoreLib::GenericProgressCallback* progressCb/*=0*/,
-															unsigned char octreeLevel/*=0*/)
+bool ccPointCloudInterpolator::Engine::interpolateTo(	ccPointCloud* destCloud,
+														CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/) const
 {
-	if (!destCloud || !srcCloud || srcCloud->size() == 0 || srcCloud->getNumberOfScalarFields() == 0)
+	if (!m_srcCloud || !m_octree)
 	{
-		ccLog::Warning("[InterpolateScalarFieldsFrom] Invalid/empty input cloud(s)!");
+		ccLog::Warning("[Interpolation] No source cloud set");
+		assert(false);
+		return false;
+	}
+	if (!destCloud || destCloud->size() == 0)
+	{
+		ccLog::Warning("[Interpolation] Invalid/empty destination cloud");
+		return false;
+	}
+	if (	m_params.algo == Parameters::NORMAL_DIST
+		&&	m_params.method != Parameters::NEAREST_NEIGHBOR
+		&&	m_params.sigma <= 0)
+	{
+		ccLog::Warning("[Interpolation] Invalid sigma value for the Gaussian kernel");
 		return false;
 	}
 
 	//check that both bounding boxes intersect!
 	ccBBox box = destCloud->getOwnBB();
-	ccBBox otherBox = srcCloud->getOwnBB();
+	ccBBox otherBox = m_srcCloud->getOwnBB();
 
 	CCVector3 dimSum = box.getDiagVec() + otherBox.getDiagVec();
 	CCVector3 dist = box.getCenter() - otherBox.getCenter();
@@ -183,41 +185,24 @@ bool ccPointCloudInterpolator::InterpolateScalarFieldsFrom(	ccPointCloud* destCl
 		||	std::abs(dist.y) > dimSum.y / 2
 		||	std::abs(dist.z) > dimSum.z / 2)
 	{
-		ccLog::Warning("[InterpolateScalarFieldsFrom] Clouds are too far from each other! Can't proceed.");
+		ccLog::Warning("[Interpolation] Clouds are too far from each other! Can't proceed.");
 		return false;
 	}
 
-	//now copy the scalar fields
+	//retrieve or create the output scalar fields
+	//(no need to initialize them, all the values will be set by the interpolation)
 	bool overwrite = false;
-	std::vector< SFPair > scalarFields;
-	try
-	{
-		scalarFields.reserve(inSFIndexes.size());
-	}
-	catch (const std::bad_alloc&)
-	{
-		ccLog::Error("Not enough memory");
-		return false;
-	}
-	for (size_t i = 0; i < inSFIndexes.size(); ++i)
+	const size_t sfCount = m_srcSFs.size();
+	std::vector<CCCoreLib::ScalarField*> outSFs(sfCount, nullptr);
+	for (size_t j = 0; j < sfCount; ++j)
 	{
-		int inSFIndex = inSFIndexes[i];
-		if (inSFIndex < 0 || inSFIndex >= static_cast<int>(srcCloud->getNumberOfScalarFields()))
-		{
-			//invalid index
-			ccLog::Warning(QString("[InterpolateScalarFieldsFrom] Source cloud has no scalar field with index #%1").arg(inSFIndex));
-			assert(false);
-			return false;
-		}
-
-		const char* sfName = srcCloud->getScalarFieldName(inSFIndex);
-		int outSFIndex = destCloud->getScalarFieldIndexByName(sfName);
+		int outSFIndex = destCloud->getScalarFieldIndexByName(m_sfNames[j].constData());
 		if (outSFIndex < 0)
 		{
-			outSFIndex = destCloud->addScalarField(sfName);
+			outSFIndex = destCloud->addScalarField(m_sfNames[j].constData());
 			if (outSFIndex < 0)
 			{
-				ccLog::Error("Not enough memory!");
+				ccLog::Warning("[Interpolation] Not enough memory");
 				return false;
 			}
 		}
@@ -225,126 +210,278 @@ bool ccPointCloudInterpolator::InterpolateScalarFieldsFrom(	ccPointCloud* destCl
 		{
 			overwrite = true;
 		}
-
-		CCCoreLib::ScalarField* inSF = srcCloud->getScalarField(inSFIndex);
-		CCCoreLib::ScalarField* outSF = destCloud->getScalarField(outSFIndex);
-		scalarFields.push_back(SFPair(inSF, outSF));
-
-		outSF->fill(CCCoreLib::NAN_VALUE);
+		outSFs[j] = destCloud->getScalarField(outSFIndex);
 	}
 
-	if (params.method == Parameters::NEAREST_NEIGHBOR)
+	unsigned pointCount = destCloud->size();
+	std::vector<InterpolationChunk> chunks;
+	try
 	{
-		//compute the closest-point set of 'this cloud' relatively to 'input cloud'
-		//(to get a mapping between the resulting vertices and the input points)
-		QSharedPointer<CCCoreLib::ReferenceCloud> CPSet = destCloud->computeCPSet(*srcCloud, progressCb, octreeLevel);
-		if (!CPSet)
+		chunks.resize((pointCount + s_chunkSize - 1) / s_chunkSize);
+		for (size_t c = 0; c < chunks.size(); ++c)
 		{
-			return false;
+			chunks[c].begin = static_cast<unsigned>(c * s_chunkSize);
+			chunks[c].end = std::min(chunks[c].begin + s_chunkSize, pointCount);
+			chunks[c].minValues.resize(sfCount, std::numeric_limits<ScalarType>::max());
+			chunks[c].maxValues.resize(sfCount, std::numeric_limits<ScalarType>::lowest());
 		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[Interpolation] Not enough memory");
+		return false;
+	}
 
-		unsigned CPSetSize = CPSet->size();
-		assert(CPSetSize == destCloud->size());
-
-		//now copy the scalar fields
-		for (SFPair& sfPair : scalarFields)
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
 		{
-			for (unsigned i = 0; i < CPSetSize; ++i)
-			{
-				unsigned pointIndex = CPSet->getPointGlobalIndex(i);
-				sfPair.out->setValue(i, sfPair.in->getValue(pointIndex));
-			}
+			progressCb->setMethodTitle("Scalar field interpolation");
+			progressCb->setInfo(qPrintable(QString("Points: %1\nScalar fields: %2").arg(pointCount).arg(sfCount)));
 		}
+		progressCb->update(0);
+		progressCb->start();
 	}
-	else
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(chunks.size()));
+
+	const Parameters& params = m_params;
+	const CCCoreLib::DgmOctree* octree = m_octree.data();
+	const unsigned char level = m_octreeLevel;
+	const std::vector<const CCCoreLib::ScalarField*>& srcSFs = m_srcSFs;
+
+	const unsigned knn = (params.method == Parameters::NEAREST_NEIGHBOR ? 1 : params.knn);
+	const bool useSphere = (params.method == Parameters::RADIUS);
+	const Parameters::Algo algo = (params.method == Parameters::NEAREST_NEIGHBOR ? Parameters::AVERAGE : params.algo);
+	const double interpSigma2x2 = 2.0 * params.sigma * params.sigma;
+	const bool normalDistWeighting = (algo == Parameters::NORMAL_DIST && interpSigma2x2 > 0);
+	const bool inverseDistWeighting = (algo == Parameters::INVERSE_DIST);
+	const double halfPower = params.power / 2; //we work with squared distances
+
+	std::atomic<bool> cancelled(false);
+	std::atomic<bool> memoryError(false);
+
+	ccParallel::For(static_cast<int>(chunks.size()), [&](int chunkIndex)
 	{
-		if ((params.method == Parameters::K_NEAREST_NEIGHBORS && params.knn == 0) ||
-			(params.method == Parameters::RADIUS && params.radius <= 0))
+		if (cancelled || memoryError)
 		{
-			//invalid input
-			ccLog::Warning("[InterpolateScalarFieldsFrom] Invalid input");
-			assert(false);
-			return false;
+			return;
 		}
 
-		assert(srcCloud && destCloud);
-
-		//we spatially 'synchronize' the octrees
-		CCCoreLib::DgmOctree *_srcOctree = nullptr;
-		CCCoreLib::DgmOctree *_destOctree = nullptr;
-		CCCoreLib::DistanceComputationTools::SOReturnCode soCode = CCCoreLib::DistanceComputationTools::synchronizeOctrees(
-			srcCloud,
-			destCloud,
-			_srcOctree,
-			_destOctree,
-			/*maxSearchDist*/0,
-			progressCb);
-		
-		QScopedPointer<CCCoreLib::DgmOctree> srcOctree(_srcOctree);
-		QScopedPointer<CCCoreLib::DgmOctree> destOctree(_destOctree);
-
-		if (soCode != CCCoreLib::DistanceComputationTools::SYNCHRONIZED)
-		{
-			//not enough memory (or invalid input)
-			ccLog::Warning("[InterpolateScalarFieldsFrom] Failed to build the octrees");
-			return false;
-		}
+		InterpolationChunk& chunk = chunks[chunkIndex];
+		InterpolationBuffers& buffers = s_buffers;
 
-		if (octreeLevel == 0)
-		{
-			if (params.method == ccPointCloudInterpolator::Parameters::K_NEAREST_NEIGHBORS)
-			{
-				octreeLevel = srcOctree->findBestLevelForAGivenPopulationPerCell(params.knn);
-			}
-			else
-			{
-				octreeLevel = srcOctree->findBestLevelForAGivenNeighbourhoodSizeExtraction(params.radius);
-			}
-		}
+		CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
+		nNSS.level = level;
+		nNSS.minNumberOfNeighbors = knn;
+		//we use the (persistent) per-thread buffer
+		nNSS.pointsInNeighbourhood.swap(buffers.neighbours);
+		nNSS.pointsInNeighbourhood.clear();
+		bool hasCell = false;
 
 		try
 		{
-			//additional parameters
-			void* additionalParameters[] = {	reinterpret_cast<void*>(srcCloud),
-												reinterpret_cast<void*>(srcOctree.data()),
-												reinterpret_cast<void*>(&scalarFields),
-												(void*)(&params)
-			};
-
-			if (destOctree->executeFunctionForAllCellsAtLevel(	octreeLevel,
-																cellSFInterpolator,
-																additionalParameters,
-																true,
-																progressCb,
-																"Scalar field interpolation",
-																0) == 0)
+			buffers.sumValues.resize(sfCount);
+
+			for (unsigned i = chunk.begin; i < chunk.end; ++i)
 			{
-				//something went wrong
-				ccLog::Warning("[InterpolateScalarFieldsFrom] Failed to perform the interpolation");
-				return false;
+				const CCVector3* P = destCloud->getPoint(i);
+				nNSS.queryPoint = *P;
+
+				//the neighbourhood extracted for the previous point can be reused if the query point lies in the same cell
+				Tuple3i cellPos;
+				octree->getTheCellPosWhichIncludesThePoint(P, cellPos, level);
+				if (!hasCell || cellPos.x != nNSS.cellPos.x || cellPos.y != nNSS.cellPos.y || cellPos.z != nNSS.cellPos.z)
+				{
+					nNSS.cellPos = cellPos;
+					octree->computeCellCenter(nNSS.cellPos, level, nNSS.cellCenter);
+					nNSS.pointsInNeighbourhood.clear();
+					nNSS.alreadyVisitedNeighbourhoodSize = 0;
+					hasCell = true;
+				}
+
+				//look for neighbors (either inside a sphere or the k nearest ones)
+				//warning: there may be more points at the end of nNSS.pointsInNeighbourhood than the actual nearest neighbors (neighborCount)!
+				unsigned neighborCount = 0;
+				if (useSphere)
+				{
+					neighborCount = octree->findNeighborsInASphereStartingFromCell(nNSS, params.radius, false);
+				}
+				else
+				{
+					neighborCount = octree->findNearestNeighborsStartingFromCell(nNSS, false);
+					neighborCount = std::min(neighborCount, knn);
+				}
+
+				if (neighborCount == 0)
+				{
+					for (size_t j = 0; j < sfCount; ++j)
+					{
+						outSFs[j]->setValue(i, CCCoreLib::NAN_VALUE);
+					}
+					continue;
+				}
+
+				if (algo == Parameters::MEDIAN)
+				{
+					buffers.values.resize(neighborCount);
+					unsigned medianIndex = std::max(neighborCount / 2, 1u) - 1;
+
+					for (size_t j = 0; j < sfCount; ++j)
+					{
+						const CCCoreLib::ScalarField* sf = srcSFs[j];
+						for (unsigned k = 0; k < neighborCount; ++k)
+						{
+							buffers.values[k] = sf->getValue(nNSS.pointsInNeighbourhood[k].pointIndex);
+						}
+						std::nth_element(buffers.values.begin(), buffers.values.begin() + medianIndex, buffers.values.end());
+						ScalarType median = buffers.values[medianIndex];
+
+						outSFs[j]->setValue(i, median);
+						if (CCCoreLib::ScalarField::ValidValue(median))
+						{
+							chunk.minValues[j] = std::min(chunk.minValues[j], median);
+							chunk.maxValues[j] = std::max(chunk.maxValues[j], median);
+						}
+					}
+				}
+				else //average or weighted average
+				{
+					const CCCoreLib::DgmOctree::PointDescriptor* exactMatch = nullptr;
+					double sumW = 0;
+					std::fill(buffers.sumValues.begin(), buffers.sumValues.end(), 0.0);
+					for (unsigned k = 0; k < neighborCount; ++k)
+					{
+						const CCCoreLib::DgmOctree::PointDescriptor& Q = nNSS.pointsInNeighbourhood[k];
+						double w = 1.0;
+						if (normalDistWeighting)
+						{
+							w = exp(-Q.squareDistd / interpSigma2x2);
+						}
+						else if (inverseDistWeighting)
+						{
+							if (Q.squareDistd <= 0)
+							{
+								//the query point coincides with a source point
+								exactMatch = &Q;
+								break;
+							}
+							w = 1.0 / pow(Q.squareDistd, halfPower);
+						}
+						sumW += w;
+						for (size_t j = 0; j < sfCount; ++j)
+						{
+							buffers.sumValues[j] += w * srcSFs[j]->getValue(Q.pointIndex);
+						}
+					}
+
+					for (size_t j = 0; j < sfCount; ++j)
+					{
+						ScalarType s = CCCoreLib::NAN_VALUE;
+						if (exactMatch)
+						{
+							s = srcSFs[j]->getValue(exactMatch->pointIndex);
+						}
+						else if (sumW > 0)
+						{
+							s = static_cast<ScalarType>(buffers.sumValues[j] / sumW);
+						}
+
+						outSFs[j]->setValue(i, s);
+						if (CCCoreLib::ScalarField::ValidValue(s))
+						{
+							chunk.minValues[j] = std::min(chunk.minValues[j], s);
+							chunk.maxValues[j] = std::max(chunk.maxValues[j], s);
+						}
+					}
+				}
 			}
 		}
 		catch (const std::bad_alloc&)
 		{
-			//not enough memory
-			ccLog::Warning("[InterpolateScalarFieldsFrom] Not enough memory");
-			return false;
+			memoryError = true;
+		}
+
+		//give the buffer back to the thread
+		nNSS.pointsInNeighbourhood.swap(buffers.neighbours);
+
+		if (!nProgress.oneStep())
+		{
+			cancelled = true;
 		}
+	});
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (memoryError)
+	{
+		ccLog::Warning("[Interpolation] Not enough memory");
+		return false;
+	}
+	if (cancelled)
+	{
+		ccLog::Warning("[Interpolation] Process cancelled by the user");
+		return false;
 	}
 
-	//now copy the scalar fields
-	for (SFPair& sfPair : scalarFields)
+	//reduce the min and max values (no need for another pass on the scalar fields)
+	for (size_t j = 0; j < sfCount; ++j)
 	{
-		sfPair.out->computeMinAndMax();
+		ScalarType minVal = std::numeric_limits<ScalarType>::max();
+		ScalarType maxVal = std::numeric_limits<ScalarType>::lowest();
+		for (const InterpolationChunk& chunk : chunks)
+		{
+			minVal = std::min(minVal, chunk.minValues[j]);
+			maxVal = std::max(maxVal, chunk.maxValues[j]);
+		}
+		if (minVal > maxVal)
+		{
+			//no valid value
+			minVal = maxVal = 0;
+		}
+
+		ccScalarField* ccSF = dynamic_cast<ccScalarField*>(outSFs[j]);
+		if (ccSF)
+		{
+			ccSF->setMinAndMax(minVal, maxVal);
+		}
+		else
+		{
+			outSFs[j]->computeMinAndMax();
+		}
 	}
 
 	if (overwrite)
 	{
-		ccLog::Warning("[InterpolateScalarFieldsFrom] Some scalar fields with the same names have been overwritten");
+		ccLog::Warning("[Interpolation] Some scalar fields with the same names have been overwritten");
 	}
 
 	//We must update the VBOs
 	destCloud->colorsHaveChanged();
-	
+
 	return true;
 }
+
+bool ccPointCloudInterpolator::InterpolateScalarFieldsFrom(	ccPointCloud* destCloud,
+															ccPointCloud* srcCloud,
+															const std::vector<int>& inSFIndexes,
+															const Parameters& params,
+															CCCoreLib::GenericProgressCallback* progressCb/*=0*/,
+															unsigned char octreeLevel/*=0*/)
+{
+	if (!destCloud || !srcCloud || srcCloud->size() == 0 || srcCloud->getNumberOfScalarFields() == 0)
+	{
+		ccLog::Warning("[InterpolateScalarFieldsFrom] Invalid/empty input cloud(s)!");
+		return false;
+	}
+
+	Engine engine;
+	if (!engine.setSource(srcCloud, inSFIndexes, params, progressCb, octreeLevel))
+	{
+		return false;
+	}
+
+	return engine.interpolateTo(destCloud, progressCb);
+}
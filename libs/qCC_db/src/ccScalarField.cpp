@@ -23,14 +23,186 @@
 //CCCoreLib
 #include <CCConst.h>
 
+//Qt
+#include <QFile>
+
 //system
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 using namespace CCCoreLib;
 
 //! Default number of classes for associated histogram
 const unsigned MAX_HISTOGRAM_SIZE = 512;
 
+namespace
+{
+	//! Number of values (de)coded at once when the values are checked or serialized
+	constexpr size_t c_compactBlockSize = (1 << 16);
+
+	//! Converts a 32 bits floating point value to a half precision one (round to nearest even)
+	inline uint16_t FloatToHalf(float value)
+	{
+		static const uint32_t f32Infinity = 255u << 23;
+		static const uint32_t f16Max = (127u + 16u) << 23;
+		static const uint32_t denormMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+		uint32_t bits = 0;
+		memcpy(&bits, &value, sizeof(float));
+		uint32_t sign = bits & 0x80000000u;
+		bits ^= sign;
+
+		uint16_t half = 0;
+		if (bits >= f16Max) //overflow (infinity) or NaN
+		{
+			half = (bits > f32Infinity ? 0x7E00 : 0x7C00);
+		}
+		else if (bits < (113u << 23)) //denormalized values (or 0)
+		{
+			float denormMagic = 0.0f;
+			memcpy(&denormMagic, &denormMagicBits, sizeof(float));
+			float f = 0.0f;
+			memcpy(&f, &bits, sizeof(float));
+			f += denormMagic;
+			memcpy(&bits, &f, sizeof(float));
+			half = static_cast<uint16_t>(bits - denormMagicBits);
+		}
+		else //normalized values
+		{
+			uint32_t mantissaOdd = (bits >> 13) & 1;
+			bits += ((15u - 127u) << 23) + 0xFFFu;
+			bits += mantissaOdd;
+			half = static_cast<uint16_t>(bits >> 13);
+		}
+
+		return half | static_cast<uint16_t>(sign >> 16);
+	}
+
+	//! Converts a half precision floating point value to a 32 bits one
+	inline float HalfToFloat(uint16_t half)
+	{
+		static const uint32_t shiftedExponent = 0x7C00u << 13;
+		static const uint32_t magicBits = 113u << 23;
+
+		uint32_t bits = (half & 0x7FFFu) << 13;
+		uint32_t exponent = shiftedExponent & bits;
+		bits += (127u - 15u) << 23;
+
+		if (exponent == shiftedExponent) //infinity or NaN
+		{
+			bits += (128u - 16u) << 23;
+		}
+		else if (exponent == 0) //denormalized values (or 0)
+		{
+			bits += 1u << 23;
+			float f = 0.0f, magic = 0.0f;
+			memcpy(&f, &bits, sizeof(float));
+			memcpy(&magic, &magicBits, sizeof(float));
+			f -= magic;
+			memcpy(&bits, &f, sizeof(float));
+		}
+
+		bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+
+		float value = 0.0f;
+		memcpy(&value, &bits, sizeof(float));
+		return value;
+	}
+
+	//! Quantizes values (the values outside of the storage range are clamped)
+	template <typename CodeType> void EncodeQuantized(const ScalarType* values, size_t count, double scale, double offset, CodeType* codes)
+	{
+		const double maxCode = static_cast<double>(std::numeric_limits<CodeType>::max());
+		for (size_t i = 0; i < count; ++i)
+		{
+			double code = std::round((values[i] - offset) / scale);
+			codes[i] = static_cast<CodeType>(std::max(0.0, std::min(code, maxCode)));
+		}
+	}
+
+	//! Dequantizes values
+	template <typename CodeType> void DecodeQuantized(const CodeType* codes, size_t count, double scale, double offset, ScalarType* values)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = static_cast<ScalarType>(offset + scale * codes[i]);
+		}
+	}
+
+	//! Saves compact values to a file (same layout as ccSerializationHelper::GenericArrayToFile)
+	bool CompactValuesToFile(const std::vector<ScalarType>& values, const ccScalarField::Storage& storage, QFile& out)
+	{
+		//component count
+		::uint8_t componentCount = 1;
+		if (out.write((const char*)&componentCount, 1) < 0)
+			return false;
+
+		//element count
+		::uint32_t elementCount = static_cast<::uint32_t>(values.size());
+		if (out.write((const char*)&elementCount, 4) < 0)
+			return false;
+
+		//encoded values (by blocks)
+		const size_t bytesPerValue = storage.bytesPerValue();
+		std::vector<char> codes;
+		try
+		{
+			codes.resize(std::min(values.size(), c_compactBlockSize) * bytesPerValue);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < values.size(); i += c_compactBlockSize)
+		{
+			size_t count = std::min(c_compactBlockSize, values.size() - i);
+			ccScalarField::Encode(storage, values.data() + i, count, codes.data());
+			if (out.write(codes.data(), static_cast<qint64>(count * bytesPerValue)) < 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	//! Loads compact values from a file (see CompactValuesToFile)
+	bool CompactValuesFromFile(std::vector<ScalarType>& values, const ccScalarField::Storage& storage, QFile& in)
+	{
+		::uint8_t componentCount = 0;
+		if (in.read((char*)&componentCount, 1) < 0)
+			return ccSerializableObject::ReadError();
+		::uint32_t elementCount = 0;
+		if (in.read((char*)&elementCount, 4) < 0)
+			return ccSerializableObject::ReadError();
+		if (componentCount != 1)
+			return ccSerializableObject::CorruptError();
+
+		const size_t bytesPerValue = storage.bytesPerValue();
+		std::vector<char> codes;
+		try
+		{
+			values.resize(elementCount);
+			codes.resize(std::min(values.size(), c_compactBlockSize) * bytesPerValue);
+		}
+		catch (const std::bad_alloc&)
+		{
+			return ccSerializableObject::MemoryError();
+		}
+
+		//decoded values (by blocks)
+		for (size_t i = 0; i < values.size(); i += c_compactBlockSize)
+		{
+			size_t count = std::min(c_compactBlockSize, values.size() - i);
+			if (in.read(codes.data(), static_cast<qint64>(count * bytesPerValue)) < 0)
+				return ccSerializableObject::ReadError();
+			ccScalarField::Decode(storage, codes.data(), count, values.data() + i);
+		}
+
+		return true;
+	}
+}
+
 ccScalarField::ccScalarField(const char* name/*=0*/)
 	: ScalarField(name)
 	, m_showNaNValuesInGrey(true)
@@ -60,6 +232,7 @@ ccScalarField::ccScalarField(const ccScalarField& sf)
 	, m_histogram(sf.m_histogram)
 	, m_modified(sf.m_modified)
 	, m_globalShift(sf.m_globalShift)
+	, m_storage(sf.m_storage)
 {
 	computeMinAndMax();
 }
@@ -164,6 +337,20 @@ void ccScalarField::computeMinAndMax()
 {
 	ScalarField::computeMinAndMax();
 
+	minAndMaxHaveChanged();
+}
+
+void ccScalarField::setMinAndMax(ScalarType minVal, ScalarType maxVal)
+{
+	assert(minVal <= maxVal);
+	m_minVal = minVal;
+	m_maxVal = maxVal;
+
+	minAndMaxHaveChanged();
+}
+
+void ccScalarField::minAndMaxHaveChanged()
+{
 	m_displayRange.setBounds(m_minVal, m_maxVal);
 
 	//update histogram
@@ -188,7 +375,7 @@ void ccScalarField::computeMinAndMax()
 			}
 			catch (const std::bad_alloc&)
 			{
-				ccLog::Warning("[ccScalarField::computeMinAndMax] Failed to update associated histogram!");
+				ccLog::Warning("[ccScalarField] Failed to update associated histogram!");
 				m_histogram.clear();
 			}
 
@@ -325,9 +512,35 @@ bool ccScalarField::toFile(QFile& out) const
 	if (out.write(m_name,256) < 0)
 		return WriteError();
 
+	//compact storage (dataVersion>=53)
+	Storage storage;
+	if (ccSerializationContext::DataVersion() >= 53)
+	{
+		//only the preferred storage is used (if it is lossless)
+		if (m_storage.type != StorageType::NATIVE && isLosslessWith(m_storage))
+		{
+			storage = m_storage;
+		}
+
+		uint8_t storageType = static_cast<uint8_t>(storage.type);
+		if (out.write((const char*)&storageType, 1) < 0)
+			return WriteError();
+		if (out.write((const char*)&storage.scale, sizeof(double)) < 0)
+			return WriteError();
+		if (out.write((const char*)&storage.offset, sizeof(double)) < 0)
+			return WriteError();
+	}
+
 	//data (dataVersion>=20)
-	if (!ccSerializationHelper::GenericArrayToFile<ScalarType, 1, ScalarType>(*this, out))
+	if (storage.type == StorageType::NATIVE)
+	{
+		if (!ccSerializationHelper::GenericArrayToFile<ScalarType, 1, ScalarType>(*this, out))
+			return WriteError();
+	}
+	else if (!CompactValuesToFile(*this, storage, out)) //dataVersion>=53 (see above)
+	{
 		return WriteError();
+	}
 
 	//displayed values & saturation boundaries (dataVersion>=20)
 	double dValue = (double)m_displayRange.start();
@@ -407,8 +620,31 @@ bool ccScalarField::fromFile(QFile& in, short dataVersion, int flags, LoadedIDMa
 			return ReadError();
 	}
 
+	//compact storage (dataVersion >= 53)
+	Storage storage;
+	if (dataVersion >= 53)
+	{
+		uint8_t storageType = 0;
+		if (in.read((char*)&storageType, 1) < 0)
+			return ReadError();
+		if (storageType > static_cast<uint8_t>(StorageType::FLOAT16))
+			return CorruptError();
+		storage.type = static_cast<StorageType>(storageType);
+		if (in.read((char*)&storage.scale, sizeof(double)) < 0)
+			return ReadError();
+		if (in.read((char*)&storage.offset, sizeof(double)) < 0)
+			return ReadError();
+	}
+	m_storage = storage;
+
 	//data (dataVersion >= 20)
 	bool result = false;
+	if (storage.type != StorageType::NATIVE)
+	{
+		//compact values (dataVersion >= 53)
+		result = CompactValuesFromFile(*this, storage, in);
+	}
+	else
 	{
 		bool fileScalarIsFloat = (flags & ccSerializableObject::DF_SCALAR_VAL_32_BITS);
 		if (fileScalarIsFloat && sizeof(ScalarType) == 8) //file is 'float' and current type is 'double'
@@ -657,4 +893,217 @@ void ccScalarField::importParametersFrom(const ccScalarField* sf)
 	setMaxDisplayed(sf->displayRange().stop());
 	setSaturationStart(sf->saturationRange().start());
 	setSaturationStop(sf->saturationRange().stop());
+	setStorage(sf->getStorage());
+}
+
+size_t ccScalarField::Storage::bytesPerValue() const
+{
+	switch (type)
+	{
+	case StorageType::UINT8:
+		return 1;
+	case StorageType::UINT16:
+	case StorageType::FLOAT16:
+		return 2;
+	case StorageType::NATIVE:
+	default:
+		return sizeof(ScalarType);
+	}
+}
+
+QString ccScalarField::Storage::description() const
+{
+	QString str;
+	switch (type)
+	{
+	case StorageType::UINT8:
+		str = "uint8";
+		break;
+	case StorageType::UINT16:
+		str = "uint16";
+		break;
+	case StorageType::FLOAT16:
+		return "float16";
+	case StorageType::NATIVE:
+	default:
+		return (sizeof(ScalarType) == 8 ? "float64" : "float32");
+	}
+
+	if (scale != 1.0 || offset != 0.0)
+	{
+		str += QString(" (scale %1, offset %2)").arg(scale).arg(offset);
+	}
+	return str;
+}
+
+ccScalarField::Storage ccScalarField::Storage::ForRange(double minValue, double maxValue, double scale/*=1.0*/)
+{
+	Storage storage;
+	if (scale > 0 && maxValue >= minValue)
+	{
+		double maxCode = std::round((maxValue - minValue) / scale);
+		if (maxCode <= std::numeric_limits<uint8_t>::max())
+		{
+			storage.type = StorageType::UINT8;
+		}
+		else if (maxCode <= std::numeric_limits<uint16_t>::max())
+		{
+			storage.type = StorageType::UINT16;
+		}
+		else
+		{
+			//too many values
+			return storage;
+		}
+		storage.scale = scale;
+		storage.offset = minValue;
+	}
+	return storage;
+}
+
+bool ccScalarField::isLosslessWith(const Storage& storage) const
+{
+	if (storage.type == StorageType::NATIVE)
+	{
+		return true;
+	}
+	if (storage.type != StorageType::FLOAT16 && storage.scale <= 0)
+	{
+		return false;
+	}
+
+	//we encode and decode the values (by blocks) and check that they are unchanged
+	std::vector<char> codes;
+	std::vector<ScalarType> decoded;
+	try
+	{
+		size_t blockSize = std::min(size(), c_compactBlockSize);
+		codes.resize(blockSize * storage.bytesPerValue());
+		decoded.resize(blockSize);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < size(); i += c_compactBlockSize)
+	{
+		size_t count = std::min(c_compactBlockSize, size() - i);
+		const ScalarType* values = data() + i;
+		Encode(storage, values, count, codes.data());
+		Decode(storage, codes.data(), count, decoded.data());
+		for (size_t j = 0; j < count; ++j)
+		{
+			if (values[j] != decoded[j] && !(std::isnan(values[j]) && std::isnan(decoded[j])))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+ccScalarField::Storage ccScalarField::getCompactStorage() const
+{
+	if (m_storage.type != StorageType::NATIVE && isLosslessWith(m_storage))
+	{
+		return m_storage;
+	}
+
+	if (empty())
+	{
+		return Storage();
+	}
+
+	//are all the values integers?
+	bool integerValues = true;
+	bool hasNaN = false;
+	ScalarType minValue = std::numeric_limits<ScalarType>::max();
+	ScalarType maxValue = std::numeric_limits<ScalarType>::lowest();
+	for (ScalarType value : *this)
+	{
+		if (std::isnan(value))
+		{
+			hasNaN = true;
+			break;
+		}
+		if (value != std::floor(value))
+		{
+			integerValues = false;
+			break;
+		}
+		minValue = std::min(minValue, value);
+		maxValue = std::max(maxValue, value);
+	}
+	if (integerValues && !hasNaN)
+	{
+		Storage storage = Storage::ForRange(minValue, maxValue);
+		if (storage.type != StorageType::NATIVE)
+		{
+			return storage;
+		}
+	}
+
+	//otherwise we can still try with half precision values
+	Storage halfStorage;
+	halfStorage.type = StorageType::FLOAT16;
+	if (isLosslessWith(halfStorage))
+	{
+		return halfStorage;
+	}
+
+	return Storage();
+}
+
+void ccScalarField::Encode(const Storage& storage, const ScalarType* values, size_t count, void* codes)
+{
+	switch (storage.type)
+	{
+	case StorageType::UINT8:
+		EncodeQuantized(values, count, storage.scale, storage.offset, static_cast<uint8_t*>(codes));
+		break;
+	case StorageType::UINT16:
+		EncodeQuantized(values, count, storage.scale, storage.offset, static_cast<uint16_t*>(codes));
+		break;
+	case StorageType::FLOAT16:
+	{
+		uint16_t* _codes = static_cast<uint16_t*>(codes);
+		for (size_t i = 0; i < count; ++i)
+		{
+			_codes[i] = FloatToHalf(static_cast<float>(values[i]));
+		}
+	}
+	break;
+	case StorageType::NATIVE:
+	default:
+		memcpy(codes, values, count * sizeof(ScalarType));
+		break;
+	}
+}
+
+void ccScalarField::Decode(const Storage& storage, const void* codes, size_t count, ScalarType* values)
+{
+	switch (storage.type)
+	{
+	case StorageType::UINT8:
+		DecodeQuantized(static_cast<const uint8_t*>(codes), count, storage.scale, storage.offset, values);
+		break;
+	case StorageType::UINT16:
+		DecodeQuantized(static_cast<const uint16_t*>(codes), count, storage.scale, storage.offset, values);
+		break;
+	case StorageType::FLOAT16:
+	{
+		const uint16_t* _codes = static_cast<const uint16_t*>(codes);
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = static_cast<ScalarType>(HalfToFloat(_codes[i]));
+		}
+	}
+	break;
+	case StorageType::NATIVE:
+	default:
+		memcpy(values, codes, count * sizeof(ScalarType));
+		break;
+	}
 }
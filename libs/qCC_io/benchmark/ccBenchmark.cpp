@@ -0,0 +1,184 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: CloudCompare project                               #
+//#                                                                        #
+//##########################################################################
+
+#include "ccBenchmark.h"
+
+//Qt
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+//system
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+double ccBenchmark::Result::min_s() const
+{
+	return times_s.empty() ? 0.0 : *std::min_element(times_s.begin(), times_s.end());
+}
+
+double ccBenchmark::Result::median_s() const
+{
+	if (times_s.empty())
+	{
+		return 0.0;
+	}
+
+	std::vector<double> sorted = times_s;
+	std::sort(sorted.begin(), sorted.end());
+	size_t half = sorted.size() / 2;
+	return (sorted.size() % 2) ? sorted[half] : (sorted[half - 1] + sorted[half]) / 2;
+}
+
+double ccBenchmark::Result::mean_s() const
+{
+	return times_s.empty() ? 0.0 : std::accumulate(times_s.begin(), times_s.end(), 0.0) / times_s.size();
+}
+
+ccBenchmark::ccBenchmark(unsigned repetitions, const QString& nameFilter/*=QString()*/)
+	: m_repetitions(std::max(1u, repetitions))
+	, m_nameFilter(nameFilter)
+{
+}
+
+bool ccBenchmark::isSelected(const QString& name) const
+{
+	return m_nameFilter.isEmpty() || name.contains(m_nameFilter, Qt::CaseInsensitive);
+}
+
+void ccBenchmark::run(	const QString& name,
+						size_t elementCount,
+						Step body,
+						Step setup/*=Step()*/,
+						Step teardown/*=Step()*/)
+{
+	if (!isSelected(name))
+	{
+		return;
+	}
+
+	Result result;
+	result.name = name;
+	result.elementCount = elementCount;
+	result.times_s.reserve(m_repetitions);
+
+	for (unsigned i = 0; i < m_repetitions; ++i)
+	{
+		if (setup && !setup())
+		{
+			result.error = "setup failed";
+			break;
+		}
+
+		QElapsedTimer timer;
+		timer.start();
+		bool success = body();
+		qint64 elapsed_ns = timer.nsecsElapsed();
+
+		if (teardown)
+		{
+			teardown();
+		}
+
+		if (!success)
+		{
+			result.error = "failed";
+			break;
+		}
+
+		result.times_s.push_back(elapsed_ns / 1.0e9);
+	}
+
+	if (result.error.isEmpty())
+	{
+		double median = result.median_s();
+		printf("%-32s %12.6f s %16.0f elements/s\n", qPrintable(name), median, median > 0 ? elementCount / median : 0.0);
+	}
+	else
+	{
+		printf("%-32s %s\n", qPrintable(name), qPrintable(result.error.toUpper()));
+	}
+	fflush(stdout);
+
+	m_results.push_back(result);
+}
+
+void ccBenchmark::skip(const QString& name, const QString& reason)
+{
+	if (!isSelected(name))
+	{
+		return;
+	}
+
+	Result result;
+	result.name = name;
+	result.skipped = true;
+	result.error = reason;
+	m_results.push_back(result);
+
+	printf("%-32s skipped (%s)\n", qPrintable(name), qPrintable(reason));
+	fflush(stdout);
+}
+
+bool ccBenchmark::saveJSON(const QString& filename, const QJsonObject& context) const
+{
+	QJsonArray benchmarks;
+	for (const Result& result : m_results)
+	{
+		QJsonObject benchmark;
+		benchmark["name"] = result.name;
+		if (result.skipped)
+		{
+			benchmark["skipped"] = result.error;
+		}
+		else if (!result.error.isEmpty())
+		{
+			benchmark["error"] = result.error;
+		}
+		else
+		{
+			double median = result.median_s();
+			benchmark["elements"] = static_cast<double>(result.elementCount);
+			benchmark["repetitions"] = static_cast<int>(result.times_s.size());
+			benchmark["min_s"] = result.min_s();
+			benchmark["median_s"] = median;
+			benchmark["mean_s"] = result.mean_s();
+			benchmark["elements_per_s"] = (median > 0 ? result.elementCount / median : 0.0);
+		}
+		benchmarks.append(benchmark);
+	}
+
+	QJsonObject root;
+	root["context"] = context;
+	root["benchmarks"] = benchmarks;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+	file.write(QJsonDocument(root).toJson());
+
+	return true;
+}
+
+unsigned ccBenchmark::failedCount() const
+{
+	return static_cast<unsigned>(std::count_if(m_results.begin(), m_results.end(), [](const Result& result) { return !result.skipped && !result.error.isEmpty(); }));
+}
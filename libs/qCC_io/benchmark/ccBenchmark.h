@@ -0,0 +1,108 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: CloudCompare project                               #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_BENCHMARK_HEADER
+#define CC_BENCHMARK_HEADER
+
+//Qt
+#include <QJsonObject>
+#include <QString>
+
+//system
+#include <functional>
+#include <vector>
+
+//! Minimal micro-benchmark harness
+/** Each benchmark is run several times: only the 'body' is timed (not the
+	'setup' and 'teardown' steps). The throughput is computed relatively to
+	the median time. The results can be saved as JSON so as to be tracked
+	across commits.
+**/
+class ccBenchmark
+{
+public:
+
+	//! Benchmark body, setup or teardown step (returns whether it succeeded)
+	using Step = std::function<bool()>;
+
+	//! Benchmark result
+	struct Result
+	{
+		//! Benchmark name (e.g. 'cloud.partialClone')
+		QString name;
+		//! Number of processed elements (points, triangles, etc.)
+		size_t elementCount = 0;
+		//! Measured times (in seconds, one per repetition)
+		std::vector<double> times_s;
+		//! Error (if any)
+		QString error;
+		//! Whether the benchmark has been skipped
+		bool skipped = false;
+
+		//! Returns the minimum time (in seconds)
+		double min_s() const;
+		//! Returns the median time (in seconds)
+		double median_s() const;
+		//! Returns the mean time (in seconds)
+		double mean_s() const;
+	};
+
+	//! Default constructor
+	/** \param repetitions number of repetitions of each benchmark
+		\param nameFilter only the benchmarks whose name contains this string are run (all if empty)
+	**/
+	ccBenchmark(unsigned repetitions, const QString& nameFilter = QString());
+
+	//! Returns whether a benchmark is selected (see the name filter)
+	bool isSelected(const QString& name) const;
+
+	//! Runs a benchmark
+	/** \param name benchmark name
+		\param elementCount number of processed elements (for the throughput)
+		\param body timed step
+		\param setup step executed before each repetition (not timed, optional)
+		\param teardown step executed after each repetition (not timed, optional)
+	**/
+	void run(	const QString& name,
+				size_t elementCount,
+				Step body,
+				Step setup = Step(),
+				Step teardown = Step());
+
+	//! Records a skipped benchmark (e.g. if a file format is not available)
+	void skip(const QString& name, const QString& reason);
+
+	//! Returns the results
+	inline const std::vector<Result>& results() const { return m_results; }
+
+	//! Saves the results (and the given context) as a JSON file
+	bool saveJSON(const QString& filename, const QJsonObject& context) const;
+
+	//! Returns the number of failed benchmarks
+	unsigned failedCount() const;
+
+protected:
+
+	//! Number of repetitions
+	unsigned m_repetitions;
+	//! Name filter
+	QString m_nameFilter;
+	//! Results
+	std::vector<Result> m_results;
+};
+
+#endif //CC_BENCHMARK_HEADER
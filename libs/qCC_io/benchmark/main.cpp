@@ -0,0 +1,500 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: CloudCompare project                               #
+//#                                                                        #
+//##########################################################################
+
+//Micro-benchmarks of the core data structures and of the I/O filters
+//
+//Usage: CCBenchmark [--points N] [--repetitions R] [--filter NAME] [--output results.json]
+//                   [--plugins DIR] [--revision ID]
+//
+//The clouds and meshes are generated (with a fixed seed) so that the results
+//only depend on the code and on the machine. The I/O filters of the plugins
+//(OBJ, STL, E57, etc.) are only benchmarked if the plugins directory is given.
+
+#include "ccBenchmark.h"
+
+//CCCoreLib
+#include <DistanceComputationTools.h>
+#include <ReferenceCloud.h>
+
+//qCC_db
+#include <ccGLMatrix.h>
+#include <ccMesh.h>
+#include <ccNormalVectors.h>
+#include <ccPointCloud.h>
+#include <ccPointCloudLOD.h>
+#include <ccRasterGrid.h>
+#include <ccScalarField.h>
+
+//qCC_io
+#include <FileIOFilter.h>
+
+//plugins
+#include <ccIOPluginInterface.h>
+
+//Qt
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QPluginLoader>
+#include <QScopedPointer>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+
+//system
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+//! Generates a synthetic cloud (noisy height field with colors and a scalar field)
+static ccPointCloud* GenerateCloud(unsigned pointCount, unsigned seed)
+{
+	QScopedPointer<ccPointCloud> cloud(new ccPointCloud("synthetic cloud"));
+	if (!cloud->reserve(pointCount) || !cloud->reserveTheRGBTable())
+	{
+		return nullptr;
+	}
+
+	ccScalarField* sf = new ccScalarField("intensity");
+	if (!sf->resizeSafe(pointCount))
+	{
+		sf->release();
+		return nullptr;
+	}
+
+	//the points cover a 100 x 100 square
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> xy(0.0f, 100.0f);
+	std::normal_distribution<float> noise(0.0f, 0.05f);
+
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		float x = xy(generator);
+		float y = xy(generator);
+		float z = 5.0f * std::sin(x / 10.0f) * std::cos(y / 10.0f) + noise(generator);
+		cloud->addPoint(CCVector3(x, y, z));
+
+		ColorCompType c = static_cast<ColorCompType>((z + 5.0f) * 25.0f);
+		cloud->addColor(c, c, ccColor::MAX - c);
+
+		sf->setValue(i, static_cast<ScalarType>(x + y));
+	}
+
+	sf->computeMinAndMax();
+	cloud->addScalarField(sf);
+
+	return cloud.take();
+}
+
+//! Generates a synthetic mesh (regular grid on a height field)
+static ccMesh* GenerateMesh(unsigned triangleCount)
+{
+	//(n-1)^2 cells, 2 triangles per cell
+	unsigned n = std::max(2u, static_cast<unsigned>(std::sqrt(triangleCount / 2.0)) + 1);
+
+	ccPointCloud* vertices = new ccPointCloud("vertices");
+	if (!vertices->reserve(n * n))
+	{
+		delete vertices;
+		return nullptr;
+	}
+	for (unsigned j = 0; j < n; ++j)
+	{
+		for (unsigned i = 0; i < n; ++i)
+		{
+			float x = i * 100.0f / (n - 1);
+			float y = j * 100.0f / (n - 1);
+			vertices->addPoint(CCVector3(x, y, 5.0f * std::sin(x / 10.0f) * std::cos(y / 10.0f)));
+		}
+	}
+
+	ccMesh* mesh = new ccMesh(vertices);
+	mesh->setName("synthetic mesh");
+	mesh->addChild(vertices);
+	if (!mesh->reserve(2 * (n - 1) * (n - 1)))
+	{
+		delete mesh;
+		return nullptr;
+	}
+	for (unsigned j = 0; j + 1 < n; ++j)
+	{
+		for (unsigned i = 0; i + 1 < n; ++i)
+		{
+			unsigned index = j * n + i;
+			mesh->addTriangle(index, index + 1, index + n);
+			mesh->addTriangle(index + 1, index + n + 1, index + n);
+		}
+	}
+
+	return mesh;
+}
+
+//! Loads the I/O filters of the plugins of a given directory
+static void LoadIOPlugins(const QString& path)
+{
+	QDir pluginsDir(path);
+	const QStringList fileNames = pluginsDir.entryList(QDir::Files);
+	for (const QString& fileName : fileNames)
+	{
+		QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
+		ccIOPluginInterface* ioPlugin = qobject_cast<ccIOPluginInterface*>(loader.instance());
+		if (!ioPlugin)
+		{
+			continue;
+		}
+
+		for (const FileIOFilter::Shared& filter : ioPlugin->getFilters())
+		{
+			if (filter)
+			{
+				FileIOFilter::Register(filter);
+			}
+		}
+	}
+}
+
+//! Benchmarks the save/load round-trip of an entity with the best I/O filter for a given extension
+static void RoundTrip(ccBenchmark& benchmark, ccHObject* entity, size_t elementCount, const QString& extension, const QString& entityType, const QDir& tempDir)
+{
+	QString baseName = QString("io.%1.%2").arg(extension, entityType);
+	if (!benchmark.isSelected(baseName))
+	{
+		return;
+	}
+
+	FileIOFilter::Shared filter = FileIOFilter::FindBestFilterForExtension(extension);
+	if (!filter || !filter->exportSupported())
+	{
+		benchmark.skip(baseName, QString("no I/O filter for '%1' files").arg(extension));
+		return;
+	}
+
+	QString filename = tempDir.absoluteFilePath(QString("%1_%2.%3").arg(entityType, filter->getFilterInfo().id, extension));
+
+	FileIOFilter::SaveParameters saveParameters;
+	saveParameters.alwaysDisplaySaveDialog = false;
+
+	benchmark.run(	baseName + ".save",
+					elementCount,
+					[&]() { return FileIOFilter::SaveToFile(entity, filename, saveParameters, filter) == CC_FERR_NO_ERROR; });
+
+	if (!QFileInfo::exists(filename))
+	{
+		return;
+	}
+
+	FileIOFilter::LoadParameters loadParameters;
+	loadParameters.alwaysDisplayLoadDialog = false;
+	loadParameters.shiftHandlingMode = ccGlobalShiftManager::NO_DIALOG;
+	loadParameters.parentWidget = nullptr;
+
+	benchmark.run(	baseName + ".load",
+					elementCount,
+					[&]()
+					{
+						CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+						ccHObject* loaded = FileIOFilter::LoadFromFile(filename, loadParameters, filter, result);
+						bool success = (loaded != nullptr && result == CC_FERR_NO_ERROR);
+						delete loaded;
+						return success;
+					});
+
+	QFile::remove(filename);
+}
+
+int main(int argc, char** argv)
+{
+#ifdef Q_OS_LINUX
+	//no need for a display on a plain Linux box
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY"))
+	{
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+#endif
+
+	//some I/O filters rely on widgets (even if their dialogs are not displayed)
+	QApplication app(argc, argv);
+
+	QCommandLineParser options;
+	options.setApplicationDescription("CloudCompare micro-benchmarks");
+	options.addHelpOption();
+	QCommandLineOption pointsOption("points", "Number of points of the synthetic clouds (and triangles of the synthetic meshes)", "count", "1000000");
+	QCommandLineOption repetitionsOption("repetitions", "Number of repetitions of each benchmark", "count", "5");
+	QCommandLineOption filterOption("filter", "Only run the benchmarks whose name contains this string", "name");
+	QCommandLineOption outputOption("output", "Output JSON file", "file");
+	QCommandLineOption pluginsOption("plugins", "Directory of the I/O plugins (OBJ, STL, E57, etc.)", "path");
+	QCommandLineOption revisionOption("revision", "Revision (e.g. commit hash) to store in the JSON file", "id");
+	options.addOptions({ pointsOption, repetitionsOption, filterOption, outputOption, pluginsOption, revisionOption });
+	options.process(app);
+
+	bool ok = false;
+	unsigned pointCount = options.value(pointsOption).toUInt(&ok);
+	if (!ok || pointCount < 16)
+	{
+		fprintf(stderr, "Invalid number of points\n");
+		return EXIT_FAILURE;
+	}
+	unsigned repetitions = options.value(repetitionsOption).toUInt(&ok);
+	if (!ok || repetitions == 0)
+	{
+		fprintf(stderr, "Invalid number of repetitions\n");
+		return EXIT_FAILURE;
+	}
+
+	FileIOFilter::InitInternalFilters();
+	if (options.isSet(pluginsOption))
+	{
+		LoadIOPlugins(options.value(pluginsOption));
+	}
+
+	QTemporaryDir tempDir;
+	if (!tempDir.isValid())
+	{
+		fprintf(stderr, "Failed to create a temporary directory\n");
+		return EXIT_FAILURE;
+	}
+
+	ccBenchmark benchmark(repetitions, options.value(filterOption));
+
+	QScopedPointer<ccPointCloud> cloud(GenerateCloud(pointCount, 0));
+	QScopedPointer<ccMesh> mesh(GenerateMesh(pointCount));
+	if (!cloud || !mesh)
+	{
+		fprintf(stderr, "Not enough memory to generate the synthetic entities\n");
+		return EXIT_FAILURE;
+	}
+	size_t triangleCount = mesh->size();
+
+	printf("%u point(s), %zu triangle(s), %u repetition(s)\n", pointCount, triangleCount, repetitions);
+
+	//point cloud
+	{
+		QScopedPointer<ccPointCloud> target;
+		auto newTarget = [&]() { target.reset(new ccPointCloud); return true; };
+
+		benchmark.run("cloud.reserve", pointCount, [&]() { return target->reserve(pointCount) && target->reserveTheRGBTable(); }, newTarget);
+
+		benchmark.run(	"cloud.append",
+						pointCount,
+						[&]()
+						{
+							for (unsigned i = 0; i < pointCount; ++i)
+							{
+								target->addPoint(*cloud->getPoint(i));
+								target->addColor(cloud->getPointColor(i));
+							}
+							return true;
+						},
+						[&]() { return newTarget() && target->reserve(pointCount) && target->reserveTheRGBTable(); });
+
+		CCCoreLib::ReferenceCloud selection(cloud.data());
+		if (selection.reserve(pointCount / 2))
+		{
+			for (unsigned i = 0; i < pointCount; i += 2)
+			{
+				selection.addPointIndex(i);
+			}
+			benchmark.run(	"cloud.partialClone",
+							selection.size(),
+							[&]()
+							{
+								ccPointCloud* clone = cloud->partialClone(&selection);
+								bool success = (clone != nullptr);
+								delete clone;
+								return success;
+							});
+		}
+
+		ccGLMatrix trans;
+		trans.initFromParameters(0.1f, CCVector3f(0, 0, 1), CCVector3f(1.0f, 2.0f, 3.0f));
+		benchmark.run(	"cloud.applyRigidTransformation",
+						pointCount,
+						[&]() { cloud->applyRigidTransformation(trans); return true; },
+						ccBenchmark::Step(),
+						[&]() { cloud->applyRigidTransformation(trans.inverse()); return true; });
+	}
+
+	//octree
+	benchmark.run(	"octree.build",
+					pointCount,
+					[&]() { return !cloud->computeOctree(nullptr, false).isNull(); },
+					[&]() { cloud->deleteOctree(); return true; });
+
+	//normals (with an already computed octree)
+	{
+		QScopedPointer<ccPointCloud> target(cloud->cloneThis());
+		if (target && !target->computeOctree(nullptr, false).isNull())
+		{
+			PointCoordinateType radius = ccNormalVectors::GuessNaiveRadius(target.data());
+			benchmark.run(	"normals.octree.LS",
+							pointCount,
+							[&]() { return target->computeNormalsWithOctree(CCCoreLib::LS, ccNormalVectors::PLUS_Z, radius); });
+		}
+		else
+		{
+			benchmark.skip("normals.octree.LS", "not enough memory");
+		}
+	}
+
+	//spatial order of the points (the synthetic points are generated in a random order)
+	{
+		QScopedPointer<ccPointCloud> target;
+		auto newTarget = [&]() { target.reset(cloud->cloneThis()); return !target.isNull(); };
+		auto deleteTarget = [&]() { target.reset(); return true; };
+
+		benchmark.run("cloud.reorderPoints.morton", pointCount, [&]() { return target->reorderPoints(ccPointCloud::SpatialOrder::MORTON); }, newTarget, deleteTarget);
+		benchmark.run("cloud.reorderPoints.hilbert", pointCount, [&]() { return target->reorderPoints(ccPointCloud::SpatialOrder::HILBERT); }, newTarget, deleteTarget);
+
+		//same algorithms on the same clouds, with the points in their original (random) order and in Hilbert order
+		QScopedPointer<ccPointCloud> randomCompared(cloud->cloneThis());
+		QScopedPointer<ccPointCloud> randomReference(GenerateCloud(pointCount, 1));
+		QScopedPointer<ccPointCloud> hilbertCompared(cloud->cloneThis());
+		QScopedPointer<ccPointCloud> hilbertReference(GenerateCloud(pointCount, 1));
+		if (	randomCompared && randomReference && hilbertCompared && hilbertReference
+			&&	hilbertCompared->reorderPoints(ccPointCloud::SpatialOrder::HILBERT)
+			&&	hilbertReference->reorderPoints(ccPointCloud::SpatialOrder::HILBERT) )
+		{
+			const char* orderNames[2] = { "random", "hilbert" };
+			ccPointCloud* compared[2] = { randomCompared.data(), hilbertCompared.data() };
+			ccPointCloud* reference[2] = { randomReference.data(), hilbertReference.data() };
+			for (int k = 0; k < 2; ++k)
+			{
+				ccPointCloud* comparedCloud = compared[k];
+				ccPointCloud* referenceCloud = reference[k];
+
+				benchmark.run(	QString("spatialOrder.c2c.%1").arg(orderNames[k]),
+								pointCount,
+								[&]()
+								{
+									CCCoreLib::DistanceComputationTools::Cloud2CloudDistancesComputationParams params;
+									return CCCoreLib::DistanceComputationTools::computeCloud2CloudDistances(comparedCloud, referenceCloud, params) >= 0;
+								},
+								[&]()
+								{
+									int sfIdx = comparedCloud->getScalarFieldIndexByName("C2C");
+									if (sfIdx < 0)
+									{
+										sfIdx = comparedCloud->addScalarField("C2C");
+									}
+									comparedCloud->setCurrentScalarField(sfIdx);
+									return sfIdx >= 0;
+								});
+
+				PointCoordinateType radius = ccNormalVectors::GuessNaiveRadius(comparedCloud);
+				benchmark.run(	QString("spatialOrder.normals.%1").arg(orderNames[k]),
+								pointCount,
+								[&]() { return comparedCloud->computeNormalsWithOctree(CCCoreLib::LS, ccNormalVectors::PLUS_Z, radius); },
+								[&]() { return !comparedCloud->computeOctree(nullptr, false).isNull(); },
+								[&]() { comparedCloud->deleteOctree(); return true; });
+			}
+		}
+		else
+		{
+			benchmark.skip("spatialOrder", "not enough memory");
+		}
+	}
+
+	//raster grid
+	{
+		const double gridStep = 0.5;
+		ccBBox box = cloud->getOwnBB();
+		unsigned gridWidth = 0;
+		unsigned gridHeight = 0;
+		ccRasterGrid::ComputeGridSize(2, box, gridStep, gridWidth, gridHeight);
+
+		ccRasterGrid grid;
+		benchmark.run(	"rasterGrid.fillWith",
+						pointCount,
+						[&]() { return grid.fillWith(cloud.data(), 2, ccRasterGrid::PROJ_AVERAGE_VALUE, false); },
+						[&]() { return grid.init(gridWidth, gridHeight, gridStep, CCVector3d::fromArray(box.minCorner().u)); },
+						[&]() { grid.clear(); return true; });
+	}
+
+	//LOD (with an already computed octree)
+	if (!cloud->computeOctree(nullptr, false).isNull())
+	{
+		QScopedPointer<ccPointCloudLOD> lod;
+		benchmark.run(	"lod.build",
+						pointCount,
+						[&]()
+						{
+							if (!lod->init(cloud.data()))
+							{
+								return false;
+							}
+							//the structure is built by a dedicated thread
+							ccPointCloudLOD::State state = lod->getState();
+							while (state != ccPointCloudLOD::INITIALIZED && state != ccPointCloudLOD::BROKEN)
+							{
+								QThread::usleep(100);
+								state = lod->getState();
+							}
+							return state == ccPointCloudLOD::INITIALIZED;
+						},
+						[&]() { lod.reset(new ccPointCloudLOD); return true; },
+						[&]() { lod.reset(); return true; });
+	}
+
+	//I/O round-trips
+	{
+		QDir dir(tempDir.path());
+		for (const QString& extension : { "bin", "ply", "asc", "shp", "e57" })
+		{
+			RoundTrip(benchmark, cloud.data(), pointCount, extension, "cloud", dir);
+		}
+		for (const QString& extension : { "bin", "ply", "obj", "stl" })
+		{
+			RoundTrip(benchmark, mesh.data(), triangleCount, extension, "mesh", dir);
+		}
+	}
+
+	if (options.isSet(outputOption))
+	{
+		QJsonObject context;
+		context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+		context["host"] = QSysInfo::machineHostName();
+		context["os"] = QSysInfo::prettyProductName();
+		context["architecture"] = QSysInfo::currentCpuArchitecture();
+		context["threads"] = QThread::idealThreadCount();
+		context["qt"] = QString(qVersion());
+#ifdef QT_DEBUG
+		context["build"] = "debug";
+#else
+		context["build"] = "release";
+#endif
+		context["points"] = static_cast<double>(pointCount);
+		context["triangles"] = static_cast<double>(triangleCount);
+		context["repetitions"] = static_cast<int>(repetitions);
+		if (options.isSet(revisionOption))
+		{
+			context["revision"] = options.value(revisionOption);
+		}
+
+		if (!benchmark.saveJSON(options.value(outputOption), context))
+		{
+			fprintf(stderr, "Failed to write '%s'\n", qPrintable(options.value(outputOption)));
+			return EXIT_FAILURE;
+		}
+	}
+
+	FileIOFilter::UnregisterAll();
+
+	return (benchmark.failedCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -40,6 +40,8 @@ public:
 	CC_FILE_ERROR loadFile(const QString& filename, ccHObject& container, LoadParameters& parameters) override;
 	bool canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
+	ChunkReader::Shared openChunkReader(const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error) override;
+	ChunkWriter::Shared openChunkWriter(const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error) override;
 
 	//! Loads a cloud from a QByteArray
 	CC_FILE_ERROR loadAsciiData(const QByteArray& data, QString sourceName, ccHObject& container, LoadParameters& parameters);
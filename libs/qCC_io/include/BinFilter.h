@@ -45,6 +45,15 @@ public:
 
 	//! new style BIN saving
 	static CC_FILE_ERROR SaveFileV2(QFile& out, ccHObject* object);
+
+	//! Sets whether the scalar fields are saved with their preferred compact storage (enabled by default)
+	/** The files are only saved with the version 5.3 if this option is enabled and if at least
+		one scalar field has a compact preferred storage (see ccScalarField::getStorage).
+		Otherwise they remain readable by the previous versions (5.2).
+	**/
+	static void SetCompactScalarFields(bool state);
+	//! Returns whether the scalar fields are saved with their preferred compact storage
+	static bool CompactScalarFields();
 };
 
 #endif //CC_BIN_FILTER_HEADER
@@ -20,6 +20,7 @@
 
 //qCC_db
 #include <ccHObject.h>
+#include <ccPointCloud.h>
 
 //local
 #include "ccGlobalShiftManager.h"
@@ -67,6 +68,11 @@ public:
 			, coordinatesShift(nullptr)
 			, preserveShiftOnSave(true)
 			, autoComputeNormals(false)
+			, weldMeshVertices(false)
+			, meshWeldingTolerance(0.0)
+			, reorderPoints(false)
+			, pointOrder(ccPointCloud::SpatialOrder::HILBERT)
+			, storeOriginalPointIndexes(false)
 			, parentWidget(nullptr)
 			, sessionStart(true)
 		{}
@@ -83,6 +89,16 @@ public:
 		bool preserveShiftOnSave;
 		//! Whether normals should be computed at loading time (if possible - e.g. for gridded clouds) or not
 		bool autoComputeNormals;
+		//! Whether the duplicated vertices of meshes should be welded at loading time (if supported by the filter)
+		bool weldMeshVertices;
+		//! Max distance between two mesh vertices to be welded (see weldMeshVertices)
+		double meshWeldingTolerance;
+		//! Whether the points of the loaded clouds should be reordered along a space filling curve (see ccPointCloud::reorderPoints)
+		bool reorderPoints;
+		//! Space filling curve used to reorder the points (see reorderPoints)
+		ccPointCloud::SpatialOrder pointOrder;
+		//! Whether the original point indexes should be stored in a scalar field when the points are reordered
+		bool storeOriginalPointIndexes;
 		//! Parent widget (if any)
 		QWidget* parentWidget;
 		//! Session start (whether the load action is the first of a session)
@@ -114,6 +130,18 @@ public: //public interface
 	
 	//! Returns whether this I/O filter can export files
 	QCC_IO_LIB_API bool exportSupported() const;
+
+	//! Returns whether this I/O filter can read and write point clouds chunk by chunk
+	/** See FilterFeature::Streaming, openChunkReader and openChunkWriter.
+		Supported by the ASCII and PLY filters, and by the LAS filter of the
+		qLASFWFIO plugin (the BIN filter reads and writes whole files).
+	**/
+	QCC_IO_LIB_API bool streamingSupported() const;
+
+	//! Returns whether this I/O filter can be used by several threads at the same time
+	/** I.e. it doesn't rely on any (mutable) static state. See FilterFeature::Reentrant.
+	**/
+	QCC_IO_LIB_API bool isReentrant() const;
 	
 	//! Returns the file filter(s) for this I/O filter
 	/** E.g. 'ASCII file (*.asc)'
@@ -163,6 +191,78 @@ public: //public interface (to be reimplemented by each I/O filter)
 		return CC_FERR_NOT_IMPLEMENTED;
 	}
 	
+	//! Chunked point cloud reader (see openChunkReader)
+	class ChunkReader
+	{
+	public:
+		//! Shared type
+		using Shared = QSharedPointer<ChunkReader>;
+
+		virtual ~ChunkReader() = default;
+
+		//! Reads the next chunk of points
+		/** All the chunks share the same attributes and the same Global Shift.
+			\param maxCount max number of points of the chunk
+			\param error error (CC_FERR_NO_ERROR if the end of the file is reached)
+			\return the chunk (or nullptr if the end of the file is reached, or if an error occurred)
+		**/
+		virtual ccPointCloud* readChunk(unsigned maxCount, CC_FILE_ERROR& error) = 0;
+	};
+
+	//! Chunked point cloud writer (see openChunkWriter)
+	class ChunkWriter
+	{
+	public:
+		//! Shared type
+		using Shared = QSharedPointer<ChunkWriter>;
+
+		virtual ~ChunkWriter() = default;
+
+		//! Writes a chunk of points
+		/** All the chunks must have the same attributes (as the first one).
+		**/
+		virtual CC_FILE_ERROR writeChunk(const ccPointCloud& chunk) = 0;
+
+		//! Finalizes the file (must be called once all the chunks have been written)
+		virtual CC_FILE_ERROR close() = 0;
+	};
+
+	//! Opens a file to read a point cloud chunk by chunk
+	/** Only for filters with the FilterFeature::Streaming feature.
+		\param filename file to read
+		\param parameters generic loading parameters
+		\param error error (if any)
+		\return the reader (or nullptr if an error occurred)
+	**/
+	virtual ChunkReader::Shared openChunkReader(const QString& filename,
+												LoadParameters& parameters,
+												CC_FILE_ERROR& error)
+	{
+		Q_UNUSED( filename );
+		Q_UNUSED( parameters );
+		
+		error = CC_FERR_NOT_IMPLEMENTED;
+		return ChunkReader::Shared(nullptr);
+	}
+
+	//! Opens a file to write a point cloud chunk by chunk
+	/** Only for filters with the FilterFeature::Streaming feature.
+		\param filename file to write
+		\param parameters generic saving parameters
+		\param error error (if any)
+		\return the writer (or nullptr if an error occurred)
+	**/
+	virtual ChunkWriter::Shared openChunkWriter(const QString& filename,
+												const SaveParameters& parameters,
+												CC_FILE_ERROR& error)
+	{
+		Q_UNUSED( filename );
+		Q_UNUSED( parameters );
+		
+		error = CC_FERR_NOT_IMPLEMENTED;
+		return ChunkWriter::Shared(nullptr);
+	}
+
 	//! Returns whether this I/O filter can save the specified type of entity
 	/** \param type entity type
 		\param multiple whether the filter can save multiple instances of this entity at once
@@ -284,6 +384,14 @@ public: //global filters registration mechanism
 	
 	//! Returns the best filter (presumably) to open a given file extension
 	QCC_IO_LIB_API static Shared FindBestFilterForExtension(const QString& ext);
+
+	//! Returns the best filter to read or write a given file extension chunk by chunk
+	/** See streamingSupported.
+		\param ext file extension
+		\param onImport whether the file will be read or written
+		\return the filter (or nullptr if no streaming filter handles this extension)
+	**/
+	QCC_IO_LIB_API static Shared FindStreamingFilterForExtension(const QString& ext, bool onImport);
 	
 	//! Type of a I/O filters container
 	using FilterContainer = std::vector<FileIOFilter::Shared>;
@@ -311,12 +419,14 @@ public:
 		BuiltIn = 0x0004,	//< Implemented in the core
 		
 		DynamicInfo = 0x0008,	//< FilterInfo cannot be set statically (this is used for internal consistency checking)
+		
+		Reentrant = 0x0010,		//< Several files can be loaded/saved concurrently (in different threads)
+		
+		Streaming = 0x0020,		//< Point clouds can be read/written chunk by chunk (see openChunkReader and openChunkWriter)
 	};
 	Q_DECLARE_FLAGS( FilterFeatures, FilterFeature )
 	
-protected:
-	static constexpr float DEFAULT_PRIORITY = 25.0f;
-
+	//! Static description of a filter
 	struct FilterInfo
 	{
 		//! ID used to uniquely identify the filter (not user-visible)
@@ -345,6 +455,14 @@ protected:
 		FilterFeatures features;
 	};
 	
+	//! Returns the static description of this filter
+	/** E.g. to describe the filter of a plugin without loading it (see ccPluginManager).
+	**/
+	QCC_IO_LIB_API const FilterInfo& getFilterInfo() const;
+	
+protected:
+	static constexpr float DEFAULT_PRIORITY = 25.0f;
+
 	QCC_IO_LIB_API explicit FileIOFilter( const FilterInfo &info );
 	
 	//! Allow import extensions to be set after construction
@@ -70,6 +70,8 @@ public:
 	
 	bool canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
+	ChunkReader::Shared openChunkReader(const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error) override;
+	ChunkWriter::Shared openChunkWriter(const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error) override;
 
 	//! Custom loading method
 	CC_FILE_ERROR loadFile(const QString& filename, const QString& textureFilename, ccHObject& container, LoadParameters& parameters);
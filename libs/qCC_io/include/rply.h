@@ -10,6 +10,7 @@
  *
  * Modifications:
  *	- DGM (25/01/06) - get_plystorage_mode method added
+ *	- ply_read_first_element_chunk method added (chunked reading)
  *
  * ---------------------------------------------------------------------- */
 
@@ -359,6 +360,18 @@ int ply_close(p_ply ply);
  * ---------------------------------------------------------------------- */
 int get_plystorage_mode(p_ply ply, e_ply_storage_mode *storage_mode);
 
+/* ----------------------------------------------------------------------
+ * Reads the next instances of the first element (chunk by chunk), calling
+ * the callbacks set with ply_set_read_cb. The other elements are not read.
+ *
+ * ply: handle returned by ply_open (the header must have been read)
+ * count: max number of instances to read
+ *
+ * Returns the number of instances read (0 once all the instances of the
+ * first element have been read), or -1 in case of error
+ * ---------------------------------------------------------------------- */
+long ply_read_first_element_chunk(p_ply ply, long count);
+
 #ifdef __cplusplus
 }
 #endif
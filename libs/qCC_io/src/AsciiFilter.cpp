@@ -93,7 +93,7 @@ AsciiFilter::AsciiFilter()
 					"asc",
 					QStringList{ GetFileFilter() },
 					QStringList{ GetFileFilter() },
-					Import | Export | BuiltIn
+					Import | Export | BuiltIn | Streaming
 					} )
 {
 }
@@ -111,6 +111,181 @@ bool AsciiFilter::canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) c
 	return false;
 }
 
+//! ASCII output format
+struct AsciiOutputFormat
+{
+	//! Separator
+	QChar separator = ' ';
+	//! Whether colors are saved as float values (between 0 and 1)
+	bool saveFloatColors = false;
+	//! Whether the alpha channel is saved
+	bool saveAlphaChannel = false;
+	//! Whether colors are written
+	bool writeColors = false;
+	//! Whether normals are written
+	bool writeNorms = false;
+	//! Written scalar fields
+	std::vector<ccScalarField*> scalarFields;
+
+	//! Sets the written attributes (depending on the cloud features)
+	void setCloud(const ccGenericPointCloud* cloud)
+	{
+		writeColors = cloud->hasColors();
+		writeNorms = cloud->hasNormals();
+		scalarFields.clear();
+		if (cloud->isKindOf(CC_TYPES::POINT_CLOUD))
+		{
+			const ccPointCloud* ccCloud = static_cast<const ccPointCloud*>(cloud);
+			for (unsigned i = 0; i < ccCloud->getNumberOfScalarFields(); ++i)
+				scalarFields.push_back(static_cast<ccScalarField*>(ccCloud->getScalarField(i)));
+		}
+	}
+};
+
+//! Returns the ASCII header line (columns names)
+static QString MakeHeaderLine(const AsciiOutputFormat& format)
+{
+	const QChar& separator = format.separator;
+
+	QString header("//");
+	header.append(AsciiHeaderColumns::X());
+	header.append(separator);
+	header.append(AsciiHeaderColumns::Y());
+	header.append(separator);
+	header.append(AsciiHeaderColumns::Z());
+
+	QString colorHeader;
+	if (format.writeColors)
+	{
+		colorHeader.append(separator);
+		colorHeader.append(format.saveFloatColors ? AsciiHeaderColumns::Rf() : AsciiHeaderColumns::R());
+		colorHeader.append(separator);
+		colorHeader.append(format.saveFloatColors ? AsciiHeaderColumns::Gf() : AsciiHeaderColumns::G());
+		colorHeader.append(separator);
+		colorHeader.append(format.saveFloatColors ? AsciiHeaderColumns::Bf() : AsciiHeaderColumns::B());
+		if (format.saveAlphaChannel)
+		{
+			colorHeader.append(separator);
+			colorHeader.append(format.saveFloatColors ? AsciiHeaderColumns::Af() : AsciiHeaderColumns::A());
+		}
+	}
+
+	if (!s_saveSFBeforeColor)
+	{
+		header.append(colorHeader);
+	}
+
+	//add each associated SF name
+	for (const ccScalarField* sf : format.scalarFields)
+	{
+		QString sfName(sf->getName());
+		sfName.replace(separator, '_');
+		header.append(separator);
+		header.append(sfName);
+	}
+
+	if (s_saveSFBeforeColor)
+	{
+		header.append(colorHeader);
+	}
+
+	if (format.writeNorms)
+	{
+		header.append(separator);
+		header.append(AsciiHeaderColumns::Nx());
+		header.append(separator);
+		header.append(AsciiHeaderColumns::Ny());
+		header.append(separator);
+		header.append(AsciiHeaderColumns::Nz());
+	}
+
+	return header;
+}
+
+//! Returns the ASCII line of a given point
+static QString MakePointLine(const ccGenericPointCloud& cloud, unsigned index, const AsciiOutputFormat& format)
+{
+	static const int s_normalPrecision = 2 + sizeof(PointCoordinateType);
+	const QChar& separator = format.separator;
+
+	//line for the current point
+	QString line;
+
+	//write current point coordinates
+	const CCVector3* P = cloud.getPoint(index);
+	CCVector3d Pglobal = cloud.toGlobal3d<PointCoordinateType>(*P);
+	line.append(QString::number(Pglobal.x, 'f', s_outputCoordPrecision));
+	line.append(separator);
+	line.append(QString::number(Pglobal.y, 'f', s_outputCoordPrecision));
+	line.append(separator);
+	line.append(QString::number(Pglobal.z, 'f', s_outputCoordPrecision));
+
+	QString colorLine;
+	if (format.writeColors)
+	{
+		//add rgb color
+		const ccColor::Rgba& col = cloud.getPointColor(index);
+		if (format.saveFloatColors)
+		{
+			colorLine.append(separator);
+			colorLine.append(QString::number(static_cast<double>(col.r) / ccColor::MAX));
+			colorLine.append(separator);
+			colorLine.append(QString::number(static_cast<double>(col.g) / ccColor::MAX));
+			colorLine.append(separator);
+			colorLine.append(QString::number(static_cast<double>(col.b) / ccColor::MAX));
+			if (format.saveAlphaChannel)
+			{
+				colorLine.append(separator);
+				colorLine.append(QString::number(static_cast<double>(col.a) / ccColor::MAX));
+			}
+		}
+		else
+		{
+			colorLine.append(separator);
+			colorLine.append(QString::number(col.r));
+			colorLine.append(separator);
+			colorLine.append(QString::number(col.g));
+			colorLine.append(separator);
+			colorLine.append(QString::number(col.b));
+			if (format.saveAlphaChannel)
+			{
+				colorLine.append(separator);
+				colorLine.append(QString::number(col.a));
+			}
+		}
+
+		if (!s_saveSFBeforeColor)
+		{
+			line.append(colorLine);
+		}
+	}
+
+	//add each associated SF values
+	for (const ccScalarField* sf : format.scalarFields)
+	{
+		line.append(separator);
+		double sfVal = sf->getGlobalShift() + sf->getValue(index);
+		line.append(QString::number(sfVal, 'f', s_outputSFPrecision));
+	}
+
+	if (format.writeColors && s_saveSFBeforeColor)
+		line.append(colorLine);
+
+	if (format.writeNorms)
+	{
+		//add normal vector
+		const CCVector3& N = cloud.getPointNormal(index);
+		line.append(separator);
+		line.append(QString::number(N.x, 'f', s_normalPrecision));
+		line.append(separator);
+		line.append(QString::number(N.y, 'f', s_normalPrecision));
+		line.append(separator);
+		line.append(QString::number(N.z, 'f', s_normalPrecision));
+	}
+
+	return line;
+}
+
 CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters)
 {
 	assert(entity && !filename.isEmpty());
@@ -216,18 +391,7 @@ CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename
 	QTextStream stream(&file);
 
 	ccGenericPointCloud* cloud = ccHObjectCaster::ToGenericPointCloud(entity);
-
 	unsigned numberOfPoints = cloud->size();
-	bool writeColors = cloud->hasColors();
-	bool writeNorms = cloud->hasNormals();
-	std::vector<ccScalarField*> theScalarFields;
-	if (cloud->isKindOf(CC_TYPES::POINT_CLOUD))
-	{
-		ccPointCloud* ccCloud = static_cast<ccPointCloud*>(cloud);
-		for (unsigned i = 0; i < ccCloud->getNumberOfScalarFields(); ++i)
-			theScalarFields.push_back(static_cast<ccScalarField*>(ccCloud->getScalarField(i)));
-	}
-	bool writeSF = (!theScalarFields.empty());
 
 	//progress dialog
 	QScopedPointer<ccProgressDialog> pDlg(nullptr);
@@ -241,73 +405,15 @@ CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename
 	CCCoreLib::NormalizedProgress nprogress(pDlg.data(), numberOfPoints);
 
 	//non static parameters
-	int normalPrecision = 2 + sizeof(PointCoordinateType);
-	QChar separator = saveDialog.getSeparator();
-	bool saveFloatColors = saveDialog.saveFloatColors();
-	bool saveAlphaChannel = saveDialog.saveAlphaChannel();
+	AsciiOutputFormat format;
+	format.separator = saveDialog.getSeparator();
+	format.saveFloatColors = saveDialog.saveFloatColors();
+	format.saveAlphaChannel = saveDialog.saveAlphaChannel();
+	format.setCloud(cloud);
 
 	if (s_saveColumnsNamesHeader)
 	{
-		QString header("//");
-		header.append(AsciiHeaderColumns::X());
-		header.append(separator);
-		header.append(AsciiHeaderColumns::Y());
-		header.append(separator);
-		header.append(AsciiHeaderColumns::Z());
-
-		if (writeColors && !s_saveSFBeforeColor)
-		{
-			header.append(separator);
-			header.append(saveFloatColors ? AsciiHeaderColumns::Rf() : AsciiHeaderColumns::R());
-			header.append(separator);
-			header.append(saveFloatColors ? AsciiHeaderColumns::Gf() : AsciiHeaderColumns::G());
-			header.append(separator);
-			header.append(saveFloatColors ? AsciiHeaderColumns::Bf() : AsciiHeaderColumns::B());
-			if (saveAlphaChannel)
-			{
-				header.append(separator);
-				header.append(saveFloatColors ? AsciiHeaderColumns::Af() : AsciiHeaderColumns::A());
-			}
-		}
-
-		if (writeSF)
-		{
-			//add each associated SF name
-			for (std::vector<ccScalarField*>::const_iterator it = theScalarFields.begin(); it != theScalarFields.end(); ++it)
-			{
-				QString sfName((*it)->getName());
-				sfName.replace(separator, '_');
-				header.append(separator);
-				header.append(sfName);
-			}
-		}
-
-		if (writeColors && s_saveSFBeforeColor)
-		{
-			header.append(separator);
-			header.append(saveFloatColors ? AsciiHeaderColumns::Rf() : AsciiHeaderColumns::R());
-			header.append(separator);
-			header.append(saveFloatColors ? AsciiHeaderColumns::Gf() : AsciiHeaderColumns::G());
-			header.append(separator);
-			header.append(saveFloatColors ? AsciiHeaderColumns::Bf() : AsciiHeaderColumns::B());
-			if (saveAlphaChannel)
-			{
-				header.append(separator);
-				header.append(saveFloatColors ? AsciiHeaderColumns::Af() : AsciiHeaderColumns::A());
-			}
-		}
-
-		if (writeNorms)
-		{
-			header.append(separator);
-			header.append(AsciiHeaderColumns::Nx());
-			header.append(separator);
-			header.append(AsciiHeaderColumns::Ny());
-			header.append(separator);
-			header.append(AsciiHeaderColumns::Nz());
-		}
-		
-		stream << header << "\n";
+		stream << MakeHeaderLine(format) << "\n";
 	}
 
 	if (s_savePointCountHeader)
@@ -318,85 +424,7 @@ CC_FILE_ERROR AsciiFilter::saveToFile(ccHObject* entity, const QString& filename
 	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
 	for (unsigned i = 0; i < numberOfPoints; ++i)
 	{
-		//line for the current point
-		QString line;
-
-		//write current point coordinates
-		const CCVector3* P = cloud->getPoint(i);
-		CCVector3d Pglobal = cloud->toGlobal3d<PointCoordinateType>(*P);
-		line.append(QString::number(Pglobal.x, 'f', s_outputCoordPrecision));
-		line.append(separator);
-		line.append(QString::number(Pglobal.y, 'f', s_outputCoordPrecision));
-		line.append(separator);
-		line.append(QString::number(Pglobal.z, 'f', s_outputCoordPrecision));
-
-		QString colorLine;
-		if (writeColors)
-		{
-			//add rgb color
-			const ccColor::Rgba& col = cloud->getPointColor(i);
-			if (saveFloatColors)
-			{
-				colorLine.append(separator);
-				colorLine.append(QString::number(static_cast<double>(col.r) / ccColor::MAX));
-				colorLine.append(separator);
-				colorLine.append(QString::number(static_cast<double>(col.g) / ccColor::MAX));
-				colorLine.append(separator);
-				colorLine.append(QString::number(static_cast<double>(col.b) / ccColor::MAX));
-				if (saveAlphaChannel)
-				{
-					colorLine.append(separator);
-					colorLine.append(QString::number(static_cast<double>(col.a) / ccColor::MAX));
-				}
-			}
-			else
-			{
-				colorLine.append(separator);
-				colorLine.append(QString::number(col.r));
-				colorLine.append(separator);
-				colorLine.append(QString::number(col.g));
-				colorLine.append(separator);
-				colorLine.append(QString::number(col.b));
-				if (saveAlphaChannel)
-				{
-					colorLine.append(separator);
-					colorLine.append(QString::number(col.a));
-				}
-			}
-
-			if (!s_saveSFBeforeColor)
-			{
-				line.append(colorLine);
-			}
-		}
-
-		if (writeSF)
-		{
-			//add each associated SF values
-			for (std::vector<ccScalarField*>::const_iterator it = theScalarFields.begin(); it != theScalarFields.end(); ++it)
-			{
-				line.append(separator);
-				double sfVal = (*it)->getGlobalShift() + (*it)->getValue(i);
-				line.append(QString::number(sfVal, 'f', s_outputSFPrecision));
-			}
-		}
-
-		if (writeColors && s_saveSFBeforeColor)
-			line.append(colorLine);
-
-		if (writeNorms)
-		{
-			//add normal vector
-			const CCVector3& N = cloud->getPointNormal(i);
-			line.append(separator);
-			line.append(QString::number(N.x, 'f', normalPrecision));
-			line.append(separator);
-			line.append(QString::number(N.y, 'f', normalPrecision));
-			line.append(separator);
-			line.append(QString::number(N.z, 'f', normalPrecision));
-		}
-
-		stream << line << "\n";
+		stream << MakePointLine(*cloud, i, format) << "\n";
 
 		if (pDlg && !nprogress.oneStep())
 		{
@@ -787,6 +815,126 @@ cloudAttributesDescriptor prepareCloud(	const AsciiOpenDlg::Sequence &openSequen
 	return cloudDesc;
 }
 
+//! Reads the point coordinates from a line (split in parts)
+/** \return false if one of the coordinates is not a numerical value
+**/
+static bool ReadCoordinates(const QStringList& parts,
+							const cloudAttributesDescriptor& cloudDesc,
+							const QLocale& locale,
+							CCVector3d& P)
+{
+	bool ok = true;
+	if (cloudDesc.xCoordIndex >= 0)
+	{
+		P.x = locale.toDouble(parts[cloudDesc.xCoordIndex], &ok);
+		if (!ok)
+		{
+			return false;
+		}
+	}
+	if (cloudDesc.yCoordIndex >= 0)
+	{
+		P.y = locale.toDouble(parts[cloudDesc.yCoordIndex], &ok);
+		if (!ok)
+		{
+			return false;
+		}
+	}
+	if (cloudDesc.zCoordIndex >= 0)
+	{
+		P.z = locale.toDouble(parts[cloudDesc.zCoordIndex], &ok);
+		if (!ok)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//! Reads the other attributes of the last added point (normal, color and scalar values) from a line (split in parts)
+static void ReadAttributes(	const QStringList& parts,
+							cloudAttributesDescriptor& cloudDesc,
+							const QLocale& locale)
+{
+	//Normal vector
+	if (cloudDesc.hasNorms)
+	{
+		CCVector3 N(0, 0, 0);
+		if (cloudDesc.xNormIndex >= 0)
+			N.x = static_cast<PointCoordinateType>(locale.toDouble(parts[cloudDesc.xNormIndex]));
+		if (cloudDesc.yNormIndex >= 0)
+			N.y = static_cast<PointCoordinateType>(locale.toDouble(parts[cloudDesc.yNormIndex]));
+		if (cloudDesc.zNormIndex >= 0)
+			N.z = static_cast<PointCoordinateType>(locale.toDouble(parts[cloudDesc.zNormIndex]));
+		cloudDesc.cloud->addNorm(N);
+	}
+
+	//Colors
+	ccColor::Rgba col(0, 0, 0, 255);
+	if (cloudDesc.hasRGBColors)
+	{
+		if (cloudDesc.iRgbaIndex >= 0)
+		{
+			const uint32_t rgba = parts[cloudDesc.iRgbaIndex].toInt();
+			col.a = ((rgba >> 24) & 0x0000ff);
+			col.r = ((rgba >> 16) & 0x0000ff);
+			col.g = ((rgba >>  8) & 0x0000ff);
+			col.b = ((rgba      ) & 0x0000ff);
+
+		}
+		else if (cloudDesc.fRgbaIndex >= 0)
+		{
+			const float rgbaf = locale.toFloat(parts[cloudDesc.fRgbaIndex]);
+			const uint32_t rgba = *(reinterpret_cast<const uint32_t *>(&rgbaf));
+			col.a = ((rgba >> 24) & 0x0000ff);
+			col.r = ((rgba >> 16) & 0x0000ff);
+			col.g = ((rgba >>  8) & 0x0000ff);
+			col.b = ((rgba      ) & 0x0000ff);
+		}
+		else
+		{
+			if (cloudDesc.redIndex >= 0)
+			{
+				float multiplier = cloudDesc.hasFloatRGBColors[0] ? static_cast<float>(ccColor::MAX) : 1.0f;
+				col.r = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.redIndex]) * multiplier);
+			}
+			if (cloudDesc.greenIndex >= 0)
+			{
+				float multiplier = cloudDesc.hasFloatRGBColors[1] ? static_cast<float>(ccColor::MAX) : 1.0f;
+				col.g = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.greenIndex]) * multiplier);
+			}
+			if (cloudDesc.blueIndex >= 0)
+			{
+				float multiplier = cloudDesc.hasFloatRGBColors[2] ? static_cast<float>(ccColor::MAX) : 1.0f;
+				col.b = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.blueIndex]) * multiplier);
+			}
+			if (cloudDesc.alphaIndex >= 0)
+			{
+				float multiplier = cloudDesc.hasFloatRGBColors[3] ? static_cast<float>(ccColor::MAX) : 1.0f;
+				col.a = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.alphaIndex]) * multiplier);
+			}
+		}
+		cloudDesc.cloud->addColor(col);
+	}
+	else if (cloudDesc.greyIndex >= 0)
+	{
+		col.r = col.g = col.b = static_cast<ColorCompType>(parts[cloudDesc.greyIndex].toInt());
+		col.a = ccColor::MAX;
+		cloudDesc.cloud->addColor(col);
+	}
+
+	//Scalar distance
+	if (!cloudDesc.scalarIndexes.empty())
+	{
+		for (size_t j = 0; j < cloudDesc.scalarIndexes.size(); ++j)
+		{
+			ScalarType D = static_cast<ScalarType>(locale.toDouble(parts[cloudDesc.scalarIndexes[j]]));
+			cloudDesc.scalarFields[j]->emplace_back(D);
+		}
+	}
+}
+
 CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 															QString filenameOrTitle,
 															ccHObject& container,
@@ -844,11 +992,8 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 	CCCoreLib::NormalizedProgress nprogress(pDlg.data(), approximateNumberOfLines);
 
 	//buffers
-	ScalarType D = 0;
 	CCVector3d P(0, 0, 0);
 	CCVector3d Pshift(0, 0, 0);
-	CCVector3 N(0, 0, 0);
-	ccColor::Rgba col(0, 0, 0, 255);
 	bool preserveCoordinateShift = true;
 
 	//other useful variables
@@ -960,39 +1105,7 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 		if (nParts > maxPartIndex) //fake loop for easy break
 		{
 			//read the point coordinates
-			bool lineIsCorrupted = true;
-			for (int step = 0; step < 1; ++step) //fake loop for easy break
-			{
-				bool ok = true;
-				if (cloudDesc.xCoordIndex >= 0)
-				{
-					P.x = locale.toDouble(parts[cloudDesc.xCoordIndex], &ok);
-					if (!ok)
-					{
-						break;
-					}
-				}
-				if (cloudDesc.yCoordIndex >= 0)
-				{
-					P.y = locale.toDouble(parts[cloudDesc.yCoordIndex], &ok);
-					if (!ok)
-					{
-						break;
-					}
-				}
-				if (cloudDesc.zCoordIndex >= 0)
-				{
-					P.z = locale.toDouble(parts[cloudDesc.zCoordIndex], &ok);
-					if (!ok)
-					{
-						break;
-					}
-				}
-
-				lineIsCorrupted = false;
-			}
-
-			if (lineIsCorrupted)
+			if (!ReadCoordinates(parts, cloudDesc, locale, P))
 			{
 				ccLog::Warning("[AsciiFilter::Load] Line %i is corrupted (non numerical value found)", linesRead);
 				continue;
@@ -1014,80 +1127,8 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 			//add point
 			cloudDesc.cloud->addPoint((P + Pshift).toPC());
 
-			//Normal vector
-			if (cloudDesc.hasNorms)
-			{
-				if (cloudDesc.xNormIndex >= 0)
-					N.x = static_cast<PointCoordinateType>(locale.toDouble(parts[cloudDesc.xNormIndex]));
-				if (cloudDesc.yNormIndex >= 0)
-					N.y = static_cast<PointCoordinateType>(locale.toDouble(parts[cloudDesc.yNormIndex]));
-				if (cloudDesc.zNormIndex >= 0)
-					N.z = static_cast<PointCoordinateType>(locale.toDouble(parts[cloudDesc.zNormIndex]));
-				cloudDesc.cloud->addNorm(N);
-			}
-
-			//Colors
-			if (cloudDesc.hasRGBColors)
-			{
-				if (cloudDesc.iRgbaIndex >= 0)
-				{
-					const uint32_t rgba = parts[cloudDesc.iRgbaIndex].toInt();
-					col.a = ((rgba >> 24) & 0x0000ff);
-					col.r = ((rgba >> 16) & 0x0000ff);
-					col.g = ((rgba >>  8) & 0x0000ff);
-					col.b = ((rgba      ) & 0x0000ff);
-
-				}
-				else if (cloudDesc.fRgbaIndex >= 0)
-				{
-					const float rgbaf = locale.toFloat(parts[cloudDesc.fRgbaIndex]);
-					const uint32_t rgba = *(reinterpret_cast<const uint32_t *>(&rgbaf));
-					col.a = ((rgba >> 24) & 0x0000ff);
-					col.r = ((rgba >> 16) & 0x0000ff);
-					col.g = ((rgba >>  8) & 0x0000ff);
-					col.b = ((rgba      ) & 0x0000ff);
-				}
-				else
-				{
-					if (cloudDesc.redIndex >= 0)
-					{
-						float multiplier = cloudDesc.hasFloatRGBColors[0] ? static_cast<float>(ccColor::MAX) : 1.0f;
-						col.r = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.redIndex]) * multiplier);
-					}
-					if (cloudDesc.greenIndex >= 0)
-					{
-						float multiplier = cloudDesc.hasFloatRGBColors[1] ? static_cast<float>(ccColor::MAX) : 1.0f;
-						col.g = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.greenIndex]) * multiplier);
-					}
-					if (cloudDesc.blueIndex >= 0)
-					{
-						float multiplier = cloudDesc.hasFloatRGBColors[2] ? static_cast<float>(ccColor::MAX) : 1.0f;
-						col.b = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.blueIndex]) * multiplier);
-					}
-					if (cloudDesc.alphaIndex >= 0)
-					{
-						float multiplier = cloudDesc.hasFloatRGBColors[3] ? static_cast<float>(ccColor::MAX) : 1.0f;
-						col.a = static_cast<ColorCompType>(locale.toFloat(parts[cloudDesc.alphaIndex]) * multiplier);
-					}
-				}
-				cloudDesc.cloud->addColor(col);
-			}
-			else if (cloudDesc.greyIndex >= 0)
-			{
-				col.r = col.g = col.b = static_cast<ColorCompType>(parts[cloudDesc.greyIndex].toInt());
-				col.a = ccColor::MAX;
-				cloudDesc.cloud->addColor(col);
-			}
-
-			//Scalar distance
-			if (!cloudDesc.scalarIndexes.empty())
-			{
-				for (size_t j = 0; j < cloudDesc.scalarIndexes.size(); ++j)
-				{
-					D = static_cast<ScalarType>(locale.toDouble(parts[cloudDesc.scalarIndexes[j]]));
-					cloudDesc.scalarFields[j]->emplace_back(D);
-				}
-			}
+			//normal, color and scalar values
+			ReadAttributes(parts, cloudDesc, locale);
 
 			//Label
 			if (cloudDesc.labelIndex >= 0)
@@ -1155,3 +1196,310 @@ CC_FILE_ERROR AsciiFilter::loadCloudFromFormatedAsciiStream(QTextStream& stream,
 
 	return result;
 }
+
+//! ASCII point cloud reader (chunk by chunk)
+/** Same columns detection as AsciiFilter::loadFile, but labels are not supported.
+**/
+class AsciiChunkReader : public FileIOFilter::ChunkReader
+{
+public:
+
+	AsciiChunkReader(const QString& filename, const FileIOFilter::LoadParameters& parameters)
+		: m_file(filename)
+		, m_parameters(parameters)
+		, m_separator(' ')
+		, m_linesRead(0)
+		, m_pointsRead(0)
+		, m_Pshift(0, 0, 0)
+		, m_preserveCoordinateShift(true)
+	{}
+
+	//! Opens the file and determines its format
+	CC_FILE_ERROR open()
+	{
+		if (!m_file.exists())
+		{
+			return CC_FERR_UNKNOWN_FILE;
+		}
+		if (!m_file.open(QFile::ReadOnly))
+		{
+			return CC_FERR_READING;
+		}
+		if (m_file.size() == 0)
+		{
+			return CC_FERR_NO_LOAD;
+		}
+		m_stream.setDevice(&m_file);
+
+		AsciiOpenDlg openDialog(m_parameters.parentWidget);
+		openDialog.setInput(m_file.fileName(), &m_stream);
+
+		bool forceDialogDisplay = m_parameters.alwaysDisplayLoadDialog;
+		if (openDialog.restorePreviousContext())
+		{
+			forceDialogDisplay = false;
+		}
+		if (m_parameters.sessionStart)
+		{
+			AsciiOpenDlg::ResetApplyAll();
+		}
+
+		QString dummyStr;
+		if (	forceDialogDisplay
+			|| !AsciiOpenDlg::CheckOpenSequence(openDialog.getOpenSequence(), dummyStr))
+		{
+			if (!openDialog.exec())
+			{
+				return CC_FERR_CANCELED_BY_USER;
+			}
+		}
+
+		m_sequence = openDialog.getOpenSequence();
+		m_separator = static_cast<char>(openDialog.getSeparator());
+		m_locale = QLocale(openDialog.useCommaAsDecimal() ? QLocale::French : QLocale::English);
+
+		//we skip lines as defined on input
+		m_stream.seek(0);
+		for (unsigned i = 0; i < openDialog.getSkippedLinesCount();)
+		{
+			QString currentLine = m_stream.readLine();
+			if (currentLine.isNull())
+			{
+				break;
+			}
+			if (!currentLine.isEmpty())
+			{
+				//empty lines are ignored
+				++i;
+			}
+		}
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	//inherited from FileIOFilter::ChunkReader
+	ccPointCloud* readChunk(unsigned maxCount, CC_FILE_ERROR& error) override
+	{
+		error = CC_FERR_NO_ERROR;
+		if (maxCount == 0 || m_stream.atEnd())
+		{
+			return nullptr;
+		}
+
+		int maxPartIndex = -1;
+		cloudAttributesDescriptor cloudDesc = prepareCloud(m_sequence, maxCount, maxPartIndex);
+		if (!cloudDesc.cloud)
+		{
+			error = CC_FERR_NOT_ENOUGH_MEMORY;
+			return nullptr;
+		}
+		if (m_pointsRead != 0 && m_preserveCoordinateShift)
+		{
+			cloudDesc.cloud->setGlobalShift(m_Pshift);
+		}
+
+		CCVector3d P(0, 0, 0);
+		while (cloudDesc.cloud->size() < maxCount)
+		{
+			//read next line
+			QString currentLine = m_stream.readLine();
+			if (currentLine.isNull())
+			{
+				//end of file
+				break;
+			}
+			++m_linesRead;
+
+			if (currentLine.isEmpty() || currentLine.startsWith("//"))
+			{
+				//empty lines and comments are ignored
+				continue;
+			}
+
+			QStringList parts = currentLine.simplified().split(m_separator, QString::SkipEmptyParts);
+			if (parts.size() <= maxPartIndex)
+			{
+				ccLog::Warning("[AsciiFilter::Load] Line %i is corrupted (found %i part(s) on %i expected)!", m_linesRead, parts.size(), maxPartIndex + 1);
+				continue;
+			}
+			if (!ReadCoordinates(parts, cloudDesc, m_locale, P))
+			{
+				ccLog::Warning("[AsciiFilter::Load] Line %i is corrupted (non numerical value found)", m_linesRead);
+				continue;
+			}
+
+			//first point: check for 'big' coordinates (the same shift is applied to all the chunks)
+			if (m_pointsRead == 0)
+			{
+				if (FileIOFilter::HandleGlobalShift(P, m_Pshift, m_preserveCoordinateShift, m_parameters))
+				{
+					if (m_preserveCoordinateShift)
+					{
+						cloudDesc.cloud->setGlobalShift(m_Pshift);
+					}
+					ccLog::Warning("[ASCIIFilter::loadFile] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", m_Pshift.x, m_Pshift.y, m_Pshift.z);
+				}
+			}
+
+			cloudDesc.cloud->addPoint((P + m_Pshift).toPC());
+			ReadAttributes(parts, cloudDesc, m_locale);
+			++m_pointsRead;
+		}
+
+		if (cloudDesc.cloud->size() == 0)
+		{
+			//end of file
+			clearStructure(cloudDesc);
+			return nullptr;
+		}
+
+		if (cloudDesc.cloud->size() < cloudDesc.cloud->capacity())
+		{
+			cloudDesc.cloud->resize(cloudDesc.cloud->size());
+		}
+		if (!cloudDesc.scalarFields.empty())
+		{
+			for (CCCoreLib::ScalarField* sf : cloudDesc.scalarFields)
+			{
+				sf->computeMinAndMax();
+			}
+			cloudDesc.cloud->setCurrentDisplayedScalarField(0);
+			cloudDesc.cloud->showSF(true);
+		}
+
+		return cloudDesc.cloud;
+	}
+
+protected:
+
+	QFile m_file;
+	QTextStream m_stream;
+	FileIOFilter::LoadParameters m_parameters;
+	AsciiOpenDlg::Sequence m_sequence;
+	char m_separator;
+	QLocale m_locale;
+	unsigned m_linesRead;
+	unsigned m_pointsRead;
+	CCVector3d m_Pshift;
+	bool m_preserveCoordinateShift;
+};
+
+FileIOFilter::ChunkReader::Shared AsciiFilter::openChunkReader(const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error)
+{
+	QSharedPointer<AsciiChunkReader> reader(new AsciiChunkReader(filename, parameters));
+	error = reader->open();
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return ChunkReader::Shared(nullptr);
+	}
+
+	return reader;
+}
+
+//! ASCII point cloud writer (chunk by chunk)
+/** The point count header can't be written (the number of points is unknown beforehand).
+**/
+class AsciiChunkWriter : public FileIOFilter::ChunkWriter
+{
+public:
+
+	explicit AsciiChunkWriter(const QString& filename)
+		: m_file(filename)
+		, m_chunkCount(0)
+		, m_scalarFieldCount(0)
+	{}
+
+	//! Opens the file
+	CC_FILE_ERROR open(const FileIOFilter::SaveParameters& parameters)
+	{
+		//we use the same settings as AsciiFilter::saveToFile (without dialog)
+		AsciiSaveDlg saveDialog(parameters.parentWidget);
+		saveDialog.setCoordsPrecision(s_outputCoordPrecision);
+		saveDialog.setSfPrecision(s_outputSFPrecision);
+		saveDialog.setSeparatorIndex(s_outputSeparatorIndex);
+		saveDialog.enableSwapColorAndSF(s_saveSFBeforeColor);
+		saveDialog.enableSaveColumnsNamesHeader(s_saveColumnsNamesHeader);
+		saveDialog.enableSavePointCountHeader(s_savePointCountHeader);
+
+		m_format.separator = saveDialog.getSeparator();
+		m_format.saveFloatColors = saveDialog.saveFloatColors();
+		m_format.saveAlphaChannel = saveDialog.saveAlphaChannel();
+
+		if (!m_file.open(QFile::WriteOnly | QFile::Truncate))
+		{
+			return CC_FERR_WRITING;
+		}
+		m_stream.setDevice(&m_file);
+
+		if (s_savePointCountHeader)
+		{
+			ccLog::Warning("[ASCII] The number of points can't be written in the header when the cloud is saved chunk by chunk");
+		}
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	//inherited from FileIOFilter::ChunkWriter
+	CC_FILE_ERROR writeChunk(const ccPointCloud& chunk) override
+	{
+		AsciiOutputFormat format = m_format;
+		format.setCloud(&chunk);
+
+		if (m_chunkCount == 0)
+		{
+			//the first chunk defines the columns
+			m_format.writeColors = format.writeColors;
+			m_format.writeNorms = format.writeNorms;
+			m_scalarFieldCount = format.scalarFields.size();
+
+			if (s_saveColumnsNamesHeader)
+			{
+				m_stream << MakeHeaderLine(format) << "\n";
+			}
+		}
+		else if (	format.writeColors != m_format.writeColors
+				||	format.writeNorms != m_format.writeNorms
+				||	format.scalarFields.size() != m_scalarFieldCount)
+		{
+			ccLog::Warning("[ASCII] All the chunks must have the same attributes");
+			return CC_FERR_BAD_ENTITY_TYPE;
+		}
+
+		for (unsigned i = 0; i < chunk.size(); ++i)
+		{
+			m_stream << MakePointLine(chunk, i, format) << "\n";
+		}
+		++m_chunkCount;
+
+		return (m_stream.status() == QTextStream::Ok ? CC_FERR_NO_ERROR : CC_FERR_WRITING);
+	}
+
+	//inherited from FileIOFilter::ChunkWriter
+	CC_FILE_ERROR close() override
+	{
+		m_stream.flush();
+		CC_FILE_ERROR result = (m_stream.status() == QTextStream::Ok ? CC_FERR_NO_ERROR : CC_FERR_WRITING);
+		m_file.close();
+		return result;
+	}
+
+protected:
+
+	QFile m_file;
+	QTextStream m_stream;
+	AsciiOutputFormat m_format;
+	unsigned m_chunkCount;
+	size_t m_scalarFieldCount;
+};
+
+FileIOFilter::ChunkWriter::Shared AsciiFilter::openChunkWriter(const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error)
+{
+	QSharedPointer<AsciiChunkWriter> writer(new AsciiChunkWriter(filename));
+	error = writer->open(parameters);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return ChunkWriter::Shared(nullptr);
+	}
+
+	return writer;
+}
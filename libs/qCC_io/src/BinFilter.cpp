@@ -61,7 +61,7 @@ BinFilter::BinFilter()
 					"bin",
 					QStringList{ GetFileFilter() },
 					QStringList{ GetFileFilter() },
-					Import | Export | BuiltIn
+					Import | Export | BuiltIn | Reentrant
 					} )	
 {
 }
@@ -145,20 +145,6 @@ static int ReadEntityHeader(QFile& in, unsigned &numberOfPoints, HeaderFlags& he
 	return 0;
 }
 
-static QFile* s_file = nullptr;
-static int s_flags = 0;
-static ccHObject* s_container = nullptr;
-
-CC_FILE_ERROR _LoadFileV2()
-{
-	return (s_file && s_container ? BinFilter::LoadFileV2(*s_file,*s_container,s_flags) : CC_FERR_BAD_ARGUMENT);
-}
-
-CC_FILE_ERROR _SaveFileV2()
-{
-	return (s_file && s_container ? BinFilter::SaveFileV2(*s_file,s_container) : CC_FERR_BAD_ARGUMENT);
-}
-
 CC_FILE_ERROR BinFilter::saveToFile(ccHObject* root, const QString& filename, const SaveParameters& parameters)
 {
 	if (!root || filename.isNull())
@@ -168,22 +154,21 @@ CC_FILE_ERROR BinFilter::saveToFile(ccHObject* root, const QString& filename, co
 	if (!out.open(QIODevice::WriteOnly))
 		return CC_FERR_WRITING;
 
-	QScopedPointer<ccProgressDialog> pDlg(nullptr);
-	if (parameters.parentWidget)
+	if (!parameters.parentWidget)
 	{
-		pDlg.reset(new ccProgressDialog(false, parameters.parentWidget));
-		pDlg->setMethodTitle(QObject::tr("BIN file"));
-		pDlg->setInfo(QObject::tr("Please wait... saving in progress"));
-		pDlg->setRange(0, 0);
-		pDlg->setModal(true);
-		pDlg->start();
+		//no dialog: no need to keep the GUI responsive
+		return SaveFileV2(out, root);
 	}
 
-	//concurrent call
-	s_file = &out;
-	s_container = root;
+	QScopedPointer<ccProgressDialog> pDlg(new ccProgressDialog(false, parameters.parentWidget));
+	pDlg->setMethodTitle(QObject::tr("BIN file"));
+	pDlg->setInfo(QObject::tr("Please wait... saving in progress"));
+	pDlg->setRange(0, 0);
+	pDlg->setModal(true);
+	pDlg->start();
 
-	QFuture<CC_FILE_ERROR> future = QtConcurrent::run(_SaveFileV2);
+	//concurrent call
+	QFuture<CC_FILE_ERROR> future = QtConcurrent::run([&out, root]() { return SaveFileV2(out, root); });
 
 	while (!future.isFinished())
 	{
@@ -192,19 +177,49 @@ CC_FILE_ERROR BinFilter::saveToFile(ccHObject* root, const QString& filename, co
 #else
 		usleep(500 * 1000);
 #endif
-		if (pDlg)
-		{
-			pDlg->setValue(pDlg->value() + 1);
-		}
+		pDlg->setValue(pDlg->value() + 1);
 		QApplication::processEvents();
 	}
-	
-	s_file = nullptr;
-	s_container = nullptr;
 
-	CC_FILE_ERROR result = future.result();
+	return future.result();
+}
+
+//! First BIN version with the compact storage of scalar fields
+static const unsigned c_compactStorageVersion = 53; //5.3
 
-	return result;
+//! Whether the scalar fields are saved with their preferred compact storage
+static bool s_compactScalarFields = true;
+
+void BinFilter::SetCompactScalarFields(bool state)
+{
+	s_compactScalarFields = state;
+}
+
+bool BinFilter::CompactScalarFields()
+{
+	return s_compactScalarFields;
+}
+
+//! Returns whether at least one scalar field of the sub-tree has a compact preferred storage
+static bool HasCompactScalarFields(const ccHObject* object)
+{
+	ccHObject::Container clouds;
+	if (object->isA(CC_TYPES::POINT_CLOUD))
+		clouds.push_back(const_cast<ccHObject*>(object));
+	object->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true);
+
+	for (ccHObject* entity : clouds)
+	{
+		const ccPointCloud* cloud = static_cast<const ccPointCloud*>(entity);
+		for (unsigned i = 0; i < cloud->getNumberOfScalarFields(); ++i)
+		{
+			const ccScalarField* sf = static_cast<const ccScalarField*>(cloud->getScalarField(static_cast<int>(i)));
+			if (sf->getStorage().type != ccScalarField::StorageType::NATIVE)
+				return true;
+		}
+	}
+
+	return false;
 }
 
 CC_FILE_ERROR BinFilter::SaveFileV2(QFile& out, ccHObject* object)
@@ -235,6 +250,11 @@ CC_FILE_ERROR BinFilter::SaveFileV2(QFile& out, ccHObject* object)
 
 	// Current BIN file version
 	uint32_t binVersion_u32 = static_cast<uint32_t>(ccObject::GetCurrentDBVersion());
+	if (binVersion_u32 == c_compactStorageVersion && (!s_compactScalarFields || !HasCompactScalarFields(object)))
+	{
+		//the files remain readable by the previous versions if the new features are not used
+		binVersion_u32 = c_compactStorageVersion - 1;
+	}
 	if (out.write((char*)&binVersion_u32, 4) < 0)
 		return CC_FERR_WRITING;
 
@@ -330,8 +350,12 @@ CC_FILE_ERROR BinFilter::SaveFileV2(QFile& out, ccHObject* object)
 	}
 
 	if (result == CC_FERR_NO_ERROR)
+	{
+		//the entities are saved with the same version as the header
+		ccSerializationContext context(static_cast<short>(binVersion_u32));
 		if (!object->toFile(out))
 			result = CC_FERR_CONSOLE_ERROR;
+	}
 
 	out.close();
 
@@ -382,24 +406,16 @@ CC_FILE_ERROR BinFilter::loadFile(const QString& filename, ccHObject& container,
 		//	return CC_FERR_WRONG_FILE_TYPE;
 		//}
 
-		if (parameters.alwaysDisplayLoadDialog)
+		if (parameters.alwaysDisplayLoadDialog && parameters.parentWidget)
 		{
-			QScopedPointer<ccProgressDialog> pDlg(nullptr);
-			if (parameters.parentWidget)
-			{
-				pDlg.reset(new ccProgressDialog(false, parameters.parentWidget));
-				pDlg->setMethodTitle(QObject::tr("BIN file"));
-				pDlg->setInfo(QObject::tr("Loading: %1").arg(QFileInfo(filename).fileName()));
-				pDlg->setRange(0, 0);
-				pDlg->show();
-			}
+			QScopedPointer<ccProgressDialog> pDlg(new ccProgressDialog(false, parameters.parentWidget));
+			pDlg->setMethodTitle(QObject::tr("BIN file"));
+			pDlg->setInfo(QObject::tr("Loading: %1").arg(QFileInfo(filename).fileName()));
+			pDlg->setRange(0, 0);
+			pDlg->show();
 
 			//concurrent call in a separate thread
-			s_file = &in;
-			s_container = &container;
-			s_flags = flags;
-
-			QFuture<CC_FILE_ERROR> future = QtConcurrent::run(_LoadFileV2);
+			QFuture<CC_FILE_ERROR> future = QtConcurrent::run([&in, &container, flags]() { return LoadFileV2(in, container, flags); });
 
 			while (!future.isFinished())
 			{
@@ -408,16 +424,10 @@ CC_FILE_ERROR BinFilter::loadFile(const QString& filename, ccHObject& container,
 #else
 				usleep(500 * 1000);
 #endif
-				if (pDlg)
-				{
-					pDlg->setValue(pDlg->value() + 1);
-				}
+				pDlg->setValue(pDlg->value() + 1);
 				//pDlg.setValue(static_cast<int>(in.pos())); //DGM: in fact, the file reading part is just half of the work!
 				QApplication::processEvents();
 			}
-	
-			s_file = nullptr;
-			s_container = nullptr;
 
 			return future.result();
 		}
@@ -77,6 +77,16 @@ bool FileIOFilter::exportSupported() const
 	return m_filterInfo.features & Export;
 }
 
+bool FileIOFilter::streamingSupported() const
+{
+	return m_filterInfo.features & Streaming;
+}
+
+bool FileIOFilter::isReentrant() const
+{
+	return m_filterInfo.features & Reentrant;
+}
+
 const QStringList& FileIOFilter::getFileFilters( bool onImport ) const
 {
 	if ( onImport )
@@ -92,6 +102,11 @@ QString FileIOFilter::getDefaultExtension() const
 	return m_filterInfo.defaultExtension;
 }
 
+const FileIOFilter::FilterInfo& FileIOFilter::getFilterInfo() const
+{
+	return m_filterInfo;
+}
+
 void FileIOFilter::setImportExtensions( const QStringList &extensions )
 {
 	m_filterInfo.importExtensions = extensions;
@@ -268,6 +283,23 @@ FileIOFilter::Shared FileIOFilter::FindBestFilterForExtension(const QString& ext
 	return FileIOFilter::Shared( nullptr );
 }
 
+FileIOFilter::Shared FileIOFilter::FindStreamingFilterForExtension(const QString& ext, bool onImport)
+{
+	const QString lowerExt = ext.toLower();
+	
+	for ( const auto &filter : s_ioFilters )
+	{
+		if (	filter->streamingSupported()
+			&&	(onImport ? filter->importSupported() : filter->exportSupported())
+			&&	filter->m_filterInfo.importExtensions.contains( lowerExt ) )
+		{
+			return filter;
+		}
+	}
+
+	return FileIOFilter::Shared( nullptr );
+}
+
 QStringList FileIOFilter::ImportFilterList()
 {
 	QStringList	list{ QObject::tr( "All (*.*)" ) };
@@ -342,6 +374,25 @@ ccHObject* FileIOFilter::LoadFromFile(	const QString& filename,
 	if (result == CC_FERR_NO_ERROR)
 	{
 		ccLog::Print(QString("[I/O] File '%1' loaded successfully").arg(filename));
+
+		if (loadParameters.reorderPoints)
+		{
+			//reorder the points of the loaded clouds (except the mesh or polyline vertices, etc.)
+			ccHObject::Container clouds;
+			container->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true);
+			for (ccHObject* cloud : clouds)
+			{
+				ccPointCloud* pc = static_cast<ccPointCloud*>(cloud);
+				if (pc->hasIndexedDependents())
+				{
+					continue;
+				}
+				if (!pc->reorderPoints(loadParameters.pointOrder, loadParameters.storeOriginalPointIndexes))
+				{
+					ccLog::Warning(QString("[I/O] Failed to reorder the points of cloud '%1'").arg(cloud->getName()));
+				}
+			}
+		}
 	}
 	else
 	{
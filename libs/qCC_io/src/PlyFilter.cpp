@@ -22,10 +22,12 @@
 #include "PlyOpenDlg.h"
 
 //Qt
+#include <QFile>
 #include <QFileInfo>
 #include <QImage>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QScopedPointer>
 
 //qCC_db
 #include <ccHObjectCaster.h>
@@ -54,6 +56,27 @@ static bool IsFloat(e_ply_type type)
 	return (type == PLY_FLOAT32) || (type == PLY_FLOAT64) || (type == PLY_FLOAT) || (type == PLY_DOUBLE);
 }
 
+//! Returns the name of the PLY property corresponding to a scalar field
+/** The 'scalar_' prefix is removed when loading the file.
+**/
+static QString ScalarPropertyName(const char* sfName, unsigned& unnamedSFCount)
+{
+	QString propName;
+	if (!sfName)
+	{
+		if (unnamedSFCount++ == 0)
+			propName = "scalar";
+		else
+			propName = QString("scalar_%1").arg(unnamedSFCount);
+	}
+	else
+	{
+		propName = QString("scalar_%1").arg(sfName);
+		propName.replace(' ','_');
+	}
+	return propName;
+}
+
 PlyFilter::PlyFilter()
 	: FileIOFilter( {
 					"_PLY Filter",
@@ -62,7 +85,7 @@ PlyFilter::PlyFilter()
 					"ply",
 					QStringList{ "PLY mesh (*.ply)" },
 					QStringList{ "PLY mesh (*.ply)" },
-					Import | Export | BuiltIn
+					Import | Export | BuiltIn | Streaming
 					} )
 {	
 }
@@ -323,20 +346,7 @@ CC_FILE_ERROR PlyFilter::saveToFile(ccHObject* entity, QString filename, e_ply_s
 			for (unsigned i=0; i<sfCount; ++i)
 			{
 				scalarFields[i] = static_cast<ccScalarField*>(ccCloud->getScalarField(i));
-				const char* sfName = scalarFields[i]->getName();
-				QString propName;
-				if (!sfName)
-				{
-					if (unnamedSF++ == 0)
-						propName = "scalar";
-					else
-						propName = QString("scalar_%1").arg(unnamedSF);
-				}
-				else
-				{
-					propName = QString("scalar_%1").arg(sfName);
-					propName.replace(' ','_');
-				}
+				QString propName = ScalarPropertyName(scalarFields[i]->getName(), unnamedSF);
 
 				result = ply_add_scalar_property(ply, qPrintable(propName), scalarType);
 			}
@@ -2007,6 +2017,24 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 		if (mesh->hasMaterials())
 			mesh->showNormals(false);
 
+		//weld the duplicated vertices (if requested)
+		if (parameters.weldMeshVertices)
+		{
+			ccMesh::WeldingParameters weldingParams;
+			weldingParams.epsilon = parameters.meshWeldingTolerance;
+
+			QScopedPointer<ccProgressDialog> weldingDlg(nullptr);
+			if (parameters.parentWidget)
+			{
+				weldingDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+			}
+			if (!mesh->weldVertices(weldingParams, nullptr, weldingDlg.data()))
+			{
+				ccLog::Warning("[PLY] Failed to weld the mesh vertices");
+			}
+			cloud = nullptr; //warning, after this point, 'cloud' may not be valid anymore
+		}
+
 		container.addChild(mesh);
 	}
 	else
@@ -2027,3 +2055,546 @@ CC_FILE_ERROR PlyFilter::loadFile(const QString& filename, const QString& inputT
 
 	return CC_FERR_NO_ERROR;
 }
+
+//! Flag set on the color properties stored as floating point values, in [0, 1] (see PlyChunkReader)
+static const long s_plyFloatColorFlag = 4;
+
+//! Placeholder for the number of vertices, fitting in a 'long' on all platforms (see PlyChunkWriter)
+static const long s_plyVertexCountPlaceholder = 2147483647L;
+
+//! PLY point cloud reader (chunk by chunk)
+/** Only the first element of the file is read (the vertices): the faces are ignored.
+	The properties are recognized by their names (no dialog): x, y and z (mandatory),
+	nx, ny and nz (normals), red, green and blue (colors). All the other scalar
+	properties are loaded as scalar fields.
+**/
+class PlyChunkReader : public FileIOFilter::ChunkReader
+{
+public:
+
+	explicit PlyChunkReader(const FileIOFilter::LoadParameters& parameters)
+		: m_ply(nullptr)
+		, m_parameters(parameters)
+		, m_vertexCount(0)
+		, m_hasNormals(false)
+		, m_hasColors(false)
+		, m_chunk(nullptr)
+		, m_currentInstance(-1)
+		, m_point(0, 0, 0)
+		, m_normal(0, 0, 0)
+		, m_color(ccColor::black)
+		, m_pointsRead(0)
+		, m_Pshift(0, 0, 0)
+		, m_preserveCoordinateShift(true)
+	{}
+
+	~PlyChunkReader() override
+	{
+		if (m_ply)
+		{
+			ply_close(m_ply);
+		}
+	}
+
+	//! Opens the file and registers the vertex properties
+	CC_FILE_ERROR open(const QString& filename)
+	{
+		m_ply = ply_open(qPrintable(filename), errorCallback, 0, nullptr);
+		if (!m_ply)
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+		if (!ply_read_header(m_ply))
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		p_ply_element element = ply_get_next_element(m_ply, nullptr);
+		if (!element)
+		{
+			return CC_FERR_NO_LOAD;
+		}
+		const char* elementName = nullptr;
+		ply_get_element_info(element, &elementName, &m_vertexCount);
+		if (ply_get_next_element(m_ply, element))
+		{
+			ccLog::Warning("[PLY] Only the vertices are read chunk by chunk (the other elements, e.g. the faces, are ignored)");
+		}
+
+		//we look for the standard properties first
+		static const char* CoordNames[3] = { "x", "y", "z" };
+		static const char* NormalNames[3] = { "nx", "ny", "nz" };
+		static const char* ColorNames[3] = { "red", "green", "blue" };
+		std::vector<plyProperty> properties;
+		int coordIndexes[3] = { -1, -1, -1 };
+		int normalIndexes[3] = { -1, -1, -1 };
+		int colorIndexes[3] = { -1, -1, -1 };
+		{
+			plyProperty lastProperty;
+			lastProperty.prop = nullptr;
+			lastProperty.elemIndex = 0;
+			while ((lastProperty.prop = ply_get_next_property(element, lastProperty.prop)))
+			{
+				ply_get_property_info(lastProperty.prop, &lastProperty.propName, &lastProperty.type, &lastProperty.length_type, &lastProperty.value_type);
+				if (lastProperty.type == PLY_LIST)
+				{
+					//list properties are ignored
+					continue;
+				}
+
+				QString name = QString(lastProperty.propName).toLower();
+				int propIndex = static_cast<int>(properties.size());
+				for (int i = 0; i < 3; ++i)
+				{
+					if (name == CoordNames[i])
+						coordIndexes[i] = propIndex;
+					else if (name == NormalNames[i])
+						normalIndexes[i] = propIndex;
+					else if (name == ColorNames[i])
+						colorIndexes[i] = propIndex;
+				}
+				properties.push_back(lastProperty);
+			}
+		}
+		if (coordIndexes[0] < 0 || coordIndexes[1] < 0 || coordIndexes[2] < 0)
+		{
+			ccLog::Warning("[PLY] The first element of the file has no (x, y, z) properties");
+			return CC_FERR_MALFORMED_FILE;
+		}
+		m_hasNormals = (normalIndexes[0] >= 0 && normalIndexes[1] >= 0 && normalIndexes[2] >= 0);
+		m_hasColors = (colorIndexes[0] >= 0 && colorIndexes[1] >= 0 && colorIndexes[2] >= 0);
+
+		std::vector<bool> used(properties.size(), false);
+		for (int i = 0; i < 3; ++i)
+		{
+			ply_set_read_cb(m_ply, elementName, properties[coordIndexes[i]].propName, CoordinateCallback, this, i);
+			used[coordIndexes[i]] = true;
+			if (m_hasNormals)
+			{
+				ply_set_read_cb(m_ply, elementName, properties[normalIndexes[i]].propName, NormalCallback, this, i);
+				used[normalIndexes[i]] = true;
+			}
+			if (m_hasColors)
+			{
+				long flags = i | (IsFloat(properties[colorIndexes[i]].type) ? s_plyFloatColorFlag : 0);
+				ply_set_read_cb(m_ply, elementName, properties[colorIndexes[i]].propName, ColorCallback, this, flags);
+				used[colorIndexes[i]] = true;
+			}
+		}
+
+		//all the other properties are loaded as scalar fields
+		for (size_t i = 0; i < properties.size(); ++i)
+		{
+			if (used[i])
+			{
+				continue;
+			}
+			QString sfName(properties[i].propName);
+			if (sfName.startsWith("scalar_") && sfName.length() > 7)
+			{
+				//remove the 'scalar_' prefix added when saving SF with CC!
+				sfName = sfName.mid(7).replace('_', ' ');
+			}
+			ply_set_read_cb(m_ply, elementName, properties[i].propName, ScalarCallback, this, static_cast<long>(m_sfNames.size()));
+			m_sfNames.push_back(sfName);
+		}
+		m_sfValues.resize(m_sfNames.size(), 0);
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	//inherited from FileIOFilter::ChunkReader
+	ccPointCloud* readChunk(unsigned maxCount, CC_FILE_ERROR& error) override
+	{
+		error = CC_FERR_NO_ERROR;
+		if (maxCount == 0 || m_pointsRead >= static_cast<size_t>(m_vertexCount))
+		{
+			return nullptr;
+		}
+		unsigned count = static_cast<unsigned>(std::min<size_t>(maxCount, static_cast<size_t>(m_vertexCount) - m_pointsRead));
+
+		QScopedPointer<ccPointCloud> cloud(new ccPointCloud("unnamed"));
+		m_chunkSFs.clear();
+		if (	!cloud->reserve(count)
+			||	(m_hasNormals && !cloud->reserveTheNormsTable())
+			||	(m_hasColors && !cloud->reserveTheRGBTable()))
+		{
+			error = CC_FERR_NOT_ENOUGH_MEMORY;
+			return nullptr;
+		}
+		for (const QString& sfName : m_sfNames)
+		{
+			ccScalarField* sf = new ccScalarField(qPrintable(sfName));
+			if (!sf->reserveSafe(count))
+			{
+				sf->release();
+				error = CC_FERR_NOT_ENOUGH_MEMORY;
+				return nullptr;
+			}
+			cloud->addScalarField(sf);
+			m_chunkSFs.push_back(sf);
+		}
+		if (m_pointsRead != 0 && m_preserveCoordinateShift)
+		{
+			cloud->setGlobalShift(m_Pshift);
+		}
+
+		m_chunk = cloud.data();
+		m_currentInstance = -1;
+		long readCount = ply_read_first_element_chunk(m_ply, static_cast<long>(count));
+		if (m_currentInstance >= 0)
+		{
+			//the last point of the chunk
+			addCurrentPoint();
+		}
+		m_chunk = nullptr;
+
+		if (readCount < 0)
+		{
+			error = CC_FERR_READING;
+			return nullptr;
+		}
+		if (cloud->size() == 0)
+		{
+			//end of file
+			return nullptr;
+		}
+
+		if (!m_chunkSFs.empty())
+		{
+			for (ccScalarField* sf : m_chunkSFs)
+			{
+				sf->computeMinAndMax();
+			}
+			cloud->setCurrentDisplayedScalarField(0);
+			cloud->showSF(true);
+		}
+		cloud->showNormals(m_hasNormals);
+		cloud->showColors(m_hasColors);
+
+		return cloud.take();
+	}
+
+protected:
+
+	//! Called at the beginning of each property callback
+	/** All the properties of an instance are read before the next instance,
+		so the previous point is complete when the instance index changes.
+	**/
+	static PlyChunkReader* BeginProperty(p_ply_argument argument, long& idata)
+	{
+		PlyChunkReader* reader = nullptr;
+		ply_get_argument_user_data(argument, reinterpret_cast<void**>(&reader), &idata);
+		long instanceIndex = 0;
+		ply_get_argument_element(argument, nullptr, &instanceIndex);
+		if (instanceIndex != reader->m_currentInstance)
+		{
+			if (reader->m_currentInstance >= 0)
+			{
+				reader->addCurrentPoint();
+			}
+			reader->m_currentInstance = instanceIndex;
+		}
+		return reader;
+	}
+
+	static int CoordinateCallback(p_ply_argument argument)
+	{
+		long dim = 0;
+		PlyChunkReader* reader = BeginProperty(argument, dim);
+		double val = ply_get_argument_value(argument);
+		//NaN values are replaced by 0 (as in PlyFilter::loadFile)
+		reader->m_point.u[dim] = (val == val ? val : 0.0);
+		return 1;
+	}
+
+	static int NormalCallback(p_ply_argument argument)
+	{
+		long dim = 0;
+		PlyChunkReader* reader = BeginProperty(argument, dim);
+		reader->m_normal.u[dim] = static_cast<PointCoordinateType>(ply_get_argument_value(argument));
+		return 1;
+	}
+
+	static int ColorCallback(p_ply_argument argument)
+	{
+		long flags = 0;
+		PlyChunkReader* reader = BeginProperty(argument, flags);
+		double val = ply_get_argument_value(argument);
+		if (flags & s_plyFloatColorFlag)
+		{
+			val = std::min(std::max(0.0, val), 1.0) * ccColor::MAX;
+		}
+		reader->m_color.rgb[flags & POS_MASK] = static_cast<ColorCompType>(val);
+		return 1;
+	}
+
+	static int ScalarCallback(p_ply_argument argument)
+	{
+		long sfIndex = 0;
+		PlyChunkReader* reader = BeginProperty(argument, sfIndex);
+		reader->m_sfValues[sfIndex] = ply_get_argument_value(argument);
+		return 1;
+	}
+
+	//! Adds the current point (and its attributes) to the current chunk
+	void addCurrentPoint()
+	{
+		assert(m_chunk);
+
+		//first point: check for 'big' coordinates (the same shift is applied to all the chunks)
+		if (m_pointsRead == 0)
+		{
+			if (FileIOFilter::HandleGlobalShift(m_point, m_Pshift, m_preserveCoordinateShift, m_parameters))
+			{
+				if (m_preserveCoordinateShift)
+				{
+					m_chunk->setGlobalShift(m_Pshift);
+				}
+				ccLog::Warning("[PLYFilter::loadFile] Cloud (vertices) has been recentered! Translation: (%.2f ; %.2f ; %.2f)", m_Pshift.x, m_Pshift.y, m_Pshift.z);
+			}
+		}
+
+		m_chunk->addPoint((m_point + m_Pshift).toPC());
+		if (m_hasNormals)
+		{
+			m_chunk->addNorm(m_normal);
+		}
+		if (m_hasColors)
+		{
+			m_chunk->addColor(m_color);
+		}
+		for (size_t i = 0; i < m_chunkSFs.size(); ++i)
+		{
+			m_chunkSFs[i]->addElement(static_cast<ScalarType>(m_sfValues[i]));
+		}
+		++m_pointsRead;
+	}
+
+	p_ply m_ply;
+	FileIOFilter::LoadParameters m_parameters;
+	long m_vertexCount;
+	bool m_hasNormals;
+	bool m_hasColors;
+	std::vector<QString> m_sfNames;
+
+	//current chunk
+	ccPointCloud* m_chunk;
+	std::vector<ccScalarField*> m_chunkSFs;
+	long m_currentInstance;
+	CCVector3d m_point;
+	CCVector3 m_normal;
+	ccColor::Rgb m_color;
+	std::vector<double> m_sfValues;
+
+	size_t m_pointsRead;
+	CCVector3d m_Pshift;
+	bool m_preserveCoordinateShift;
+};
+
+FileIOFilter::ChunkReader::Shared PlyFilter::openChunkReader(const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error)
+{
+	QSharedPointer<PlyChunkReader> reader(new PlyChunkReader(parameters));
+	error = reader->open(filename);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return ChunkReader::Shared(nullptr);
+	}
+
+	return reader;
+}
+
+//! PLY point cloud writer (chunk by chunk)
+/** The number of vertices is unknown when the header is written: a placeholder
+	is written instead, and replaced by the real count (padded with spaces) once
+	all the chunks have been written.
+**/
+class PlyChunkWriter : public FileIOFilter::ChunkWriter
+{
+public:
+
+	PlyChunkWriter(const QString& filename, e_ply_storage_mode storageMode)
+		: m_filename(filename)
+		, m_storageMode(storageMode)
+		, m_ply(nullptr)
+		, m_hasColors(false)
+		, m_hasNormals(false)
+		, m_scalarFieldCount(0)
+		, m_pointCount(0)
+	{}
+
+	~PlyChunkWriter() override
+	{
+		if (m_ply)
+		{
+			ply_close(m_ply);
+		}
+	}
+
+	//inherited from FileIOFilter::ChunkWriter
+	CC_FILE_ERROR writeChunk(const ccPointCloud& chunk) override
+	{
+		if (!m_ply)
+		{
+			//the first chunk defines the properties
+			CC_FILE_ERROR error = writeHeader(chunk);
+			if (error != CC_FERR_NO_ERROR)
+			{
+				return error;
+			}
+		}
+		else if (	chunk.hasColors() != m_hasColors
+				||	chunk.hasNormals() != m_hasNormals
+				||	chunk.getNumberOfScalarFields() != m_scalarFieldCount)
+		{
+			ccLog::Warning("[PLY] All the chunks must have the same attributes");
+			return CC_FERR_BAD_ENTITY_TYPE;
+		}
+
+		if (static_cast<size_t>(s_plyVertexCountPlaceholder) - m_pointCount < chunk.size())
+		{
+			ccLog::Warning("[PLY] Too many points to be written chunk by chunk");
+			return CC_FERR_WRITING;
+		}
+
+		int result = 1;
+		for (unsigned i = 0; i < chunk.size() && result; ++i)
+		{
+			CCVector3d Pglobal = chunk.toGlobal3d<PointCoordinateType>(*chunk.getPoint(i));
+			result = ply_write(m_ply, Pglobal.x) && ply_write(m_ply, Pglobal.y) && ply_write(m_ply, Pglobal.z);
+
+			if (m_hasColors)
+			{
+				const ccColor::Rgb& col = chunk.getPointColor(i);
+				result = result && ply_write(m_ply, col.r) && ply_write(m_ply, col.g) && ply_write(m_ply, col.b);
+			}
+
+			if (m_hasNormals)
+			{
+				const CCVector3& N = chunk.getPointNormal(i);
+				result = result && ply_write(m_ply, N.x) && ply_write(m_ply, N.y) && ply_write(m_ply, N.z);
+			}
+
+			for (unsigned j = 0; j < m_scalarFieldCount; ++j)
+			{
+				const ccScalarField* sf = static_cast<const ccScalarField*>(chunk.getScalarField(j));
+				result = result && ply_write(m_ply, sf->getGlobalShift() + sf->getValue(i));
+			}
+		}
+		m_pointCount += chunk.size();
+
+		return (result ? CC_FERR_NO_ERROR : CC_FERR_WRITING);
+	}
+
+	//inherited from FileIOFilter::ChunkWriter
+	CC_FILE_ERROR close() override
+	{
+		if (!m_ply)
+		{
+			//no chunk written
+			return CC_FERR_NO_SAVE;
+		}
+		int result = ply_close(m_ply);
+		m_ply = nullptr;
+		if (!result)
+		{
+			return CC_FERR_WRITING;
+		}
+
+		//replace the placeholder by the real number of vertices
+		QFile file(m_filename);
+		if (!file.open(QFile::ReadWrite))
+		{
+			return CC_FERR_WRITING;
+		}
+		const QByteArray placeholder = QByteArray("element vertex ") + QByteArray::number(static_cast<qlonglong>(s_plyVertexCountPlaceholder)) + '\n';
+		QByteArray header = file.read(1 << 16);
+		int headerEnd = header.indexOf("end_header");
+		int pos = header.indexOf(placeholder);
+		if (pos < 0 || headerEnd < pos)
+		{
+			assert(false);
+			return CC_FERR_WRITING;
+		}
+		QByteArray line = QByteArray("element vertex ") + QByteArray::number(static_cast<qulonglong>(m_pointCount));
+		line = line.leftJustified(placeholder.size() - 1, ' ') + '\n';
+		if (!file.seek(pos) || file.write(line) != line.size())
+		{
+			return CC_FERR_WRITING;
+		}
+		file.close();
+
+		return CC_FERR_NO_ERROR;
+	}
+
+protected:
+
+	//! Creates the file and writes the header (based on the first chunk)
+	CC_FILE_ERROR writeHeader(const ccPointCloud& chunk)
+	{
+		m_ply = ply_create(qPrintable(m_filename), m_storageMode, errorCallback, 0, nullptr);
+		if (!m_ply)
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		m_hasColors = chunk.hasColors();
+		m_hasNormals = chunk.hasNormals();
+		m_scalarFieldCount = chunk.getNumberOfScalarFields();
+
+		//same properties as PlyFilter::saveToFile
+		e_ply_type coordType = chunk.isShifted() || sizeof(PointCoordinateType) > 4 ? PLY_DOUBLE : PLY_FLOAT;
+		int result = ply_add_element(m_ply, "vertex", s_plyVertexCountPlaceholder);
+		result = result && ply_add_scalar_property(m_ply, "x", coordType);
+		result = result && ply_add_scalar_property(m_ply, "y", coordType);
+		result = result && ply_add_scalar_property(m_ply, "z", coordType);
+		if (m_hasColors)
+		{
+			result = result && ply_add_scalar_property(m_ply, "red", PLY_UCHAR);
+			result = result && ply_add_scalar_property(m_ply, "green", PLY_UCHAR);
+			result = result && ply_add_scalar_property(m_ply, "blue", PLY_UCHAR);
+		}
+		if (m_hasNormals)
+		{
+			e_ply_type normType = (sizeof(PointCoordinateType) > 4 ? PLY_DOUBLE : PLY_FLOAT);
+			result = result && ply_add_scalar_property(m_ply, "nx", normType);
+			result = result && ply_add_scalar_property(m_ply, "ny", normType);
+			result = result && ply_add_scalar_property(m_ply, "nz", normType);
+		}
+		e_ply_type scalarType = (sizeof(ScalarType) > 4 ? PLY_DOUBLE : PLY_FLOAT);
+		unsigned unnamedSF = 0;
+		for (unsigned i = 0; i < m_scalarFieldCount; ++i)
+		{
+			QString propName = ScalarPropertyName(chunk.getScalarField(i)->getName(), unnamedSF);
+			result = result && ply_add_scalar_property(m_ply, qPrintable(propName), scalarType);
+		}
+
+		ply_add_comment(m_ply, qPrintable(FileIO::createdBy()));
+		ply_add_comment(m_ply, qPrintable(FileIO::createdDateTime()));
+		ply_add_obj_info(m_ply, "Generated by CloudCompare!");
+
+		if (!result || !ply_write_header(m_ply))
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	QString m_filename;
+	e_ply_storage_mode m_storageMode;
+	p_ply m_ply;
+	bool m_hasColors;
+	bool m_hasNormals;
+	unsigned m_scalarFieldCount;
+	size_t m_pointCount;
+};
+
+FileIOFilter::ChunkWriter::Shared PlyFilter::openChunkWriter(const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error)
+{
+	Q_UNUSED(parameters);
+
+	//the file is created when the first chunk is written (no dialog)
+	error = CC_FERR_NO_ERROR;
+	return ChunkWriter::Shared(new PlyChunkWriter(filename, s_defaultOutputFormat));
+}
@@ -185,6 +185,8 @@ typedef t_ply_odriver *p_ply_odriver;
  * argument: storage space for callback arguments
  * welement, wproperty: element/property type being written
  * winstance_index: index of instance of current element being written
+ * rinstance_index: index of the next instance of the first element to be
+ *     read (see ply_read_first_element_chunk)
  * wvalue_index: index of list property value being written 
  * wlength: number of values in list property being written
  * error_cb: error callback
@@ -208,6 +210,7 @@ typedef struct t_ply_ {
     t_ply_argument argument;
     long welement, wproperty;
     long winstance_index, wvalue_index, wlength;
+    long rinstance_index;
     p_ply_error_cb error_cb;
     void *pdata;
     long idata;
@@ -472,6 +475,36 @@ int ply_read(p_ply ply) {
     return 1;
 }
 
+long ply_read_first_element_chunk(p_ply ply, long count) {
+    long j, k, end;
+    p_ply_element element = NULL;
+    p_ply_argument argument = NULL;
+    assert(ply && ply->fp && ply->io_mode == PLY_READ);
+    if (ply->nelements == 0 || count <= 0) return 0;
+    element = &ply->element[0];
+    argument = &ply->argument;
+    argument->element = element;
+    end = ply->rinstance_index + count;
+    if (end > element->ninstances || end < ply->rinstance_index)
+        end = element->ninstances;
+    /* for each element of this type (in the chunk) */
+    for (j = ply->rinstance_index; j < end; j++) {
+        argument->instance_index = j;
+        /* for each property */
+        for (k = 0; k < element->nproperties; k++) {
+            p_ply_property property = &element->property[k];
+            argument->property = property;
+            argument->pdata = property->pdata;
+            argument->idata = property->idata;
+            if (!ply_read_property(ply, element, property, argument))
+                return -1;
+        }
+    }
+    count = end - ply->rinstance_index;
+    ply->rinstance_index = end;
+    return count;
+}
+
 /* ----------------------------------------------------------------------
  * Write support functions
  * ---------------------------------------------------------------------- */
@@ -1128,6 +1161,7 @@ static void ply_init(p_ply ply) {
     ply->welement = 0;
     ply->wproperty = 0;
     ply->winstance_index = 0;
+    ply->rinstance_index = 0;
     ply->wlength = 0;
     ply->wvalue_index = 0;
 }
@@ -0,0 +1,188 @@
+#include "TestBinFilter.h"
+
+#include "BinFilter.h"
+#include "FileIOFilter.h"
+#include "ccHObject.h"
+#include "ccPointCloud.h"
+#include "ccScalarField.h"
+
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <cstdint>
+
+
+ccPointCloud* TestBinFilter::createCloud(unsigned pointCount, bool integerValues)
+{
+	ccPointCloud* cloud = new ccPointCloud("cloud");
+	if (!cloud->reserve(pointCount))
+	{
+		delete cloud;
+		return nullptr;
+	}
+
+	ccScalarField* sf = new ccScalarField("values");
+	if (!sf->reserveSafe(pointCount))
+	{
+		sf->release();
+		delete cloud;
+		return nullptr;
+	}
+
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		cloud->addPoint(CCVector3(static_cast<PointCoordinateType>(i), static_cast<PointCoordinateType>(2 * i), 0));
+		sf->addElement(integerValues ? static_cast<ScalarType>(i % 256) : static_cast<ScalarType>(i) / 3);
+	}
+	sf->computeMinAndMax();
+	cloud->addScalarField(sf);
+
+	return cloud;
+}
+
+ccPointCloud* TestBinFilter::roundTrip(ccPointCloud& cloud, const QString& filename, unsigned expectedVersion)
+{
+	BinFilter filter;
+	FileIOFilter::SaveParameters saveParams;
+	saveParams.alwaysDisplaySaveDialog = false;
+	if (filter.saveToFile(&cloud, filename, saveParams) != CC_FERR_NO_ERROR)
+	{
+		return nullptr;
+	}
+
+	//header: 'CCB' + deserialization flags + version (uint32)
+	QFile in(filename);
+	if (!in.open(QFile::ReadOnly))
+	{
+		return nullptr;
+	}
+	QByteArray header = in.read(8);
+	in.close();
+	if (header.size() != 8 || !header.startsWith("CCB"))
+	{
+		return nullptr;
+	}
+	uint32_t version = *reinterpret_cast<const uint32_t*>(header.constData() + 4);
+	if (version != expectedVersion)
+	{
+		qWarning() << "Unexpected BIN version:" << version << "(expected:" << expectedVersion << ")";
+		return nullptr;
+	}
+
+	ccHObject container;
+	FileIOFilter::LoadParameters loadParams;
+	loadParams.alwaysDisplayLoadDialog = false;
+	if (filter.loadFile(filename, container, loadParams) != CC_FERR_NO_ERROR)
+	{
+		return nullptr;
+	}
+
+	ccHObject::Container clouds;
+	container.filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, true);
+	if (clouds.size() != 1)
+	{
+		return nullptr;
+	}
+
+	//we take the ownership of the loaded cloud
+	ccPointCloud* loaded = static_cast<ccPointCloud*>(clouds.front());
+	if (loaded->getParent())
+	{
+		loaded->getParent()->detachChild(loaded);
+	}
+	return loaded;
+}
+
+void TestBinFilter::compareClouds(const ccPointCloud& original, const ccPointCloud& loaded)
+{
+	QCOMPARE(loaded.size(), original.size());
+	QCOMPARE(loaded.getNumberOfScalarFields(), original.getNumberOfScalarFields());
+
+	const ccScalarField* originalSF = static_cast<const ccScalarField*>(original.getScalarField(0));
+	const ccScalarField* loadedSF = static_cast<const ccScalarField*>(loaded.getScalarField(0));
+	QVERIFY(loadedSF);
+	QCOMPARE(QString(loadedSF->getName()), QString(originalSF->getName()));
+
+	for (unsigned i = 0; i < original.size(); ++i)
+	{
+		const CCVector3* P = original.getPoint(i);
+		const CCVector3* Q = loaded.getPoint(i);
+		QCOMPARE(Q->x, P->x);
+		QCOMPARE(Q->y, P->y);
+		QCOMPARE(Q->z, P->z);
+		QCOMPARE(loadedSF->getValue(i), originalSF->getValue(i));
+	}
+}
+
+void TestBinFilter::testRoundTripV52() const
+{
+	QScopedPointer<ccPointCloud> cloud(createCloud(1000, true));
+	QVERIFY(cloud);
+
+	QTemporaryDir tmpDir;
+	QScopedPointer<ccPointCloud> loaded(roundTrip(*cloud, tmpDir.path() + "/v52.bin", 52));
+	QVERIFY(loaded);
+	compareClouds(*cloud, *loaded);
+	QVERIFY(static_cast<ccScalarField*>(loaded->getScalarField(0))->getStorage().type == ccScalarField::StorageType::NATIVE);
+}
+
+void TestBinFilter::testRoundTripV53() const
+{
+	QScopedPointer<ccPointCloud> cloud(createCloud(1000, true));
+	QVERIFY(cloud);
+	static_cast<ccScalarField*>(cloud->getScalarField(0))->setStorage(ccScalarField::Storage::ForRange(0, 255));
+
+	QTemporaryDir tmpDir;
+	QString filename = tmpDir.path() + "/v53.bin";
+	QScopedPointer<ccPointCloud> loaded(roundTrip(*cloud, filename, 53));
+	QVERIFY(loaded);
+	compareClouds(*cloud, *loaded);
+
+	//the preferred storage is restored
+	const ccScalarField::Storage& storage = static_cast<ccScalarField*>(loaded->getScalarField(0))->getStorage();
+	QVERIFY(storage.type == ccScalarField::StorageType::UINT8);
+	QCOMPARE(storage.scale, 1.0);
+	QCOMPARE(storage.offset, 0.0);
+
+	//the values are saved with 1 byte instead of sizeof(ScalarType)
+	QTemporaryDir nativeDir;
+	QString nativeFilename = nativeDir.path() + "/native.bin";
+	BinFilter::SetCompactScalarFields(false);
+	FileIOFilter::SaveParameters saveParams;
+	saveParams.alwaysDisplaySaveDialog = false;
+	CC_FILE_ERROR error = BinFilter().saveToFile(cloud.data(), nativeFilename, saveParams);
+	BinFilter::SetCompactScalarFields(true);
+	QVERIFY(error == CC_FERR_NO_ERROR);
+	QVERIFY(QFileInfo(filename).size() < QFileInfo(nativeFilename).size());
+}
+
+void TestBinFilter::testRoundTripCompactDisabled() const
+{
+	QScopedPointer<ccPointCloud> cloud(createCloud(1000, true));
+	QVERIFY(cloud);
+	static_cast<ccScalarField*>(cloud->getScalarField(0))->setStorage(ccScalarField::Storage::ForRange(0, 255));
+
+	QTemporaryDir tmpDir;
+	BinFilter::SetCompactScalarFields(false);
+	QScopedPointer<ccPointCloud> loaded(roundTrip(*cloud, tmpDir.path() + "/disabled.bin", 52));
+	BinFilter::SetCompactScalarFields(true);
+	QVERIFY(loaded);
+	compareClouds(*cloud, *loaded);
+}
+
+void TestBinFilter::testRoundTripLossyStorage() const
+{
+	QScopedPointer<ccPointCloud> cloud(createCloud(1000, false));
+	QVERIFY(cloud);
+	static_cast<ccScalarField*>(cloud->getScalarField(0))->setStorage(ccScalarField::Storage::ForRange(0, 255));
+
+	QTemporaryDir tmpDir;
+	QScopedPointer<ccPointCloud> loaded(roundTrip(*cloud, tmpDir.path() + "/lossy.bin", 53));
+	QVERIFY(loaded);
+	compareClouds(*cloud, *loaded);
+
+	//the values are saved with the native storage
+	QVERIFY(static_cast<ccScalarField*>(loaded->getScalarField(0))->getStorage().type == ccScalarField::StorageType::NATIVE);
+}
+
+QTEST_MAIN(TestBinFilter)
@@ -0,0 +1,43 @@
+
+#ifndef CC_TEST_BIN_FILTER_HEADER
+#define CC_TEST_BIN_FILTER_HEADER
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+class ccPointCloud;
+
+/*
+ * Save/load round-trips of BIN files (version 5.2 and 5.3)
+ * 1) create a cloud with a scalar field
+ * 2) save it
+ * 3) check the version of the file and reload it
+ */
+class TestBinFilter : public QObject
+{
+Q_OBJECT
+private slots:
+	//! A cloud without compact scalar field is saved as a 5.2 file
+	void testRoundTripV52() const;
+
+	//! A cloud with a compact scalar field is saved as a 5.3 file
+	void testRoundTripV53() const;
+
+	//! The compact storage is not used when the option is disabled (5.2 file)
+	void testRoundTripCompactDisabled() const;
+
+	//! A lossy preferred storage is not used (but the file is still a 5.3 file)
+	void testRoundTripLossyStorage() const;
+
+private:
+	//! Creates a cloud with one scalar field
+	static ccPointCloud* createCloud(unsigned pointCount, bool integerValues);
+
+	//! Saves a cloud, checks the version of the file and reloads it
+	static ccPointCloud* roundTrip(ccPointCloud& cloud, const QString& filename, unsigned expectedVersion);
+
+	//! Checks that the points and scalar values of two clouds are the same
+	static void compareClouds(const ccPointCloud& original, const ccPointCloud& loaded);
+};
+
+#endif //CC_TEST_BIN_FILTER_HEADER
@@ -54,7 +54,7 @@ ObjFilter::ObjFilter()
 					"obj",
 					QStringList{ "OBJ mesh (*.obj)" },
 					QStringList{ "OBJ mesh (*.obj)" },
-					Import | Export
+					Import | Export | Reentrant
 					} )
 {
 }
@@ -1357,6 +1357,32 @@ CC_FILE_ERROR ObjFilter::loadFile(const QString& filename, ccHObject& container,
 				ccLog::Warning("File contains normals which seem to be neither per-vertex nor per-face!!! We had to ignore them...");
 			}
 		}
+
+		//weld the duplicated vertices (if requested)
+		if (!error && parameters.weldMeshVertices && baseMesh && vertices)
+		{
+			if (vertices->getChildrenNumber() != 0)
+			{
+				//the polylines share the same vertices
+				ccLog::Warning("[OBJ] Mesh vertices can't be welded (they are shared with polylines)");
+			}
+			else
+			{
+				ccMesh::WeldingParameters weldingParams;
+				weldingParams.epsilon = parameters.meshWeldingTolerance;
+
+				QScopedPointer<ccProgressDialog> weldingDlg(nullptr);
+				if (parameters.parentWidget)
+				{
+					weldingDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+				}
+				if (!baseMesh->weldVertices(weldingParams, nullptr, weldingDlg.data()))
+				{
+					ccLog::Warning("[OBJ] Failed to weld the mesh vertices");
+				}
+				vertices = nullptr; //warning, after this point, 'vertices' may not be valid anymore
+			}
+		}
 	}
 
 	if (error)
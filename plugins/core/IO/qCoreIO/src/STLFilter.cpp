@@ -48,7 +48,7 @@ STLFilter::STLFilter()
 					"stl",
 					QStringList{ "STL mesh (*.stl)" },
 					QStringList{ "STL mesh (*.stl)" },
-					Import | Export
+					Import | Export | Reentrant
 					} )
 {	
 }
@@ -361,12 +361,22 @@ CC_FILE_ERROR STLFilter::loadFile(const QString& filename, ccHObject& container,
 		}
 	}
 
-	//remove duplicated vertices
-	mesh->mergeDuplicatedVertices(ccMesh::DefaultMergeDulicateVerticesLevel, parameters.parentWidget);
+	//remove duplicated vertices (and the degenerate/duplicate triangles)
+	{
+		ccMesh::WeldingParameters weldingParams;
+		weldingParams.epsilon = (parameters.weldMeshVertices ? parameters.meshWeldingTolerance : ccMesh::DefaultWeldingTolerance());
+
+		QScopedPointer<ccProgressDialog> pDlg;
+		if (parameters.parentWidget)
+		{
+			pDlg.reset(new ccProgressDialog(true, parameters.parentWidget));
+		}
+		mesh->weldVertices(weldingParams, nullptr, pDlg.data());
+	}
 	vertices = nullptr; //warning, after this point, 'vertices' is not valid anymore
 
 	ccGenericPointCloud* meshVertices = mesh->getAssociatedCloud();
-	if (mesh->size() != 0 && meshVertices) //their might not remain anymore triangle after 'mergeDuplicatedVertices'
+	if (mesh->size() != 0 && meshVertices) //their might not remain anymore triangle after 'weldVertices'
 	{
 		NormsIndexesTableType* normals = mesh->getTriNormsTable();
 		if (normals)
@@ -44,7 +44,7 @@ SimpleBinFilter::SimpleBinFilter()
 					"sbf",
 					QStringList{ "Simple binary file (*.sbf)" },
 					QStringList{ "Simple binary file (*.sbf)" },
-					Import | Export
+					Import | Export | Reentrant
 					} )
 {
 }
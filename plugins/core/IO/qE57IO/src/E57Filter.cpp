@@ -40,6 +40,7 @@
 
 //system
 #include <cassert>
+#include <cmath>
 #include <string>
 
 using colorFieldType = double;
@@ -464,7 +465,18 @@ static bool SaveScan(ccPointCloud* cloud, e57::StructureNode& scanNode, e57::Ima
 	//Intensity field
 	if (intensitySF)
 	{
-		proto.set("intensity", e57::FloatNode(imf, intensitySF->getMin(), sizeof(ScalarType) == 8 ? e57::E57_DOUBLE : e57::E57_SINGLE, intensitySF->getMin(), intensitySF->getMax()));
+		//8 or 16 bits quantized intensities can be stored as scaled integers (more compact)
+		ccScalarField::Storage storage = (hasInvalidIntensities ? ccScalarField::Storage() : intensitySF->getCompactStorage());
+		if (storage.type == ccScalarField::StorageType::UINT8 || storage.type == ccScalarField::StorageType::UINT16)
+		{
+			int64_t minCode = static_cast<int64_t>(std::round((intensitySF->getMin() - storage.offset) / storage.scale));
+			int64_t maxCode = static_cast<int64_t>(std::round((intensitySF->getMax() - storage.offset) / storage.scale));
+			proto.set("intensity", e57::ScaledIntegerNode(imf, minCode, minCode, maxCode, storage.scale, storage.offset));
+		}
+		else
+		{
+			proto.set("intensity", e57::FloatNode(imf, intensitySF->getMin(), sizeof(ScalarType) == 8 ? e57::E57_DOUBLE : e57::E57_SINGLE, intensitySF->getMin(), intensitySF->getMax()));
+		}
 		arrays.intData.resize(chunkSize);
 		dbufs.emplace_back( imf, "intensity",  arrays.intData.data(),  chunkSize, true, true );
 
@@ -1653,6 +1665,12 @@ static ccHObject* LoadScan(const e57::Node& node, QString& guidStr, ccProgressDi
 	if (header.pointFields.intensityField)
 	{
 		intensitySF = new ccScalarField(CC_E57_INTENSITY_FIELD_NAME);
+		if (header.pointFields.intensityScaledInteger != 0)
+		{
+			//integer or scaled integer intensities
+			double scale = (header.pointFields.intensityScaledInteger > 0 ? header.pointFields.intensityScaledInteger : 1.0);
+			intensitySF->setStorage(ccScalarField::Storage::ForRange(header.intensityLimits.intensityMinimum, header.intensityLimits.intensityMaximum, scale));
+		}
 		if (!intensitySF->resizeSafe(static_cast<unsigned>(pointCount)))
 		{
 			ccLog::Error("[E57] Not enough memory!");
@@ -1728,6 +1746,7 @@ static ccHObject* LoadScan(const e57::Node& node, QString& guidStr, ccProgressDi
 	{
 		//we store the point return index as a scalar field
 		returnIndexSF = new ccScalarField(CC_E57_RETURN_INDEX_FIELD_NAME);
+		returnIndexSF->setStorage(ccScalarField::Storage::ForRange(0, header.pointFields.returnMaximum));
 		if (!returnIndexSF->resizeSafe(static_cast<unsigned>(pointCount)))
 		{
 			ccLog::Error("[E57] Not enough memory!");
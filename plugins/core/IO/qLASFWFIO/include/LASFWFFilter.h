@@ -35,6 +35,8 @@ public:
 
 	bool canSave(CC_CLASS_ENUM type, bool& multiple, bool& exclusive) const override;
 	CC_FILE_ERROR saveToFile(ccHObject* entity, const QString& filename, const SaveParameters& parameters) override;
+	ChunkReader::Shared openChunkReader(const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error) override;
+	ChunkWriter::Shared openChunkWriter(const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error) override;
 };
 
 #endif //CC_LAS_FWF_FILTER_HEADER
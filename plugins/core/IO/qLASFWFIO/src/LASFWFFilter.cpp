@@ -45,6 +45,7 @@
 
 //system
 #include <assert.h>
+#include <cmath>
 #include <string.h>
 
 //! Custom ("Extra bytes") field (EVLR)
@@ -70,11 +71,14 @@ struct ExtraLasField : LasField
 	typedef QSharedPointer<ExtraLasField> Shared;
 
 	inline QString getName() const override { return fieldName; }
+	inline ccScalarField::Storage getStorage() const override { return storage; }
 
 	QString fieldName;
 	QString sanitizedName;
 	bool isShifted;
 	I32 startIndex;
+	//! Compact storage of the values (depends on the attribute type)
+	ccScalarField::Storage storage;
 };
 
 //! LAS Save dialog
@@ -116,6 +120,268 @@ public:
 	}
 };
 
+//! Sets the value of a standard LAS field for a given point
+static void SetLASFieldValue(LASpoint& laspoint, const LasField& field, unsigned pointIndex, bool pointFormatSixOrAbove)
+{
+	assert(field.sf);
+	ScalarType value = field.sf->getValue(pointIndex);
+	switch (field.type)
+	{
+	case LAS_X:
+	case LAS_Y:
+	case LAS_Z:
+		assert(false);
+		break;
+	case LAS_INTENSITY:
+		laspoint.set_intensity(static_cast<U16>(value));
+		break;
+	case LAS_RETURN_NUMBER:
+		laspoint.set_return_number(static_cast<U8>(value));
+		break;
+	case LAS_NUMBER_OF_RETURNS:
+		laspoint.set_number_of_returns(static_cast<U8>(value));
+		break;
+	case LAS_SCAN_DIRECTION:
+		laspoint.set_scan_direction_flag(static_cast<U8>(value));
+		break;
+	case LAS_FLIGHT_LINE_EDGE:
+		laspoint.set_edge_of_flight_line(static_cast<U8>(value));
+		break;
+	case LAS_CLASSIFICATION:
+		if (pointFormatSixOrAbove)
+		{
+			laspoint.set_extended_classification(static_cast<U8>(value));
+		}
+		else
+		{
+			//we have to decompose the field so that LASlib handles it properly
+			U8 classif = static_cast<U8>(value);
+			laspoint.set_classification(classif & 31);
+			laspoint.set_synthetic_flag(classif & 32);
+			laspoint.set_keypoint_flag(classif & 64);
+			laspoint.set_withheld_flag(classif & 128);
+		}
+		break;
+	case LAS_SCAN_ANGLE_RANK:
+		laspoint.set_scan_angle_rank(static_cast<U8>(value));
+		break;
+	case LAS_USER_DATA:
+		laspoint.set_user_data(static_cast<U8>(value));
+		break;
+	case LAS_POINT_SOURCE_ID:
+		laspoint.set_point_source_ID(static_cast<U16>(value));
+		break;
+	case LAS_RED:
+	case LAS_GREEN:
+	case LAS_BLUE:
+		assert(false);
+		break;
+	case LAS_TIME:
+		laspoint.set_gps_time(static_cast<F64>(value) + field.sf->getGlobalShift());
+		break;
+	case LAS_CLASSIF_VALUE:
+		if (pointFormatSixOrAbove)
+		{
+			laspoint.set_extended_classification(static_cast<U8>(value)); //8 bits
+		}
+		else
+		{
+			laspoint.set_classification(static_cast<U8>(value) & 31); //5 first bits
+		}
+		break;
+	case LAS_CLASSIF_SYNTHETIC:
+		laspoint.set_synthetic_flag(value != 0 ? 1 : 0);
+		break;
+	case LAS_CLASSIF_KEYPOINT:
+		laspoint.set_keypoint_flag(value != 0 ? 1 : 0);
+		break;
+	case LAS_CLASSIF_WITHHELD:
+		laspoint.set_withheld_flag(value != 0 ? 1 : 0);
+		break;
+	case LAS_CLASSIF_OVERLAP:
+		laspoint.set_extended_overlap_flag(value != 0 ? 1 : 0);
+		break;
+	case LAS_INVALID:
+	default:
+		assert(false);
+		break;
+	}
+}
+
+//! Sets the value of an extra field for a given point
+static void SetExtraFieldValue(LASpoint& laspoint, const ExtraLasField& f, unsigned pointIndex)
+{
+	ScalarType s = f.sf->getValue(pointIndex);
+	if (f.isShifted)
+	{
+		double sd = s + f.sf->getGlobalShift();
+		laspoint.set_attribute(f.startIndex, sd);
+	}
+	else if (f.storage.type == ccScalarField::StorageType::UINT8)
+	{
+		U8 code = 0;
+		ccScalarField::Encode(f.storage, &s, 1, &code);
+		laspoint.set_attribute(f.startIndex, code);
+	}
+	else if (f.storage.type == ccScalarField::StorageType::UINT16)
+	{
+		U16 code = 0;
+		ccScalarField::Encode(f.storage, &s, 1, &code);
+		laspoint.set_attribute(f.startIndex, code);
+	}
+	else
+	{
+		laspoint.set_attribute(f.startIndex, s);
+	}
+}
+
+//! Returns the standard and extra fields that can be loaded from a LAS file
+static void GetFieldsToLoad(const LASheader& header, std::vector< LasField::Shared >& fieldsToLoad)
+{
+	if (header.point_data_format >= 6)
+	{
+		fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIFICATION, 0, 0, 255))); //unsigned char: between 0 and 255
+		fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_OVERLAP, 0, 0, 1))); //1 bit: 0 or 1
+	}
+	else
+	{
+		fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_VALUE, 0, 0, 31))); //5 bits: between 0 and 31
+	}
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_SYNTHETIC, 0, 0, 1))); //1 bit: 0 or 1
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_KEYPOINT, 0, 0, 1))); //1 bit: 0 or 1
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_WITHHELD, 0, 0, 1))); //1 bit: 0 or 1
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_INTENSITY, 0, 0, 65535))); //16 bits: between 0 and 65536
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_TIME, 0, 0, -1.0))); //8 bytes (double) --> we use global shift!
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_RETURN_NUMBER, 1, 1, 7))); //3 bits: between 1 and 7
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_NUMBER_OF_RETURNS, 1, 1, 7))); //3 bits: between 1 and 7
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_SCAN_DIRECTION, 0, 0, 1))); //1 bit: 0 or 1
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_FLIGHT_LINE_EDGE, 0, 0, 1))); //1 bit: 0 or 1
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_SCAN_ANGLE_RANK, 0, -90, 90))); //signed char: between -90 and +90
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_USER_DATA, 0, 0, 255))); //unsigned char: between 0 and 255
+	fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_POINT_SOURCE_ID, 0, 0, 65535))); //16 bits: between 0 and 65536
+
+	//now for the extra values
+	for (I32 i = 0; i < header.number_attributes; ++i)
+	{
+		const LASattribute& attribute = header.attributes[i];
+		ExtraLasField* field = new ExtraLasField(attribute.name);
+		field->startIndex = i; // header.attribute_starts[i];
+		field->isShifted = (attribute.data_type == 10);
+
+		//8 and 16 bits attributes can be stored in a compact way
+		double scale = (attribute.has_scale() ? attribute.scale[0] : 1.0);
+		double offset = (attribute.has_offset() ? attribute.offset[0] : 0.0);
+		switch (attribute.get_type())
+		{
+		case LAS_ATTRIBUTE_U8:
+			field->storage = ccScalarField::Storage::ForRange(offset, offset + 255 * scale, scale);
+			break;
+		case LAS_ATTRIBUTE_I8:
+			field->storage = ccScalarField::Storage::ForRange(offset - 128 * scale, offset + 127 * scale, scale);
+			break;
+		case LAS_ATTRIBUTE_U16:
+			field->storage = ccScalarField::Storage::ForRange(offset, offset + 65535 * scale, scale);
+			break;
+		case LAS_ATTRIBUTE_I16:
+			field->storage = ccScalarField::Storage::ForRange(offset - 32768 * scale, offset + 32767 * scale, scale);
+			break;
+		default:
+			break;
+		}
+		fieldsToLoad.push_back(LasField::Shared(field));
+	}
+}
+
+//! Returns the value of a (standard or extra) LAS field for the current point
+/** \return false if the field is not handled
+**/
+static bool GetLASFieldValue(const LASpoint& point, const LasField& field, bool pointFormatSixOrAbove, double& value)
+{
+	switch (field.type)
+	{
+	case LAS_INTENSITY:
+		value = static_cast<double>(point.get_intensity());
+		break;
+	case LAS_RETURN_NUMBER:
+		value = static_cast<double>(point.get_return_number());
+		break;
+	case LAS_NUMBER_OF_RETURNS:
+		value = static_cast<double>(point.get_number_of_returns());
+		break;
+	case LAS_SCAN_DIRECTION:
+		value = static_cast<double>(point.get_scan_direction_flag());
+		break;
+	case LAS_FLIGHT_LINE_EDGE:
+		value = static_cast<double>(point.get_edge_of_flight_line());
+		break;
+	case LAS_CLASSIFICATION:
+		if (pointFormatSixOrAbove)
+		{
+			value = static_cast<double>(point.get_extended_classification());
+		}
+		else
+		{
+			//warning: compared to the other LAS filters, the 'LAS_CLASSIFICATION'
+			//field corresponds to the full 8 bits (for point format < 6)
+			value = static_cast<double>(point.get_classification()
+				+ point.get_synthetic_flag() * 32
+				+ point.get_keypoint_flag() * 64
+				+ point.get_withheld_flag() * 128);
+		}
+		break;
+	case LAS_SCAN_ANGLE_RANK:
+		value = static_cast<double>(point.get_scan_angle_rank());
+		break;
+	case LAS_USER_DATA:
+		value = static_cast<double>(point.get_user_data());
+		break;
+	case LAS_POINT_SOURCE_ID:
+		value = static_cast<double>(point.get_point_source_ID());
+		break;
+	case LAS_TIME:
+		value = point.get_gps_time();
+		break;
+	case LAS_CLASSIF_VALUE:
+		if (pointFormatSixOrAbove)
+			value = static_cast<double>(point.get_extended_classification()); //8 bits
+		else
+			value = static_cast<double>(point.get_classification() & 31); //5 bits
+		break;
+	case LAS_CLASSIF_SYNTHETIC:
+		if (pointFormatSixOrAbove)
+			value = static_cast<double>(point.get_synthetic_flag() << 5); //shift the value so as to give the same result as with older versions
+		else
+			value = static_cast<double>(point.get_classification() & 32); //bit #6
+		break;
+	case LAS_CLASSIF_KEYPOINT:
+		if (pointFormatSixOrAbove)
+			value = static_cast<double>(point.get_keypoint_flag() << 6); //shift the value so as to give the same result as with older versions
+		else
+			value = static_cast<double>(point.get_classification() & 64); //bit #7
+		break;
+	case LAS_CLASSIF_WITHHELD:
+		if (pointFormatSixOrAbove)
+			value = static_cast<double>(point.get_withheld_flag() << 7); //shift the value so as to give the same result as with older versions
+		else
+			value = static_cast<double>(point.get_classification() & 128); //bit #8
+		break;
+	case LAS_CLASSIF_OVERLAP:
+		if (pointFormatSixOrAbove)
+			value = static_cast<double>(point.get_extended_overlap_flag());
+		else
+			value = 0; //not present in point format < 6
+		break;
+	case LAS_EXTRA:
+		value = point.get_attribute_as_float(static_cast<const ExtraLasField&>(field).startIndex);
+		break;
+	default:
+		//ignored
+		return false;
+	}
+
+	return true;
+}
+
 LASFWFFilter::LASFWFFilter()
     : FileIOFilter( {
                     "_LASFW Filter",
@@ -124,7 +390,7 @@ LASFWFFilter::LASFWFFilter()
                     "las",
                     QStringList{ GetFileFilter() },
                     QStringList{ GetFileFilter() },
-                    Import | Export
+                    Import | Export | Streaming
                     } )
 {
 }
@@ -450,9 +716,31 @@ CC_FILE_ERROR LASFWFFilter::saveToFile(ccHObject* entity, const QString& filenam
 				{
 					assert(f.sf);
 
-					LASattribute attribute(f.isShifted || sizeof(ScalarType) == 8 ? LAS_ATTRIBUTE_F64 : LAS_ATTRIBUTE_F32, qPrintable(f.sanitizedName), "additional attributes");
-					lasheader.point_data_record_length += (attribute.data_type == LAS_ATTRIBUTE_F32 + 1 ? 4 : 8); //strangely, LASlib shifts the official type indexes :|
-					I32 attributeIndex = lasheader.add_attribute(attribute);
+					//can we store the values in a compact way?
+					if (!f.isShifted)
+					{
+						f.storage = f.sf->getCompactStorage();
+					}
+
+					I32 attributeIndex = -1;
+					if (f.storage.type == ccScalarField::StorageType::UINT8 || f.storage.type == ccScalarField::StorageType::UINT16)
+					{
+						bool is8Bits = (f.storage.type == ccScalarField::StorageType::UINT8);
+						LASattribute attribute(is8Bits ? LAS_ATTRIBUTE_U8 : LAS_ATTRIBUTE_U16, qPrintable(f.sanitizedName), "additional attributes");
+						if (f.storage.scale != 1.0)
+							attribute.set_scale(f.storage.scale);
+						if (f.storage.offset != 0.0)
+							attribute.set_offset(f.storage.offset);
+						lasheader.point_data_record_length += (is8Bits ? 1 : 2);
+						attributeIndex = lasheader.add_attribute(attribute);
+					}
+					else
+					{
+						f.storage = ccScalarField::Storage();
+						LASattribute attribute(f.isShifted || sizeof(ScalarType) == 8 ? LAS_ATTRIBUTE_F64 : LAS_ATTRIBUTE_F32, qPrintable(f.sanitizedName), "additional attributes");
+						lasheader.point_data_record_length += (attribute.data_type == LAS_ATTRIBUTE_F32 + 1 ? 4 : 8); //strangely, LASlib shifts the official type indexes :|
+						attributeIndex = lasheader.add_attribute(attribute);
+					}
 					f.startIndex = lasheader.get_attribute_start(attributeIndex);
 
 					//U8* data = new U8[192];
@@ -533,94 +821,9 @@ CC_FILE_ERROR LASFWFFilter::saveToFile(ccHObject* entity, const QString& filenam
 			}
 
 			//additional fields
-			for (std::vector<LasField>::const_iterator it = fieldsToSave.begin(); it != fieldsToSave.end(); ++it)
+			for (const LasField& f : fieldsToSave)
 			{
-				assert(it->sf);
-				switch (it->type)
-				{
-				case LAS_X:
-				case LAS_Y:
-				case LAS_Z:
-					assert(false);
-					break;
-				case LAS_INTENSITY:
-					laspoint.set_intensity(static_cast<U16>(it->sf->getValue(i)));
-					break;
-				case LAS_RETURN_NUMBER:
-					laspoint.set_return_number(static_cast<U8>(it->sf->getValue(i)));
-					break;
-				case LAS_NUMBER_OF_RETURNS:
-					laspoint.set_number_of_returns(static_cast<U8>(it->sf->getValue(i)));
-					break;
-				case LAS_SCAN_DIRECTION:
-					laspoint.set_scan_direction_flag(static_cast<U8>(it->sf->getValue(i)));
-					break;
-				case LAS_FLIGHT_LINE_EDGE:
-					laspoint.set_edge_of_flight_line(static_cast<U8>(it->sf->getValue(i)));
-					break;
-				case LAS_CLASSIFICATION:
-					if (pointFormatSixOrAbove)
-					{
-						laspoint.set_extended_classification(static_cast<U8>(it->sf->getValue(i)));
-					}
-					else
-					{
-						//we have to decompose the field so that LASlib handles it properly
-						U8 classif = static_cast<U8>(it->sf->getValue(i));
-						laspoint.set_classification(classif & 31);
-						laspoint.set_synthetic_flag(classif & 32);
-						laspoint.set_keypoint_flag(classif & 64);
-						laspoint.set_withheld_flag(classif & 128);
-					}
-					break;
-				case LAS_SCAN_ANGLE_RANK:
-					laspoint.set_scan_angle_rank(static_cast<U8>(it->sf->getValue(i)));
-					break;
-				case LAS_USER_DATA:
-					laspoint.set_user_data(static_cast<U8>(it->sf->getValue(i)));
-					break;
-				case LAS_POINT_SOURCE_ID:
-					laspoint.set_point_source_ID(static_cast<U16>(it->sf->getValue(i)));
-					break;
-				case LAS_RED:
-				case LAS_GREEN:
-				case LAS_BLUE:
-					assert(false);
-					break;
-				case LAS_TIME:
-					laspoint.set_gps_time(static_cast<F64>(it->sf->getValue(i)) + it->sf->getGlobalShift());
-					break;
-				case LAS_CLASSIF_VALUE:
-					if (pointFormatSixOrAbove)
-					{
-						laspoint.set_extended_classification(static_cast<U8>(it->sf->getValue(i))); //8 bits
-					}
-					else
-					{
-						laspoint.set_classification(static_cast<U8>(it->sf->getValue(i)) & 31); //5 first bits
-					}
-					break;
-				case LAS_CLASSIF_SYNTHETIC:
-					if (it->sf->getValue(i) != 0)
-						laspoint.set_synthetic_flag(1);
-					break;
-				case LAS_CLASSIF_KEYPOINT:
-					if (it->sf->getValue(i) != 0)
-						laspoint.set_keypoint_flag(1);
-					break;
-				case LAS_CLASSIF_WITHHELD:
-					if (it->sf->getValue(i) != 0)
-						laspoint.set_withheld_flag(1);
-					break;
-				case LAS_CLASSIF_OVERLAP:
-					if (it->sf->getValue(i) != 0)
-						laspoint.set_extended_overlap_flag(1);
-					break;
-				case LAS_INVALID:
-				default:
-					assert(false);
-					break;
-				}
+				SetLASFieldValue(laspoint, f, i, pointFormatSixOrAbove);
 			}
 
 			if (hasColors)
@@ -664,16 +867,7 @@ CC_FILE_ERROR LASFWFFilter::saveToFile(ccHObject* entity, const QString& filenam
 			//extra fields
 			for (const ExtraLasField& f : extraFieldsToSave)
 			{
-				ScalarType s = f.sf->getValue(i);
-				if (f.isShifted)
-				{
-					double sd = s + f.sf->getGlobalShift();
-					laspoint.set_attribute(f.startIndex, sd);
-				}
-				else
-				{
-					laspoint.set_attribute(f.startIndex, s);
-				}
+				SetExtraFieldValue(laspoint, f, i);
 			}
 
 			//write the point
@@ -730,6 +924,7 @@ bool PrepareLASField(ccScalarField*& sf, LasField* lasField, unsigned totalCount
 	{
 		sf = new ccScalarField(LAS_FIELD_NAMES[lasField->type]);
 	}
+	sf->setStorage(lasField->getStorage());
 
 	//try to reserve the memory to store the field values
 	if (!sf->reserveSafe(totalCount))
@@ -809,39 +1004,7 @@ CC_FILE_ERROR LASFWFFilter::loadFile(const QString& filename, ccHObject& contain
 
 		//DGM: from now on, we only enable scalar fields when we detect a valid value!
 		std::vector< LasField::Shared > fieldsToLoad;
-		{
-			if (pointFormatSixOrAbove)
-			{
-				fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIFICATION, 0, 0, 255))); //unsigned char: between 0 and 255
-				fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_OVERLAP, 0, 0, 1))); //1 bit: 0 or 1
-			}
-			else
-			{
-				fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_VALUE, 0, 0, 31))); //5 bits: between 0 and 31
-			}
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_SYNTHETIC, 0, 0, 1))); //1 bit: 0 or 1
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_KEYPOINT, 0, 0, 1))); //1 bit: 0 or 1
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_CLASSIF_WITHHELD, 0, 0, 1))); //1 bit: 0 or 1
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_INTENSITY, 0, 0, 65535))); //16 bits: between 0 and 65536
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_TIME, 0, 0, -1.0))); //8 bytes (double) --> we use global shift!
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_RETURN_NUMBER, 1, 1, 7))); //3 bits: between 1 and 7
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_NUMBER_OF_RETURNS, 1, 1, 7))); //3 bits: between 1 and 7
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_SCAN_DIRECTION, 0, 0, 1))); //1 bit: 0 or 1
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_FLIGHT_LINE_EDGE, 0, 0, 1))); //1 bit: 0 or 1
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_SCAN_ANGLE_RANK, 0, -90, 90))); //signed char: between -90 and +90
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_USER_DATA, 0, 0, 255))); //unsigned char: between 0 and 255
-			fieldsToLoad.push_back(LasField::Shared(new LasField(LAS_POINT_SOURCE_ID, 0, 0, 65535))); //16 bits: between 0 and 65536
-		}
-
-		//now for the extra values
-		for (I32 i = 0; i < lasreader.header.number_attributes; ++i)
-		{
-			const LASattribute& attribute = lasreader.header.attributes[i];
-			ExtraLasField* field = new ExtraLasField(attribute.name);
-			field->startIndex = i; // lasreader.header.attribute_starts[i];
-			field->isShifted = (attribute.data_type == 10);
-			fieldsToLoad.push_back(LasField::Shared(field));
-		}
+		GetFieldsToLoad(lasreader.header, fieldsToLoad);
 
 		bool hasFWF = (lasreader.header.vlr_wave_packet_descr != 0);
 		for (int fakeIteration = 0; hasFWF && fakeIteration < 1; ++fakeIteration)
@@ -1101,92 +1264,16 @@ CC_FILE_ERROR LASFWFFilter::loadFile(const QString& filename, ccHObject& contain
 			for (LasField::Shared& field : fieldsToLoad)
 			{
 				double value = 0.0;
-				switch (field->type)
+				if (!GetLASFieldValue(point, *field, pointFormatSixOrAbove, value))
 				{
-				case LAS_INTENSITY:
-					value = static_cast<double>(point.get_intensity());
-					break;
-				case LAS_RETURN_NUMBER:
-					value = static_cast<double>(point.get_return_number());
-					break;
-				case LAS_NUMBER_OF_RETURNS:
-					value = static_cast<double>(point.get_number_of_returns());
-					break;
-				case LAS_SCAN_DIRECTION:
-					value = static_cast<double>(point.get_scan_direction_flag());
-					break;
-				case LAS_FLIGHT_LINE_EDGE:
-					value = static_cast<double>(point.get_edge_of_flight_line());
-					break;
-				case LAS_CLASSIFICATION:
-					if (pointFormatSixOrAbove)
-					{
-						value = static_cast<double>(point.get_extended_classification());
-					}
-					else
-					{
-						//warning: compared to the other LAS filters, the 'LAS_CLASSIFICATION'
-						//field corresponds to the full 8 bits (for point format < 6)
-						value = static_cast<double>(point.get_classification()
-							+ point.get_synthetic_flag() * 32
-							+ point.get_keypoint_flag() * 64
-							+ point.get_withheld_flag() * 128);
-					}
-					break;
-				case LAS_SCAN_ANGLE_RANK:
-					value = static_cast<double>(point.get_scan_angle_rank());
-					break;
-				case LAS_USER_DATA:
-					value = static_cast<double>(point.get_user_data());
-					break;
-				case LAS_POINT_SOURCE_ID:
-					value = static_cast<double>(point.get_point_source_ID());
-					break;
-				case LAS_TIME:
-					value = point.get_gps_time();
-					if (field->sf)
-					{
-						//shift time values (so as to avoid losing accuracy)
-						value -= field->sf->getGlobalShift();
-					}
-					break;
-				case LAS_CLASSIF_VALUE:
-					if (pointFormatSixOrAbove)
-						value = static_cast<double>(point.get_extended_classification()); //8 bits
-					else
-						value = static_cast<double>(point.get_classification() & 31); //5 bits
-					break;
-				case LAS_CLASSIF_SYNTHETIC:
-					if (pointFormatSixOrAbove)
-						value = static_cast<double>(point.get_synthetic_flag() << 5); //shift the value so as to give the same result as with older versions
-					else
-						value = static_cast<double>(point.get_classification() & 32); //bit #6
-					break;
-				case LAS_CLASSIF_KEYPOINT:
-					if (pointFormatSixOrAbove)
-						value = static_cast<double>(point.get_keypoint_flag() << 6); //shift the value so as to give the same result as with older versions
-					else
-						value = static_cast<double>(point.get_classification() & 64); //bit #7
-					break;
-				case LAS_CLASSIF_WITHHELD:
-					if (pointFormatSixOrAbove)
-						value = static_cast<double>(point.get_withheld_flag() << 7); //shift the value so as to give the same result as with older versions
-					else
-						value = static_cast<double>(point.get_classification() & 128); //bit #8
-					break;
-				case LAS_CLASSIF_OVERLAP:
-					if (pointFormatSixOrAbove)
-						value = static_cast<double>(point.get_extended_overlap_flag());
-					else
-						value = 0; //not present in point format < 6
-					break;
-				case LAS_EXTRA:
-					value = point.get_attribute_as_float(static_cast<ExtraLasField*>(field.data())->startIndex);
-					break;
-				default:
 					//ignored
 					continue;
 				}
+				if (field->type == LAS_TIME && field->sf)
+				{
+					//shift time values (so as to avoid losing accuracy)
+					value -= field->sf->getGlobalShift();
+				}
 
 				if (field->sf)
 				{
@@ -1328,3 +1415,562 @@ CC_FILE_ERROR LASFWFFilter::loadFile(const QString& filename, ccHObject& contain
 
 	return result;
 }
+
+//! LAS point cloud reader (chunk by chunk)
+/** Contrary to LASFWFFilter::loadFile, all the standard fields of the point format
+	are loaded (even if their values are all the same) so that all the chunks share
+	the same scalar fields. Waveforms are not supported.
+**/
+class LASFWFChunkReader : public FileIOFilter::ChunkReader
+{
+public:
+
+	explicit LASFWFChunkReader(const FileIOFilter::LoadParameters& parameters)
+		: m_parameters(parameters)
+		, m_pointFormatSixOrAbove(false)
+		, m_hasColors(false)
+		, m_colorBitDec(0)
+		, m_pointsRead(0)
+		, m_Pshift(0, 0, 0)
+		, m_preserveCoordinateShift(true)
+	{}
+
+	~LASFWFChunkReader() override
+	{
+		m_lasreader.close();
+	}
+
+	//! Opens the file
+	CC_FILE_ERROR open(const QString& filename)
+	{
+		if (!m_lasreader.open(qUtf8Printable(filename)))
+		{
+			ccLog::Warning("LASLib", "Failed to open 'lasreader'");
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		const LASheader& header = m_lasreader.header;
+		ccLog::Print(QString("[LASLib] File version: %1.%2").arg(header.version_major).arg(header.version_minor));
+		ccLog::Print(QString("[LASLib] Point format: %1").arg(header.point_data_format));
+		m_pointFormatSixOrAbove = (header.point_data_format >= 6);
+		m_hasColors = (m_lasreader.point.have_rgb != 0);
+
+		if (header.vlr_wave_packet_descr != 0)
+		{
+			ccLog::Warning("[LAS] Waveforms are not supported in streaming mode (they will be ignored)");
+		}
+
+		GetFieldsToLoad(header, m_fields);
+		if (!m_lasreader.point.have_gps_time)
+		{
+			for (size_t i = 0; i < m_fields.size(); ++i)
+			{
+				if (m_fields[i]->type == LAS_TIME)
+				{
+					m_fields.erase(m_fields.begin() + i);
+					break;
+				}
+			}
+		}
+		m_fieldShifts.resize(m_fields.size(), 0.0);
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	//inherited from FileIOFilter::ChunkReader
+	ccPointCloud* readChunk(unsigned maxCount, CC_FILE_ERROR& error) override
+	{
+		error = CC_FERR_NO_ERROR;
+		if (maxCount == 0)
+		{
+			return nullptr;
+		}
+
+		try
+		{
+			unsigned capacity = maxCount;
+			if (m_lasreader.npoints > static_cast<I64>(m_pointsRead))
+			{
+				capacity = static_cast<unsigned>(std::min<I64>(capacity, m_lasreader.npoints - m_pointsRead));
+			}
+
+			QScopedPointer<ccPointCloud> cloud(new ccPointCloud("unnamed"));
+			if (!cloud->reserve(capacity) || (m_hasColors && !cloud->reserveTheRGBTable()))
+			{
+				error = CC_FERR_NOT_ENOUGH_MEMORY;
+				return nullptr;
+			}
+			if (m_pointsRead != 0 && m_preserveCoordinateShift)
+			{
+				cloud->setGlobalShift(m_Pshift);
+			}
+
+			const LASheader& header = m_lasreader.header;
+			cloud->setMetaData(LAS_SCALE_X_META_DATA, QVariant(header.x_scale_factor));
+			cloud->setMetaData(LAS_SCALE_Y_META_DATA, QVariant(header.y_scale_factor));
+			cloud->setMetaData(LAS_SCALE_Z_META_DATA, QVariant(header.z_scale_factor));
+			cloud->setMetaData(LAS_OFFSET_X_META_DATA, QVariant(header.x_offset));
+			cloud->setMetaData(LAS_OFFSET_Y_META_DATA, QVariant(header.y_offset));
+			cloud->setMetaData(LAS_OFFSET_Z_META_DATA, QVariant(header.z_offset));
+
+			//the scalar fields belong to the cloud right away
+			std::vector<ccScalarField*> sfs(m_fields.size(), nullptr);
+			for (size_t i = 0; i < m_fields.size(); ++i)
+			{
+				const LasField& field = *m_fields[i];
+				ccScalarField* sf = new ccScalarField(field.type == LAS_EXTRA ? qPrintable(field.getName()) : LAS_FIELD_NAMES[field.type]);
+				sf->setStorage(field.getStorage());
+				sf->link();
+				bool success = (sf->reserveSafe(capacity) && cloud->addScalarField(sf) >= 0);
+				sf->release();
+				if (!success)
+				{
+					error = CC_FERR_NOT_ENOUGH_MEMORY;
+					return nullptr;
+				}
+				sfs[i] = sf;
+			}
+
+			while (cloud->size() < capacity && m_lasreader.read_point())
+			{
+				const LASpoint& point = m_lasreader.point;
+
+				CCVector3d P(	point.quantizer->get_x(point.X),
+								point.quantizer->get_y(point.Y),
+								point.quantizer->get_z(point.Z));
+
+				if (m_pointsRead == 0) //first point
+				{
+					//same global shift handling as LASFWFFilter::loadFile (the same shift is applied to all the chunks)
+					CCVector3d lasShift = -CCVector3d(header.x_offset, header.y_offset, header.z_offset);
+					ccGlobalShiftManager::Mode csModeBackup = m_parameters.shiftHandlingMode;
+					bool useLasShift = false;
+					if (lasShift.norm2() != 0 && (!m_parameters.coordinatesShiftEnabled || !*m_parameters.coordinatesShiftEnabled))
+					{
+						useLasShift = true;
+						m_Pshift = lasShift;
+						if (	csModeBackup != ccGlobalShiftManager::NO_DIALOG
+							&&	csModeBackup != ccGlobalShiftManager::NO_DIALOG_AUTO_SHIFT)
+						{
+							m_parameters.shiftHandlingMode = ccGlobalShiftManager::ALWAYS_DISPLAY_DIALOG;
+						}
+					}
+					if (FileIOFilter::HandleGlobalShift(P, m_Pshift, m_preserveCoordinateShift, m_parameters, useLasShift))
+					{
+						if (m_preserveCoordinateShift)
+						{
+							cloud->setGlobalShift(m_Pshift);
+						}
+						ccLog::Warning("[LAS] Cloud has been recentered! Translation: (%.2f ; %.2f ; %.2f)", m_Pshift.x, m_Pshift.y, m_Pshift.z);
+					}
+					m_parameters.shiftHandlingMode = csModeBackup;
+
+					//we use the first values as 'global shift' for time and shifted extra fields (otherwise we will lose accuracy)
+					for (size_t i = 0; i < m_fields.size(); ++i)
+					{
+						const LasField& field = *m_fields[i];
+						double value = 0.0;
+						if (	(field.type == LAS_TIME || (field.type == LAS_EXTRA && static_cast<const ExtraLasField&>(field).isShifted))
+							&&	GetLASFieldValue(point, field, m_pointFormatSixOrAbove, value))
+						{
+							m_fieldShifts[i] = value;
+							ccLog::Warning("[LAS] '%s' SF has been shifted to prevent a loss of accuracy (%.2f)", qPrintable(field.getName()), value);
+						}
+					}
+				}
+
+				if (m_hasColors)
+				{
+					U16 mergedColorComp = point.rgb[0] | point.rgb[1] | point.rgb[2];
+					if (m_colorBitDec == 0 && mergedColorComp > 255)
+					{
+						//same heuristic as LASFWFFilter::loadFile: colors are assumed to be coded on 8 bits
+						//until a value higher than 255 is met (we can't go back to the previous chunks)
+						m_colorBitDec = 8;
+						if (m_pointsRead != 0)
+						{
+							ccLog::Warning("[LAS] 16 bits colors detected after %u points: the previous colors have been read as 8 bits values", m_pointsRead);
+						}
+					}
+
+					cloud->addColor(ccColor::Rgb(	static_cast<unsigned char>((point.rgb[0] >> m_colorBitDec) & 255),
+													static_cast<unsigned char>((point.rgb[1] >> m_colorBitDec) & 255),
+													static_cast<unsigned char>((point.rgb[2] >> m_colorBitDec) & 255)));
+				}
+
+				for (size_t i = 0; i < m_fields.size(); ++i)
+				{
+					double value = 0.0;
+					GetLASFieldValue(point, *m_fields[i], m_pointFormatSixOrAbove, value);
+					sfs[i]->addElement(static_cast<ScalarType>(value - m_fieldShifts[i]));
+				}
+
+				cloud->addPoint((P + m_Pshift).toPC());
+				++m_pointsRead;
+			}
+
+			if (cloud->size() == 0)
+			{
+				//end of file
+				return nullptr;
+			}
+
+			if (cloud->size() < capacity)
+			{
+				cloud->resize(cloud->size());
+			}
+			for (size_t i = 0; i < sfs.size(); ++i)
+			{
+				sfs[i]->setGlobalShift(m_fieldShifts[i]);
+				sfs[i]->computeMinAndMax();
+			}
+			if (!sfs.empty())
+			{
+				cloud->setCurrentDisplayedScalarField(0);
+				cloud->showSF(true);
+			}
+			cloud->showColors(m_hasColors);
+
+			return cloud.take();
+		}
+		catch (const std::bad_alloc&)
+		{
+			error = CC_FERR_NOT_ENOUGH_MEMORY;
+		}
+		catch (...)
+		{
+			error = CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		return nullptr;
+	}
+
+protected:
+
+	LASreaderLAS m_lasreader;
+	FileIOFilter::LoadParameters m_parameters;
+	std::vector< LasField::Shared > m_fields;
+	std::vector<double> m_fieldShifts;
+	bool m_pointFormatSixOrAbove;
+	bool m_hasColors;
+	int m_colorBitDec;
+	unsigned m_pointsRead;
+	CCVector3d m_Pshift;
+	bool m_preserveCoordinateShift;
+};
+
+FileIOFilter::ChunkReader::Shared LASFWFFilter::openChunkReader(const QString& filename, LoadParameters& parameters, CC_FILE_ERROR& error)
+{
+	QSharedPointer<LASFWFChunkReader> reader(new LASFWFChunkReader(parameters));
+	error = reader->open(filename);
+	if (error != CC_FERR_NO_ERROR)
+	{
+		return ChunkReader::Shared(nullptr);
+	}
+
+	return reader;
+}
+
+//! LAS point cloud writer (chunk by chunk)
+/** The header is defined by the first chunk:
+	- the scale and offset come from the LAS meta-data (if any), otherwise the scale is 0.001
+	and the offset is the opposite of the Global Shift (or the first chunk's minimum corner)
+	- extra fields are stored as 8 or 16 bits integers if their declared storage allows it
+	(see ccScalarField::getStorage), and as floating point values otherwise
+	The bounding-box and the point count are updated when the file is closed.
+	Waveforms are not supported.
+**/
+class LASFWFChunkWriter : public FileIOFilter::ChunkWriter
+{
+public:
+
+	explicit LASFWFChunkWriter(const QString& filename)
+		: m_filename(filename)
+		, m_chunkCount(0)
+		, m_hasColors(false)
+		, m_pointFormatSixOrAbove(false)
+		, m_lossyExtraFieldWarning(false)
+	{}
+
+	//inherited from FileIOFilter::ChunkWriter
+	CC_FILE_ERROR writeChunk(const ccPointCloud& chunk) override
+	{
+		try
+		{
+			if (m_chunkCount == 0)
+			{
+				CC_FILE_ERROR error = init(chunk);
+				if (error != CC_FERR_NO_ERROR)
+				{
+					return error;
+				}
+			}
+			else if (chunk.hasColors() != m_hasColors)
+			{
+				ccLog::Warning("[LAS] All the chunks must have the same attributes");
+				return CC_FERR_BAD_ENTITY_TYPE;
+			}
+
+			//the scalar fields are matched by name
+			for (size_t i = 0; i < m_fields.size(); ++i)
+			{
+				if (!(m_fields[i].sf = getScalarField(chunk, m_sfNames[i])))
+				{
+					return CC_FERR_BAD_ENTITY_TYPE;
+				}
+			}
+			for (ExtraLasField& f : m_extraFields)
+			{
+				if (!(f.sf = getScalarField(chunk, f.fieldName)))
+				{
+					return CC_FERR_BAD_ENTITY_TYPE;
+				}
+				if (	!m_lossyExtraFieldWarning
+					&&	f.storage.type != ccScalarField::StorageType::NATIVE
+					&&	!f.sf->isLosslessWith(f.storage))
+				{
+					ccLog::Warning(QString("[LAS] Some values of the '%1' field can't be stored as %2 bits integers (they will be clamped)").arg(f.fieldName).arg(f.storage.type == ccScalarField::StorageType::UINT8 ? 8 : 16));
+					m_lossyExtraFieldWarning = true;
+				}
+			}
+
+			for (unsigned i = 0; i < chunk.size(); ++i)
+			{
+				CCVector3d Pglobal = chunk.toGlobal3d<PointCoordinateType>(*chunk.getPoint(i));
+				m_laspoint.set_X(static_cast<I32>(std::round((Pglobal.x - m_lasheader.x_offset) / m_lasheader.x_scale_factor)));
+				m_laspoint.set_Y(static_cast<I32>(std::round((Pglobal.y - m_lasheader.y_offset) / m_lasheader.y_scale_factor)));
+				m_laspoint.set_Z(static_cast<I32>(std::round((Pglobal.z - m_lasheader.z_offset) / m_lasheader.z_scale_factor)));
+
+				for (const LasField& f : m_fields)
+				{
+					SetLASFieldValue(m_laspoint, f, i, m_pointFormatSixOrAbove);
+				}
+
+				if (m_hasColors)
+				{
+					const ccColor::Rgb& rgb = chunk.getPointColor(i);
+					//DGM: LAS colors are stored on 16 bits!
+					m_laspoint.set_R(static_cast<U16>(rgb.r) << 8);
+					m_laspoint.set_G(static_cast<U16>(rgb.g) << 8);
+					m_laspoint.set_B(static_cast<U16>(rgb.b) << 8);
+				}
+
+				for (const ExtraLasField& f : m_extraFields)
+				{
+					SetExtraFieldValue(m_laspoint, f, i);
+				}
+
+				m_laswriter.write_point(&m_laspoint);
+				m_laswriter.update_inventory(&m_laspoint);
+			}
+			++m_chunkCount;
+		}
+		catch (const std::bad_alloc&)
+		{
+			return CC_FERR_NOT_ENOUGH_MEMORY;
+		}
+		catch (...)
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	//inherited from FileIOFilter::ChunkWriter
+	CC_FILE_ERROR close() override
+	{
+		if (m_chunkCount == 0)
+		{
+			ccLog::Warning("[LAS] No point to save");
+			return CC_FERR_NO_SAVE;
+		}
+
+		//the header (bounding-box, point count, etc.) is updated with the inventory
+		bool success = (m_laswriter.update_header(&m_lasheader, TRUE) != FALSE);
+		m_laswriter.close();
+		m_chunkCount = 0;
+
+		return (success ? CC_FERR_NO_ERROR : CC_FERR_WRITING);
+	}
+
+protected:
+
+	//! Returns the scalar field of a chunk by name (with a warning if it doesn't exist)
+	static ccScalarField* getScalarField(const ccPointCloud& chunk, const QString& name)
+	{
+		int sfIndex = chunk.getScalarFieldIndexByName(qPrintable(name));
+		if (sfIndex < 0)
+		{
+			ccLog::Warning(QString("[LAS] All the chunks must have the same attributes (scalar field '%1' is missing)").arg(name));
+			return nullptr;
+		}
+		return static_cast<ccScalarField*>(chunk.getScalarField(sfIndex));
+	}
+
+	//! Creates the file and writes the header (based on the first chunk)
+	CC_FILE_ERROR init(const ccPointCloud& firstChunk)
+	{
+		//GetLASFields doesn't modify the cloud
+		ccPointCloud* cloud = const_cast<ccPointCloud*>(&firstChunk);
+
+		m_hasColors = firstChunk.hasColors();
+
+		//match cloud SFs with official LAS fields
+		LasField::GetLASFields(cloud, m_fields, 0);
+		uint8_t minPointFormat = 0;
+		for (const LasField& f : m_fields)
+		{
+			minPointFormat = std::max(minPointFormat, f.minPointFormat);
+			m_sfNames.push_back(QString(f.sf->getName())); //the LAS fields are matched regardless of the case
+		}
+
+		//extended fields (i.e. other scalar fields)
+		for (unsigned i = 0; i < firstChunk.getNumberOfScalarFields(); ++i)
+		{
+			ccScalarField* sf = static_cast<ccScalarField*>(firstChunk.getScalarField(i));
+
+			bool standardField = false;
+			for (const LasField& lf : m_fields)
+			{
+				if (lf.sf == sf)
+				{
+					standardField = true;
+					break;
+				}
+			}
+			if (!standardField)
+			{
+				m_extraFields.emplace_back(ExtraLasField(QString(sf->getName()), sf));
+			}
+		}
+
+		//scale
+		bool hasScaleMetaData = false;
+		CCVector3d lasScale(0, 0, 0);
+		lasScale.x = firstChunk.getMetaData(LAS_SCALE_X_META_DATA).toDouble(&hasScaleMetaData);
+		if (hasScaleMetaData)
+		{
+			lasScale.y = firstChunk.getMetaData(LAS_SCALE_Y_META_DATA).toDouble(&hasScaleMetaData);
+			if (hasScaleMetaData)
+			{
+				lasScale.z = firstChunk.getMetaData(LAS_SCALE_Z_META_DATA).toDouble(&hasScaleMetaData);
+			}
+		}
+		if (!hasScaleMetaData)
+		{
+			//the optimal scale can't be computed without the whole bounding-box
+			lasScale = CCVector3d(1.0e-3, 1.0e-3, 1.0e-3);
+			ccLog::Print("[LAS] No LAS scale defined: the coordinates will be saved with a 0.001 scale");
+		}
+
+		//offset
+		bool hasOffsetMetaData = false;
+		CCVector3d lasOffset(0, 0, 0);
+		lasOffset.x = firstChunk.getMetaData(LAS_OFFSET_X_META_DATA).toDouble(&hasOffsetMetaData);
+		if (hasOffsetMetaData)
+		{
+			lasOffset.y = firstChunk.getMetaData(LAS_OFFSET_Y_META_DATA).toDouble(&hasOffsetMetaData);
+			if (hasOffsetMetaData)
+			{
+				lasOffset.z = firstChunk.getMetaData(LAS_OFFSET_Z_META_DATA).toDouble(&hasOffsetMetaData);
+			}
+		}
+		if (!hasOffsetMetaData)
+		{
+			CCVector3d bbMin, bbMax;
+			if (firstChunk.isShifted())
+			{
+				lasOffset = -firstChunk.getGlobalShift(); //'global shift' is the opposite of LAS offset ;)
+			}
+			else if (cloud->getOwnGlobalBB(bbMin, bbMax) && ccGlobalShiftManager::NeedShift(bbMax))
+			{
+				lasOffset = bbMin;
+			}
+		}
+
+		m_lasheader.x_scale_factor = lasScale.x;
+		m_lasheader.y_scale_factor = lasScale.y;
+		m_lasheader.z_scale_factor = lasScale.z;
+		m_lasheader.x_offset = lasOffset.x;
+		m_lasheader.y_offset = lasOffset.y;
+		m_lasheader.z_offset = lasOffset.z;
+
+		minPointFormat = LasField::UpdateMinPointFormat(minPointFormat, m_hasColors, false, false); //no legacy format with this plugin
+		m_lasheader.point_data_format = minPointFormat;
+		m_lasheader.version_minor = LasField::VersionMinorForPointFormat(minPointFormat);
+		if (m_lasheader.version_minor == 4)
+		{
+			// add the 148 byte difference between LAS 1.4 and LAS 1.2 header sizes
+			m_lasheader.header_size += 148;
+			m_lasheader.offset_to_point_data += 148;
+		}
+		m_lasheader.point_data_record_length = LasField::GetFormatRecordLength(m_lasheader.point_data_format);
+		m_pointFormatSixOrAbove = (m_lasheader.point_data_format >= 6);
+
+		//additional fields (the values of the next chunks are unknown: we rely on the declared storage)
+		for (ExtraLasField& f : m_extraFields)
+		{
+			f.storage = (f.isShifted ? ccScalarField::Storage() : f.sf->getStorage());
+
+			I32 attributeIndex = -1;
+			if (f.storage.type == ccScalarField::StorageType::UINT8 || f.storage.type == ccScalarField::StorageType::UINT16)
+			{
+				bool is8Bits = (f.storage.type == ccScalarField::StorageType::UINT8);
+				LASattribute attribute(is8Bits ? LAS_ATTRIBUTE_U8 : LAS_ATTRIBUTE_U16, qPrintable(f.sanitizedName), "additional attributes");
+				if (f.storage.scale != 1.0)
+					attribute.set_scale(f.storage.scale);
+				if (f.storage.offset != 0.0)
+					attribute.set_offset(f.storage.offset);
+				m_lasheader.point_data_record_length += (is8Bits ? 1 : 2);
+				attributeIndex = m_lasheader.add_attribute(attribute);
+			}
+			else
+			{
+				f.storage = ccScalarField::Storage();
+				LASattribute attribute(f.isShifted || sizeof(ScalarType) == 8 ? LAS_ATTRIBUTE_F64 : LAS_ATTRIBUTE_F32, qPrintable(f.sanitizedName), "additional attributes");
+				m_lasheader.point_data_record_length += (attribute.data_type == LAS_ATTRIBUTE_F32 + 1 ? 4 : 8); //strangely, LASlib shifts the official type indexes :|
+				attributeIndex = m_lasheader.add_attribute(attribute);
+			}
+			f.startIndex = m_lasheader.get_attribute_start(attributeIndex);
+		}
+		if (!m_extraFields.empty())
+		{
+			m_lasheader.update_extra_bytes_vlr(TRUE);
+		}
+
+		if (!m_laspoint.init(&m_lasheader, m_lasheader.point_data_format, m_lasheader.point_data_record_length, 0))
+		{
+			return CC_FERR_THIRD_PARTY_LIB_FAILURE;
+		}
+
+		bool useLAZ = QFileInfo(m_filename).suffix().toUpper().endsWith('Z');
+		if (!m_laswriter.open(qUtf8Printable(m_filename), &m_lasheader, useLAZ ? LASZIP_COMPRESSOR_LAYERED_CHUNKED : LASZIP_COMPRESSOR_NONE))
+		{
+			return CC_FERR_WRITING;
+		}
+
+		return CC_FERR_NO_ERROR;
+	}
+
+	QString m_filename;
+	LASheader m_lasheader;
+	LASpoint m_laspoint;
+	LASwriterLAS m_laswriter;
+	std::vector<LasField> m_fields;
+	std::vector<QString> m_sfNames;
+	std::vector<ExtraLasField> m_extraFields;
+	unsigned m_chunkCount;
+	bool m_hasColors;
+	bool m_pointFormatSixOrAbove;
+	bool m_lossyExtraFieldWarning;
+};
+
+FileIOFilter::ChunkWriter::Shared LASFWFFilter::openChunkWriter(const QString& filename, const SaveParameters& parameters, CC_FILE_ERROR& error)
+{
+	Q_UNUSED(parameters);
+
+	//the file is created with the first chunk (the header depends on it)
+	error = CC_FERR_NO_ERROR;
+	return ChunkWriter::Shared(new LASFWFChunkWriter(filename));
+}
@@ -118,6 +118,9 @@ struct LasField
 	//! Returns official field name
 	virtual inline QString getName() const { return type < LAS_INVALID ? QString(LAS_FIELD_NAMES[type]) : QString(); }
 
+	//! Returns the compact storage of the field values (see ccScalarField::Storage)
+	virtual inline ccScalarField::Storage getStorage() const { return (maxValue >= minValue ? ccScalarField::Storage::ForRange(minValue, maxValue) : ccScalarField::Storage()); }
+
 	//! Returns the (compliant) LAS fields in a point cloud
 	static bool GetLASFields(ccPointCloud* cloud, std::vector<LasField>& fieldsToSave, uint8_t minPointFormat)
 	{
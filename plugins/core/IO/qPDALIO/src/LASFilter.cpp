@@ -63,6 +63,7 @@ using namespace pdal;
 //System
 #include <string.h>
 #include <bitset>
+#include <cmath>
 
 static const char s_LAS_SRS_Key[] = "LAS.spatialReference.nosave"; //DGM: added the '.nosave' suffix because this custom type can't be streamed properly
 
@@ -682,9 +683,30 @@ CC_FILE_ERROR LASFilter::saveToFile(ccHObject* entity, const QString& filename,
 		for (const ExtraLasField::Shared extraField : extraFields)
 		{
 			std::string dimName = extraField->getName().toStdString();
-			// All extra scalar fields are written as double.
-			// A more specific solution would be welcome.
+			// Extra scalar fields are written as double, unless they
+			// only contain small integer values (see the SF storage)
 			Type t = Type::Double;
+			ccScalarField* sf = extraField->sf;
+			if (sf && sf->getGlobalShift() == 0)
+			{
+				ccScalarField::Storage storage = sf->getCompactStorage();
+				if (	storage.type != ccScalarField::StorageType::NATIVE
+					&&	storage.type != ccScalarField::StorageType::FLOAT16
+					&&	storage.scale == 1.0
+					&&	storage.offset == std::floor(storage.offset))
+				{
+					double minVal = sf->getMin();
+					double maxVal = sf->getMax();
+					if (minVal >= 0 && maxVal <= 255)
+						t = Type::Unsigned8;
+					else if (minVal >= -128 && maxVal <= 127)
+						t = Type::Signed8;
+					else if (minVal >= 0 && maxVal <= 65535)
+						t = Type::Unsigned16;
+					else if (minVal >= -32768 && maxVal <= 32767)
+						t = Type::Signed16;
+				}
+			}
 			extraField->pdalId = table.layout()->registerOrAssignDim(dimName, t);
 		}
 
@@ -1559,6 +1581,7 @@ CC_FILE_ERROR LASFilter::loadFile(const QString& filename, ccHObject& container,
 					    ||	(field->firstValue != field->defaultValue && field->firstValue >= field->minValue))
 					{
 						field->sf = new ccScalarField(qPrintable(field->getName()));
+						field->sf->setStorage(field->getStorage());
 						if (field->sf->reserveSafe(fileChunkSize))
 						{
 							field->sf->link();
@@ -54,12 +54,15 @@ public:
 	void saveOffGroundPoints(const std::vector<int>& grp, std::string path = "");
 	
 	//The main program: Do filtering
+	/** \param showProgress whether to display a progress dialog or not (must be false if called from a worker thread)
+	**/
 	bool do_filtering(	std::vector<int>& groundIndexes,
 						std::vector<int>& offGroundIndexes,
 						bool exportClothMesh,
 						ccMesh* &clothMesh,
 						ccMainAppInterface* app = 0,
-						QWidget* parent = 0);
+						QWidget* parent = 0,
+						bool showProgress = true);
 
 private:
 	wl::PointCloud& point_cloud;
@@ -82,6 +85,12 @@ public:
 		int rigidness;
 
 		int iterations;
+
+		//! Whether the octree based steps can use several threads
+		/** Must be false if several CSF instances are run concurrently (CCCoreLib's
+			multi-threaded octree passes can't be run concurrently).
+		**/
+		bool multiThreaded = true;
 	};
 	
 	Parameters params;
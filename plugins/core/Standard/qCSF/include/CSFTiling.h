@@ -0,0 +1,89 @@
+//#######################################################################################
+//#                                                                                     #
+//#                              CLOUDCOMPARE PLUGIN: qCSF                              #
+//#                                                                                     #
+//#        This program is free software; you can redistribute it and/or modify         #
+//#        it under the terms of the GNU General Public License as published by         #
+//#        the Free Software Foundation; version 2 or later of the License.             #
+//#                                                                                     #
+//#        This program is distributed in the hope that it will be useful,              #
+//#        but WITHOUT ANY WARRANTY; without even the implied warranty of               #
+//#        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 #
+//#        GNU General Public License for more details.                                 #
+//#                                                                                     #
+//#        Please cite the following paper, If you use this plugin in your work.        #
+//#                                                                                     #
+//#  Zhang W, Qi J, Wan P, Wang H, Xie D, Wang X, Yan G. An Easy-to-Use Airborne LiDAR  #
+//#  Data Filtering Method Based on Cloth Simulation. Remote Sensing. 2016; 8(6):501.   #
+//#                                                                                     #
+//#                                     Copyright ©                                     #
+//#               RAMM laboratory, School of Geography, Beijing Normal University       #
+//#                               (http://ramm.bnu.edu.cn/)                             #
+//#                                                                                     #
+//#                      Wuming Zhang; Jianbo Qi; Peng Wan; Hongtao Wang                #
+//#                                                                                     #
+//#                      contact us: 2009zwm@gmail.com; wpqjbzwm@126.com                #
+//#                                                                                     #
+//#######################################################################################
+
+#ifndef CSF_TILING_H_
+#define CSF_TILING_H_
+
+//Local
+#include "CSF.h"
+
+//CCCoreLib
+#include <GenericIndexedCloudPersist.h>
+#include <GenericProgressCallback.h>
+
+//system
+#include <vector>
+
+//! Tiled version of the CSF filter (for clouds too large to be processed at once)
+/** The cloud is split into a regular grid of XY tiles. Each tile is extended by
+	an overlap margin and processed independently (and concurrently) by the
+	standard CSF algorithm. Only the points of the extended tile are copied, so
+	that the memory footprint of each cloth simulation is bounded by the tile size.
+
+	Stitching: each point is classified by the tile that contains it in its core
+	footprint. The overlap margins only serve as context so that the cloth behaves
+	consistently at the tile borders.
+**/
+class CSFTiling
+{
+public:
+
+	//! Tiling parameters
+	struct Parameters
+	{
+		//! Tile size (along X and Y, same unit as the cloud)
+		double tileSize = 500.0;
+		//! Overlap margin added around each tile (same unit as the cloud)
+		/** Should be at least several times the cloth resolution.
+			Can't be larger than the tile size.
+		**/
+		double overlap = 50.0;
+		//! Max number of tiles processed concurrently (0 = as many as the number of cores)
+		/** The peak memory consumption is roughly proportional to this number.
+		**/
+		int maxThreadCount = 0;
+	};
+
+	//! Applies the CSF filter tile by tile
+	/** \param cloud input cloud (Z is considered as the vertical dimension)
+		\param csfParams CSF parameters (shared by all tiles)
+		\param tilingParams tiling parameters
+		\param groundIndexes output ground point indexes (sorted)
+		\param offGroundIndexes output off-ground point indexes (sorted)
+		\param progressCb optional progress callback (one step per tile)
+		\return success
+	**/
+	static bool Filter(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+						const CSF::Parameters& csfParams,
+						const Parameters& tilingParams,
+						std::vector<int>& groundIndexes,
+						std::vector<int>& offGroundIndexes,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+};
+
+#endif //CSF_TILING_H_
@@ -37,12 +37,16 @@ class Cloud2CloudDist
 {
 public:
 	
+	//! Classifies the points (ground / off-ground)
+	/** \param multiThread whether the octree based version can use several threads (must be false if several instances run concurrently)
+	**/
 	static bool Compute(const Cloth& cloth,
 						const wl::PointCloud& pc,
 						double class_threshold,
 						std::vector<int>& groundIndexes,
 						std::vector<int>& offGroundIndexes,
-						unsigned N = 3);
+						unsigned N = 3,
+						bool multiThread = true);
 };
 
 #endif
\ No newline at end of file
@@ -44,7 +44,9 @@ public:
 	double static findHeightValByScanline(Particle *p, Cloth &cloth);
 
 	//ԵƽٽѰΧN  
-	static bool RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN = 1);
+	/** \param multiThread whether the octree based version can use several threads (must be false if several instances run concurrently)
+	**/
+	static bool RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN = 1, bool multiThread = true);
 
 };
 
@@ -38,6 +38,13 @@
 //Local
 #include "ccCSFDlg.h"
 #include "CSF.h"
+#include "CSFTiling.h"
+
+//qCC_db
+#include <ccProgressDialog.h>
+
+//Qt
+#include <QScopedPointer>
 
 static const char COMMAND_CSF[] = "CSF"; 
 static const char COMMAND_CSF_SCENE[] = "SCENES";
@@ -50,6 +57,8 @@ static const char COMMAND_CSF_MAX_ITERATION[] = "MAX_ITERATION";
 static const char COMMAND_CSF_CLASS_THRESHOLD[] = "CLASS_THRESHOLD";
 static const char COMMAND_CSF_EXPORT_GROUND[] = "EXPORT_GROUND";
 static const char COMMAND_CSF_EXPORT_OFFGROUND[] = "EXPORT_OFFGROUND";
+static const char COMMAND_CSF_TILE_SIZE[] = "TILE_SIZE";
+static const char COMMAND_CSF_TILE_OVERLAP[] = "TILE_OVERLAP";
 
 
 struct CommandCSF : public ccCommandLineInterface::Command
@@ -68,28 +77,6 @@ struct CommandCSF : public ccCommandLineInterface::Command
 
 		ccPointCloud* pc = cmd.clouds()[0].pc;
 
-		//Convert CC point cloud to CSF type
-		unsigned count = pc->size();
-		wl::PointCloud csfPC;
-		try 
-		{
-			csfPC.reserve(count);
-		}
-		catch (const std::bad_alloc&) 
-		{
-			return cmd.error("Not enough memory!");
-		}
-
-		for (unsigned i = 0; i < count; i++) 
-		{
-			const CCVector3* P = pc->getPoint(i);
-			wl::Point tmpPoint;
-			tmpPoint.x = P->x;
-			tmpPoint.y = -P->z;
-			tmpPoint.z = P->y;
-			csfPC.push_back(tmpPoint);
-		}
-
 		//initial parameters
 		bool csfPostprocessing = false;
 		double clothResolution = 2;
@@ -98,6 +85,8 @@ struct CommandCSF : public ccCommandLineInterface::Command
 		int maxIteration = 500;
 		bool exportGround = false;
 		bool exportOffground = false;
+		bool tiling = false;
+		CSFTiling::Parameters tilingParams;
 
 		while (!cmd.arguments().empty())
 		{
@@ -166,6 +155,29 @@ struct CommandCSF : public ccCommandLineInterface::Command
 				}
 				cmd.print(QString("Custom class threshold set: %1").arg(classThreshold));
 			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_TILE_SIZE))
+			{
+				cmd.arguments().pop_front();
+				bool conv = false;
+				tilingParams.tileSize = cmd.arguments().takeFirst().toDouble(&conv);
+				if (!conv || tilingParams.tileSize <= 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_TILE_SIZE));
+				}
+				cmd.print(QString("Tiled processing enabled: tile size = %1").arg(tilingParams.tileSize));
+				tiling = true;
+			}
+			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_TILE_OVERLAP))
+			{
+				cmd.arguments().pop_front();
+				bool conv = false;
+				tilingParams.overlap = cmd.arguments().takeFirst().toDouble(&conv);
+				if (!conv || tilingParams.overlap < 0)
+				{
+					return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_CSF_TILE_OVERLAP));
+				}
+				cmd.print(QString("Tile overlap set: %1").arg(tilingParams.overlap));
+			}
 			else if (ccCommandLineInterface::IsCommand(ARGUMENT, COMMAND_CSF_EXPORT_GROUND))
 			{
 				cmd.arguments().pop_front();
@@ -185,24 +197,70 @@ struct CommandCSF : public ccCommandLineInterface::Command
 			}
 		}
 		
-		//instantiation a CSF class
-		CSF csf(csfPC);
-
 		//setup paramter
-		csf.params.k_nearest_points = 1;
-		csf.params.bSloopSmooth = csfPostprocessing;
-		csf.params.time_step = 0.65;
-		csf.params.class_threshold = classThreshold;
-		csf.params.cloth_resolution = clothResolution;
-		csf.params.rigidness = csfRigidness;
-		csf.params.iterations = maxIteration;
+		CSF::Parameters csfParams;
+		csfParams.k_nearest_points = 1;
+		csfParams.bSloopSmooth = csfPostprocessing;
+		csfParams.time_step = 0.65;
+		csfParams.class_threshold = classThreshold;
+		csfParams.cloth_resolution = clothResolution;
+		csfParams.rigidness = csfRigidness;
+		csfParams.iterations = maxIteration;
 
+		unsigned count = pc->size();
 		std::vector<int> groundIndexes;
 		std::vector<int> offGroundIndexes;
-		ccMesh* clothMesh = nullptr;
-		if (!csf.do_filtering(groundIndexes, offGroundIndexes, false, clothMesh, nullptr, cmd.widgetParent()))
 		{
-			return cmd.error("Process failed");
+			//the section ends when going out of scope (whatever the outcome)
+			ccCommandLineInterface::ProfilingScope profiling(cmd, "CSF", "filtering");
+			profiling.setPointCount(count);
+
+			if (tiling)
+			{
+				//no need to copy the whole cloud in this mode
+				QScopedPointer<ccProgressDialog> pDlg;
+				if (!cmd.silentMode())
+				{
+					pDlg.reset(new ccProgressDialog(true, cmd.widgetParent()));
+				}
+				if (!CSFTiling::Filter(pc, csfParams, tilingParams, groundIndexes, offGroundIndexes, pDlg.data()))
+				{
+					return cmd.error("Process failed");
+				}
+			}
+			else
+			{
+				//Convert CC point cloud to CSF type
+				wl::PointCloud csfPC;
+				try
+				{
+					csfPC.reserve(count);
+				}
+				catch (const std::bad_alloc&)
+				{
+					return cmd.error("Not enough memory!");
+				}
+
+				for (unsigned i = 0; i < count; i++)
+				{
+					const CCVector3* P = pc->getPoint(i);
+					wl::Point tmpPoint;
+					tmpPoint.x = P->x;
+					tmpPoint.y = -P->z;
+					tmpPoint.z = P->y;
+					csfPC.push_back(tmpPoint);
+				}
+
+				//instantiation a CSF class
+				CSF csf(csfPC);
+				csf.params = csfParams;
+
+				ccMesh* clothMesh = nullptr;
+				if (!csf.do_filtering(groundIndexes, offGroundIndexes, false, clothMesh, nullptr, cmd.widgetParent()))
+				{
+					return cmd.error("Process failed");
+				}
+			}
 		}
 
 		cmd.print(QString("[CSF] %1% of points classified as ground points").arg((groundIndexes.size() * 100.0) / count, 0, 'f', 2));
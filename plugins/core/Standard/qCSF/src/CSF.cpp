@@ -40,6 +40,7 @@
 #include <QProgressDialog>
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include <QScopedPointer>
 
 //system
 #include <cmath>
@@ -105,7 +106,8 @@ bool CSF::do_filtering(	std::vector<int>& groundIndexes,
 						bool exportClothMesh,
 						ccMesh* &clothMesh,
 						ccMainAppInterface* app/*=0*/,
-						QWidget* parent/*=0*/)
+						QWidget* parent/*=0*/,
+						bool showProgress/*=true*/)
 {
 	//constants
 	static const double cloth_y_height = 0.05; //origin cloth height
@@ -145,7 +147,7 @@ bool CSF::do_filtering(	std::vector<int>& groundIndexes,
 			app->dispToConsole(QString("[CSF] Cloth creation: %1 ms").arg(timer.restart()));
 		}
 
-		if (!Rasterization::RasterTerrain(cloth, point_cloud, cloth.getHeightvals(), params.k_nearest_points))
+		if (!Rasterization::RasterTerrain(cloth, point_cloud, cloth.getHeightvals(), params.k_nearest_points, params.multiThreaded))
 		{
 			return false;
 		}
@@ -159,12 +161,16 @@ bool CSF::do_filtering(	std::vector<int>& groundIndexes,
 		double time_step2 = params.time_step * params.time_step;
 
 		//do the filtering
-		QProgressDialog pDlg(parent);
-		pDlg.setWindowTitle("CSF");
-		pDlg.setLabelText(QString("Cloth deformation\n%1 x %2 particles").arg(cloth.num_particles_width).arg(cloth.num_particles_height));
-		pDlg.setRange(0, params.iterations);
-		pDlg.show();
-		QCoreApplication::processEvents();
+		QScopedPointer<QProgressDialog> pDlg;
+		if (showProgress)
+		{
+			pDlg.reset(new QProgressDialog(parent));
+			pDlg->setWindowTitle("CSF");
+			pDlg->setLabelText(QString("Cloth deformation\n%1 x %2 particles").arg(cloth.num_particles_width).arg(cloth.num_particles_height));
+			pDlg->setRange(0, params.iterations);
+			pDlg->show();
+			QCoreApplication::processEvents();
+		}
 
 		bool wasCancelled = false;
 		cloth.addForce(Vec3(0, -gravity, 0) * time_step2);
@@ -185,18 +191,24 @@ bool CSF::do_filtering(	std::vector<int>& groundIndexes,
 				break;
 			}
 
-			pDlg.setValue(i);
-			QCoreApplication::processEvents();
-
-			if (pDlg.wasCanceled())
+			if (pDlg)
 			{
-				wasCancelled = true;
-				break;
+				pDlg->setValue(i);
+				QCoreApplication::processEvents();
+
+				if (pDlg->wasCanceled())
+				{
+					wasCancelled = true;
+					break;
+				}
 			}
 		}
 		
-		pDlg.close();
-		QCoreApplication::processEvents();
+		if (pDlg)
+		{
+			pDlg->close();
+			QCoreApplication::processEvents();
+		}
 
 		if (app)
 		{
@@ -220,7 +232,7 @@ bool CSF::do_filtering(	std::vector<int>& groundIndexes,
 		}
 	
 		//classification of the points
-		bool result = Cloud2CloudDist::Compute(cloth, point_cloud, params.class_threshold, groundIndexes, offGroundIndexes);
+		bool result = Cloud2CloudDist::Compute(cloth, point_cloud, params.class_threshold, groundIndexes, offGroundIndexes, 3, params.multiThreaded);
 		if (app)
 		{
 			app->dispToConsole(QString("[CSF] Distance computation: %1 ms").arg(timer.restart()));
@@ -0,0 +1,373 @@
+//#######################################################################################
+//#                                                                                     #
+//#                              CLOUDCOMPARE PLUGIN: qCSF                              #
+//#                                                                                     #
+//#        This program is free software; you can redistribute it and/or modify         #
+//#        it under the terms of the GNU General Public License as published by         #
+//#        the Free Software Foundation; version 2 or later of the License.             #
+//#                                                                                     #
+//#        This program is distributed in the hope that it will be useful,              #
+//#        but WITHOUT ANY WARRANTY; without even the implied warranty of               #
+//#        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the                 #
+//#        GNU General Public License for more details.                                 #
+//#                                                                                     #
+//#        Please cite the following paper, If you use this plugin in your work.        #
+//#                                                                                     #
+//#  Zhang W, Qi J, Wan P, Wang H, Xie D, Wang X, Yan G. An Easy-to-Use Airborne LiDAR  #
+//#  Data Filtering Method Based on Cloth Simulation. Remote Sensing. 2016; 8(6):501.   #
+//#                                                                                     #
+//#                                     Copyright ©                                     #
+//#               RAMM laboratory, School of Geography, Beijing Normal University       #
+//#                               (http://ramm.bnu.edu.cn/)                             #
+//#                                                                                     #
+//#                      Wuming Zhang; Jianbo Qi; Peng Wan; Hongtao Wang                #
+//#                                                                                     #
+//#                      contact us: 2009zwm@gmail.com; wpqjbzwm@126.com                #
+//#                                                                                     #
+//#######################################################################################
+
+#include "CSFTiling.h"
+
+//CCCoreLib
+#include <ParallelSort.h>
+
+//Qt
+#include <QFuture>
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+//system
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+//! Tile descriptor
+struct CSFTile
+{
+	unsigned ix = 0;
+	unsigned iy = 0;
+	std::vector<int> groundIndexes;
+	std::vector<int> offGroundIndexes;
+	bool success = true;
+};
+
+//! Context shared by all the tiles (see ProcessTile)
+struct CSFTilingContext
+{
+	CCCoreLib::GenericIndexedCloudPersist* cloud = nullptr;
+	CSF::Parameters csfParams;
+	CCVector3 bbMin;
+	double tileSize = 0;
+	double overlap = 0;
+	unsigned tileCountX = 0;
+	unsigned tileCountY = 0;
+	//! Point indexes sorted by tile
+	std::vector<unsigned> sortedIndexes;
+	//! Position of the first point of each tile in 'sortedIndexes' (followed by the total number of points)
+	std::vector<unsigned> tileStart;
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	//! Set by any worker to make the others stop (error or cancellation)
+	std::atomic<bool> processCanceled{ false };
+	//! Next tile to process (shared by the workers)
+	std::atomic<unsigned> nextTile{ 0 };
+};
+
+static unsigned GetTileIndex(const CSFTilingContext& context, const CCVector3* P)
+{
+	double fx = std::floor((P->x - context.bbMin.x) / context.tileSize);
+	double fy = std::floor((P->y - context.bbMin.y) / context.tileSize);
+	unsigned ix = std::min(static_cast<unsigned>(std::max(0.0, fx)), context.tileCountX - 1);
+	unsigned iy = std::min(static_cast<unsigned>(std::max(0.0, fy)), context.tileCountY - 1);
+	return iy * context.tileCountX + ix;
+}
+
+static void ProcessTile(CSFTilingContext& context, CSFTile& tile)
+{
+	if (context.processCanceled)
+	{
+		tile.success = false;
+		return;
+	}
+
+	unsigned tileIndex = tile.iy * context.tileCountX + tile.ix;
+	unsigned coreStart = context.tileStart[tileIndex];
+	unsigned coreCount = context.tileStart[tileIndex + 1] - coreStart;
+
+	if (coreCount != 0)
+	{
+		//extended footprint (core + overlap)
+		const double margin = context.overlap;
+		const double xMin = context.bbMin.x + tile.ix * context.tileSize - margin;
+		const double yMin = context.bbMin.y + tile.iy * context.tileSize - margin;
+		const double xMax = xMin + context.tileSize + 2 * margin;
+		const double yMax = yMin + context.tileSize + 2 * margin;
+
+		try
+		{
+			wl::PointCloud tilePC;
+			std::vector<unsigned> globalIndexes;
+			tilePC.reserve(coreCount);
+			globalIndexes.reserve(coreCount);
+
+			auto addPoint = [&](unsigned globalIndex, const CCVector3* P)
+			{
+				wl::Point tmpPoint;
+				tmpPoint.x =  P->x;
+				tmpPoint.y = -P->z;
+				tmpPoint.z =  P->y;
+				tilePC.push_back(tmpPoint);
+				globalIndexes.push_back(globalIndex);
+			};
+
+			//the core points come first (so that local indexes < coreCount are the core points)
+			for (unsigned i = 0; i < coreCount; ++i)
+			{
+				unsigned globalIndex = context.sortedIndexes[coreStart + i];
+				addPoint(globalIndex, context.cloud->getPoint(globalIndex));
+			}
+
+			//then the points of the neighbouring tiles that fall inside the overlap margin
+			if (margin > 0)
+			{
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					int ny = static_cast<int>(tile.iy) + dy;
+					if (ny < 0 || ny >= static_cast<int>(context.tileCountY))
+						continue;
+
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						int nx = static_cast<int>(tile.ix) + dx;
+						if ((dx == 0 && dy == 0) || nx < 0 || nx >= static_cast<int>(context.tileCountX))
+							continue;
+
+						unsigned neighborIndex = static_cast<unsigned>(ny) * context.tileCountX + static_cast<unsigned>(nx);
+						for (unsigned i = context.tileStart[neighborIndex]; i < context.tileStart[neighborIndex + 1]; ++i)
+						{
+							unsigned globalIndex = context.sortedIndexes[i];
+							const CCVector3* P = context.cloud->getPoint(globalIndex);
+							if (P->x >= xMin && P->x <= xMax && P->y >= yMin && P->y <= yMax)
+							{
+								addPoint(globalIndex, P);
+							}
+						}
+					}
+				}
+			}
+
+			CSF csf(tilePC);
+			csf.params = context.csfParams;
+
+			std::vector<int> localGroundIndexes;
+			std::vector<int> localOffGroundIndexes;
+			ccMesh* clothMesh = nullptr;
+			if (csf.do_filtering(localGroundIndexes, localOffGroundIndexes, false, clothMesh, nullptr, nullptr, false))
+			{
+				//we only keep the classification of the core points
+				for (int localIndex : localGroundIndexes)
+				{
+					if (static_cast<unsigned>(localIndex) < coreCount)
+						tile.groundIndexes.push_back(static_cast<int>(globalIndexes[localIndex]));
+				}
+				for (int localIndex : localOffGroundIndexes)
+				{
+					if (static_cast<unsigned>(localIndex) < coreCount)
+						tile.offGroundIndexes.push_back(static_cast<int>(globalIndexes[localIndex]));
+				}
+			}
+			else
+			{
+				tile.success = false;
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			//not enough memory
+			tile.success = false;
+		}
+
+		if (!tile.success)
+		{
+			context.processCanceled = true; //to make the loop stop!
+		}
+	}
+
+	//progress notification
+	if (context.nProgress && !context.nProgress->oneStep())
+	{
+		context.processCanceled = true;
+	}
+}
+
+bool CSFTiling::Filter(	CCCoreLib::GenericIndexedCloudPersist* cloud,
+						const CSF::Parameters& csfParams,
+						const Parameters& tilingParams,
+						std::vector<int>& groundIndexes,
+						std::vector<int>& offGroundIndexes,
+						CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	if (!cloud || cloud->size() == 0 || tilingParams.tileSize <= 0)
+	{
+		assert(false);
+		return false;
+	}
+
+	unsigned pointCount = cloud->size();
+	CCVector3 bbMin;
+	CCVector3 bbMax;
+	cloud->getBoundingBox(bbMin, bbMax);
+
+	double tileCountX = std::max(1.0, std::ceil((bbMax.x - bbMin.x) / tilingParams.tileSize));
+	double tileCountY = std::max(1.0, std::ceil((bbMax.y - bbMin.y) / tilingParams.tileSize));
+	if (tileCountX * tileCountY >= static_cast<double>(std::numeric_limits<unsigned>::max()))
+	{
+		//tile size is too small
+		return false;
+	}
+
+	CSFTilingContext context;
+	context.cloud = cloud;
+	context.csfParams = csfParams;
+	//several tiles are processed concurrently: the octree passes of each tile must be single-threaded
+	context.csfParams.multiThreaded = false;
+	context.bbMin = bbMin;
+	context.tileSize = tilingParams.tileSize;
+	//we only look for the overlapping points in the direct neighbours
+	context.overlap = std::max(0.0, std::min(tilingParams.overlap, tilingParams.tileSize));
+	context.tileCountX = static_cast<unsigned>(tileCountX);
+	context.tileCountY = static_cast<unsigned>(tileCountY);
+
+	unsigned tileCount = context.tileCountX * context.tileCountY;
+	std::vector<CSFTile> tiles;
+	try
+	{
+		context.sortedIndexes.resize(pointCount);
+		context.tileStart.assign(tileCount + 1, 0);
+		tiles.resize(tileCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	//sort the point indexes by tile (counting sort)
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		++context.tileStart[GetTileIndex(context, cloud->getPoint(i)) + 1];
+	}
+	for (unsigned t = 0; t < tileCount; ++t)
+	{
+		context.tileStart[t + 1] += context.tileStart[t];
+	}
+	{
+		std::vector<unsigned> fillPos(context.tileStart.begin(), context.tileStart.end() - 1);
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			context.sortedIndexes[fillPos[GetTileIndex(context, cloud->getPoint(i))]++] = i;
+		}
+	}
+
+	for (unsigned t = 0; t < tileCount; ++t)
+	{
+		tiles[t].ix = t % context.tileCountX;
+		tiles[t].iy = t / context.tileCountX;
+	}
+
+	CCCoreLib::NormalizedProgress nProgress(progressCb, tileCount);
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setInfo(qPrintable(QString("Tiles: %1 x %2\nPoints: %3").arg(context.tileCountX).arg(context.tileCountY).arg(pointCount)));
+			progressCb->setMethodTitle("CSF (tiled)");
+		}
+		progressCb->start();
+	}
+	context.nProgress = progressCb ? &nProgress : nullptr;
+
+	int maxThreadCount = tilingParams.maxThreadCount;
+	if (maxThreadCount <= 0 || maxThreadCount > QThread::idealThreadCount())
+	{
+		maxThreadCount = QThread::idealThreadCount();
+	}
+	maxThreadCount = std::min(maxThreadCount, static_cast<int>(tileCount));
+
+	//each worker processes the tiles one after the other (local pool, so as to not change the global one)
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(maxThreadCount);
+	std::vector< QFuture<void> > workers;
+	workers.reserve(maxThreadCount);
+	for (int w = 0; w < maxThreadCount; ++w)
+	{
+		workers.push_back(QtConcurrent::run(&threadPool, [&context, &tiles]()
+		{
+			for (unsigned t = context.nextTile++; t < tiles.size() && !context.processCanceled; t = context.nextTile++)
+			{
+				ProcessTile(context, tiles[t]);
+			}
+		}));
+	}
+	for (QFuture<void>& worker : workers)
+	{
+		worker.waitForFinished();
+	}
+
+	bool success = !context.processCanceled;
+
+	//release memory
+	context.sortedIndexes.clear();
+	context.sortedIndexes.shrink_to_fit();
+	context.tileStart.clear();
+	context.tileStart.shrink_to_fit();
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (!success)
+	{
+		return false;
+	}
+
+	//stitch the tiles
+	try
+	{
+		size_t groundCount = 0;
+		size_t offGroundCount = 0;
+		for (const CSFTile& tile : tiles)
+		{
+			groundCount += tile.groundIndexes.size();
+			offGroundCount += tile.offGroundIndexes.size();
+		}
+		groundIndexes.clear();
+		groundIndexes.reserve(groundCount);
+		offGroundIndexes.clear();
+		offGroundIndexes.reserve(offGroundCount);
+
+		for (CSFTile& tile : tiles)
+		{
+			groundIndexes.insert(groundIndexes.end(), tile.groundIndexes.begin(), tile.groundIndexes.end());
+			offGroundIndexes.insert(offGroundIndexes.end(), tile.offGroundIndexes.begin(), tile.offGroundIndexes.end());
+			//release memory as soon as possible
+			std::vector<int>().swap(tile.groundIndexes);
+			std::vector<int>().swap(tile.offGroundIndexes);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	//restore the original order of the points
+	ParallelSort(groundIndexes.begin(), groundIndexes.end());
+	ParallelSort(offGroundIndexes.begin(), offGroundIndexes.end());
+
+	return true;
+}
@@ -41,7 +41,8 @@ bool Cloud2CloudDist::Compute(const Cloth& cloth,
 	double class_threshold,
 	std::vector<int>& groundIndexes,
 	std::vector<int>& offGroundIndexes,
-	unsigned N/*=3*/)
+	unsigned N/*=3*/,
+	bool multiThread/*=true*/)
 {
 
 	try
@@ -120,7 +121,8 @@ bool Cloud2CloudDist::Compute(const Cloth& cloth,
 	double class_threshold,
 	std::vector<int>& groundIndexes,
 	std::vector<int>& offGroundIndexes,
-	unsigned N/*=3*/)
+	unsigned N/*=3*/,
+	bool multiThread/*=true*/)
 {
 	try
 	{
@@ -237,7 +239,8 @@ bool Cloud2CloudDist::Compute(	const Cloth& cloth,
 								double class_threshold,
 								std::vector<int>& groundIndexes,
 								std::vector<int>& offGroundIndexes,
-								unsigned N/*=3*/)
+								unsigned N/*=3*/,
+								bool multiThread/*=true*/)
 {
 	CCCoreLib::SimpleCloud particlePoints;
 	if (!particlePoints.reserve(static_cast<unsigned>(cloth.getSize())))
@@ -296,7 +299,7 @@ bool Cloud2CloudDist::Compute(	const Cloth& cloth,
 			octreeLevel,
 			ComputeMeanNeighborAltitude,
 			additionalParameters,
-			true,
+			multiThread,
 			0,
 			"Rasterization",
 			QThread::idealThreadCount());
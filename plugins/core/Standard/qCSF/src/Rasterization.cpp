@@ -121,7 +121,7 @@ double Rasterization::findHeightValByNeighbor(Particle *p, Cloth &cloth)
 	return MIN_INF;
 }
 
-bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN)
+bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN, bool multiThread)
 {
 	try
 	{
@@ -199,7 +199,7 @@ typedef CGAL::Search_traits_2<K> TreeTraits;
 typedef CGAL::Orthogonal_k_neighbor_search<TreeTraits> Neighbor_search;
 typedef Neighbor_search::Tree Tree;
 
-bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN)
+bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN, bool multiThread)
 {
 	try
 	{
@@ -302,7 +302,7 @@ static bool ComputeMaxNeighborAltitude(	const CCCoreLib::DgmOctree::octreeCell&
 	return true;
 }
 
-bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN)
+bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::vector<double>& heightVal, unsigned KNN, bool multiThread)
 {
 	CCCoreLib::SimpleCloud particlePoints;
 	if (!particlePoints.reserve(static_cast<unsigned>(cloth.getSize())))
@@ -389,7 +389,7 @@ bool Rasterization::RasterTerrain(Cloth& cloth, const wl::PointCloud& pc, std::v
 							octreeLevel,
 							ComputeMaxNeighborAltitude,
 							additionalParameters,
-							true,
+							multiThread,
 							0,
 							"Rasterization",
 							QThread::idealThreadCount());
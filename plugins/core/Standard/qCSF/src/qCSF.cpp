@@ -60,6 +60,7 @@
 
 //CSF
 #include <CSF.h>
+#include <CSFTiling.h>
 
 qCSF::qCSF(QObject* parent)
 	: QObject( parent )
@@ -115,31 +116,6 @@ void qCSF::doAction()
 	//to get the point cloud from selected entity.
 	ccPointCloud* pc = static_cast<ccPointCloud*>(ent);
 
-	//Convert CC point cloud to CSF type
-	unsigned count = pc->size();
-	wl::PointCloud csfPC;
-	try
-	{
-		csfPC.reserve(count);
-	}
-	catch (const std::bad_alloc&)
-	{
-		m_app->dispToConsole("Not enough memory!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-		return;
-	}
-	for (unsigned i = 0; i < count; i++)
-	{
-		const CCVector3* P = pc->getPoint(i);
-		wl::Point tmpPoint;
-		//tmpPoint.x = P->x;
-		//tmpPoint.y = P->y;
-		//tmpPoint.z = P->z;
-		tmpPoint.x =  P->x;
-		tmpPoint.y = -P->z;
-		tmpPoint.z =  P->y;
-		csfPC.push_back(tmpPoint);
-	}
-
 	//initial dialog parameters
 	static bool csf_postprocessing = false;
 	static double cloth_resolution = 2;
@@ -147,6 +123,9 @@ void qCSF::doAction()
 	static int csf_rigidness = 2;
 	static int MaxIteration = 500;
 	static bool ExportClothMesh = false;
+	static bool Tiling = false;
+	static double TileSize = 500.0;
+	static double TileOverlap = 50.0;
 
 	// display the dialog
 	{
@@ -159,6 +138,9 @@ void qCSF::doAction()
 		csfDlg.cloth_resolutionSpinBox->setValue(cloth_resolution);
 		csfDlg.class_thresholdSpinBox->setValue(class_threshold);
 		csfDlg.exportClothMeshCheckBox->setChecked(ExportClothMesh);
+		csfDlg.tilingGroupBox->setChecked(Tiling);
+		csfDlg.tileSizeDoubleSpinBox->setValue(TileSize);
+		csfDlg.tileOverlapDoubleSpinBox->setValue(TileOverlap);
 
 		if (!csfDlg.exec())
 		{
@@ -177,37 +159,90 @@ void qCSF::doAction()
 		cloth_resolution = csfDlg.cloth_resolutionSpinBox->value();
 		class_threshold = csfDlg.class_thresholdSpinBox->value();
 		ExportClothMesh = csfDlg.exportClothMeshCheckBox->isChecked();
+		Tiling = csfDlg.tilingGroupBox->isChecked();
+		TileSize = csfDlg.tileSizeDoubleSpinBox->value();
+		TileOverlap = csfDlg.tileOverlapDoubleSpinBox->value();
 	}
 
-	//display the progress dialog
-	QProgressDialog pDlg;
-	pDlg.setWindowTitle("CSF");
-	pDlg.setLabelText("Computing....");
-	pDlg.setCancelButton(nullptr);
-	pDlg.show();
-	QApplication::processEvents();
+	if (Tiling && ExportClothMesh)
+	{
+		m_app->dispToConsole("[CSF] The cloth mesh can't be exported in tiled mode", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+		ExportClothMesh = false;
+	}
+
+	unsigned count = pc->size();
 
 	QElapsedTimer timer;
 	timer.start();
-	//instantiation a CSF class
-	CSF csf(csfPC);
 
 	// setup parameter
-	csf.params.k_nearest_points = 1;
-	csf.params.bSloopSmooth = csf_postprocessing;
-	csf.params.time_step = 0.65;
-	csf.params.class_threshold = class_threshold;
-	csf.params.cloth_resolution = cloth_resolution;
-	csf.params.rigidness = csf_rigidness;
-	csf.params.iterations = MaxIteration;
+	CSF::Parameters csfParams;
+	csfParams.k_nearest_points = 1;
+	csfParams.bSloopSmooth = csf_postprocessing;
+	csfParams.time_step = 0.65;
+	csfParams.class_threshold = class_threshold;
+	csfParams.cloth_resolution = cloth_resolution;
+	csfParams.rigidness = csf_rigidness;
+	csfParams.iterations = MaxIteration;
+
 	//to do filtering
 	std::vector<int> groundIndexes;
 	std::vector<int> offGroundIndexes;
 	ccMesh* clothMesh = nullptr;
-	if (!csf.do_filtering(groundIndexes, offGroundIndexes, ExportClothMesh, clothMesh, m_app))
+
+	if (Tiling)
 	{
-		m_app->dispToConsole("Process failed", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
-		return;
+		CSFTiling::Parameters tilingParams;
+		tilingParams.tileSize = TileSize;
+		tilingParams.overlap = TileOverlap;
+
+		ccProgressDialog tilingPDlg(true, m_app->getMainWindow());
+		if (!CSFTiling::Filter(pc, csfParams, tilingParams, groundIndexes, offGroundIndexes, &tilingPDlg))
+		{
+			m_app->dispToConsole("Process failed (or cancelled by the user)", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return;
+		}
+	}
+	else
+	{
+		//display the progress dialog
+		QProgressDialog pDlg;
+		pDlg.setWindowTitle("CSF");
+		pDlg.setLabelText("Computing....");
+		pDlg.setCancelButton(nullptr);
+		pDlg.show();
+		QApplication::processEvents();
+
+		//Convert CC point cloud to CSF type
+		wl::PointCloud csfPC;
+		try
+		{
+			csfPC.reserve(count);
+		}
+		catch (const std::bad_alloc&)
+		{
+			m_app->dispToConsole("Not enough memory!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return;
+		}
+		for (unsigned i = 0; i < count; i++)
+		{
+			const CCVector3* P = pc->getPoint(i);
+			wl::Point tmpPoint;
+			tmpPoint.x =  P->x;
+			tmpPoint.y = -P->z;
+			tmpPoint.z =  P->y;
+			csfPC.push_back(tmpPoint);
+		}
+
+		//instantiation a CSF class
+		CSF csf(csfPC);
+		csf.params = csfParams;
+
+		if (!csf.do_filtering(groundIndexes, offGroundIndexes, ExportClothMesh, clothMesh, m_app))
+		{
+			m_app->dispToConsole("Process failed", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+			return;
+		}
 	}
 
 	m_app->dispToConsole(QString("[CSF] %1% of points classified as ground points").arg((groundIndexes.size() * 100.0) / count, 0, 'f', 2), ccMainAppInterface::STD_CONSOLE_MESSAGE);
@@ -152,4 +152,37 @@ protected:
 	unsigned m_dimPerScale;
 };
 
+//! Descriptors of a set of (core) points, stored as a contiguous structure-of-arrays matrix
+/** The values of a given dimension are contiguous for all the points (dimension-major layout),
+	so that the linear projections of the classifiers can be applied to many points at once.
+**/
+class CorePointDescMatrix
+{
+public:
+
+	CorePointDescMatrix() : m_pointCount(0), m_dimCount(0) {}
+
+	//! Builds the matrix from a set of descriptors
+	/** \return false if not enough memory (or if the descriptors have different sizes)
+	**/
+	bool build(const CorePointDescSet& descriptors);
+
+	//! Returns the number of points
+	inline size_t pointCount() const { return m_pointCount; }
+	//! Returns the number of dimensions (i.e. values per point)
+	inline size_t dimCount() const { return m_dimCount; }
+
+	//! Returns the values of a given dimension (for all the points)
+	inline const float* dimension(size_t dimIndex) const { return m_values.data() + dimIndex * m_pointCount; }
+
+protected:
+
+	//! Values (dimension-major)
+	std::vector<float> m_values;
+	//! Number of points
+	size_t m_pointCount;
+	//! Number of dimensions
+	size_t m_dimCount;
+};
+
 #endif 
\ No newline at end of file
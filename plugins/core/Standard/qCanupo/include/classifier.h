@@ -63,6 +63,18 @@ public: //methods
 	//! Classification in MSC space
 	float classify(const CorePointDesc& mscdata) const;
 
+	//! Classification of a batch of descriptors in MSC space
+	/** The descriptors are read from a structure-of-arrays matrix (shared by all
+		the classifiers) so that the linear projections are applied to the whole
+		batch at once (vectorized).
+		\param descriptors descriptors matrix
+		\param firstIndex index of the first descriptor of the batch
+		\param count number of descriptors in the batch
+		\param distances output distances to the boundary (at least 'count' values)
+		\param stride distance (in number of values) between two consecutive outputs in 'distances'
+	**/
+	void classifyBatch(const CorePointDescMatrix& descriptors, size_t firstIndex, size_t count, float distances[], size_t stride = 1) const;
+
 	//! Classifier's file header info
 	struct FileHeader
 	{
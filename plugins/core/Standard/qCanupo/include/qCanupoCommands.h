@@ -26,6 +26,7 @@
 
 static const char COMMAND_CANUPO_CALSSIFY[] = "CANUPO_CLASSIFY";
 static const char COMMAND_CANUPO_CONFIDENCE[] = "USE_CONFIDENCE";
+static const char COMMAND_CANUPO_DESC_CACHE[] = "DESC_CACHE";
 
 struct CommandCanupoClassif : public ccCommandLineInterface::Command
 {
@@ -71,6 +72,19 @@ struct CommandCanupoClassif : public ccCommandLineInterface::Command
 
 				cmd.print(QString("Confidence threshold set to %1").arg(params.confidenceThreshold));
 			}
+			else if (ccCommandLineInterface::IsCommand(argument, COMMAND_CANUPO_DESC_CACHE))
+			{
+				//local option confirmed, we can move on
+				cmd.arguments().pop_front();
+
+				if (cmd.arguments().empty())
+				{
+					return cmd.error(QString("Missing parameter: cache folder after '%1'").arg(COMMAND_CANUPO_DESC_CACHE));
+				}
+
+				params.descriptorsCacheFolder = cmd.arguments().takeFirst();
+				cmd.print(QString("Descriptors cache: %1").arg(params.descriptorsCacheFolder));
+			}
 			else
 			{
 				//we assume the parameter is the classifier filename
@@ -108,7 +122,14 @@ struct CommandCanupoClassif : public ccCommandLineInterface::Command
 				params.useActiveSFForConfidence = false;
 			}
 
-			if (qCanupoProcess::Classify(classifierFilename, params, desc.pc, corePoints, corePointsDescriptors, realCorePoints, nullptr, nullptr, cmd.silentMode()))
+			bool success = false;
+			{
+				ccCommandLineInterface::ProfilingScope profiling(cmd, "Canupo", "classification");
+				profiling.setPointCount(desc.pc->size());
+				success = qCanupoProcess::Classify(classifierFilename, params, desc.pc, corePoints, corePointsDescriptors, realCorePoints, nullptr, nullptr, cmd.silentMode());
+			}
+
+			if (success)
 			{
 				if (cmd.autoSaveMode())
 				{
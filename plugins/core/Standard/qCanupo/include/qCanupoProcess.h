@@ -45,6 +45,11 @@ public:
 		bool useActiveSFForConfidence = true;
 		bool generateAdditionalSF = false;
 		bool generateRoughnessSF = false;
+		//! Folder of the on-disk descriptors cache (empty = no cache)
+		/** The descriptors are cached per cloud, scale set and descriptor type, so that
+			classifying the same cloud with another classifier doesn't compute them again.
+		**/
+		QString descriptorsCacheFolder;
 	};
 
 	//! Classify a point cloud
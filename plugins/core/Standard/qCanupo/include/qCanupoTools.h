@@ -90,6 +90,24 @@ public:
 												CCCoreLib::DgmOctree* inputOctree = nullptr,
 												std::vector<ccScalarField*>* roughnessSFs = nullptr /*for tests*/); 
 
+	//! Returns the key of the descriptors of a set of core points in an on-disk cache
+	/** The key depends on the core points and source cloud coordinates, on the scales
+		and on the descriptor type (and on the active scalar field of the source cloud if
+		the descriptor needs it).
+	**/
+	static QString DescriptorsCacheKey(	CCCoreLib::GenericIndexedCloud* corePoints,
+										ccGenericPointCloud* sourceCloud,
+										const std::vector<float>& scales,
+										unsigned descriptorID);
+
+	//! Loads descriptors from an on-disk cache
+	/** \return false if the cache has no (valid) entry for the given key
+	**/
+	static bool LoadDescriptorsFromCache(const QString& cacheFolder, const QString& key, CorePointDescSet& descriptors);
+
+	//! Saves descriptors in an on-disk cache
+	static bool SaveDescriptorsToCache(const QString& cacheFolder, const QString& key, const CorePointDescSet& descriptors);
+
 	//! Returns a long description of a given entity (name + [ID])
 	static QString GetEntityName(ccHObject* obj);
 
@@ -522,6 +522,49 @@ QByteArray CorePointDescSet::toByteArray() const
 	return data;
 }
 
+bool CorePointDescMatrix::build(const CorePointDescSet& descriptors)
+{
+	m_values.clear();
+	m_pointCount = 0;
+	m_dimCount = 0;
+
+	if (descriptors.empty())
+	{
+		return true;
+	}
+
+	size_t pointCount = descriptors.size();
+	size_t dimCount = descriptors.front().params.size();
+	try
+	{
+		m_values.resize(pointCount * dimCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		//not enough memory
+		return false;
+	}
+
+	for (size_t j = 0; j < pointCount; ++j)
+	{
+		const std::vector<float>& params = descriptors[j].params;
+		if (params.size() != dimCount)
+		{
+			assert(false);
+			m_values.clear();
+			return false;
+		}
+		for (size_t i = 0; i < dimCount; ++i)
+		{
+			m_values[i * pointCount + j] = params[i];
+		}
+	}
+
+	m_pointCount = pointCount;
+	m_dimCount = dimCount;
+	return true;
+}
+
 bool CorePointDescSet::fromByteArray(const QByteArray& data)
 {
 	if (data.size() < 2*sizeof(int))
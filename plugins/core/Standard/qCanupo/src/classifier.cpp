@@ -170,6 +170,44 @@ float Classifier::classify(const CorePointDesc& mscdata) const
 	return classify2D(P);
 }
 
+void Classifier::classifyBatch(const CorePointDescMatrix& descriptors, size_t firstIndex, size_t count, float distances[], size_t stride/*=1*/) const
+{
+	assert(weightsAxis1.size() == weightsAxis2.size());
+	assert(weightsAxis1.size() > 1);
+	assert(firstIndex + count <= descriptors.pointCount());
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	//see Classifier::project
+	size_t weightCount = weightsAxis1.size() - 1;
+	size_t paramCount = descriptors.dimCount();
+	assert(weightCount <= paramCount);
+	size_t shift = paramCount - weightCount;
+
+	//apply the linear projections on the whole batch (the values of each dimension are contiguous)
+	std::vector<float> X(count, weightsAxis1.back());
+	std::vector<float> Y(count, weightsAxis2.back());
+	for (size_t i = 0; i < weightCount; ++i)
+	{
+		const float w1 = weightsAxis1[i];
+		const float w2 = weightsAxis2[i];
+		const float* values = descriptors.dimension(shift + i) + firstIndex;
+		for (size_t j = 0; j < count; ++j)
+		{
+			X[j] += w1 * values[j];
+			Y[j] += w2 * values[j];
+		}
+	}
+
+	for (size_t j = 0; j < count; ++j)
+	{
+		distances[j * stride] = classify2D(Point2D(X[j], Y[j]));
+	}
+}
+
 bool Classifier::Load(QString filename,
 	std::vector<Classifier>& classifiers,
 	std::vector<float>& scales,
@@ -38,6 +38,12 @@
 #include <QApplication>
 #include <QMessageBox>
 #include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+//system
+#include <atomic>
 
 // Default SF names
 #ifdef COMPILE_PRIVATE_CANUPO
@@ -48,6 +54,9 @@ static const char CANUPO_PER_LEVEL_ADDITIONAL_SF_NAME[] = "CANUPO.(x-y)";
 //Reserved name for CANUPO 'MSC' meta-data
 static const char s_canupoMSCMetaData[] = "CanupoMSCData";
 
+//! Number of core points classified at once
+static const unsigned s_classifyBatchSize = 256;
+
 //Tries to refine the classification (returns the new confidence if successful)
 float RefinePointClassif(	const Classifier& classifier,
 							const float confidence,
@@ -396,6 +405,32 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 			computeDescriptors |= generateRoughnessSF;
 #endif
 
+			//the descriptors may have been cached on disk (by a previous classification)
+			QString descriptorsCacheKey;
+			bool useDescriptorsCache = (computeDescriptors && !params.descriptorsCacheFolder.isEmpty());
+#ifdef COMPILE_PRIVATE_CANUPO
+			useDescriptorsCache &= !generateRoughnessSF; //the roughness SFs are computed along with the descriptors
+#endif
+			if (useDescriptorsCache)
+			{
+				descriptorsCacheKey = qCanupoTools::DescriptorsCacheKey(corePoints, cloud, scales, descriptorID);
+				if (qCanupoTools::LoadDescriptorsFromCache(params.descriptorsCacheFolder, descriptorsCacheKey, corePointsDescriptors))
+				{
+					if (	corePointsDescriptors.size() == corePoints->size()
+						&&	corePointsDescriptors.descriptorID() == descriptorID
+						&&	qCanupoTools::CompareVectors(scales, corePointsDescriptors.scales()))
+					{
+						if (app)
+							app->dispToConsole(QString("[qCanupo] Descriptors loaded from the cache (%1)").arg(params.descriptorsCacheFolder), ccMainAppInterface::STD_CONSOLE_MESSAGE);
+						computeDescriptors = false;
+					}
+					else
+					{
+						corePointsDescriptors = CorePointDescSet();
+					}
+				}
+			}
+
 			//let's compute the descriptors
 			if (computeDescriptors)
 			{
@@ -470,6 +505,12 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 					if (app)
 						app->dispToConsole("[qCanupo] Some descriptors couldn't be computed (min scale may be too small)!", ccMainAppInterface::WRN_CONSOLE_MESSAGE);
 				}
+
+				if (!descriptorsCacheKey.isEmpty() && !qCanupoTools::SaveDescriptorsToCache(params.descriptorsCacheFolder, descriptorsCacheKey, corePointsDescriptors))
+				{
+					if (app)
+						app->dispToConsole(QString("[qCanupo] Failed to save the descriptors in the cache (%1)").arg(params.descriptorsCacheFolder), ccMainAppInterface::WRN_CONSOLE_MESSAGE);
+				}
 			}
 
 			//main classification process
@@ -514,6 +555,73 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 				corePointClasses.resize(corePointCount, -1);
 				corePointConfidences.resize(corePointCount, 0.0f);
 
+				//the distances to the boundary only depend on the descriptors: we compute them once, by batches and in parallel
+				//(all the classifiers read the same structure-of-arrays descriptors matrix)
+				size_t classifierCount = classifiers.size();
+				std::vector<float> distancesToBoundary; //point-major: one value per classifier for each core point
+				CorePointDescMatrix descriptorsMatrix;
+				try
+				{
+					distancesToBoundary.resize(corePointCount * classifierCount);
+				}
+				catch (const std::bad_alloc&)
+				{
+					if (app)
+						app->dispToConsole("Not enough memory to store the distances to the boundary!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+					break;
+				}
+				if (!descriptorsMatrix.build(corePointsDescriptors))
+				{
+					if (app)
+						app->dispToConsole("Not enough memory to gather the core points descriptors!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+					break;
+				}
+				{
+					std::atomic<size_t> nextBatchStart(0);
+					std::atomic<bool> notEnoughMemory(false);
+					auto classifyBatches = [&]()
+					{
+						//the exceptions can't be propagated outside of the worker threads
+						try
+						{
+							for (size_t firstIndex = nextBatchStart.fetch_add(s_classifyBatchSize); firstIndex < corePointCount; firstIndex = nextBatchStart.fetch_add(s_classifyBatchSize))
+							{
+								size_t count = std::min<size_t>(s_classifyBatchSize, corePointCount - firstIndex);
+								float* distances = distancesToBoundary.data() + firstIndex * classifierCount;
+								for (size_t c = 0; c < classifierCount; ++c)
+								{
+									classifiers[c].classifyBatch(descriptorsMatrix, firstIndex, count, distances + c, classifierCount);
+								}
+							}
+						}
+						catch (const std::bad_alloc&)
+						{
+							notEnoughMemory = true;
+						}
+					};
+
+					//(local pool, so as to not change the global one)
+					QThreadPool threadPool;
+					threadPool.setMaxThreadCount(params.maxThreadCount > 0 ? params.maxThreadCount : QThread::idealThreadCount());
+					std::vector< QFuture<void> > futures;
+					for (int t = 0; t < threadPool.maxThreadCount(); ++t)
+					{
+						futures.push_back(QtConcurrent::run(&threadPool, classifyBatches));
+					}
+					for (QFuture<void>& future : futures)
+					{
+						future.waitForFinished();
+					}
+
+					if (notEnoughMemory)
+					{
+						if (app)
+							app->dispToConsole("Not enough memory to classify the core points!", ccMainAppInterface::ERR_CONSOLE_MESSAGE);
+						break;
+					}
+				}
+				descriptorsMatrix = CorePointDescMatrix(); //release memory
+
 				//number of points that couldn't be classified
 				std::vector<unsigned> pendingPoints(corePointCount);
 				{
@@ -538,13 +646,13 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 					for (size_t i = 0; i < pendingPoints.size(); ++i)
 					{
 						unsigned coreIndex = pendingPoints[i];
-						CorePointDesc& coreDesc = corePointsDescriptors[coreIndex];
+						const float* coreDistances = distancesToBoundary.data() + static_cast<size_t>(coreIndex) * classifierCount;
 
 						//most common case
 						if (classifiers.size() == 1)
 						{
 							const Classifier& classifier = classifiers.front();
-							float distToBoundary = classifier.classify(coreDesc);
+							float distToBoundary = coreDistances[0];
 
 							float confidence = 1.0f / (exp(-std::abs(distToBoundary)) + 1.0f); //in [0.5 ; 1]
 							confidence = 2 * (confidence - 0.5f); //map to [0;1]
@@ -587,13 +695,13 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 							if (!unreliable)
 							{
 								int theClass = (distToBoundary >= 0 ? classifier.class2 : classifier.class1);
-								corePointClasses[i] = theClass;
-								corePointConfidences[i] = confidence;
+								corePointClasses[coreIndex] = theClass;
+								corePointConfidences[coreIndex] = confidence;
 							}
 							else if (params.useActiveSFForConfidence)
 							{
 								//this point can't be classified this way
-								unreliablePointIndexes.push_back(static_cast<unsigned>(i));
+								unreliablePointIndexes.push_back(coreIndex);
 							}
 						}
 						else //more than one classifier
@@ -602,12 +710,12 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 							std::map< int, float > minConfidences;
 
 							// apply all classifiers and look for the most represented class
-							for (std::vector<Classifier>::const_iterator classifierIt = classifiers.begin(); classifierIt != classifiers.end(); ++classifierIt)
+							for (size_t c = 0; c < classifierCount; ++c)
 							{
-								const Classifier& classifier = *classifierIt;
+								const Classifier& classifier = classifiers[c];
 
 								// uniformize the order, distToBoundary>0 selects the larger class of both
-								float distToBoundary = classifier.classify(coreDesc); //DGM: the descriptors may have more values than the number of scales!
+								float distToBoundary = coreDistances[c]; //DGM: the descriptors may have more values than the number of scales!
 								//if (classifier.class1 > classifier.class2)
 								//	distToBoundary = -distToBoundary;
 
@@ -706,13 +814,13 @@ bool qCanupoProcess::Classify(	QString classifierFilename,
 									}
 								}
 
-								corePointClasses[i] = bestClassLabel;
-								corePointConfidences[i] = minConfidences[bestClassLabel];
+								corePointClasses[coreIndex] = bestClassLabel;
+								corePointConfidences[coreIndex] = minConfidences[bestClassLabel];
 							}
 							else if (params.useActiveSFForConfidence)
 							{
 								//this point can't be classified this way
-								unreliablePointIndexes.push_back(static_cast<unsigned>(i));
+								unreliablePointIndexes.push_back(coreIndex);
 							}
 						}
 
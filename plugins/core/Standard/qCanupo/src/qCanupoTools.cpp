@@ -36,9 +36,15 @@
 //Qt
 #include <QApplication>
 #include <QComboBox>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
 #include <QMainWindow>
 #include <QtConcurrentMap>
 
+//system
+#include <algorithm>
+
 //ComputeCorePointsDescriptors parameters
 static struct
 {
@@ -99,7 +105,8 @@ void ComputeCorePointDescriptor(unsigned index)
 			}
 
 			//sort the neighbors by increasing distance
-			ParallelSort(neighbours.begin(), neighbours.end(), CCCoreLib::DgmOctree::PointDescriptor::distComp);
+			//(we are already called in parallel, no need to use a parallel sort here)
+			std::sort(neighbours.begin(), neighbours.end(), CCCoreLib::DgmOctree::PointDescriptor::distComp);
 
 			for (int j = 0; j < n; ++j)
 			{
@@ -412,6 +419,106 @@ size_t qCanupoTools::TestVectorsOverlap(const std::vector<float>& first, const s
 	return i;
 }
 
+//! Extension of the descriptors files in the on-disk cache
+static const char s_descriptorsCacheExtension[] = "canupo_desc";
+
+//! Adds the coordinates of a cloud to a hash (by blocks, to limit the number of calls)
+static void HashCloudCoordinates(CCCoreLib::GenericIndexedCloud* cloud, QCryptographicHash& hash)
+{
+	static const unsigned BlockSize = (1 << 16);
+	std::vector<CCVector3> block;
+	block.reserve(std::min(BlockSize, cloud->size()));
+
+	unsigned pointCount = cloud->size();
+	hash.addData(reinterpret_cast<const char*>(&pointCount), sizeof(unsigned));
+	for (unsigned i = 0; i < pointCount; ++i)
+	{
+		block.push_back(*cloud->getPoint(i));
+		if (block.size() == BlockSize || i + 1 == pointCount)
+		{
+			hash.addData(reinterpret_cast<const char*>(block.data()), static_cast<int>(block.size() * sizeof(CCVector3)));
+			block.clear();
+		}
+	}
+}
+
+QString qCanupoTools::DescriptorsCacheKey(	CCCoreLib::GenericIndexedCloud* corePoints,
+											ccGenericPointCloud* sourceCloud,
+											const std::vector<float>& scales,
+											unsigned descriptorID)
+{
+	assert(corePoints && sourceCloud);
+
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	hash.addData(reinterpret_cast<const char*>(&descriptorID), sizeof(unsigned));
+	hash.addData(reinterpret_cast<const char*>(scales.data()), static_cast<int>(scales.size() * sizeof(float)));
+	HashCloudCoordinates(corePoints, hash);
+	if (sourceCloud != corePoints)
+	{
+		HashCloudCoordinates(sourceCloud, hash);
+	}
+
+	//the scalar values are part of some descriptors
+	ScaleParamsComputer* computer = ScaleParamsComputer::GetByID(descriptorID);
+	if (computer && computer->needSF() && sourceCloud->isA(CC_TYPES::POINT_CLOUD))
+	{
+		const CCCoreLib::ScalarField* sf = static_cast<ccPointCloud*>(sourceCloud)->getCurrentDisplayedScalarField();
+		if (sf && !sf->empty())
+		{
+			hash.addData(reinterpret_cast<const char*>(sf->data()), static_cast<int>(sf->size() * sizeof(ScalarType)));
+		}
+	}
+
+	return QString::fromLatin1(hash.result().toHex());
+}
+
+bool qCanupoTools::LoadDescriptorsFromCache(const QString& cacheFolder, const QString& key, CorePointDescSet& descriptors)
+{
+	QFile file(QDir(cacheFolder).absoluteFilePath(key + "." + s_descriptorsCacheExtension));
+	if (!file.exists() || !file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	CorePointDescSet cachedDescriptors;
+	if (!cachedDescriptors.fromByteArray(file.readAll()))
+	{
+		return false;
+	}
+
+	descriptors = cachedDescriptors;
+	return true;
+}
+
+bool qCanupoTools::SaveDescriptorsToCache(const QString& cacheFolder, const QString& key, const CorePointDescSet& descriptors)
+{
+	QDir dir(cacheFolder);
+	if (!dir.exists() && !dir.mkpath("."))
+	{
+		return false;
+	}
+
+	QByteArray data = descriptors.toByteArray();
+	if (data.isEmpty())
+	{
+		return false;
+	}
+
+	//we write a temporary file first, so that a concurrent reader never sees a partial file
+	QString filename = dir.absoluteFilePath(key + "." + s_descriptorsCacheExtension);
+	QString tempFilename = filename + ".tmp";
+	{
+		QFile file(tempFilename);
+		if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+		{
+			QFile::remove(tempFilename);
+			return false;
+		}
+	}
+	QFile::remove(filename);
+	return QFile::rename(tempFilename, filename);
+}
+
 QString qCanupoTools::GetEntityName(ccHObject* obj)
 {
 	if (!obj)
@@ -62,9 +62,13 @@ struct CommandM3C2 : public ccCommandLineInterface::Command
 
 		QString errorMessage;
 		ccPointCloud* outputCloud = nullptr; //only necessary for the command line version in fact
-		if (!qM3C2Process::Compute(dlg, errorMessage, outputCloud, !cmd.silentMode(), cmd.widgetParent()))
 		{
-			return cmd.error(errorMessage);
+			ccCommandLineInterface::ProfilingScope profiling(cmd, "M3C2", "distances computation");
+			profiling.setPointCount(corePointsCloud ? corePointsCloud->size() : cloud1->size());
+			if (!qM3C2Process::Compute(dlg, errorMessage, outputCloud, !cmd.silentMode(), cmd.widgetParent()))
+			{
+				return cmd.error(errorMessage);
+			}
 		}
 
 		if (outputCloud)
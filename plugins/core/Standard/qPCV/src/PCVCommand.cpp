@@ -221,9 +221,19 @@ bool PCVCommand::process(ccCommandLineInterface& cmd)
 	for (CLMeshDesc& desc : cmd.meshes())
 		candidates.push_back(desc.mesh);
 
-	if (!Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, nullptr))
 	{
-		return cmd.error(QObject::tr("Process failed"));
+		ccCommandLineInterface::ProfilingScope profiling(cmd, "PCV", "illumination");
+		size_t pointCount = 0;
+		for (const CLCloudDesc& desc : cmd.clouds())
+			pointCount += desc.pc->size();
+		for (const CLMeshDesc& desc : cmd.meshes())
+			pointCount += desc.mesh->getAssociatedCloud()->size();
+		profiling.setPointCount(pointCount);
+
+		if (!Process(candidates, rays, meshIsClosed, resolution, &pcvProgressCb, nullptr))
+		{
+			return cmd.error(QObject::tr("Process failed"));
+		}
 	}
 
 	for (CLCloudDesc& desc : cmd.clouds())
@@ -6,6 +6,9 @@
  *
  */
 #include <stdio.h>
+#include <ctime>
+#include <functional>
+#include <thread>
 #include "Random.h"
 #define register 
 using namespace MiscLib;
@@ -19,13 +22,15 @@ using namespace MiscLib;
 #define is_odd(x)     ( (x) & 1 )
 #define evenize(x)    ( (x) & (MM-2) )
 
-size_t MiscLib::rn_buf[MiscLib_RN_BUFSIZE];
-size_t MiscLib::rn_point = MiscLib_RN_BUFSIZE;
+thread_local size_t MiscLib::rn_buf[MiscLib_RN_BUFSIZE];
+thread_local size_t MiscLib::rn_point = MiscLib_RN_BUFSIZE;
+static thread_local bool rn_seeded = false;
 
 void MiscLib::rn_setseed(size_t seed)
 {
   register int t, j;
   size_t x[KK+KK-1];
+  rn_seeded = true;
   register size_t ss = evenize(seed+2);
   for (j=0;j<KK;j++) {
     x[j]=ss;
@@ -57,6 +62,8 @@ void MiscLib::rn_setseed(size_t seed)
 size_t MiscLib::rn_refresh()
 {
 /* You remember Duff's device? If it would help then it should be used here */
+  if (!rn_seeded) /* first draw on this thread */
+    rn_setseed((size_t)time(NULL) ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
   rn_point=1;
 
   register int i, j;
@@ -111,7 +111,8 @@ void RansacShapeDetector::GenerateCandidates(
 	for(int candIter = 0; candIter < 200; ++candIter)
 	{
 		// pick a sample level
-		double s = ((double)rand()) / (double)RAND_MAX;
+		// (rn_frand uses a per-thread generator, unlike rand())
+		double s = static_cast<double>(rn_frand());
 		size_t sampleLevel = 0;
 		for(; sampleLevel < sampleLevelProbSum.size() - 1; ++sampleLevel)
 			if(sampleLevelProbSum[sampleLevel] >= s)
@@ -453,14 +454,15 @@ bool RansacShapeDetector::FindBestCandidate(CandidatesType &candidates,
 
 size_t
 RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
-	MiscLib::Vector< std::pair< RefCountPtr< PrimitiveShape >, size_t > > *shapes)
+	MiscLib::Vector< std::pair< RefCountPtr< PrimitiveShape >, size_t > > *shapes,
+	size_t seedOffset)
 {
 	size_t pcSize = endIdx - beginIdx;
 	/*
 	 * Initialization part
 	 */
-	srand((unsigned int)time(NULL));
-	rn_setseed((size_t)time(NULL));
+	// the offset decorrelates concurrent detections (e.g. on different blocks)
+	rn_setseed((size_t)time(NULL) + seedOffset);
 
 	CandidatesType candidates;
 
@@ -724,10 +726,9 @@ RansacShapeDetector::Detect(PointCloud &pc, size_t beginIdx, size_t endIdx,
 
 				// reindex global octree
 				size_t minInvalidIndex = currentSize - numInvalid + beginIdx;
+				// this compaction must stay sequential (the shared write cursor
+				// j made the parallel version corrupt the global octree)
 				int j = 0;
-#ifdef DOPARALLEL
-				#pragma omp parallel for schedule(static)
-#endif
 				for(int i = 0; i < static_cast<int>(globalOctreeIndices.size()); ++i)
 					if(shapeIndex[globalOctreeIndices[i]] < minInvalidIndex)
 						globalOctreeIndices[j++] = shapeIndex[globalOctreeIndices[i]];
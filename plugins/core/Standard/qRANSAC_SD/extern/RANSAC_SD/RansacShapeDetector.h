@@ -41,8 +41,11 @@ class DLL_LINKAGE RansacShapeDetector
 		RansacShapeDetector(const Options &options);
 		virtual ~RansacShapeDetector();
 		void Add(PrimitiveShapeConstructor *c);
+		// seedOffset is added to the (time based) seed of the random generator, so that
+		// concurrent detections started at the same time draw different candidates
 		size_t Detect(PointCloud &pc, size_t begin, size_t end,
-			MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > > *shapes);
+			MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > > *shapes,
+			size_t seedOffset = 0);
 		void AutoAcceptSize(size_t s) { m_autoAcceptSize = s; }
 		size_t AutoAcceptSize() const { return m_autoAcceptSize; }
 		const Options &GetOptions() const { return m_options; }
@@ -67,6 +67,8 @@ public:
 		float minTorusMajorRadius;
 		float maxTorusMinorRadius;
 		float maxTorusMajorRadius;
+		float blockSize; // size of the spatial blocks processed in parallel (0 = whole cloud at once)
+		int maxThreadCount; // max number of threads used in block mode (0 = all)
 
 		RansacParams() : epsilon(0.005f)
 			, bitmapEpsilon(0.001f)
@@ -89,6 +91,8 @@ public:
 			, minTorusMajorRadius(std::numeric_limits<float>::infinity())
 			, maxTorusMinorRadius(std::numeric_limits<float>::infinity())
 			, maxTorusMajorRadius(std::numeric_limits<float>::infinity())
+			, blockSize(0.0f)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
@@ -118,6 +122,8 @@ public:
 			, minTorusMajorRadius(std::numeric_limits<float>::infinity())
 			, maxTorusMinorRadius(std::numeric_limits<float>::infinity())
 			, maxTorusMajorRadius(std::numeric_limits<float>::infinity())
+			, blockSize(0.0f)
+			, maxThreadCount(0)
 		{
 			primEnabled[RPT_PLANE] = true;
 			primEnabled[RPT_SPHERE] = true;
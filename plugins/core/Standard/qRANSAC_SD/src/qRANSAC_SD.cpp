@@ -38,6 +38,8 @@
 #include <QtGui>
 #include <QApplication>
 #include <QtConcurrentRun>
+#include <QThread>
+#include <QThreadPool>
 #include <QApplication>
 #include <QProgressDialog>
 #include <QMainWindow>
@@ -55,9 +57,17 @@
 //CCCoreLib
 #include <ScalarField.h>
 #include <CCPlatform.h>
+#include <ParallelSort.h>
 
 //System
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #if defined(CC_WINDOWS)
 #include "windows.h"
 #else
@@ -105,16 +115,368 @@ void qRansacSD::registerCommands(ccCommandLineInterface* cmd)
 	cmd->registerCommand(ccCommandLineInterface::Command::Shared(new CommandRANSAC));
 }
 
-static MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > >* s_shapes; // stores the detected shapes
-static size_t s_remainingPoints = 0;
-static RansacShapeDetector* s_detector = 0;
-static PointCloud* s_cloud = 0;
+typedef std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > DetectedShape;
+
+//! Spatial block of the (reordered) cloud processed by a single detection
+struct RansacBlock
+{
+	size_t begin = 0; //first point (in the temporary cloud)
+	size_t end = 0; //last point + 1
+	int cellPos[3] = { 0, 0, 0 }; //position in the block grid
+	size_t remainingPoints = 0; //points not assigned to any shape (they are stored at the beginning of the block)
+	MiscLib::Vector< DetectedShape > shapes; //shapes detected in this block
+};
+
+static std::vector<RansacBlock>* s_blocks = nullptr; // detection blocks
+static RansacShapeDetector* s_detector = nullptr;
+static PointCloud* s_cloud = nullptr;
+static int s_maxThreadCount = 0;
+static std::atomic<bool> s_notEnoughMemory(false);
+
+static void DetectInBlock(RansacBlock& block, size_t blockIndex)
+{
+	const size_t blockPointCount = block.end - block.begin;
+	if (blockPointCount < s_detector->GetOptions().m_minSupport)
+	{
+		//not enough points to detect anything
+		block.remainingPoints = blockPointCount;
+		return;
+	}
+
+	if (s_blocks->size() == 1)
+	{
+		//the whole cloud is processed at once
+		block.remainingPoints = s_detector->Detect(*s_cloud, block.begin, block.end, &block.shapes);
+		return;
+	}
+
+	//the detector allocates its internal structures for the whole input cloud: we give it a copy
+	//of the block so that the memory and the time spent per block only depend on the block size
+	try
+	{
+		PointCloud blockCloud(&(*s_cloud)[block.begin], static_cast<unsigned>(blockPointCount));
+		//same bounding-box as the whole cloud (so that the detection scale is the same for all blocks)
+		blockCloud.setBBox(s_cloud->GetBBoxMin(), s_cloud->GetBBoxMax());
+
+		//each block has its own seed (the blocks are copied, so they all start at index 0)
+		block.remainingPoints = s_detector->Detect(blockCloud, 0, blockPointCount, &block.shapes, blockIndex);
+
+		//the detector has reordered the points of the block
+		std::copy(blockCloud.begin(), blockCloud.end(), &(*s_cloud)[block.begin]);
+	}
+	catch (const std::bad_alloc&)
+	{
+		block.shapes.clear();
+		block.remainingPoints = blockPointCount;
+		s_notEnoughMemory = true;
+	}
+}
+
 void doDetection()
 {
-	if (!s_detector || !s_cloud || !s_shapes)
+	if (!s_detector || !s_cloud || !s_blocks)
 		return;
 
-	s_remainingPoints = s_detector->Detect(*s_cloud, 0, s_cloud->size(), s_shapes);
+	s_notEnoughMemory = false;
+
+	if (s_blocks->size() == 1)
+	{
+		DetectInBlock(s_blocks->front(), 0);
+	}
+	else
+	{
+		int maxThreadCount = (s_maxThreadCount == 0 ? QThread::idealThreadCount() : s_maxThreadCount);
+		maxThreadCount = std::min(maxThreadCount, static_cast<int>(s_blocks->size()));
+
+		//each worker processes the blocks one after the other (local pool, so as to not change the global one)
+		QThreadPool threadPool;
+		threadPool.setMaxThreadCount(maxThreadCount);
+		std::atomic<size_t> nextBlock(0);
+		std::vector< QFuture<void> > workers;
+		workers.reserve(maxThreadCount);
+		for (int w = 0; w < maxThreadCount; ++w)
+		{
+			workers.push_back(QtConcurrent::run(&threadPool, [&nextBlock]()
+			{
+#ifdef _OPENMP
+				//the blocks are already processed concurrently
+				omp_set_num_threads(1);
+#endif
+				for (size_t b = nextBlock++; b < s_blocks->size(); b = nextBlock++)
+				{
+					DetectInBlock((*s_blocks)[b], b);
+				}
+			}));
+		}
+		for (QFuture<void>& worker : workers)
+		{
+			worker.waitForFinished();
+		}
+	}
+}
+
+//! Sorts the points of the cloud by spatial block (in place) and returns the non-empty blocks
+static bool BuildBlocks(PointCloud& cloud, const CCVector3& bbMin, const CCVector3& bbMax, float blockSize, std::vector<RansacBlock>& blocks)
+{
+	const size_t pointCount = cloud.size();
+
+	int gridSize[3];
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		gridSize[d] = std::max(1, static_cast<int>(std::ceil((bbMax.u[d] - bbMin.u[d]) / blockSize)));
+	}
+
+	std::vector< std::pair<uint64_t, size_t> > cellKeys;
+	try
+	{
+		cellKeys.resize(pointCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < pointCount; ++i)
+	{
+		uint64_t cellPos[3];
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			int c = static_cast<int>((cloud[i].pos[d] - bbMin.u[d]) / blockSize);
+			cellPos[d] = static_cast<uint64_t>(std::min(std::max(c, 0), gridSize[d] - 1));
+		}
+		cellKeys[i].first = (cellPos[2] * gridSize[1] + cellPos[1]) * gridSize[0] + cellPos[0];
+		cellKeys[i].second = i;
+	}
+	ParallelSort(cellKeys.begin(), cellKeys.end());
+
+	//extract the blocks
+	try
+	{
+		for (size_t i = 0; i < pointCount; )
+		{
+			const uint64_t key = cellKeys[i].first;
+			RansacBlock block;
+			block.begin = i;
+			while (i < pointCount && cellKeys[i].first == key)
+			{
+				++i;
+			}
+			block.end = i;
+			block.cellPos[0] = static_cast<int>(key % gridSize[0]);
+			block.cellPos[1] = static_cast<int>((key / gridSize[0]) % gridSize[1]);
+			block.cellPos[2] = static_cast<int>(key / (static_cast<uint64_t>(gridSize[0]) * gridSize[1]));
+			blocks.push_back(block);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		blocks.clear();
+		return false;
+	}
+
+	//apply the permutation in place (by following its cycles)
+	for (size_t i = 0; i < pointCount; ++i)
+	{
+		if (cellKeys[i].second == i)
+		{
+			continue;
+		}
+		Point P = cloud[i];
+		size_t j = i;
+		while (true)
+		{
+			size_t k = cellKeys[j].second;
+			cellKeys[j].second = j;
+			if (k == i)
+			{
+				cloud[j] = P;
+				break;
+			}
+			cloud[j] = cloud[k];
+			j = k;
+		}
+	}
+
+	return true;
+}
+
+//! Shape found by the detection, possibly made of several parts (merged across block borders)
+struct RansacShape
+{
+	DetectedShape shape; //largest part
+	std::vector< std::pair<size_t, size_t> > ranges; //point ranges in the temporary cloud
+	size_t pointCount = 0;
+	size_t blockIndex = 0;
+};
+
+//! Returns whether two shapes (detected in different blocks) are the same primitive
+static bool SameShape(const PrimitiveShape* shapeA, const PrimitiveShape* shapeB, float epsilon, float normalThresh)
+{
+	if (shapeA->Identifier() != shapeB->Identifier())
+	{
+		return false;
+	}
+
+	switch (shapeA->Identifier())
+	{
+	case qRansacSD::RPT_PLANE: //coplanar planes
+	{
+		const Plane& A = static_cast<const PlanePrimitiveShape*>(shapeA)->Internal();
+		const Plane& B = static_cast<const PlanePrimitiveShape*>(shapeB)->Internal();
+		return std::abs(A.getNormal().dot(B.getNormal())) >= normalThresh
+			&& std::abs(A.SignedDistance(B.getPosition())) < epsilon
+			&& std::abs(B.SignedDistance(A.getPosition())) < epsilon;
+	}
+
+	case qRansacSD::RPT_CYLINDER: //coaxial cylinders with the same radius
+	{
+		const Cylinder& A = static_cast<const CylinderPrimitiveShape*>(shapeA)->Internal();
+		const Cylinder& B = static_cast<const CylinderPrimitiveShape*>(shapeB)->Internal();
+		if (std::abs(A.AxisDirection().dot(B.AxisDirection())) < normalThresh
+			|| std::abs(A.Radius() - B.Radius()) >= epsilon)
+		{
+			return false;
+		}
+		//distance between the position of B and the axis of A
+		Vec3f d = B.AxisPosition() - A.AxisPosition();
+		Vec3f orthoD = d - A.AxisDirection() * d.dot(A.AxisDirection());
+		return orthoD.length() < epsilon;
+	}
+
+	default:
+		//other primitives are not merged
+		break;
+	}
+
+	return false;
+}
+
+//! Returns the key of a block (from its position in the block grid)
+static inline uint64_t BlockKey(int x, int y, int z)
+{
+	//21 bits per dimension
+	return (static_cast<uint64_t>(x) << 42) | (static_cast<uint64_t>(y) << 21) | static_cast<uint64_t>(z);
+}
+
+//! Merges the shapes detected in adjacent blocks that correspond to the same primitive
+/** Only the shapes of adjacent blocks are compared.
+	\warning The shapes must be sorted by block index
+	
+eturn false if there's not enough memory
+**/
+static bool MergeShapes(std::vector<RansacShape>& shapes, const std::vector<RansacBlock>& blocks, float epsilon, float normalThresh)
+{
+	try
+	{
+		//range of shapes of each block
+		std::vector<size_t> blockFirstShape(blocks.size() + 1, shapes.size());
+		for (size_t i = shapes.size(); i-- > 0; )
+		{
+			blockFirstShape[shapes[i].blockIndex] = i;
+		}
+		for (size_t b = blocks.size(); b-- > 0; )
+		{
+			blockFirstShape[b] = std::min(blockFirstShape[b], blockFirstShape[b + 1]);
+		}
+
+		//blocks by position
+		std::unordered_map<uint64_t, size_t> blockIndexes;
+		blockIndexes.reserve(blocks.size());
+		for (size_t b = 0; b < blocks.size(); ++b)
+		{
+			blockIndexes[BlockKey(blocks[b].cellPos[0], blocks[b].cellPos[1], blocks[b].cellPos[2])] = b;
+		}
+
+		//union-find
+		std::vector<size_t> parent(shapes.size());
+		for (size_t i = 0; i < shapes.size(); ++i)
+		{
+			parent[i] = i;
+		}
+		auto root = [&parent](size_t i)
+		{
+			while (parent[i] != i)
+			{
+				i = parent[i] = parent[parent[i]];
+			}
+			return i;
+		};
+
+		for (size_t i = 0; i < shapes.size(); ++i)
+		{
+			const RansacBlock& blockI = blocks[shapes[i].blockIndex];
+
+			//look for the same shape in the adjacent blocks
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dz = -1; dz <= 1; ++dz)
+					{
+						int x = blockI.cellPos[0] + dx;
+						int y = blockI.cellPos[1] + dy;
+						int z = blockI.cellPos[2] + dz;
+						if ((dx == 0 && dy == 0 && dz == 0) || x < 0 || y < 0 || z < 0)
+						{
+							continue;
+						}
+						auto it = blockIndexes.find(BlockKey(x, y, z));
+						if (it == blockIndexes.end() || it->second < shapes[i].blockIndex)
+						{
+							//no such block, or pair already tested
+							continue;
+						}
+
+						for (size_t j = blockFirstShape[it->second]; j < blockFirstShape[it->second + 1]; ++j)
+						{
+							if (SameShape(shapes[i].shape.first, shapes[j].shape.first, epsilon, normalThresh))
+							{
+								size_t rootI = root(i);
+								size_t rootJ = root(j);
+								if (rootI != rootJ)
+								{
+									parent[std::max(rootI, rootJ)] = std::min(rootI, rootJ);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		std::vector<RansacShape> mergedShapes;
+		mergedShapes.reserve(shapes.size());
+		std::vector<size_t> mergedIndex(shapes.size());
+		for (size_t i = 0; i < shapes.size(); ++i)
+		{
+			size_t r = root(i);
+			if (r == i)
+			{
+				mergedIndex[i] = mergedShapes.size();
+				mergedShapes.push_back(shapes[i]);
+			}
+			else
+			{
+				//the root always comes first
+				RansacShape& mergedShape = mergedShapes[mergedIndex[r]];
+				mergedShape.ranges.insert(mergedShape.ranges.end(), shapes[i].ranges.begin(), shapes[i].ranges.end());
+				mergedShape.pointCount += shapes[i].pointCount;
+				//we keep the primitive fitted on the largest part
+				if (shapes[i].shape.second > mergedShape.shape.second)
+				{
+					mergedShape.shape = shapes[i].shape;
+				}
+			}
+		}
+
+		shapes.swap(mergedShapes);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+
+	return true;
 }
 
 //for parameters persistence
@@ -150,6 +512,8 @@ static double s_minTorusMinorRadius = 1;
 static double s_minTorusMajorRadius = 1;
 static double s_maxTorusMinorRadius = 1;
 static double s_maxTorusMajorRadius = 1;
+static bool s_blockModeEnabled = false;
+static double s_blockSize = 0;
 
 void qRansacSD::doAction()
 {
@@ -219,6 +583,8 @@ void qRansacSD::doAction()
 	rsdDlg.maxTorusMinorRadiusdoubleSpinBox->setValue(s_maxTorusMinorRadius);
 	rsdDlg.maxTorusMajorRadiusdoubleSpinBox->setValue(s_maxTorusMajorRadius);
 	rsdDlg.randomColorcheckBox->setChecked(s_randomColor);
+	rsdDlg.blockModeGroupBox->setChecked(s_blockModeEnabled);
+	rsdDlg.blockSizeDoubleSpinBox->setValue(s_blockSize > 0 ? s_blockSize : 0.1 * scale); // default: 10% of bounding box width
 	if (!rsdDlg.exec())
 	{
 		return;
@@ -235,6 +601,7 @@ void qRansacSD::doAction()
 	s_maxTorusMinorRadiusEnabled = rsdDlg.maxTorusMinorRadiuscheckBox->isChecked();
 	s_maxTorusMajorRadiusEnabled = rsdDlg.maxTorusMajorRadiuscheckBox->isChecked();
 	s_randomColor = rsdDlg.randomColorcheckBox->isChecked();
+	s_blockModeEnabled = rsdDlg.blockModeGroupBox->isChecked();
 	RansacParams params;
 	{
 		params.epsilon = static_cast<float>(rsdDlg.epsilonDoubleSpinBox->value());
@@ -307,6 +674,11 @@ void qRansacSD::doAction()
 			params.maxTorusMajorRadius = static_cast<float>(rsdDlg.maxTorusMajorRadiusdoubleSpinBox->value());
 			s_maxTorusMajorRadius = params.maxTorusMajorRadius;
 		}
+		if (s_blockModeEnabled)
+		{
+			params.blockSize = static_cast<float>(rsdDlg.blockSizeDoubleSpinBox->value());
+			s_blockSize = params.blockSize;
+		}
 	}
 	
 	ccHObject* group = executeRANSAC(pc, params, false);
@@ -476,18 +848,32 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		detector.Add(new TorusPrimitiveShapeConstructor(false, params.minTorusMinorRadius, params.minTorusMajorRadius, params.maxTorusMinorRadius, params.maxTorusMajorRadius)); // Do not allow apple shaped torus
 
 
-	unsigned remaining = count;
-	typedef std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > DetectedShape;
-	MiscLib::Vector< DetectedShape > shapes; // stores the detected shapes
+	//spatial blocks (processed in parallel)
+	std::vector<RansacBlock> blocks;
+	if (params.blockSize > 0)
+	{
+		//the points are sorted by block so that each block is a contiguous range of the cloud
+		if (!BuildBlocks(cloud, bbMin, bbMax, params.blockSize, blocks))
+		{
+			ccLog::Error("[qRansacSD] Not enough memory!");
+			return nullptr;
+		}
+		ccLog::Print(QString("[qRansacSD] Detection will be run on %1 blocks").arg(blocks.size()));
+	}
+	else
+	{
+		blocks.resize(1);
+		blocks.front().end = count;
+	}
 
-	// run detection
+	// run detection (on each block)
 	// returns number of unassigned points
 	// the array shapes is filled with pointers to the detected shapes
 	// the second element per shapes gives the number of points assigned to that primitive (the support)
-	// the points belonging to the first shape (shapes[0]) have been sorted to the end of pc,
-	// i.e. into the range [ pc.size() - shapes[0].second, pc.size() )
+	// the points belonging to the first shape (shapes[0]) have been sorted to the end of the block,
+	// i.e. into the range [ end - shapes[0].second, end )
 	// the points of shape i are found in the range
-	// [ pc.size() - \sum_{j=0..i} shapes[j].second, pc.size() - \sum_{j=0..i-1} shapes[j].second )
+	// [ end - \sum_{j=0..i} shapes[j].second, end - \sum_{j=0..i-1} shapes[j].second )
 
 	{
 		//progress dialog (Qtconcurrent::run can't be canceled!)
@@ -508,8 +894,9 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 
 		//run in a separate thread
 		s_detector = &detector;
-		s_shapes = &shapes;
+		s_blocks = &blocks;
 		s_cloud = &cloud;
+		s_maxThreadCount = params.maxThreadCount;
 		QElapsedTimer eTimer;
 		eTimer.start();
 		QFuture<void> future = QtConcurrent::run(doDetection);
@@ -527,8 +914,6 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 			}
 			QApplication::processEvents();
 		}
-		remaining = static_cast<unsigned>(s_remainingPoints);
-
 		QApplication::processEvents();
 		if (pDlg)
 		{
@@ -540,6 +925,67 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		ccLog::Print("[qRANSAC] Search Timing: %2.3f s", static_cast<double>(elapsedTime_ms) / 1.0e3);
 	}
 
+	if (s_notEnoughMemory)
+	{
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		return nullptr;
+	}
+
+	//gather the detected shapes (and the unassigned points) of all blocks
+	std::vector<RansacShape> shapes;
+	std::vector< std::pair<size_t, size_t> > leftOverRanges;
+	unsigned remaining = 0;
+	try
+	{
+		for (size_t b = 0; b < blocks.size(); ++b)
+		{
+			const RansacBlock& block = blocks[b];
+			size_t shapeEnd = block.end;
+			for (const DetectedShape& detectedShape : block.shapes)
+			{
+				RansacShape shape;
+				shape.shape = detectedShape;
+				shape.pointCount = detectedShape.second;
+				shape.ranges.emplace_back(shapeEnd - detectedShape.second, shapeEnd);
+				shape.blockIndex = b;
+				shapes.push_back(shape);
+				shapeEnd -= detectedShape.second;
+			}
+
+			//the unassigned points are at the beginning of the block
+			if (block.remainingPoints != 0)
+			{
+				leftOverRanges.emplace_back(block.begin, block.begin + block.remainingPoints);
+				remaining += static_cast<unsigned>(block.remainingPoints);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Error("[qRansacSD] Not enough memory!");
+		return nullptr;
+	}
+
+	if (remaining == count)
+	{
+		ccLog::Error("[qRansacSD] Segmentation failed...");
+		return nullptr;
+	}
+
+	if (blocks.size() > 1)
+	{
+		//shapes crossing the block borders have been split
+		size_t shapeCount = shapes.size();
+		if (!MergeShapes(shapes, blocks, ransacOptions.m_epsilon, ransacOptions.m_normalThresh))
+		{
+			ccLog::Warning("[qRansacSD] Not enough memory to merge the shapes across block borders");
+		}
+		else if (shapes.size() != shapeCount)
+		{
+			ccLog::Print(QString("[qRansacSD] %1 shapes merged across block borders").arg(shapeCount - shapes.size()));
+		}
+	}
+
 #if 0 //def _DEBUG
 	FILE* fp = fopen("RANS_SD_trace.txt", "wt");
 
@@ -560,8 +1006,8 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		fprintf(fp, "\n[Shapes]\n");
 		for (unsigned i = 0; i < shapes.size(); ++i)
 		{
-			PrimitiveShape* shape = shapes[i].first;
-			size_t shapePointsCount = shapes[i].second;
+			const PrimitiveShape* shape = shapes[i].shape.first;
+			size_t shapePointsCount = shapes[i].pointCount;
 
 			std::string desc;
 			shape->Description(&desc);
@@ -571,13 +1017,6 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 	fclose(fp);
 #endif
 
-
-	if (remaining == count)
-	{
-		ccLog::Error("[qRansacSD] Segmentation failed...");
-		return nullptr;
-	}
-
 	if (shapes.size() > 0)
 	{
 		unsigned planeCount = 1;
@@ -586,10 +1025,10 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 		unsigned coneCount = 1;
 		unsigned torusCount = 1;
 		ccHObject* group = nullptr;
-		for (MiscLib::Vector<DetectedShape>::const_iterator it = shapes.begin(); it != shapes.end(); ++it)
+		for (const RansacShape& ransacShape : shapes)
 		{
-			const PrimitiveShape* shape = it->first;
-			unsigned shapePointsCount = static_cast<unsigned>(it->second);
+			const PrimitiveShape* shape = ransacShape.shape.first;
+			unsigned shapePointsCount = static_cast<unsigned>(ransacShape.pointCount);
 
 			//too many points?!
 			if (shapePointsCount > count)
@@ -601,15 +1040,30 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 			if (shapePointsCount < params.supportPoints)
 			{
 				ccLog::Warning("[qRansacSD] Skipping shape, did not meet minimum point requirement");
-				count -= shapePointsCount;
 				continue;
 			}
 
 			std::string desc;
 			shape->Description(&desc);
 
-			// points to current shapes last point in cloud
-			const auto shapeCloudIndex = count - 1;
+			// positions of the shape points in the (temporary) cloud
+			std::vector<size_t> shapeIndexes;
+			try
+			{
+				shapeIndexes.reserve(shapePointsCount);
+			}
+			catch (const std::bad_alloc&)
+			{
+				ccLog::Error("[qRansacSD] Not enough memory!");
+				break;
+			}
+			for (const auto& range : ransacShape.ranges)
+			{
+				for (size_t j = range.first; j < range.second; ++j)
+				{
+					shapeIndexes.push_back(j);
+				}
+			}
 
 			//new cloud for sub-part
 			ccPointCloud* pcShape = nullptr;
@@ -626,7 +1080,7 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 
 				for (unsigned j = 0; j < shapePointsCount; ++j)
 				{
-					refPcShape.addPointIndex(cloud[shapeCloudIndex - j].index);
+					refPcShape.addPointIndex(cloud[shapeIndexes[j]].index);
 				}
 				int warnings = 0;
 				pcShape = ccPC->partialClone(&refPcShape, &warnings);
@@ -650,10 +1104,10 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 
 				for (unsigned j = 0; j < shapePointsCount; ++j)
 				{
-					pcShape->addPoint(CCVector3::fromArray(cloud[shapeCloudIndex - j].pos));
+					pcShape->addPoint(CCVector3::fromArray(cloud[shapeIndexes[j]].pos));
 					if (saveNormals)
 					{
-						pcShape->addNorm(CCVector3::fromArray(cloud[shapeCloudIndex - j].normal));
+						pcShape->addNorm(CCVector3::fromArray(cloud[shapeIndexes[j]].normal));
 					}
 
 				}
@@ -690,7 +1144,7 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 				for (unsigned j = 0; j < shapePointsCount; ++j)
 				{
 					std::pair<float, float> param;
-					plane->Parameters(cloud[shapeCloudIndex - j].pos, &param);
+					plane->Parameters(cloud[shapeIndexes[j]].pos, &param);
 					if (j != 0)
 					{
 						if (minX < param.first)
@@ -764,6 +1218,18 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 				float r = cyl->Internal().Radius();
 				float hMin = cyl->MinHeight();
 				float hMax = cyl->MaxHeight();
+				if (ransacShape.ranges.size() > 1)
+				{
+					//merged cylinder: the extents must be computed on all its parts
+					hMin = std::numeric_limits<float>::max();
+					hMax = -std::numeric_limits<float>::max();
+					for (size_t index : shapeIndexes)
+					{
+						float hi = (cloud[index].pos - G).dot(N);
+						hMin = std::min(hMin, hi);
+						hMax = std::max(hMax, hi);
+					}
+				}
 				float h = hMax - hMin;
 				G += N * (hMin + h / 2);
 
@@ -792,20 +1258,20 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 				//compute max height
 				Vec3f minP, maxP;
 				float minHeight, maxHeight;
-				minP = maxP = cloud[shapeCloudIndex].pos;
-				minHeight = maxHeight = cone->Internal().Height(cloud[shapeCloudIndex].pos);
+				minP = maxP = cloud[shapeIndexes[0]].pos;
+				minHeight = maxHeight = cone->Internal().Height(cloud[shapeIndexes[0]].pos);
 				for (size_t j = 1; j < shapePointsCount; ++j)
 				{
-					float h = cone->Internal().Height(cloud[shapeCloudIndex - j].pos);
+					float h = cone->Internal().Height(cloud[shapeIndexes[j]].pos);
 					if (h < minHeight)
 					{
 						minHeight = h;
-						minP = cloud[shapeCloudIndex - j].pos;
+						minP = cloud[shapeIndexes[j]].pos;
 					}
 					else if (h > maxHeight)
 					{
 						maxHeight = h;
-						maxP = cloud[shapeCloudIndex - j].pos;
+						maxP = cloud[shapeIndexes[j]].pos;
 					}
 
 				}
@@ -901,8 +1367,6 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 			}
 
 
-			count -= shapePointsCount;
-
 			QApplication::processEvents();
 		}
 
@@ -929,9 +1393,12 @@ ccHObject* qRansacSD::executeRANSAC(ccPointCloud* ccPC, const RansacParams& para
 					ccLog::Error("[qRansacSD] Not enough memory!");
 				}
 
-				for (unsigned j = 0; j < remaining; ++j)
+				for (const auto& range : leftOverRanges)
 				{
-					refPcLO.addPointIndex(cloud[j].index);
+					for (size_t j = range.first; j < range.second; ++j)
+					{
+						refPcLO.addPointIndex(cloud[j].index);
+					}
 				}
 				int warnings = 0;
 				pcLeftOvers = ccPC->partialClone(&refPcLO, &warnings);
@@ -0,0 +1,1182 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccC2CBatchEngine.h"
+
+//CCCoreLib
+#include <DgmOctree.h>
+#include <GenericProgressCallback.h>
+#include <LocalModel.h>
+#include <Neighbourhood.h>
+#include <ReferenceCloud.h>
+
+//qCC_db
+#include <ccGenericPointCloud.h>
+#include <ccLog.h>
+#include <ccPointCloud.h>
+#include <ccScalarField.h>
+
+//Local
+#include "ccCommon.h"
+
+//Qt
+#include <QByteArray>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+//system
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+//! Number of compared points processed by each job
+static const unsigned s_c2cChunkSize = 4096;
+//! Number of compared points used to measure the error in approximate mode
+static const unsigned s_errorSampleCount = 1000;
+
+//! Data shared by all the distance computation jobs
+struct C2CBatchContext
+{
+	const ccGenericPointCloud* refCloud = nullptr;
+	const CCCoreLib::DgmOctree* octree = nullptr;
+	const ccC2CBatchEngine::Parameters* params = nullptr;
+	unsigned char level = 0;
+	unsigned char modelLevel = 0;
+	CCCoreLib::NormalizedProgress* nProgress = nullptr;
+	std::atomic<bool> cancelled { false };
+	std::atomic<bool> memoryError { false };
+};
+
+//! Output scalar fields of a compared cloud
+struct C2CBatchTarget
+{
+	ccPointCloud* cloud = nullptr;
+	ccScalarField* distances = nullptr;
+	ccScalarField* split[3] = { nullptr, nullptr, nullptr };
+};
+
+//! Distance computation job (range of points of a given compared cloud)
+struct C2CBatchJob
+{
+	C2CBatchContext* context = nullptr;
+	C2CBatchTarget* target = nullptr;
+	unsigned begin = 0;
+	unsigned end = 0;
+	//! Point indexes (optional: if set, 'begin' and 'end' are positions in this list)
+	const unsigned* indexes = nullptr;
+
+	//partial statistics
+	unsigned validCount = 0;
+	double sum = 0.0;
+	double sum2 = 0.0;
+	double minDist = std::numeric_limits<double>::max();
+	double maxDist = 0.0;
+};
+
+//! Prepares a neighborhood search structure for a given query point
+/** The already extracted neighborhood is kept if the point lies in the same cell as the previous one.
+**/
+static void PrepareSearch(	const CCCoreLib::DgmOctree& octree,
+							CCCoreLib::DgmOctree::NearestNeighboursSearchStruct& nNSS,
+							const CCVector3& P,
+							bool& hasCell)
+{
+	nNSS.queryPoint = P;
+
+	Tuple3i cellPos;
+	octree.getTheCellPosWhichIncludesThePoint(&P, cellPos, nNSS.level);
+	if (!hasCell || cellPos.x != nNSS.cellPos.x || cellPos.y != nNSS.cellPos.y || cellPos.z != nNSS.cellPos.z)
+	{
+		nNSS.cellPos = cellPos;
+		octree.computeCellCenter(nNSS.cellPos, nNSS.level, nNSS.cellCenter);
+		nNSS.pointsInNeighbourhood.clear();
+		nNSS.alreadyVisitedNeighbourhoodSize = 0;
+		hasCell = true;
+	}
+}
+
+static void ComputeC2CDistances(C2CBatchJob& job)
+{
+	C2CBatchContext& context = *job.context;
+	if (context.cancelled || context.memoryError)
+	{
+		return;
+	}
+
+	const ccC2CBatchEngine::Parameters& params = *context.params;
+	const CCCoreLib::DgmOctree& octree = *context.octree;
+	ccPointCloud* cloud = job.target->cloud;
+
+	const double maxSearchDist = params.maxSearchDist;
+	const bool useLocalModel = (params.localModel != CCCoreLib::NO_MODEL);
+
+	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
+	nNSS.level = context.level;
+	nNSS.minNumberOfNeighbors = 1;
+	bool hasCell = false;
+
+	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSSModel;
+	nNSSModel.level = context.modelLevel;
+	nNSSModel.minNumberOfNeighbors = params.kNNForLocalModel;
+	bool hasModelCell = false;
+
+	try
+	{
+		CCCoreLib::ReferenceCloud neighbours(const_cast<ccGenericPointCloud*>(context.refCloud));
+
+		for (unsigned k = job.begin; k < job.end; ++k)
+		{
+			const unsigned i = (job.indexes ? job.indexes[k] : k);
+			const CCVector3* P = cloud->getPoint(i);
+
+			PrepareSearch(octree, nNSS, *P, hasCell);
+			if (octree.findNearestNeighborsStartingFromCell(nNSS, false) == 0)
+			{
+				job.target->distances->setValue(i, CCCoreLib::NAN_VALUE);
+				for (ccScalarField* sf : job.target->split)
+				{
+					if (sf)
+						sf->setValue(i, CCCoreLib::NAN_VALUE);
+				}
+				continue;
+			}
+
+			const CCCoreLib::DgmOctree::PointDescriptor& nearest = nNSS.pointsInNeighbourhood.front();
+			const CCVector3 nearestPoint = *nearest.point;
+			double dist = sqrt(nearest.squareDistd);
+
+			//local model (built around the nearest reference point)
+			if (useLocalModel && dist > 0)
+			{
+				PrepareSearch(octree, nNSSModel, nearestPoint, hasModelCell);
+
+				unsigned neighborCount = 0;
+				if (params.useSphericalSearchForLocalModel)
+				{
+					neighborCount = octree.findNeighborsInASphereStartingFromCell(nNSSModel, params.radiusForLocalModel, false);
+				}
+				else
+				{
+					neighborCount = octree.findNearestNeighborsStartingFromCell(nNSSModel, false);
+					neighborCount = std::min(neighborCount, params.kNNForLocalModel);
+				}
+
+				if (neighborCount >= CCCoreLib::CC_LOCAL_MODEL_MIN_SIZE[params.localModel])
+				{
+					neighbours.clear();
+					PointCoordinateType maxSquareDist = 0;
+					for (unsigned k = 0; k < neighborCount; ++k)
+					{
+						const CCCoreLib::DgmOctree::PointDescriptor& Q = nNSSModel.pointsInNeighbourhood[k];
+						neighbours.addPointIndex(Q.pointIndex);
+						maxSquareDist = std::max(maxSquareDist, static_cast<PointCoordinateType>(Q.squareDistd));
+					}
+
+					CCCoreLib::Neighbourhood Z(&neighbours);
+					CCCoreLib::LocalModel* lm = CCCoreLib::LocalModel::New(params.localModel, Z, nearestPoint, maxSquareDist);
+					if (lm)
+					{
+						double distToModel = lm->computeDistanceFromModelToPoint(P);
+						if (distToModel < dist)
+						{
+							dist = distToModel;
+						}
+						delete lm;
+					}
+				}
+			}
+
+			if (maxSearchDist > 0 && dist > maxSearchDist)
+			{
+				dist = maxSearchDist;
+			}
+
+			job.target->distances->setValue(i, static_cast<ScalarType>(dist));
+			if (job.target->split[0])
+			{
+				CCVector3 D = *P - nearestPoint;
+				for (unsigned d = 0; d < 3; ++d)
+				{
+					job.target->split[d]->setValue(i, static_cast<ScalarType>(D.u[d]));
+				}
+			}
+
+			++job.validCount;
+			job.sum += dist;
+			job.sum2 += dist * dist;
+			job.minDist = std::min(job.minDist, dist);
+			job.maxDist = std::max(job.maxDist, dist);
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		context.memoryError = true;
+		return;
+	}
+
+	if (context.nProgress && !context.nProgress->oneStep())
+	{
+		context.cancelled = true;
+	}
+}
+
+ccC2CBatchEngine::ccC2CBatchEngine()
+	: m_refCloud(nullptr)
+	, m_octreeLevel(0)
+	, m_modelOctreeLevel(0)
+	, m_approxOctreeLevel(0)
+{}
+
+unsigned ccC2CBatchEngine::getApproxReferenceSize() const
+{
+	return (m_approxCloud ? m_approxCloud->size() : 0);
+}
+
+bool ccC2CBatchEngine::prepareApproximateReference(CCCoreLib::GenericProgressCallback* progressCb)
+{
+	assert(m_refCloud && m_refOctree);
+
+	//we look for the coarsest level where any point of a cell can replace the others (i.e. the cells diagonal is below the max error)
+	unsigned char level = 0;
+	for (unsigned char l = 1; l <= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL; ++l)
+	{
+		if (m_refOctree->getCellSize(l) * sqrt(3.0) <= m_params.approxMaxError)
+		{
+			level = l;
+			break;
+		}
+	}
+	if (level == 0)
+	{
+		ccLog::Warning("[C2C] Max error is too small for the approximate mode: exact distances will be computed");
+		return true;
+	}
+
+	QSharedPointer<CCCoreLib::ReferenceCloud> approxCloud(new CCCoreLib::ReferenceCloud(m_refCloud));
+	if (!approxCloud->reserve(m_refOctree->getCellNumber(level)))
+	{
+		ccLog::Warning("[C2C] Not enough memory");
+		return false;
+	}
+
+	//the points are sorted by cell code: we keep the first point of each cell
+	const unsigned char bitShift = CCCoreLib::DgmOctree::GET_BIT_SHIFT(level);
+	const CCCoreLib::DgmOctree::cellsContainer& codes = m_refOctree->pointsAndTheirCellCodes();
+	CCCoreLib::DgmOctree::CellCode previousCode = 0;
+	for (size_t i = 0; i < codes.size(); ++i)
+	{
+		CCCoreLib::DgmOctree::CellCode code = (codes[i].theCode >> bitShift);
+		if (i == 0 || code != previousCode)
+		{
+			approxCloud->addPointIndex(codes[i].theIndex);
+			previousCode = code;
+		}
+	}
+
+	if (approxCloud->size() > m_refCloud->size() * 0.9)
+	{
+		ccLog::Warning("[C2C] Max error is too small for the approximate mode to be efficient: exact distances will be computed");
+		return true;
+	}
+
+	QSharedPointer<CCCoreLib::DgmOctree> approxOctree(new CCCoreLib::DgmOctree(approxCloud.data()));
+	if (approxOctree->build(progressCb) <= 0)
+	{
+		ccLog::Warning("[C2C] Failed to compute the octree of the decimated reference (not enough memory?)");
+		return false;
+	}
+
+	m_approxCloud = approxCloud;
+	m_approxOctree = approxOctree;
+	m_approxOctreeLevel = approxOctree->findBestLevelForAGivenPopulationPerCell(3);
+
+	ccLog::Print(QString("[C2C] Approximate mode: %1 reference points kept out of %2 (octree level %3)").arg(approxCloud->size()).arg(m_refCloud->size()).arg(level));
+	return true;
+}
+
+void ccC2CBatchEngine::measureApproximationError(const ccPointCloud* compared, const ccScalarField* distances, Statistics& stats) const
+{
+	assert(m_refOctree && compared && distances);
+
+	stats.errorSampleCount = 0;
+	stats.meanError = stats.maxError = 0.0;
+
+	ccPointCloud* cloud = const_cast<ccPointCloud*>(compared);
+	unsigned step = std::max(1u, cloud->size() / s_errorSampleCount);
+
+	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
+	nNSS.level = m_octreeLevel;
+	nNSS.minNumberOfNeighbors = 1;
+	bool hasCell = false;
+
+	double sumError = 0.0;
+	for (unsigned i = 0; i < cloud->size(); i += step)
+	{
+		ScalarType approxDist = distances->getValue(i);
+		if (!CCCoreLib::ScalarField::ValidValue(approxDist))
+		{
+			continue;
+		}
+
+		PrepareSearch(*m_refOctree, nNSS, *cloud->getPoint(i), hasCell);
+		if (m_refOctree->findNearestNeighborsStartingFromCell(nNSS, false) == 0)
+		{
+			continue;
+		}
+		double dist = sqrt(nNSS.pointsInNeighbourhood.front().squareDistd);
+		if (m_params.maxSearchDist > 0 && dist > m_params.maxSearchDist)
+		{
+			dist = m_params.maxSearchDist;
+		}
+
+		double error = std::abs(approxDist - dist);
+		sumError += error;
+		stats.maxError = std::max(stats.maxError, error);
+		++stats.errorSampleCount;
+	}
+
+	if (stats.errorSampleCount != 0)
+	{
+		stats.meanError = sumError / stats.errorSampleCount;
+	}
+}
+
+//! Runs the distance computation jobs
+/** \return false if the process failed or has been cancelled
+**/
+static bool RunC2CJobs(std::vector<C2CBatchJob>& jobs, C2CBatchContext& context, int maxThreadCount)
+{
+	if (maxThreadCount <= 0 || maxThreadCount > QThread::idealThreadCount())
+	{
+		maxThreadCount = QThread::idealThreadCount();
+	}
+	maxThreadCount = std::min(maxThreadCount, static_cast<int>(jobs.size()));
+
+	//each worker processes the jobs one after the other (local pool, so as to not change the global one)
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(std::max(1, maxThreadCount));
+	std::atomic<size_t> nextJob(0);
+	std::vector< QFuture<void> > workers;
+	workers.reserve(maxThreadCount);
+	for (int w = 0; w < maxThreadCount; ++w)
+	{
+		workers.push_back(QtConcurrent::run(&threadPool, [&nextJob, &jobs]()
+		{
+			for (size_t j = nextJob++; j < jobs.size(); j = nextJob++)
+			{
+				ComputeC2CDistances(jobs[j]);
+			}
+		}));
+	}
+	for (QFuture<void>& worker : workers)
+	{
+		worker.waitForFinished();
+	}
+
+	if (context.memoryError)
+	{
+		ccLog::Warning("[C2C] Not enough memory");
+		return false;
+	}
+	if (context.cancelled)
+	{
+		ccLog::Warning("[C2C] Process cancelled by the user");
+		return false;
+	}
+	return true;
+}
+
+bool ccC2CBatchEngine::setReference(ccGenericPointCloud* reference,
+									const Parameters& params,
+									CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/,
+									ccOctree::Shared octree/*=ccOctree::Shared()*/)
+{
+	m_refCloud = nullptr;
+	m_refOctree.clear();
+	m_approxCloud.clear();
+	m_approxOctree.clear();
+
+	if (!reference || reference->size() == 0)
+	{
+		ccLog::Warning("[C2C] Invalid or empty reference cloud");
+		return false;
+	}
+
+	if (params.localModel != CCCoreLib::NO_MODEL)
+	{
+		if (	( params.useSphericalSearchForLocalModel && params.radiusForLocalModel <= 0)
+			||	(!params.useSphericalSearchForLocalModel && params.kNNForLocalModel < CCCoreLib::CC_LOCAL_MODEL_MIN_SIZE[params.localModel]))
+		{
+			ccLog::Warning("[C2C] Invalid local model neighborhood size");
+			return false;
+		}
+	}
+
+	if (!octree || octree->getNumberOfProjectedPoints() == 0)
+	{
+		octree = reference->getOctree();
+	}
+	if (!octree)
+	{
+		octree = reference->computeOctree(progressCb);
+		if (!octree)
+		{
+			ccLog::Warning("[C2C] Failed to compute the reference octree (not enough memory?)");
+			return false;
+		}
+	}
+
+	m_refCloud = reference;
+	m_refOctree = octree;
+	m_params = params;
+	m_octreeLevel = (params.octreeLevel != 0 ? params.octreeLevel : octree->findBestLevelForAGivenPopulationPerCell(3));
+	m_modelOctreeLevel = m_octreeLevel;
+	if (params.localModel != CCCoreLib::NO_MODEL)
+	{
+		m_modelOctreeLevel = params.useSphericalSearchForLocalModel
+							? octree->findBestLevelForAGivenNeighbourhoodSizeExtraction(static_cast<PointCoordinateType>(params.radiusForLocalModel))
+							: octree->findBestLevelForAGivenPopulationPerCell(params.kNNForLocalModel);
+	}
+
+	if (params.approxMaxError > 0)
+	{
+		if (params.localModel != CCCoreLib::NO_MODEL)
+		{
+			ccLog::Warning("[C2C] Local models are not supported in approximate mode (ignored)");
+			m_params.localModel = CCCoreLib::NO_MODEL;
+		}
+		if (!prepareApproximateReference(progressCb))
+		{
+			m_refCloud = nullptr;
+			m_refOctree.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+QString ccC2CBatchEngine::GetDefaultSFName(const Parameters& params)
+{
+	QString sfName(CC_CLOUD2CLOUD_DISTANCES_DEFAULT_SF_NAME);
+
+	if (params.localModel != CCCoreLib::NO_MODEL)
+	{
+		//same names as in the comparison dialog
+		static const char* s_modelNames[] = { "NONE", "Least Square Plane", "2D1/2 Triangulation", "Quadric" };
+		sfName += QString("[%1]").arg(s_modelNames[params.localModel]);
+		if (params.useSphericalSearchForLocalModel)
+			sfName += QString("[r=%1]").arg(params.radiusForLocalModel);
+		else
+			sfName += QString("[k=%1]").arg(params.kNNForLocalModel);
+	}
+
+	if (params.maxSearchDist > 0)
+	{
+		sfName += QString("[<%1]").arg(params.maxSearchDist);
+	}
+
+	if (params.approxMaxError > 0)
+	{
+		sfName += QString("[~%1]").arg(params.approxMaxError);
+	}
+
+	return sfName;
+}
+
+//! Creates (or overwrites) a scalar field on a cloud
+static ccScalarField* PrepareScalarField(ccPointCloud* cloud, const QString& name)
+{
+	int sfIdx = cloud->getScalarFieldIndexByName(qPrintable(name));
+	if (sfIdx < 0)
+	{
+		sfIdx = cloud->addScalarField(qPrintable(name));
+		if (sfIdx < 0)
+		{
+			return nullptr;
+		}
+	}
+	return static_cast<ccScalarField*>(cloud->getScalarField(sfIdx));
+}
+
+bool ccC2CBatchEngine::computeDistances(const std::vector<ccPointCloud*>& comparedClouds,
+										std::vector<Statistics>& stats,
+										QString sfName/*=QString()*/,
+										QString splitBaseName/*=QString()*/,
+										int maxThreadCount/*=0*/,
+										CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/) const
+{
+	if (!m_refCloud || !m_refOctree)
+	{
+		ccLog::Warning("[C2C] No reference cloud set");
+		assert(false);
+		return false;
+	}
+
+	if (sfName.isEmpty())
+	{
+		sfName = getDefaultSFName();
+	}
+	if (splitBaseName.isEmpty())
+	{
+		splitBaseName = sfName;
+	}
+
+	std::vector<C2CBatchTarget> targets;
+	std::vector<C2CBatchJob> jobs;
+	C2CBatchContext context;
+	try
+	{
+		stats.clear();
+		stats.resize(comparedClouds.size());
+		targets.resize(comparedClouds.size());
+
+		for (size_t c = 0; c < comparedClouds.size(); ++c)
+		{
+			ccPointCloud* cloud = comparedClouds[c];
+			stats[c].pointCount = (cloud ? cloud->size() : 0);
+			if (!cloud || cloud->size() == 0 || cloud == m_refCloud)
+			{
+				ccLog::Warning(QString("[C2C] Invalid or empty compared cloud (#%1)").arg(c + 1));
+				continue;
+			}
+
+			C2CBatchTarget& target = targets[c];
+			target.distances = PrepareScalarField(cloud, sfName);
+			if (!target.distances)
+			{
+				ccLog::Warning(QString("[C2C] Not enough memory to process cloud '%1'").arg(cloud->getName()));
+				continue;
+			}
+			if (m_params.splitXYZ)
+			{
+				static const QChar s_dimChars[3] = { 'X', 'Y', 'Z' };
+				for (unsigned d = 0; d < 3; ++d)
+				{
+					target.split[d] = PrepareScalarField(cloud, splitBaseName + QString(" (%1)").arg(s_dimChars[d]));
+					if (!target.split[d])
+					{
+						ccLog::Warning(QString("[C2C] Not enough memory to generate the split fields on cloud '%1'").arg(cloud->getName()));
+						target.split[0] = target.split[1] = target.split[2] = nullptr;
+						break;
+					}
+				}
+			}
+			target.cloud = cloud;
+
+			//the jobs of all the clouds are mixed so that the clouds are processed concurrently
+			for (unsigned begin = 0; begin < cloud->size(); begin += s_c2cChunkSize)
+			{
+				C2CBatchJob job;
+				job.context = &context;
+				job.target = &target;
+				job.begin = begin;
+				job.end = std::min(begin + s_c2cChunkSize, cloud->size());
+				jobs.push_back(job);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[C2C] Not enough memory");
+		return false;
+	}
+
+	if (jobs.empty())
+	{
+		return false;
+	}
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("Cloud-to-cloud distances");
+			progressCb->setInfo(qPrintable(QString("Reference: %1\nCompared clouds: %2").arg(m_refCloud->getName()).arg(comparedClouds.size())));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+	CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(jobs.size()));
+
+	context.refCloud = m_refCloud;
+	context.octree = (m_approxOctree ? m_approxOctree.data() : m_refOctree.data());
+	context.params = &m_params;
+	context.level = (m_approxOctree ? m_approxOctreeLevel : m_octreeLevel);
+	context.modelLevel = m_modelOctreeLevel;
+	context.nProgress = (progressCb ? &nProgress : nullptr);
+
+	bool success = RunC2CJobs(jobs, context, maxThreadCount);
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	if (!success)
+	{
+		return false;
+	}
+
+	//reduce the statistics
+	std::vector<C2CBatchJob> totals(targets.size());
+	for (const C2CBatchJob& job : jobs)
+	{
+		C2CBatchJob& total = totals[job.target - targets.data()];
+		total.validCount += job.validCount;
+		total.sum += job.sum;
+		total.sum2 += job.sum2;
+		total.minDist = std::min(total.minDist, job.minDist);
+		total.maxDist = std::max(total.maxDist, job.maxDist);
+	}
+
+	bool atLeastOneSuccess = false;
+	for (size_t c = 0; c < targets.size(); ++c)
+	{
+		C2CBatchTarget& target = targets[c];
+		if (!target.cloud)
+		{
+			continue;
+		}
+
+		const C2CBatchJob& total = totals[c];
+		Statistics& s = stats[c];
+		s.success = true;
+		s.validCount = total.validCount;
+		if (total.validCount != 0)
+		{
+			s.minDist = total.minDist;
+			s.maxDist = total.maxDist;
+			s.mean = total.sum / total.validCount;
+			s.stdDev = sqrt(std::max(0.0, total.sum2 / total.validCount - s.mean * s.mean));
+			s.rms = sqrt(total.sum2 / total.validCount);
+		}
+		atLeastOneSuccess = true;
+
+		//the min and max values are already known
+		target.distances->setMinAndMax(static_cast<ScalarType>(s.minDist), static_cast<ScalarType>(s.maxDist));
+		if (m_approxOctree)
+		{
+			measureApproximationError(target.cloud, target.distances, s);
+		}
+		for (ccScalarField* sf : target.split)
+		{
+			if (sf)
+				sf->computeMinAndMax();
+		}
+	}
+
+	return atLeastOneSuccess;
+}
+
+//! Hashes a point (the hash of a cell is the sum of the hashes of its points, so that it doesn't depend on the points order)
+static inline uint64_t HashPoint(const CCVector3& P)
+{
+	uint64_t h = 0x9E3779B97F4A7C15ULL;
+	for (unsigned d = 0; d < 3; ++d)
+	{
+		PointCoordinateType c = P.u[d];
+		uint64_t bits = 0;
+		memcpy(&bits, &c, sizeof(PointCoordinateType));
+
+		//splitmix64
+		h ^= bits + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+		h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+		h ^= (h >> 31);
+	}
+	return h;
+}
+
+//! Returns the (clamped) grid index of a coordinate
+static inline int GridIndex(double x, double origin, double cellSize, int gridSize)
+{
+	double f = (x - origin) / cellSize;
+	if (!(f >= 0)) //also handles NaN
+		return 0;
+	if (f >= gridSize)
+		return gridSize - 1;
+	return static_cast<int>(f);
+}
+
+//! Reference hashing job (range of points)
+struct C2CHashJob
+{
+	const ccGenericPointCloud* cloud = nullptr;
+	const ccC2CBatchEngine::Dependency* dependency = nullptr;
+	unsigned begin = 0;
+	unsigned end = 0;
+	std::vector<uint64_t> cellHashes;
+	bool memoryError = false;
+};
+
+static void HashReferencePoints(C2CHashJob& job)
+{
+	const ccC2CBatchEngine::Dependency& dep = *job.dependency;
+	const int G = static_cast<int>(dep.gridSize);
+	try
+	{
+		job.cellHashes.resize(static_cast<size_t>(G) * G * G, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		job.memoryError = true;
+		return;
+	}
+
+	ccGenericPointCloud* cloud = const_cast<ccGenericPointCloud*>(job.cloud);
+	for (unsigned i = job.begin; i < job.end; ++i)
+	{
+		const CCVector3* P = cloud->getPoint(i);
+		int x = GridIndex(P->x, dep.gridOrigin.x, dep.cellSize, G);
+		int y = GridIndex(P->y, dep.gridOrigin.y, dep.cellSize, G);
+		int z = GridIndex(P->z, dep.gridOrigin.z, dep.cellSize, G);
+		job.cellHashes[(static_cast<size_t>(z) * G + y) * G + x] += HashPoint(*P);
+	}
+}
+
+bool ccC2CBatchEngine::ComputeDependency(	const ccGenericPointCloud* reference,
+											const ccPointCloud* compared,
+											double maxSearchDist,
+											Dependency& dependency,
+											const Dependency* gridDefinition/*=nullptr*/)
+{
+	if (!reference || !compared || reference->size() == 0)
+	{
+		return false;
+	}
+
+	dependency.referenceID = reference->getUniqueID();
+	dependency.maxSearchDist = maxSearchDist;
+	dependency.comparedTransformation = compared->getGLTransformationHistory();
+
+	if (gridDefinition && gridDefinition->gridSize != 0)
+	{
+		dependency.gridOrigin = gridDefinition->gridOrigin;
+		dependency.cellSize = gridDefinition->cellSize;
+		dependency.gridSize = gridDefinition->gridSize;
+	}
+	else
+	{
+		//the grid covers both clouds (the points outside are projected in the border cells)
+		ccGenericPointCloud* ref = const_cast<ccGenericPointCloud*>(reference);
+		ccPointCloud* comp = const_cast<ccPointCloud*>(compared);
+		CCVector3 refMin;
+		CCVector3 refMax;
+		CCVector3 compMin;
+		CCVector3 compMax;
+		ref->getBoundingBox(refMin, refMax);
+		comp->getBoundingBox(compMin, compMax);
+
+		CCVector3d bbMin;
+		double maxDim = 0.0;
+		for (unsigned d = 0; d < 3; ++d)
+		{
+			bbMin.u[d] = std::min(refMin.u[d], compMin.u[d]);
+			maxDim = std::max(maxDim, std::max(refMax.u[d], compMax.u[d]) - bbMin.u[d]);
+		}
+
+		//~64 reference points per cell (on average)
+		double gridSize = std::cbrt(reference->size() / 64.0);
+		dependency.gridSize = static_cast<unsigned>(std::max(8.0, std::min(64.0, gridSize)));
+		dependency.cellSize = std::max(maxDim, 1.0e-6) * 1.001 / dependency.gridSize;
+		dependency.gridOrigin = bbMin - CCVector3d(1, 1, 1) * (maxDim * 0.0005);
+	}
+
+	//one job per thread
+	unsigned jobCount = static_cast<unsigned>(std::max(1, QThread::idealThreadCount()));
+	unsigned chunkSize = (reference->size() + jobCount - 1) / jobCount;
+	std::vector<C2CHashJob> jobs;
+	try
+	{
+		for (unsigned begin = 0; begin < reference->size(); begin += chunkSize)
+		{
+			C2CHashJob job;
+			job.cloud = reference;
+			job.dependency = &dependency;
+			job.begin = begin;
+			job.end = std::min(begin + chunkSize, reference->size());
+			jobs.push_back(job);
+		}
+		dependency.cellHashes.clear();
+		dependency.cellHashes.resize(static_cast<size_t>(dependency.gridSize) * dependency.gridSize * dependency.gridSize, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[C2C] Not enough memory");
+		return false;
+	}
+
+	QtConcurrent::blockingMap(jobs, HashReferencePoints);
+
+	for (const C2CHashJob& job : jobs)
+	{
+		if (job.memoryError)
+		{
+			ccLog::Warning("[C2C] Not enough memory");
+			dependency.cellHashes.clear();
+			return false;
+		}
+		for (size_t c = 0; c < job.cellHashes.size(); ++c)
+		{
+			dependency.cellHashes[c] += job.cellHashes[c];
+		}
+	}
+
+	return true;
+}
+
+//! Returns whether two transformations are strictly identical
+static bool SameTransformation(const ccGLMatrix& A, const ccGLMatrix& B)
+{
+	return memcmp(A.data(), B.data(), 16 * sizeof(float)) == 0;
+}
+
+bool ccC2CBatchEngine::updateDistances(	ccPointCloud* compared,
+										ccScalarField* distances,
+										const Dependency& previous,
+										Dependency& current,
+										unsigned& recomputedCount,
+										double maxRatio/*=0.5*/,
+										int maxThreadCount/*=0*/,
+										CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/) const
+{
+	recomputedCount = 0;
+
+	if (!m_refCloud || !m_refOctree || !compared || !distances)
+	{
+		assert(false);
+		return false;
+	}
+
+	//the previous distances can only be reused in some cases
+	const unsigned G = previous.gridSize;
+	if (	m_params.localModel != CCCoreLib::NO_MODEL
+		||	m_params.splitXYZ
+		||	m_approxOctree
+		||	previous.referenceID != m_refCloud->getUniqueID()
+		||	previous.maxSearchDist != m_params.maxSearchDist
+		||	G == 0
+		||	previous.cellHashes.size() != static_cast<size_t>(G) * G * G
+		||	distances->size() != compared->size()
+		||	!SameTransformation(previous.comparedTransformation, compared->getGLTransformationHistory()))
+	{
+		return false;
+	}
+
+	if (!ComputeDependency(m_refCloud, compared, m_params.maxSearchDist, current, &previous))
+	{
+		return false;
+	}
+
+	//summed-area table of the modified cells (to count them in any box quickly)
+	const size_t S = G + 1;
+	std::vector<unsigned> changedSAT;
+	std::vector<unsigned> indexes;
+	try
+	{
+		changedSAT.resize(S * S * S, 0);
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[C2C] Not enough memory");
+		return false;
+	}
+
+	unsigned changedCellCount = 0;
+	for (unsigned z = 0; z < G; ++z)
+	{
+		for (unsigned y = 0; y < G; ++y)
+		{
+			for (unsigned x = 0; x < G; ++x)
+			{
+				size_t c = (static_cast<size_t>(z) * G + y) * G + x;
+				unsigned changed = (previous.cellHashes[c] != current.cellHashes[c] ? 1 : 0);
+				changedCellCount += changed;
+
+				changedSAT[((z + 1) * S + (y + 1)) * S + (x + 1)] = changed
+					+ changedSAT[((z    ) * S + (y + 1)) * S + (x + 1)]
+					+ changedSAT[((z + 1) * S + (y    )) * S + (x + 1)]
+					+ changedSAT[((z + 1) * S + (y + 1)) * S + (x    )]
+					- changedSAT[((z    ) * S + (y    )) * S + (x + 1)]
+					- changedSAT[((z    ) * S + (y + 1)) * S + (x    )]
+					- changedSAT[((z + 1) * S + (y    )) * S + (x    )]
+					+ changedSAT[((z    ) * S + (y    )) * S + (x    )];
+			}
+		}
+	}
+
+	//number of modified cells in the box [x0,x1]x[y0,y1]x[z0,z1] (inclusive)
+	auto countChanged = [&](int x0, int y0, int z0, int x1, int y1, int z1) -> unsigned
+	{
+		++x1; ++y1; ++z1;
+		return	  changedSAT[(z1 * S + y1) * S + x1]
+				- changedSAT[(z0 * S + y1) * S + x1]
+				- changedSAT[(z1 * S + y0) * S + x1]
+				- changedSAT[(z1 * S + y1) * S + x0]
+				+ changedSAT[(z0 * S + y0) * S + x1]
+				+ changedSAT[(z0 * S + y1) * S + x0]
+				+ changedSAT[(z1 * S + y0) * S + x0]
+				- changedSAT[(z0 * S + y0) * S + x0];
+	};
+
+	//we look for the points whose nearest neighbor may have changed (i.e. the points
+	//for which a modified cell intersects the bounding box of the sphere of radius
+	//equal to their previous distance)
+	const unsigned pointCount = compared->size();
+	const unsigned maxCount = static_cast<unsigned>(maxRatio * pointCount);
+	const int iG = static_cast<int>(G);
+	try
+	{
+		for (unsigned i = 0; i < pointCount; ++i)
+		{
+			ScalarType d = distances->getValue(i);
+			bool affected = !CCCoreLib::ScalarField::ValidValue(d);
+			if (!affected && changedCellCount != 0)
+			{
+				const CCVector3* P = compared->getPoint(i);
+				//small margin for the rounding errors
+				double r = static_cast<double>(d) * (1.0 + 1.0e-5) + previous.cellSize * 1.0e-6;
+				int x0 = GridIndex(P->x - r, previous.gridOrigin.x, previous.cellSize, iG);
+				int y0 = GridIndex(P->y - r, previous.gridOrigin.y, previous.cellSize, iG);
+				int z0 = GridIndex(P->z - r, previous.gridOrigin.z, previous.cellSize, iG);
+				int x1 = GridIndex(P->x + r, previous.gridOrigin.x, previous.cellSize, iG);
+				int y1 = GridIndex(P->y + r, previous.gridOrigin.y, previous.cellSize, iG);
+				int z1 = GridIndex(P->z + r, previous.gridOrigin.z, previous.cellSize, iG);
+				affected = (countChanged(x0, y0, z0, x1, y1, z1) != 0);
+			}
+
+			if (affected)
+			{
+				if (indexes.size() >= maxCount)
+				{
+					//not worth it
+					return false;
+				}
+				indexes.push_back(i);
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		ccLog::Warning("[C2C] Not enough memory");
+		return false;
+	}
+
+	if (!indexes.empty())
+	{
+		C2CBatchContext context;
+		C2CBatchTarget target;
+		target.cloud = compared;
+		target.distances = distances;
+
+		std::vector<C2CBatchJob> jobs;
+		try
+		{
+			for (unsigned begin = 0; begin < indexes.size(); begin += s_c2cChunkSize)
+			{
+				C2CBatchJob job;
+				job.context = &context;
+				job.target = &target;
+				job.indexes = indexes.data();
+				job.begin = begin;
+				job.end = std::min(begin + s_c2cChunkSize, static_cast<unsigned>(indexes.size()));
+				jobs.push_back(job);
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[C2C] Not enough memory");
+			return false;
+		}
+
+		if (progressCb)
+		{
+			if (progressCb->textCanBeEdited())
+			{
+				progressCb->setMethodTitle("Cloud-to-cloud distances (update)");
+				progressCb->setInfo(qPrintable(QString("Points to update: %1 / %2").arg(indexes.size()).arg(pointCount)));
+			}
+			progressCb->update(0);
+			progressCb->start();
+		}
+		CCCoreLib::NormalizedProgress nProgress(progressCb, static_cast<unsigned>(jobs.size()));
+
+		context.refCloud = m_refCloud;
+		context.octree = m_refOctree.data();
+		context.params = &m_params;
+		context.level = m_octreeLevel;
+		context.modelLevel = m_modelOctreeLevel;
+		context.nProgress = (progressCb ? &nProgress : nullptr);
+
+		bool success = RunC2CJobs(jobs, context, maxThreadCount);
+
+		if (progressCb)
+		{
+			progressCb->stop();
+		}
+
+		if (!success)
+		{
+			//the distances are now partially updated
+			return false;
+		}
+	}
+
+	distances->computeMinAndMax();
+	recomputedCount = static_cast<unsigned>(indexes.size());
+
+	return true;
+}
+
+//! Returns the meta-data key of the dependency of a given scalar field
+static QString DependencyKey(const QString& sfName)
+{
+	return QString("C2C dependency: %1").arg(sfName);
+}
+
+void ccC2CBatchEngine::SetDependency(ccPointCloud* compared, const QString& sfName, const Dependency& dependency)
+{
+	if (!compared)
+	{
+		assert(false);
+		return;
+	}
+
+	QVariantMap map;
+	map["refID"] = dependency.referenceID;
+	map["maxDist"] = dependency.maxSearchDist;
+	map["ox"] = dependency.gridOrigin.x;
+	map["oy"] = dependency.gridOrigin.y;
+	map["oz"] = dependency.gridOrigin.z;
+	map["cellSize"] = dependency.cellSize;
+	map["gridSize"] = dependency.gridSize;
+	map["hashes"] = QByteArray(reinterpret_cast<const char*>(dependency.cellHashes.data()), static_cast<int>(dependency.cellHashes.size() * sizeof(uint64_t)));
+	map["compTrans"] = QByteArray(reinterpret_cast<const char*>(dependency.comparedTransformation.data()), static_cast<int>(16 * sizeof(float)));
+
+	compared->setMetaData(DependencyKey(sfName), map);
+}
+
+bool ccC2CBatchEngine::GetDependency(const ccPointCloud* compared, const QString& sfName, Dependency& dependency)
+{
+	if (!compared)
+	{
+		assert(false);
+		return false;
+	}
+
+	QVariant value = compared->getMetaData(DependencyKey(sfName));
+	if (!value.isValid())
+	{
+		return false;
+	}
+
+	QVariantMap map = value.toMap();
+	QByteArray hashes = map.value("hashes").toByteArray();
+	QByteArray compTrans = map.value("compTrans").toByteArray();
+	unsigned gridSize = map.value("gridSize").toUInt();
+	size_t cellCount = static_cast<size_t>(gridSize) * gridSize * gridSize;
+	if (	gridSize == 0
+		||	static_cast<size_t>(hashes.size()) != cellCount * sizeof(uint64_t)
+		||	compTrans.size() != static_cast<int>(16 * sizeof(float)))
+	{
+		ccLog::Warning(QString("[C2C] Invalid dependency information for scalar field '%1'").arg(sfName));
+		return false;
+	}
+
+	try
+	{
+		dependency.cellHashes.resize(cellCount);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return false;
+	}
+	memcpy(dependency.cellHashes.data(), hashes.constData(), hashes.size());
+	memcpy(dependency.comparedTransformation.data(), compTrans.constData(), compTrans.size());
+	dependency.referenceID = map.value("refID").toUInt();
+	dependency.maxSearchDist = map.value("maxDist").toDouble();
+	dependency.gridOrigin = CCVector3d(map.value("ox").toDouble(), map.value("oy").toDouble(), map.value("oz").toDouble());
+	dependency.cellSize = map.value("cellSize").toDouble();
+	dependency.gridSize = gridSize;
+
+	return true;
+}
+
+void ccC2CBatchEngine::RemoveDependency(ccPointCloud* compared, const QString& sfName)
+{
+	if (compared)
+	{
+		compared->removeMetaData(DependencyKey(sfName));
+	}
+}
+
+bool ccC2CBatchEngine::SaveSummary(	const QString& filename,
+									const QStringList& cloudNames,
+									const std::vector<Statistics>& stats,
+									int precision/*=6*/)
+{
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		ccLog::Warning(QString("[C2C] Failed to open file '%1' for writing").arg(filename));
+		return false;
+	}
+
+	QTextStream stream(&file);
+	stream.setRealNumberNotation(QTextStream::FixedNotation);
+	stream.setRealNumberPrecision(precision);
+	bool withErrors = false;
+	for (const Statistics& s : stats)
+	{
+		if (s.errorSampleCount != 0)
+		{
+			withErrors = true;
+			break;
+		}
+	}
+
+	stream << "Cloud;Success;Points;Valid distances;Min;Max;Mean;Std. dev.;RMS";
+	if (withErrors)
+	{
+		stream << ";Error samples;Mean error;Max error";
+	}
+	stream << endl;
+
+	for (size_t i = 0; i < stats.size(); ++i)
+	{
+		const Statistics& s = stats[i];
+		stream << (static_cast<int>(i) < cloudNames.size() ? cloudNames[static_cast<int>(i)] : QString("#%1").arg(i + 1)) << ';';
+		stream << (s.success ? 1 : 0) << ';' << s.pointCount << ';' << s.validCount << ';';
+		stream << s.minDist << ';' << s.maxDist << ';' << s.mean << ';' << s.stdDev << ';' << s.rms;
+		if (withErrors)
+		{
+			stream << ';' << s.errorSampleCount << ';' << s.meanError << ';' << s.maxError;
+		}
+		stream << endl;
+	}
+
+	return true;
+}
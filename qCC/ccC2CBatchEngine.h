@@ -0,0 +1,269 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_C2C_BATCH_ENGINE_HEADER
+#define CC_C2C_BATCH_ENGINE_HEADER
+
+//CCCoreLib
+#include <CCConst.h>
+
+//qCC_db
+#include <ccGLMatrix.h>
+#include <ccOctree.h>
+
+//Qt
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+//system
+#include <cstdint>
+#include <vector>
+
+class ccGenericPointCloud;
+class ccPointCloud;
+class ccScalarField;
+
+namespace CCCoreLib
+{
+	class ReferenceCloud;
+}
+
+//! Cloud-to-cloud distances engine for several compared clouds and a single reference
+/** The reference octree is built once by setReference (or retrieved if the cloud
+	already has one) and shared by all the subsequent calls to computeDistances.
+	All the points of all the compared clouds are processed concurrently.
+
+	Compared to CCCoreLib::DistanceComputationTools::computeCloud2CloudDistances,
+	the octrees don't need to be 'synchronized' (i.e. the compared clouds don't need
+	an octree) but the 'reuse existing local models' optimization is not supported.
+	The split X/Y/Z components are always expressed relatively to the nearest
+	reference point.
+
+	In 'approximate' mode, the nearest neighbors are searched in a decimated
+	version of the reference (a single point per octree cell, at the level where
+	the cells diagonal is below the max error). The computed distances are
+	therefore never smaller than the true ones, and never larger than the true
+	ones + the max error.
+
+	The engine can also track the dependency between a distances scalar field and
+	the reference cloud (see Dependency), so that only the points affected by a
+	(local) modification of the reference are recomputed afterwards.
+**/
+class ccC2CBatchEngine
+{
+public:
+
+	//! Distance computation parameters
+	struct Parameters
+	{
+		//! Octree level (0 = automatic)
+		unsigned char octreeLevel = 0;
+		//! Max search distance (0 = no limit)
+		/** Farther points get this distance as value.
+		**/
+		double maxSearchDist = 0.0;
+		//! Whether to generate the X, Y and Z components of the distances as well
+		bool splitXYZ = false;
+		//! Local model
+		CCCoreLib::LOCAL_MODEL_TYPES localModel = CCCoreLib::NO_MODEL;
+		//! Whether to use a spherical neighborhood (or kNN) to build the local models
+		bool useSphericalSearchForLocalModel = false;
+		//! Number of neighbors for the local models (kNN)
+		unsigned kNNForLocalModel = 0;
+		//! Neighborhood radius for the local models (spherical search)
+		double radiusForLocalModel = 0.0;
+		//! Max error on the distances for the approximate mode (0 = exact distances)
+		/** Local models are not supported in this mode.
+		**/
+		double approxMaxError = 0.0;
+	};
+
+	//! Distance statistics (for a given compared cloud)
+	struct Statistics
+	{
+		bool success = false;
+		unsigned pointCount = 0;
+		unsigned validCount = 0;
+		double minDist = 0.0;
+		double maxDist = 0.0;
+		double mean = 0.0;
+		double stdDev = 0.0;
+		double rms = 0.0;
+
+		//approximate mode only: error measured on a subset of the points (compared to the exact distances)
+		unsigned errorSampleCount = 0;
+		double meanError = 0.0;
+		double maxError = 0.0;
+	};
+
+	//! State of the reference cloud at the time the distances of a compared cloud were computed
+	/** The reference cloud is summarized by a regular grid of cells: each cell stores
+		an order-independent hash of the points it contains. Comparing two states gives
+		the cells where reference points have been added, removed or moved.
+		Only the 'nearest neighbor' distances (i.e. without local model) can be tracked.
+	**/
+	struct Dependency
+	{
+		//! Reference cloud unique ID
+		unsigned referenceID = 0;
+		//! Max search distance used for the computation
+		double maxSearchDist = 0.0;
+		//! Transformation history of the compared cloud
+		ccGLMatrix comparedTransformation;
+		//! Grid origin
+		CCVector3d gridOrigin;
+		//! Grid cell size
+		double cellSize = 0.0;
+		//! Grid size (along each dimension)
+		unsigned gridSize = 0;
+		//! Per-cell hashes (gridSize^3)
+		std::vector<uint64_t> cellHashes;
+	};
+
+	//! Default constructor
+	ccC2CBatchEngine();
+
+	//! Sets the reference cloud and the distance computation parameters
+	/** The octree of the cloud is reused if it already exists, otherwise it is computed
+		(and attached to the cloud, so that it is also reused by the next instances).
+		\param reference reference cloud
+		\param params distance computation parameters
+		\param progressCb progress callback (optional)
+		\param octree already computed octree of the reference cloud (optional)
+		\return success
+	**/
+	bool setReference(	ccGenericPointCloud* reference,
+						const Parameters& params,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr,
+						ccOctree::Shared octree = ccOctree::Shared());
+
+	//! Returns the reference cloud
+	inline ccGenericPointCloud* getReference() const { return m_refCloud; }
+
+	//! Returns the octree level actually used
+	inline unsigned char getOctreeLevel() const { return m_octreeLevel; }
+
+	//! Returns whether the distances are approximate (see Parameters::approxMaxError)
+	inline bool isApproximate() const { return !m_approxOctree.isNull(); }
+	//! Returns the number of points of the decimated reference (approximate mode only)
+	unsigned getApproxReferenceSize() const;
+
+	//! Returns the default name of the distances scalar field (depends on the parameters)
+	inline QString getDefaultSFName() const { return GetDefaultSFName(m_params); }
+
+	//! Returns the default name of the distances scalar field for a given set of parameters
+	static QString GetDefaultSFName(const Parameters& params);
+
+	//! Computes the distances between several compared clouds and the reference
+	/** A scalar field named 'sfName' is created (or overwritten) on each compared cloud.
+		If the X/Y/Z components are requested, 3 additional scalar fields are
+		created with the 'splitBaseName (X)', 'splitBaseName (Y)' and 'splitBaseName (Z)' names.
+		\param comparedClouds compared clouds
+		\param stats output statistics (one per compared cloud)
+		\param sfName name of the output scalar field (default name if empty)
+		\param splitBaseName base name of the X/Y/Z scalar fields (same as sfName if empty)
+		\param maxThreadCount max number of threads (0 = all)
+		\param progressCb progress callback (optional)
+		\return success (if at least one cloud could be processed)
+	**/
+	bool computeDistances(	const std::vector<ccPointCloud*>& comparedClouds,
+							std::vector<Statistics>& stats,
+							QString sfName = QString(),
+							QString splitBaseName = QString(),
+							int maxThreadCount = 0,
+							CCCoreLib::GenericProgressCallback* progressCb = nullptr) const;
+
+	//! Updates the distances of a compared cloud after the reference has been modified
+	/** Only the points whose previous distance sphere intersects a modified cell of the
+		reference (and the points without a valid distance) are recomputed.
+		\param compared compared cloud
+		\param distances scalar field with the previous distances (updated in place)
+		\param previous state of the reference when the previous distances were computed
+		\param current output: current state of the reference
+		\param recomputedCount output: number of recomputed points
+		\param maxRatio max ratio of points to recompute (the method fails beyond this ratio, so that the caller can do a full computation instead)
+		\param maxThreadCount max number of threads (0 = all)
+		\param progressCb progress callback (optional)
+		\return whether the distances could be updated (otherwise they must be entirely recomputed)
+	**/
+	bool updateDistances(	ccPointCloud* compared,
+							ccScalarField* distances,
+							const Dependency& previous,
+							Dependency& current,
+							unsigned& recomputedCount,
+							double maxRatio = 0.5,
+							int maxThreadCount = 0,
+							CCCoreLib::GenericProgressCallback* progressCb = nullptr) const;
+
+	//! Computes the current state of a reference cloud (see Dependency)
+	/** \param reference reference cloud
+		\param compared compared cloud
+		\param maxSearchDist max search distance
+		\param dependency output state
+		\param gridDefinition previous state (to reuse the same grid definition, optional)
+		\return success
+	**/
+	static bool ComputeDependency(	const ccGenericPointCloud* reference,
+									const ccPointCloud* compared,
+									double maxSearchDist,
+									Dependency& dependency,
+									const Dependency* gridDefinition = nullptr);
+
+	//! Attaches a dependency to a distances scalar field (stored as meta-data of the compared cloud)
+	static void SetDependency(ccPointCloud* compared, const QString& sfName, const Dependency& dependency);
+	//! Retrieves the dependency attached to a distances scalar field (if any)
+	static bool GetDependency(const ccPointCloud* compared, const QString& sfName, Dependency& dependency);
+	//! Removes the dependency attached to a distances scalar field (if any)
+	static void RemoveDependency(ccPointCloud* compared, const QString& sfName);
+
+	//! Saves a summary table (CSV) of the distance statistics of several clouds
+	/** The approximation error columns are only added if at least one cloud has some.
+	**/
+	static bool SaveSummary(const QString& filename,
+							const QStringList& cloudNames,
+							const std::vector<Statistics>& stats,
+							int precision = 6);
+
+protected:
+
+	//! Prepares the decimated reference for the approximate mode
+	bool prepareApproximateReference(CCCoreLib::GenericProgressCallback* progressCb);
+
+	//! Measures the approximation error on a subset of the points of a compared cloud
+	void measureApproximationError(const ccPointCloud* compared, const ccScalarField* distances, Statistics& stats) const;
+
+	//! Reference cloud
+	ccGenericPointCloud* m_refCloud;
+	//! Reference octree
+	ccOctree::Shared m_refOctree;
+	//! Parameters
+	Parameters m_params;
+	//! Octree level used for nearest neighbour search
+	unsigned char m_octreeLevel;
+	//! Octree level used for the local models neighborhood extraction
+	unsigned char m_modelOctreeLevel;
+
+	//! Decimated reference cloud (approximate mode)
+	QSharedPointer<CCCoreLib::ReferenceCloud> m_approxCloud;
+	//! Octree of the decimated reference cloud (approximate mode)
+	QSharedPointer<CCCoreLib::DgmOctree> m_approxOctree;
+	//! Octree level used for nearest neighbour search in the decimated reference
+	unsigned char m_approxOctreeLevel;
+};
+
+#endif //CC_C2C_BATCH_ENGINE_HEADER
@@ -12,6 +12,7 @@
 #include <ccHObjectCaster.h>
 #include <ccNormalVectors.h>
 #include <ccPlane.h>
+#include <ccPointCloudInterpolator.h>
 #include <ccPolyline.h>
 #include <ccProgressDialog.h>
 #include <ccScalarField.h>
@@ -37,7 +38,15 @@
 #include "ccEntityAction.h"
 
 #include <QDateTime>
+#include <QFile>
 #include <QFileInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+//system
+#include <atomic>
+#include <limits>
 
 //commands
 constexpr char COMMAND_CLOUD_EXPORT_FORMAT[]			= "C_EXPORT_FMT";
@@ -50,6 +59,8 @@ constexpr char COMMAND_MESH_EXPORT_FORMAT[]				= "M_EXPORT_FMT";
 constexpr char COMMAND_HIERARCHY_EXPORT_FORMAT[]		= "H_EXPORT_FMT";
 constexpr char COMMAND_OPEN[]							= "O";				//+file name
 constexpr char COMMAND_OPEN_SKIP_LINES[]				= "SKIP";			//+number of lines to skip
+constexpr char COMMAND_OPEN_WELD_VERTICES[]				= "WELD";			//+welding tolerance
+constexpr char COMMAND_OPEN_REORDER[]					= "REORDER";		//+spatial order (MORTON/HILBERT)
 constexpr char COMMAND_SUBSAMPLE[]						= "SS";				//+ method (RANDOM/SPATIAL/OCTREE) + parameter (resp. point count / spatial step / octree level)
 constexpr char COMMAND_EXTRACT_CC[]						= "EXTRACT_CC";
 constexpr char COMMAND_CURVATURE[]						= "CURV";			//+ curvature type (MEAN/GAUSS)
@@ -64,7 +75,18 @@ constexpr char COMMAND_SF_COLOR_SCALE[]					= "SF_COLOR_SCALE";
 constexpr char COMMAND_SF_CONVERT_TO_RGB[]				= "SF_CONVERT_TO_RGB";
 constexpr char COMMAND_FILTER_SF_BY_VALUE[]				= "FILTER_SF";
 constexpr char COMMAND_MERGE_CLOUDS[]					= "MERGE_CLOUDS";
+constexpr char COMMAND_REORDER_POINTS[]					= "REORDER_POINTS";	//+spatial order (MORTON/HILBERT/ORIGINAL)
+constexpr char COMMAND_REORDER_STORE_INDEXES[]			= "STORE_ORIGINAL_INDEXES";
 constexpr char COMMAND_MERGE_MESHES[]                   = "MERGE_MESHES";
+constexpr char COMMAND_WELD_VERTICES[]					= "WELD_VERTICES";
+constexpr char COMMAND_WELD_EPSILON[]					= "EPSILON";		//+welding tolerance
+constexpr char COMMAND_WELD_KEEP_DEGENERATE[]			= "KEEP_DEGENERATE";
+constexpr char COMMAND_WELD_KEEP_DUPLICATES[]			= "KEEP_DUPLICATES";
+constexpr char COMMAND_SMOOTH_MESH[]					= "SMOOTH_MESH";
+constexpr char COMMAND_SMOOTH_ITERATIONS[]				= "ITER";			//+number of iterations
+constexpr char COMMAND_SMOOTH_FACTOR[]					= "FACTOR";			//+smoothing factor (lambda for Taubin)
+constexpr char COMMAND_SMOOTH_TAUBIN[]					= "TAUBIN";			//+inflating factor (mu)
+constexpr char COMMAND_SUBDIVIDE_MESH[]					= "SUBDIVIDE_MESH";	//+max triangle area
 constexpr char COMMAND_SET_ACTIVE_SF[]					= "SET_ACTIVE_SF";
 constexpr char COMMAND_REMOVE_ALL_SFS[]					= "REMOVE_ALL_SFS";
 constexpr char COMMAND_REMOVE_SCAN_GRIDS[]				= "REMOVE_SCAN_GRIDS";
@@ -93,6 +115,11 @@ constexpr char COMMAND_C2C_DIST[]						= "C2C_DIST";
 constexpr char COMMAND_CLOSEST_POINT_SET[]              = "CLOSEST_POINT_SET";
 constexpr char COMMAND_C2C_SPLIT_XYZ[]					= "SPLIT_XYZ";
 constexpr char COMMAND_C2C_LOCAL_MODEL[]				= "MODEL";
+constexpr char COMMAND_C2C_MULTI[]						= "MULTI";
+constexpr char COMMAND_C2C_FILES[]						= "FILES";
+constexpr char COMMAND_C2C_MEM_BUDGET[]					= "MEM_BUDGET";
+constexpr char COMMAND_C2C_SUMMARY[]					= "SUMMARY";
+constexpr char COMMAND_C2C_APPROX[]						= "APPROX";
 constexpr char COMMAND_C2X_MAX_DISTANCE[]				= "MAX_DIST";
 constexpr char COMMAND_C2X_OCTREE_LEVEL[]				= "OCTREE_LEVEL";
 constexpr char COMMAND_STAT_TEST[]						= "STAT_TEST";
@@ -103,6 +130,13 @@ constexpr char COMMAND_DELAUNAY_MAX_EDGE_LENGTH[]		= "MAX_EDGE_LENGTH";
 constexpr char COMMAND_SF_ARITHMETIC[]					= "SF_ARITHMETIC";
 constexpr char COMMAND_SF_OP[]							= "SF_OP";
 constexpr char COMMAND_RENAME_SF[]						= "RENAME_SF";
+constexpr char COMMAND_SF_INTERP[]						= "SF_INTERP";
+constexpr char COMMAND_SF_INTERP_SF[]					= "SF";
+constexpr char COMMAND_SF_INTERP_METHOD[]				= "METHOD";
+constexpr char COMMAND_SF_INTERP_ALGO[]					= "ALGO";
+constexpr char COMMAND_SF_INTERP_RADIUS[]				= "RADIUS";
+constexpr char COMMAND_SF_INTERP_SIGMA[]				= "SIGMA";
+constexpr char COMMAND_SF_INTERP_POWER[]				= "POWER";
 constexpr char COMMAND_COORD_TO_SF[]					= "COORD_TO_SF";
 constexpr char COMMAND_EXTRACT_VERTICES[]				= "EXTRACT_VERTICES";
 constexpr char COMMAND_ICP[]							= "ICP";
@@ -116,6 +150,12 @@ constexpr char COMMAND_ICP_ENABLE_FARTHEST_REMOVAL[]	= "FARTHEST_REMOVAL";
 constexpr char COMMAND_ICP_USE_MODEL_SF_AS_WEIGHT[]		= "MODEL_SF_AS_WEIGHTS";
 constexpr char COMMAND_ICP_USE_DATA_SF_AS_WEIGHT[]		= "DATA_SF_AS_WEIGHTS";
 constexpr char COMMAND_ICP_ROT[]						= "ROT";
+constexpr char COMMAND_ICP_METRIC[]						= "METRIC";
+constexpr char COMMAND_ICP_LEVELS[]						= "LEVELS";
+constexpr char COMMAND_ICP_BATCH[]						= "ICP_BATCH";
+constexpr char COMMAND_ICP_BATCH_REFERENCE_IS_MESH[]	= "REFERENCE_IS_MESH";
+constexpr char COMMAND_ICP_BATCH_REPORT[]				= "REPORT";
+constexpr char COMMAND_ICP_BATCH_APPLY[]				= "APPLY";
 constexpr char COMMAND_PLY_EXPORT_FORMAT[]				= "PLY_EXPORT_FMT";
 constexpr char COMMAND_COMPUTE_GRIDDED_NORMALS[]		= "COMPUTE_NORMALS";
 constexpr char COMMAND_INVERT_NORMALS[]					= "INVERT_NORMALS";
@@ -147,6 +187,7 @@ constexpr char OPTION_LAST[]							= "LAST";
 constexpr char OPTION_FILE_NAMES[]						= "FILE";
 constexpr char OPTION_ORIENT[]							= "ORIENT";
 constexpr char OPTION_MODEL[]							= "MODEL";
+constexpr char OPTION_KNN[]								= "KNN";
 
 CommandChangeOutputFormat::CommandChangeOutputFormat(const QString& name, const QString& keyword)
     : ccCommandLineInterface::Command(name, keyword)
@@ -418,6 +459,24 @@ bool CommandChangeHierarchyOutputFormat::process(ccCommandLineInterface& cmd)
 	return true;
 }
 
+static bool ReadSpatialOrder(const QString& orderArg, ccPointCloud::SpatialOrder& order)
+{
+	QString upperArg = orderArg.toUpper();
+	if (upperArg == "MORTON")
+	{
+		order = ccPointCloud::SpatialOrder::MORTON;
+	}
+	else if (upperArg == "HILBERT")
+	{
+		order = ccPointCloud::SpatialOrder::HILBERT;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
 CommandLoad::CommandLoad()
 	: ccCommandLineInterface::Command(QObject::tr("Load"), COMMAND_OPEN)
 {}
@@ -432,6 +491,10 @@ bool CommandLoad::process(ccCommandLineInterface &cmd)
 	
 	//optional parameters
 	int skipLines = 0;
+	bool weldVertices = false;
+	double weldingTolerance = 0.0;
+	bool reorderPoints = false;
+	ccPointCloud::SpatialOrder pointOrder = ccPointCloud::SpatialOrder::HILBERT;
 
 	bool coordinatesShiftWasEnabled = cmd.coordinatesShiftWasEnabled();
 
@@ -457,6 +520,45 @@ bool CommandLoad::process(ccCommandLineInterface &cmd)
 			
 			cmd.print(QObject::tr("Will skip %1 lines").arg(skipLines));
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_WELD_VERTICES))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: welding tolerance after '%1'").arg(COMMAND_OPEN_WELD_VERTICES));
+			}
+
+			bool ok;
+			weldingTolerance = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || weldingTolerance < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: welding tolerance after '%1'").arg(COMMAND_OPEN_WELD_VERTICES));
+			}
+			weldVertices = true;
+
+			cmd.print(QObject::tr("Mesh vertices will be welded (tolerance: %1)").arg(weldingTolerance));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_OPEN_REORDER))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: spatial order after '%1' (MORTON/HILBERT)").arg(COMMAND_OPEN_REORDER));
+			}
+
+			QString orderArg = cmd.arguments().takeFirst();
+			if (!ReadSpatialOrder(orderArg, pointOrder))
+			{
+				return cmd.error(QObject::tr("Invalid parameter: spatial order after '%1' (MORTON/HILBERT)").arg(COMMAND_OPEN_REORDER));
+			}
+			reorderPoints = true;
+
+			cmd.print(QObject::tr("Points will be reordered (%1 order)").arg(orderArg.toUpper()));
+		}
 		else if (cmd.nextCommandIsGlobalShift())
 		{
 			//local option confirmed, we can move on
@@ -474,14 +576,35 @@ bool CommandLoad::process(ccCommandLineInterface &cmd)
 		}
 	}
 	
-	if (skipLines >= 0)
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: filename after \"-%1\"").arg(COMMAND_OPEN));
+	}
+	QString filename(cmd.arguments().takeFirst());
+
+	//the number of skipped lines is a global setting of the ASCII filter: we don't
+	//touch it for the other files (they may be loaded concurrently in parallel mode)
+	if (	skipLines >= 0
+		&&	qSharedPointerDynamicCast<AsciiFilter>(FileIOFilter::FindBestFilterForExtension(QFileInfo(filename).suffix())))
 	{
 		AsciiFilter::SetDefaultSkippedLineCount(skipLines);
 	}
 	
+	//mesh welding (for this file only)
+	cmd.fileLoadingParams().weldMeshVertices = weldVertices;
+	cmd.fileLoadingParams().meshWeldingTolerance = weldingTolerance;
+	//point reordering (for this file only)
+	cmd.fileLoadingParams().reorderPoints = reorderPoints;
+	cmd.fileLoadingParams().pointOrder = pointOrder;
+
 	//open specified file
-	QString filename(cmd.arguments().takeFirst());
-	if (!cmd.importFile(filename))
+	bool success = cmd.importFile(filename);
+
+	cmd.fileLoadingParams().weldMeshVertices = false;
+	cmd.fileLoadingParams().meshWeldingTolerance = 0.0;
+	cmd.fileLoadingParams().reorderPoints = false;
+
+	if (!success)
 	{
 		return false;
 	}
@@ -642,6 +765,7 @@ bool CommandOctreeNormal::process(ccCommandLineInterface &cmd)
 
 	CCCoreLib::LOCAL_MODEL_TYPES model = CCCoreLib::QUADRIC;
 	ccNormalVectors::Orientation  orientation = ccNormalVectors::Orientation::UNDEFINED;
+	unsigned kNN = 0;
 	
 	while (!cmd.arguments().isEmpty())
 	{
@@ -734,12 +858,32 @@ bool CommandOctreeNormal::process(ccCommandLineInterface &cmd)
 				return cmd.error(QObject::tr("Missing model"));
 			}
 		}
+		else if (ccCommandLineInterface::IsCommand(argument, OPTION_KNN))
+		{
+			cmd.arguments().takeFirst();
+			if (cmd.arguments().isEmpty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: number of neighbors after \"-%1\"").arg(OPTION_KNN));
+			}
+			bool ok = false;
+			kNN = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || kNN < 3)
+			{
+				return cmd.error(QObject::tr("Invalid number of neighbors (should be >= 3)"));
+			}
+			cmd.print(QObject::tr("\tkNN: %1 (the radius is ignored)").arg(kNN));
+		}
 		else
 		{
 			break;
 		}
 	}
 	
+	if (kNN != 0 && model == CCCoreLib::LOCAL_MODEL_TYPES::TRI)
+	{
+		return cmd.error(QObject::tr("Option \"-%1\" can't be used with the TRI model (it already relies on a fixed number of neighbors)").arg(OPTION_KNN));
+	}
+	
 	for (const CLCloudDesc& thisCloudDesc : cmd.clouds())
 	{
 		ccPointCloud* cloud = thisCloudDesc.pc;
@@ -760,7 +904,7 @@ bool CommandOctreeNormal::process(ccCommandLineInterface &cmd)
 		}
 
 		float thisCloudRadius = radius;
-		if (std::isnan(thisCloudRadius))
+		if (std::isnan(thisCloudRadius) && kNN == 0)
 		{
 			thisCloudRadius = ccNormalVectors::GuessBestRadius(cloud, cloud->getOctree().data());
 			if (thisCloudRadius == 0)
@@ -771,7 +915,7 @@ bool CommandOctreeNormal::process(ccCommandLineInterface &cmd)
 		}
 
 		cmd.print(QObject::tr("computeNormalsWithOctree started..."));
-		bool success = cloud->computeNormalsWithOctree(model, orientation, thisCloudRadius, progressDialog.data());
+		bool success = cloud->computeNormalsWithOctree(model, orientation, thisCloudRadius, progressDialog.data(), kNN);
 		if(success)
 		{
 			cmd.print(QObject::tr("computeNormalsWithOctree success"));
@@ -1817,6 +1961,19 @@ enum USE_SPECIAL_SF_VALUE
 	USE_N_SIGMA_MAX
 };
 
+bool CommandFilterBySFValue::isPointLocal(const QStringList& arguments) const
+{
+	//the special values (MIN, DISP_MAX, N_SIGMA_MIN, etc.) depend on the whole scalar field
+	bool minOk = false;
+	bool maxOk = false;
+	if (arguments.size() >= 2)
+	{
+		arguments[0].toDouble(&minOk);
+		arguments[1].toDouble(&maxOk);
+	}
+	return minOk && maxOk;
+}
+
 bool CommandFilterBySFValue::process(ccCommandLineInterface &cmd)
 {
 	cmd.print(QObject::tr("[FILTER BY VALUE]"));
@@ -2153,882 +2310,616 @@ bool CommandMergeMeshes::process(ccCommandLineInterface &cmd)
 	return true;
 }
 
-CommandMergeClouds::CommandMergeClouds()
-	: ccCommandLineInterface::Command(QObject::tr("Merge clouds"), COMMAND_MERGE_CLOUDS)
+CommandWeldVertices::CommandWeldVertices()
+	: ccCommandLineInterface::Command(QObject::tr("Weld mesh vertices"), COMMAND_WELD_VERTICES)
 {}
 
-bool CommandMergeClouds::process(ccCommandLineInterface &cmd)
+bool CommandWeldVertices::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[MERGE CLOUDS]"));
-	
-	if (cmd.clouds().size() < 2)
-	{
-		cmd.warning(QObject::tr("Less than 2 clouds are loaded! Nothing to do..."));
-		return true;
-	}
-	
-	//merge clouds
+	cmd.print(QObject::tr("[WELD VERTICES]"));
+
+	ccMesh::WeldingParameters params;
+	params.epsilon = ccMesh::DefaultWeldingTolerance();
+
+	//optional parameters
+	while (!cmd.arguments().empty())
 	{
-		for (size_t i = 1; i < cmd.clouds().size(); ++i)
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_WELD_EPSILON))
 		{
-			unsigned beforePts = cmd.clouds().front().pc->size();
-			unsigned newPts = cmd.clouds()[i].pc->size();
-			*cmd.clouds().front().pc += cmd.clouds()[i].pc;
-			
-			//success?
-			if (cmd.clouds().front().pc->size() == beforePts + newPts)
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
 			{
-				delete cmd.clouds()[i].pc;
-				cmd.clouds()[i].pc = nullptr;
+				return cmd.error(QObject::tr("Missing parameter: welding tolerance after '%1'").arg(COMMAND_WELD_EPSILON));
 			}
-			else
+
+			bool ok;
+			params.epsilon = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || params.epsilon < 0)
 			{
-				return cmd.error(QObject::tr("Fusion failed! (not enough memory?)"));
+				return cmd.error(QObject::tr("Invalid parameter: welding tolerance after '%1'").arg(COMMAND_WELD_EPSILON));
 			}
 		}
-	}
-	
-	//clean the 'cmd.clouds()' vector
-	cmd.clouds().resize(1);
-	//update the first one
-	cmd.clouds().front().basename += QObject::tr("_MERGED");
-	if (cmd.autoSaveMode())
-	{
-		QString errorStr = cmd.exportEntity(cmd.clouds().front());
-		if (!errorStr.isEmpty())
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_WELD_KEEP_DEGENERATE))
 		{
-			return cmd.error(errorStr);
-		}
-	}
-	return true;
-}
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
 
-CommandSetActiveSF::CommandSetActiveSF()
-	: ccCommandLineInterface::Command(QObject::tr("Set active SF"), COMMAND_SET_ACTIVE_SF)
-{}
+			params.removeDegenerateTriangles = false;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_WELD_KEEP_DUPLICATES))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
 
-bool CommandSetActiveSF::process(ccCommandLineInterface &cmd)
-{
-	if (cmd.arguments().empty())
-	{
-		return cmd.error(QObject::tr("Missing parameter: scalar field index after \"-%1\"").arg(COMMAND_SET_ACTIVE_SF));
-	}
-	
-	int sfIndex = -1;
-	bool ok = true;
-	QString sfIndexStr = cmd.arguments().takeFirst();
-	if (sfIndexStr.toUpper() == OPTION_LAST)
-	{
-		sfIndex = -2;
-	}
-	else
-	{
-		sfIndex = sfIndexStr.toInt(&ok);
-	}
-	if (!ok || sfIndex == -1)
-	{
-		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SET_ACTIVE_SF));
-	}
-	cmd.print(QObject::tr("Set active S.F. index: %1").arg(sfIndex));
-	
-	if (cmd.clouds().empty())
-	{
-		return cmd.error(QObject::tr("No point cloud loaded! (be sure to open one with \"-%1 [cloud filename]\" before \"-%2\")").arg(COMMAND_OPEN, COMMAND_SET_ACTIVE_SF));
-	}
-	
-	for (size_t i = 0; i<cmd.clouds().size(); ++i)
-	{
-		if (cmd.clouds()[i].pc && cmd.clouds()[i].pc->hasScalarFields())
+			params.removeDuplicateTriangles = false;
+		}
+		else
 		{
-			if (sfIndex < static_cast<int>(cmd.clouds()[i].pc->getNumberOfScalarFields()))
-			{
-				cmd.clouds()[i].pc->setCurrentScalarField(sfIndex < 0 ? static_cast<int>(cmd.clouds()[i].pc->getNumberOfScalarFields()) - 1 : sfIndex);
-			}
-			else
-			{
-				cmd.warning(QObject::tr("Cloud '%1' has less scalar fields than the index to select!").arg(cmd.clouds()[i].pc->getName()));
-			}
+			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
 		}
 	}
-	
-	return true;
-}
-
-CommandRemoveAllSF::CommandRemoveAllSF()
-	: ccCommandLineInterface::Command(QObject::tr("Remove all SF"), COMMAND_REMOVE_ALL_SFS)
-{}
 
-bool CommandRemoveAllSF::process(ccCommandLineInterface &cmd)
-{
-	//no argument required
-	for (auto &cloudDesc : cmd.clouds())
+	if (cmd.meshes().empty())
 	{
-		if (cloudDesc.pc/* && cmd.clouds()[i].pc->hasScalarFields()*/)
-		{
-			cloudDesc.pc->deleteAllScalarFields();
-			cloudDesc.pc->showSF(false);
-		}
+		cmd.warning(QObject::tr("No mesh loaded! Nothing to do..."));
+		return true;
 	}
-	
-	for (auto &meshDesc : cmd.meshes())
+
+	cmd.print(QObject::tr("Welding tolerance: %1").arg(params.epsilon));
+
+	for (CLMeshDesc& meshDesc : cmd.meshes())
 	{
-		if (meshDesc.mesh)
+		ccMesh* mesh = dynamic_cast<ccMesh*>(meshDesc.mesh);
+		if (!mesh)
 		{
-			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
-			if (cloud->isA(CC_TYPES::POINT_CLOUD))
-			{
-				static_cast<ccPointCloud*>(cloud)->deleteAllScalarFields();
-				cloud->showSF(false);
-			}
+			cmd.warning(QObject::tr("Can't weld the vertices of mesh '%1' (unhandled type)").arg(meshDesc.basename));
+			continue;
 		}
-	}
-	
-	return true;
-}
-
-CommandRemoveRGB::CommandRemoveRGB()
-	: ccCommandLineInterface::Command(QObject::tr("Remove RGB"), COMMAND_REMOVE_RGB)
-{}
 
-bool CommandRemoveRGB::process(ccCommandLineInterface &cmd)
-{
-	//no argument required
-	for (auto &cloudDesc : cmd.clouds())
-	{
-		if (cloudDesc.pc)
+		ccMesh::WeldingStats stats;
+		if (!mesh->weldVertices(params, &stats, cmd.progressDialog()))
 		{
-			cloudDesc.pc->unallocateColors();
-			cloudDesc.pc->showColors(false);
+			return cmd.error(QObject::tr("Failed to weld the vertices of mesh '%1'").arg(meshDesc.basename));
 		}
-	}
 
-	for (auto &meshDesc : cmd.meshes())
-	{
-		if (meshDesc.mesh)
+		cmd.print(QObject::tr("Mesh '%1': %2 merged vertices, %3 degenerate and %4 duplicate triangles removed")
+					.arg(meshDesc.basename)
+					.arg(stats.mergedVertexCount)
+					.arg(stats.degenerateTriangleCount)
+					.arg(stats.duplicateTriangleCount));
+
+		meshDesc.basename += QObject::tr("_WELDED");
+		if (cmd.autoSaveMode())
 		{
-			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
-			if (cloud->isA(CC_TYPES::POINT_CLOUD))
+			QString errorStr = cmd.exportEntity(meshDesc);
+			if (!errorStr.isEmpty())
 			{
-				static_cast<ccPointCloud*>(cloud)->unallocateColors();
-				cloud->showColors(false);
+				return cmd.error(errorStr);
 			}
-			meshDesc.mesh->showColors(false);
 		}
 	}
 
 	return true;
 }
 
-CommandRemoveNormals::CommandRemoveNormals()
-	: ccCommandLineInterface::Command(QObject::tr("Remove normals"), COMMAND_REMOVE_NORMALS)
+CommandSmoothMesh::CommandSmoothMesh()
+	: ccCommandLineInterface::Command(QObject::tr("Smooth mesh"), COMMAND_SMOOTH_MESH)
 {}
 
-bool CommandRemoveNormals::process(ccCommandLineInterface &cmd)
+bool CommandSmoothMesh::process(ccCommandLineInterface &cmd)
 {
-	//no argument required
-	for (auto &cloudDesc : cmd.clouds())
-	{
-		if (cloudDesc.pc)
-		{
-			cloudDesc.pc->unallocateNorms();
-			cloudDesc.pc->showNormals(false);
-		}
-	}
+	cmd.print(QObject::tr("[SMOOTH MESH]"));
 
-	for (auto &meshDesc : cmd.meshes())
+	unsigned iterationCount = 20;
+	double factor = 0.2;
+	bool taubin = false;
+	double mu = -0.53;
+
+	//optional parameters
+	while (!cmd.arguments().empty())
 	{
-		if (meshDesc.mesh)
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_SMOOTH_ITERATIONS))
 		{
-			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
-			if (cloud->isA(CC_TYPES::POINT_CLOUD))
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
 			{
-				static_cast<ccPointCloud*>(cloud)->unallocateNorms();
-				cloud->showNormals(false);
+				return cmd.error(QObject::tr("Missing parameter: number of iterations after '%1'").arg(COMMAND_SMOOTH_ITERATIONS));
 			}
-			if (meshDesc.mesh->isA(CC_TYPES::MESH))
+
+			bool ok;
+			iterationCount = cmd.arguments().takeFirst().toUInt(&ok);
+			if (!ok || iterationCount == 0)
 			{
-				static_cast<ccMesh*>(meshDesc.mesh)->clearTriNormals();
-				meshDesc.mesh->showNormals(false);
+				return cmd.error(QObject::tr("Invalid parameter: number of iterations after '%1'").arg(COMMAND_SMOOTH_ITERATIONS));
 			}
 		}
-	}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SMOOTH_FACTOR))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
 
-	return true;
-}
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: smoothing factor after '%1'").arg(COMMAND_SMOOTH_FACTOR));
+			}
 
-CommandRemoveScanGrids::CommandRemoveScanGrids()
-	: ccCommandLineInterface::Command(QObject::tr("Remove scan grids"), COMMAND_REMOVE_SCAN_GRIDS)
-{}
+			bool ok;
+			factor = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || factor <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: smoothing factor after '%1'").arg(COMMAND_SMOOTH_FACTOR));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SMOOTH_TAUBIN))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
 
-bool CommandRemoveScanGrids::process(ccCommandLineInterface &cmd)
-{
-	//no argument required
-	for (CLCloudDesc& cloudDesc : cmd.clouds())
-	{
-		if (cloudDesc.pc)
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: inflating factor after '%1'").arg(COMMAND_SMOOTH_TAUBIN));
+			}
+
+			bool ok;
+			mu = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || mu >= 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: inflating factor after '%1' (should be negative)").arg(COMMAND_SMOOTH_TAUBIN));
+			}
+			taubin = true;
+		}
+		else
 		{
-			cloudDesc.pc->removeGrids();
+			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
 		}
 	}
-	
+
+	if (taubin && -mu < factor)
+	{
+		return cmd.error(QObject::tr("Invalid parameters: the inflating factor should be larger (in absolute value) than the smoothing factor"));
+	}
+
+	if (cmd.meshes().empty())
+	{
+		cmd.warning(QObject::tr("No mesh loaded! Nothing to do..."));
+		return true;
+	}
+
+	if (taubin)
+		cmd.print(QObject::tr("Taubin smoothing: %1 iterations (lambda = %2, mu = %3)").arg(iterationCount).arg(factor).arg(mu));
+	else
+		cmd.print(QObject::tr("Laplacian smoothing: %1 iterations (factor = %2)").arg(iterationCount).arg(factor));
+
 	for (CLMeshDesc& meshDesc : cmd.meshes())
 	{
-		if (meshDesc.mesh)
+		ccMesh* mesh = dynamic_cast<ccMesh*>(meshDesc.mesh);
+		if (!mesh)
 		{
-			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
-			if (cloud->isA(CC_TYPES::POINT_CLOUD))
+			cmd.warning(QObject::tr("Can't smooth mesh '%1' (unhandled type)").arg(meshDesc.basename));
+			continue;
+		}
+
+		bool success = taubin	? mesh->taubinSmooth(iterationCount, static_cast<PointCoordinateType>(factor), static_cast<PointCoordinateType>(mu), cmd.progressDialog())
+								: mesh->laplacianSmooth(iterationCount, static_cast<PointCoordinateType>(factor), cmd.progressDialog());
+		if (!success)
+		{
+			return cmd.error(QObject::tr("Failed to smooth mesh '%1'").arg(meshDesc.basename));
+		}
+
+		meshDesc.basename += QObject::tr("_SMOOTHED");
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(meshDesc);
+			if (!errorStr.isEmpty())
 			{
-				static_cast<ccPointCloud*>(cloud)->removeGrids();
+				return cmd.error(errorStr);
 			}
 		}
 	}
-	
+
 	return true;
 }
 
-CommandMatchBBCenters::CommandMatchBBCenters()
-	: ccCommandLineInterface::Command(QObject::tr("Match B.B. centers"), COMMAND_MATCH_BB_CENTERS)
+CommandSubdivideMesh::CommandSubdivideMesh()
+	: ccCommandLineInterface::Command(QObject::tr("Subdivide mesh"), COMMAND_SUBDIVIDE_MESH)
 {}
 
-bool CommandMatchBBCenters::process(ccCommandLineInterface &cmd)
+bool CommandSubdivideMesh::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[MATCH B.B. CENTERS]"));
-	
-	std::vector<CLEntityDesc*> entities;
-	for (auto& cloud : cmd.clouds())
-	{
-		entities.push_back(&cloud);
-	}
-	for (auto& mesh : cmd.meshes())
+	cmd.print(QObject::tr("[SUBDIVIDE MESH]"));
+
+	if (cmd.arguments().empty())
 	{
-		entities.push_back(&mesh);
+		return cmd.error(QObject::tr("Missing parameter: max triangle area after \"-%1\"").arg(COMMAND_SUBDIVIDE_MESH));
 	}
-	
-	if (entities.empty())
+
+	bool ok;
+	double maxArea = cmd.arguments().takeFirst().toDouble(&ok);
+	if (!ok || maxArea <= 0)
 	{
-		return cmd.error("No entity loaded!");
+		return cmd.error(QObject::tr("Invalid parameter: max triangle area after \"-%1\"").arg(COMMAND_SUBDIVIDE_MESH));
 	}
-	else if (entities.size() == 1)
+
+	if (cmd.meshes().empty())
 	{
-		cmd.warning("Nothing to do: only one entity currently loaded!");
+		cmd.warning(QObject::tr("No mesh loaded! Nothing to do..."));
 		return true;
 	}
-	
-	CCVector3 firstCenter = entities.front()->getEntity()->getOwnBB().getCenter();
-	for (size_t i = 1; i < entities.size(); ++i)
+
+	for (CLMeshDesc& meshDesc : cmd.meshes())
 	{
-		ccHObject* ent = entities[i]->getEntity();
-		CCVector3 center = ent->getOwnBB().getCenter();
-		CCVector3 T = firstCenter - center;
-		
-		//transformation (used only for translation)
-		ccGLMatrix glTrans;
-		glTrans += T;
-		
-		//apply translation matrix
-		ent->applyGLTransformation_recursive(&glTrans);
-		cmd.print(QObject::tr("Entity '%1' has been translated: (%2,%3,%4)").arg(ent->getName()).arg(T.x).arg(T.y).arg(T.z));
+		ccMesh* mesh = dynamic_cast<ccMesh*>(meshDesc.mesh);
+		if (!mesh)
+		{
+			cmd.warning(QObject::tr("Can't subdivide mesh '%1' (unhandled type)").arg(meshDesc.basename));
+			continue;
+		}
+
+		ccMesh* subdividedMesh = mesh->subdivide(static_cast<PointCoordinateType>(maxArea));
+		if (!subdividedMesh)
+		{
+			return cmd.error(QObject::tr("Failed to subdivide mesh '%1'").arg(meshDesc.basename));
+		}
+		cmd.print(QObject::tr("Mesh '%1': %2 triangles (before: %3)").arg(meshDesc.basename).arg(subdividedMesh->size()).arg(mesh->size()));
+
+		subdividedMesh->setName(QString("%1.subdivided(S<%2)").arg(mesh->getName()).arg(maxArea));
+		delete meshDesc.mesh;
+		meshDesc.mesh = subdividedMesh;
+
+		meshDesc.basename += QObject::tr("_SUBDIVIDED");
 		if (cmd.autoSaveMode())
 		{
-			QString errorStr = cmd.exportEntity(*entities[i]);
+			QString errorStr = cmd.exportEntity(meshDesc);
 			if (!errorStr.isEmpty())
 			{
 				return cmd.error(errorStr);
 			}
 		}
 	}
-	
+
 	return true;
 }
 
-CommandMatchBestFitPlane::CommandMatchBestFitPlane()
-	: ccCommandLineInterface::Command(QObject::tr("Match best fit plane"), COMMAND_BEST_FIT_PLANE)
+CommandMergeClouds::CommandMergeClouds()
+	: ccCommandLineInterface::Command(QObject::tr("Merge clouds"), COMMAND_MERGE_CLOUDS)
 {}
 
-bool CommandMatchBestFitPlane::process(ccCommandLineInterface &cmd)
+bool CommandMergeClouds::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[COMPUTE BEST FIT PLANE]"));
+	cmd.print(QObject::tr("[MERGE CLOUDS]"));
 	
-	//look for local options
-	bool makeCloudsHoriz = false;
-	bool keepLoaded = false;
+	if (cmd.clouds().size() < 2)
+	{
+		cmd.warning(QObject::tr("Less than 2 clouds are loaded! Nothing to do..."));
+		return true;
+	}
 	
-	while (!cmd.arguments().empty())
+	//merge clouds (all at once)
 	{
-		QString argument = cmd.arguments().front();
-		if (ccCommandLineInterface::IsCommand(argument, COMMAND_BEST_FIT_PLANE_MAKE_HORIZ))
+		std::vector<ccPointCloud*> addedClouds;
+		addedClouds.reserve(cmd.clouds().size() - 1);
+		for (size_t i = 1; i < cmd.clouds().size(); ++i)
 		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			makeCloudsHoriz = true;
+			addedClouds.push_back(cmd.clouds()[i].pc);
 		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_BEST_FIT_PLANE_KEEP_LOADED))
+		
+		if (!cmd.clouds().front().pc->append(addedClouds))
 		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			keepLoaded = true;
+			return cmd.error(QObject::tr("Fusion failed! (not enough memory?)"));
 		}
-		else
+		
+		for (size_t i = 1; i < cmd.clouds().size(); ++i)
 		{
-			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
+			delete cmd.clouds()[i].pc;
+			cmd.clouds()[i].pc = nullptr;
 		}
 	}
 	
+	//clean the 'cmd.clouds()' vector
+	cmd.clouds().resize(1);
+	//update the first one
+	cmd.clouds().front().basename += QObject::tr("_MERGED");
+	if (cmd.autoSaveMode())
+	{
+		QString errorStr = cmd.exportEntity(cmd.clouds().front());
+		if (!errorStr.isEmpty())
+		{
+			return cmd.error(errorStr);
+		}
+	}
+	return true;
+}
+
+CommandReorderPoints::CommandReorderPoints()
+	: ccCommandLineInterface::Command(QObject::tr("Reorder points"), COMMAND_REORDER_POINTS)
+{}
+
+bool CommandReorderPoints::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[REORDER POINTS]"));
+
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: spatial order after \"-%1\" (MORTON/HILBERT/ORIGINAL)").arg(COMMAND_REORDER_POINTS));
+	}
+
+	QString orderArg = cmd.arguments().takeFirst().toUpper();
+	bool restoreOriginalOrder = (orderArg == "ORIGINAL");
+	ccPointCloud::SpatialOrder order = ccPointCloud::SpatialOrder::HILBERT;
+	if (!restoreOriginalOrder && !ReadSpatialOrder(orderArg, order))
+	{
+		return cmd.error(QObject::tr("Invalid parameter: spatial order after \"-%1\" (MORTON/HILBERT/ORIGINAL)").arg(COMMAND_REORDER_POINTS));
+	}
+
+	//optional parameter
+	bool storeOriginalIndexes = false;
+	if (!cmd.arguments().empty() && ccCommandLineInterface::IsCommand(cmd.arguments().front(), COMMAND_REORDER_STORE_INDEXES))
+	{
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		storeOriginalIndexes = true;
+	}
+
 	if (cmd.clouds().empty())
 	{
-		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
+		return cmd.error(QObject::tr("No point cloud loaded! (be sure to open one with \"-%1 [cloud filename]\" before \"-%2\")").arg(COMMAND_OPEN, COMMAND_REORDER_POINTS));
 	}
-	
-	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+
+	for (CLCloudDesc& desc : cmd.clouds())
 	{
-		ccPointCloud* pc = cmd.clouds()[i].pc;
-		
-		//try to fit plane
-		double rms = 0.0;
-		ccPlane* pPlane = ccPlane::Fit(pc, &rms);
-		if (pPlane)
+		bool success = (restoreOriginalOrder ? desc.pc->restoreOriginalPointOrder() : desc.pc->reorderPoints(order, storeOriginalIndexes));
+		if (!success)
 		{
-			cmd.print(QObject::tr("Plane successfully fitted: rms = %1").arg(rms));
-			
-			CCVector3 N = pPlane->getNormal();
-			CCVector3 C = *CCCoreLib::Neighbourhood(pc).getGravityCenter();
-			
-			CLMeshDesc planeDesc;
-			planeDesc.mesh = pPlane;
-			planeDesc.basename = cmd.clouds()[i].basename;
-			planeDesc.path = cmd.clouds()[i].path;
-			
-			//save plane as a BIN file
-			QString outputFilename;
-			QString errorStr = cmd.exportEntity(planeDesc, "BEST_FIT_PLANE", &outputFilename);
+			return cmd.error(QObject::tr("Failed to reorder the points of cloud '%1'").arg(desc.pc->getName()));
+		}
+
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(desc, "_REORDERED");
 			if (!errorStr.isEmpty())
 			{
-				cmd.warning(errorStr);
-			}
-			
-			//open text file to save plane related information
-			QString txtFilename = QObject::tr("%1/%2_BEST_FIT_PLANE_INFO").arg(cmd.clouds()[i].path, cmd.clouds()[i].basename);
-			if (cmd.addTimestamp())
-			{
-				txtFilename += QObject::tr("_%1").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh'h'mm"));
-			}
-			txtFilename += QObject::tr(".txt");
-			QFile txtFile(txtFilename);
-			txtFile.open(QIODevice::WriteOnly | QIODevice::Text);
-			QTextStream txtStream(&txtFile);
-			
-			txtStream << QObject::tr("Filename: %1").arg(outputFilename) << endl;
-			txtStream << QObject::tr("Fitting RMS: %1").arg(rms) << endl;
-			
-			//We always consider the normal with a positive 'Z' by default!
-			if (N.z < 0.0)
-			{
-				N *= -1.0;
-			}
-			
-			int precision = cmd.numericalPrecision();
-			txtStream << QObject::tr("Normal: (%1,%2,%3)").arg(N.x, 0, 'f', precision).arg(N.y, 0, 'f', precision).arg(N.z, 0, 'f', precision) << endl;
-			
-			//we compute strike & dip by the way
-			{
-				PointCoordinateType dip = 0;
-				PointCoordinateType dipDir = 0;
-				ccNormalVectors::ConvertNormalToDipAndDipDir(N, dip, dipDir);
-				txtStream << ccNormalVectors::ConvertDipAndDipDirToString(dip, dipDir) << endl;
+				return cmd.error(errorStr);
 			}
-			
-			//compute the transformation matrix that would make this normal points towards +Z
-			ccGLMatrix makeZPosMatrix = ccGLMatrix::FromToRotation(N, CCVector3(0, 0, CCCoreLib::PC_ONE));
-			CCVector3 Gt = C;
-			makeZPosMatrix.applyRotation(Gt);
-			makeZPosMatrix.setTranslation(C - Gt);
-			
-			txtStream << "Orientation matrix:" << endl;
-			txtStream << makeZPosMatrix.toString(precision, ' ') << endl;
-			
-			//close the text file
-			txtFile.close();
-			
-			if (keepLoaded)
-			{
-				//add the resulting plane (mesh) to the main set
-				cmd.meshes().push_back(planeDesc);
-			}
-			
-			if (makeCloudsHoriz)
-			{
-				//apply 'horizontal' matrix
-				pc->applyGLTransformation_recursive(&makeZPosMatrix);
-				cmd.print(QObject::tr("Cloud '%1' has been transformed with the above matrix").arg(pc->getName()));
-				cmd.clouds()[i].basename += QObject::tr("_HORIZ");
-				if (cmd.autoSaveMode())
-				{
-					QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
-					if (!errorStr.isEmpty())
-					{
-						cmd.warning(errorStr);
-					}
-				}
-			}
-		}
-		else
-		{
-			cmd.warning(QObject::tr("Failed to compute best fit plane for cloud '%1'").arg(cmd.clouds()[i].pc->getName()));
 		}
 	}
-	
+
 	return true;
 }
 
-CommandOrientNormalsMST::CommandOrientNormalsMST()
-	: ccCommandLineInterface::Command(QObject::tr("Orient normals"), COMMAND_ORIENT_NORMALS)
+CommandSetActiveSF::CommandSetActiveSF()
+	: ccCommandLineInterface::Command(QObject::tr("Set active SF"), COMMAND_SET_ACTIVE_SF)
 {}
 
-bool CommandOrientNormalsMST::process(ccCommandLineInterface &cmd)
+bool CommandSetActiveSF::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[ORIENT NORMALS (MST)]"));
-	
 	if (cmd.arguments().empty())
 	{
-		return cmd.error(QObject::tr("Missing parameter: number of neighbors after \"-%1\"").arg(COMMAND_ORIENT_NORMALS));
+		return cmd.error(QObject::tr("Missing parameter: scalar field index after \"-%1\"").arg(COMMAND_SET_ACTIVE_SF));
 	}
 	
-	QString knnStr = cmd.arguments().takeFirst();
-	bool ok;
-	int knn = knnStr.toInt(&ok);
-	if (!ok || knn <= 0)
+	int sfIndex = -1;
+	bool ok = true;
+	QString sfIndexStr = cmd.arguments().takeFirst();
+	if (sfIndexStr.toUpper() == OPTION_LAST)
 	{
-		return cmd.error(QObject::tr("Invalid parameter: number of neighbors (%1)").arg(knnStr));
+		sfIndex = -2;
 	}
-	
-	if (cmd.clouds().empty())
+	else
 	{
-		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
+		sfIndex = sfIndexStr.toInt(&ok);
+	}
+	if (!ok || sfIndex == -1)
+	{
+		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SET_ACTIVE_SF));
 	}
+	cmd.print(QObject::tr("Set active S.F. index: %1").arg(sfIndex));
 	
-	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
-	if (!cmd.silentMode())
+	if (cmd.clouds().empty())
 	{
-		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
-		progressDialog->setAutoClose(false);
+		return cmd.error(QObject::tr("No point cloud loaded! (be sure to open one with \"-%1 [cloud filename]\" before \"-%2\")").arg(COMMAND_OPEN, COMMAND_SET_ACTIVE_SF));
 	}
 	
-	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	for (size_t i = 0; i<cmd.clouds().size(); ++i)
 	{
-		ccPointCloud* cloud = cmd.clouds()[i].pc;
-		assert(cloud);
-		
-		if (!cloud->hasNormals())
-		{
-			continue;
-		}
-		
-		//computation
-		if (cloud->orientNormalsWithMST(knn, progressDialog.data()))
+		if (cmd.clouds()[i].pc && cmd.clouds()[i].pc->hasScalarFields())
 		{
-			cmd.clouds()[i].basename += QObject::tr("_NORMS_REORIENTED");
-			if (cmd.autoSaveMode())
+			if (sfIndex < static_cast<int>(cmd.clouds()[i].pc->getNumberOfScalarFields()))
 			{
-				QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
-				if (!errorStr.isEmpty())
-				{
-					cmd.warning(errorStr);
-				}
+				cmd.clouds()[i].pc->setCurrentScalarField(sfIndex < 0 ? static_cast<int>(cmd.clouds()[i].pc->getNumberOfScalarFields()) - 1 : sfIndex);
+			}
+			else
+			{
+				cmd.warning(QObject::tr("Cloud '%1' has less scalar fields than the index to select!").arg(cmd.clouds()[i].pc->getName()));
 			}
 		}
-		else
-		{
-			return cmd.error(QObject::tr("Failed to orient the normals of cloud '%1'!").arg(cloud->getName()));
-		}
-	}
-	
-	if (progressDialog)
-	{
-		progressDialog->close();
-		QCoreApplication::processEvents();
 	}
 	
 	return true;
 }
 
-CommandSORFilter::CommandSORFilter()
-	: ccCommandLineInterface::Command(QObject::tr("S.O.R. filter"), COMMAND_SOR_FILTER)
+CommandRemoveAllSF::CommandRemoveAllSF()
+	: ccCommandLineInterface::Command(QObject::tr("Remove all SF"), COMMAND_REMOVE_ALL_SFS)
 {}
 
-bool CommandSORFilter::process(ccCommandLineInterface &cmd)
+bool CommandRemoveAllSF::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[SOR FILTER]"));
-	
-	if (cmd.arguments().empty())
-	{
-		return cmd.error(QObject::tr("Missing parameter: number of neighbors mode after \"-%1\"").arg(COMMAND_SOR_FILTER));
-	}
-	
-	QString knnStr = cmd.arguments().takeFirst();
-	bool ok;
-	int knn = knnStr.toInt(&ok);
-	if (!ok || knn <= 0)
-	{
-		return cmd.error(QObject::tr("Invalid parameter: number of neighbors (%1)").arg(knnStr));
-	}
-	
-	if (cmd.arguments().empty())
-	{
-		return cmd.error(QObject::tr("Missing parameter: sigma multiplier after number of neighbors (SOR)"));
-	}
-	QString sigmaStr = cmd.arguments().takeFirst();
-	double nSigma = sigmaStr.toDouble(&ok);
-	if (!ok || nSigma < 0)
-	{
-		return cmd.error(QObject::tr("Invalid parameter: sigma multiplier (%1)").arg(nSigma));
-	}
-	
-	if (cmd.clouds().empty())
-	{
-		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
-	}
-	
-	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
-	if (!cmd.silentMode())
+	//no argument required
+	for (auto &cloudDesc : cmd.clouds())
 	{
-		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
-		progressDialog->setAutoClose(false);
+		if (cloudDesc.pc/* && cmd.clouds()[i].pc->hasScalarFields()*/)
+		{
+			cloudDesc.pc->deleteAllScalarFields();
+			cloudDesc.pc->showSF(false);
+		}
 	}
 	
-	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	for (auto &meshDesc : cmd.meshes())
 	{
-		ccPointCloud* cloud = cmd.clouds()[i].pc;
-		assert(cloud);
-		
-		//computation
-		CCCoreLib::ReferenceCloud* selection = CCCoreLib::CloudSamplingTools::sorFilter(cloud,
-																				knn,
-																				nSigma,
-																				nullptr,
-																				progressDialog.data());
-		
-		if (selection)
+		if (meshDesc.mesh)
 		{
-			ccPointCloud* cleanCloud = cloud->partialClone(selection);
-			if (cleanCloud)
-			{
-				cleanCloud->setName(cloud->getName() + QObject::tr(".clean"));
-				if (cmd.autoSaveMode())
-				{
-					CLCloudDesc cloudDesc(cleanCloud, cmd.clouds()[i].basename, cmd.clouds()[i].path, cmd.clouds()[i].indexInFile);
-					QString errorStr = cmd.exportEntity(cloudDesc, "SOR");
-					if (!errorStr.isEmpty())
-					{
-						delete cleanCloud;
-						return cmd.error(errorStr);
-					}
-				}
-				//replace current cloud by this one
-				delete cmd.clouds()[i].pc;
-				cmd.clouds()[i].pc = cleanCloud;
-				cmd.clouds()[i].basename += QObject::tr("_SOR");
-				//delete cleanCloud;
-				//cleanCloud = 0;
-			}
-			else
+			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
+			if (cloud->isA(CC_TYPES::POINT_CLOUD))
 			{
-				return cmd.error(QObject::tr("Not enough memory to create a clean version of cloud '%1'!").arg(cloud->getName()));
+				static_cast<ccPointCloud*>(cloud)->deleteAllScalarFields();
+				cloud->showSF(false);
 			}
-			
-			delete selection;
-			selection = nullptr;
-		}
-		else
-		{
-			//no points fall inside selection!
-			return cmd.error(QObject::tr("Failed to apply SOR filter on cloud '%1'! (empty output or not enough memory?)").arg(cloud->getName()));
 		}
 	}
 	
-	if (progressDialog)
-	{
-		progressDialog->close();
-		QCoreApplication::processEvents();
-	}
-	
 	return true;
 }
 
-CommandNoiseFilter::CommandNoiseFilter()
-	: ccCommandLineInterface::Command(QObject::tr("Noise filter"), COMMAND_NOISE_FILTER)
+CommandRemoveRGB::CommandRemoveRGB()
+	: ccCommandLineInterface::Command(QObject::tr("Remove RGB"), COMMAND_REMOVE_RGB)
 {}
 
-bool CommandNoiseFilter::process(ccCommandLineInterface &cmd)
+bool CommandRemoveRGB::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[NOISE FILTER]"));
-
-	if (cmd.arguments().size() < 4)
+	//no argument required
+	for (auto &cloudDesc : cmd.clouds())
 	{
-		return cmd.error(QObject::tr("Missing parameters: 'KNN/RADIUS {value} REL/ABS {value}' expected after \"-%1\"").arg(COMMAND_NOISE_FILTER));
+		if (cloudDesc.pc)
+		{
+			cloudDesc.pc->unallocateColors();
+			cloudDesc.pc->showColors(false);
+		}
 	}
 
-	QString firstOption = cmd.arguments().takeFirst().toUpper();
-	int knn = -1;
-	double radius = std::numeric_limits<double>::quiet_NaN();
-
-	if (firstOption == COMMAND_NOISE_FILTER_KNN)
+	for (auto &meshDesc : cmd.meshes())
 	{
-		QString knnStr = cmd.arguments().takeFirst();
-		bool ok;
-		knn = knnStr.toInt(&ok);
-		if (!ok || knn <= 0)
+		if (meshDesc.mesh)
 		{
-			return cmd.error(QObject::tr("Invalid parameter: number of neighbors after KNN (got '%1' instead)").arg(knnStr));
+			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
+			if (cloud->isA(CC_TYPES::POINT_CLOUD))
+			{
+				static_cast<ccPointCloud*>(cloud)->unallocateColors();
+				cloud->showColors(false);
+			}
+			meshDesc.mesh->showColors(false);
 		}
 	}
-	else if(firstOption == COMMAND_NOISE_FILTER_RADIUS)
+
+	return true;
+}
+
+CommandRemoveNormals::CommandRemoveNormals()
+	: ccCommandLineInterface::Command(QObject::tr("Remove normals"), COMMAND_REMOVE_NORMALS)
+{}
+
+bool CommandRemoveNormals::process(ccCommandLineInterface &cmd)
+{
+	//no argument required
+	for (auto &cloudDesc : cmd.clouds())
 	{
-		QString radiusStr = cmd.arguments().takeFirst();
-		bool ok;
-		radius = radiusStr.toDouble(&ok);
-		if (!ok || radius <= 0)
+		if (cloudDesc.pc)
 		{
-			return cmd.error(QObject::tr("Invalid parameter: radius after RADIUS (got '%1' instead)").arg(radiusStr));
+			cloudDesc.pc->unallocateNorms();
+			cloudDesc.pc->showNormals(false);
 		}
 	}
-	else
-	{
-		return cmd.error(QObject::tr("Invalid parameter: KNN or RADIUS expected after \"-%1\"").arg(COMMAND_NOISE_FILTER));
-	}
-
-	QString secondOption = cmd.arguments().takeFirst().toUpper();
-	bool absoluteError = true;
-	if (secondOption == COMMAND_NOISE_FILTER_REL)
-	{
-		absoluteError = false;
-	}
-	else if (secondOption == COMMAND_NOISE_FILTER_ABS)
-	{
-		absoluteError = true;
-	}
-	else
-	{
-		return cmd.error(QObject::tr("Invalid parameter: REL or ABS expected"));
-	}
-
-	double error = std::numeric_limits<double>::quiet_NaN();
-	{
-		QString errorStr = cmd.arguments().takeFirst();
-		bool ok;
-		error = errorStr.toDouble(&ok);
-		if (!ok || error <= 0)
-		{
-			return cmd.error(QObject::tr("Invalid parameter: relative or absolute error expected after KNN (got '%1' instead)").arg(errorStr));
-		}
-	}
-
-	//optional arguments
-	bool removeIsolatedPoints = false;
-	if (!cmd.arguments().empty())
-	{
-		QString argument = cmd.arguments().front();
-		if (argument == COMMAND_NOISE_FILTER_RIP)
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			removeIsolatedPoints = true;
-		}
-	}
-
-	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
-	if (!cmd.silentMode())
-	{
-		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
-		progressDialog->setAutoClose(false);
-	}
 
-	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	for (auto &meshDesc : cmd.meshes())
 	{
-		ccPointCloud* cloud = cmd.clouds()[i].pc;
-		assert(cloud);
-
-		//computation
-		CCCoreLib::ReferenceCloud* selection = CCCoreLib::CloudSamplingTools::noiseFilter(cloud,
-			static_cast<PointCoordinateType>(radius),
-			error,
-			removeIsolatedPoints,
-			knn > 0,
-			knn,
-			absoluteError,
-			error,
-			nullptr,
-			progressDialog.data());
-
-		if (selection)
+		if (meshDesc.mesh)
 		{
-			ccPointCloud* cleanCloud = cloud->partialClone(selection);
-			if (cleanCloud)
+			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
+			if (cloud->isA(CC_TYPES::POINT_CLOUD))
 			{
-				cleanCloud->setName(cloud->getName() + QObject::tr(".clean"));
-				if (cmd.autoSaveMode())
-				{
-					CLCloudDesc cloudDesc(cleanCloud, cmd.clouds()[i].basename, cmd.clouds()[i].path, cmd.clouds()[i].indexInFile);
-					QString errorStr = cmd.exportEntity(cloudDesc, "DENOISED");
-					if (!errorStr.isEmpty())
-					{
-						delete cleanCloud;
-						return cmd.error(errorStr);
-					}
-				}
-				//replace current cloud by this one
-				delete cmd.clouds()[i].pc;
-				cmd.clouds()[i].pc = cleanCloud;
-				cmd.clouds()[i].basename += QObject::tr("_DENOISED");
-				//delete cleanCloud;
-				//cleanCloud = 0;
+				static_cast<ccPointCloud*>(cloud)->unallocateNorms();
+				cloud->showNormals(false);
 			}
-			else
+			if (meshDesc.mesh->isA(CC_TYPES::MESH))
 			{
-				return cmd.error(QObject::tr("Not enough memory to create a clean version of cloud '%1'!").arg(cloud->getName()));
+				static_cast<ccMesh*>(meshDesc.mesh)->clearTriNormals();
+				meshDesc.mesh->showNormals(false);
 			}
-
-			delete selection;
-			selection = nullptr;
-		}
-		else
-		{
-			//no points fall inside selection!
-			return cmd.error(QObject::tr("Failed to apply Noise filter on cloud '%1'! (empty output or not enough memory?)").arg(cloud->getName()));
 		}
 	}
 
-	if (progressDialog)
-	{
-		progressDialog->close();
-		QCoreApplication::processEvents();
-	}
-
 	return true;
 }
 
-CommandExtractVertices::CommandExtractVertices()
-	: ccCommandLineInterface::Command(QObject::tr("Extract vertices (as a standalone 'cloud')"), COMMAND_EXTRACT_VERTICES)
+CommandRemoveScanGrids::CommandRemoveScanGrids()
+	: ccCommandLineInterface::Command(QObject::tr("Remove scan grids"), COMMAND_REMOVE_SCAN_GRIDS)
 {}
 
-bool CommandExtractVertices::process(ccCommandLineInterface &cmd)
+bool CommandRemoveScanGrids::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[EXTRACT VERTICES]"));
-	
-	if (cmd.meshes().empty())
+	//no argument required
+	for (CLCloudDesc& cloudDesc : cmd.clouds())
 	{
-		cmd.warning(QObject::tr("No mesh available. Be sure to open one first!"));
-		return false;
+		if (cloudDesc.pc)
+		{
+			cloudDesc.pc->removeGrids();
+		}
 	}
 	
-	for (size_t i = 0; i < cmd.meshes().size(); ++i)
+	for (CLMeshDesc& meshDesc : cmd.meshes())
 	{
-		ccGenericMesh* mesh = cmd.meshes()[i].mesh;
-		ccGenericPointCloud* cloud = mesh->getAssociatedCloud();
-		ccPointCloud* pc = ccHObjectCaster::ToPointCloud(cloud);
-		if (!pc)
-		{
-			assert(false);
-			continue;
-		}
-		
-		//add the resulting cloud to the main set
-		cmd.clouds().emplace_back(pc, cmd.meshes()[i].basename + QObject::tr(".vertices"), cmd.meshes()[i].path);
-		
-		//don't forget to detach the cloud before we delete the meshes!
-		assert(pc->getParent() == mesh);
-		if (pc->getParent())
-		{
-			pc->getParent()->detachChild(pc);
-		}
-		
-		//save it as well
-		if (cmd.autoSaveMode())
+		if (meshDesc.mesh)
 		{
-			QString errorStr = cmd.exportEntity(cmd.clouds().back());
-			if (!errorStr.isEmpty())
+			ccGenericPointCloud* cloud = meshDesc.mesh->getAssociatedCloud();
+			if (cloud->isA(CC_TYPES::POINT_CLOUD))
 			{
-				return cmd.error(errorStr);
+				static_cast<ccPointCloud*>(cloud)->removeGrids();
 			}
 		}
 	}
 	
-	cmd.removeMeshes(false);
-	
 	return true;
 }
 
-CommandSampleMesh::CommandSampleMesh()
-	: ccCommandLineInterface::Command(QObject::tr("Sample mesh"), COMMAND_SAMPLE_MESH)
+CommandMatchBBCenters::CommandMatchBBCenters()
+	: ccCommandLineInterface::Command(QObject::tr("Match B.B. centers"), COMMAND_MATCH_BB_CENTERS)
 {}
 
-bool CommandSampleMesh::process(ccCommandLineInterface &cmd)
+bool CommandMatchBBCenters::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[SAMPLE POINTS ON MESH]"));
-	
-	if (cmd.arguments().empty())
-	{
-		return cmd.error(QObject::tr("Missing parameter: sampling mode after \"-%1\" (POINTS/DENSITY)").arg(COMMAND_SAMPLE_MESH));
-	}
-	
-	bool useDensity = false;
-	double parameter = 0;
-	
-	QString sampleMode = cmd.arguments().takeFirst().toUpper();
-	if (sampleMode == "POINTS")
-	{
-		useDensity = false;
-	}
-	else if (sampleMode == "DENSITY")
-	{
-		useDensity = true;
-	}
-	else
-	{
-		return cmd.error(QObject::tr("Invalid parameter: unknown sampling mode \"%1\"").arg(sampleMode));
-	}
+	cmd.print(QObject::tr("[MATCH B.B. CENTERS]"));
 	
-	if (cmd.arguments().empty())
+	std::vector<CLEntityDesc*> entities;
+	for (auto& cloud : cmd.clouds())
 	{
-		return cmd.error(QObject::tr("Missing parameter: value after sampling mode"));
+		entities.push_back(&cloud);
 	}
-	bool conversionOk = false;
-	parameter = cmd.arguments().takeFirst().toDouble(&conversionOk);
-	if (!conversionOk)
+	for (auto& mesh : cmd.meshes())
 	{
-		return cmd.error(QObject::tr("Invalid parameter: value after sampling mode"));
+		entities.push_back(&mesh);
 	}
 	
-	if (cmd.meshes().empty())
+	if (entities.empty())
 	{
-		return cmd.error(QObject::tr("No mesh available. Be sure to open one first!"));
+		return cmd.error("No entity loaded!");
 	}
-	
-	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
-	if (!cmd.silentMode())
+	else if (entities.size() == 1)
 	{
-		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
-		progressDialog->setAutoClose(false);
+		cmd.warning("Nothing to do: only one entity currently loaded!");
+		return true;
 	}
 	
-	for (size_t i = 0; i < cmd.meshes().size(); ++i)
+	CCVector3 firstCenter = entities.front()->getEntity()->getOwnBB().getCenter();
+	for (size_t i = 1; i < entities.size(); ++i)
 	{
-		ccPointCloud* cloud = cmd.meshes()[i].mesh->samplePoints(useDensity, parameter, true, true, true, progressDialog.data());
-		
-		if (!cloud)
-		{
-			return cmd.error(QObject::tr("Cloud sampling failed!"));
-		}
+		ccHObject* ent = entities[i]->getEntity();
+		CCVector3 center = ent->getOwnBB().getCenter();
+		CCVector3 T = firstCenter - center;
 		
-		//add the resulting cloud to the main set
-		cmd.print(QObject::tr("Sampled cloud created: %1 points").arg(cloud->size()));
-		cmd.clouds().emplace_back(cloud, cmd.meshes()[i].basename + QObject::tr("_SAMPLED_POINTS"), cmd.meshes()[i].path);
+		//transformation (used only for translation)
+		ccGLMatrix glTrans;
+		glTrans += T;
 		
-		//save it as well
+		//apply translation matrix
+		ent->applyGLTransformation_recursive(&glTrans);
+		cmd.print(QObject::tr("Entity '%1' has been translated: (%2,%3,%4)").arg(ent->getName()).arg(T.x).arg(T.y).arg(T.z));
 		if (cmd.autoSaveMode())
 		{
-			QString errorStr = cmd.exportEntity(cmd.clouds().back());
+			QString errorStr = cmd.exportEntity(*entities[i]);
 			if (!errorStr.isEmpty())
 			{
 				return cmd.error(errorStr);
@@ -3036,227 +2927,825 @@ bool CommandSampleMesh::process(ccCommandLineInterface &cmd)
 		}
 	}
 	
-	if (progressDialog)
-	{
-		progressDialog->close();
-		QCoreApplication::processEvents();
-	}
-	
 	return true;
 }
 
-CommandCrop::CommandCrop()
-	: ccCommandLineInterface::Command(QObject::tr("Crop"), COMMAND_CROP)
+CommandMatchBestFitPlane::CommandMatchBestFitPlane()
+	: ccCommandLineInterface::Command(QObject::tr("Match best fit plane"), COMMAND_BEST_FIT_PLANE)
 {}
 
-bool CommandCrop::process(ccCommandLineInterface &cmd)
+bool CommandMatchBestFitPlane::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[CROP]"));
+	cmd.print(QObject::tr("[COMPUTE BEST FIT PLANE]"));
 	
-	if (cmd.arguments().empty())
-	{
-		return cmd.error(QObject::tr("Missing parameter: box extents after \"-%1\" (Xmin:Ymin:Zmin:Xmax:Ymax:Zmax)").arg(COMMAND_CROP));
-	}
-	if (cmd.clouds().empty() && cmd.meshes().empty())
-	{
-		return cmd.error(QObject::tr("No point cloud or mesh available. Be sure to open or generate one first!"));
-	}
-	
-	//decode box extents
-	CCVector3 boxMin;
-	CCVector3 boxMax;
-	{
-		QString boxBlock = cmd.arguments().takeFirst();
-		QStringList tokens = boxBlock.split(':');
-		if (tokens.size() != 6)
-		{
-			return cmd.error(QObject::tr("Invalid parameter: box extents (expected format is 'Xmin:Ymin:Zmin:Xmax:Ymax:Zmax')").arg(COMMAND_CROP));
-		}
-		
-		for (int i = 0; i < 6; ++i)
-		{
-			CCVector3* vec = (i < 3 ? &boxMin : &boxMax);
-			bool ok = true;
-			vec->u[i % 3] = static_cast<PointCoordinateType>(tokens[i].toDouble(&ok));
-			if (!ok)
-			{
-				return cmd.error(QObject::tr("Invalid parameter: box extents (component #%1 is not a valid number)").arg(i + 1));
-			}
-		}
-	}
+	//look for local options
+	bool makeCloudsHoriz = false;
+	bool keepLoaded = false;
 	
-	//optional parameters
-	bool inside = true;
 	while (!cmd.arguments().empty())
 	{
 		QString argument = cmd.arguments().front();
-		if (ccCommandLineInterface::IsCommand(argument, COMMAND_CROP_OUTSIDE))
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_BEST_FIT_PLANE_MAKE_HORIZ))
 		{
 			//local option confirmed, we can move on
 			cmd.arguments().pop_front();
-			inside = false;
+			
+			makeCloudsHoriz = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_BEST_FIT_PLANE_KEEP_LOADED))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			keepLoaded = true;
 		}
 		else
 		{
-			break;
+			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
 		}
 	}
 	
-	ccBBox cropBox(boxMin, boxMax);
-	//crop clouds
+	if (cmd.clouds().empty())
 	{
-		for (size_t i = 0; i < cmd.clouds().size(); ++i)
+		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
+	}
+	
+	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	{
+		ccPointCloud* pc = cmd.clouds()[i].pc;
+		
+		//try to fit plane
+		double rms = 0.0;
+		ccPlane* pPlane = ccPlane::Fit(pc, &rms);
+		if (pPlane)
 		{
-			ccHObject* croppedCloud = ccCropTool::Crop(cmd.clouds()[i].pc, cropBox, inside);
-			if (croppedCloud)
+			cmd.print(QObject::tr("Plane successfully fitted: rms = %1").arg(rms));
+			
+			CCVector3 N = pPlane->getNormal();
+			CCVector3 C = *CCCoreLib::Neighbourhood(pc).getGravityCenter();
+			
+			CLMeshDesc planeDesc;
+			planeDesc.mesh = pPlane;
+			planeDesc.basename = cmd.clouds()[i].basename;
+			planeDesc.path = cmd.clouds()[i].path;
+			
+			//save plane as a BIN file
+			QString outputFilename;
+			QString errorStr = cmd.exportEntity(planeDesc, "BEST_FIT_PLANE", &outputFilename);
+			if (!errorStr.isEmpty())
 			{
-				delete cmd.clouds()[i].pc;
-				assert(croppedCloud->isA(CC_TYPES::POINT_CLOUD));
-				cmd.clouds()[i].pc = static_cast<ccPointCloud*>(croppedCloud);
-				cmd.clouds()[i].basename += "_CROPPED";
-				if (cmd.autoSaveMode())
-				{
-					QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
-					if (!errorStr.isEmpty())
-					{
-						return cmd.error(errorStr);
-					}
-				}
+				cmd.warning(errorStr);
 			}
-			else
+			
+			//open text file to save plane related information
+			QString txtFilename = QObject::tr("%1/%2_BEST_FIT_PLANE_INFO").arg(cmd.clouds()[i].path, cmd.clouds()[i].basename);
+			if (cmd.addTimestamp())
 			{
-				//otherwise an error message has already been issued
-				delete cmd.clouds()[i].pc;
-				cmd.clouds()[i].pc = nullptr; //will be removed after this loop
-				//cmd.clouds()[i].basename += "_FULLY_CROPPED";
+				txtFilename += QObject::tr("_%1").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh'h'mm"));
 			}
-		}
-
-		//now clean the set of clouds in case some have been 'cropped out'
-		for (auto it = cmd.clouds().begin(); it != cmd.clouds().end(); )
-		{
-			if (it->pc == nullptr)
+			txtFilename += QObject::tr(".txt");
+			QFile txtFile(txtFilename);
+			txtFile.open(QIODevice::WriteOnly | QIODevice::Text);
+			QTextStream txtStream(&txtFile);
+			
+			txtStream << QObject::tr("Filename: %1").arg(outputFilename) << endl;
+			txtStream << QObject::tr("Fitting RMS: %1").arg(rms) << endl;
+			
+			//We always consider the normal with a positive 'Z' by default!
+			if (N.z < 0.0)
 			{
-				it = cmd.clouds().erase(it);
+				N *= -1.0;
 			}
-			else
+			
+			int precision = cmd.numericalPrecision();
+			txtStream << QObject::tr("Normal: (%1,%2,%3)").arg(N.x, 0, 'f', precision).arg(N.y, 0, 'f', precision).arg(N.z, 0, 'f', precision) << endl;
+			
+			//we compute strike & dip by the way
 			{
-				++it;
+				PointCoordinateType dip = 0;
+				PointCoordinateType dipDir = 0;
+				ccNormalVectors::ConvertNormalToDipAndDipDir(N, dip, dipDir);
+				txtStream << ccNormalVectors::ConvertDipAndDipDirToString(dip, dipDir) << endl;
 			}
-		}
-	}
-	
-	//crop meshes
-	{
-		for (size_t i = 0; i < cmd.meshes().size(); ++i)
-		{
-			ccHObject* croppedMesh = ccCropTool::Crop(cmd.meshes()[i].mesh, cropBox, inside);
-			if (croppedMesh)
+			
+			//compute the transformation matrix that would make this normal points towards +Z
+			ccGLMatrix makeZPosMatrix = ccGLMatrix::FromToRotation(N, CCVector3(0, 0, CCCoreLib::PC_ONE));
+			CCVector3 Gt = C;
+			makeZPosMatrix.applyRotation(Gt);
+			makeZPosMatrix.setTranslation(C - Gt);
+			
+			txtStream << "Orientation matrix:" << endl;
+			txtStream << makeZPosMatrix.toString(precision, ' ') << endl;
+			
+			//close the text file
+			txtFile.close();
+			
+			if (keepLoaded)
 			{
-				delete cmd.meshes()[i].mesh;
-				assert(croppedMesh->isA(CC_TYPES::MESH));
-				cmd.meshes()[i].mesh = static_cast<ccMesh*>(croppedMesh);
-				cmd.meshes()[i].basename += "_CROPPED";
+				//add the resulting plane (mesh) to the main set
+				cmd.meshes().push_back(planeDesc);
+			}
+			
+			if (makeCloudsHoriz)
+			{
+				//apply 'horizontal' matrix
+				pc->applyGLTransformation_recursive(&makeZPosMatrix);
+				cmd.print(QObject::tr("Cloud '%1' has been transformed with the above matrix").arg(pc->getName()));
+				cmd.clouds()[i].basename += QObject::tr("_HORIZ");
 				if (cmd.autoSaveMode())
 				{
-					QString errorStr = cmd.exportEntity(cmd.meshes()[i]);
+					QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
 					if (!errorStr.isEmpty())
 					{
-						return cmd.error(errorStr);
+						cmd.warning(errorStr);
 					}
 				}
 			}
-			else
-			{
-				//otherwise an error message has already been issued
-				delete cmd.meshes()[i].mesh;
-				cmd.meshes()[i].mesh = nullptr; //will be removed after this loop
-				//cmd.meshes()[i].basename += "_FULLY_CROPPED";
-			}
 		}
-
-		//now clean the set of meshes in case some have been 'cropped out'
-		for (auto it = cmd.meshes().begin(); it != cmd.meshes().end(); )
+		else
 		{
-			if (it->mesh == nullptr)
-			{
-				it = cmd.meshes().erase(it);
-			}
-			else
-			{
-				++it;
-			}
+			cmd.warning(QObject::tr("Failed to compute best fit plane for cloud '%1'").arg(cmd.clouds()[i].pc->getName()));
 		}
 	}
 	
 	return true;
 }
 
-CommandCoordToSF::CommandCoordToSF()
-	: ccCommandLineInterface::Command(QObject::tr("Crop"), COMMAND_COORD_TO_SF)
+CommandOrientNormalsMST::CommandOrientNormalsMST()
+	: ccCommandLineInterface::Command(QObject::tr("Orient normals"), COMMAND_ORIENT_NORMALS)
 {}
 
-bool CommandCoordToSF::process(ccCommandLineInterface &cmd)
+bool CommandOrientNormalsMST::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[COORD TO SF]"));
+	cmd.print(QObject::tr("[ORIENT NORMALS (MST)]"));
 	
 	if (cmd.arguments().empty())
 	{
-		return cmd.error(QObject::tr("Missing parameter after \"-%1\" (DIMENSION)").arg(COMMAND_COORD_TO_SF));
+		return cmd.error(QObject::tr("Missing parameter: number of neighbors after \"-%1\"").arg(COMMAND_ORIENT_NORMALS));
+	}
+	
+	QString knnStr = cmd.arguments().takeFirst();
+	bool ok;
+	int knn = knnStr.toInt(&ok);
+	if (!ok || knn <= 0)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: number of neighbors (%1)").arg(knnStr));
 	}
+	
 	if (cmd.clouds().empty())
 	{
-		return cmd.error(QObject::tr("No point cloud available. Be sure to open or generate one first!"));
+		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
 	}
 	
-	//dimension
-	bool exportDims[3] = { false, false, false };
-	QString dimStr = cmd.arguments().takeFirst().toUpper();
+	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
+	if (!cmd.silentMode())
 	{
-		if (dimStr == "X")
-		{
-			exportDims[0] = true;
-		}
-		else if (dimStr == "Y")
-		{
-			exportDims[1] = true;
-		}
-		else if (dimStr == "Z")
-		{
-			exportDims[2] = true;
-		}
-		else
-		{
-			return cmd.error(QObject::tr("Invalid parameter: dimension after \"-%1\" (expected: X, Y or Z)").arg(COMMAND_COORD_TO_SF));
-		}
+		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
+		progressDialog->setAutoClose(false);
 	}
 	
-	//now we can export the corresponding coordinate
 	for (size_t i = 0; i < cmd.clouds().size(); ++i)
 	{
-		ccPointCloud* pc = cmd.clouds()[i].pc;
-		if (pc->exportCoordToSF(exportDims))
+		ccPointCloud* cloud = cmd.clouds()[i].pc;
+		assert(cloud);
+		
+		if (!cloud->hasNormals())
 		{
-			cmd.clouds()[i].basename += QObject::tr("_%1_TO_SF").arg(dimStr);
+			continue;
+		}
+		
+		//computation
+		if (cloud->orientNormalsWithMST(knn, progressDialog.data()))
+		{
+			cmd.clouds()[i].basename += QObject::tr("_NORMS_REORIENTED");
 			if (cmd.autoSaveMode())
 			{
 				QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
 				if (!errorStr.isEmpty())
 				{
-					return cmd.error(errorStr);
+					cmd.warning(errorStr);
 				}
 			}
 		}
 		else
 		{
-			return cmd.error(QObject::tr("Failed to export coord. %1 to SF on cloud '%2'!").arg(dimStr, cmd.clouds()[i].pc->getName()));
+			return cmd.error(QObject::tr("Failed to orient the normals of cloud '%1'!").arg(cloud->getName()));
 		}
 	}
 	
-	return true;
-}
-
-CommandCrop2D::CommandCrop2D()
+	if (progressDialog)
+	{
+		progressDialog->close();
+		QCoreApplication::processEvents();
+	}
+	
+	return true;
+}
+
+CommandSORFilter::CommandSORFilter()
+	: ccCommandLineInterface::Command(QObject::tr("S.O.R. filter"), COMMAND_SOR_FILTER)
+{}
+
+bool CommandSORFilter::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[SOR FILTER]"));
+	
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: number of neighbors mode after \"-%1\"").arg(COMMAND_SOR_FILTER));
+	}
+	
+	QString knnStr = cmd.arguments().takeFirst();
+	bool ok;
+	int knn = knnStr.toInt(&ok);
+	if (!ok || knn <= 0)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: number of neighbors (%1)").arg(knnStr));
+	}
+	
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: sigma multiplier after number of neighbors (SOR)"));
+	}
+	QString sigmaStr = cmd.arguments().takeFirst();
+	double nSigma = sigmaStr.toDouble(&ok);
+	if (!ok || nSigma < 0)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: sigma multiplier (%1)").arg(nSigma));
+	}
+	
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud available. Be sure to open one first!"));
+	}
+	
+	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
+	if (!cmd.silentMode())
+	{
+		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
+		progressDialog->setAutoClose(false);
+	}
+	
+	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	{
+		ccPointCloud* cloud = cmd.clouds()[i].pc;
+		assert(cloud);
+		
+		//computation
+		CCCoreLib::ReferenceCloud* selection = CCCoreLib::CloudSamplingTools::sorFilter(cloud,
+																				knn,
+																				nSigma,
+																				nullptr,
+																				progressDialog.data());
+		
+		if (selection)
+		{
+			ccPointCloud* cleanCloud = cloud->partialClone(selection);
+			if (cleanCloud)
+			{
+				cleanCloud->setName(cloud->getName() + QObject::tr(".clean"));
+				if (cmd.autoSaveMode())
+				{
+					CLCloudDesc cloudDesc(cleanCloud, cmd.clouds()[i].basename, cmd.clouds()[i].path, cmd.clouds()[i].indexInFile);
+					QString errorStr = cmd.exportEntity(cloudDesc, "SOR");
+					if (!errorStr.isEmpty())
+					{
+						delete cleanCloud;
+						return cmd.error(errorStr);
+					}
+				}
+				//replace current cloud by this one
+				delete cmd.clouds()[i].pc;
+				cmd.clouds()[i].pc = cleanCloud;
+				cmd.clouds()[i].basename += QObject::tr("_SOR");
+				//delete cleanCloud;
+				//cleanCloud = 0;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Not enough memory to create a clean version of cloud '%1'!").arg(cloud->getName()));
+			}
+			
+			delete selection;
+			selection = nullptr;
+		}
+		else
+		{
+			//no points fall inside selection!
+			return cmd.error(QObject::tr("Failed to apply SOR filter on cloud '%1'! (empty output or not enough memory?)").arg(cloud->getName()));
+		}
+	}
+	
+	if (progressDialog)
+	{
+		progressDialog->close();
+		QCoreApplication::processEvents();
+	}
+	
+	return true;
+}
+
+CommandNoiseFilter::CommandNoiseFilter()
+	: ccCommandLineInterface::Command(QObject::tr("Noise filter"), COMMAND_NOISE_FILTER)
+{}
+
+bool CommandNoiseFilter::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[NOISE FILTER]"));
+
+	if (cmd.arguments().size() < 4)
+	{
+		return cmd.error(QObject::tr("Missing parameters: 'KNN/RADIUS {value} REL/ABS {value}' expected after \"-%1\"").arg(COMMAND_NOISE_FILTER));
+	}
+
+	QString firstOption = cmd.arguments().takeFirst().toUpper();
+	int knn = -1;
+	double radius = std::numeric_limits<double>::quiet_NaN();
+
+	if (firstOption == COMMAND_NOISE_FILTER_KNN)
+	{
+		QString knnStr = cmd.arguments().takeFirst();
+		bool ok;
+		knn = knnStr.toInt(&ok);
+		if (!ok || knn <= 0)
+		{
+			return cmd.error(QObject::tr("Invalid parameter: number of neighbors after KNN (got '%1' instead)").arg(knnStr));
+		}
+	}
+	else if(firstOption == COMMAND_NOISE_FILTER_RADIUS)
+	{
+		QString radiusStr = cmd.arguments().takeFirst();
+		bool ok;
+		radius = radiusStr.toDouble(&ok);
+		if (!ok || radius <= 0)
+		{
+			return cmd.error(QObject::tr("Invalid parameter: radius after RADIUS (got '%1' instead)").arg(radiusStr));
+		}
+	}
+	else
+	{
+		return cmd.error(QObject::tr("Invalid parameter: KNN or RADIUS expected after \"-%1\"").arg(COMMAND_NOISE_FILTER));
+	}
+
+	QString secondOption = cmd.arguments().takeFirst().toUpper();
+	bool absoluteError = true;
+	if (secondOption == COMMAND_NOISE_FILTER_REL)
+	{
+		absoluteError = false;
+	}
+	else if (secondOption == COMMAND_NOISE_FILTER_ABS)
+	{
+		absoluteError = true;
+	}
+	else
+	{
+		return cmd.error(QObject::tr("Invalid parameter: REL or ABS expected"));
+	}
+
+	double error = std::numeric_limits<double>::quiet_NaN();
+	{
+		QString errorStr = cmd.arguments().takeFirst();
+		bool ok;
+		error = errorStr.toDouble(&ok);
+		if (!ok || error <= 0)
+		{
+			return cmd.error(QObject::tr("Invalid parameter: relative or absolute error expected after KNN (got '%1' instead)").arg(errorStr));
+		}
+	}
+
+	//optional arguments
+	bool removeIsolatedPoints = false;
+	if (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (argument == COMMAND_NOISE_FILTER_RIP)
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			removeIsolatedPoints = true;
+		}
+	}
+
+	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
+	if (!cmd.silentMode())
+	{
+		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
+		progressDialog->setAutoClose(false);
+	}
+
+	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	{
+		ccPointCloud* cloud = cmd.clouds()[i].pc;
+		assert(cloud);
+
+		//computation
+		CCCoreLib::ReferenceCloud* selection = CCCoreLib::CloudSamplingTools::noiseFilter(cloud,
+			static_cast<PointCoordinateType>(radius),
+			error,
+			removeIsolatedPoints,
+			knn > 0,
+			knn,
+			absoluteError,
+			error,
+			nullptr,
+			progressDialog.data());
+
+		if (selection)
+		{
+			ccPointCloud* cleanCloud = cloud->partialClone(selection);
+			if (cleanCloud)
+			{
+				cleanCloud->setName(cloud->getName() + QObject::tr(".clean"));
+				if (cmd.autoSaveMode())
+				{
+					CLCloudDesc cloudDesc(cleanCloud, cmd.clouds()[i].basename, cmd.clouds()[i].path, cmd.clouds()[i].indexInFile);
+					QString errorStr = cmd.exportEntity(cloudDesc, "DENOISED");
+					if (!errorStr.isEmpty())
+					{
+						delete cleanCloud;
+						return cmd.error(errorStr);
+					}
+				}
+				//replace current cloud by this one
+				delete cmd.clouds()[i].pc;
+				cmd.clouds()[i].pc = cleanCloud;
+				cmd.clouds()[i].basename += QObject::tr("_DENOISED");
+				//delete cleanCloud;
+				//cleanCloud = 0;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Not enough memory to create a clean version of cloud '%1'!").arg(cloud->getName()));
+			}
+
+			delete selection;
+			selection = nullptr;
+		}
+		else
+		{
+			//no points fall inside selection!
+			return cmd.error(QObject::tr("Failed to apply Noise filter on cloud '%1'! (empty output or not enough memory?)").arg(cloud->getName()));
+		}
+	}
+
+	if (progressDialog)
+	{
+		progressDialog->close();
+		QCoreApplication::processEvents();
+	}
+
+	return true;
+}
+
+CommandExtractVertices::CommandExtractVertices()
+	: ccCommandLineInterface::Command(QObject::tr("Extract vertices (as a standalone 'cloud')"), COMMAND_EXTRACT_VERTICES)
+{}
+
+bool CommandExtractVertices::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[EXTRACT VERTICES]"));
+	
+	if (cmd.meshes().empty())
+	{
+		cmd.warning(QObject::tr("No mesh available. Be sure to open one first!"));
+		return false;
+	}
+	
+	for (size_t i = 0; i < cmd.meshes().size(); ++i)
+	{
+		ccGenericMesh* mesh = cmd.meshes()[i].mesh;
+		ccGenericPointCloud* cloud = mesh->getAssociatedCloud();
+		ccPointCloud* pc = ccHObjectCaster::ToPointCloud(cloud);
+		if (!pc)
+		{
+			assert(false);
+			continue;
+		}
+		
+		//add the resulting cloud to the main set
+		cmd.clouds().emplace_back(pc, cmd.meshes()[i].basename + QObject::tr(".vertices"), cmd.meshes()[i].path);
+		
+		//don't forget to detach the cloud before we delete the meshes!
+		assert(pc->getParent() == mesh);
+		if (pc->getParent())
+		{
+			pc->getParent()->detachChild(pc);
+		}
+		
+		//save it as well
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(cmd.clouds().back());
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
+		}
+	}
+	
+	cmd.removeMeshes(false);
+	
+	return true;
+}
+
+CommandSampleMesh::CommandSampleMesh()
+	: ccCommandLineInterface::Command(QObject::tr("Sample mesh"), COMMAND_SAMPLE_MESH)
+{}
+
+bool CommandSampleMesh::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[SAMPLE POINTS ON MESH]"));
+	
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: sampling mode after \"-%1\" (POINTS/DENSITY)").arg(COMMAND_SAMPLE_MESH));
+	}
+	
+	bool useDensity = false;
+	double parameter = 0;
+	
+	QString sampleMode = cmd.arguments().takeFirst().toUpper();
+	if (sampleMode == "POINTS")
+	{
+		useDensity = false;
+	}
+	else if (sampleMode == "DENSITY")
+	{
+		useDensity = true;
+	}
+	else
+	{
+		return cmd.error(QObject::tr("Invalid parameter: unknown sampling mode \"%1\"").arg(sampleMode));
+	}
+	
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: value after sampling mode"));
+	}
+	bool conversionOk = false;
+	parameter = cmd.arguments().takeFirst().toDouble(&conversionOk);
+	if (!conversionOk)
+	{
+		return cmd.error(QObject::tr("Invalid parameter: value after sampling mode"));
+	}
+	
+	if (cmd.meshes().empty())
+	{
+		return cmd.error(QObject::tr("No mesh available. Be sure to open one first!"));
+	}
+	
+	QScopedPointer<ccProgressDialog> progressDialog(nullptr);
+	if (!cmd.silentMode())
+	{
+		progressDialog.reset(new ccProgressDialog(false, cmd.widgetParent()));
+		progressDialog->setAutoClose(false);
+	}
+	
+	for (size_t i = 0; i < cmd.meshes().size(); ++i)
+	{
+		ccPointCloud* cloud = cmd.meshes()[i].mesh->samplePoints(useDensity, parameter, true, true, true, progressDialog.data());
+		
+		if (!cloud)
+		{
+			return cmd.error(QObject::tr("Cloud sampling failed!"));
+		}
+		
+		//add the resulting cloud to the main set
+		cmd.print(QObject::tr("Sampled cloud created: %1 points").arg(cloud->size()));
+		cmd.clouds().emplace_back(cloud, cmd.meshes()[i].basename + QObject::tr("_SAMPLED_POINTS"), cmd.meshes()[i].path);
+		
+		//save it as well
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(cmd.clouds().back());
+			if (!errorStr.isEmpty())
+			{
+				return cmd.error(errorStr);
+			}
+		}
+	}
+	
+	if (progressDialog)
+	{
+		progressDialog->close();
+		QCoreApplication::processEvents();
+	}
+	
+	return true;
+}
+
+CommandCrop::CommandCrop()
+	: ccCommandLineInterface::Command(QObject::tr("Crop"), COMMAND_CROP)
+{}
+
+bool CommandCrop::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[CROP]"));
+	
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter: box extents after \"-%1\" (Xmin:Ymin:Zmin:Xmax:Ymax:Zmax)").arg(COMMAND_CROP));
+	}
+	if (cmd.clouds().empty() && cmd.meshes().empty())
+	{
+		return cmd.error(QObject::tr("No point cloud or mesh available. Be sure to open or generate one first!"));
+	}
+	
+	//decode box extents
+	CCVector3 boxMin;
+	CCVector3 boxMax;
+	{
+		QString boxBlock = cmd.arguments().takeFirst();
+		QStringList tokens = boxBlock.split(':');
+		if (tokens.size() != 6)
+		{
+			return cmd.error(QObject::tr("Invalid parameter: box extents (expected format is 'Xmin:Ymin:Zmin:Xmax:Ymax:Zmax')").arg(COMMAND_CROP));
+		}
+		
+		for (int i = 0; i < 6; ++i)
+		{
+			CCVector3* vec = (i < 3 ? &boxMin : &boxMax);
+			bool ok = true;
+			vec->u[i % 3] = static_cast<PointCoordinateType>(tokens[i].toDouble(&ok));
+			if (!ok)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: box extents (component #%1 is not a valid number)").arg(i + 1));
+			}
+		}
+	}
+	
+	//optional parameters
+	bool inside = true;
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_CROP_OUTSIDE))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			inside = false;
+		}
+		else
+		{
+			break;
+		}
+	}
+	
+	ccBBox cropBox(boxMin, boxMax);
+	//crop clouds
+	{
+		for (size_t i = 0; i < cmd.clouds().size(); ++i)
+		{
+			ccHObject* croppedCloud = ccCropTool::Crop(cmd.clouds()[i].pc, cropBox, inside);
+			if (croppedCloud)
+			{
+				delete cmd.clouds()[i].pc;
+				assert(croppedCloud->isA(CC_TYPES::POINT_CLOUD));
+				cmd.clouds()[i].pc = static_cast<ccPointCloud*>(croppedCloud);
+				cmd.clouds()[i].basename += "_CROPPED";
+				if (cmd.autoSaveMode())
+				{
+					QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
+					if (!errorStr.isEmpty())
+					{
+						return cmd.error(errorStr);
+					}
+				}
+			}
+			else
+			{
+				//otherwise an error message has already been issued
+				delete cmd.clouds()[i].pc;
+				cmd.clouds()[i].pc = nullptr; //will be removed after this loop
+				//cmd.clouds()[i].basename += "_FULLY_CROPPED";
+			}
+		}
+
+		//now clean the set of clouds in case some have been 'cropped out'
+		for (auto it = cmd.clouds().begin(); it != cmd.clouds().end(); )
+		{
+			if (it->pc == nullptr)
+			{
+				it = cmd.clouds().erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+	
+	//crop meshes
+	{
+		for (size_t i = 0; i < cmd.meshes().size(); ++i)
+		{
+			ccHObject* croppedMesh = ccCropTool::Crop(cmd.meshes()[i].mesh, cropBox, inside);
+			if (croppedMesh)
+			{
+				delete cmd.meshes()[i].mesh;
+				assert(croppedMesh->isA(CC_TYPES::MESH));
+				cmd.meshes()[i].mesh = static_cast<ccMesh*>(croppedMesh);
+				cmd.meshes()[i].basename += "_CROPPED";
+				if (cmd.autoSaveMode())
+				{
+					QString errorStr = cmd.exportEntity(cmd.meshes()[i]);
+					if (!errorStr.isEmpty())
+					{
+						return cmd.error(errorStr);
+					}
+				}
+			}
+			else
+			{
+				//otherwise an error message has already been issued
+				delete cmd.meshes()[i].mesh;
+				cmd.meshes()[i].mesh = nullptr; //will be removed after this loop
+				//cmd.meshes()[i].basename += "_FULLY_CROPPED";
+			}
+		}
+
+		//now clean the set of meshes in case some have been 'cropped out'
+		for (auto it = cmd.meshes().begin(); it != cmd.meshes().end(); )
+		{
+			if (it->mesh == nullptr)
+			{
+				it = cmd.meshes().erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+	
+	return true;
+}
+
+CommandCoordToSF::CommandCoordToSF()
+	: ccCommandLineInterface::Command(QObject::tr("Crop"), COMMAND_COORD_TO_SF)
+{}
+
+bool CommandCoordToSF::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[COORD TO SF]"));
+	
+	if (cmd.arguments().empty())
+	{
+		return cmd.error(QObject::tr("Missing parameter after \"-%1\" (DIMENSION)").arg(COMMAND_COORD_TO_SF));
+	}
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No point cloud available. Be sure to open or generate one first!"));
+	}
+	
+	//dimension
+	bool exportDims[3] = { false, false, false };
+	QString dimStr = cmd.arguments().takeFirst().toUpper();
+	{
+		if (dimStr == "X")
+		{
+			exportDims[0] = true;
+		}
+		else if (dimStr == "Y")
+		{
+			exportDims[1] = true;
+		}
+		else if (dimStr == "Z")
+		{
+			exportDims[2] = true;
+		}
+		else
+		{
+			return cmd.error(QObject::tr("Invalid parameter: dimension after \"-%1\" (expected: X, Y or Z)").arg(COMMAND_COORD_TO_SF));
+		}
+	}
+	
+	//now we can export the corresponding coordinate
+	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	{
+		ccPointCloud* pc = cmd.clouds()[i].pc;
+		if (pc->exportCoordToSF(exportDims))
+		{
+			cmd.clouds()[i].basename += QObject::tr("_%1_TO_SF").arg(dimStr);
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cmd.clouds()[i]);
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+		else
+		{
+			return cmd.error(QObject::tr("Failed to export coord. %1 to SF on cloud '%2'!").arg(dimStr, cmd.clouds()[i].pc->getName()));
+		}
+	}
+	
+	return true;
+}
+
+CommandCrop2D::CommandCrop2D()
 	: ccCommandLineInterface::Command(QObject::tr("Crop"), COMMAND_CROP_2D)
 {}
 
@@ -3525,67 +4014,6 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 {
 	cmd.print(QObject::tr("[DISTANCE COMPUTATION]"));
 	
-	//compared cloud
-	CLEntityDesc* compEntity = nullptr;
-	ccHObject* compCloud = nullptr;
-	size_t nextMeshIndex = 0;
-	if (cmd.clouds().empty())
-	{
-		//no cloud loaded
-		if (!m_cloud2meshDist || cmd.meshes().size() < 2)
-		{
-			//we would need at least two meshes
-			return cmd.error(QObject::tr("No point cloud available. Be sure to open or generate one first!"));
-		}
-		else
-		{
-			cmd.warning(QObject::tr("No point cloud available. Will use the first mesh vertices as compared cloud."));
-			compEntity = &(cmd.meshes().front());
-			compCloud = dynamic_cast<ccPointCloud*>(cmd.meshes()[nextMeshIndex++].mesh->getAssociatedCloud());
-			if (!compCloud)
-			{
-				return cmd.error(QObject::tr("Unhandled mesh vertices type"));
-			}
-		}
-	}
-	else //at least two clouds
-	{
-		if (m_cloud2meshDist && cmd.clouds().size() != 1)
-		{
-			cmd.warning(QObject::tr("[C2M] Multiple point clouds loaded! Will take the first one by default."));
-		}
-		compEntity = &(cmd.clouds().front());
-		compCloud = cmd.clouds().front().pc;
-	}
-	assert(compEntity && compCloud);
-	
-	//reference entity
-	ccHObject* refEntity = nullptr;
-	if (m_cloud2meshDist)
-	{
-		if (cmd.meshes().size() <= nextMeshIndex)
-		{
-			return cmd.error(QObject::tr("No mesh available. Be sure to open one first!"));
-		}
-		else if (cmd.meshes().size() != nextMeshIndex + 1)
-		{
-			cmd.warning(QString("Multiple meshes loaded! We take the %1 one by default").arg(nextMeshIndex == 0 ? "first" : "second"));
-		}
-		refEntity = cmd.meshes()[nextMeshIndex].mesh;
-	}
-	else
-	{
-		if (cmd.clouds().size() < 2)
-		{
-			return cmd.error(QObject::tr("Only one point cloud available. Be sure to open or generate a second one before performing C2C distance!"));
-		}
-		else if (cmd.clouds().size() > 2)
-		{
-			cmd.warning(QObject::tr("More than 3 point clouds loaded! We take the second one as reference by default"));
-		}
-		refEntity = cmd.clouds()[1].pc;
-	}
-	
 	//inner loop for Distance computation options
 	bool flipNormals = false;
 	double maxDist = 0.0;
@@ -3597,6 +4025,15 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 	bool useKNN = true;
 	double nSize = 0;
 	
+	//multi-compared mode (C2C only)
+	bool multiMode = false;
+	QStringList comparedFiles;
+	double memoryBudget_MB = 0;
+	QString summaryFilename;
+	
+	//approximate mode (C2C only)
+	double approxMaxError = 0.0;
+	
 	while (!cmd.arguments().empty())
 	{
 		QString argument = cmd.arguments().front();
@@ -3729,14 +4166,85 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 			
 			if (cmd.arguments().empty())
 			{
-				return cmd.error(QObject::tr("Missing parameter: max thread count after '%1'").arg(COMMAND_MAX_THREAD_COUNT));
+				return cmd.error(QObject::tr("Missing parameter: max thread count after '%1'").arg(COMMAND_MAX_THREAD_COUNT));
+			}
+			
+			bool ok;
+			maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
+			if (!ok || maxThreadCount < 0)
+			{
+				return cmd.error(QObject::tr("Invalid thread count! (after %1)").arg(COMMAND_MAX_THREAD_COUNT));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_MULTI))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			multiMode = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_FILES))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			//all the following arguments until the next option are filenames
+			while (!cmd.arguments().empty() && !cmd.arguments().front().startsWith('-'))
+			{
+				comparedFiles << cmd.arguments().takeFirst();
+			}
+			if (comparedFiles.empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: filename(s) after \"-%1\"").arg(COMMAND_C2C_FILES));
+			}
+			multiMode = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_MEM_BUDGET))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: memory budget (in MB) after \"-%1\"").arg(COMMAND_C2C_MEM_BUDGET));
+			}
+			bool conversionOk = false;
+			memoryBudget_MB = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || memoryBudget_MB < 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_C2C_MEM_BUDGET));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_SUMMARY))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: summary filename after \"-%1\"").arg(COMMAND_C2C_SUMMARY));
+			}
+			summaryFilename = cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_C2C_APPROX))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: max error after \"-%1\"").arg(COMMAND_C2C_APPROX));
+			}
+			bool conversionOk = false;
+			approxMaxError = cmd.arguments().takeFirst().toDouble(&conversionOk);
+			if (!conversionOk || approxMaxError <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid parameter: value after \"-%1\"").arg(COMMAND_C2C_APPROX));
 			}
 			
-			bool ok;
-			maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
-			if (!ok || maxThreadCount < 0)
+			if (m_cloud2meshDist)
 			{
-				return cmd.error(QObject::tr("Invalid thread count! (after %1)").arg(COMMAND_MAX_THREAD_COUNT));
+				cmd.warning(QObject::tr("Parameter \"-%1\" ignored: only for C2C distance!").arg(COMMAND_C2C_APPROX));
 			}
 		}
 		else
@@ -3745,6 +4253,90 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 		}
 	}
 	
+	if (multiMode)
+	{
+		if (m_cloud2meshDist)
+		{
+			return cmd.error(QObject::tr("The multi-compared mode is only available for C2C distances"));
+		}
+		
+		ccC2CBatchEngine::Parameters params;
+		params.octreeLevel = static_cast<unsigned char>(octreeLevel);
+		params.maxSearchDist = maxDist;
+		params.splitXYZ = splitXYZ;
+		params.approxMaxError = approxMaxError;
+		if (modelIndex != 0)
+		{
+			params.localModel = static_cast<CCCoreLib::LOCAL_MODEL_TYPES>(modelIndex);
+			params.useSphericalSearchForLocalModel = !useKNN;
+			params.kNNForLocalModel = static_cast<unsigned>(nSize);
+			params.radiusForLocalModel = nSize;
+		}
+		
+		return processMultiC2C(cmd, params, comparedFiles, memoryBudget_MB, summaryFilename, maxThreadCount);
+	}
+	
+	//compared cloud
+	CLEntityDesc* compEntity = nullptr;
+	ccHObject* compCloud = nullptr;
+	size_t nextMeshIndex = 0;
+	if (cmd.clouds().empty())
+	{
+		//no cloud loaded
+		if (!m_cloud2meshDist || cmd.meshes().size() < 2)
+		{
+			//we would need at least two meshes
+			return cmd.error(QObject::tr("No point cloud available. Be sure to open or generate one first!"));
+		}
+		else
+		{
+			cmd.warning(QObject::tr("No point cloud available. Will use the first mesh vertices as compared cloud."));
+			compEntity = &(cmd.meshes().front());
+			compCloud = dynamic_cast<ccPointCloud*>(cmd.meshes()[nextMeshIndex++].mesh->getAssociatedCloud());
+			if (!compCloud)
+			{
+				return cmd.error(QObject::tr("Unhandled mesh vertices type"));
+			}
+		}
+	}
+	else //at least two clouds
+	{
+		if (m_cloud2meshDist && cmd.clouds().size() != 1)
+		{
+			cmd.warning(QObject::tr("[C2M] Multiple point clouds loaded! Will take the first one by default."));
+		}
+		compEntity = &(cmd.clouds().front());
+		compCloud = cmd.clouds().front().pc;
+	}
+	assert(compEntity && compCloud);
+	
+	//reference entity
+	ccHObject* refEntity = nullptr;
+	if (m_cloud2meshDist)
+	{
+		if (cmd.meshes().size() <= nextMeshIndex)
+		{
+			return cmd.error(QObject::tr("No mesh available. Be sure to open one first!"));
+		}
+		else if (cmd.meshes().size() != nextMeshIndex + 1)
+		{
+			cmd.warning(QString("Multiple meshes loaded! We take the %1 one by default").arg(nextMeshIndex == 0 ? "first" : "second"));
+		}
+		refEntity = cmd.meshes()[nextMeshIndex].mesh;
+	}
+	else
+	{
+		if (cmd.clouds().size() < 2)
+		{
+			return cmd.error(QObject::tr("Only one point cloud available. Be sure to open or generate a second one before performing C2C distance!"));
+		}
+		else if (cmd.clouds().size() > 2)
+		{
+			cmd.warning(QObject::tr("More than 3 point clouds loaded! We take the second one as reference by default"));
+		}
+		refEntity = cmd.clouds()[1].pc;
+	}
+	
 	//spawn dialog (virtually) so as to prepare the comparison process
 	ccComparisonDlg compDlg(compCloud,
 							refEntity,
@@ -3804,6 +4396,11 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 				compDlg.lmRadiusDoubleSpinBox->setValue(nSize);
 			}
 		}
+		if (approxMaxError > 0)
+		{
+			compDlg.approxCheckBox->setChecked(true);
+			compDlg.approxMaxErrorSpinBox->setValue(approxMaxError);
+		}
 	}
 	
 	if (!compDlg.computeDistances())
@@ -3819,6 +4416,10 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 	{
 		suffix += QObject::tr("_MAX_DIST_%1").arg(maxDist);
 	}
+	if (approxMaxError > 0 && !m_cloud2meshDist)
+	{
+		suffix += QObject::tr("_APPROX_%1").arg(approxMaxError);
+	}
 	
 	compEntity->basename += suffix;
 	
@@ -3834,6 +4435,192 @@ bool CommandDist::process(ccCommandLineInterface &cmd)
 	return true;
 }
 
+//! Rough estimation of the memory used by a cloud (in bytes)
+static double EstimateCloudMemory(const ccPointCloud* cloud)
+{
+	double bytesPerPoint = sizeof(CCVector3) + cloud->getNumberOfScalarFields() * sizeof(ScalarType);
+	if (cloud->hasColors())
+		bytesPerPoint += sizeof(ccColor::Rgba);
+	if (cloud->hasNormals())
+		bytesPerPoint += sizeof(CompressedNormType);
+	return bytesPerPoint * cloud->size();
+}
+
+bool CommandDist::processMultiC2C(	ccCommandLineInterface& cmd,
+									const ccC2CBatchEngine::Parameters& params,
+									const QStringList& comparedFiles,
+									double memoryBudget_MB,
+									QString summaryFilename,
+									int maxThreadCount)
+{
+	//as with the standard mode, the reference is the second loaded cloud (or the only one if only the files
+	//are compared), all the other clouds (+ the files) are compared with it
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No point cloud available. Be sure to open the reference cloud first!"));
+	}
+	if (cmd.clouds().size() < 2 && comparedFiles.empty())
+	{
+		return cmd.error(QObject::tr("No cloud to compare (expect at least one cloud or one file besides the reference)"));
+	}
+	const size_t referenceIndex = (cmd.clouds().size() > 1 ? 1 : 0);
+	
+	//the reference octree is built only once
+	ccC2CBatchEngine engine;
+	const CLCloudDesc referenceDesc = cmd.clouds()[referenceIndex];
+	if (!engine.setReference(referenceDesc.pc, params, cmd.progressDialog()))
+	{
+		return cmd.error(QObject::tr("Failed to prepare the reference cloud '%1'").arg(referenceDesc.basename));
+	}
+	cmd.print(QObject::tr("Reference: '%1' (octree level: %2)").arg(referenceDesc.basename).arg(engine.getOctreeLevel()));
+	
+	QString suffix("_C2C_DIST");
+	if (params.maxSearchDist > 0)
+	{
+		suffix += QObject::tr("_MAX_DIST_%1").arg(params.maxSearchDist);
+	}
+	
+	QStringList summaryNames;
+	std::vector<ccC2CBatchEngine::Statistics> summaryStats;
+	
+	//processes the clouds with the given indexes
+	//(the clouds loaded from the files are saved and released afterwards)
+	auto processBatch = [&](const std::vector<size_t>& cloudIndexes, bool releaseClouds) -> bool
+	{
+		if (cloudIndexes.empty())
+		{
+			return true;
+		}
+		std::vector<ccPointCloud*> clouds;
+		for (size_t index : cloudIndexes)
+		{
+			clouds.push_back(cmd.clouds()[index].pc);
+		}
+		
+		std::vector<ccC2CBatchEngine::Statistics> stats;
+		if (!engine.computeDistances(clouds, stats, engine.getDefaultSFName(), QString(), maxThreadCount, cmd.progressDialog()))
+		{
+			return cmd.error(QObject::tr("An error occurred during distances computation!"));
+		}
+		
+		for (size_t i = 0; i < clouds.size(); ++i)
+		{
+			CLCloudDesc& desc = cmd.clouds()[cloudIndexes[i]];
+			const ccC2CBatchEngine::Statistics& s = stats[i];
+			summaryNames << desc.basename;
+			summaryStats.push_back(s);
+			
+			if (!s.success)
+			{
+				cmd.warning(QObject::tr("Failed to compute the distances for cloud '%1'").arg(desc.basename));
+				continue;
+			}
+			cmd.print(QObject::tr("Cloud '%1': mean = %2 / std deviation = %3 / max = %4").arg(desc.basename).arg(s.mean).arg(s.stdDev).arg(s.maxDist));
+			
+			desc.pc->setCurrentDisplayedScalarField(desc.pc->getScalarFieldIndexByName(qPrintable(engine.getDefaultSFName())));
+			desc.basename += suffix;
+			
+			//the clouds that will be released are always saved
+			if (cmd.autoSaveMode() || releaseClouds)
+			{
+				QString errorStr = cmd.exportEntity(desc);
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+		
+		if (releaseClouds)
+		{
+			//the released clouds are always the last ones
+			while (cmd.clouds().size() > cloudIndexes.front())
+			{
+				cmd.removeClouds(true);
+			}
+		}
+		
+		return true;
+	};
+	
+	//first the already loaded clouds
+	{
+		std::vector<size_t> cloudIndexes;
+		for (size_t i = 0; i < cmd.clouds().size(); ++i)
+		{
+			if (i != referenceIndex)
+			{
+				cloudIndexes.push_back(i);
+			}
+		}
+		if (!processBatch(cloudIndexes, false))
+		{
+			return false;
+		}
+	}
+	
+	//then the files (loaded by batches, depending on the memory budget)
+	const double memoryBudget = memoryBudget_MB * (1 << 20);
+	const size_t firstFileCloudIndex = cmd.clouds().size();
+	auto fileCloudIndexes = [&]()
+	{
+		std::vector<size_t> cloudIndexes;
+		for (size_t i = firstFileCloudIndex; i < cmd.clouds().size(); ++i)
+		{
+			cloudIndexes.push_back(i);
+		}
+		return cloudIndexes;
+	};
+	double batchMemory = 0;
+	double maxFileMemory = 0; //the footprint of the next file is predicted from the largest one loaded so far
+	for (const QString& filename : comparedFiles)
+	{
+		//process the current batch first if the next file may not fit in the budget (one file at a time without budget)
+		if (	cmd.clouds().size() > firstFileCloudIndex
+			&&	(memoryBudget <= 0 || batchMemory + maxFileMemory > memoryBudget) )
+		{
+			if (!processBatch(fileCloudIndexes(), true))
+			{
+				return false;
+			}
+			batchMemory = 0;
+		}
+		
+		size_t cloudCountBefore = cmd.clouds().size();
+		if (!cmd.importFile(filename))
+		{
+			return cmd.error(QObject::tr("Failed to load file '%1'").arg(filename));
+		}
+		double fileMemory = 0;
+		for (size_t i = cloudCountBefore; i < cmd.clouds().size(); ++i)
+		{
+			fileMemory += EstimateCloudMemory(cmd.clouds()[i].pc);
+		}
+		batchMemory += fileMemory;
+		maxFileMemory = std::max(maxFileMemory, fileMemory);
+	}
+	if (!processBatch(fileCloudIndexes(), true))
+	{
+		return false;
+	}
+	
+	//summary table
+	if (summaryFilename.isEmpty())
+	{
+		summaryFilename = QObject::tr("%1/%2_C2C_SUMMARY").arg(referenceDesc.path, referenceDesc.basename);
+		if (cmd.addTimestamp())
+			summaryFilename += QObject::tr("_%1").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh'h'mm"));
+		summaryFilename += QObject::tr(".csv");
+	}
+	if (!ccC2CBatchEngine::SaveSummary(summaryFilename, summaryNames, summaryStats, cmd.numericalPrecision()))
+	{
+		return cmd.error(QObject::tr("Failed to save the summary table '%1'").arg(summaryFilename));
+	}
+	cmd.print(QObject::tr("Distances summary saved to '%1'").arg(summaryFilename));
+	
+	return true;
+}
+
 CommandC2MDist::CommandC2MDist()
 	: CommandDist(true, QObject::tr("C2M distance"), COMMAND_C2M_DIST)
 {}
@@ -4200,23 +4987,115 @@ bool CommandDelaunayTri::process(ccCommandLineInterface &cmd)
 			mesh->addChild(cloud);
 		}
 	}
-	//mehses have taken ownership of the clouds!
-	cmd.clouds().resize(0);
+	//mehses have taken ownership of the clouds!
+	cmd.clouds().resize(0);
+	
+	return true;
+}
+
+CommandSFArithmetic::CommandSFArithmetic()
+	: ccCommandLineInterface::Command(QObject::tr("SF arithmetic"), COMMAND_SF_ARITHMETIC)
+{}
+
+bool CommandSFArithmetic::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[SF ARITHMETIC]"));
+	
+	if (cmd.arguments().size() < 2)
+	{
+		return cmd.error(QObject::tr("Missing parameter(s): SF index and/or operation after '%1' (2 values expected)").arg(COMMAND_SF_ARITHMETIC));
+	}
+	
+	//read sf index
+	int sfIndex = -1;
+	bool ok = true;
+	QString sfIndexStr = cmd.arguments().takeFirst();
+	if (sfIndexStr.toUpper() == OPTION_LAST)
+	{
+		sfIndex = -2;
+	}
+	else
+	{
+		sfIndex = sfIndexStr.toInt(&ok);
+	}
+	if (!ok || sfIndex == -1)
+	{
+		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SF_ARITHMETIC));
+	}
+	
+	//read operation type
+	ccScalarFieldArithmeticsDlg::Operation operation = ccScalarFieldArithmeticsDlg::INVALID;
+	{
+		QString opName = cmd.arguments().takeFirst();
+		operation = ccScalarFieldArithmeticsDlg::GetOperationByName(opName);
+		if (operation == ccScalarFieldArithmeticsDlg::INVALID)
+		{
+			return cmd.error(QObject::tr("Unknown operation! (%1)").arg(opName));
+		}
+		else if (operation <= ccScalarFieldArithmeticsDlg::DIVIDE)
+		{
+			return cmd.error(QObject::tr("Operation %1 can't be applied with %2").arg(opName, COMMAND_SF_ARITHMETIC));
+		}
+	}
+	
+	//apply operation on clouds
+	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+	{
+		ccPointCloud* cloud = cmd.clouds()[i].pc;
+		if (cloud && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		{
+			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, false))
+			{
+				return cmd.error(QObject::tr("Failed top apply operation on cloud '%1'").arg(cloud->getName()));
+			}
+			else if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cmd.clouds()[i], "SF_ARITHMETIC");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+	
+	//and meshes!
+	for (size_t j = 0; j < cmd.meshes().size(); ++j)
+	{
+		bool isLocked = false;
+		ccGenericMesh* mesh = cmd.meshes()[j].mesh;
+		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(mesh, &isLocked);
+		if (cloud && !isLocked && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		{
+			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, false))
+			{
+				return cmd.error(QObject::tr("Failed top apply operation on mesh '%1'").arg(mesh->getName()));
+			}
+			else if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cmd.meshes()[j], "SF_ARITHMETIC");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
 	
 	return true;
 }
 
-CommandSFArithmetic::CommandSFArithmetic()
-	: ccCommandLineInterface::Command(QObject::tr("SF arithmetic"), COMMAND_SF_ARITHMETIC)
+CommandSFOperation::CommandSFOperation()
+	: ccCommandLineInterface::Command(QObject::tr("SF operation"), COMMAND_SF_OP)
 {}
 
-bool CommandSFArithmetic::process(ccCommandLineInterface &cmd)
+bool CommandSFOperation::process(ccCommandLineInterface &cmd)
 {
-	cmd.print(QObject::tr("[SF ARITHMETIC]"));
+	cmd.print(QObject::tr("[SF OPERATION]"));
 	
-	if (cmd.arguments().size() < 2)
+	if (cmd.arguments().size() < 3)
 	{
-		return cmd.error(QObject::tr("Missing parameter(s): SF index and/or operation after '%1' (2 values expected)").arg(COMMAND_SF_ARITHMETIC));
+		return cmd.error(QObject::tr("Missing parameter(s): SF index and/or operation and/or scalar value after '%1' (3 values expected)").arg(COMMAND_SF_OP));
 	}
 	
 	//read sf index
@@ -4231,9 +5110,10 @@ bool CommandSFArithmetic::process(ccCommandLineInterface &cmd)
 	{
 		sfIndex = sfIndexStr.toInt(&ok);
 	}
+	
 	if (!ok || sfIndex == -1)
 	{
-		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SF_ARITHMETIC));
+		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SF_OP));
 	}
 	
 	//read operation type
@@ -4245,25 +5125,42 @@ bool CommandSFArithmetic::process(ccCommandLineInterface &cmd)
 		{
 			return cmd.error(QObject::tr("Unknown operation! (%1)").arg(opName));
 		}
-		else if (operation <= ccScalarFieldArithmeticsDlg::DIVIDE)
+		else if (operation > ccScalarFieldArithmeticsDlg::DIVIDE)
 		{
-			return cmd.error(QObject::tr("Operation %1 can't be applied with %2").arg(opName, COMMAND_SF_ARITHMETIC));
+			return cmd.error(QObject::tr("Operation %1 can't be applied with %2").arg(opName, COMMAND_SF_OP));
+		}
+	}
+	
+	//read scalar value
+	double value = 1.0;
+	{
+		bool ok = true;
+		value = cmd.arguments().takeFirst().toDouble(&ok);
+		if (!ok)
+		{
+			return cmd.error(QObject::tr("Invalid scalar value! (after %1)").arg(COMMAND_SF_OP));
 		}
 	}
 	
+	ccScalarFieldArithmeticsDlg::SF2 sf2;
+	{
+		sf2.isConstantValue = true;
+		sf2.constantValue = value;
+	}
+	
 	//apply operation on clouds
 	for (size_t i = 0; i < cmd.clouds().size(); ++i)
 	{
 		ccPointCloud* cloud = cmd.clouds()[i].pc;
 		if (cloud && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
 		{
-			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, false))
+			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, true, &sf2))
 			{
 				return cmd.error(QObject::tr("Failed top apply operation on cloud '%1'").arg(cloud->getName()));
 			}
 			else if (cmd.autoSaveMode())
 			{
-				QString errorStr = cmd.exportEntity(cmd.clouds()[i], "SF_ARITHMETIC");
+				QString errorStr = cmd.exportEntity(cmd.clouds()[i], "SF_OP");
 				if (!errorStr.isEmpty())
 				{
 					return cmd.error(errorStr);
@@ -4280,231 +5177,592 @@ bool CommandSFArithmetic::process(ccCommandLineInterface &cmd)
 		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(mesh, &isLocked);
 		if (cloud && !isLocked && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
 		{
-			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, false))
+			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, true, &sf2))
+			{
+				return cmd.error(QObject::tr("Failed top apply operation on mesh '%1'").arg(mesh->getName()));
+			}
+			else if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cmd.meshes()[j], "SF_OP");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+	
+	return true;
+}
+
+
+CommandSFRename::CommandSFRename()
+	: ccCommandLineInterface::Command(QObject::tr("Rename SF"), COMMAND_RENAME_SF)
+{}
+
+bool CommandSFRename::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[RENAME SF]"));
+
+	if (cmd.arguments().size() < 2)
+	{
+		return cmd.error(QObject::tr("Missing parameter(s): SF index and/or scalar field name after '%1' (2 values expected)").arg(COMMAND_RENAME_SF));
+	}
+
+	//read sf index
+	int sfIndex = -1;
+	bool ok = true;
+	QString sfIndexStr = cmd.arguments().takeFirst();
+	if (sfIndexStr.toUpper() == OPTION_LAST)
+	{
+		sfIndex = -2;
+	}
+	else
+	{
+		sfIndex = sfIndexStr.toInt(&ok);
+	}
+
+	if (!ok || sfIndex == -1)
+	{
+		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SF_OP));
+	}
+
+	//read the SF name
+	QString sfName = cmd.arguments().takeFirst();
+
+	//apply operation on clouds
+	for (CLCloudDesc& cloudDesc : cmd.clouds())
+	{
+		ccPointCloud* cloud = cloudDesc.pc;
+		if (cloud && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		{
+			int thisSFIndex = (sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex);
+			int indexOfSFWithSameName = cloud->getScalarFieldIndexByName(qPrintable(sfName));
+			if (indexOfSFWithSameName >= 0 && thisSFIndex != indexOfSFWithSameName)
+			{
+				return cmd.error("A SF with the same name is already defined on cloud " + cloud->getName());
+			}
+			CCCoreLib::ScalarField* sf = cloud->getScalarField(thisSFIndex);
+			if (!sf)
+			{
+				assert(false);
+				return cmd.error("Internal error: invalid SF index");
+			}
+			sf->setName(qPrintable(sfName));
+
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(cloudDesc, "SF_RENAMED");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+
+	//and meshes!
+	for (CLMeshDesc& meshDesc : cmd.meshes())
+	{
+		bool isLocked = false;
+		ccGenericMesh* mesh = meshDesc.mesh;
+		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(mesh, &isLocked);
+		if (cloud && !isLocked && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		{
+			int thisSFIndex = (sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex);
+			int indexOfSFWithSameName = cloud->getScalarFieldIndexByName(qPrintable(sfName));
+			if (indexOfSFWithSameName >= 0 && thisSFIndex != indexOfSFWithSameName)
+			{
+				return cmd.error("A SF with the same name is already defined on cloud " + cloud->getName());
+			}
+			CCCoreLib::ScalarField* sf = cloud->getScalarField(thisSFIndex);
+			if (!sf)
+			{
+				assert(false);
+				return cmd.error("Internal error: invalid SF index");
+			}
+			sf->setName(qPrintable(sfName));
+
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(meshDesc, "SF_RENAMED");
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+CommandSFInterpolation::CommandSFInterpolation()
+	: ccCommandLineInterface::Command(QObject::tr("SF interpolation"), COMMAND_SF_INTERP)
+{}
+
+bool CommandSFInterpolation::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[SF INTERPOLATION]"));
+
+	//look for local options
+	ccPointCloudInterpolator::Parameters params;
+	QStringList sfIndexStrs;
+
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_SF_INTERP_SF))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: SF index after '%1'").arg(COMMAND_SF_INTERP_SF));
+			}
+			sfIndexStrs << cmd.arguments().takeFirst();
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SF_INTERP_METHOD))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: method after \"-%1\" (NN/KNN/RADIUS)").arg(COMMAND_SF_INTERP_METHOD));
+			}
+			QString method = cmd.arguments().takeFirst().toUpper();
+			if (method == "NN")
+			{
+				params.method = ccPointCloudInterpolator::Parameters::NEAREST_NEIGHBOR;
+			}
+			else if (method == "KNN")
+			{
+				params.method = ccPointCloudInterpolator::Parameters::K_NEAREST_NEIGHBORS;
+			}
+			else if (method == "RADIUS")
+			{
+				params.method = ccPointCloudInterpolator::Parameters::RADIUS;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Invalid parameter: unknown interpolation method \"%1\"").arg(method));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SF_INTERP_ALGO))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: algorithm after \"-%1\" (AVERAGE/MEDIAN/GAUSSIAN/IDW)").arg(COMMAND_SF_INTERP_ALGO));
+			}
+			QString algo = cmd.arguments().takeFirst().toUpper();
+			if (algo == "AVERAGE")
+			{
+				params.algo = ccPointCloudInterpolator::Parameters::AVERAGE;
+			}
+			else if (algo == "MEDIAN")
+			{
+				params.algo = ccPointCloudInterpolator::Parameters::MEDIAN;
+			}
+			else if (algo == "GAUSSIAN")
+			{
+				params.algo = ccPointCloudInterpolator::Parameters::NORMAL_DIST;
+			}
+			else if (algo == "IDW")
+			{
+				params.algo = ccPointCloudInterpolator::Parameters::INVERSE_DIST;
+			}
+			else
+			{
+				return cmd.error(QObject::tr("Invalid parameter: unknown interpolation algorithm \"%1\"").arg(algo));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, OPTION_KNN))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: number of neighbors after '%1'").arg(OPTION_KNN));
+			}
+			bool ok;
+			QString arg = cmd.arguments().takeFirst();
+			params.knn = arg.toUInt(&ok);
+			if (!ok || params.knn == 0)
+			{
+				return cmd.error(QObject::tr("Invalid number of neighbors! (%1)").arg(arg));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SF_INTERP_RADIUS))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: radius after '%1'").arg(COMMAND_SF_INTERP_RADIUS));
+			}
+			bool ok;
+			params.radius = cmd.arguments().takeFirst().toFloat(&ok);
+			if (!ok || params.radius <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid radius! (after %1)").arg(COMMAND_SF_INTERP_RADIUS));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SF_INTERP_SIGMA))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: sigma after '%1'").arg(COMMAND_SF_INTERP_SIGMA));
+			}
+			bool ok;
+			params.sigma = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || params.sigma <= 0)
+			{
+				return cmd.error(QObject::tr("Invalid sigma value! (after %1)").arg(COMMAND_SF_INTERP_SIGMA));
+			}
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_SF_INTERP_POWER))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+
+			if (cmd.arguments().empty())
 			{
-				return cmd.error(QObject::tr("Failed top apply operation on mesh '%1'").arg(mesh->getName()));
+				return cmd.error(QObject::tr("Missing parameter: power after '%1'").arg(COMMAND_SF_INTERP_POWER));
 			}
-			else if (cmd.autoSaveMode())
+			bool ok;
+			params.power = cmd.arguments().takeFirst().toDouble(&ok);
+			if (!ok || params.power <= 0)
 			{
-				QString errorStr = cmd.exportEntity(cmd.meshes()[j], "SF_ARITHMETIC");
-				if (!errorStr.isEmpty())
-				{
-					return cmd.error(errorStr);
-				}
+				return cmd.error(QObject::tr("Invalid power value! (after %1)").arg(COMMAND_SF_INTERP_POWER));
 			}
 		}
+		else
+		{
+			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
+		}
 	}
-	
-	return true;
-}
-
-CommandSFOperation::CommandSFOperation()
-	: ccCommandLineInterface::Command(QObject::tr("SF operation"), COMMAND_SF_OP)
-{}
 
-bool CommandSFOperation::process(ccCommandLineInterface &cmd)
-{
-	cmd.print(QObject::tr("[SF OPERATION]"));
-	
-	if (cmd.arguments().size() < 3)
-	{
-		return cmd.error(QObject::tr("Missing parameter(s): SF index and/or operation and/or scalar value after '%1' (3 values expected)").arg(COMMAND_SF_OP));
-	}
-	
-	//read sf index
-	int sfIndex = -1;
-	bool ok = true;
-	QString sfIndexStr = cmd.arguments().takeFirst();
-	if (sfIndexStr.toUpper() == OPTION_LAST)
+	if (params.method == ccPointCloudInterpolator::Parameters::K_NEAREST_NEIGHBORS && params.knn == 0)
 	{
-		sfIndex = -2;
-	}
-	else
-	{
-		sfIndex = sfIndexStr.toInt(&ok);
+		return cmd.error(QObject::tr("The number of neighbors must be set with -%1 (KNN method)").arg(OPTION_KNN));
 	}
-	
-	if (!ok || sfIndex == -1)
+	if (params.method == ccPointCloudInterpolator::Parameters::RADIUS && params.radius <= 0)
 	{
-		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SF_OP));
+		return cmd.error(QObject::tr("The radius must be set with -%1 (RADIUS method)").arg(COMMAND_SF_INTERP_RADIUS));
 	}
-	
-	//read operation type
-	ccScalarFieldArithmeticsDlg::Operation operation = ccScalarFieldArithmeticsDlg::INVALID;
+	if (	params.algo == ccPointCloudInterpolator::Parameters::NORMAL_DIST
+		&&	params.method != ccPointCloudInterpolator::Parameters::NEAREST_NEIGHBOR
+		&&	params.sigma <= 0)
 	{
-		QString opName = cmd.arguments().takeFirst();
-		operation = ccScalarFieldArithmeticsDlg::GetOperationByName(opName);
-		if (operation == ccScalarFieldArithmeticsDlg::INVALID)
+		if (params.method == ccPointCloudInterpolator::Parameters::RADIUS)
 		{
-			return cmd.error(QObject::tr("Unknown operation! (%1)").arg(opName));
+			//same default value as the GUI
+			params.sigma = params.radius / 2.5;
 		}
-		else if (operation > ccScalarFieldArithmeticsDlg::DIVIDE)
+		else
 		{
-			return cmd.error(QObject::tr("Operation %1 can't be applied with %2").arg(opName, COMMAND_SF_OP));
+			//no default value in KNN mode (it depends on the cloud density)
+			return cmd.error(QObject::tr("The sigma value must be set with -%1 (GAUSSIAN algorithm with the KNN method)").arg(COMMAND_SF_INTERP_SIGMA));
 		}
 	}
-	
-	//read scalar value
-	double value = 1.0;
+
+	//the source is the first loaded cloud, all the other clouds are destinations
+	if (cmd.clouds().size() < 2)
 	{
-		bool ok = true;
-		value = cmd.arguments().takeFirst().toDouble(&ok);
-		if (!ok)
-		{
-			return cmd.error(QObject::tr("Invalid scalar value! (after %1)").arg(COMMAND_SF_OP));
-		}
+		return cmd.error(QObject::tr("At least two clouds must be loaded (the first one is the source)"));
 	}
-	
-	ccScalarFieldArithmeticsDlg::SF2 sf2;
+	CLCloudDesc& sourceDesc = cmd.clouds().front();
+	ccPointCloud* source = sourceDesc.pc;
+	if (!source->hasScalarFields())
 	{
-		sf2.isConstantValue = true;
-		sf2.constantValue = value;
+		return cmd.error(QObject::tr("Source cloud '%1' has no scalar field").arg(sourceDesc.basename));
 	}
-	
-	//apply operation on clouds
-	for (size_t i = 0; i < cmd.clouds().size(); ++i)
+
+	std::vector<int> sfIndexes;
+	if (sfIndexStrs.empty())
 	{
-		ccPointCloud* cloud = cmd.clouds()[i].pc;
-		if (cloud && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		//all the scalar fields by default
+		for (unsigned i = 0; i < source->getNumberOfScalarFields(); ++i)
 		{
-			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, true, &sf2))
+			sfIndexes.push_back(static_cast<int>(i));
+		}
+	}
+	else
+	{
+		for (const QString& sfIndexStr : sfIndexStrs)
+		{
+			int sfIndex = -1;
+			if (sfIndexStr.toUpper() == OPTION_LAST)
 			{
-				return cmd.error(QObject::tr("Failed top apply operation on cloud '%1'").arg(cloud->getName()));
+				sfIndex = static_cast<int>(source->getNumberOfScalarFields()) - 1;
 			}
-			else if (cmd.autoSaveMode())
+			else
 			{
-				QString errorStr = cmd.exportEntity(cmd.clouds()[i], "SF_OP");
-				if (!errorStr.isEmpty())
+				bool ok;
+				sfIndex = sfIndexStr.toInt(&ok);
+				if (!ok)
 				{
-					return cmd.error(errorStr);
+					//maybe it's a scalar field name
+					sfIndex = source->getScalarFieldIndexByName(qPrintable(sfIndexStr));
 				}
 			}
+			if (sfIndex < 0 || sfIndex >= static_cast<int>(source->getNumberOfScalarFields()))
+			{
+				return cmd.error(QObject::tr("Invalid SF index or name: %1 (after %2)").arg(sfIndexStr, COMMAND_SF_INTERP_SF));
+			}
+			sfIndexes.push_back(sfIndex);
 		}
 	}
-	
-	//and meshes!
-	for (size_t j = 0; j < cmd.meshes().size(); ++j)
+
+	//the source octree is built once for all the destination clouds
+	ccPointCloudInterpolator::Engine engine;
+	if (!engine.setSource(source, sfIndexes, params, cmd.progressDialog()))
 	{
-		bool isLocked = false;
-		ccGenericMesh* mesh = cmd.meshes()[j].mesh;
-		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(mesh, &isLocked);
-		if (cloud && !isLocked && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		return cmd.error(QObject::tr("Failed to prepare the source cloud '%1'").arg(sourceDesc.basename));
+	}
+
+	for (size_t i = 1; i < cmd.clouds().size(); ++i)
+	{
+		CLCloudDesc& desc = cmd.clouds()[i];
+		if (!engine.interpolateTo(desc.pc, cmd.progressDialog()))
 		{
-			if (!ccScalarFieldArithmeticsDlg::Apply(cloud, operation, sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex, true, &sf2))
-			{
-				return cmd.error(QObject::tr("Failed top apply operation on mesh '%1'").arg(mesh->getName()));
-			}
-			else if (cmd.autoSaveMode())
+			return cmd.error(QObject::tr("Failed to interpolate the scalar field(s) on cloud '%1'").arg(desc.basename));
+		}
+		cmd.print(QObject::tr("%1 scalar field(s) interpolated on cloud '%2'").arg(sfIndexes.size()).arg(desc.basename));
+
+		desc.basename += QObject::tr("_SF_INTERP");
+		if (cmd.autoSaveMode())
+		{
+			QString errorStr = cmd.exportEntity(desc);
+			if (!errorStr.isEmpty())
 			{
-				QString errorStr = cmd.exportEntity(cmd.meshes()[j], "SF_OP");
-				if (!errorStr.isEmpty())
-				{
-					return cmd.error(errorStr);
-				}
+				return cmd.error(errorStr);
 			}
 		}
 	}
-	
+
 	return true;
 }
 
+//! Options shared by the -ICP and -ICP_BATCH commands
+struct ICPCommandOptions
+{
+	bool enableFarthestPointRemoval = false;
+	double minErrorDiff = 1.0e-6;
+	unsigned iterationCount = 0;
+	unsigned randomSamplingLimit = 20000;
+	unsigned overlap = 100;
+	int maxThreadCount = 0;
+	int transformationFilters = 0;
+	//! Whether an ICP engine option has been set
+	bool useEngine = false;
+	ccICPEngine::Options engineOptions;
 
-CommandSFRename::CommandSFRename()
-	: ccCommandLineInterface::Command(QObject::tr("Rename SF"), COMMAND_RENAME_SF)
-{}
+	//! Fills the corresponding registration parameters
+	void toParameters(CCCoreLib::ICPRegistrationTools::Parameters& parameters) const
+	{
+		parameters.convType					= (iterationCount != 0 ? CCCoreLib::ICPRegistrationTools::MAX_ITER_CONVERGENCE : CCCoreLib::ICPRegistrationTools::MAX_ERROR_CONVERGENCE);
+		parameters.minRMSDecrease			= minErrorDiff;
+		parameters.nbMaxIterations			= iterationCount;
+		parameters.filterOutFarthestPoints	= enableFarthestPointRemoval;
+		parameters.samplingLimit			= randomSamplingLimit;
+		parameters.finalOverlapRatio		= overlap / 100.0;
+		parameters.transformationFilters	= transformationFilters;
+		parameters.maxThreadCount			= maxThreadCount;
+	}
+};
 
-bool CommandSFRename::process(ccCommandLineInterface &cmd)
+//! Reads the current argument if it is one of the options shared by the -ICP and -ICP_BATCH commands
+/** \param cmd command line interface
+	\param options options to update
+	\param[out] recognized whether the current argument is a shared option (in which case it is consumed)
+	\return false if the option (or its parameter) is invalid
+**/
+static bool ReadICPOption(ccCommandLineInterface& cmd, ICPCommandOptions& options, bool& recognized)
 {
-	cmd.print(QObject::tr("[RENAME SF]"));
+	recognized = true;
 
-	if (cmd.arguments().size() < 2)
+	QString argument = cmd.arguments().front();
+	if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_ENABLE_FARTHEST_REMOVAL))
 	{
-		return cmd.error(QObject::tr("Missing parameter(s): SF index and/or scalar field name after '%1' (2 values expected)").arg(COMMAND_RENAME_SF));
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		options.enableFarthestPointRemoval = true;
 	}
-
-	//read sf index
-	int sfIndex = -1;
-	bool ok = true;
-	QString sfIndexStr = cmd.arguments().takeFirst();
-	if (sfIndexStr.toUpper() == OPTION_LAST)
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_MIN_ERROR_DIIF))
 	{
-		sfIndex = -2;
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QObject::tr("Missing parameter: min error difference after '%1'").arg(COMMAND_ICP_MIN_ERROR_DIIF));
+		}
+		bool ok;
+		options.minErrorDiff = cmd.arguments().takeFirst().toDouble(&ok);
+		if (!ok || options.minErrorDiff <= 0)
+		{
+			return cmd.error(QObject::tr("Invalid value for min. error difference! (after %1)").arg(COMMAND_ICP_MIN_ERROR_DIIF));
+		}
 	}
-	else
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_ITERATION_COUNT))
 	{
-		sfIndex = sfIndexStr.toInt(&ok);
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QObject::tr("Missing parameter: number of iterations after '%1'").arg(COMMAND_ICP_ITERATION_COUNT));
+		}
+		bool ok;
+		QString arg = cmd.arguments().takeFirst();
+		options.iterationCount = arg.toUInt(&ok);
+		if (!ok || options.iterationCount == 0)
+		{
+			return cmd.error(QObject::tr("Invalid number of iterations! (%1)").arg(arg));
+		}
 	}
-
-	if (!ok || sfIndex == -1)
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_OVERLAP))
 	{
-		return cmd.error(QObject::tr("Invalid SF index! (after %1)").arg(COMMAND_SF_OP));
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QObject::tr("Missing parameter: overlap percentage after '%1'").arg(COMMAND_ICP_OVERLAP));
+		}
+		bool ok;
+		QString arg = cmd.arguments().takeFirst();
+		options.overlap = arg.toUInt(&ok);
+		if (!ok || options.overlap < 10 || options.overlap > 100)
+		{
+			return cmd.error(QObject::tr("Invalid overlap value! (%1 --> should be between 10 and 100)").arg(arg));
+		}
 	}
-
-	//read the SF name
-	QString sfName = cmd.arguments().takeFirst();
-
-	//apply operation on clouds
-	for (CLCloudDesc& cloudDesc : cmd.clouds())
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_RANDOM_SAMPLING_LIMIT))
 	{
-		ccPointCloud* cloud = cloudDesc.pc;
-		if (cloud && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
 		{
-			int thisSFIndex = (sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex);
-			int indexOfSFWithSameName = cloud->getScalarFieldIndexByName(qPrintable(sfName));
-			if (indexOfSFWithSameName >= 0 && thisSFIndex != indexOfSFWithSameName)
-			{
-				return cmd.error("A SF with the same name is already defined on cloud " + cloud->getName());
-			}
-			CCCoreLib::ScalarField* sf = cloud->getScalarField(thisSFIndex);
-			if (!sf)
-			{
-				assert(false);
-				return cmd.error("Internal error: invalid SF index");
-			}
-			sf->setName(qPrintable(sfName));
-
-			if (cmd.autoSaveMode())
-			{
-				QString errorStr = cmd.exportEntity(cloudDesc, "SF_RENAMED");
-				if (!errorStr.isEmpty())
-				{
-					return cmd.error(errorStr);
-				}
-			}
+			return cmd.error(QObject::tr("Missing parameter: random sampling limit value after '%1'").arg(COMMAND_ICP_RANDOM_SAMPLING_LIMIT));
+		}
+		bool ok;
+		options.randomSamplingLimit = cmd.arguments().takeFirst().toUInt(&ok);
+		if (!ok || options.randomSamplingLimit < 3)
+		{
+			return cmd.error(QObject::tr("Invalid random sampling limit! (after %1)").arg(COMMAND_ICP_RANDOM_SAMPLING_LIMIT));
+		}
+	}
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_MAX_THREAD_COUNT))
+	{
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QObject::tr("Missing parameter: max thread count after '%1'").arg(COMMAND_MAX_THREAD_COUNT));
+		}
+		
+		bool ok;
+		options.maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
+		if (!ok || options.maxThreadCount < 0)
+		{
+			return cmd.error(QObject::tr("Invalid thread count! (after %1)").arg(COMMAND_MAX_THREAD_COUNT));
+		}
+	}
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_ROT))
+	{
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QObject::tr("Missing parameter: rotation filter after \"-%1\" (XYZ/X/Y/Z/NONE)").arg(COMMAND_ICP_ROT));
+		}
+		QString rotation = cmd.arguments().takeFirst().toUpper();
+		if (rotation == "XYZ")
+		{
+			options.transformationFilters = 0;
+		}
+		else if (rotation == "X")
+		{
+			options.transformationFilters = CCCoreLib::RegistrationTools::SKIP_RYZ;
+		}
+		else if (rotation == "Y")
+		{
+			options.transformationFilters = CCCoreLib::RegistrationTools::SKIP_RXZ;
+		}
+		else if (rotation == "Z")
+		{
+			options.transformationFilters = CCCoreLib::RegistrationTools::SKIP_RXY;
+		}
+		else if (rotation == "NONE")
+		{
+			options.transformationFilters = CCCoreLib::RegistrationTools::SKIP_ROTATION;
+		}
+		else
+		{
+			return cmd.error(QObject::tr("Invalid parameter: unknown rotation filter \"%1\"").arg(rotation));
+		}
+	}
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_METRIC))
+	{
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
+		{
+			return cmd.error(QObject::tr("Missing parameter: error metric after \"-%1\" (POINT_TO_POINT/POINT_TO_PLANE)").arg(COMMAND_ICP_METRIC));
+		}
+		QString metric = cmd.arguments().takeFirst().toUpper();
+		if (metric == "POINT_TO_POINT")
+		{
+			options.engineOptions.metric = ccICPEngine::POINT_TO_POINT;
+		}
+		else if (metric == "POINT_TO_PLANE")
+		{
+			options.engineOptions.metric = ccICPEngine::POINT_TO_PLANE;
+		}
+		else
+		{
+			return cmd.error(QObject::tr("Invalid parameter: unknown error metric \"%1\"").arg(metric));
 		}
+		options.useEngine = true;
 	}
-
-	//and meshes!
-	for (CLMeshDesc& meshDesc : cmd.meshes())
+	else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_LEVELS))
 	{
-		bool isLocked = false;
-		ccGenericMesh* mesh = meshDesc.mesh;
-		ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(mesh, &isLocked);
-		if (cloud && !isLocked && cloud->getNumberOfScalarFields() != 0 && sfIndex < static_cast<int>(cloud->getNumberOfScalarFields()))
+		//local option confirmed, we can move on
+		cmd.arguments().pop_front();
+		
+		if (cmd.arguments().empty())
 		{
-			int thisSFIndex = (sfIndex < 0 ? static_cast<int>(cloud->getNumberOfScalarFields()) - 1 : sfIndex);
-			int indexOfSFWithSameName = cloud->getScalarFieldIndexByName(qPrintable(sfName));
-			if (indexOfSFWithSameName >= 0 && thisSFIndex != indexOfSFWithSameName)
-			{
-				return cmd.error("A SF with the same name is already defined on cloud " + cloud->getName());
-			}
-			CCCoreLib::ScalarField* sf = cloud->getScalarField(thisSFIndex);
-			if (!sf)
-			{
-				assert(false);
-				return cmd.error("Internal error: invalid SF index");
-			}
-			sf->setName(qPrintable(sfName));
-
-			if (cmd.autoSaveMode())
-			{
-				QString errorStr = cmd.exportEntity(meshDesc, "SF_RENAMED");
-				if (!errorStr.isEmpty())
-				{
-					return cmd.error(errorStr);
-				}
-			}
+			return cmd.error(QObject::tr("Missing parameter: number of levels after '%1'").arg(COMMAND_ICP_LEVELS));
 		}
+		bool ok;
+		int levelCount = cmd.arguments().takeFirst().toInt(&ok);
+		if (!ok || levelCount < 1)
+		{
+			return cmd.error(QObject::tr("Invalid number of levels! (after %1)").arg(COMMAND_ICP_LEVELS));
+		}
+		options.engineOptions.levelCount = static_cast<unsigned>(levelCount);
+		options.useEngine = true;
+	}
+	else
+	{
+		recognized = false;
 	}
 
 	return true;
@@ -4521,15 +5779,9 @@ bool CommandICP::process(ccCommandLineInterface &cmd)
 	//look for local options
 	bool referenceIsFirst = false;
 	bool adjustScale = false;
-	bool enableFarthestPointRemoval = false;
-	double minErrorDiff = 1.0e-6;
-	unsigned iterationCount = 0;
-	unsigned randomSamplingLimit = 20000;
-	unsigned overlap = 100;
 	int modelSFAsWeights = -1;
 	int dataSFAsWeights = -1;
-	int maxThreadCount = 0;
-	int transformationFilters = 0;
+	ICPCommandOptions icpOptions;
 	
 	while (!cmd.arguments().empty())
 	{
@@ -4548,77 +5800,6 @@ bool CommandICP::process(ccCommandLineInterface &cmd)
 			
 			adjustScale = true;
 		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_ENABLE_FARTHEST_REMOVAL))
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			enableFarthestPointRemoval = true;
-		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_MIN_ERROR_DIIF))
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			if (cmd.arguments().empty())
-			{
-				return cmd.error(QObject::tr("Missing parameter: min error difference after '%1'").arg(COMMAND_ICP_MIN_ERROR_DIIF));
-			}
-			bool ok;
-			minErrorDiff = cmd.arguments().takeFirst().toDouble(&ok);
-			if (!ok || minErrorDiff <= 0)
-			{
-				return cmd.error(QObject::tr("Invalid value for min. error difference! (after %1)").arg(COMMAND_ICP_MIN_ERROR_DIIF));
-			}
-		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_ITERATION_COUNT))
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			if (cmd.arguments().empty())
-			{
-				return cmd.error(QObject::tr("Missing parameter: number of iterations after '%1'").arg(COMMAND_ICP_ITERATION_COUNT));
-			}
-			bool ok;
-			QString arg = cmd.arguments().takeFirst();
-			iterationCount = arg.toUInt(&ok);
-			if (!ok || iterationCount == 0)
-				return cmd.error(QObject::tr("Invalid number of iterations! (%1)").arg(arg));
-		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_OVERLAP))
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			if (cmd.arguments().empty())
-			{
-				return cmd.error(QObject::tr("Missing parameter: overlap percentage after '%1'").arg(COMMAND_ICP_OVERLAP));
-			}
-			bool ok;
-			QString arg = cmd.arguments().takeFirst();
-			overlap = arg.toUInt(&ok);
-			if (!ok || overlap < 10 || overlap > 100)
-			{
-				return cmd.error(QObject::tr("Invalid overlap value! (%1 --> should be between 10 and 100)").arg(arg));
-			}
-		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_RANDOM_SAMPLING_LIMIT))
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			if (cmd.arguments().empty())
-			{
-				return cmd.error(QObject::tr("Missing parameter: random sampling limit value after '%1'").arg(COMMAND_ICP_RANDOM_SAMPLING_LIMIT));
-			}
-			bool ok;
-			randomSamplingLimit = cmd.arguments().takeFirst().toUInt(&ok);
-			if (!ok || randomSamplingLimit < 3)
-			{
-				return cmd.error(QObject::tr("Invalid random sampling limit! (after %1)").arg(COMMAND_ICP_RANDOM_SAMPLING_LIMIT));
-			}
-		}
 		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_USE_MODEL_SF_AS_WEIGHT))
 		{
 			//local option confirmed, we can move on
@@ -4667,65 +5848,18 @@ bool CommandICP::process(ccCommandLineInterface &cmd)
 				}
 			}
 		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_MAX_THREAD_COUNT))
-		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			if (cmd.arguments().empty())
-			{
-				return cmd.error(QObject::tr("Missing parameter: max thread count after '%1'").arg(COMMAND_MAX_THREAD_COUNT));
-			}
-			
-			bool ok;
-			maxThreadCount = cmd.arguments().takeFirst().toInt(&ok);
-			if (!ok || maxThreadCount < 0)
-			{
-				return cmd.error(QObject::tr("Invalid thread count! (after %1)").arg(COMMAND_MAX_THREAD_COUNT));
-			}
-		}
-		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_ROT))
+		else
 		{
-			//local option confirmed, we can move on
-			cmd.arguments().pop_front();
-			
-			if (!cmd.arguments().empty())
+			bool recognized = false;
+			if (!ReadICPOption(cmd, icpOptions, recognized))
 			{
-				QString rotation = cmd.arguments().takeFirst().toUpper();
-				if (rotation == "XYZ")
-				{
-					transformationFilters = 0;
-				}
-				else if (rotation == "X")
-				{
-					transformationFilters = 2;
-				}
-				else if (rotation == "Y")
-				{
-					transformationFilters = 4;
-				}
-				else if (rotation == "Z")
-				{
-					transformationFilters = 1;
-				}
-				else if (rotation == "NONE")
-				{
-					transformationFilters = 7;
-				}
-				else
-				{
-					return cmd.error(QObject::tr("Invalid parameter: unknown rotation filter \"%1\"").arg(rotation));
-				}
+				return false;
 			}
-			else
+			if (!recognized)
 			{
-				return cmd.error(QObject::tr("Missing parameter: rotation filter after \"-%1\" (XYZ/X/Y/Z/NONE)").arg(COMMAND_ICP_ROT));
+				break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
 			}
 		}
-		else
-		{
-			break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
-		}
 	}
 	
 	//we'll get the first two entities
@@ -4805,15 +5939,8 @@ bool CommandICP::process(ccCommandLineInterface &cmd)
 
 	CCCoreLib::ICPRegistrationTools::Parameters parameters;
 	{
-		parameters.convType					= (iterationCount != 0 ? CCCoreLib::ICPRegistrationTools::MAX_ITER_CONVERGENCE : CCCoreLib::ICPRegistrationTools::MAX_ERROR_CONVERGENCE);
-		parameters.minRMSDecrease			= minErrorDiff;
-		parameters.nbMaxIterations			= iterationCount;
+		icpOptions.toParameters(parameters);
 		parameters.adjustScale				= adjustScale;
-		parameters.filterOutFarthestPoints	= enableFarthestPointRemoval;
-		parameters.samplingLimit			= randomSamplingLimit;
-		parameters.finalOverlapRatio		= overlap / 100.0;
-		parameters.transformationFilters	= transformationFilters;
-		parameters.maxThreadCount			= maxThreadCount;
 		parameters.useC2MSignedDistances	= false; //TODO
 		parameters.normalsMatching			= CCCoreLib::ICPRegistrationTools::NO_NORMAL; //TODO
 	}
@@ -4827,7 +5954,8 @@ bool CommandICP::process(ccCommandLineInterface &cmd)
 									parameters,
 									dataSFAsWeights >= 0,
 									modelSFAsWeights >= 0,
-									cmd.widgetParent()))
+									cmd.widgetParent(),
+									icpOptions.useEngine ? &icpOptions.engineOptions : nullptr))
 	{
 		ccHObject* data = dataAndModel[0]->getEntity();
 		data->applyGLTransformation_recursive(&transMat);
@@ -4866,6 +5994,209 @@ bool CommandICP::process(ccCommandLineInterface &cmd)
 	return true;
 }
 
+//! Batch registration job (see CommandICPBatch)
+struct ICPBatchJob
+{
+	ccPointCloud* cloud = nullptr;
+	ccICPEngine::Result result;
+	bool success = false;
+};
+
+CommandICPBatch::CommandICPBatch()
+	: ccCommandLineInterface::Command(QObject::tr("ICP batch"), COMMAND_ICP_BATCH)
+{}
+
+bool CommandICPBatch::process(ccCommandLineInterface &cmd)
+{
+	cmd.print(QObject::tr("[ICP BATCH]"));
+	
+	//look for local options
+	bool applyTransformation = false;
+	QString reportFilename;
+	ICPCommandOptions icpOptions;
+	
+	while (!cmd.arguments().empty())
+	{
+		QString argument = cmd.arguments().front();
+		if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_BATCH_REFERENCE_IS_MESH))
+		{
+			//the batch registration relies on the ICP engine (point-to-point correspondences with a shared index):
+			//meshes are not supported as reference (otherwise each cloud would be registered sequentially, with its own index)
+			return cmd.error(QObject::tr("Option '%1' is not supported by '-%2' (the reference must be a cloud): use '-%3' to register clouds with a mesh").arg(COMMAND_ICP_BATCH_REFERENCE_IS_MESH, COMMAND_ICP_BATCH, COMMAND_ICP));
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_BATCH_APPLY))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			applyTransformation = true;
+		}
+		else if (ccCommandLineInterface::IsCommand(argument, COMMAND_ICP_BATCH_REPORT))
+		{
+			//local option confirmed, we can move on
+			cmd.arguments().pop_front();
+			
+			if (cmd.arguments().empty())
+			{
+				return cmd.error(QObject::tr("Missing parameter: report filename after '%1'").arg(COMMAND_ICP_BATCH_REPORT));
+			}
+			reportFilename = cmd.arguments().takeFirst();
+		}
+		else
+		{
+			bool recognized = false;
+			if (!ReadICPOption(cmd, icpOptions, recognized))
+			{
+				return false;
+			}
+			if (!recognized)
+			{
+				break; //as soon as we encounter an unrecognized argument, we break the local loop to go back to the main one!
+			}
+		}
+	}
+	
+	//the reference is the first loaded cloud, all the other clouds are registered with it
+	if (cmd.clouds().empty())
+	{
+		return cmd.error(QObject::tr("No cloud loaded"));
+	}
+	CLEntityDesc* referenceDesc = &cmd.clouds().front();
+	const size_t firstDataCloudIndex = 1;
+	if (cmd.clouds().size() <= firstDataCloudIndex)
+	{
+		return cmd.error(QObject::tr("No cloud to register (expect at least one cloud besides the reference)"));
+	}
+	
+	std::vector<ICPBatchJob> jobs;
+	try
+	{
+		jobs.resize(cmd.clouds().size() - firstDataCloudIndex);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return cmd.error(QObject::tr("Not enough memory"));
+	}
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		jobs[i].cloud = cmd.clouds()[firstDataCloudIndex + i].pc;
+	}
+	
+	CCCoreLib::ICPRegistrationTools::Parameters parameters;
+	{
+		icpOptions.toParameters(parameters);
+		parameters.adjustScale				= false;
+		parameters.modelWeights				= nullptr;
+		parameters.dataWeights				= nullptr;
+	}
+	
+	cmd.print(QObject::tr("Registering %1 cloud(s) with '%2'").arg(jobs.size()).arg(referenceDesc->basename));
+	
+	//build the reference index once
+	ccICPEngine engine;
+	if (!engine.setModel(referenceDesc->getEntity(), cmd.progressDialog()))
+	{
+		return cmd.error(QObject::tr("Failed to prepare the reference entity '%1'").arg(referenceDesc->basename));
+	}
+	
+	int maxThreadCount = parameters.maxThreadCount;
+	if (maxThreadCount <= 0 || maxThreadCount > QThread::idealThreadCount())
+	{
+		maxThreadCount = QThread::idealThreadCount();
+	}
+	maxThreadCount = std::min(maxThreadCount, static_cast<int>(jobs.size()));
+	parameters.maxThreadCount = 1; //the parallelism is at the cloud level
+	
+	//the clouds are registered concurrently: each worker processes the clouds one after the other (local pool, so as to not change the global one)
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(maxThreadCount);
+	std::atomic<size_t> nextJob(0);
+	std::vector< QFuture<void> > workers;
+	workers.reserve(maxThreadCount);
+	for (int w = 0; w < maxThreadCount; ++w)
+	{
+		workers.push_back(QtConcurrent::run(&threadPool, [&]()
+		{
+			for (size_t j = nextJob++; j < jobs.size(); j = nextJob++)
+			{
+				ICPBatchJob& job = jobs[j];
+				job.success = engine.registerData(job.cloud, parameters, icpOptions.engineOptions, job.result);
+			}
+		}));
+	}
+	for (QFuture<void>& worker : workers)
+	{
+		worker.waitForFinished();
+	}
+	
+	//report
+	if (reportFilename.isEmpty())
+	{
+		reportFilename = QObject::tr("%1/%2_BATCH_REGISTRATION").arg(referenceDesc->path, referenceDesc->basename);
+		if (cmd.addTimestamp())
+			reportFilename += QObject::tr("_%1").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh'h'mm"));
+		reportFilename += QObject::tr(".csv");
+	}
+	QFile reportFile(reportFilename);
+	if (!reportFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		return cmd.error(QObject::tr("Failed to open the report file '%1' for writing").arg(reportFilename));
+	}
+	QTextStream reportStream(&reportFile);
+	reportStream.setRealNumberNotation(QTextStream::FixedNotation);
+	reportStream.setRealNumberPrecision(cmd.numericalPrecision());
+	reportStream << "Cloud;Success;RMS;Final point count;Sampled point count;Overlap;Mean distance;Max distance;Iterations;Transformation (row major)" << endl;
+	
+	unsigned failureCount = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const ICPBatchJob& job = jobs[i];
+		CLCloudDesc& desc = cmd.clouds()[firstDataCloudIndex + i];
+		
+		//measured overlap: kept matches / sampled points (final step)
+		double overlap = (job.result.sampledPointCount != 0 ? static_cast<double>(job.result.finalPointCount) / job.result.sampledPointCount : 0.0);
+		reportStream << desc.basename << ';' << (job.success ? 1 : 0) << ';' << job.result.finalRMS << ';' << job.result.finalPointCount << ';' << job.result.sampledPointCount << ';';
+		reportStream << overlap << ';' << job.result.meanDistance << ';' << job.result.maxDistance << ';' << job.result.iterationCount;
+		const double* mat = job.result.transMat.data();
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				reportStream << ';' << mat[c * 4 + r];
+		reportStream << endl;
+		
+		if (!job.success)
+		{
+			++failureCount;
+			cmd.warning(QObject::tr("Failed to register cloud '%1'").arg(desc.basename));
+			continue;
+		}
+		cmd.print(QObject::tr("Cloud '%1': RMS = %2 (%3 points used for the final step, overlap = %4%)").arg(desc.basename).arg(job.result.finalRMS).arg(job.result.finalPointCount).arg(100.0 * overlap, 0, 'f', 1));
+		
+		if (applyTransformation)
+		{
+			ccGLMatrix transMat(job.result.transMat.data());
+			desc.pc->applyGLTransformation_recursive(&transMat);
+			desc.basename += QObject::tr("_REGISTERED");
+			if (cmd.autoSaveMode())
+			{
+				QString errorStr = cmd.exportEntity(desc);
+				if (!errorStr.isEmpty())
+				{
+					return cmd.error(errorStr);
+				}
+			}
+		}
+	}
+	reportFile.close();
+	cmd.print(QObject::tr("Registration report saved to '%1'").arg(reportFilename));
+	
+	if (failureCount == jobs.size())
+	{
+		return cmd.error(QObject::tr("All registrations failed"));
+	}
+	
+	return true;
+}
+
 CommandChangePLYExportFormat::CommandChangePLYExportFormat()
 	: ccCommandLineInterface::Command(QObject::tr("Change PLY output format"), COMMAND_PLY_EXPORT_FORMAT)
 {}
@@ -3,6 +3,7 @@
 
 #include <QStringList>
 
+#include "ccC2CBatchEngine.h"
 #include "ccCommandLineInterface.h"
 
 
@@ -18,6 +19,7 @@ struct CommandChangeCloudOutputFormat : public CommandChangeOutputFormat
 	CommandChangeCloudOutputFormat();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandChangeMeshOutputFormat : public CommandChangeOutputFormat
@@ -46,6 +48,7 @@ struct CommandClearNormals : public ccCommandLineInterface::Command
 	CommandClearNormals();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandOctreeNormal : public ccCommandLineInterface::Command
@@ -60,6 +63,7 @@ struct CommandInvertNormal : public ccCommandLineInterface::Command
 	CommandInvertNormal();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandConvertNormalsToDipAndDipDir : public ccCommandLineInterface::Command
@@ -67,6 +71,7 @@ struct CommandConvertNormalsToDipAndDipDir : public ccCommandLineInterface::Comm
 	CommandConvertNormalsToDipAndDipDir();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandConvertNormalsToSFs : public ccCommandLineInterface::Command
@@ -74,6 +79,7 @@ struct CommandConvertNormalsToSFs : public ccCommandLineInterface::Command
 	CommandConvertNormalsToSFs();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandSubsample : public ccCommandLineInterface::Command
@@ -130,6 +136,7 @@ struct CommandApplyTransformation : public ccCommandLineInterface::Command
 	CommandApplyTransformation();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandDropGlobalShift : public ccCommandLineInterface::Command
@@ -137,6 +144,7 @@ struct CommandDropGlobalShift : public ccCommandLineInterface::Command
 	CommandDropGlobalShift();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandSFColorScale : public ccCommandLineInterface::Command
@@ -144,6 +152,7 @@ struct CommandSFColorScale : public ccCommandLineInterface::Command
 	CommandSFColorScale();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandSFConvertToRGB : public ccCommandLineInterface::Command
@@ -158,6 +167,7 @@ struct CommandFilterBySFValue : public ccCommandLineInterface::Command
 	CommandFilterBySFValue();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList& arguments) const override;
 };
 
 struct CommandComputeMeshVolume : public ccCommandLineInterface::Command
@@ -174,6 +184,27 @@ struct CommandMergeMeshes : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandWeldVertices : public ccCommandLineInterface::Command
+{
+	CommandWeldVertices();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+struct CommandSmoothMesh : public ccCommandLineInterface::Command
+{
+	CommandSmoothMesh();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
+struct CommandSubdivideMesh : public ccCommandLineInterface::Command
+{
+	CommandSubdivideMesh();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 struct CommandMergeClouds : public ccCommandLineInterface::Command
 {
 	CommandMergeClouds();
@@ -181,11 +212,19 @@ struct CommandMergeClouds : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandReorderPoints : public ccCommandLineInterface::Command
+{
+	CommandReorderPoints();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 struct CommandSetActiveSF : public ccCommandLineInterface::Command
 {
 	CommandSetActiveSF();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandRemoveAllSF : public ccCommandLineInterface::Command
@@ -193,6 +232,7 @@ struct CommandRemoveAllSF : public ccCommandLineInterface::Command
 	CommandRemoveAllSF();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandRemoveRGB : public ccCommandLineInterface::Command
@@ -200,6 +240,7 @@ struct CommandRemoveRGB : public ccCommandLineInterface::Command
 	CommandRemoveRGB();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandRemoveNormals : public ccCommandLineInterface::Command
@@ -207,6 +248,7 @@ struct CommandRemoveNormals : public ccCommandLineInterface::Command
 	CommandRemoveNormals();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandRemoveScanGrids : public ccCommandLineInterface::Command
@@ -270,6 +312,7 @@ struct CommandCrop : public ccCommandLineInterface::Command
 	CommandCrop();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandCoordToSF : public ccCommandLineInterface::Command
@@ -277,6 +320,7 @@ struct CommandCoordToSF : public ccCommandLineInterface::Command
 	CommandCoordToSF();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandCrop2D : public ccCommandLineInterface::Command
@@ -299,6 +343,14 @@ struct CommandDist : public ccCommandLineInterface::Command
 
 	bool process(ccCommandLineInterface& cmd) override;
 
+	//! Computes the C2C distances between the first loaded cloud (reference) and several compared clouds
+	bool processMultiC2C(	ccCommandLineInterface& cmd,
+							const ccC2CBatchEngine::Parameters& params,
+							const QStringList& comparedFiles,
+							double memoryBudget_MB,
+							QString summaryFilename,
+							int maxThreadCount);
+
 	bool m_cloud2meshDist;
 };
 
@@ -338,6 +390,7 @@ struct CommandSFArithmetic : public ccCommandLineInterface::Command
 	CommandSFArithmetic();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandSFOperation : public ccCommandLineInterface::Command
@@ -345,12 +398,21 @@ struct CommandSFOperation : public ccCommandLineInterface::Command
 	CommandSFOperation();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandSFRename : public ccCommandLineInterface::Command
 {
 	CommandSFRename();
 
+	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
+};
+
+struct CommandSFInterpolation : public ccCommandLineInterface::Command
+{
+	CommandSFInterpolation();
+
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
@@ -361,11 +423,19 @@ struct CommandICP : public ccCommandLineInterface::Command
 	bool process(ccCommandLineInterface& cmd) override;
 };
 
+struct CommandICPBatch : public ccCommandLineInterface::Command
+{
+	CommandICPBatch();
+
+	bool process(ccCommandLineInterface& cmd) override;
+};
+
 struct CommandChangePLYExportFormat : public ccCommandLineInterface::Command
 {
 	CommandChangePLYExportFormat();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandForceNormalsComputation : public ccCommandLineInterface::Command
@@ -452,6 +522,7 @@ struct CommandSetNoTimestamp : public ccCommandLineInterface::Command
 	CommandSetNoTimestamp();
 
 	bool process(ccCommandLineInterface& cmd) override;
+	bool isPointLocal(const QStringList&) const override { return true; }
 };
 
 struct CommandMoment : public ccCommandLineInterface::Command
@@ -0,0 +1,262 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccCommandLineEntityCache.h"
+
+//CCCoreLib
+#include <DgmOctree.h>
+
+//qCC_db
+#include <ccPointCloud.h>
+
+//Qt
+#include <QFileInfo>
+
+//system
+#include <algorithm>
+#include <cassert>
+
+ccCommandLineEntityCache::ccCommandLineEntityCache(double memoryBudget_MB)
+	: m_memoryBudget_MB(memoryBudget_MB)
+	, m_memoryUsed_MB(0.0)
+	, m_useCounter(0)
+	, m_hitCount(0)
+	, m_missCount(0)
+{
+}
+
+ccCommandLineEntityCache::~ccCommandLineEntityCache()
+{
+	QMutexLocker locker(&m_mutex);
+
+	while (!m_entries.empty())
+	{
+		//the borrowed clouds belong to their job
+		deleteEntry(m_entries.size() - 1, m_entries.back().borrower == nullptr);
+	}
+}
+
+double ccCommandLineEntityCache::EstimatedMemory_MB(const ccPointCloud* cloud)
+{
+	size_t bytesPerPoint = sizeof(CCVector3);
+	if (cloud->hasColors())
+	{
+		bytesPerPoint += sizeof(ccColor::Rgba);
+	}
+	if (cloud->hasNormals())
+	{
+		bytesPerPoint += sizeof(CompressedNormType);
+	}
+	bytesPerPoint += cloud->getNumberOfScalarFields() * sizeof(ScalarType);
+	//octree: one code and one index per point
+	bytesPerPoint += sizeof(CCCoreLib::DgmOctree::CellCode) + sizeof(unsigned);
+
+	return (static_cast<double>(cloud->size()) * bytesPerPoint) / (1 << 20);
+}
+
+bool ccCommandLineEntityCache::acquire(const QString& filename, const QString& loadingKey, const void* job, unsigned version, std::vector<ccPointCloud*>& clouds)
+{
+	QFileInfo fileInfo(filename);
+	QString absoluteFilename = fileInfo.absoluteFilePath();
+
+	QMutexLocker locker(&m_mutex);
+
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		Entry& entry = m_entries[i];
+		if (entry.filename != absoluteFilename || entry.loadingKey != loadingKey)
+		{
+			continue;
+		}
+
+		if (entry.borrower != nullptr)
+		{
+			//already borrowed by another job
+			break;
+		}
+
+		if (entry.lastModified != fileInfo.lastModified() || entry.fileSize != fileInfo.size())
+		{
+			//the file has been modified in the meantime
+			deleteEntry(i, true);
+			break;
+		}
+
+		entry.borrower = job;
+		entry.borrowerVersion = version;
+		entry.lastUse = ++m_useCounter;
+		clouds = entry.clouds;
+		++m_hitCount;
+		return true;
+	}
+
+	++m_missCount;
+	return false;
+}
+
+void ccCommandLineEntityCache::insert(const QString& filename, const QString& loadingKey, const void* job, unsigned version, const std::vector<ccPointCloud*>& clouds)
+{
+	if (clouds.empty())
+	{
+		return;
+	}
+
+	QFileInfo fileInfo(filename);
+
+	Entry entry;
+	entry.filename = fileInfo.absoluteFilePath();
+	entry.loadingKey = loadingKey;
+	entry.lastModified = fileInfo.lastModified();
+	entry.fileSize = fileInfo.size();
+	entry.borrower = job;
+	entry.borrowerVersion = version;
+	entry.clouds = clouds;
+	entry.names.reserve(clouds.size());
+	for (ccPointCloud* cloud : clouds)
+	{
+		entry.memory_MB += EstimatedMemory_MB(cloud);
+		entry.names.push_back(cloud->getName());
+	}
+	if (m_memoryBudget_MB > 0 && entry.memory_MB > m_memoryBudget_MB)
+	{
+		//too big
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+	for (const Entry& other : m_entries)
+	{
+		if (other.filename == entry.filename && other.loadingKey == loadingKey)
+		{
+			//already cached (loaded by another job at the same time)
+			return;
+		}
+	}
+	entry.lastUse = ++m_useCounter;
+	m_memoryUsed_MB += entry.memory_MB;
+	m_entries.push_back(entry);
+}
+
+void ccCommandLineEntityCache::release(const void* job, unsigned version, std::vector<CLCloudDesc>& clouds)
+{
+	QMutexLocker locker(&m_mutex);
+
+	for (size_t i = 0; i < m_entries.size(); )
+	{
+		Entry& entry = m_entries[i];
+		if (entry.borrower != job)
+		{
+			++i;
+			continue;
+		}
+
+		//the clouds may have been modified by the commands run since they were borrowed
+		bool unmodified = (entry.borrowerVersion == version);
+		//a cloud which is not in the job set anymore has been deleted (or taken over) by the job
+		for (size_t j = 0; j < entry.clouds.size() && unmodified; ++j)
+		{
+			unmodified = std::any_of(clouds.begin(), clouds.end(), [&](const CLCloudDesc& desc) { return desc.pc == entry.clouds[j]; });
+		}
+
+		if (!unmodified)
+		{
+			//the job keeps the clouds (and will delete them)
+			deleteEntry(i, false);
+			continue;
+		}
+
+		//we take the clouds back
+		for (size_t j = 0; j < entry.clouds.size(); ++j)
+		{
+			ccPointCloud* cloud = entry.clouds[j];
+			cloud->setName(entry.names[j]); //the name is modified when the cloud is saved
+			for (auto it = clouds.begin(); it != clouds.end(); ++it)
+			{
+				if (it->pc == cloud)
+				{
+					clouds.erase(it);
+					break;
+				}
+			}
+		}
+		entry.borrower = nullptr;
+		entry.lastUse = ++m_useCounter;
+		++i;
+	}
+
+	enforceBudget();
+}
+
+void ccCommandLineEntityCache::enforceBudget()
+{
+	while (m_memoryBudget_MB > 0 && m_memoryUsed_MB > m_memoryBudget_MB)
+	{
+		//look for the least recently used entry (that is not borrowed)
+		size_t lruIndex = m_entries.size();
+		for (size_t i = 0; i < m_entries.size(); ++i)
+		{
+			if (m_entries[i].borrower == nullptr && (lruIndex == m_entries.size() || m_entries[i].lastUse < m_entries[lruIndex].lastUse))
+			{
+				lruIndex = i;
+			}
+		}
+		if (lruIndex == m_entries.size())
+		{
+			//all the entries are borrowed
+			break;
+		}
+		deleteEntry(lruIndex, true);
+	}
+}
+
+void ccCommandLineEntityCache::deleteEntry(size_t index, bool deleteClouds)
+{
+	assert(index < m_entries.size());
+	Entry& entry = m_entries[index];
+	if (deleteClouds)
+	{
+		for (ccPointCloud* cloud : entry.clouds)
+		{
+			delete cloud;
+		}
+	}
+	m_memoryUsed_MB -= entry.memory_MB;
+
+	m_entries.erase(m_entries.begin() + index);
+}
+
+QString ccCommandLineEntityCache::status() const
+{
+	QMutexLocker locker(&m_mutex);
+
+	unsigned borrowedCount = 0;
+	for (const Entry& entry : m_entries)
+	{
+		if (entry.borrower)
+		{
+			++borrowedCount;
+		}
+	}
+
+	return QString("%1 cached file(s) (%2 in use), %3 / %4 MB, %5 hit(s), %6 miss(es)")
+		.arg(m_entries.size())
+		.arg(borrowedCount)
+		.arg(m_memoryUsed_MB, 0, 'f', 1)
+		.arg(m_memoryBudget_MB, 0, 'f', 1)
+		.arg(m_hitCount)
+		.arg(m_missCount);
+}
@@ -0,0 +1,127 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_COMMAND_LINE_ENTITY_CACHE_HEADER
+#define CC_COMMAND_LINE_ENTITY_CACHE_HEADER
+
+//interface
+#include "ccCommandLineInterface.h"
+
+//Qt
+#include <QDateTime>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+
+//system
+#include <cstdint>
+#include <vector>
+
+class ccPointCloud;
+
+//! Cache of the point clouds loaded by the jobs of the command line server (see the '-SERVER' option)
+/** The cached clouds are lent to a single job at a time, so that they keep the
+	structures computed by the previous jobs (typically their octree). A job that
+	needs a file which is currently lent to another job simply loads it again.
+
+	When a job ends, the clouds it borrowed go back to the cache, unless they may have
+	been modified or deleted by the job. The job keeps a 'version' counter, incremented
+	by each command that may modify the loaded entities: a cloud is unmodified if the
+	version of the job hasn't changed since it was borrowed. The least recently used
+	files are released as soon as the memory budget is exceeded.
+**/
+class ccCommandLineEntityCache
+{
+public:
+
+	//! Shared type
+	using Shared = QSharedPointer<ccCommandLineEntityCache>;
+
+	//! Default constructor
+	/** \param memoryBudget_MB max (approximate) memory used by the cached clouds
+	**/
+	explicit ccCommandLineEntityCache(double memoryBudget_MB);
+
+	//! Destructor
+	~ccCommandLineEntityCache();
+
+	//! Borrows the clouds loaded from a file (if they are in the cache and available)
+	/** \param filename file
+		\param loadingKey signature of the loading parameters (the same file loaded with other parameters is another entry)
+		\param job job identifier
+		\param version current version of the job
+		\param clouds output clouds (the job must give them back with release)
+		\return whether the clouds could be borrowed
+	**/
+	bool acquire(const QString& filename, const QString& loadingKey, const void* job, unsigned version, std::vector<ccPointCloud*>& clouds);
+
+	//! Adds the clouds loaded from a file by a job (they are considered as borrowed by this job)
+	/** Nothing happens if the file is already in the cache, or if the clouds exceed the budget on their own.
+	**/
+	void insert(const QString& filename, const QString& loadingKey, const void* job, unsigned version, const std::vector<ccPointCloud*>& clouds);
+
+	//! Takes back the clouds borrowed by a job
+	/** The unmodified clouds are removed from the input set (the other ones are left to the job).
+		\param job job identifier
+		\param version final version of the job
+		\param clouds job clouds
+	**/
+	void release(const void* job, unsigned version, std::vector<CLCloudDesc>& clouds);
+
+	//! Returns a short description of the cache content
+	QString status() const;
+
+protected:
+
+	//! Cache entry
+	struct Entry
+	{
+		QString filename;
+		QString loadingKey;
+		QDateTime lastModified;
+		qint64 fileSize = 0;
+		std::vector<ccPointCloud*> clouds;
+		std::vector<QString> names;
+		double memory_MB = 0.0;
+		const void* borrower = nullptr;
+		unsigned borrowerVersion = 0;
+		uint64_t lastUse = 0;
+	};
+
+	//! Returns the (approximate) memory used by a cloud and its octree
+	static double EstimatedMemory_MB(const ccPointCloud* cloud);
+
+	//! Releases the least recently used entries until the budget is respected
+	void enforceBudget();
+	//! Deletes an entry (and its clouds)
+	void deleteEntry(size_t index, bool deleteClouds);
+
+	//! Entries
+	std::vector<Entry> m_entries;
+	//! Memory budget (in MB)
+	double m_memoryBudget_MB;
+	//! Memory used by the cached clouds (in MB)
+	double m_memoryUsed_MB;
+	//! Usage counter (for the LRU policy)
+	uint64_t m_useCounter;
+	//! Number of successful / failed acquisitions
+	unsigned m_hitCount, m_missCount;
+	//! Mutex
+	mutable QMutex m_mutex;
+};
+
+#endif //CC_COMMAND_LINE_ENTITY_CACHE_HEADER
@@ -3,14 +3,19 @@
 //Local
 #include "ccCommandCrossSection.h"
 #include "ccCommandLineCommands.h"
+#include "ccCommandLineServer.h"
 #include "ccCommandRaster.h"
 #include "ccPluginInterface.h"
 
 //qCC_db
 #include <ccGenericMesh.h>
 #include <ccHObjectCaster.h>
+#include <ccPointCloud.h>
 #include <ccProgressDialog.h>
 
+//CCCoreLib
+#include <ReferenceCloud.h>
+
 //qCC_io
 #include <AsciiFilter.h>
 #include <BinFilter.h>
@@ -23,14 +28,330 @@
 //Qt
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QMessageBox>
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
 
 //system
+#include <algorithm>
+#include <numeric>
+#include <random>
 #include <unordered_set>
 
 //commands
-constexpr char COMMAND_HELP[]			= "HELP";
-constexpr char COMMAND_SILENT_MODE[]	= "SILENT";
+constexpr char COMMAND_HELP[]						= "HELP";
+constexpr char COMMAND_SILENT_MODE[]				= "SILENT";
+constexpr char COMMAND_PROFILE[]					= "PROFILE";		//+ report filename (JSON, or CSV if the extension is 'csv')
+constexpr char COMMAND_PARALLEL_FILES[]				= "PARALLEL_FILES";
+constexpr char COMMAND_PARALLEL_MAX_THREAD_COUNT[]	= "MAX_TCOUNT";		//+ max number of files processed at the same time
+constexpr char COMMAND_PARALLEL_MEM_BUDGET[]		= "MEM_BUDGET";		//+ memory budget (in MB)
+constexpr char COMMAND_STREAM[]						= "STREAM";
+constexpr char COMMAND_STREAM_CHUNK_SIZE[]			= "CHUNK_SIZE";		//+ max number of points per chunk
+constexpr char COMMAND_STREAM_SEED[]				= "SEED";			//+ seed of the random subsampling
+constexpr char COMMAND_SERVER[]						= "SERVER";
+constexpr char COMMAND_SERVER_NAME[]				= "NAME";			//+ server (socket) name
+constexpr char COMMAND_OPEN[]						= "O";				//see CommandLoad
+constexpr char COMMAND_SUBSAMPLE[]					= "SS";				//see CommandSubsample
+constexpr char COMMAND_SUBSAMPLE_RANDOM[]			= "RANDOM";
+
+//! Mutex used by the workers to load or save files with non reentrant filters (parallel mode)
+static QMutex s_nonReentrantIOMutex;
+
+//! Commands that can be run by concurrent workers (parallel and server modes)
+/** They don't create any dialog and don't rely on any shared state.
+	The settings commands (export formats, etc.) must be placed before the files.
+**/
+static const QSet<QString> s_concurrentCommands {	"O", "SAVE_CLOUDS", "SAVE_MESHES", "AUTO_SAVE", "NO_TIMESTAMP", "COMPUTE_NORMALS",
+													"CLEAR", "CLEAR_CLOUDS", "POP_CLOUDS", "CLEAR_MESHES", "POP_MESHES",
+													"APPLY_TRANS", "DROP_GLOBAL_SHIFT", "MATCH_CENTERS", "BEST_FIT_PLANE", "REORDER_POINTS",
+													"FILTER_SF", "SET_ACTIVE_SF", "REMOVE_ALL_SFS", "RENAME_SF", "SF_ARITHMETIC", "SF_OP",
+													"SF_CONVERT_TO_RGB", "SF_INTERP", "COORD_TO_SF", "CBANDING",
+													"REMOVE_RGB", "REMOVE_NORMALS", "REMOVE_SCAN_GRIDS", "CLEAR_NORMALS", "INVERT_NORMALS",
+													"NORMALS_TO_DIP", "NORMALS_TO_SFS", "MERGE_CLOUDS", "CROP", "CROP2D",
+													"MERGE_MESHES", "EXTRACT_VERTICES", "SAMPLE_MESH", "WELD_VERTICES", "SMOOTH_MESH",
+													"SUBDIVIDE_MESH", "MESH_VOLUME", "DELAUNAY" };
+
+//! Commands that can be run by concurrent workers, but only one at a time (parallel and server modes)
+/** They rely on multi-threaded octree passes, and CCCoreLib's DgmOctree keeps the state of
+	these passes in static variables (without letting the caller choose a single-threaded pass).
+**/
+static const QSet<QString> s_exclusiveCommands {	"SS", "CURV", "DENSITY", "APPROX_DENSITY", "ROUGH", "SF_GRAD", "FEATURE", "MOMENT",
+													"SOR", "NOISE", "OCTREE_NORMALS", "ORIENT_NORMS_MST", "EXTRACT_CC", "STAT_TEST", "ICP" };
+
+//! Mutex used by the concurrent workers to run the 'exclusive' commands one at a time
+static QMutex s_exclusiveCommandMutex;
+
+//! Commands that don't modify the loaded clouds (server mode, see ccCommandLineEntityCache)
+static const QSet<QString> s_readOnlyCommands {	"O", "SAVE_CLOUDS", "SAVE_MESHES", "AUTO_SAVE", "NO_TIMESTAMP", "CLEAR_MESHES", "POP_MESHES",
+												"C_EXPORT_FMT", "M_EXPORT_FMT", "H_EXPORT_FMT", "PLY_EXPORT_FMT" };
+
+//! Rough ratio between the memory required to process a file and the memory used by its loaded entities (parallel mode)
+static const double s_parallelMemoryFactor = 2.0;
+
+//! Default number of points per chunk (streaming mode)
+static const unsigned s_defaultStreamChunkSize = 1000000;
+
+namespace
+{
+	//! Returns the signature of the loading parameters (server mode)
+	QString LoadingKey(const FileIOFilter::LoadParameters& parameters, FileIOFilter::Shared filter)
+	{
+		QString key = QString("%1_%2_%3_%4").arg(static_cast<int>(parameters.shiftHandlingMode)).arg(parameters.autoComputeNormals).arg(parameters.weldMeshVertices).arg(parameters.meshWeldingTolerance);
+		if (parameters.reorderPoints)
+		{
+			key += QString("_order%1").arg(static_cast<int>(parameters.pointOrder));
+		}
+		if (parameters.coordinatesShiftEnabled && *parameters.coordinatesShiftEnabled && parameters.coordinatesShift)
+		{
+			const CCVector3d& shift = *parameters.coordinatesShift;
+			key += QString("_%1_%2_%3").arg(shift.x, 0, 'f', 6).arg(shift.y, 0, 'f', 6).arg(shift.z, 0, 'f', 6);
+		}
+		if (filter)
+		{
+			key += "_" + filter->getDefaultExtension();
+		}
+		return key;
+	}
+
+	//! Rough estimation of the memory used by the loaded entities (in bytes)
+	double LoadedMemory(const ccCommandLineInterface& cmd)
+	{
+		double bytes = 0;
+		for (const CLCloudDesc& desc : cmd.clouds())
+		{
+			if (!desc.pc)
+			{
+				continue;
+			}
+			double bytesPerPoint = sizeof(CCVector3) + desc.pc->getNumberOfScalarFields() * sizeof(ScalarType);
+			if (desc.pc->hasColors())
+				bytesPerPoint += sizeof(ccColor::Rgba);
+			if (desc.pc->hasNormals())
+				bytesPerPoint += sizeof(CompressedNormType);
+			bytes += bytesPerPoint * desc.pc->size();
+		}
+		for (const CLMeshDesc& desc : cmd.meshes())
+		{
+			if (desc.mesh)
+			{
+				bytes += 3.0 * sizeof(unsigned) * desc.mesh->size();
+				if (desc.mesh->getAssociatedCloud())
+					bytes += static_cast<double>(sizeof(CCVector3)) * desc.mesh->getAssociatedCloud()->size();
+			}
+		}
+		return bytes;
+	}
+
+	//! Memory budget shared by the workers (parallel mode)
+	/** The memory required by a file is predicted from its size, with the largest
+		'required memory / file size' ratio measured so far. Until a first file has
+		been loaded (and measured), the files are processed one at a time.
+	**/
+	class MemoryBudget
+	{
+	public:
+
+		//! Default constructor
+		/** \param budget memory budget (in bytes, 0 = no limit)
+		**/
+		explicit MemoryBudget(double budget)
+			: m_budget(budget)
+			, m_used(0)
+			, m_ratio(0)
+			, m_activeCount(0)
+		{}
+
+		//! Waits until the memory predicted for a file is available
+		/** A file is always accepted if no other file is being processed
+			(even if it exceeds the budget on its own).
+			\param fileSize file size (in bytes)
+			\return the reserved amount of memory
+		**/
+		double acquire(double fileSize)
+		{
+			QMutexLocker locker(&m_mutex);
+			while (m_budget > 0 && m_activeCount != 0 && (m_ratio <= 0 || m_used + fileSize * m_ratio > m_budget))
+			{
+				m_released.wait(&m_mutex);
+			}
+			double amount = fileSize * m_ratio;
+			m_used += amount;
+			++m_activeCount;
+			return amount;
+		}
+
+		//! Replaces the predicted memory of a file by the one measured once it is loaded
+		/** \param fileSize file size (in bytes)
+			\param amount reserved amount of memory (updated)
+			\param required memory actually required by the file
+		**/
+		void update(double fileSize, double& amount, double required)
+		{
+			QMutexLocker locker(&m_mutex);
+			if (fileSize > 0)
+			{
+				m_ratio = std::max(m_ratio, required / fileSize);
+			}
+			m_used += required - amount;
+			amount = required;
+			m_released.wakeAll();
+		}
+
+		//! Releases the memory reserved for a file
+		void release(double amount)
+		{
+			QMutexLocker locker(&m_mutex);
+			m_used -= amount;
+			--m_activeCount;
+			m_released.wakeAll();
+		}
+
+	protected:
+
+		double m_budget;
+		double m_used;
+		double m_ratio;
+		unsigned m_activeCount;
+		QMutex m_mutex;
+		QWaitCondition m_released;
+	};
+
+	//! Uniform random sample of a stream of points (streaming mode)
+	/** Each point gets a random key: the reservoir keeps the points with the smallest keys
+		(in their input order) so that its size never exceeds its capacity.
+	**/
+	class PointReservoir
+	{
+	public:
+
+		//! Default constructor
+		/** \param capacity max number of points
+			\param seed seed of the random generator
+		**/
+		PointReservoir(unsigned capacity, unsigned seed)
+			: m_capacity(capacity)
+			, m_cloud(nullptr)
+			, m_generator(seed)
+		{}
+
+		//! Destructor
+		~PointReservoir()
+		{
+			delete m_cloud;
+		}
+
+		//! Adds a chunk of points
+		/** The chunk is either kept or deleted.
+			\return success
+		**/
+		bool add(ccPointCloud* chunk)
+		{
+			if (!chunk)
+			{
+				assert(false);
+				return false;
+			}
+
+			size_t previousCount = m_keys.size();
+			try
+			{
+				m_keys.resize(previousCount + chunk->size());
+			}
+			catch (const std::bad_alloc&)
+			{
+				delete chunk;
+				return false;
+			}
+			std::uniform_real_distribution<double> distribution(0.0, 1.0);
+			for (size_t i = previousCount; i < m_keys.size(); ++i)
+			{
+				m_keys[i] = distribution(m_generator);
+			}
+
+			if (!m_cloud)
+			{
+				m_cloud = chunk;
+			}
+			else
+			{
+				*m_cloud += chunk;
+				delete chunk;
+				if (m_cloud->size() != m_keys.size())
+				{
+					//not enough memory
+					return false;
+				}
+			}
+
+			return (m_cloud->size() <= m_capacity || shrink());
+		}
+
+		//! Takes the sampled cloud (the caller becomes its owner)
+		ccPointCloud* takeCloud()
+		{
+			ccPointCloud* cloud = m_cloud;
+			m_cloud = nullptr;
+			m_keys.clear();
+			return cloud;
+		}
+
+	protected:
+
+		//! Only keeps the points with the smallest keys
+		bool shrink()
+		{
+			std::vector<unsigned> indexes;
+			try
+			{
+				indexes.resize(m_cloud->size());
+			}
+			catch (const std::bad_alloc&)
+			{
+				return false;
+			}
+			std::iota(indexes.begin(), indexes.end(), 0);
+			std::nth_element(indexes.begin(), indexes.begin() + m_capacity, indexes.end(), [this](unsigned a, unsigned b) { return m_keys[a] < m_keys[b]; });
+			indexes.resize(m_capacity);
+			std::sort(indexes.begin(), indexes.end());
+
+			CCCoreLib::ReferenceCloud selection(m_cloud);
+			if (!selection.reserve(m_capacity))
+			{
+				return false;
+			}
+			std::vector<double> keys(m_capacity);
+			for (unsigned i = 0; i < m_capacity; ++i)
+			{
+				selection.addPointIndex(indexes[i]);
+				keys[i] = m_keys[indexes[i]];
+			}
+
+			ccPointCloud* sampledCloud = m_cloud->partialClone(&selection);
+			if (!sampledCloud)
+			{
+				return false;
+			}
+			sampledCloud->setName(m_cloud->getName());
+			delete m_cloud;
+			m_cloud = sampledCloud;
+			m_keys = std::move(keys);
+
+			return true;
+		}
+
+		unsigned m_capacity;
+		ccPointCloud* m_cloud;
+		std::vector<double> m_keys;
+		std::mt19937 m_generator;
+	};
+}
 
 /*****************************************************/
 /*************** ccCommandLineParser *****************/
@@ -38,23 +359,81 @@ constexpr char COMMAND_SILENT_MODE[]	= "SILENT";
 
 void ccCommandLineParser::print(const QString& message) const
 {
+	if (m_isWorker)
+	{
+		m_bufferedMessages.push_back({ ccLog::LOG_STANDARD, message });
+		return;
+	}
+
 	ccConsole::Print(message);
 }
 
 void ccCommandLineParser::warning(const QString& message) const
 {
+	if (m_isWorker)
+	{
+		m_bufferedMessages.push_back({ ccLog::LOG_WARNING, message });
+		return;
+	}
+
 	ccConsole::Warning(message);
 	
 }
 
 bool ccCommandLineParser::error(const QString& message) const
 {
+	if (m_isWorker)
+	{
+		m_bufferedMessages.push_back({ ccLog::LOG_ERROR, message });
+		return false;
+	}
+
 	ccConsole::Error(message);
 	
 
 	return false;
 }
 
+void ccCommandLineParser::FlushMessages(const std::vector<BufferedMessage>& messages)
+{
+	for (const BufferedMessage& message : messages)
+	{
+		switch (message.level)
+		{
+		case ccLog::LOG_WARNING:
+			ccConsole::Warning(message.text);
+			break;
+		case ccLog::LOG_ERROR:
+			ccConsole::Error(message.text);
+			break;
+		default:
+			ccConsole::Print(message.text);
+			break;
+		}
+	}
+}
+
+int ccCommandLineParser::beginProfilingSection(const QString& category, const QString& name)
+{
+	if (!m_profiler)
+	{
+		return -1;
+	}
+
+	return m_profiler->beginSection(category, name, m_profilingDepth++);
+}
+
+void ccCommandLineParser::endProfilingSection(int section, size_t pointCount/*=0*/, size_t triangleCount/*=0*/)
+{
+	if (!m_profiler || section < 0)
+	{
+		return;
+	}
+
+	--m_profilingDepth;
+	m_profiler->endSection(section, pointCount, triangleCount);
+}
+
 int ccCommandLineParser::Parse(int nargs, char** args, ccPluginInterfaceList& plugins)
 {
 	if (args == nullptr || nargs < 2)
@@ -110,8 +489,10 @@ int ccCommandLineParser::Parse(int nargs, char** args, ccPluginInterfaceList& pl
 			continue;
 		}
 
-		plugin->registerCommands(parser.data());
+		parser->registerPluginCommands(plugin);
 	}
+	//the metadata cache is written once for all the plugins
+	ccPluginManager::get().flushMetaDataCache();
 
 	//parse input
 	int result = parser->start(consoleDlg.data());
@@ -144,6 +525,12 @@ ccCommandLineParser::ccCommandLineParser()
 	, m_orphans("orphans")
 	, m_progressDialog(nullptr)
 	, m_parentWidget(nullptr)
+	, m_isWorker(false)
+	, m_isConcurrentWorker(false)
+	, m_stopWhenEmpty(false)
+	, m_dryRun(false)
+	, m_profilingDepth(0)
+	, m_entityCacheVersion(0)
 {
 }
 
@@ -176,6 +563,69 @@ bool ccCommandLineParser::registerCommand(Command::Shared command)
 	return true;
 }
 
+void ccCommandLineParser::registerPluginCommands(ccPluginInterface* plugin)
+{
+	ccPluginManager& pluginManager = ccPluginManager::get();
+
+	if (pluginManager.isDeferred(plugin))
+	{
+		for (const QString& keyword : pluginManager.commandKeywords(plugin))
+		{
+			m_deferredCommands.insert(keyword.toUpper(), plugin);
+		}
+		return;
+	}
+
+	QStringList previousKeywords = m_commands.keys();
+
+	plugin->registerCommands(this);
+
+	//update the metadata cache (so that the plugin can be deferred next time)
+	QStringList keywords;
+	for (const QString& keyword : m_commands.keys())
+	{
+		if (!previousKeywords.contains(keyword))
+		{
+			keywords << keyword;
+		}
+	}
+	pluginManager.setCommandKeywords(plugin, keywords);
+}
+
+bool ccCommandLineParser::loadDeferredCommand(const QString& keyword)
+{
+	ccPluginInterface* plugin = m_deferredCommands.value(keyword);
+	if (!plugin)
+	{
+		assert(false);
+		return false;
+	}
+
+	//all the keywords of this plugin will be registered at once
+	for (auto it = m_deferredCommands.begin(); it != m_deferredCommands.end();)
+	{
+		if (it.value() == plugin)
+			it = m_deferredCommands.erase(it);
+		else
+			++it;
+	}
+
+	if (!ccPluginManager::get().load(plugin))
+	{
+		return error(QString("Failed to load plugin '%1' (required by command '%2')").arg(plugin->getName(), keyword));
+	}
+
+	registerPluginCommands(plugin);
+	ccPluginManager::get().flushMetaDataCache();
+
+	if (!m_commands.contains(keyword))
+	{
+		return error(QString("Plugin '%1' doesn't provide command '%2' anymore").arg(plugin->getName(), keyword));
+	}
+
+	return true;
+}
+
 QString ccCommandLineParser::getExportFilename(	const CLEntityDesc& entityDesc,
 												QString extension/*=QString()*/,
 												QString suffix/*=QString()*/,
@@ -322,13 +772,38 @@ QString ccCommandLineParser::exportEntity(	CLEntityDesc& entityDesc,
 		}
 	}
 
+	//workers can't use a non reentrant filter at the same time
+	QMutex* ioMutex = nullptr;
+	if (m_isWorker)
+	{
+		FileIOFilter::Shared filter = FileIOFilter::GetFilter(format, false);
+		if (!filter || !filter->isReentrant())
+		{
+			ioMutex = &s_nonReentrantIOMutex;
+		}
+	}
+
 #ifdef _DEBUG
 	print("Output filename: " + outputFilename);
 #endif
-	CC_FILE_ERROR result = FileIOFilter::SaveToFile(entity,
-													outputFilename,
-													parameters,
-													format);
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+	{
+		ProfilingScope profiling(*this, "export", outputFilename);
+		if (m_profiler)
+		{
+			size_t pointCount = 0;
+			size_t triangleCount = 0;
+			ccCommandLineProfiler::CountElements(entity, pointCount, triangleCount);
+			profiling.setPointCount(pointCount);
+			profiling.setTriangleCount(triangleCount);
+		}
+
+		QMutexLocker locker(ioMutex);
+		result = FileIOFilter::SaveToFile(	entity,
+											outputFilename,
+											parameters,
+											format);
+	}
 
 	//restore input state!
 	if (tempDependencyCreated)
@@ -371,17 +846,74 @@ void ccCommandLineParser::removeMeshes(bool onlyLast/*=false*/)
 
 bool ccCommandLineParser::importFile(QString filename, FileIOFilter::Shared filter)
 {
+	if (m_dryRun)
+	{
+		//we only list the files
+		m_dryRunFiles.push_back(filename);
+		return true;
+	}
+
 	print(QString("Opening file: '%1'").arg(filename));
 
-	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
-	ccHObject* db = nullptr;
-	if (filter)
+	//server mode: the file may have already been loaded by a previous job
+	QString cacheKey;
+	if (m_entityCache)
 	{
-		db = FileIOFilter::LoadFromFile(filename, m_loadingParameters, filter, result);
+		cacheKey = LoadingKey(m_loadingParameters, filter);
+		std::vector<ccPointCloud*> cachedClouds;
+		if (m_entityCache->acquire(filename, cacheKey, this, m_entityCacheVersion, cachedClouds))
+		{
+			for (size_t i = 0; i < cachedClouds.size(); ++i)
+			{
+				print(QString("Found one cloud with %1 points (cached)").arg(cachedClouds[i]->size()));
+				m_clouds.emplace_back(cachedClouds[i], filename, cachedClouds.size() == 1 ? -1 : static_cast<int>(i));
+			}
+
+			//same output as if the file had been loaded
+			if (!cachedClouds.empty() && m_loadingParameters.coordinatesShiftEnabled && m_loadingParameters.coordinatesShift)
+			{
+				*m_loadingParameters.coordinatesShiftEnabled = cachedClouds.front()->isShifted();
+				*m_loadingParameters.coordinatesShift = cachedClouds.front()->getGlobalShift();
+			}
+			return true;
+		}
 	}
-	else
+	size_t cloudCountBefore = m_clouds.size();
+	size_t meshCountBefore = m_meshes.size();
+
+	//workers can't use a non reentrant filter at the same time
+	QMutex* ioMutex = nullptr;
+	if (m_isWorker)
 	{
-		db = FileIOFilter::LoadFromFile(filename, m_loadingParameters, result, QString());
+		FileIOFilter::Shared actualFilter = (filter ? filter : FileIOFilter::FindBestFilterForExtension(QFileInfo(filename).suffix()));
+		if (!actualFilter || !actualFilter->isReentrant())
+		{
+			ioMutex = &s_nonReentrantIOMutex;
+		}
+	}
+
+	CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+	ccHObject* db = nullptr;
+	{
+		QMutexLocker locker(ioMutex);
+		int section = beginProfilingSection("import", filename);
+
+		if (filter)
+		{
+			db = FileIOFilter::LoadFromFile(filename, m_loadingParameters, filter, result);
+		}
+		else
+		{
+			db = FileIOFilter::LoadFromFile(filename, m_loadingParameters, result, QString());
+		}
+
+		if (section >= 0)
+		{
+			size_t pointCount = 0;
+			size_t triangleCount = 0;
+			ccCommandLineProfiler::CountElements(db, pointCount, triangleCount);
+			endProfilingSection(section, pointCount, triangleCount);
+		}
 	}
 
 	if (!db)
@@ -478,6 +1010,17 @@ bool ccCommandLineParser::importFile(QString filename, FileIOFilter::Shared filt
 	delete db;
 	db = nullptr;
 
+	//server mode: the clouds are cached for the next jobs (only if the file doesn't contain meshes)
+	if (m_entityCache && m_meshes.size() == meshCountBefore && m_clouds.size() > cloudCountBefore)
+	{
+		std::vector<ccPointCloud*> loadedClouds;
+		for (size_t i = cloudCountBefore; i < m_clouds.size(); ++i)
+		{
+			loadedClouds.push_back(m_clouds[i].pc);
+		}
+		m_entityCache->insert(filename, cacheKey, this, m_entityCacheVersion, loadedClouds);
+	}
+
 	return true;
 }
 
@@ -607,7 +1150,11 @@ void ccCommandLineParser::registerBuiltInCommands()
 	registerCommand(Command::Shared(new CommandDropGlobalShift));
 	registerCommand(Command::Shared(new CommandFilterBySFValue));
 	registerCommand(Command::Shared(new CommandMergeClouds));
+	registerCommand(Command::Shared(new CommandReorderPoints));
 	registerCommand(Command::Shared(new CommandMergeMeshes));
+	registerCommand(Command::Shared(new CommandWeldVertices));
+	registerCommand(Command::Shared(new CommandSmoothMesh));
+	registerCommand(Command::Shared(new CommandSubdivideMesh));
 	registerCommand(Command::Shared(new CommandSetActiveSF));
 	registerCommand(Command::Shared(new CommandRemoveAllSF));
 	registerCommand(Command::Shared(new CommandRemoveRGB));
@@ -633,7 +1180,9 @@ void ccCommandLineParser::registerBuiltInCommands()
 	registerCommand(Command::Shared(new CommandSFArithmetic));
 	registerCommand(Command::Shared(new CommandSFOperation));
 	registerCommand(Command::Shared(new CommandSFRename));
+	registerCommand(Command::Shared(new CommandSFInterpolation));
 	registerCommand(Command::Shared(new CommandICP));
+	registerCommand(Command::Shared(new CommandICPBatch));
 	registerCommand(Command::Shared(new CommandChangeCloudOutputFormat));
 	registerCommand(Command::Shared(new CommandChangeMeshOutputFormat));
 	registerCommand(Command::Shared(new CommandChangeHierarchyOutputFormat));
@@ -664,73 +1213,926 @@ void ccCommandLineParser::registerBuiltInCommands()
 
 }
 
+void ccCommandLineParser::countLoadedElements(size_t& pointCount, size_t& triangleCount) const
+{
+	pointCount = triangleCount = 0;
+	for (const CLCloudDesc& desc : m_clouds)
+	{
+		pointCount += (desc.pc ? desc.pc->size() : 0);
+	}
+	for (const CLMeshDesc& desc : m_meshes)
+	{
+		triangleCount += (desc.mesh ? desc.mesh->size() : 0);
+	}
+}
+
 void ccCommandLineParser::cleanup()
 {
 	removeClouds();
 	removeMeshes();
 }
 
-int ccCommandLineParser::start(QDialog* parent/*=0*/)
+ccCommandLineParser* ccCommandLineParser::createWorker(bool concurrent/*=false*/) const
 {
-	if (m_arguments.empty())
+	ccCommandLineParser* worker = new ccCommandLineParser;
+	worker->m_isWorker = true;
+	worker->m_isConcurrentWorker = concurrent;
+	worker->m_commands = m_commands;
+	worker->m_deferredCommands = m_deferredCommands;
+
+	worker->m_cloudExportFormat = m_cloudExportFormat;
+	worker->m_cloudExportExt = m_cloudExportExt;
+	worker->m_meshExportFormat = m_meshExportFormat;
+	worker->m_meshExportExt = m_meshExportExt;
+	worker->m_hierarchyExportFormat = m_hierarchyExportFormat;
+	worker->m_hierarchyExportExt = m_hierarchyExportExt;
+
+	worker->m_silentMode = true; //no dialog in worker threads
+	worker->m_autoSaveMode = m_autoSaveMode;
+	worker->m_addTimestamp = false; //deterministic output filenames
+	worker->m_precision = m_precision;
+	worker->m_loadingParameters = m_loadingParameters;
+	worker->m_loadingParameters.parentWidget = nullptr;
+	//the copied pointers still point to the members of this parser
+	worker->m_loadingParameters.coordinatesShiftEnabled = &worker->m_loadingParameters.m_coordinatesShiftEnabled;
+	worker->m_loadingParameters.coordinatesShift = &worker->m_loadingParameters.m_coordinatesShift;
+	worker->m_coordinatesShiftWasEnabled = m_coordinatesShiftWasEnabled;
+	worker->m_formerCoordinatesShift = m_formerCoordinatesShift;
+	worker->m_profiler = m_profiler;
+
+	return worker;
+}
+
+bool ccCommandLineParser::takeOpenCommands(std::vector<OpenedFile>& files)
+{
+	Command::Shared openCommand = m_commands.value(COMMAND_OPEN);
+	if (!openCommand)
 	{
 		assert(false);
-		return EXIT_FAILURE;
+		return error("Internal error: 'open' command not registered");
 	}
 
-	m_parentWidget = parent;
-	//if (!m_silentMode)
-	//{
-	//	m_progressDialog = new ccProgressDialog(false, parent);
-	//	//m_progressDialog->setAttribute(Qt::WA_DeleteOnClose);
-	//	m_progressDialog->setAutoClose(false);
-	//	m_progressDialog->hide();
-	//}
-
-	QElapsedTimer eTimer;
-	eTimer.start();
+	//we let the 'open' command parse its own options
+	QScopedPointer<ccCommandLineParser> probe(createWorker());
+	probe->m_dryRun = true;
 
-	bool success = true;
-	while (success && !m_arguments.empty())
+	while (!m_arguments.empty() && IsCommand(m_arguments.front(), COMMAND_OPEN))
 	{
-		QApplication::processEvents();	//Without this the console is just a spinner until the end of all processing
-		QString argument = m_arguments.takeFirst();
-
-		if (!argument.startsWith("-"))
+		probe->m_arguments = m_arguments.mid(1);
+		probe->m_dryRunFiles.clear();
+		probe->m_bufferedMessages.clear();
+		if (!openCommand->process(*probe) || probe->m_dryRunFiles.size() != 1)
 		{
-			error(QString("Command expected (commands start with '-'). Found '%1'").arg(argument));
-			success = false;
-			break;
+			FlushMessages(probe->m_bufferedMessages);
+			return error(QString("Invalid '-%1' command").arg(COMMAND_OPEN));
 		}
-		QString keyword = argument.mid(1).toUpper();
 
-		if (m_commands.contains(keyword))
-		{
-			assert(m_commands[keyword]);
-			success = m_commands[keyword]->process(*this);
-		}
-		//silent mode (i.e. no console)
-		else if (keyword == COMMAND_SILENT_MODE)
+		OpenedFile file;
+		file.filename = probe->m_dryRunFiles.front();
+		file.openArguments = m_arguments.mid(0, m_arguments.size() - probe->m_arguments.size());
+		files.push_back(file);
+
+		m_arguments = probe->m_arguments;
+	}
+
+	return true;
+}
+
+bool ccCommandLineParser::processFilesInParallel()
+{
+	print("[PARALLEL FILES]");
+
+	//optional parameters
+	int maxThreadCount = 0;
+	double memoryBudget_MB = 0;
+	while (!m_arguments.empty())
+	{
+		QString argument = m_arguments.front();
+		if (IsCommand(argument, COMMAND_PARALLEL_MAX_THREAD_COUNT))
 		{
-			warning(QString("Misplaced command: '%1' (must be first)").arg(COMMAND_SILENT_MODE));
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
+			{
+				return error(QString("Missing parameter: max thread count after '%1'").arg(COMMAND_PARALLEL_MAX_THREAD_COUNT));
+			}
+			bool ok = false;
+			maxThreadCount = m_arguments.takeFirst().toInt(&ok);
+			if (!ok || maxThreadCount < 0)
+			{
+				return error(QString("Invalid thread count! (after %1)").arg(COMMAND_PARALLEL_MAX_THREAD_COUNT));
+			}
 		}
-		else if (keyword == COMMAND_HELP)
+		else if (IsCommand(argument, COMMAND_PARALLEL_MEM_BUDGET))
 		{
-			print("Available commands:");
-			for (auto it = m_commands.constBegin(); it != m_commands.constEnd(); ++it)
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
 			{
-				print(QString("-%1: %2").arg(it.key().toUpper(), it.value()->m_name));
+				return error(QString("Missing parameter: memory budget (in MB) after '%1'").arg(COMMAND_PARALLEL_MEM_BUDGET));
+			}
+			bool ok = false;
+			memoryBudget_MB = m_arguments.takeFirst().toDouble(&ok);
+			if (!ok || memoryBudget_MB < 0)
+			{
+				return error(QString("Invalid memory budget! (after %1)").arg(COMMAND_PARALLEL_MEM_BUDGET));
 			}
 		}
 		else
 		{
-			error(QString("Unknown or misplaced command: '%1'").arg(argument));
-			success = false;
 			break;
 		}
 	}
 
-	print(QString("Processed finished in %1 s.").arg(eTimer.elapsed() / 1.0e3, 0, 'f', 2));
+	//the leading arguments (settings, etc.) are processed once, as usual
+	{
+		QStringList leadingArguments;
+		while (!m_arguments.empty() && !IsCommand(m_arguments.front(), COMMAND_OPEN))
+		{
+			leadingArguments.push_back(m_arguments.takeFirst());
+		}
+		std::swap(leadingArguments, m_arguments);
+		if (!processCommands())
+		{
+			return false;
+		}
+		m_arguments = leadingArguments;
+	}
+
+	//list the files (with their specific loading options)
+	std::vector<OpenedFile> files;
+	if (!takeOpenCommands(files))
+	{
+		return false;
+	}
+	if (files.empty())
+	{
+		return error(QString("No file to process (the files must be opened with '-%1' after the '-%2' options)").arg(COMMAND_OPEN, COMMAND_PARALLEL_FILES));
+	}
+
+	struct FileJob
+	{
+		QString filename;
+		QStringList openArguments;
+		double fileSize = 0;
+		bool success = false;
+		std::vector<BufferedMessage> messages;
+	};
+	std::vector<FileJob> jobs;
+	jobs.reserve(files.size());
+	for (const OpenedFile& file : files)
+	{
+		FileJob job;
+		job.filename = file.filename;
+		job.openArguments = file.openArguments;
+		job.fileSize = static_cast<double>(QFileInfo(job.filename).size());
+		jobs.push_back(job);
+	}
+
+	//the remaining arguments are applied to each file after loading it
+	const QStringList trailingArguments = m_arguments;
+	m_arguments.clear();
+	for (const QString& argument : trailingArguments)
+	{
+		if (IsCommand(argument, COMMAND_OPEN))
+		{
+			return error(QString("Misplaced command: '-%1' (in parallel mode, the files must be opened one after the other)").arg(COMMAND_OPEN));
+		}
+
+		//check all the commands before starting any worker (the other arguments are local options or values)
+		if (!argument.startsWith("-"))
+		{
+			continue;
+		}
+		QString keyword = argument.mid(1).toUpper();
+		if (	(m_commands.contains(keyword) || m_deferredCommands.contains(keyword))
+			&&	!s_concurrentCommands.contains(keyword)
+			&&	!s_exclusiveCommands.contains(keyword))
+		{
+			return error(QString("Command '%1' can't be run concurrently on several files (the settings commands must be placed before the files)").arg(argument));
+		}
+	}
+
+	{
+		QSet<QString> filenames;
+		for (const FileJob& job : jobs)
+		{
+			QString absoluteFilename = QFileInfo(job.filename).absoluteFilePath();
+			if (filenames.contains(absoluteFilename))
+			{
+				warning(QString("File '%1' is opened several times: its output files will be overwritten").arg(job.filename));
+			}
+			filenames.insert(absoluteFilename);
+		}
+	}
+
+	if (m_addTimestamp)
+	{
+		print("Output files won't be timestamped in parallel mode");
+	}
+
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(maxThreadCount > 0 ? maxThreadCount : QThread::idealThreadCount());
+	print(QString("Processing %1 file(s) with up to %2 thread(s)").arg(jobs.size()).arg(threadPool.maxThreadCount()));
+	if (memoryBudget_MB > 0)
+	{
+		print(QString("Memory budget: %1 MB").arg(memoryBudget_MB));
+	}
+
+	MemoryBudget memoryBudget(memoryBudget_MB * (1 << 20));
+
+	auto processFile = [&](FileJob& job)
+	{
+		double reservedMemory = memoryBudget.acquire(job.fileSize);
+
+		QScopedPointer<ccCommandLineParser> worker(createWorker(true));
+		try
+		{
+			worker->m_arguments = job.openArguments;
+			job.success = worker->processCommands();
+
+			if (job.success)
+			{
+				//the memory actually used by the loaded entities refines the prediction
+				memoryBudget.update(job.fileSize, reservedMemory, LoadedMemory(*worker) * s_parallelMemoryFactor);
+
+				worker->m_arguments = trailingArguments;
+				job.success = worker->processCommands();
+			}
+		}
+		catch (const std::bad_alloc&)
+		{
+			job.success = worker->error("Not enough memory");
+		}
+
+		worker->cleanup();
+		job.messages = std::move(worker->m_bufferedMessages);
+		worker.reset();
+
+		memoryBudget.release(reservedMemory);
+	};
+
+	std::vector< QFuture<void> > futures;
+	futures.reserve(jobs.size());
+	for (FileJob& job : jobs)
+	{
+		futures.push_back(QtConcurrent::run(&threadPool, [&processFile, &job]() { processFile(job); }));
+	}
+
+	//display the messages in the input order
+	size_t failedCount = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		if (silentMode())
+		{
+			futures[i].waitForFinished();
+		}
+		else
+		{
+			//the console must remain responsive
+			QFutureWatcher<void> watcher;
+			QEventLoop loop;
+			QObject::connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+			watcher.setFuture(futures[i]);
+			if (!watcher.isFinished())
+			{
+				loop.exec();
+			}
+		}
+
+		print(QString("[PARALLEL FILES] File %1/%2: '%3'").arg(i + 1).arg(jobs.size()).arg(jobs[i].filename));
+		FlushMessages(jobs[i].messages);
+		jobs[i].messages.clear();
+
+		if (!jobs[i].success)
+		{
+			++failedCount;
+		}
+	}
+
+	if (failedCount != 0)
+	{
+		return error(QString("%1 file(s) out of %2 could not be processed").arg(failedCount).arg(jobs.size()));
+	}
+
+	return true;
+}
+
+bool ccCommandLineParser::processFilesAsStreams()
+{
+	print("[STREAM]");
+
+	//optional parameters
+	unsigned chunkSize = s_defaultStreamChunkSize;
+	unsigned seed = std::random_device()();
+	bool fixedSeed = false;
+	while (!m_arguments.empty())
+	{
+		QString argument = m_arguments.front();
+		if (IsCommand(argument, COMMAND_STREAM_CHUNK_SIZE))
+		{
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
+			{
+				return error(QString("Missing parameter: number of points per chunk after '%1'").arg(COMMAND_STREAM_CHUNK_SIZE));
+			}
+			bool ok = false;
+			chunkSize = m_arguments.takeFirst().toUInt(&ok);
+			if (!ok || chunkSize == 0)
+			{
+				return error(QString("Invalid chunk size! (after %1)").arg(COMMAND_STREAM_CHUNK_SIZE));
+			}
+		}
+		else if (IsCommand(argument, COMMAND_STREAM_SEED))
+		{
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
+			{
+				return error(QString("Missing parameter: seed value after '%1'").arg(COMMAND_STREAM_SEED));
+			}
+			bool ok = false;
+			seed = m_arguments.takeFirst().toUInt(&ok);
+			if (!ok)
+			{
+				return error(QString("Invalid seed value! (after %1)").arg(COMMAND_STREAM_SEED));
+			}
+			fixedSeed = true;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	//the leading arguments (settings, etc.) are processed once, as usual
+	{
+		QStringList leadingArguments;
+		while (!m_arguments.empty() && !IsCommand(m_arguments.front(), COMMAND_OPEN))
+		{
+			leadingArguments.push_back(m_arguments.takeFirst());
+		}
+		std::swap(leadingArguments, m_arguments);
+		if (!processCommands())
+		{
+			return false;
+		}
+		m_arguments = leadingArguments;
+	}
+
+	//list the files (with their specific loading options)
+	std::vector<OpenedFile> files;
+	if (!takeOpenCommands(files))
+	{
+		return false;
+	}
+	if (files.empty())
+	{
+		return error(QString("No file to process (the files must be opened with '-%1' after the '-%2' options)").arg(COMMAND_OPEN, COMMAND_STREAM));
+	}
+
+	//the remaining arguments are applied to each chunk: they must be 'point-local',
+	//except for a random subsampling, after which they are applied to the sampled points
+	QStringList chunkArguments = m_arguments;
+	QStringList sampleArguments;
+	unsigned sampleSize = 0;
+	m_arguments.clear();
+	for (int i = 0; i < chunkArguments.size(); ++i)
+	{
+		const QString& argument = chunkArguments[i];
+		if (!argument.startsWith("-"))
+		{
+			//command parameter
+			continue;
+		}
+
+		if (IsCommand(argument, COMMAND_OPEN))
+		{
+			return error(QString("Misplaced command: '-%1' (in streaming mode, the files must be opened one after the other)").arg(COMMAND_OPEN));
+		}
+
+		if (	IsCommand(argument, COMMAND_SUBSAMPLE)
+			&&	i + 2 < chunkArguments.size()
+			&&	chunkArguments[i + 1].toUpper() == COMMAND_SUBSAMPLE_RANDOM)
+		{
+			bool ok = false;
+			sampleSize = chunkArguments[i + 2].toUInt(&ok);
+			if (!ok || sampleSize == 0)
+			{
+				return error(QString("Invalid number of points for random resampling!"));
+			}
+			sampleArguments = chunkArguments.mid(i + 3);
+			chunkArguments = chunkArguments.mid(0, i);
+			break;
+		}
+
+		QString keyword = argument.mid(1).toUpper();
+		if (m_deferredCommands.contains(keyword) && !loadDeferredCommand(keyword))
+		{
+			return false;
+		}
+
+		Command::Shared command = m_commands.value(keyword);
+		if (command && !command->isPointLocal(chunkArguments.mid(i + 1)))
+		{
+			return error(QString("Command '%1' can't be applied chunk by chunk (only point-local commands and '-%2 %3' are supported in streaming mode)").arg(argument, COMMAND_SUBSAMPLE, COMMAND_SUBSAMPLE_RANDOM));
+		}
+	}
+
+	print(QString("Processing %1 file(s) by chunks of %2 point(s)").arg(files.size()).arg(chunkSize));
+	if (sampleSize != 0)
+	{
+		print(QString("Random subsampling: %1 point(s) per file (seed: %2)").arg(sampleSize).arg(seed));
+	}
+	else if (fixedSeed)
+	{
+		warning(QString("'%1' is only used by the random subsampling").arg(COMMAND_STREAM_SEED));
+	}
+
+	for (size_t fileIndex = 0; fileIndex < files.size(); ++fileIndex)
+	{
+		const OpenedFile& file = files[fileIndex];
+		print(QString("[STREAM] File %1/%2: '%3'").arg(fileIndex + 1).arg(files.size()).arg(file.filename));
+
+		FileIOFilter::Shared inputFilter = FileIOFilter::FindStreamingFilterForExtension(QFileInfo(file.filename).suffix(), true);
+		if (!inputFilter)
+		{
+			return error(QString("The format of file '%1' can't be read chunk by chunk (only ASCII, PLY and LAS files are supported in streaming mode)").arg(file.filename));
+		}
+
+		//the 'open' command options (Global Shift, etc.) are applied to the loading parameters
+		QScopedPointer<ccCommandLineParser> setup(createWorker());
+		setup->m_dryRun = true;
+		setup->m_arguments = file.openArguments;
+		bool setupSuccess = setup->processCommands();
+		FlushMessages(setup->m_bufferedMessages);
+		if (!setupSuccess)
+		{
+			return false;
+		}
+
+		CC_FILE_ERROR result = CC_FERR_NO_ERROR;
+		FileIOFilter::ChunkReader::Shared reader = inputFilter->openChunkReader(file.filename, setup->m_loadingParameters, result);
+		if (!reader)
+		{
+			FileIOFilter::DisplayErrorMessage(result, "reading", file.filename);
+			return error(QString("Failed to open file '%1'").arg(file.filename));
+		}
+
+		QScopedPointer<PointReservoir> reservoir(sampleSize != 0 ? new PointReservoir(sampleSize, seed) : nullptr);
+		FileIOFilter::ChunkWriter::Shared writer;
+		QString outputFilename;
+		size_t readCount = 0;
+		size_t writtenCount = 0;
+		QString basename;
+		QString path;
+
+		for (unsigned chunkIndex = 0; ; ++chunkIndex)
+		{
+			ccPointCloud* chunk = nullptr;
+			{
+				ProfilingScope profiling(*this, "import", file.filename);
+				chunk = reader->readChunk(chunkSize, result);
+				profiling.setPointCount(chunk ? chunk->size() : 0);
+			}
+			if (!chunk)
+			{
+				if (result != CC_FERR_NO_ERROR)
+				{
+					FileIOFilter::DisplayErrorMessage(result, "reading", file.filename);
+					return error(QString("Failed to read file '%1'").arg(file.filename));
+				}
+				//end of file
+				break;
+			}
+			readCount += chunk->size();
+
+			QScopedPointer<ccCommandLineParser> worker(createWorker());
+			worker->m_autoSaveMode = false; //only the final points are saved
+			worker->m_stopWhenEmpty = true; //e.g. if the chunk is entirely cropped
+			worker->m_addTimestamp = m_addTimestamp;
+			worker->m_clouds.emplace_back(chunk, file.filename, -1);
+
+			worker->m_arguments = chunkArguments;
+			bool success = false;
+			try
+			{
+				success = worker->processCommands();
+			}
+			catch (const std::bad_alloc&)
+			{
+				success = worker->error("Not enough memory");
+			}
+
+			//the messages of the first chunk are displayed entirely (then only the warnings and errors)
+			if (chunkIndex != 0)
+			{
+				auto isStandard = [](const BufferedMessage& message) { return (message.level & (ccLog::LOG_WARNING | ccLog::LOG_ERROR)) == 0; };
+				worker->m_bufferedMessages.erase(std::remove_if(worker->m_bufferedMessages.begin(), worker->m_bufferedMessages.end(), isStandard), worker->m_bufferedMessages.end());
+			}
+			FlushMessages(worker->m_bufferedMessages);
+			worker->m_bufferedMessages.clear();
+
+			if (!success)
+			{
+				worker->cleanup();
+				return error(QString("Failed to process chunk #%1 of file '%2'").arg(chunkIndex + 1).arg(file.filename));
+			}
+			if (worker->m_clouds.size() > 1 || !worker->m_meshes.empty())
+			{
+				worker->cleanup();
+				return error("In streaming mode, the commands must output a single cloud per chunk");
+			}
+
+			if (!worker->m_clouds.empty() && worker->m_clouds.front().pc->size() != 0)
+			{
+				CLCloudDesc& desc = worker->m_clouds.front();
+				if (reservoir)
+				{
+					//the commands may have changed the base name
+					basename = desc.basename;
+					path = desc.path;
+
+					bool added = reservoir->add(desc.pc);
+					desc.pc = nullptr;
+					if (!added)
+					{
+						worker->cleanup();
+						return error("Not enough memory");
+					}
+				}
+				else
+				{
+					if (!writer)
+					{
+						//the output format is the one set by the commands (on the first chunk)
+						//(another filter may handle the same extension chunk by chunk, e.g. LAS files)
+						FileIOFilter::Shared outputFilter = FileIOFilter::GetFilter(worker->m_cloudExportFormat, false);
+						if (!outputFilter || !outputFilter->streamingSupported())
+						{
+							outputFilter = FileIOFilter::FindStreamingFilterForExtension(worker->m_cloudExportExt, false);
+						}
+						if (!outputFilter)
+						{
+							worker->cleanup();
+							return error(QString("The cloud export format '%1' can't be written chunk by chunk (only the ASCII, PLY and LAS formats are supported in streaming mode, see -C_EXPORT_FMT)").arg(worker->m_cloudExportFormat));
+						}
+
+						outputFilename = worker->getExportFilename(desc, worker->m_cloudExportExt, "STREAMED");
+						FileIOFilter::SaveParameters saveParameters;
+						saveParameters.alwaysDisplaySaveDialog = false;
+						writer = outputFilter->openChunkWriter(outputFilename, saveParameters, result);
+						if (!writer)
+						{
+							worker->cleanup();
+							FileIOFilter::DisplayErrorMessage(result, "saving", outputFilename);
+							return error(QString("Failed to save result in file '%1'").arg(outputFilename));
+						}
+					}
+
+					{
+						ProfilingScope profiling(*this, "export", outputFilename);
+						profiling.setPointCount(desc.pc->size());
+						result = writer->writeChunk(*desc.pc);
+					}
+					if (result != CC_FERR_NO_ERROR)
+					{
+						worker->cleanup();
+						FileIOFilter::DisplayErrorMessage(result, "saving", outputFilename);
+						return error(QString("Failed to save result in file '%1'").arg(outputFilename));
+					}
+					writtenCount += desc.pc->size();
+				}
+			}
+
+			worker->cleanup();
+			print(QString("\tChunk #%1 processed (%2 point(s) read so far)").arg(chunkIndex + 1).arg(readCount));
+		}
+
+		if (writer)
+		{
+			result = writer->close();
+			if (result != CC_FERR_NO_ERROR)
+			{
+				FileIOFilter::DisplayErrorMessage(result, "saving", outputFilename);
+				return error(QString("Failed to save result in file '%1'").arg(outputFilename));
+			}
+			print(QString("%1 point(s) read, %2 point(s) saved in file '%3'").arg(readCount).arg(writtenCount).arg(outputFilename));
+		}
+		else if (!reservoir)
+		{
+			warning(QString("%1 point(s) read, no point to save").arg(readCount));
+		}
+
+		if (reservoir)
+		{
+			ccPointCloud* sample = reservoir->takeCloud();
+			if (!sample)
+			{
+				warning(QString("%1 point(s) read, no point to subsample").arg(readCount));
+				continue;
+			}
+			print(QString("%1 point(s) read, %2 point(s) randomly sampled").arg(readCount).arg(sample->size()));
+
+			//the sampled points are then processed as a regular cloud
+			QScopedPointer<ccCommandLineParser> worker(createWorker());
+			worker->m_addTimestamp = m_addTimestamp;
+			worker->m_clouds.emplace_back(sample, basename, path, -1);
+
+			bool success = true;
+			try
+			{
+				if (m_autoSaveMode)
+				{
+					QString errorStr = worker->exportEntity(worker->m_clouds.back(), "RANDOM_SUBSAMPLED");
+					if (!errorStr.isEmpty())
+					{
+						success = worker->error(errorStr);
+					}
+				}
+				if (success)
+				{
+					worker->m_arguments = sampleArguments;
+					success = worker->processCommands();
+				}
+			}
+			catch (const std::bad_alloc&)
+			{
+				success = worker->error("Not enough memory");
+			}
+
+			worker->cleanup();
+			FlushMessages(worker->m_bufferedMessages);
+			if (!success)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool ccCommandLineParser::processServer()
+{
+	print("[SERVER]");
+
+	//optional parameters
+	ccCommandLineServer::Parameters parameters;
+	while (!m_arguments.empty())
+	{
+		QString argument = m_arguments.front();
+		if (IsCommand(argument, COMMAND_SERVER_NAME))
+		{
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
+			{
+				return error(QString("Missing parameter: server name after '%1'").arg(COMMAND_SERVER_NAME));
+			}
+			parameters.name = m_arguments.takeFirst();
+		}
+		else if (IsCommand(argument, COMMAND_PARALLEL_MAX_THREAD_COUNT))
+		{
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
+			{
+				return error(QString("Missing parameter: max number of concurrent jobs after '%1'").arg(COMMAND_PARALLEL_MAX_THREAD_COUNT));
+			}
+			bool ok = false;
+			parameters.maxJobCount = m_arguments.takeFirst().toInt(&ok);
+			if (!ok || parameters.maxJobCount < 0)
+			{
+				return error(QString("Invalid number of jobs! (after %1)").arg(COMMAND_PARALLEL_MAX_THREAD_COUNT));
+			}
+		}
+		else if (IsCommand(argument, COMMAND_PARALLEL_MEM_BUDGET))
+		{
+			//local option confirmed, we can move on
+			m_arguments.pop_front();
+
+			if (m_arguments.empty())
+			{
+				return error(QString("Missing parameter: cache memory budget (in MB) after '%1'").arg(COMMAND_PARALLEL_MEM_BUDGET));
+			}
+			bool ok = false;
+			parameters.cacheBudget_MB = m_arguments.takeFirst().toDouble(&ok);
+			if (!ok || parameters.cacheBudget_MB < 0)
+			{
+				return error(QString("Invalid memory budget! (after %1)").arg(COMMAND_PARALLEL_MEM_BUDGET));
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	//the remaining arguments (settings, etc.) are processed once
+	if (!processCommands())
+	{
+		return false;
+	}
+	if (!m_clouds.empty() || !m_meshes.empty())
+	{
+		warning("The entities loaded before the server starts are not available to the jobs");
+	}
+
+	ccCommandLineServer server(*this, parameters);
+	return server.run();
+}
+
+bool ccCommandLineParser::processCommands()
+{
+	while (!m_arguments.empty())
+	{
+		if (!m_isWorker)
+		{
+			QApplication::processEvents();	//Without this the console is just a spinner until the end of all processing
+		}
+		QString argument = m_arguments.takeFirst();
+
+		if (!argument.startsWith("-"))
+		{
+			return error(QString("Command expected (commands start with '-'). Found '%1'").arg(argument));
+		}
+		QString keyword = argument.mid(1).toUpper();
+
+		//concurrent workers only run the commands known to be thread-safe
+		//(checked before loading a deferred plugin, as this is not thread-safe either)
+		QMutex* commandMutex = nullptr;
+		if (m_isConcurrentWorker && (m_commands.contains(keyword) || m_deferredCommands.contains(keyword)))
+		{
+			if (s_exclusiveCommands.contains(keyword))
+			{
+				commandMutex = &s_exclusiveCommandMutex;
+			}
+			else if (!s_concurrentCommands.contains(keyword))
+			{
+				return error(QString("Command '%1' can't be run concurrently on several files (the settings commands must be placed before the files)").arg(argument));
+			}
+		}
+
+		if (m_deferredCommands.contains(keyword) && !loadDeferredCommand(keyword))
+		{
+			return false;
+		}
+
+		if (m_commands.contains(keyword))
+		{
+			assert(m_commands[keyword]);
+
+			//the throughput is computed relatively to the input or output entities (the largest)
+			size_t pointCount = 0;
+			size_t triangleCount = 0;
+			int section = beginProfilingSection("command", argument.toUpper());
+			if (section >= 0)
+			{
+				countLoadedElements(pointCount, triangleCount);
+			}
+
+			bool success = false;
+			{
+				QMutexLocker locker(commandMutex);
+				success = m_commands[keyword]->process(*this);
+			}
+			if (m_entityCache && !s_readOnlyCommands.contains(keyword))
+			{
+				//the cached clouds may have been modified
+				++m_entityCacheVersion;
+			}
+
+			if (section >= 0)
+			{
+				size_t outputPointCount = 0;
+				size_t outputTriangleCount = 0;
+				countLoadedElements(outputPointCount, outputTriangleCount);
+				endProfilingSection(section, std::max(pointCount, outputPointCount), std::max(triangleCount, outputTriangleCount));
+			}
+
+			if (!success)
+			{
+				return false;
+			}
+
+			if (m_stopWhenEmpty && m_clouds.empty() && m_meshes.empty())
+			{
+				//nothing left to process (the remaining commands are skipped)
+				m_arguments.clear();
+				break;
+			}
+		}
+		//silent mode (i.e. no console)
+		else if (keyword == COMMAND_SILENT_MODE)
+		{
+			warning(QString("Misplaced command: '%1' (must be first)").arg(COMMAND_SILENT_MODE));
+		}
+		else if (keyword == COMMAND_PARALLEL_FILES || keyword == COMMAND_STREAM || keyword == COMMAND_SERVER || keyword == COMMAND_PROFILE)
+		{
+			return error(QString("Misplaced command: '%1' (must be first, or right after '%2')").arg(keyword, COMMAND_SILENT_MODE));
+		}
+		else if (keyword == COMMAND_HELP)
+		{
+			print("Available commands:");
+			for (auto it = m_commands.constBegin(); it != m_commands.constEnd(); ++it)
+			{
+				print(QString("-%1: %2").arg(it.key().toUpper(), it.value()->m_name));
+			}
+			for (auto it = m_deferredCommands.constBegin(); it != m_deferredCommands.constEnd(); ++it)
+			{
+				print(QString("-%1: (plugin '%2')").arg(it.key(), it.value()->getName()));
+			}
+		}
+		else
+		{
+			return error(QString("Unknown or misplaced command: '%1'").arg(argument));
+		}
+	}
+
+	return true;
+}
+
+int ccCommandLineParser::start(QDialog* parent/*=0*/)
+{
+	if (m_arguments.empty())
+	{
+		assert(false);
+		return EXIT_FAILURE;
+	}
+
+	m_parentWidget = parent;
+	//if (!m_silentMode)
+	//{
+	//	m_progressDialog = new ccProgressDialog(false, parent);
+	//	//m_progressDialog->setAttribute(Qt::WA_DeleteOnClose);
+	//	m_progressDialog->setAutoClose(false);
+	//	m_progressDialog->hide();
+	//}
+
+	QElapsedTimer eTimer;
+	eTimer.start();
+
+	//specific command: profiling (must be first)
+	if (IsCommand(m_arguments.front(), COMMAND_PROFILE))
+	{
+		m_arguments.pop_front();
+		if (m_arguments.empty())
+		{
+			error(QString("Missing parameter: report filename after '%1'").arg(COMMAND_PROFILE));
+			return EXIT_FAILURE;
+		}
+		m_profilingReportFilename = m_arguments.takeFirst();
+		m_profiler.reset(new ccCommandLineProfiler);
+		print(QString("Profiling enabled (report: '%1')").arg(m_profilingReportFilename));
+	}
+
+	bool success = false;
+	//specific command: parallel mode (must be first)
+	if (!m_arguments.empty() && IsCommand(m_arguments.front(), COMMAND_PARALLEL_FILES))
+	{
+		m_arguments.pop_front();
+		success = processFilesInParallel();
+	}
+	//specific command: streaming mode (must be first)
+	else if (!m_arguments.empty() && IsCommand(m_arguments.front(), COMMAND_STREAM))
+	{
+		m_arguments.pop_front();
+		success = processFilesAsStreams();
+	}
+	//specific command: server mode (must be first)
+	else if (!m_arguments.empty() && IsCommand(m_arguments.front(), COMMAND_SERVER))
+	{
+		m_arguments.pop_front();
+		success = processServer();
+	}
+	else
+	{
+		success = processCommands();
+	}
+
+	print(QString("Processed finished in %1 s.").arg(eTimer.elapsed() / 1.0e3, 0, 'f', 2));
+
+	//the report is saved even if the process failed
+	if (m_profiler)
+	{
+		QString errorMessage;
+		if (m_profiler->saveReport(m_profilingReportFilename, errorMessage))
+		{
+			print(QString("Profiling report saved: '%1'").arg(m_profilingReportFilename));
+		}
+		else
+		{
+			warning(errorMessage);
+		}
+	}
 
 	return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -5,8 +5,14 @@
 #include "ccCommandLineInterface.h"
 
 //Local
+#include "ccCommandLineEntityCache.h"
+#include "ccCommandLineProfiler.h"
 #include "ccPluginManager.h"
 
+//system
+#include <vector>
+
+class ccCommandLineServer;
 class ccProgressDialog;
 class QDialog;
 
@@ -52,6 +58,8 @@ public:
 	void setCloudExportFormat(QString format, QString ext) override { m_cloudExportFormat = format; m_cloudExportExt = ext; }
 	void setMeshExportFormat(QString format, QString ext) override { m_meshExportFormat = format; m_meshExportExt = ext; }
 	void setHierarchyExportFormat(QString format, QString ext) override { m_hierarchyExportFormat = format; m_hierarchyExportExt = ext; }
+	int beginProfilingSection(const QString& category, const QString& name) override;
+	void endProfilingSection(int section, size_t pointCount = 0, size_t triangleCount = 0) override;
 
 protected: //other methods
 
@@ -61,14 +69,95 @@ protected: //other methods
 	ccCommandLineParser();
    
    void  registerBuiltInCommands();
+
+	//! Registers the commands of a plugin
+	/** If the plugin is deferred (see ccPluginManager), its commands are only registered
+		(and its library loaded) the first time one of its keywords is actually used.
+	**/
+	void registerPluginCommands(ccPluginInterface* plugin);
+
+	//! Loads the (deferred) plugin of a keyword and registers its commands
+	bool loadDeferredCommand(const QString& keyword);
    
    void  cleanup();
 
+	//! Returns the total number of points and triangles of the loaded clouds and meshes (profiling)
+	void countLoadedElements(size_t& pointCount, size_t& triangleCount) const;
+
 	//! Parses the command line
 	int start(QDialog* parent = nullptr);
 
+	//! Processes the (remaining) commands sequentially
+	bool processCommands();
+
+	//! Processes each file as an independent pipeline, concurrently (see COMMAND_PARALLEL_FILES)
+	/** The leading arguments (before the first 'open' command) are processed once, as usual.
+		The trailing ones (after the last 'open' command) are applied to each file separately,
+		and must be supported by the concurrent workers (see createWorker).
+		The output files are never timestamped (so that their names are deterministic)
+		and the messages of each file are displayed as a block, in the input order.
+	**/
+	bool processFilesInParallel();
+
+	//! Processes each file as a stream of chunks of points (see COMMAND_STREAM)
+	/** The leading arguments (before the first 'open' command) are processed once, as usual.
+		The trailing ones (after the last 'open' command) are applied to each chunk of
+		each file, and must therefore be point-local (see Command::isPointLocal). The only
+		exception is a random subsampling ('-SS RANDOM'): the chunks then feed a reservoir
+		of points, and the remaining commands are applied to the sampled cloud as usual.
+		Otherwise, the resulting chunks are saved one after the other (in a single file).
+		A chunk that gets empty (e.g. entirely cropped) simply skips the remaining commands.
+		Only the formats supporting chunked I/O can be used (see FileIOFilter::streamingSupported).
+		The memory consumption is therefore bounded by the chunk size (or the sample size).
+	**/
+	bool processFilesAsStreams();
+
+	//! File opened by an 'open' command (parallel and streaming modes)
+	struct OpenedFile
+	{
+		//! Filename
+		QString filename;
+		//! 'open' command arguments (including the filename)
+		QStringList openArguments;
+	};
+
+	//! Runs the local processing server (see COMMAND_SERVER and ccCommandLineServer)
+	/** The arguments following the server options are processed once, before
+		the server starts (the jobs then start with the resulting settings).
+	**/
+	bool processServer();
+
+	//! Takes the consecutive 'open' commands at the beginning of the remaining arguments (parallel and streaming modes)
+	/** The files are not loaded.
+	**/
+	bool takeOpenCommands(std::vector<OpenedFile>& files);
+
+	//! Creates a worker parser (parallel, streaming and server modes)
+	/** The worker shares the registered commands and the current settings of this parser.
+		A concurrent worker (i.e. running at the same time as other workers) only accepts
+		the commands known to be thread-safe, and runs the ones relying on multi-threaded
+		octree passes one at a time.
+		\param concurrent whether the worker runs concurrently with other workers
+	**/
+	ccCommandLineParser* createWorker(bool concurrent = false) const;
+
+	//! Buffered message (parallel mode)
+	struct BufferedMessage
+	{
+		//! Message level (see ccLog::MessageLevelFlags)
+		int level;
+		//! Message
+		QString text;
+	};
+
+	//! Flushes buffered messages to the console (parallel mode)
+	static void FlushMessages(const std::vector<BufferedMessage>& messages);
+
 private: //members
 
+	//the server manages its own workers
+	friend class ccCommandLineServer;
+
 	//! Current cloud(s) export format (can be modified with the 'COMMAND_CLOUD_EXPORT_FORMAT' option)
 	QString m_cloudExportFormat;
 	//! Current cloud(s) export extension (warning: can be anything)
@@ -91,6 +180,9 @@ private: //members
 	//! Registered commands
 	QMap< QString, Command::Shared > m_commands;
 
+	//! Keywords of the deferred plugins (their commands are not registered yet)
+	QMap< QString, ccPluginInterface* > m_deferredCommands;
+
 	//! Oprhan entities
 	ccHObject m_orphans;
 
@@ -99,6 +191,38 @@ private: //members
 
 	//! Widget parent
 	QDialog* m_parentWidget;
+
+	//! Whether this parser is a worker (parallel mode)
+	/** A worker buffers its messages, never processes the application events
+		and serializes its I/O with the other workers for non reentrant filters.
+	**/
+	bool m_isWorker;
+
+	//! Whether this parser is a concurrent worker (see createWorker)
+	bool m_isConcurrentWorker;
+
+	//! Whether the remaining commands should be skipped once no entity is loaded (streaming mode)
+	bool m_stopWhenEmpty;
+
+	//! Whether files should only be listed instead of being loaded (parallel mode)
+	bool m_dryRun;
+	//! Files listed in 'dry run' mode
+	QStringList m_dryRunFiles;
+
+	//! Buffered messages (parallel mode)
+	mutable std::vector<BufferedMessage> m_bufferedMessages;
+
+	//! Profiler (see COMMAND_PROFILE, shared with the workers)
+	ccCommandLineProfiler::Shared m_profiler;
+	//! Current profiling sections depth
+	int m_profilingDepth;
+	//! Profiling report filename
+	QString m_profilingReportFilename;
+
+	//! Cache of the loaded clouds (server mode only)
+	ccCommandLineEntityCache::Shared m_entityCache;
+	//! Number of commands that may have modified the loaded entities (server mode only, see ccCommandLineEntityCache)
+	unsigned m_entityCacheVersion;
 };
 
 #endif
@@ -0,0 +1,295 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccCommandLineProfiler.h"
+
+//qCC_db
+#include <ccGenericMesh.h>
+#include <ccGenericPointCloud.h>
+#include <ccHObjectCaster.h>
+
+//Qt
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+//system
+#include <cassert>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+ccCommandLineProfiler::ccCommandLineProfiler()
+	: m_cpuTimeAtStart_s(ProcessCPUTime())
+{
+	m_timer.start();
+}
+
+int ccCommandLineProfiler::beginSection(const QString& category, const QString& name, int depth)
+{
+	Record record;
+	record.section.category = category;
+	record.section.name = name;
+	record.section.depth = depth;
+	record.cpuTimeAtStart_s = ProcessCPUTime();
+	record.peakMemoryAtStart_MB = ProcessPeakMemory();
+
+	QMutexLocker locker(&m_mutex);
+
+	Qt::HANDLE threadID = QThread::currentThreadId();
+	auto it = m_threadIndexes.find(threadID);
+	if (it == m_threadIndexes.end())
+	{
+		it = m_threadIndexes.insert(threadID, m_threadIndexes.size());
+	}
+	record.section.threadIndex = it.value();
+
+	//we read the timer last, so that the profiling overhead is not included
+	record.section.startTime_s = m_timer.nsecsElapsed() / 1.0e9;
+	m_records.push_back(record);
+
+	return static_cast<int>(m_records.size()) - 1;
+}
+
+void ccCommandLineProfiler::endSection(int section, size_t pointCount, size_t triangleCount)
+{
+	double endTime_s = m_timer.nsecsElapsed() / 1.0e9;
+	double cpuTime_s = ProcessCPUTime();
+	double peakMemory_MB = ProcessPeakMemory();
+
+	QMutexLocker locker(&m_mutex);
+
+	if (section < 0 || static_cast<size_t>(section) >= m_records.size())
+	{
+		assert(false);
+		return;
+	}
+
+	Record& record = m_records[section];
+	record.section.wallTime_s = endTime_s - record.section.startTime_s;
+	record.section.cpuTime_s = cpuTime_s - record.cpuTimeAtStart_s;
+	record.section.peakMemoryIncrease_MB = peakMemory_MB - record.peakMemoryAtStart_MB;
+	record.section.pointCount = pointCount;
+	record.section.triangleCount = triangleCount;
+	record.section.finished = true;
+}
+
+void ccCommandLineProfiler::CountElements(const ccHObject* entity, size_t& pointCount, size_t& triangleCount)
+{
+	pointCount = triangleCount = 0;
+	if (!entity)
+	{
+		return;
+	}
+
+	ccHObject::Container clouds;
+	entity->filterChildren(clouds, true, CC_TYPES::POINT_CLOUD, false);
+	ccHObject::Container meshes;
+	entity->filterChildren(meshes, true, CC_TYPES::MESH, true); //strict, to ignore the sub-meshes
+	if (entity->isKindOf(CC_TYPES::POINT_CLOUD))
+	{
+		clouds.push_back(const_cast<ccHObject*>(entity));
+	}
+	else if (entity->isA(CC_TYPES::MESH))
+	{
+		meshes.push_back(const_cast<ccHObject*>(entity));
+	}
+
+	for (ccHObject* cloud : clouds)
+	{
+		pointCount += static_cast<ccGenericPointCloud*>(cloud)->size();
+	}
+	for (ccHObject* mesh : meshes)
+	{
+		triangleCount += ccHObjectCaster::ToGenericMesh(mesh)->size();
+	}
+}
+
+double ccCommandLineProfiler::ProcessCPUTime()
+{
+#ifdef _WIN32
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return 0.0;
+	}
+	auto toSeconds = [](const FILETIME& time) { return ((static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1.0e7; }; //100 ns units
+	return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0.0;
+	}
+	return	usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1.0e6
+		+	usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1.0e6;
+#endif
+}
+
+double ccCommandLineProfiler::ProcessPeakMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0.0;
+	}
+	return counters.PeakWorkingSetSize / static_cast<double>(1 << 20);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0.0;
+	}
+#ifdef __APPLE__
+	return usage.ru_maxrss / static_cast<double>(1 << 20); //bytes
+#else
+	return usage.ru_maxrss / 1024.0; //kilobytes
+#endif
+#endif
+}
+
+bool ccCommandLineProfiler::saveReport(const QString& filename, QString& errorMessage) const
+{
+	if (QFileInfo(filename).suffix().compare("csv", Qt::CaseInsensitive) == 0)
+	{
+		return saveCSVReport(filename, errorMessage);
+	}
+	else
+	{
+		return saveJSONReport(filename, errorMessage);
+	}
+}
+
+//! Throughput (in elements per second)
+static double Throughput(size_t count, double time_s)
+{
+	return (time_s > 0 ? count / time_s : 0.0);
+}
+
+bool ccCommandLineProfiler::saveJSONReport(const QString& filename, QString& errorMessage) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	int idealThreadCount = QThread::idealThreadCount();
+	double totalWallTime_s = m_timer.nsecsElapsed() / 1.0e9;
+
+	QJsonArray sections;
+	for (const Record& record : m_records)
+	{
+		const Section& section = record.section;
+
+		QJsonObject object;
+		object["category"] = section.category;
+		object["name"] = section.name;
+		object["depth"] = section.depth;
+		object["thread"] = section.threadIndex;
+		object["start_s"] = section.startTime_s;
+		object["finished"] = section.finished;
+		if (section.finished)
+		{
+			double busyThreads = (section.wallTime_s > 0 ? section.cpuTime_s / section.wallTime_s : 0.0);
+			object["wall_time_s"] = section.wallTime_s;
+			object["cpu_time_s"] = section.cpuTime_s;
+			object["busy_threads"] = busyThreads;
+			object["thread_utilization"] = busyThreads / idealThreadCount;
+			object["peak_memory_increase_MB"] = section.peakMemoryIncrease_MB;
+			object["points"] = static_cast<double>(section.pointCount);
+			object["triangles"] = static_cast<double>(section.triangleCount);
+			object["points_per_s"] = Throughput(section.pointCount, section.wallTime_s);
+			object["triangles_per_s"] = Throughput(section.triangleCount, section.wallTime_s);
+		}
+		sections.append(object);
+	}
+
+	QJsonObject report;
+	report["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	report["ideal_thread_count"] = idealThreadCount;
+	report["thread_count"] = m_threadIndexes.size();
+	report["wall_time_s"] = totalWallTime_s;
+	report["cpu_time_s"] = ProcessCPUTime() - m_cpuTimeAtStart_s;
+	report["peak_memory_MB"] = ProcessPeakMemory();
+	report["sections"] = sections;
+
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		errorMessage = QString("Failed to open file '%1' for writing").arg(filename);
+		return false;
+	}
+	if (file.write(QJsonDocument(report).toJson()) < 0)
+	{
+		errorMessage = QString("Failed to write file '%1'").arg(filename);
+		return false;
+	}
+
+	return true;
+}
+
+bool ccCommandLineProfiler::saveCSVReport(const QString& filename, QString& errorMessage) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+	{
+		errorMessage = QString("Failed to open file '%1' for writing").arg(filename);
+		return false;
+	}
+
+	int idealThreadCount = QThread::idealThreadCount();
+
+	QTextStream stream(&file);
+	stream << "Category;Name;Depth;Thread;Start (s);Wall time (s);CPU time (s);Busy threads;Thread utilization;Peak memory increase (MB);Points;Triangles;Points/s;Triangles/s" << endl;
+	for (const Record& record : m_records)
+	{
+		const Section& section = record.section;
+
+		QString name = section.name;
+		name.replace(';', ',');
+		stream << section.category << ';' << name << ';' << section.depth << ';' << section.threadIndex << ';' << section.startTime_s << ';';
+		if (section.finished)
+		{
+			double busyThreads = (section.wallTime_s > 0 ? section.cpuTime_s / section.wallTime_s : 0.0);
+			stream << section.wallTime_s << ';' << section.cpuTime_s << ';' << busyThreads << ';' << busyThreads / idealThreadCount << ';';
+			stream << section.peakMemoryIncrease_MB << ';' << section.pointCount << ';' << section.triangleCount << ';';
+			stream << Throughput(section.pointCount, section.wallTime_s) << ';' << Throughput(section.triangleCount, section.wallTime_s);
+		}
+		else
+		{
+			//unfinished section (error)
+			stream << ";;;;;;;;";
+		}
+		stream << endl;
+	}
+
+	if (stream.status() != QTextStream::Ok)
+	{
+		errorMessage = QString("Failed to write file '%1'").arg(filename);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,125 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_COMMAND_LINE_PROFILER_HEADER
+#define CC_COMMAND_LINE_PROFILER_HEADER
+
+//Qt
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+
+//system
+#include <vector>
+
+class ccHObject;
+
+//! Command line profiler (see the '-PROFILE' option)
+/** Records the wall time, CPU time, peak memory increase and throughput of
+	(possibly nested) sections: commands, file imports and exports, plugin steps, etc.
+	Sections can be recorded by several threads at the same time (parallel mode).
+
+	The CPU time and the peak memory are measured for the whole process. In parallel
+	mode, they therefore include the activity of the other threads.
+**/
+class ccCommandLineProfiler
+{
+public:
+
+	//! Shared type
+	using Shared = QSharedPointer<ccCommandLineProfiler>;
+
+	//! Profiled section
+	struct Section
+	{
+		//! Category ("command", "import", "export", or any plugin specific value)
+		QString category;
+		//! Name
+		QString name;
+		//! Nesting depth
+		int depth = 0;
+		//! Index of the thread that recorded the section
+		int threadIndex = 0;
+		//! Start time (relatively to the profiler creation, in seconds)
+		double startTime_s = 0.0;
+		//! Wall time (in seconds)
+		double wallTime_s = 0.0;
+		//! Process CPU time (in seconds)
+		double cpuTime_s = 0.0;
+		//! Increase of the process peak memory (in MB)
+		double peakMemoryIncrease_MB = 0.0;
+		//! Number of processed points
+		size_t pointCount = 0;
+		//! Number of processed triangles
+		size_t triangleCount = 0;
+		//! Whether the section has been properly ended
+		bool finished = false;
+	};
+
+	//! Default constructor
+	ccCommandLineProfiler();
+
+	//! Starts a new section
+	/** \return section handle
+	**/
+	int beginSection(const QString& category, const QString& name, int depth);
+
+	//! Ends a section
+	void endSection(int section, size_t pointCount, size_t triangleCount);
+
+	//! Saves the report (JSON, or CSV if the file extension is 'csv')
+	bool saveReport(const QString& filename, QString& errorMessage) const;
+
+	//! Returns the number of points and triangles of an entity (and of its children)
+	static void CountElements(const ccHObject* entity, size_t& pointCount, size_t& triangleCount);
+
+	//! Returns the CPU time consumed by the process so far (user + system, in seconds)
+	static double ProcessCPUTime();
+
+	//! Returns the peak memory (resident set size) of the process so far (in MB)
+	static double ProcessPeakMemory();
+
+protected:
+
+	//! Section record
+	struct Record
+	{
+		Section section;
+		double cpuTimeAtStart_s = 0.0;
+		double peakMemoryAtStart_MB = 0.0;
+	};
+
+	//! Saves the report as a JSON file
+	bool saveJSONReport(const QString& filename, QString& errorMessage) const;
+	//! Saves the report as a CSV file
+	bool saveCSVReport(const QString& filename, QString& errorMessage) const;
+
+	//! Sections
+	std::vector<Record> m_records;
+	//! Thread indexes
+	QHash<Qt::HANDLE, int> m_threadIndexes;
+	//! Timer (started at construction)
+	QElapsedTimer m_timer;
+	//! Process CPU time at construction
+	double m_cpuTimeAtStart_s;
+	//! Mutex
+	mutable QMutex m_mutex;
+};
+
+#endif //CC_COMMAND_LINE_PROFILER_HEADER
@@ -0,0 +1,289 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccCommandLineServer.h"
+
+//Local
+#include "ccCommandLineParser.h"
+
+//qCC_db
+#include <ccLog.h>
+
+//Qt
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+//system
+#include <functional>
+
+//server jobs
+constexpr char COMMAND_SERVER_STATUS[]	= "SERVER_STATUS";
+constexpr char COMMAND_SERVER_STOP[]	= "SERVER_STOP";
+
+ccCommandLineServer::ccCommandLineServer(ccCommandLineParser& parser, const Parameters& parameters)
+	: m_parser(parser)
+	, m_parameters(parameters)
+	, m_cache(new ccCommandLineEntityCache(parameters.cacheBudget_MB))
+{
+}
+
+bool ccCommandLineServer::SplitArguments(const QString& line, QStringList& arguments)
+{
+	arguments.clear();
+
+	QString current;
+	bool inQuotes = false;
+	bool hasArgument = false;
+	for (QChar c : line)
+	{
+		if (c == '"')
+		{
+			inQuotes = !inQuotes;
+			hasArgument = true; //to handle empty arguments ("")
+		}
+		else if (c.isSpace() && !inQuotes)
+		{
+			if (hasArgument)
+			{
+				arguments.push_back(current);
+				current.clear();
+				hasArgument = false;
+			}
+		}
+		else
+		{
+			current += c;
+			hasArgument = true;
+		}
+	}
+	if (hasArgument)
+	{
+		arguments.push_back(current);
+	}
+
+	return !inQuotes;
+}
+
+ccCommandLineServer::JobResult ccCommandLineServer::processJob(const QStringList& arguments) const
+{
+	JobResult result;
+
+	//the jobs run concurrently (only the thread-safe commands are accepted)
+	QScopedPointer<ccCommandLineParser> worker(m_parser.createWorker(true));
+	worker->m_entityCache = m_cache;
+	worker->m_arguments = arguments;
+	try
+	{
+		result.success = worker->processCommands();
+	}
+	catch (const std::bad_alloc&)
+	{
+		result.success = worker->error("Not enough memory");
+	}
+
+	//the cached clouds go back to the cache (if they haven't been modified)
+	m_cache->release(worker.data(), worker->m_entityCacheVersion, worker->m_clouds);
+	worker->cleanup();
+
+	for (const ccCommandLineParser::BufferedMessage& message : worker->m_bufferedMessages)
+	{
+		QString prefix = "[I] ";
+		if (message.level & ccLog::LOG_ERROR)
+		{
+			prefix = "[E] ";
+		}
+		else if (message.level & ccLog::LOG_WARNING)
+		{
+			prefix = "[W] ";
+		}
+		QString text = message.text;
+		text.replace('\n', ' ');
+		result.messages.push_back(prefix + text);
+	}
+
+	return result;
+}
+
+bool ccCommandLineServer::run()
+{
+	//only the current user can connect to the server
+	QLocalServer server;
+	server.setSocketOptions(QLocalServer::UserAccessOption);
+
+	//we don't steal the name of another server (a remaining socket, e.g. if a previous instance crashed, must be removed manually)
+	if (!server.listen(m_parameters.name))
+	{
+		if (server.serverError() == QAbstractSocket::AddressInUseError)
+		{
+			return m_parser.error(QString("[SERVER] The name '%1' is already in use (by another server, or by a remaining socket that should be removed)").arg(m_parameters.name));
+		}
+		return m_parser.error(QString("[SERVER] Failed to listen on '%1': %2").arg(m_parameters.name, server.errorString()));
+	}
+
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(m_parameters.maxJobCount > 0 ? m_parameters.maxJobCount : QThread::idealThreadCount());
+
+	m_parser.print(QString("[SERVER] Listening on '%1' (up to %2 job(s) at the same time, cache budget: %3 MB)").arg(server.fullServerName()).arg(threadPool.maxThreadCount()).arg(m_parameters.cacheBudget_MB));
+
+	struct Connection
+	{
+		QLocalSocket* socket = nullptr;
+		QByteArray buffer;
+		QStringList currentJob;
+		QList<QStringList> pendingJobs;
+		bool busy = false;
+		bool closed = false;
+	};
+	using ConnectionPtr = QSharedPointer<Connection>;
+
+	QEventLoop eventLoop;
+	bool stopping = false;
+	int runningJobCount = 0;
+	unsigned jobCounter = 0;
+
+	auto send = [](const ConnectionPtr& connection, const QString& reply)
+	{
+		if (!connection->closed)
+		{
+			connection->socket->write(reply.toUtf8());
+			connection->socket->flush();
+		}
+	};
+
+	std::function<void(ConnectionPtr)> startNextJobs;
+	startNextJobs = [&](ConnectionPtr connection)
+	{
+		//the jobs of a given connection are processed one after the other
+		while (!connection->busy && !connection->pendingJobs.empty())
+		{
+			QStringList arguments;
+			if (!SplitArguments(connection->pendingJobs.takeFirst().join(' '), arguments))
+			{
+				send(connection, "[E] Unbalanced quotes\nFAILED\n");
+				continue;
+			}
+			if (arguments.empty())
+			{
+				continue;
+			}
+
+			if (stopping)
+			{
+				send(connection, "[E] The server is stopping\nFAILED\n");
+				continue;
+			}
+			if (arguments.size() == 1 && ccCommandLineInterface::IsCommand(arguments.front(), COMMAND_SERVER_STATUS))
+			{
+				send(connection, QString("[I] %1 job(s) running\n[I] %2\nOK\n").arg(runningJobCount).arg(m_cache->status()));
+				continue;
+			}
+			if (arguments.size() == 1 && ccCommandLineInterface::IsCommand(arguments.front(), COMMAND_SERVER_STOP))
+			{
+				m_parser.print("[SERVER] Stop requested");
+				stopping = true;
+				server.close();
+				send(connection, "OK\n");
+				if (runningJobCount == 0)
+				{
+					eventLoop.quit();
+				}
+				continue;
+			}
+
+			unsigned jobIndex = ++jobCounter;
+			connection->busy = true;
+			++runningJobCount;
+
+			QFutureWatcher<JobResult>* watcher = new QFutureWatcher<JobResult>;
+			QObject::connect(watcher, &QFutureWatcher<JobResult>::finished, watcher, [&, watcher, connection, jobIndex]()
+			{
+				JobResult result = watcher->result();
+				watcher->deleteLater();
+
+				m_parser.print(QString("[SERVER] Job #%1: %2").arg(jobIndex).arg(result.success ? "OK" : "FAILED"));
+				result.messages.push_back(result.success ? "OK" : "FAILED");
+				send(connection, result.messages.join('\n') + '\n');
+
+				connection->busy = false;
+				--runningJobCount;
+				if (stopping)
+				{
+					if (runningJobCount == 0)
+					{
+						eventLoop.quit();
+					}
+				}
+				startNextJobs(connection);
+			});
+			watcher->setFuture(QtConcurrent::run(&threadPool, [this, arguments]() { return processJob(arguments); }));
+		}
+	};
+
+	QObject::connect(&server, &QLocalServer::newConnection, [&]()
+	{
+		while (QLocalSocket* socket = server.nextPendingConnection())
+		{
+			ConnectionPtr connection(new Connection);
+			connection->socket = socket;
+
+			QObject::connect(socket, &QLocalSocket::readyRead, socket, [&, connection]()
+			{
+				connection->buffer += connection->socket->readAll();
+				for (int eol = connection->buffer.indexOf('\n'); eol >= 0; eol = connection->buffer.indexOf('\n'))
+				{
+					QString line = QString::fromUtf8(connection->buffer.left(eol)).trimmed();
+					connection->buffer.remove(0, eol + 1);
+
+					if (line.isEmpty())
+					{
+						//end of job
+						if (!connection->currentJob.empty())
+						{
+							connection->pendingJobs.push_back(connection->currentJob);
+							connection->currentJob.clear();
+						}
+					}
+					else if (!line.startsWith('#'))
+					{
+						connection->currentJob.push_back(line);
+					}
+				}
+				startNextJobs(connection);
+			});
+
+			QObject::connect(socket, &QLocalSocket::disconnected, socket, [connection]()
+			{
+				//the running job (if any) goes on, but its result will be ignored
+				connection->closed = true;
+				connection->pendingJobs.clear();
+				connection->socket->deleteLater();
+			});
+		}
+	});
+
+	eventLoop.exec();
+
+	threadPool.waitForDone();
+	m_parser.print(QString("[SERVER] Stopped after %1 job(s) (%2)").arg(jobCounter).arg(m_cache->status()));
+
+	return true;
+}
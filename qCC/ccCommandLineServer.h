@@ -0,0 +1,101 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_COMMAND_LINE_SERVER_HEADER
+#define CC_COMMAND_LINE_SERVER_HEADER
+
+//Local
+#include "ccCommandLineEntityCache.h"
+
+//Qt
+#include <QString>
+#include <QStringList>
+
+class ccCommandLineParser;
+
+//! Local processing server (see the '-SERVER' option)
+/** The server listens on a local socket (a named pipe on Windows) and processes
+	'jobs', i.e. sequences of commands with the same syntax as the command line.
+	The jobs of different connections are processed concurrently, the jobs of
+	a given connection are processed one after the other.
+
+	Protocol (UTF-8 text):
+	- a job is a block of lines ended by an empty line (the lines are simply
+		concatenated, and the lines starting with '#' are ignored)
+	- arguments containing spaces must be enclosed in double quotes
+	- for each job, the server sends back the job messages (one per line,
+		prefixed by '[I] ', '[W] ' or '[E] ') and then a line with 'OK' or 'FAILED'
+	- the '-SERVER_STATUS' job returns the state of the cache
+	- the '-SERVER_STOP' job stops the server (once the running jobs are finished)
+
+	Each job starts with the settings of the server parser (export formats, etc.), and only
+	accepts the commands that can be run concurrently (see ccCommandLineParser::createWorker).
+	The point clouds loaded by the jobs are kept in a cache (see ccCommandLineEntityCache).
+	Only the current user can connect to the server.
+**/
+class ccCommandLineServer
+{
+public:
+
+	//! Server parameters
+	struct Parameters
+	{
+		//! Server (socket) name
+		QString name = "CloudCompareServer";
+		//! Max number of jobs processed at the same time (0 = number of cores)
+		int maxJobCount = 0;
+		//! Memory budget of the cache (in MB)
+		double cacheBudget_MB = 2048.0;
+	};
+
+	//! Default constructor
+	/** \param parser parser used as template for the jobs
+		\param parameters server parameters
+	**/
+	ccCommandLineServer(ccCommandLineParser& parser, const Parameters& parameters);
+
+	//! Runs the server (until it is stopped)
+	/** \return false if the server couldn't be started
+	**/
+	bool run();
+
+	//! Splits a line into arguments (the arguments containing spaces must be enclosed in double quotes)
+	/** \return false if the quotes are not balanced
+	**/
+	static bool SplitArguments(const QString& line, QStringList& arguments);
+
+protected:
+
+	//! Job result
+	struct JobResult
+	{
+		bool success = false;
+		QStringList messages;
+	};
+
+	//! Processes a job (in a worker thread)
+	JobResult processJob(const QStringList& arguments) const;
+
+	//! Template parser
+	ccCommandLineParser& m_parser;
+	//! Parameters
+	Parameters m_parameters;
+	//! Loaded entities cache
+	ccCommandLineEntityCache::Shared m_cache;
+};
+
+#endif //CC_COMMAND_LINE_SERVER_HEADER
@@ -72,6 +72,7 @@ ccComparisonDlg::ccComparisonDlg(	ccHObject* compEntity,
 	, m_compType(cpType)
 	, m_noDisplay(noDisplay)
 	, m_bestOctreeLevel(0)
+	, m_hasPendingDependency(false)
 {
 	setupUi(this);
 
@@ -120,12 +121,17 @@ ccComparisonDlg::ccComparisonDlg(	ccHObject* compEntity,
 		signedDistCheckBox->setChecked(true);
 		filterVisibilityCheckBox->setEnabled(false);
 		filterVisibilityCheckBox->setVisible(false);
+		approxCheckBox->setChecked(false);
+		approxCheckBox->setEnabled(false);
+		approxCheckBox->setVisible(false);
+		approxMaxErrorSpinBox->setVisible(false);
 	}
 	else
 	{
 		signedDistCheckBox->setEnabled(false);
 		split3DCheckBox->setEnabled(true);
 		lmRadiusDoubleSpinBox->setValue(compEntBBox.getDiagNorm() / 200.0);
+		approxMaxErrorSpinBox->setValue(compEntBBox.getDiagNorm() / 1000.0);
 		filterVisibilityCheckBox->setEnabled(m_refCloud && m_refCloud->isA(CC_TYPES::POINT_CLOUD) && static_cast<ccPointCloud*>(m_refCloud)->hasSensor());
 	}
 
@@ -212,6 +218,40 @@ bool ccComparisonDlg::prepareEntitiesForComparison()
 	return true;
 }
 
+void ccComparisonDlg::setAdditionalComparedClouds(const std::vector<ccPointCloud*>& clouds)
+{
+	if (m_compType != CLOUDCLOUD_DIST)
+	{
+		assert(false);
+		return;
+	}
+
+	m_additionalCompClouds.clear();
+	m_additionalOldSfNames.clear();
+	for (ccPointCloud* cloud : clouds)
+	{
+		if (!cloud || cloud == m_compCloud || cloud == m_refCloud)
+		{
+			continue;
+		}
+		m_additionalCompClouds.push_back(cloud);
+
+		//backup currently displayed SF
+		int oldSfIdx = cloud->getCurrentDisplayedScalarFieldIndex();
+		m_additionalOldSfNames.push_back(oldSfIdx >= 0 ? QString(cloud->getScalarFieldName(oldSfIdx)) : QString());
+	}
+
+	if (!m_additionalCompClouds.empty())
+	{
+		compName->setText(tr("%1 (+ %2 other cloud(s))").arg(m_compEnt->getName()).arg(m_additionalCompClouds.size()));
+		//not supported in this mode
+		lmOptimizeCheckBox->setChecked(false);
+		lmOptimizeCheckBox->setEnabled(false);
+		filterVisibilityCheckBox->setChecked(false);
+		filterVisibilityCheckBox->setEnabled(false);
+	}
+}
+
 void ccComparisonDlg::maxDistUpdated()
 {
 	//the current 'best octree level' is depreacted
@@ -276,6 +316,14 @@ void ccComparisonDlg::updateDisplay(bool showSF, bool showRef)
 		m_compEnt->prepareDisplayForRefresh_recursive();
 	}
 
+	for (ccPointCloud* cloud : m_additionalCompClouds)
+	{
+		cloud->setVisible(true);
+		cloud->setEnabled(true);
+		cloud->showSF(showSF);
+		cloud->prepareDisplayForRefresh_recursive();
+	}
+
 	if (m_refEnt)
 	{
 		m_refEnt->setVisible(showRef);
@@ -663,6 +711,12 @@ bool ccComparisonDlg::computeDistances()
 	if (!isValid())
 		return false;
 
+	if (!m_additionalCompClouds.empty() || (approxCheckBox->isEnabled() && approxCheckBox->isChecked()))
+	{
+		//multiple compared clouds and/or approximate distances
+		return computeMultiDistances();
+	}
+
 	int octreeLevel = octreeLevelComboBox->currentIndex();
 	assert(octreeLevel <= CCCoreLib::DgmOctree::MAX_OCTREE_LEVEL);
 
@@ -710,6 +764,8 @@ bool ccComparisonDlg::computeDistances()
 	c2cParams.maxThreadCount = c2mParams.maxThreadCount = maxThreadCountSpinBox->value();
 
 	int result = -1;
+	bool incrementalUpdate = false;
+	m_hasPendingDependency = false;
 	QScopedPointer<ccProgressDialog> progressDlg;
 	if (parentWidget())
 	{
@@ -829,12 +885,37 @@ bool ccComparisonDlg::computeDistances()
 			c2cParams.CPSet = nullptr;
 		}
 		
-		result = CCCoreLib::DistanceComputationTools::computeCloud2CloudDistances(	m_compCloud,
-																					m_refCloud,
-																					c2cParams,
-																					progressDlg.data(),
-																					m_compOctree.data(),
-																					m_refOctree.data());
+		//if only a part of the reference has changed since the last computation
+		//(with the same parameters), we only update the affected distances
+		if (	!split3D
+			&&	c2cParams.localModel == CCCoreLib::NO_MODEL
+			&&	!(filterVisibilityCheckBox->isEnabled() && filterVisibilityCheckBox->isChecked()))
+		{
+			incrementalUpdate = tryIncrementalUpdate(static_cast<ccScalarField*>(sf), maxSearchDist, multiThread ? c2cParams.maxThreadCount : 1, progressDlg.data());
+		}
+
+		if (incrementalUpdate)
+		{
+			result = 0;
+		}
+		else
+		{
+			result = CCCoreLib::DistanceComputationTools::computeCloud2CloudDistances(	m_compCloud,
+																						m_refCloud,
+																						c2cParams,
+																						progressDlg.data(),
+																						m_compOctree.data(),
+																						m_refOctree.data());
+
+			//we keep track of the reference state (for the next computation)
+			if (	result >= 0
+				&&	!split3D
+				&&	c2cParams.localModel == CCCoreLib::NO_MODEL
+				&&	!(filterVisibilityCheckBox->isEnabled() && filterVisibilityCheckBox->isChecked()))
+			{
+				m_hasPendingDependency = ccC2CBatchEngine::ComputeDependency(m_refCloud, m_compCloud, maxSearchDist, m_pendingDependency);
+			}
+		}
 		break;
 
 	case CLOUDMESH_DIST: //cloud-mesh
@@ -963,6 +1044,185 @@ bool ccComparisonDlg::computeDistances()
 	return result >= 0;
 }
 
+bool ccComparisonDlg::tryIncrementalUpdate(ccScalarField* sf, double maxSearchDist, int maxThreadCount, CCCoreLib::GenericProgressCallback* progressCb)
+{
+	assert(m_compType == CLOUDCLOUD_DIST && m_refCloud && sf);
+
+	ccC2CBatchEngine::Parameters params;
+	params.octreeLevel = static_cast<unsigned char>(octreeLevelComboBox->currentIndex()); //0 = AUTO
+	params.maxSearchDist = maxSearchDist;
+
+	QString sfName = ccC2CBatchEngine::GetDefaultSFName(params);
+
+	//previously computed distances
+	int previousSFIdx = m_compCloud->getScalarFieldIndexByName(qPrintable(sfName));
+	if (previousSFIdx < 0)
+	{
+		return false;
+	}
+	ccC2CBatchEngine::Dependency previous;
+	if (!ccC2CBatchEngine::GetDependency(m_compCloud, sfName, previous))
+	{
+		return false;
+	}
+	if (previous.referenceID != m_refCloud->getUniqueID())
+	{
+		return false;
+	}
+
+	CCCoreLib::ScalarField* previousSF = m_compCloud->getScalarField(previousSFIdx);
+	if (!previousSF || previousSF->size() != m_compCloud->size() || !sf->resizeSafe(m_compCloud->size()))
+	{
+		return false;
+	}
+
+	ccC2CBatchEngine engine;
+	if (!engine.setReference(m_refCloud, params, progressCb, m_refOctree))
+	{
+		return false;
+	}
+
+	//we start from the previous distances
+	for (unsigned i = 0; i < m_compCloud->size(); ++i)
+	{
+		sf->setValue(i, previousSF->getValue(i));
+	}
+
+	unsigned recomputedCount = 0;
+	if (!engine.updateDistances(m_compCloud, sf, previous, m_pendingDependency, recomputedCount, 0.5, maxThreadCount, progressCb))
+	{
+		//the full computation will be done instead
+		return false;
+	}
+	m_hasPendingDependency = true;
+
+	ccLog::Print(QString("[ComputeDistances] Incremental update: %1 point(s) recomputed (%2%)").arg(recomputedCount).arg(100.0 * recomputedCount / m_compCloud->size(), 0, 'f', 2));
+	return true;
+}
+
+bool ccComparisonDlg::computeMultiDistances()
+{
+	assert(m_compType == CLOUDCLOUD_DIST && m_refCloud);
+
+	//the incremental update is not supported in this mode
+	m_hasPendingDependency = false;
+
+	//parameters
+	ccC2CBatchEngine::Parameters params;
+	params.octreeLevel = static_cast<unsigned char>(octreeLevelComboBox->currentIndex()); //0 = AUTO
+	params.maxSearchDist = (maxDistCheckBox->isChecked() ? maxSearchDistSpinBox->value() : 0.0);
+	params.splitXYZ = split3DCheckBox->isEnabled() && split3DCheckBox->isChecked();
+	params.approxMaxError = (approxCheckBox->isEnabled() && approxCheckBox->isChecked() ? approxMaxErrorSpinBox->value() : 0.0);
+	if (localModelingTab->isEnabled())
+	{
+		params.localModel = static_cast<CCCoreLib::LOCAL_MODEL_TYPES>(localModelComboBox->currentIndex());
+		if (params.localModel != CCCoreLib::NO_MODEL)
+		{
+			params.useSphericalSearchForLocalModel = lmRadiusRadioButton->isChecked();
+			params.kNNForLocalModel = static_cast<unsigned>(std::max(0, lmKNNSpinBox->value()));
+			params.radiusForLocalModel = lmRadiusDoubleSpinBox->value();
+		}
+	}
+	int maxThreadCount = (multiThreadedCheckBox->isChecked() ? maxThreadCountSpinBox->value() : 1);
+
+	QScopedPointer<ccProgressDialog> progressDlg;
+	if (parentWidget())
+	{
+		progressDlg.reset(new ccProgressDialog(true, this));
+	}
+
+	QElapsedTimer eTimer;
+	eTimer.start();
+
+	ccC2CBatchEngine engine;
+	if (!engine.setReference(m_refCloud, params, progressDlg.data(), m_refOctree))
+	{
+		ccLog::Error("[ComputeDistances] Failed to prepare the reference cloud");
+		return false;
+	}
+
+	std::vector<ccPointCloud*> clouds;
+	clouds.push_back(m_compCloud);
+	clouds.insert(clouds.end(), m_additionalCompClouds.begin(), m_additionalCompClouds.end());
+
+	m_sfName = engine.getDefaultSFName();
+
+	std::vector<ccC2CBatchEngine::Statistics> stats;
+	bool success = engine.computeDistances(clouds, stats, CC_TEMP_DISTANCES_DEFAULT_SF_NAME, m_sfName, maxThreadCount, progressDlg.data());
+
+	if (progressDlg)
+	{
+		progressDlg->stop();
+	}
+
+	if (success)
+	{
+		ccLog::Print("[ComputeDistances] Time: %3.2f s.", eTimer.elapsed() / 1.0e3);
+		ccLog::Print(QString("[ComputeDistances] Octree level: %1").arg(engine.getOctreeLevel()));
+
+		//summary table
+		ccLog::Print(tr("[ComputeDistances] Cloud | Points | Min | Max | Mean | Std. dev. | RMS"));
+		for (size_t i = 0; i < clouds.size(); ++i)
+		{
+			const ccC2CBatchEngine::Statistics& s = stats[i];
+			if (s.success)
+			{
+				ccLog::Print(QString("[ComputeDistances] %1 | %2 | %3 | %4 | %5 | %6 | %7").arg(clouds[i]->getName()).arg(s.validCount).arg(s.minDist).arg(s.maxDist).arg(s.mean).arg(s.stdDev).arg(s.rms));
+			}
+			else
+			{
+				ccLog::Warning(QString("[ComputeDistances] %1 | failed").arg(clouds[i]->getName()));
+			}
+		}
+		if (engine.isApproximate())
+		{
+			//accuracy measured on a subset of the points
+			ccLog::Print(tr("[ComputeDistances] Approximate distances (max error: %1) | Cloud | Samples | Mean error | Max error").arg(params.approxMaxError));
+			for (size_t i = 0; i < clouds.size(); ++i)
+			{
+				const ccC2CBatchEngine::Statistics& s = stats[i];
+				if (s.success)
+				{
+					ccLog::Print(QString("[ComputeDistances] %1 | %2 | %3 | %4").arg(clouds[i]->getName()).arg(s.errorSampleCount).arg(s.meanError).arg(s.maxError));
+				}
+			}
+		}
+		if (params.splitXYZ)
+		{
+			ccLog::Warning("[ComputeDistances] Result has been split along each dimension (check the 3 other scalar fields with '_X', '_Y' and '_Z' suffix!)");
+		}
+
+		okButton->setEnabled(true);
+	}
+	else
+	{
+		ccLog::Error("[ComputeDistances] Failed to compute the distances (see console)");
+	}
+
+	for (ccPointCloud* cloud : clouds)
+	{
+		int sfIdx = cloud->getScalarFieldIndexByName(CC_TEMP_DISTANCES_DEFAULT_SF_NAME);
+		if (sfIdx < 0)
+		{
+			continue;
+		}
+		if (success)
+		{
+			cloud->setCurrentDisplayedScalarField(sfIdx);
+			cloud->showSF(true);
+		}
+		else
+		{
+			cloud->deleteScalarField(sfIdx);
+			cloud->showSF(false);
+		}
+	}
+
+	updateDisplay(success, false);
+
+	return success;
+}
+
 void ccComparisonDlg::showHisto()
 {
 	if (!m_compCloud)
@@ -986,6 +1246,29 @@ void ccComparisonDlg::showHisto()
 
 void ccComparisonDlg::applyAndExit()
 {
+	//additional compared clouds ('multi-compared' mode)
+	for (ccPointCloud* cloud : m_additionalCompClouds)
+	{
+		int sfIdx = cloud->getScalarFieldIndexByName(CC_TEMP_DISTANCES_DEFAULT_SF_NAME);
+		if (sfIdx < 0 || m_sfName.isEmpty())
+		{
+			continue;
+		}
+
+		//we delete any existing scalar field with the exact same name
+		int _sfIdx = cloud->getScalarFieldIndexByName(qPrintable(m_sfName));
+		if (_sfIdx >= 0)
+		{
+			cloud->deleteScalarField(_sfIdx);
+			sfIdx = cloud->getScalarFieldIndexByName(CC_TEMP_DISTANCES_DEFAULT_SF_NAME);
+		}
+
+		cloud->renameScalarField(sfIdx, qPrintable(m_sfName));
+		cloud->setCurrentDisplayedScalarField(sfIdx);
+		cloud->showSF(true);
+		ccC2CBatchEngine::RemoveDependency(cloud, m_sfName);
+	}
+
 	if (m_compCloud)
 	{
 		//m_compCloud->setCurrentDisplayedScalarField(-1);
@@ -1025,6 +1308,16 @@ void ccComparisonDlg::applyAndExit()
 				m_compCloud->renameScalarField(sfIdx,qPrintable(m_sfName));
 				m_compCloud->setCurrentDisplayedScalarField(sfIdx);
 				m_compCloud->showSF(sfIdx >= 0);
+
+				//dependency between the distances and the reference cloud (for the next incremental updates)
+				if (m_hasPendingDependency)
+				{
+					ccC2CBatchEngine::SetDependency(m_compCloud, m_sfName, m_pendingDependency);
+				}
+				else
+				{
+					ccC2CBatchEngine::RemoveDependency(m_compCloud, m_sfName);
+				}
 			}
 		}
 
@@ -1042,6 +1335,30 @@ void ccComparisonDlg::applyAndExit()
 
 void ccComparisonDlg::cancelAndExit()
 {
+	//additional compared clouds ('multi-compared' mode)
+	for (size_t i = 0; i < m_additionalCompClouds.size(); ++i)
+	{
+		ccPointCloud* cloud = m_additionalCompClouds[i];
+		cloud->setCurrentDisplayedScalarField(-1);
+		cloud->showSF(false);
+
+		int sfIdx = cloud->getScalarFieldIndexByName(CC_TEMP_DISTANCES_DEFAULT_SF_NAME);
+		if (sfIdx >= 0)
+		{
+			cloud->deleteScalarField(sfIdx);
+		}
+
+		if (!m_additionalOldSfNames[i].isEmpty())
+		{
+			int oldSfIdx = cloud->getScalarFieldIndexByName(qPrintable(m_additionalOldSfNames[i]));
+			if (oldSfIdx >= 0)
+			{
+				cloud->setCurrentDisplayedScalarField(oldSfIdx);
+				cloud->showSF(true);
+			}
+		}
+	}
+
 	if (m_compCloud)
 	{
 		m_compCloud->setCurrentDisplayedScalarField(-1);
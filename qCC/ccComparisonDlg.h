@@ -25,12 +25,19 @@
 #include <QDialog>
 #include <QString>
 
+//Local
+#include "ccC2CBatchEngine.h"
+
+//system
+#include <vector>
+
 #include <ui_comparisonDlg.h>
 
 class ccHObject;
 class ccPointCloud;
 class ccGenericPointCloud;
 class ccGenericMesh;
+class ccScalarField;
 
 //! Dialog for cloud/cloud or cloud/mesh comparison setting
 class ccComparisonDlg: public QDialog, public Ui::ComparisonDialog
@@ -64,6 +71,14 @@ public:
 	//! Returns compared entity
 	ccHObject* getReferenceEntity() { return m_refEnt; }
 
+	//! Sets additional compared clouds (cloud/cloud comparison only)
+	/** In this 'multi-compared' mode, the reference octree is built only once and
+		the distances are computed for all the compared clouds concurrently (see
+		ccC2CBatchEngine). A summary of the statistics is output in the console.
+		Should be called before initDialog.
+	**/
+	void setAdditionalComparedClouds(const std::vector<ccPointCloud*>& clouds);
+
 public:
 	bool computeDistances();
 	void applyAndExit();
@@ -79,6 +94,8 @@ protected:
 	bool isValid();
 	bool prepareEntitiesForComparison();
 	bool computeApproxDistances();
+	bool computeMultiDistances();
+	bool tryIncrementalUpdate(ccScalarField* sf, double maxSearchDist, int maxThreadCount, CCCoreLib::GenericProgressCallback* progressCb);
 	int getBestOctreeLevel();
 	int determineBestOctreeLevel(double);
 	void updateDisplay(bool showSF, bool hideRef);
@@ -122,6 +139,16 @@ protected:
 
 	//! Best octree level (or 0 if none has been guessed already)
 	int m_bestOctreeLevel;
+
+	//! Additional compared clouds ('multi-compared' mode)
+	std::vector<ccPointCloud*> m_additionalCompClouds;
+	//! Initial SF names enabled on the additional compared clouds
+	std::vector<QString> m_additionalOldSfNames;
+
+	//! State of the reference cloud for the last computed distances (see ccC2CBatchEngine::Dependency)
+	ccC2CBatchEngine::Dependency m_pendingDependency;
+	//! Whether m_pendingDependency is valid
+	bool m_hasPendingDependency;
 };
 
 #endif
@@ -25,18 +25,24 @@
 #include <ccSingleton.h>
 
 //Qt
+#include <QAbstractListModel>
 #include <QApplication>
+#include <QBrush>
 #include <QClipboard>
-#include <QColor>
+#include <QFile>
 #include <QKeyEvent>
 #include <QMessageBox>
+#include <QMutex>
 #include <QSettings>
 #include <QTextStream>
 #include <QThread>
 #include <QTime>
+#include <QWaitCondition>
 
 //system
+#include <algorithm>
 #include <cassert>
+#include <deque>
 #ifdef QT_DEBUG
 #include <iostream>
 #endif
@@ -51,32 +57,246 @@ static ccSingleton<ccConsole> s_console;
 bool ccConsole::s_showQtMessagesInConsole = false;
 bool ccConsole::s_redirectToStdOut = false;
 
+//! Max number of messages kept in the console widget (the oldest ones are discarded)
+static const size_t MAX_CONSOLE_ROW_COUNT = 100000;
 
-// ccCustomQListWidget
-ccCustomQListWidget::ccCustomQListWidget(QWidget *parent)
-	: QListWidget(parent)
+
+//! Console messages model
+/** The messages are only formatted when the view requests them
+	(i.e. for the visible rows).
+**/
+class ccConsoleModel : public QAbstractListModel
+{
+public:
+
+	explicit ccConsoleModel(QObject* parent)
+		: QAbstractListModel(parent)
+	{}
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override
+	{
+		return parent.isValid() ? 0 : static_cast<int>(m_records.size());
+	}
+
+	QVariant data(const QModelIndex& index, int role) const override
+	{
+		if (!index.isValid() || index.row() >= static_cast<int>(m_records.size()))
+		{
+			return {};
+		}
+
+		const ccLogRingBuffer::Record& record = m_records[index.row()];
+		switch (role)
+		{
+		case Qt::DisplayRole:
+			return ccLogRingBuffer::Format(record);
+
+		case Qt::ForegroundRole:
+			//set color based on the message severity
+			if (record.level & ccLog::LOG_ERROR)
+			{
+				return QBrush(Qt::red);
+			}
+			else if (record.level & ccLog::LOG_WARNING)
+			{
+				return QBrush(Qt::darkRed);
+			}
+#ifdef QT_DEBUG
+			else if (record.level & ccLog::LOG_DEBUG)
+			{
+				return QBrush(Qt::blue);
+			}
+#endif
+			break;
+
+		default:
+			break;
+		}
+
+		return {};
+	}
+
+	//! Appends new messages
+	void append(std::vector<ccLogRingBuffer::Record>& records)
+	{
+		if (records.empty())
+		{
+			return;
+		}
+
+		size_t first = 0;
+		if (records.size() > MAX_CONSOLE_ROW_COUNT)
+		{
+			first = records.size() - MAX_CONSOLE_ROW_COUNT;
+		}
+		size_t addedCount = records.size() - first;
+
+		//discard the oldest messages if necessary
+		if (m_records.size() + addedCount > MAX_CONSOLE_ROW_COUNT)
+		{
+			size_t removedCount = std::min(m_records.size(), m_records.size() + addedCount - MAX_CONSOLE_ROW_COUNT);
+			beginRemoveRows(QModelIndex(), 0, static_cast<int>(removedCount) - 1);
+			m_records.erase(m_records.begin(), m_records.begin() + removedCount);
+			endRemoveRows();
+		}
+
+		int firstRow = static_cast<int>(m_records.size());
+		beginInsertRows(QModelIndex(), firstRow, firstRow + static_cast<int>(addedCount) - 1);
+		std::move(records.begin() + first, records.end(), std::back_inserter(m_records));
+		endInsertRows();
+	}
+
+protected:
+
+	//! Messages
+	std::deque<ccLogRingBuffer::Record> m_records;
+};
+
+
+//! Asynchronous log file writer
+/** The messages are written (and flushed) by a dedicated thread.
+**/
+class ccLogFileWriter : public QThread
+{
+public:
+
+	ccLogFileWriter()
+		: m_stopRequested(false)
+		, m_active(false)
+	{}
+
+	~ccLogFileWriter() override
+	{
+		close();
+	}
+
+	//! Opens a new log file (and starts the writing thread)
+	bool open(const QString& filename)
+	{
+		close();
+
+		m_file.setFileName(filename);
+		if (!m_file.open(QFile::Text | QFile::WriteOnly))
+		{
+			return false;
+		}
+
+		//discard any message pushed while the writer was inactive
+		std::vector<ccLogRingBuffer::Record> discarded;
+		m_buffer.popAll(discarded);
+
+		m_active = true;
+		start();
+		return true;
+	}
+
+	//! Writes the pending messages, stops the writing thread and closes the file
+	void close()
+	{
+		m_active = false;
+		if (isRunning())
+		{
+			{
+				QMutexLocker locker(&m_waitMutex);
+				m_stopRequested = true;
+				m_waitCondition.wakeAll();
+			}
+			wait();
+		}
+		m_stopRequested = false;
+
+		if (m_file.isOpen())
+		{
+			m_file.close();
+		}
+	}
+
+	//! Returns whether a log file is currently open
+	inline bool isActive() const { return m_active; }
+
+	//! Pushes a new message (thread-safe)
+	inline void push(ccLogRingBuffer::Record&& record) { m_buffer.push(std::move(record)); }
+
+	//! Forces the writing thread to write the pending messages
+	void wakeUp()
+	{
+		QMutexLocker locker(&m_waitMutex);
+		m_waitCondition.wakeAll();
+	}
+
+protected:
+
+	void run() override
+	{
+		QTextStream stream(&m_file);
+		std::vector<ccLogRingBuffer::Record> records;
+
+		while (true)
+		{
+			bool stop = m_stopRequested;
+
+			records.clear();
+			if (m_buffer.popAll(records) != 0)
+			{
+				for (const ccLogRingBuffer::Record& record : records)
+				{
+					stream << ccLogRingBuffer::Format(record) << '\n';
+				}
+				stream.flush();
+			}
+
+			if (stop)
+			{
+				break;
+			}
+
+			QMutexLocker locker(&m_waitMutex);
+			if (!m_stopRequested)
+			{
+				m_waitCondition.wait(&m_waitMutex, 200);
+			}
+		}
+	}
+
+	//! Log file
+	QFile m_file;
+	//! Pending messages
+	ccLogRingBuffer m_buffer;
+	//! Mutex (for the wait condition only)
+	QMutex m_waitMutex;
+	//! Wait condition
+	QWaitCondition m_waitCondition;
+	//! Whether the thread should stop
+	std::atomic<bool> m_stopRequested;
+	//! Whether the file is open
+	std::atomic<bool> m_active;
+};
+
+
+// ccCustomQListView
+ccCustomQListView::ccCustomQListView(QWidget *parent)
+	: QListView(parent)
 {
 }
 
-void ccCustomQListWidget::keyPressEvent(QKeyEvent *event)
+void ccCustomQListView::keyPressEvent(QKeyEvent *event)
 {
 	if (event->matches(QKeySequence::Copy))
 	{
-		int itemsCount = count();
+		QModelIndexList selectedRows = selectionModel()->selectedRows();
+		std::sort(selectedRows.begin(), selectedRows.end(), [](const QModelIndex& a, const QModelIndex& b) { return a.row() < b.row(); });
+
 		QStringList strings;
-		for (int i = 0; i < itemsCount; ++i)
+		for (const QModelIndex& index : selectedRows)
 		{
-			if (item(i)->isSelected())
-			{
-				strings << item(i)->text();
-			}
+			strings << index.data(Qt::DisplayRole).toString();
 		}
 		
 		QApplication::clipboard()->setText(strings.join("\n"));
 	}
 	else
 	{
-		QListWidget::keyPressEvent(event);
+		QListView::keyPressEvent(event);
 	}
 }
 
@@ -106,15 +326,19 @@ void ccConsole::ReleaseInstance(bool flush/*=true*/)
 
 ccConsole::ccConsole()
 	: m_textDisplay(nullptr)
+	, m_model(nullptr)
 	, m_parentWidget(nullptr)
 	, m_parentWindow(nullptr)
-	, m_logStream(nullptr)
+	, m_queue(1 << 16)
+	, m_logFileWriter(nullptr)
 {
 }
 
 ccConsole::~ccConsole()
 {
-	setLogFile(QString()); //to close/delete any active stream
+	setLogFile(QString()); //to close any active log file
+
+	delete m_logFileWriter.exchange(nullptr);
 }
 
 void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
@@ -188,7 +412,7 @@ void ccConsole::EnableQtMessages(bool state)
 	settings.endGroup();
 }
 
-void ccConsole::Init(	QListWidget* textDisplay/*=0*/,
+void ccConsole::Init(	QListView* textDisplay/*=0*/,
 						QWidget* parentWidget/*=0*/,
 						MainWindow* parentWindow/*=0*/,
 						bool redirectToStdOut/*=false*/)
@@ -208,6 +432,10 @@ void ccConsole::Init(	QListWidget* textDisplay/*=0*/,
 	//auto-start
 	if (textDisplay)
 	{
+		s_console.instance->m_model = new ccConsoleModel(s_console.instance);
+		textDisplay->setModel(s_console.instance->m_model);
+		textDisplay->setUniformItemSizes(true); //so that the view only needs to query the visible rows
+
 		//load from persistent settings
 		QSettings settings;
 		settings.beginGroup(ccPS::Console());
@@ -238,66 +466,35 @@ void ccConsole::setAutoRefresh(bool state)
 
 void ccConsole::refresh()
 {
-	m_mutex.lock();
-	
-	if ((m_textDisplay || m_logStream) && !m_queue.isEmpty())
+	if (!m_textDisplay || !m_model)
 	{
-		for (QVector<ConsoleItemType>::const_iterator it=m_queue.constBegin(); it!=m_queue.constEnd(); ++it)
-		{
-			 //it->second = message severity
-			bool debugMessage = (it->second & LOG_DEBUG);
-#ifndef QT_DEBUG
-			//skip debug message in release mode
-			if (debugMessage)
-				continue;
-#endif
-
-			//destination: log file
-			if (m_logStream)
-			{
-				*m_logStream << it->first << endl;
-			}
-
-			//destination: console widget
-			if (m_textDisplay)
-			{
-				//it->first = message text
-				QListWidgetItem* item = new QListWidgetItem(it->first);
+		return;
+	}
 
-				//set color based on the message severity
-				//Error
-				if (it->second & LOG_ERROR)
-				{
-					item->setForeground(Qt::red);
-				}
-				//Warning
-				else if (it->second & LOG_WARNING)
-				{
-					item->setForeground(Qt::darkRed);
-					//we also force the console visibility if a warning message arrives!
-					if (m_parentWindow)
-						m_parentWindow->forceConsoleDisplay();
-				}
-#ifdef QT_DEBUG
-				else if (debugMessage) {
-					item->setForeground(Qt::blue);
-				}
-#endif
+	std::vector<ccLogRingBuffer::Record> records;
+	if (m_queue.popAll(records) == 0)
+	{
+		return;
+	}
 
-				m_textDisplay->addItem(item);
-			}
+	//we force the console visibility if a warning message arrives!
+	bool warningMessage = false;
+	for (const ccLogRingBuffer::Record& record : records)
+	{
+		if ((record.level & LOG_WARNING) && !(record.level & LOG_ERROR))
+		{
+			warningMessage = true;
+			break;
 		}
-
-		if (m_logStream)
-			m_logFile.flush();
-
-		if (m_textDisplay)
-			m_textDisplay->scrollToBottom();
 	}
 
-	m_queue.clear();
+	m_model->append(records);
+	m_textDisplay->scrollToBottom();
 
-	m_mutex.unlock();
+	if (warningMessage && m_parentWindow)
+	{
+		m_parentWindow->forceConsoleDisplay();
+	}
 }
 
 void ccConsole::logMessage(const QString& message, int level)
@@ -310,16 +507,35 @@ void ccConsole::logMessage(const QString& message, int level)
 	}
 #endif
 
-	QString formatedMessage = QStringLiteral("[") + QTime::currentTime().toString() + QStringLiteral("] ") + message;
 	if (s_redirectToStdOut)
 	{
 		printf("%s\n", qPrintable(message));
 	}
-	if (m_textDisplay || m_logStream)
+
+	//the message will only be formatted when (and if) it is displayed or written
+	ccLogRingBuffer::Record record;
+	record.message = message;
+	record.level = level;
+	record.msecs = QTime::currentTime().msecsSinceStartOfDay();
+
+	ccLogFileWriter* logFileWriter = m_logFileWriter.load();
+	bool toLogFile = (logFileWriter && logFileWriter->isActive());
+
+	if (m_textDisplay || toLogFile)
 	{
-		m_mutex.lock();
-		m_queue.push_back(ConsoleItemType(formatedMessage,level));
-		m_mutex.unlock();
+		if (toLogFile)
+		{
+			logFileWriter->push(m_textDisplay ? ccLogRingBuffer::Record(record) : std::move(record));
+			if (level & LOG_ERROR)
+			{
+				//don't wait to write errors
+				logFileWriter->wakeUp();
+			}
+		}
+		if (m_textDisplay)
+		{
+			m_queue.push(std::move(record));
+		}
 	}
 #ifdef QT_DEBUG
 	else
@@ -348,7 +564,7 @@ void ccConsole::logMessage(const QString& message, int level)
 			else
 				printf("MSG: ");
 		}
-		printf(" %s\n",qPrintable(formatedMessage));
+		printf(" %s\n",qPrintable(ccLogRingBuffer::Format(record)));
 	}
 #endif
 
@@ -365,32 +581,26 @@ void ccConsole::logMessage(const QString& message, int level)
 
 bool ccConsole::setLogFile(const QString& filename)
 {
-	//close previous stream (if any)
-	if (m_logStream)
+	//close previous file (if any)
+	ccLogFileWriter* logFileWriter = m_logFileWriter.load();
+	if (logFileWriter)
 	{
-		m_mutex.lock();
-		delete m_logStream;
-		m_logStream = nullptr;
-		m_mutex.unlock();
-
-		if (m_logFile.isOpen())
-		{
-			m_logFile.close();
-		}
+		logFileWriter->close();
 	}
 	
 	if (!filename.isEmpty())
 	{
-		m_logFile.setFileName(filename);
-		if (!m_logFile.open(QFile::Text| QFile::WriteOnly))
+		if (!logFileWriter)
 		{
-			return Error(QString("[Console] Failed to open/create log file '%1'").arg(filename));
+			//the writer is only released with the console (as other threads may be using it)
+			logFileWriter = new ccLogFileWriter;
+			m_logFileWriter = logFileWriter;
 		}
 
-		m_mutex.lock();
-		m_logStream = new QTextStream(&m_logFile);
-		m_mutex.unlock();
-		setAutoRefresh(true);
+		if (!logFileWriter->open(filename))
+		{
+			return Error(QString("[Console] Failed to open/create log file '%1'").arg(filename));
+		}
 	}
 
 	return true;
@@ -21,22 +21,24 @@
 //qCC_db
 #include <ccLog.h>
 
+//Local
+#include "ccLogRingBuffer.h"
+
 //Qt
-#include <QFile>
-#include <QListWidget>
-#include <QMutex>
+#include <QListView>
 #include <QTimer>
 
 class MainWindow;
-class QTextStream;
+class ccConsoleModel;
+class ccLogFileWriter;
 
-//! Custom QListWidget to allow for the copy of all selected elements when using CTRL+C
-class ccCustomQListWidget : public QListWidget
+//! Custom QListView to allow for the copy of all selected elements when using CTRL+C
+class ccCustomQListView : public QListView
 {
 	Q_OBJECT
 	
 public:
-	ccCustomQListWidget(QWidget* parent = nullptr);
+	ccCustomQListView(QWidget* parent = nullptr);
 
 protected:
 	void keyPressEvent(QKeyEvent *event) override;
@@ -62,7 +64,7 @@ public:
 		\param parentWindow parent window (if any - optional)
 		\param silentCommandLineMode will cause logmessage to printf (optional)
 	**/
-	static void Init(	QListWidget* textDisplay = nullptr,
+	static void Init(	QListView* textDisplay = nullptr,
 						QWidget* parentWidget = nullptr,
 						MainWindow* parentWindow = nullptr,
 						bool redirectToStdOut = false);
@@ -79,6 +81,8 @@ public:
 	void setAutoRefresh(bool state);
 
 	//! Sets log file
+	/** The messages are written by a dedicated thread.
+	**/
 	bool setLogFile(const QString& filename);
 
 	//! Whether to show Qt messages (qDebug / qWarning / etc.) in Console
@@ -106,7 +110,10 @@ protected:
 	void logMessage(const QString& message, int level) override;
 
 	//! Associated text display widget
-	QListWidget* m_textDisplay;
+	QListView* m_textDisplay;
+
+	//! Console model (only the visible rows are formatted by the view)
+	ccConsoleModel* m_model;
 
 	//! Parent widget
 	QWidget* m_parentWidget;
@@ -114,22 +121,14 @@ protected:
 	//! Parent window (if any)
 	MainWindow* m_parentWindow;
 
-	//! Mutex for concurrent thread access to console
-	QMutex m_mutex;
-
-	//! Queue element type (message + color)
-	using ConsoleItemType = QPair<QString,int>;
-
-	//! Queue for incoming messages
-	QVector<ConsoleItemType> m_queue;
+	//! Queue for incoming messages (lock-free)
+	ccLogRingBuffer m_queue;
 
 	//! Timer for auto-refresh
 	QTimer m_timer;
 
-	//! Log file
-	QFile m_logFile;
-	//! Log file stream
-	QTextStream* m_logStream;
+	//! Log file writer (if any)
+	std::atomic<ccLogFileWriter*> m_logFileWriter;
 
 	//! Whether to show Qt messages (qDebug / qWarning / etc.) in Console
 	static bool s_showQtMessagesInConsole;
@@ -378,53 +378,85 @@ namespace ccEntityAction
 		return true;
 	}
 
-	//! Interpolate scalar fields from on entity and transfer them to another one
+	//! Interpolate scalar fields from on entity and transfer them to another one (or several others)
 	bool	interpolateSFs(const ccHObject::Container &selectedEntities, ccMainAppInterface* app)
 	{
-		if (selectedEntities.size() != 2)
+		if (selectedEntities.size() < 2)
 		{
-			ccConsole::Error(QObject::tr("Select 2 entities (clouds or meshes)!"));
+			ccConsole::Error(QObject::tr("Select at least 2 entities (clouds or meshes)!"));
 			return false;
 		}
-		
-		ccHObject* ent1 = selectedEntities[0];
-		ccHObject* ent2 = selectedEntities[1];
-		
-		ccPointCloud* cloud1 = ccHObjectCaster::ToPointCloud(ent1);
-		ccPointCloud* cloud2 = ccHObjectCaster::ToPointCloud(ent2);
 
-		if (!cloud1 || !cloud2)
-		{
-			ccConsole::Error(QObject::tr("Select 2 entities (clouds or meshes)!"));
-			return false;
-		}
-		
-		if (!cloud1->hasScalarFields() && !cloud2->hasScalarFields())
-		{
-			ccConsole::Error(QObject::tr("None of the selected entities has per-point or per-vertex colors!"));
-			return false;
-		}
-		else if (cloud1->hasScalarFields() && cloud2->hasScalarFields())
+		ccPointCloud* source = nullptr;
+		std::vector<ccPointCloud*> destinations;
+
+		if (selectedEntities.size() == 2)
 		{
-			//ask the user to chose which will be the 'source' cloud
-			ccOrderChoiceDlg ocDlg(cloud1, QObject::tr("Source"), cloud2, QObject::tr("Destination"), app);
-			if (!ocDlg.exec())
+			ccHObject* ent1 = selectedEntities[0];
+			ccHObject* ent2 = selectedEntities[1];
+
+			ccPointCloud* cloud1 = ccHObjectCaster::ToPointCloud(ent1);
+			ccPointCloud* cloud2 = ccHObjectCaster::ToPointCloud(ent2);
+
+			if (!cloud1 || !cloud2)
 			{
-				//process cancelled by the user
+				ccConsole::Error(QObject::tr("Select 2 entities (clouds or meshes)!"));
+				return false;
+			}
+
+			if (!cloud1->hasScalarFields() && !cloud2->hasScalarFields())
+			{
+				ccConsole::Error(QObject::tr("None of the selected entities has per-point or per-vertex scalar fields!"));
 				return false;
 			}
-			if (cloud1 != ocDlg.getFirstEntity())
+			else if (cloud1->hasScalarFields() && cloud2->hasScalarFields())
+			{
+				//ask the user to chose which will be the 'source' cloud
+				ccOrderChoiceDlg ocDlg(cloud1, QObject::tr("Source"), cloud2, QObject::tr("Destination"), app);
+				if (!ocDlg.exec())
+				{
+					//process cancelled by the user
+					return false;
+				}
+				if (cloud1 != ocDlg.getFirstEntity())
+				{
+					std::swap(cloud1, cloud2);
+				}
+			}
+			else if (cloud2->hasScalarFields())
 			{
 				std::swap(cloud1, cloud2);
 			}
+
+			source = cloud1;
+			destinations.push_back(cloud2);
 		}
-		else if (cloud2->hasScalarFields())
+		else
 		{
-			std::swap(cloud1, cloud2);
+			//the first selected entity is the source, all the others are destinations
+			//(the source octree will be shared by all the interpolations)
+			source = ccHObjectCaster::ToPointCloud(selectedEntities.front());
+			if (!source || !source->hasScalarFields())
+			{
+				ccConsole::Error(QObject::tr("The first selected entity (source) must be a cloud or a mesh with scalar fields!"));
+				return false;
+			}
+			for (size_t i = 1; i < selectedEntities.size(); ++i)
+			{
+				ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(selectedEntities[i]);
+				if (!cloud || cloud == source)
+				{
+					ccConsole::Warning(QObject::tr("Entity '%1' is not a cloud or a mesh: ignored").arg(selectedEntities[i]->getName()));
+					continue;
+				}
+				destinations.push_back(cloud);
+			}
+			if (destinations.empty())
+			{
+				ccConsole::Error(QObject::tr("No valid destination entity!"));
+				return false;
+			}
 		}
-		
-		ccPointCloud* source = cloud1;
-		ccPointCloud* dest = cloud2;
 
 		//show the list of scalar fields available on the source point cloud
 		std::vector<int> sfIndexes;
@@ -473,12 +505,14 @@ namespace ccEntityAction
 		static ccPointCloudInterpolator::Parameters::Method s_interpMethod = ccPointCloudInterpolator::Parameters::RADIUS;
 		static ccPointCloudInterpolator::Parameters::Algo s_interpAlgo = ccPointCloudInterpolator::Parameters::NORMAL_DIST;
 		static int s_interpKNN = 6;
+		static double s_interpPower = 2.0;
 
 		ccInterpolationDlg iDlg(app->getMainWindow());
 		iDlg.setInterpolationMethod(s_interpMethod);
 		iDlg.setInterpolationAlgorithm(s_interpAlgo);
 		iDlg.knnSpinBox->setValue(s_interpKNN);
-		iDlg.radiusDoubleSpinBox->setValue(dest->getOwnBB().getDiagNormd() / 100);
+		iDlg.idwPowerDoubleSpinBox->setValue(s_interpPower);
+		iDlg.radiusDoubleSpinBox->setValue(destinations.front()->getOwnBB().getDiagNormd() / 100);
 
 		if (!iDlg.exec())
 		{
@@ -493,22 +527,41 @@ namespace ccEntityAction
 		params.knn = s_interpKNN = iDlg.knnSpinBox->value();
 		params.radius = iDlg.radiusDoubleSpinBox->value();
 		params.sigma = iDlg.kernelDoubleSpinBox->value();
+		params.power = s_interpPower = iDlg.idwPowerDoubleSpinBox->value();
 
 		ccProgressDialog pDlg(true, app->getMainWindow());
-		unsigned sfCountBefore = dest->getNumberOfScalarFields();
 
-		if (ccPointCloudInterpolator::InterpolateScalarFieldsFrom(dest, source, sfIndexes, params, &pDlg))
+		ccPointCloudInterpolator::Engine engine;
+		if (!engine.setSource(source, sfIndexes, params, &pDlg))
 		{
-			dest->setCurrentDisplayedScalarField(static_cast<int>(std::min(sfCountBefore + 1, dest->getNumberOfScalarFields())) - 1);
-			dest->showSF(true);
+			ccConsole::Error(QObject::tr("An error occurred! (see console)"));
+			return false;
 		}
-		else
+
+		bool success = true;
+		for (ccPointCloud* dest : destinations)
 		{
-			ccConsole::Error(QObject::tr("An error occurred! (see console)"));
+			unsigned sfCountBefore = dest->getNumberOfScalarFields();
+
+			if (engine.interpolateTo(dest, &pDlg))
+			{
+				dest->setCurrentDisplayedScalarField(static_cast<int>(std::min(sfCountBefore + 1, dest->getNumberOfScalarFields())) - 1);
+				dest->showSF(true);
+			}
+			else
+			{
+				ccConsole::Error(QObject::tr("An error occurred! (see console)"));
+				success = false;
+			}
+
+			dest->prepareDisplayForRefresh_recursive();
+
+			if (!success)
+			{
+				break;
+			}
 		}
 		
-		dest->prepareDisplayForRefresh_recursive();
-		
 		return true;
 	}
 	
@@ -1537,10 +1590,14 @@ namespace ccEntityAction
 			static ccNormalVectors::Orientation s_lastNormalOrientation = ccNormalVectors::UNDEFINED;
 			static int s_lastMSTNeighborCount = 6;
 			static double s_lastMinGridAngle_deg = 1.0;
+			static bool s_lastUseKNN = false;
+			static int s_lastKNN = 12;
 			
 			ccNormalComputationDlg ncDlg(withScanGrid, withSensor, parent);
 			ncDlg.setLocalModel(s_lastModelType);
 			ncDlg.setRadius(defaultRadius);
+			ncDlg.setKNN(s_lastKNN);
+			ncDlg.setUseKNN(s_lastUseKNN);
 			ncDlg.setPreferredOrientation(s_lastNormalOrientation);
 			ncDlg.setMSTNeighborCount(s_lastMSTNeighborCount);
 			ncDlg.setMinGridAngle_deg(s_lastMinGridAngle_deg);
@@ -1556,6 +1613,9 @@ namespace ccEntityAction
 			CCCoreLib::LOCAL_MODEL_TYPES model = s_lastModelType = ncDlg.getLocalModel();
 			bool useGridStructure = withScanGrid && ncDlg.useScanGridsForComputation();
 			defaultRadius = ncDlg.getRadius();
+			s_lastUseKNN = ncDlg.useKNN();
+			s_lastKNN = ncDlg.getKNN();
+			unsigned kNN = s_lastUseKNN ? static_cast<unsigned>(s_lastKNN) : 0;
 			double minGridAngle_deg = s_lastMinGridAngle_deg = ncDlg.getMinGridAngle_deg();
 			
 			//normals orientation
@@ -1620,8 +1680,8 @@ namespace ccEntityAction
 				{
 					//compute normals with the octree
 					normalsAlreadyOriented = orientNormals && (preferredOrientation != ccNormalVectors::UNDEFINED);
-					result = cloud->computeNormalsWithOctree(model, orientNormals ? preferredOrientation : ccNormalVectors::UNDEFINED, defaultRadius, &pDlg);
-					if (result)
+					result = cloud->computeNormalsWithOctree(model, orientNormals ? preferredOrientation : ccNormalVectors::UNDEFINED, defaultRadius, &pDlg, kNN);
+					if (result && kNN == 0)
 					{
 						//save the normal computation radius as meta-data
 						cloud->setMetaData(s_NormalScaleKey, defaultRadius);
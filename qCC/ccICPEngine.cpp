@@ -0,0 +1,646 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccICPEngine.h"
+
+//CCCoreLib
+#include <ScalarField.h>
+
+//qCC_db
+#include <ccGenericPointCloud.h>
+#include <ccHObjectCaster.h>
+#include <ccLog.h>
+
+//Qt
+#include <QString>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+//system
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+
+//! Max number of iterations per level (when the convergence is driven by the RMS decrease)
+static const unsigned s_maxIterationCountPerLevel = 100;
+//! Min number of data points sampled at the coarsest level
+static const unsigned s_minSampledPointCount = 1000;
+//! Number of data points processed by each correspondence search job
+static const unsigned s_matchingChunkSize = 1024;
+
+//! Correspondence between a (transformed) data point and its nearest model point
+struct ICPMatch
+{
+	CCVector3d P; //transformed data point
+	CCVector3d Q; //nearest model point
+	CCVector3d N; //model normal at Q (point-to-plane only)
+	double squareDist = -1.0; //negative if the match is invalid
+	double weight = 1.0;
+};
+
+//! Data shared by all the correspondence search jobs of a given iteration
+struct ICPMatchingContext
+{
+	const ccOctree* octree = nullptr;
+	const ccGenericPointCloud* model = nullptr;
+	unsigned char level = 0;
+	bool withNormals = false;
+	const CCCoreLib::ScalarField* modelWeights = nullptr;
+	const std::vector<CCVector3d>* dataPoints = nullptr;
+	const std::vector<double>* dataWeights = nullptr;
+	ccGLMatrixd trans;
+	std::vector<ICPMatch>* matches = nullptr;
+};
+
+//! Correspondence search job
+struct ICPMatchingChunk
+{
+	const ICPMatchingContext* context = nullptr;
+	unsigned begin = 0;
+	unsigned end = 0;
+};
+
+static void FindMatches(ICPMatchingChunk& chunk)
+{
+	const ICPMatchingContext& context = *chunk.context;
+
+	CCCoreLib::DgmOctree::NearestNeighboursSearchStruct nNSS;
+	nNSS.level = context.level;
+	nNSS.minNumberOfNeighbors = 1;
+
+	for (unsigned i = chunk.begin; i < chunk.end; ++i)
+	{
+		ICPMatch& match = context.matches->at(i);
+		match.P = context.trans * context.dataPoints->at(i);
+		match.squareDist = -1.0;
+
+		CCVector3 P = CCVector3::fromArray(match.P.u);
+		nNSS.queryPoint = P;
+		context.octree->getTheCellPosWhichIncludesThePoint(&P, nNSS.cellPos, context.level);
+		context.octree->computeCellCenter(nNSS.cellPos, context.level, nNSS.cellCenter);
+		nNSS.pointsInNeighbourhood.clear();
+		nNSS.alreadyVisitedNeighbourhoodSize = 0;
+
+		if (context.octree->findNearestNeighborsStartingFromCell(nNSS, false) == 0)
+		{
+			continue;
+		}
+
+		const CCCoreLib::DgmOctree::PointDescriptor& nearest = nNSS.pointsInNeighbourhood.front();
+		match.Q = CCVector3d::fromArray(nearest.point->u);
+		match.squareDist = nearest.squareDistd;
+
+		match.weight = (context.dataWeights ? context.dataWeights->at(i) : 1.0);
+		if (context.modelWeights)
+		{
+			ScalarType w = context.modelWeights->getValue(nearest.pointIndex);
+			match.weight *= (CCCoreLib::ScalarField::ValidValue(w) ? std::abs(w) : 0.0);
+		}
+
+		if (context.withNormals)
+		{
+			match.N = CCVector3d::fromArray(context.model->getPointNormal(nearest.pointIndex).u);
+		}
+	}
+}
+
+//! Solves a (small) linear system with Gaussian elimination and partial pivoting
+/** \param A n x n matrix (row major, modified)
+	\param b right hand side (modified)
+	\param x solution
+**/
+static bool SolveLinearSystem(std::vector<double>& A, std::vector<double>& b, std::vector<double>& x)
+{
+	const size_t n = b.size();
+	for (size_t c = 0; c < n; ++c)
+	{
+		size_t pivot = c;
+		for (size_t r = c + 1; r < n; ++r)
+		{
+			if (std::abs(A[r * n + c]) > std::abs(A[pivot * n + c]))
+				pivot = r;
+		}
+		if (std::abs(A[pivot * n + c]) < 1.0e-12)
+		{
+			//singular system
+			return false;
+		}
+		if (pivot != c)
+		{
+			for (size_t k = 0; k < n; ++k)
+				std::swap(A[c * n + k], A[pivot * n + k]);
+			std::swap(b[c], b[pivot]);
+		}
+		for (size_t r = c + 1; r < n; ++r)
+		{
+			double f = A[r * n + c] / A[c * n + c];
+			for (size_t k = c; k < n; ++k)
+				A[r * n + k] -= f * A[c * n + k];
+			b[r] -= f * b[c];
+		}
+	}
+
+	x.resize(n);
+	for (size_t c = n; c-- > 0;)
+	{
+		double sum = b[c];
+		for (size_t k = c + 1; k < n; ++k)
+			sum -= A[c * n + k] * x[k];
+		x[c] = sum / A[c * n + c];
+	}
+
+	return true;
+}
+
+//! Computes the (linearized) rigid transformation increment that minimizes the error between the valid matches
+/** Unknowns are (rx, ry, rz, tx, ty, tz). They are expressed relatively to the
+	gravity center of the data points for a better conditioning (unless some
+	translation filters are active).
+**/
+static bool ComputeIncrement(	const std::vector<ICPMatch>& matches,
+								ccICPEngine::ErrorMetric metric,
+								int filters,
+								ccGLMatrixd& increment)
+{
+	//gravity center of the data points
+	CCVector3d G(0, 0, 0);
+	double wSum = 0.0;
+	for (const ICPMatch& match : matches)
+	{
+		if (match.squareDist >= 0 && match.weight > 0)
+		{
+			G += match.P * match.weight;
+			wSum += match.weight;
+		}
+	}
+	if (wSum <= 0)
+	{
+		return false;
+	}
+	G /= wSum;
+
+	//translation filters apply to the absolute translation: in this case the rotation
+	//must be expressed relatively to the origin
+	if (filters & (CCCoreLib::RegistrationTools::SKIP_TX | CCCoreLib::RegistrationTools::SKIP_TY | CCCoreLib::RegistrationTools::SKIP_TZ))
+	{
+		G = CCVector3d(0, 0, 0);
+	}
+
+	//normal equations
+	double AtA[6][6] = {};
+	double Atb[6] = {};
+	auto addRow = [&](const double J[6], double r, double w)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			for (int j = i; j < 6; ++j)
+				AtA[i][j] += w * J[i] * J[j];
+			Atb[i] += w * J[i] * r;
+		}
+	};
+
+	for (const ICPMatch& match : matches)
+	{
+		if (match.squareDist < 0 || match.weight <= 0)
+			continue;
+
+		CCVector3d P = match.P - G;
+		CCVector3d D = match.Q - match.P;
+
+		if (metric == ccICPEngine::POINT_TO_PLANE)
+		{
+			CCVector3d PxN = P.cross(match.N);
+			double J[6] = { PxN.x, PxN.y, PxN.z, match.N.x, match.N.y, match.N.z };
+			addRow(J, D.dot(match.N), match.weight);
+		}
+		else
+		{
+			double Jx[6] = { 0.0,  P.z, -P.y, 1.0, 0.0, 0.0 };
+			double Jy[6] = { -P.z, 0.0,  P.x, 0.0, 1.0, 0.0 };
+			double Jz[6] = { P.y, -P.x, 0.0,  0.0, 0.0, 1.0 };
+			addRow(Jx, D.x, match.weight);
+			addRow(Jy, D.y, match.weight);
+			addRow(Jz, D.z, match.weight);
+		}
+	}
+
+	//active unknowns (depending on the transformation filters)
+	bool active[6] = { true, true, true, true, true, true };
+	if (filters & CCCoreLib::RegistrationTools::SKIP_RYZ)
+		active[1] = active[2] = false;
+	if (filters & CCCoreLib::RegistrationTools::SKIP_RXZ)
+		active[0] = active[2] = false;
+	if (filters & CCCoreLib::RegistrationTools::SKIP_RXY)
+		active[0] = active[1] = false;
+	if (filters & CCCoreLib::RegistrationTools::SKIP_TX)
+		active[3] = false;
+	if (filters & CCCoreLib::RegistrationTools::SKIP_TY)
+		active[4] = false;
+	if (filters & CCCoreLib::RegistrationTools::SKIP_TZ)
+		active[5] = false;
+
+	std::vector<int> unknowns;
+	for (int i = 0; i < 6; ++i)
+	{
+		if (active[i])
+			unknowns.push_back(i);
+	}
+
+	double x[6] = {};
+	if (!unknowns.empty())
+	{
+		const size_t n = unknowns.size();
+		std::vector<double> A(n * n), b(n), sol;
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t j = 0; j < n; ++j)
+			{
+				int u = std::min(unknowns[i], unknowns[j]);
+				int v = std::max(unknowns[i], unknowns[j]);
+				A[i * n + j] = AtA[u][v];
+			}
+			b[i] = Atb[unknowns[i]];
+		}
+
+		if (!SolveLinearSystem(A, b, sol))
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < n; ++i)
+			x[unknowns[i]] = sol[i];
+	}
+
+	//rotation (around G) + translation
+	CCVector3d omega(x[0], x[1], x[2]);
+	double angle = omega.norm();
+	increment.toIdentity();
+	if (angle > 1.0e-12)
+	{
+		increment.initFromParameters(angle, omega / angle, CCVector3d(0, 0, 0));
+	}
+	CCVector3d RG = G;
+	increment.applyRotation(RG);
+	increment.setTranslation(G + CCVector3d(x[3], x[4], x[5]) - RG);
+
+	return true;
+}
+
+ccICPEngine::ccICPEngine()
+	: m_modelCloud(nullptr)
+	, m_octreeLevel(0)
+{}
+
+bool ccICPEngine::setModel(ccHObject* model, CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/)
+{
+	m_modelCloud = nullptr;
+	m_modelOctree.clear();
+
+	if (model && model->isKindOf(CC_TYPES::MESH))
+	{
+		//the correspondences are searched between points only: a mesh would silently be reduced to its vertices
+		ccLog::Warning("[ICP] Mesh models are not supported by the ICP engine (point-to-triangle distances are required)");
+		return false;
+	}
+
+	ccGenericPointCloud* cloud = ccHObjectCaster::ToGenericPointCloud(model);
+	if (!cloud || cloud->size() == 0)
+	{
+		ccLog::Warning("[ICP] Invalid or empty model entity");
+		return false;
+	}
+
+	ccOctree::Shared octree = cloud->getOctree();
+	if (!octree)
+	{
+		octree = cloud->computeOctree(progressCb);
+		if (!octree)
+		{
+			ccLog::Warning("[ICP] Failed to compute the model octree (not enough memory?)");
+			return false;
+		}
+	}
+
+	m_modelCloud = cloud;
+	m_modelOctree = octree;
+	m_octreeLevel = octree->findBestLevelForAGivenPopulationPerCell(3);
+
+	return true;
+}
+
+bool ccICPEngine::modelHasNormals() const
+{
+	return m_modelCloud && m_modelCloud->hasNormals();
+}
+
+bool ccICPEngine::registerData(	CCCoreLib::GenericIndexedCloudPersist* data,
+								const CCCoreLib::ICPRegistrationTools::Parameters& params,
+								const Options& options,
+								Result& result,
+								CCCoreLib::GenericProgressCallback* progressCb/*=nullptr*/) const
+{
+	result = Result();
+
+	if (!hasModel())
+	{
+		ccLog::Warning("[ICP] No model set");
+		return false;
+	}
+	if (!data || data->size() == 0)
+	{
+		ccLog::Warning("[ICP] Invalid or empty data cloud");
+		return false;
+	}
+
+	ErrorMetric metric = options.metric;
+	if (metric == POINT_TO_PLANE && !modelHasNormals())
+	{
+		ccLog::Warning("[ICP] Model has no normals: point-to-point metric will be used instead of point-to-plane");
+		metric = POINT_TO_POINT;
+	}
+
+	const unsigned dataCount = data->size();
+	const unsigned levelCount = std::max(1u, options.levelCount);
+	const unsigned finestCount = (params.samplingLimit != 0 ? std::min(dataCount, params.samplingLimit) : dataCount);
+	const double overlapRatio = std::min(1.0, std::max(0.01, params.finalOverlapRatio));
+	const unsigned minMatchCount = (metric == POINT_TO_PLANE ? 6 : 3);
+
+	if (progressCb)
+	{
+		if (progressCb->textCanBeEdited())
+		{
+			progressCb->setMethodTitle("ICP registration");
+			progressCb->setInfo(qPrintable(QString("Data points: %1\nLevels: %2").arg(dataCount).arg(levelCount)));
+		}
+		progressCb->update(0);
+		progressCb->start();
+	}
+
+	std::mt19937 generator(std::random_device{}());
+
+	//local pool, so as to not change the global one (the engine can be used concurrently)
+	int maxThreadCount = params.maxThreadCount;
+	if (maxThreadCount <= 0 || maxThreadCount > QThread::idealThreadCount())
+	{
+		maxThreadCount = QThread::idealThreadCount();
+	}
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(maxThreadCount);
+
+	ccGLMatrixd trans;
+	std::vector<CCVector3d> dataPoints;
+	std::vector<double> dataWeights;
+	std::vector<ICPMatch> matches;
+	std::vector<ICPMatchingChunk> chunks;
+	std::vector<double> squareDists;
+
+	for (unsigned level = 0; level < levelCount; ++level)
+	{
+		//number of points sampled at this level (divided by 4 at each coarser level)
+		unsigned sampledCount = finestCount;
+		for (unsigned l = level + 1; l < levelCount && sampledCount / 4 >= s_minSampledPointCount; ++l)
+		{
+			sampledCount /= 4;
+		}
+
+		//random (but ordered) selection of the data points
+		try
+		{
+			dataPoints.resize(sampledCount);
+			dataWeights.resize(params.dataWeights ? sampledCount : 0);
+			matches.resize(sampledCount);
+		}
+		catch (const std::bad_alloc&)
+		{
+			ccLog::Warning("[ICP] Not enough memory");
+			return false;
+		}
+		{
+			unsigned selected = 0;
+			for (unsigned i = 0; i < dataCount && selected < sampledCount; ++i)
+			{
+				if (sampledCount != dataCount)
+				{
+					//selection sampling (Knuth's algorithm S)
+					std::uniform_int_distribution<unsigned> distribution(0, dataCount - i - 1);
+					if (distribution(generator) >= sampledCount - selected)
+						continue;
+				}
+				dataPoints[selected] = CCVector3d::fromArray(data->getPoint(i)->u);
+				if (params.dataWeights)
+				{
+					ScalarType w = params.dataWeights->getValue(i);
+					dataWeights[selected] = (CCCoreLib::ScalarField::ValidValue(w) ? std::abs(w) : 0.0);
+				}
+				++selected;
+			}
+			assert(selected == sampledCount);
+		}
+
+		ICPMatchingContext context;
+		context.octree = m_modelOctree.data();
+		context.model = m_modelCloud;
+		context.level = m_octreeLevel;
+		context.withNormals = (metric == POINT_TO_PLANE);
+		context.modelWeights = params.modelWeights;
+		context.dataPoints = &dataPoints;
+		context.dataWeights = (params.dataWeights ? &dataWeights : nullptr);
+		context.matches = &matches;
+
+		chunks.clear();
+		for (unsigned begin = 0; begin < sampledCount; begin += s_matchingChunkSize)
+		{
+			ICPMatchingChunk chunk;
+			chunk.context = &context;
+			chunk.begin = begin;
+			chunk.end = std::min(begin + s_matchingChunkSize, sampledCount);
+			chunks.push_back(chunk);
+		}
+
+		double previousRMS = -1.0;
+		for (unsigned iteration = 0; ; ++iteration)
+		{
+			//correspondences
+			context.trans = trans;
+			if (params.maxThreadCount == 1 || chunks.size() == 1)
+			{
+				for (ICPMatchingChunk& chunk : chunks)
+					FindMatches(chunk);
+			}
+			else
+			{
+				//each worker processes the chunks one after the other
+				const int workerCount = std::min(maxThreadCount, static_cast<int>(chunks.size()));
+				std::atomic<size_t> nextChunk(0);
+				std::vector< QFuture<void> > workers;
+				workers.reserve(workerCount);
+				for (int w = 0; w < workerCount; ++w)
+				{
+					workers.push_back(QtConcurrent::run(&threadPool, [&nextChunk, &chunks]()
+					{
+						for (size_t c = nextChunk++; c < chunks.size(); c = nextChunk++)
+						{
+							FindMatches(chunks[c]);
+						}
+					}));
+				}
+				for (QFuture<void>& worker : workers)
+				{
+					worker.waitForFinished();
+				}
+			}
+
+			//keep the closest matches (final overlap)
+			squareDists.clear();
+			for (const ICPMatch& match : matches)
+			{
+				if (match.squareDist >= 0)
+					squareDists.push_back(match.squareDist);
+			}
+			if (squareDists.size() < minMatchCount)
+			{
+				ccLog::Warning("[ICP] Not enough correspondences");
+				return false;
+			}
+			size_t keptCount = std::min(squareDists.size(), static_cast<size_t>(std::ceil(overlapRatio * sampledCount)));
+			keptCount = std::max<size_t>(keptCount, minMatchCount);
+			double maxSquareDist = std::numeric_limits<double>::max();
+			if (keptCount < squareDists.size())
+			{
+				std::nth_element(squareDists.begin(), squareDists.begin() + (keptCount - 1), squareDists.end());
+				maxSquareDist = squareDists[keptCount - 1];
+			}
+
+			//remove the farthest points (mean + 3 sigma)
+			if (params.filterOutFarthestPoints)
+			{
+				double sum = 0.0;
+				double sum2 = 0.0;
+				unsigned count = 0;
+				for (const ICPMatch& match : matches)
+				{
+					if (match.squareDist >= 0 && match.squareDist <= maxSquareDist)
+					{
+						double d = std::sqrt(match.squareDist);
+						sum += d;
+						sum2 += d * d;
+						++count;
+					}
+				}
+				double mean = sum / count;
+				double stdDev = std::sqrt(std::max(0.0, sum2 / count - mean * mean));
+				double maxDist = mean + 3.0 * stdDev;
+				maxSquareDist = std::min(maxSquareDist, maxDist * maxDist);
+			}
+
+			//(weighted) RMS
+			double errorSum = 0.0;
+			double wSum = 0.0;
+			double distSum = 0.0;
+			double maxKeptDist = 0.0;
+			unsigned matchCount = 0;
+			for (ICPMatch& match : matches)
+			{
+				if (match.squareDist > maxSquareDist)
+				{
+					match.squareDist = -1.0;
+				}
+				if (match.squareDist < 0 || match.weight <= 0)
+				{
+					continue;
+				}
+
+				double e2 = match.squareDist;
+				if (metric == POINT_TO_PLANE)
+				{
+					double e = (match.Q - match.P).dot(match.N);
+					e2 = e * e;
+				}
+				errorSum += match.weight * e2;
+				wSum += match.weight;
+				++matchCount;
+
+				double d = std::sqrt(match.squareDist);
+				distSum += d;
+				maxKeptDist = std::max(maxKeptDist, d);
+			}
+			if (matchCount < minMatchCount || wSum <= 0)
+			{
+				ccLog::Warning("[ICP] Not enough correspondences");
+				return false;
+			}
+			double rms = std::sqrt(errorSum / wSum);
+
+			result.finalRMS = rms;
+			result.finalPointCount = matchCount;
+			result.meanDistance = distSum / matchCount;
+			result.maxDistance = maxKeptDist;
+
+			if (progressCb)
+			{
+				if (progressCb->textCanBeEdited())
+				{
+					progressCb->setInfo(qPrintable(QString("Level %1/%2 - iteration %3\nRMS = %4").arg(level + 1).arg(levelCount).arg(iteration + 1).arg(rms)));
+				}
+				progressCb->update(100.0f * (level + std::min(1.0f, static_cast<float>(iteration) / s_maxIterationCountPerLevel)) / levelCount);
+				if (progressCb->isCancelRequested())
+				{
+					return false;
+				}
+			}
+
+			//convergence
+			if (params.convType == CCCoreLib::ICPRegistrationTools::MAX_ERROR_CONVERGENCE)
+			{
+				if (	(previousRMS >= 0 && previousRMS - rms < params.minRMSDecrease)
+					||	iteration >= s_maxIterationCountPerLevel)
+				{
+					break;
+				}
+			}
+			else if (iteration >= std::max(1u, params.nbMaxIterations))
+			{
+				break;
+			}
+			previousRMS = rms;
+
+			ccGLMatrixd increment;
+			if (!ComputeIncrement(matches, metric, params.transformationFilters, increment))
+			{
+				ccLog::Warning("[ICP] Degenerate configuration, can't go further");
+				break;
+			}
+			trans = increment * trans;
+			++result.iterationCount;
+		}
+
+		result.sampledPointCount = sampledCount;
+	}
+
+	result.transMat = trans;
+
+	if (progressCb)
+	{
+		progressCb->stop();
+	}
+
+	return true;
+}
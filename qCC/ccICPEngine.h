@@ -0,0 +1,132 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_ICP_ENGINE_HEADER
+#define CC_ICP_ENGINE_HEADER
+
+//CCCoreLib
+#include <RegistrationTools.h>
+
+//qCC_db
+#include <ccGLMatrix.h>
+#include <ccOctree.h>
+
+class ccHObject;
+class ccGenericPointCloud;
+
+//! ICP registration engine with a persistent 'model' index
+/** The model spatial index (octree) is built once by setModel and shared by all
+	subsequent calls to registerData (which is const and can be called concurrently).
+	Compared to CCCoreLib::ICPRegistrationTools, it adds:
+	- a point-to-plane error metric (based on the model normals)
+	- a coarse-to-fine schedule (the data cloud is subsampled more aggressively
+	at the first levels)
+	- a parallel correspondence search
+
+	Scale adjustment and mesh models (which require point-to-triangle distances) are
+	not supported (see ccRegistrationTools::ICP which falls back to the standard
+	algorithm in this case).
+**/
+class ccICPEngine
+{
+public:
+
+	//! Error metric
+	enum ErrorMetric
+	{
+		POINT_TO_POINT = 0,
+		POINT_TO_PLANE = 1,
+	};
+
+	//! Engine specific options
+	struct Options
+	{
+		//! Error metric
+		ErrorMetric metric = POINT_TO_POINT;
+		//! Number of resolution levels (1 = full resolution only)
+		unsigned levelCount = 1;
+	};
+
+	//! Registration result
+	struct Result
+	{
+		//! Transformation to apply to the data cloud
+		ccGLMatrixd transMat;
+		//! Final (potentially weighted) RMS
+		double finalRMS = 0.0;
+		//! Number of points used for the final step (i.e. the kept matches)
+		unsigned finalPointCount = 0;
+		//! Mean distance of the kept matches (final step)
+		double meanDistance = 0.0;
+		//! Max distance of the kept matches (final step)
+		double maxDistance = 0.0;
+		//! Number of data points sampled at the finest level
+		unsigned sampledPointCount = 0;
+		//! Total number of iterations (all levels)
+		unsigned iterationCount = 0;
+	};
+
+	//! Default constructor
+	ccICPEngine();
+
+	//! Sets the 'model' (reference) entity
+	/** The entity must be a cloud (meshes are rejected).
+		The octree of the cloud is reused if it already exists, otherwise it is computed
+		(and attached to the cloud, so that it is also reused by the next instances).
+		\return success
+	**/
+	bool setModel(ccHObject* model, CCCoreLib::GenericProgressCallback* progressCb = nullptr);
+
+	//! Returns whether a model is set
+	inline bool hasModel() const { return m_modelCloud && m_modelOctree; }
+
+	//! Returns the model cloud
+	inline ccGenericPointCloud* getModelCloud() const { return m_modelCloud; }
+
+	//! Returns whether the model has normals (required for the point-to-plane metric)
+	bool modelHasNormals() const;
+
+	//! Registers a 'data' cloud with the current model
+	/** Parameters that are taken into account: convType, minRMSDecrease, nbMaxIterations,
+		filterOutFarthestPoints, samplingLimit, finalOverlapRatio, modelWeights, dataWeights,
+		transformationFilters and maxThreadCount (1 = no parallelism, 0 = all cores).
+		The correspondence search runs on a local thread pool (the global one is left untouched).
+		\warning dataWeights must be indexed like the input data cloud
+		\param data cloud to align
+		\param params ICP parameters
+		\param options engine options
+		\param result output result
+		\param progressCb progress callback (optional)
+		\return success
+	**/
+	bool registerData(	CCCoreLib::GenericIndexedCloudPersist* data,
+						const CCCoreLib::ICPRegistrationTools::Parameters& params,
+						const Options& options,
+						Result& result,
+						CCCoreLib::GenericProgressCallback* progressCb = nullptr) const;
+
+protected:
+
+	//! Model cloud
+	ccGenericPointCloud* m_modelCloud;
+	//! Model octree
+	ccOctree::Shared m_modelOctree;
+	//! Octree level used for nearest neighbour search
+	unsigned char m_octreeLevel;
+};
+
+#endif //CC_ICP_ENGINE_HEADER
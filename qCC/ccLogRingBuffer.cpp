@@ -0,0 +1,166 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#include "ccLogRingBuffer.h"
+
+//Qt
+#include <QTime>
+
+//system
+#include <cstdint>
+#include <iterator>
+
+ccLogRingBuffer::ccLogRingBuffer(size_t capacity/*=(1 << 14)*/)
+	: m_mask(0)
+	, m_pushPos(0)
+	, m_popPos(0)
+	, m_overflowing(false)
+{
+	//round the capacity up to the next power of 2
+	size_t actualCapacity = 2;
+	while (actualCapacity < capacity)
+	{
+		actualCapacity <<= 1;
+	}
+	m_mask = actualCapacity - 1;
+
+	m_cells.reset(new Cell[actualCapacity]);
+	for (size_t i = 0; i < actualCapacity; ++i)
+	{
+		m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+bool ccLogRingBuffer::tryPush(Record& record)
+{
+	size_t pos = m_pushPos.load(std::memory_order_relaxed);
+	Cell* cell = nullptr;
+	while (true)
+	{
+		cell = &m_cells[pos & m_mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+		if (diff == 0)
+		{
+			//the slot is free, we try to reserve it
+			if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			//the ring is full
+			return false;
+		}
+		else
+		{
+			//another producer got this slot
+			pos = m_pushPos.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->record = std::move(record);
+	cell->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool ccLogRingBuffer::tryPop(Record& record)
+{
+	size_t pos = m_popPos.load(std::memory_order_relaxed);
+	Cell* cell = nullptr;
+	while (true)
+	{
+		cell = &m_cells[pos & m_mask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+		if (diff == 0)
+		{
+			if (m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			//the ring is empty
+			return false;
+		}
+		else
+		{
+			pos = m_popPos.load(std::memory_order_relaxed);
+		}
+	}
+
+	record = std::move(cell->record);
+	cell->record.message.clear();
+	cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+void ccLogRingBuffer::push(Record&& record)
+{
+	//as long as the overflow list is not empty, we keep using it (to preserve the order)
+	if (!m_overflowing.load(std::memory_order_acquire) && tryPush(record))
+	{
+		return;
+	}
+
+	QMutexLocker locker(&m_overflowMutex);
+	m_overflow.push_back(std::move(record));
+	m_overflowing.store(true, std::memory_order_release);
+}
+
+size_t ccLogRingBuffer::popAll(std::vector<Record>& records)
+{
+	size_t count = 0;
+
+	Record record;
+	while (tryPop(record))
+	{
+		records.push_back(std::move(record));
+		++count;
+	}
+
+	if (m_overflowing.load(std::memory_order_acquire))
+	{
+		QMutexLocker locker(&m_overflowMutex);
+		//the ring may have been filled again in the meantime
+		while (tryPop(record))
+		{
+			records.push_back(std::move(record));
+			++count;
+		}
+		count += m_overflow.size();
+		std::move(m_overflow.begin(), m_overflow.end(), std::back_inserter(records));
+		m_overflow.clear();
+		m_overflowing.store(false, std::memory_order_release);
+	}
+
+	return count;
+}
+
+bool ccLogRingBuffer::empty() const
+{
+	return	m_popPos.load(std::memory_order_relaxed) == m_pushPos.load(std::memory_order_relaxed)
+		&&	!m_overflowing.load(std::memory_order_relaxed);
+}
+
+QString ccLogRingBuffer::Format(const Record& record)
+{
+	return QStringLiteral("[") + QTime::fromMSecsSinceStartOfDay(record.msecs).toString() + QStringLiteral("] ") + record.message;
+}
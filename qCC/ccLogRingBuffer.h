@@ -0,0 +1,104 @@
+//##########################################################################
+//#                                                                        #
+//#                              CLOUDCOMPARE                              #
+//#                                                                        #
+//#  This program is free software; you can redistribute it and/or modify  #
+//#  it under the terms of the GNU General Public License as published by  #
+//#  the Free Software Foundation; version 2 or later of the License.      #
+//#                                                                        #
+//#  This program is distributed in the hope that it will be useful,       #
+//#  but WITHOUT ANY WARRANTY; without even the implied warranty of        #
+//#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          #
+//#  GNU General Public License for more details.                          #
+//#                                                                        #
+//#          COPYRIGHT: EDF R&D / TELECOM ParisTech (ENST-TSI)             #
+//#                                                                        #
+//##########################################################################
+
+#ifndef CC_LOG_RING_BUFFER_HEADER
+#define CC_LOG_RING_BUFFER_HEADER
+
+//Qt
+#include <QMutex>
+#include <QString>
+
+//system
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//! Bounded multiple producers / single consumer lock-free queue of log messages
+/** Based on D. Vyukov's bounded queue (each slot has its own sequence number).
+	Pushing a message never blocks, unless the buffer is full: in this (rare)
+	case the message goes to a mutex-protected overflow list until the consumer
+	catches up.
+	Messages are stored 'raw' (text, level and time): the formatting is done
+	by the consumer, and only when the message is actually displayed or written.
+**/
+class ccLogRingBuffer
+{
+public:
+
+	//! Log record
+	struct Record
+	{
+		//! Raw message
+		QString message;
+		//! Message level (see ccLog::MessageLevelFlags)
+		int level = 0;
+		//! Time (milliseconds since midnight)
+		int msecs = 0;
+	};
+
+	//! Default constructor
+	/** \param capacity buffer capacity (rounded up to the next power of 2)
+	**/
+	explicit ccLogRingBuffer(size_t capacity = (1 << 14));
+
+	//! Pushes a new message (thread-safe)
+	void push(Record&& record);
+
+	//! Pops all the pending messages (single consumer only)
+	/** \return the number of popped messages
+	**/
+	size_t popAll(std::vector<Record>& records);
+
+	//! Returns whether there's (probably) nothing to pop
+	bool empty() const;
+
+	//! Formats a record as '[hh:mm:ss] message'
+	static QString Format(const Record& record);
+
+protected:
+
+	//! Tries to push a message in the ring
+	bool tryPush(Record& record);
+	//! Tries to pop a message from the ring
+	bool tryPop(Record& record);
+
+	//! Buffer slot
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		Record record;
+	};
+
+	//! Slots
+	std::unique_ptr<Cell[]> m_cells;
+	//! Index mask (capacity - 1)
+	size_t m_mask;
+
+	//! Next 'push' position
+	alignas(64) std::atomic<size_t> m_pushPos;
+	//! Next 'pop' position
+	alignas(64) std::atomic<size_t> m_popPos;
+
+	//! Whether the ring is full (the messages go to the overflow list)
+	std::atomic<bool> m_overflowing;
+	//! Overflow list mutex
+	QMutex m_overflowMutex;
+	//! Overflow list
+	std::vector<Record> m_overflow;
+};
+
+#endif //CC_LOG_RING_BUFFER_HEADER
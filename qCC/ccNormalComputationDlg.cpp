@@ -40,6 +40,7 @@ ccNormalComputationDlg::ccNormalComputationDlg(bool withScanGrid, bool withSenso
 
 	connect(localModelComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &ccNormalComputationDlg::localModelChanged);
 	connect(autoRadiusToolButton, &QToolButton::clicked,												this, &ccNormalComputationDlg::autoEstimateRadius);
+	connect(useKNNCheckBox, &QCheckBox::toggled,															this, &ccNormalComputationDlg::updateNeighborhoodWidgets);
 
 	if (withScanGrid)
 	{
@@ -107,10 +108,20 @@ CCCoreLib::LOCAL_MODEL_TYPES ccNormalComputationDlg::getLocalModel() const
 }
 
 void ccNormalComputationDlg::localModelChanged(int index)
+{
+	Q_UNUSED(index);
+	updateNeighborhoodWidgets();
+}
+
+void ccNormalComputationDlg::updateNeighborhoodWidgets()
 {
 	//DGM: we don't disable the parent frame anymore as it is used by the octree/grid toggling
-	radiusDoubleSpinBox->setEnabled(index != 2);
-	autoRadiusToolButton->setEnabled(index != 2);
+	bool withNeighborhood = (localModelComboBox->currentIndex() != 2); //TRI has its own neighborhood
+	bool knnMode = withNeighborhood && useKNNCheckBox->isChecked();
+	radiusDoubleSpinBox->setEnabled(withNeighborhood && !knnMode);
+	autoRadiusToolButton->setEnabled(withNeighborhood && !knnMode);
+	useKNNCheckBox->setEnabled(withNeighborhood);
+	knnSpinBox->setEnabled(knnMode);
 }
 
 void ccNormalComputationDlg::setRadius(PointCoordinateType radius)
@@ -130,6 +141,27 @@ PointCoordinateType ccNormalComputationDlg::getRadius() const
 	return static_cast<PointCoordinateType>(radiusDoubleSpinBox->value());
 }
 
+bool ccNormalComputationDlg::useKNN() const
+{
+	return useKNNCheckBox->isEnabled() && useKNNCheckBox->isChecked();
+}
+
+void ccNormalComputationDlg::setUseKNN(bool state)
+{
+	useKNNCheckBox->setChecked(state);
+	updateNeighborhoodWidgets();
+}
+
+int ccNormalComputationDlg::getKNN() const
+{
+	return knnSpinBox->value();
+}
+
+void ccNormalComputationDlg::setKNN(int k)
+{
+	knnSpinBox->setValue(k);
+}
+
 void ccNormalComputationDlg::setPreferredOrientation(ccNormalVectors::Orientation orientation)
 {
 	if (orientation == ccNormalVectors::UNDEFINED)
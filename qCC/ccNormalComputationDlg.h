@@ -67,6 +67,18 @@ public:
 	//! Returns local neighbourhood radius
 	PointCoordinateType getRadius() const;
 
+	//! Returns whether the local model should be fitted on the k nearest neighbors (instead of a radius)
+	bool useKNN() const;
+
+	//! Sets whether the local model should be fitted on the k nearest neighbors (instead of a radius)
+	void setUseKNN(bool state);
+
+	//! Returns the number of nearest neighbors (kNN mode)
+	int getKNN() const;
+
+	//! Sets the number of nearest neighbors (kNN mode)
+	void setKNN(int k);
+
 	//! Returns whether normals should be oriented or not
 	bool orientNormals() const;
 
@@ -96,6 +108,9 @@ protected:
 	//! On local model change
 	void localModelChanged(int index);
 
+	//! Updates the state of the radius and kNN widgets
+	void updateNeighborhoodWidgets();
+
 	//! Automatically estimate the local surface radius
 	void autoEstimateRadius();
 
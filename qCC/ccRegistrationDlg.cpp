@@ -52,6 +52,8 @@ static bool		s_useDataSFAsWeights = false;
 static bool		s_useModelSFAsWeights = false;
 static bool		s_useC2MSignedDistances = false;
 static int		s_normalsMatchingOption = CCCoreLib::ICPRegistrationTools::NO_NORMAL;
+static int		s_engineComboIndex = 0;
+static int		s_levelCount = 1;
 
 ccRegistrationDlg::ccRegistrationDlg(ccHObject *data, ccHObject *model, QWidget* parent/*=nullptr*/)
 	: QDialog(parent, Qt::Tool)
@@ -103,8 +105,13 @@ ccRegistrationDlg::ccRegistrationDlg(ccHObject *data, ccHObject *model, QWidget*
 		checkBoxUseModelSFAsWeights->setChecked(s_useModelSFAsWeights);
 		useC2MSignedDistancesCheckBox->setChecked(s_useC2MSignedDistances);
 		normalsComboBox->setCurrentIndex(s_normalsMatchingOption);
+		engineComboBox->setCurrentIndex(s_engineComboIndex);
+		levelCountSpinBox->setValue(s_levelCount);
 	}
 
+	levelCountSpinBox->setEnabled(useEngine());
+	connect(engineComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, [this](int) { levelCountSpinBox->setEnabled(useEngine()); });
+
 	connect(swapButton, &QAbstractButton::clicked, this, &ccRegistrationDlg::swapModelAndData);
 }
 
@@ -142,6 +149,8 @@ void ccRegistrationDlg::saveParameters() const
 	s_useModelSFAsWeights = checkBoxUseModelSFAsWeights->isChecked();
 	s_useC2MSignedDistances = useC2MSignedDistancesCheckBox->isChecked();
 	s_normalsMatchingOption = normalsComboBox->currentIndex();
+	s_engineComboIndex = engineComboBox->currentIndex();
+	s_levelCount = levelCountSpinBox->value();
 }
 
 ccHObject *ccRegistrationDlg::getDataEntity()
@@ -211,6 +220,19 @@ int ccRegistrationDlg::getMaxThreadCount() const
 	return maxThreadCountSpinBox->value();
 }
 
+bool ccRegistrationDlg::useEngine() const
+{
+	return engineComboBox->currentIndex() != 0;
+}
+
+ccICPEngine::Options ccRegistrationDlg::getEngineOptions() const
+{
+	ccICPEngine::Options options;
+	options.metric = (engineComboBox->currentIndex() == 2 ? ccICPEngine::POINT_TO_PLANE : ccICPEngine::POINT_TO_POINT);
+	options.levelCount = static_cast<unsigned>(levelCountSpinBox->value());
+	return options;
+}
+
 double ccRegistrationDlg::GetAbsoluteMinRMSDecrease()
 {
 	return 1.0e-7;
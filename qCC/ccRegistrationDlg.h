@@ -26,6 +26,9 @@
 #include <ui_registrationDlg.h>
 #include <ReferenceCloud.h>
 
+//Local
+#include "ccICPEngine.h"
+
 class ccHObject;
 
 //! Point cloud or mesh registration dialog
@@ -108,6 +111,14 @@ public:
 	//! Returns the maximum number of threads
 	int getMaxThreadCount() const;
 
+	//! Returns whether the ICP engine should be used (instead of the standard algorithm)
+	bool useEngine() const;
+
+	//! Returns the ICP engine options
+	/** Only valid if useEngine returns true.
+	**/
+	ccICPEngine::Options getEngineOptions() const;
+
 	//! Saves parameters for next call
 	void saveParameters() const;
 
@@ -52,7 +52,8 @@ bool ccRegistrationTools::ICP(	ccHObject* data,
 								const CCCoreLib::ICPRegistrationTools::Parameters& inputParameters,
 								bool useDataSFAsWeights/*=false*/,
 								bool useModelSFAsWeights/*=false*/,
-								QWidget* parent/*=nullptr*/)
+								QWidget* parent/*=nullptr*/,
+								const ccICPEngine::Options* engineOptions/*=nullptr*/)
 {
 	bool restoreColorState = false;
 	bool restoreSFState = false;
@@ -97,6 +98,73 @@ bool ccRegistrationTools::ICP(	ccHObject* data,
 		dataCloud = ccHObjectCaster::ToGenericPointCloud(data);
 	}
 
+	if (engineOptions)
+	{
+		if (params.adjustScale || modelMesh)
+		{
+			ccLog::Warning("[ICP] Scale adjustment and mesh models are not supported by the ICP engine: the standard algorithm will be used");
+		}
+		else
+		{
+			if (params.normalsMatching != CCCoreLib::ICPRegistrationTools::NO_NORMAL)
+			{
+				ccLog::Warning("[ICP] Normals matching option is ignored by the ICP engine");
+			}
+
+			ccICPEngine engine;
+			if (!engine.setModel(model, progressDlg.data()))
+			{
+				ccLog::Error("[ICP] Failed to prepare the 'model' entity");
+				return false;
+			}
+
+			//weights (the engine doesn't reduce the data cloud, so that the SF indexes remain valid)
+			params.modelWeights = nullptr;
+			params.dataWeights = nullptr;
+			if (useModelSFAsWeights)
+			{
+				if (model->isA(CC_TYPES::POINT_CLOUD))
+				{
+					params.modelWeights = static_cast<ccPointCloud*>(model)->getCurrentDisplayedScalarField();
+					if (!params.modelWeights)
+						ccLog::Warning("[ICP] 'useModelSFAsWeights' is true but model has no displayed scalar field!");
+				}
+				else
+				{
+					ccLog::Warning("[ICP] 'useModelSFAsWeights' is true but only point cloud scalar fields can be used as weights!");
+				}
+			}
+			if (useDataSFAsWeights)
+			{
+				if (data->isA(CC_TYPES::POINT_CLOUD))
+				{
+					params.dataWeights = static_cast<ccPointCloud*>(data)->getCurrentDisplayedScalarField();
+					if (!params.dataWeights)
+						ccLog::Warning("[ICP] 'useDataSFAsWeights' is true but data has no displayed scalar field!");
+				}
+				else
+				{
+					ccLog::Warning("[ICP] 'useDataSFAsWeights' is true but only point cloud scalar fields can be used as weights!");
+				}
+			}
+
+			ccICPEngine::Result result;
+			if (!engine.registerData(dataCloud, params, *engineOptions, result, progressDlg.data()))
+			{
+				ccLog::Error("Registration failed: an error occurred");
+				return false;
+			}
+
+			ccLog::Print(QString("[ICP] %1 iteration(s) on %2 level(s)").arg(result.iterationCount).arg(std::max(1u, engineOptions->levelCount)));
+
+			transMat = ccGLMatrix(result.transMat.data());
+			finalScale = 1.0;
+			finalRMS = result.finalRMS;
+			finalPointCount = result.finalPointCount;
+			return true;
+		}
+	}
+
 	//we activate a temporary scalar field for registration distances computation
 	CCCoreLib::ScalarField* dataDisplayedSF = nullptr;
 	int oldDataSfIdx = -1;
@@ -21,6 +21,9 @@
 //CCCoreLib
 #include <RegistrationTools.h>
 
+//Local
+#include "ccICPEngine.h"
+
 //qCC_db
 #include <ccGLMatrix.h>
 
@@ -46,7 +49,8 @@ public:
 					const CCCoreLib::ICPRegistrationTools::Parameters& inputParameters,
 					bool useDataSFAsWeights = false,
 					bool useModelSFAsWeights = false,
-					QWidget* parent = nullptr);
+					QWidget* parent = nullptr,
+					const ccICPEngine::Options* engineOptions = nullptr);
 
 };
 
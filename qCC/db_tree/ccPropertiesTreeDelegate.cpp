@@ -624,10 +624,28 @@ void ccPropertiesTreeDelegate::fillSFWithPointCloud(ccGenericPointCloud* _obj)
 		//fields list combo
 		appendRow(ITEM( tr( "Active" ) ), PERSISTENT_EDITOR(OBJECT_CURRENT_SCALAR_FIELD), true);
 
+		//memory used by the fields (and their size once saved with their preferred storage)
+		{
+			size_t memory = 0;
+			size_t compactMemory = 0;
+			for (unsigned i = 0; i < sfCount; ++i)
+			{
+				const ccScalarField* field = static_cast<const ccScalarField*>(cloud->getScalarField(i));
+				memory += field->memoryUsage();
+				compactMemory += field->compactMemoryUsage();
+			}
+			double memory_mb = memory / static_cast<double>(1 << 20);
+			double compactMemory_mb = compactMemory / static_cast<double>(1 << 20);
+			appendRow(ITEM( tr( "Memory" ) ), ITEM(tr("%1 Mb (saved: %2 Mb)").arg(memory_mb, 0, 'f', 2).arg(compactMemory_mb, 0, 'f', 2)));
+		}
+
 		//no need to go any further if no SF is currently active
 		CCCoreLib::ScalarField* sf = cloud->getCurrentDisplayedScalarField();
 		if (sf)
 		{
+			//preferred storage of the active field (used when saving it)
+			appendRow(ITEM( tr( "Preferred storage" ) ), ITEM(static_cast<ccScalarField*>(sf)->getStorage().description()));
+
 			addSeparator("Color Scale");
 
 			//color scale selection combo box
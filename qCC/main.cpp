@@ -19,6 +19,7 @@
 
 //Qt
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMessageBox>
 #include <QPixmap>
 #include <QSettings>
@@ -58,6 +59,10 @@
 
 int main(int argc, char **argv)
 {
+	//startup time (reported in the Console)
+	QElapsedTimer startupTimer;
+	startupTimer.start();
+
 #ifdef _WIN32 //This will allow printf to function on windows when opened from command line	
 	DWORD stdout_type = GetFileType(GetStdHandle(STD_OUTPUT_HANDLE));
 	if (AttachConsole(ATTACH_PARENT_PROCESS))
@@ -163,6 +168,8 @@ int main(int argc, char **argv)
 	//command line mode
 	if (commandLine)
 	{
+		ccLog::Print(QString("[Startup] Initialization done in %1 ms").arg(startupTimer.elapsed()));
+
 		//command line processing (no GUI)
 		result = ccCommandLineParser::Parse(argc, argv, ccPluginManager::get().pluginList());
 	}
@@ -179,6 +186,8 @@ int main(int argc, char **argv)
 		mainWindow->show();
 		QApplication::processEvents();
 
+		ccLog::Print(QString("[Startup] Application started in %1 ms").arg(startupTimer.elapsed()));
+
 		//show current Global Shift parameters in Console
 		{
 			ccLog::Print(QString("[Global Shift] Max abs. coord = %1 / max abs. diag = %2")
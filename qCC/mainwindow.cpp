@@ -147,6 +147,7 @@
 
 //Qt
 #include <QClipboard>
+#include <QFile>
 
 //Qt UI files
 #include <ui_distanceMapDlg.h>
@@ -625,6 +626,7 @@ void MainWindow::connectActions()
 	connect(m_UI->actionCrop,						&QAction::triggered, this, &MainWindow::doActionCrop);
 	connect(m_UI->actionEditGlobalShiftAndScale,	&QAction::triggered, this, &MainWindow::doActionEditGlobalShiftAndScale);
 	connect(m_UI->actionSubsample,					&QAction::triggered, this, &MainWindow::doActionSubsample);
+	connect(m_UI->actionReorderPoints,				&QAction::triggered, this, &MainWindow::doActionReorderPoints);
 	connect(m_UI->actionDelete,						&QAction::triggered,	m_ccRoot,	&ccDBRoot::deleteSelectedEntities);
 
 	//"Tools > Clean" menu
@@ -3402,82 +3404,72 @@ void MainWindow::doActionMerge()
 		//we will remove the useless clouds/meshes later
 		ccHObject::Container toBeRemoved;
 
-		ccPointCloud* firstCloud = nullptr;
-		ccHObjectContext firstCloudContext;
+		//we don't delete the first cloud (we'll merge the other ones 'inside' it)
+		ccPointCloud* firstCloud = clouds.front();
+		//we still have to temporarily detach the first cloud, as it may undergo
+		//'severe' modifications (octree deletion, etc.) --> see ccPointCloud::append
+		ccHObjectContext firstCloudContext = removeObjectTemporarilyFromDBTree(firstCloud);
 
 		//whether to generate the 'original cloud index' scalar field or not
 		CCCoreLib::ScalarField* ocIndexSF = nullptr;
-		size_t cloudIndex = 0;
-
-		for (size_t i = 0; i < clouds.size(); ++i)
+		if (QMessageBox::question(this, tr("Original cloud index"), tr("Do you want to generate a scalar field with the original cloud index?")) == QMessageBox::Yes)
 		{
-			ccPointCloud* pc = clouds[i];
-			if (!firstCloud)
+			int sfIdx = firstCloud->getScalarFieldIndexByName(CC_ORIGINAL_CLOUD_INDEX_SF_NAME);
+			if (sfIdx < 0)
 			{
-				//we don't delete the first cloud (we'll merge the other one 'inside' it
-				firstCloud = pc;
-				//we still have to temporarily detach the first cloud, as it may undergo
-				//'severe' modifications (octree deletion, etc.) --> see ccPointCloud::operator +=
-				firstCloudContext = removeObjectTemporarilyFromDBTree(firstCloud);
-
-				if (QMessageBox::question(this, tr("Original cloud index"), tr("Do you want to generate a scalar field with the original cloud index?")) == QMessageBox::Yes)
-				{
-					int sfIdx = pc->getScalarFieldIndexByName(CC_ORIGINAL_CLOUD_INDEX_SF_NAME);
-					if (sfIdx < 0)
-					{
-						sfIdx = pc->addScalarField(CC_ORIGINAL_CLOUD_INDEX_SF_NAME);
-					}
-					if (sfIdx < 0)
-					{
-						ccConsole::Error(tr("Couldn't allocate a new scalar field for storing the original cloud index! Try to free some memory ..."));
-						return;
-					}
-					else
-					{
-						ocIndexSF = pc->getScalarField(sfIdx);
-						ocIndexSF->fill(0);
-						firstCloud->setCurrentDisplayedScalarField(sfIdx);
-					}
-				}
+				sfIdx = firstCloud->addScalarField(CC_ORIGINAL_CLOUD_INDEX_SF_NAME);
+			}
+			if (sfIdx < 0)
+			{
+				ccConsole::Error(tr("Couldn't allocate a new scalar field for storing the original cloud index! Try to free some memory ..."));
+				putObjectBackIntoDBTree(firstCloud, firstCloudContext);
+				return;
 			}
 			else
 			{
-				unsigned countBefore = firstCloud->size();
-				unsigned countAdded = pc->size();
-				*firstCloud += pc;
+				ocIndexSF = firstCloud->getScalarField(sfIdx);
+				ocIndexSF->fill(0);
+				firstCloud->setCurrentDisplayedScalarField(sfIdx);
+			}
+		}
 
-				//success?
-				if (firstCloud->size() == countBefore + countAdded)
-				{
-					firstCloud->prepareDisplayForRefresh_recursive();
+		//all the other clouds are merged at once
+		std::vector<ccPointCloud*> addedClouds(clouds.begin() + 1, clouds.end());
+		unsigned countBefore = firstCloud->size();
+		if (firstCloud->append(addedClouds))
+		{
+			firstCloud->prepareDisplayForRefresh_recursive();
 
-					ccHObject* toRemove = nullptr;
-					//if the entity to remove is a group with a unique child, we can remove it as well
-					ccHObject* parent = pc->getParent();
-					if (parent && parent->isA(CC_TYPES::HIERARCHY_OBJECT) && parent->getChildrenNumber() == 1 && parent != firstCloudContext.parent)
-						toRemove = parent;
-					else
-						toRemove = pc;
+			for (size_t i = 0; i < addedClouds.size(); ++i)
+			{
+				ccPointCloud* pc = addedClouds[i];
+				unsigned countAdded = pc->size();
+
+				ccHObject* toRemove = nullptr;
+				//if the entity to remove is a group with a unique child, we can remove it as well
+				ccHObject* parent = pc->getParent();
+				if (parent && parent->isA(CC_TYPES::HIERARCHY_OBJECT) && parent->getChildrenNumber() == 1 && parent != firstCloudContext.parent)
+					toRemove = parent;
+				else
+					toRemove = pc;
 
-					AddToRemoveList(toRemove, toBeRemoved);
+				AddToRemoveList(toRemove, toBeRemoved);
 
-					if (ocIndexSF)
+				if (ocIndexSF)
+				{
+					ScalarType index = static_cast<ScalarType>(i + 1);
+					for (unsigned j = 0; j < countAdded; ++j)
 					{
-						ScalarType index = static_cast<ScalarType>(++cloudIndex);
-						for (unsigned i = 0; i < countAdded; ++i)
-						{
-							ocIndexSF->setValue(countBefore + i, index);
-						}
+						ocIndexSF->setValue(countBefore + j, index);
 					}
 				}
-				else
-				{
-					ccConsole::Error(tr("Fusion failed! (not enough memory?)"));
-					break;
-				}
-				pc = nullptr;
+				countBefore += countAdded;
 			}
 		}
+		else
+		{
+			ccConsole::Error(tr("Fusion failed! (not enough memory?)"));
+		}
 
 		if (ocIndexSF)
 		{
@@ -3607,6 +3599,8 @@ void MainWindow::doActionRegister()
 	}
 	bool useDataSFAsWeights		= rDlg.useDataSFAsWeights();
 	bool useModelSFAsWeights	= rDlg.useModelSFAsWeights();
+	bool useEngine				= rDlg.useEngine();
+	ccICPEngine::Options engineOptions = rDlg.getEngineOptions();
 
 	//semi-persistent storage (for next call)
 	rDlg.saveParameters();
@@ -3625,7 +3619,8 @@ void MainWindow::doActionRegister()
 									parameters,
 									useDataSFAsWeights,
 									useModelSFAsWeights,
-									this))
+									this,
+									useEngine ? &engineOptions : nullptr))
 	{
 		QString rmsString = tr("Final RMS*: %1 (computed on %2 points)").arg(finalError).arg(finalPointCount);
 		QString rmsDisclaimerString = tr("(* RMS is potentially weighted, depending on the selected options)");
@@ -8986,33 +8981,72 @@ void MainWindow::doActionExportCloudInfo()
 
 void MainWindow::doActionCloudCloudDist()
 {
-	if (getSelectedEntities().size() != 2)
+	if (getSelectedEntities().size() < 2)
 	{
-		ccConsole::Error(tr("Select 2 point clouds!"));
+		ccConsole::Error(tr("Select at least 2 point clouds!"));
 		return;
 	}
 
-	if (!m_selectedEntities[0]->isKindOf(CC_TYPES::POINT_CLOUD) ||
-		!m_selectedEntities[1]->isKindOf(CC_TYPES::POINT_CLOUD))
+	for (ccHObject* entity : m_selectedEntities)
 	{
-		ccConsole::Error(tr("Select 2 point clouds!"));
-		return;
+		if (!entity->isKindOf(CC_TYPES::POINT_CLOUD))
+		{
+			ccConsole::Error(tr("Select only point clouds!"));
+			return;
+		}
 	}
 
-	ccOrderChoiceDlg dlg(	m_selectedEntities[0], tr("Compared"),
-							m_selectedEntities[1], tr("Reference"),
-							this );
-	if (!dlg.exec())
-		return;
+	ccGenericPointCloud* compCloud = nullptr;
+	ccGenericPointCloud* refCloud = nullptr;
+	std::vector<ccPointCloud*> additionalCompClouds;
 
-	ccGenericPointCloud* compCloud = ccHObjectCaster::ToGenericPointCloud(dlg.getFirstEntity());
-	ccGenericPointCloud* refCloud = ccHObjectCaster::ToGenericPointCloud(dlg.getSecondEntity());
+	if (m_selectedEntities.size() == 2)
+	{
+		ccOrderChoiceDlg dlg(	m_selectedEntities[0], tr("Compared"),
+								m_selectedEntities[1], tr("Reference"),
+								this );
+		if (!dlg.exec())
+			return;
+
+		compCloud = ccHObjectCaster::ToGenericPointCloud(dlg.getFirstEntity());
+		refCloud = ccHObjectCaster::ToGenericPointCloud(dlg.getSecondEntity());
+	}
+	else
+	{
+		//multi-compared mode: the user must choose the reference cloud
+		int refIndex = ccItemSelectionDlg::SelectEntity(m_selectedEntities, 0, this, tr("Select the reference cloud"));
+		if (refIndex < 0)
+			return;
+
+		refCloud = ccHObjectCaster::ToGenericPointCloud(m_selectedEntities[refIndex]);
+		for (size_t i = 0; i < m_selectedEntities.size(); ++i)
+		{
+			if (static_cast<int>(i) == refIndex)
+				continue;
+
+			//the compared entities must be real point clouds
+			ccPointCloud* cloud = ccHObjectCaster::ToPointCloud(m_selectedEntities[i]);
+			if (!cloud)
+			{
+				ccConsole::Error(tr("Entity '%1' is not a real point cloud!").arg(m_selectedEntities[i]->getName()));
+				return;
+			}
+			if (!compCloud)
+				compCloud = cloud;
+			else
+				additionalCompClouds.push_back(cloud);
+		}
+	}
 
 	//assert(!m_compDlg);
 	if (m_compDlg)
 		delete m_compDlg;
 
 	m_compDlg = new ccComparisonDlg(compCloud, refCloud, ccComparisonDlg::CLOUDCLOUD_DIST, this);
+	if (!additionalCompClouds.empty())
+	{
+		m_compDlg->setAdditionalComparedClouds(additionalCompClouds);
+	}
 	if (!m_compDlg->initDialog())
 	{
 		ccConsole::Error(tr("Failed to initialize comparison dialog"));
@@ -10827,6 +10861,7 @@ void MainWindow::enableUIItems(dbTreeSelectionInfo& selInfo)
 	m_UI->actionComputeKdTree->setEnabled(exactlyOneCloud || exactlyOneMesh);
 	m_UI->actionShowWaveDialog->setEnabled(exactlyOneCloud);
 	m_UI->actionCompressFWFData->setEnabled(atLeastOneCloud);
+	m_UI->actionReorderPoints->setEnabled(atLeastOneCloud);
 
 	m_UI->actionKMeans->setEnabled(/*TODO: exactlyOneEntity && exactlyOneSF*/false);
 	m_UI->actionFrontPropagation->setEnabled(/*TODO: exactlyOneEntity && exactlyOneSF*/false);
@@ -10859,7 +10894,7 @@ void MainWindow::enableUIItems(dbTreeSelectionInfo& selInfo)
 	m_UI->actionBBMaxCornerToOrigin->setEnabled(atLeastOneEntity);
 
 	m_UI->actionAlign->setEnabled(exactlyTwoEntities); //Aurelien BEY le 13/11/2008
-	m_UI->actionCloudCloudDist->setEnabled(exactlyTwoClouds);
+	m_UI->actionCloudCloudDist->setEnabled(selInfo.cloudCount >= 2 && selInfo.cloudCount == selInfo.selCount);
 	m_UI->actionCloudMeshDist->setEnabled(exactlyTwoEntities && atLeastOneMesh);
 	m_UI->actionCloudPrimitiveDist->setEnabled(atLeastOneCloud && (atLeastOneMesh || atLeastOnePolyline));
 	m_UI->actionCPS->setEnabled(exactlyTwoClouds);
@@ -11190,6 +11225,65 @@ void MainWindow::doActionCompressFWFData()
 	}
 }
 
+void MainWindow::doActionReorderPoints()
+{
+	QStringList orders;
+	orders << tr("Hilbert curve") << tr("Morton curve (octree)") << tr("Original order (restore)");
+	bool ok = false;
+	QString selectedOrder = QInputDialog::getItem(this, tr("Reorder points"), tr("Order"), orders, 0, false, &ok);
+	if (!ok)
+	{
+		return;
+	}
+	int orderIndex = orders.indexOf(selectedOrder);
+	bool restoreOriginalOrder = (orderIndex == 2);
+	ccPointCloud::SpatialOrder order = (orderIndex == 1 ? ccPointCloud::SpatialOrder::MORTON : ccPointCloud::SpatialOrder::HILBERT);
+
+	bool storeOriginalIndexes = false;
+	if (!restoreOriginalOrder)
+	{
+		storeOriginalIndexes = (QMessageBox::question(	this,
+														tr("Reorder points"),
+														tr("Store the original point indexes in a scalar field?\n(so as to be able to restore the original order)"),
+														QMessageBox::Yes,
+														QMessageBox::No) == QMessageBox::Yes);
+	}
+
+	//the selection may change when the clouds are temporarily detached from the DB tree
+	ccHObject::Container selectedEntities = getSelectedEntities();
+
+	for ( ccHObject *entity : selectedEntities )
+	{
+		if (!entity || !entity->isA(CC_TYPES::POINT_CLOUD))
+		{
+			continue;
+		}
+
+		ccPointCloud* cloud = static_cast<ccPointCloud*>(entity);
+
+		//we temporarily detach the cloud, as its octree will be deleted
+		ccHObjectContext objContext = removeObjectTemporarilyFromDBTree(cloud);
+		bool success = (restoreOriginalOrder ? cloud->restoreOriginalPointOrder() : cloud->reorderPoints(order, storeOriginalIndexes));
+		putObjectBackIntoDBTree(cloud, objContext);
+
+		if (!success)
+		{
+			ccConsole::Error(tr("Failed to reorder the points of cloud '%1' (see the Console)").arg(cloud->getName()));
+			break;
+		}
+		ccConsole::Print(tr("[ReorderPoints] Points of cloud '%1' reordered").arg(cloud->getName()));
+
+		cloud->prepareDisplayForRefresh_recursive();
+	}
+
+	//reselect previously selected entities!
+	if (m_ccRoot)
+		m_ccRoot->selectEntities(selectedEntities);
+
+	refreshAll();
+	updateUI();
+}
+
 void MainWindow::doActionShowWaveDialog()
 {
 	if (!haveSelection())
@@ -339,6 +339,7 @@ private:
 	void doActionComputeCPS();
 	void doActionShowWaveDialog();
 	void doActionCompressFWFData();
+	void doActionReorderPoints();
 	void doActionKMeans();
 	void doActionFrontPropagation();
 	void doActionApplyScale();
@@ -147,11 +147,10 @@ void ccPluginUIManager::init()
 				
 			case CC_IO_FILTER_PLUGIN:
 			{
-				ccIOPluginInterface *ioPlugin = static_cast<ccIOPluginInterface*>( plugin );
-
 				// there are no menus or toolbars for I/O plugins
+				// (and their library may not be loaded yet, see ccPluginManager::isDeferred)
 				
-				m_plugins.push_back( ioPlugin );
+				m_plugins.push_back( plugin );
 				break;
 			}	
 		}